@@ -6,6 +6,8 @@
 #include "arch/x86_64/isr.h"
 #include "arch/x86_64/lapic.h"
 #include "arch/x86_64/percpu.h"
+#include "arch/x86_64/tsc.h"
+#include "proc/preempt.h"
 #include "lib/kprintf.h"
 
 /* TLB shootdown handler — flush TLB on this CPU */
@@ -22,9 +24,9 @@ static void ipi_tlb_handler(InterruptFrame *frame) {
 static void ipi_schedule_handler(InterruptFrame *frame) {
     (void)frame;
     lapic_eoi();
-    /* The timer IRQ handler normally calls sched_schedule().
-     * For cross-core wakeup, we just need to mark that a reschedule
-     * is needed. The next timer tick will pick it up. */
+    /* Cross-core wakeup: mark that a reschedule is needed; interrupt exit
+     * performs it if the interrupted thread is preemptible. */
+    set_need_resched(tsc_read());
 }
 
 /* Halt handler — stop this CPU */
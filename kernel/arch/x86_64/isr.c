@@ -1,6 +1,7 @@
 #include "arch/x86_64/isr.h"
 #include "arch/x86_64/pic.h"
 #include "arch/x86_64/lapic.h"
+#include "proc/preempt.h"
 #include "lib/kprintf.h"
 #include <stddef.h>
 
@@ -81,6 +82,10 @@ static void default_exception_handler(InterruptFrame *frame) {
     }
 }
 
+void isr_unhandled_exception(InterruptFrame *frame) {
+    default_exception_handler(frame);
+}
+
 void isr_dispatch(InterruptFrame *frame) {
     uint64_t vector = frame->vector;
 
@@ -101,12 +106,15 @@ void isr_dispatch(InterruptFrame *frame) {
         if (handlers[vector] != NULL) {
             handlers[vector](frame);
         }
+        /* Interrupt exit is a preemption point */
+        preempt_irq_exit();
         return;
     }
 
     /* IPI / high-vector path (0xF0+) — handled by registered handlers */
     if (vector >= 0xF0 && handlers[vector] != NULL) {
         handlers[vector](frame);
+        preempt_irq_exit();
         return;
     }
 
@@ -37,6 +37,10 @@ typedef void (*isr_handler_t)(InterruptFrame *frame);
 /* Register a handler for a specific interrupt vector. */
 void isr_register_handler(int vector, isr_handler_t handler);
 
+/* Report an exception no handler could resolve, then halt. For handlers
+ * that only deal with some occurrences of their vector (e.g. page faults). */
+void isr_unhandled_exception(InterruptFrame *frame);
+
 /* C dispatcher called from assembly. */
 void isr_dispatch(InterruptFrame *frame);
 
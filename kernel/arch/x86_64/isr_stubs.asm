@@ -93,8 +93,15 @@ ISR_NOERRCODE i
 
 ; --- Common ISR handler ---
 ; Stack at entry: SS, RSP, RFLAGS, CS, RIP, error_code, vector
+;
+; Interrupts taken from ring 3 arrive with the user GS base loaded; swap in
+; the kernel one (PerCpu) for the handler and back again on the way out.
 
 isr_common:
+    test qword [rsp + 24], 3    ; CS.RPL of the interrupted context
+    jz .kernel_entry
+    swapgs
+.kernel_entry:
     ; Save all general-purpose registers
     push rax
     push rbx
@@ -141,6 +148,10 @@ isr_common:
     pop rbx
     pop rax
 
+    test qword [rsp + 24], 3    ; Returning to ring 3?
+    jz .kernel_exit
+    swapgs
+.kernel_exit:
     ; Remove vector and error code from stack
     add rsp, 16
 
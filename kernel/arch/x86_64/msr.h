@@ -8,6 +8,8 @@
 #define MSR_STAR    0xC0000081  /* Segment selectors for SYSCALL/SYSRET */
 #define MSR_LSTAR   0xC0000082  /* SYSCALL entry point (64-bit) */
 #define MSR_SFMASK  0xC0000084  /* RFLAGS mask for SYSCALL */
+#define MSR_GS_BASE        0xC0000101  /* Active GS base */
+#define MSR_KERNEL_GS_BASE 0xC0000102  /* Exchanged with GS base by swapgs */
 
 /* EFER bits */
 #define EFER_SCE    (1ULL << 0) /* System Call Extensions enable */
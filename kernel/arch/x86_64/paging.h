@@ -13,6 +13,8 @@
 #define PTE_DIRTY      (1ULL << 6)
 #define PTE_HUGE       (1ULL << 7)   /* 2MB page (in PD entry) or 1GB page (in PDPT) */
 #define PTE_GLOBAL     (1ULL << 8)
+#define PTE_SHARED     (1ULL << 9)   /* Software: frame owned elsewhere (page cache) */
+#define PTE_COW        (1ULL << 10)  /* Software: copy the frame on write */
 #define PTE_NX         (1ULL << 63)  /* No-execute */
 
 /* Mask to extract physical address from PTE (bits 12-51) */
@@ -34,6 +36,13 @@ static inline uint64_t paging_read_cr3(void) {
     return cr3;
 }
 
+/* Read CR2 — the faulting linear address after a page fault. */
+static inline uint64_t paging_read_cr2(void) {
+    uint64_t cr2;
+    __asm__ volatile ("mov %%cr2, %0" : "=r"(cr2));
+    return cr2;
+}
+
 /* Write CR3 — switch to a new PML4. Flushes the entire TLB. */
 static inline void paging_write_cr3(uint64_t cr3) {
     __asm__ volatile ("mov %0, %%cr3" : : "r"(cr3) : "memory");
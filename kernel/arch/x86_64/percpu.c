@@ -1,7 +1,8 @@
 /* arc_os — Per-CPU data infrastructure
  *
  * Each CPU has a PerCpu struct accessible via the GS segment base MSR.
- * BSP initializes first; APs call percpu_init_ap on startup. */
+ * BSP initializes first, before anything calls this_cpu(); APs call
+ * percpu_init_ap on startup. */
 
 #include "arch/x86_64/percpu.h"
 #include "arch/x86_64/gdt.h"
@@ -15,6 +16,7 @@ void percpu_init_bsp(void) {
     PerCpu *bsp = &percpu_data[0];
     memset(bsp, 0, sizeof(PerCpu));
 
+    bsp->self = bsp;
     bsp->cpu_id = 0;
     bsp->apic_id = 0;  /* Will be updated by LAPIC init */
     bsp->current_thread = thread_current();
@@ -36,6 +38,7 @@ void percpu_init_ap(uint32_t cpu_id, uint32_t apic_id) {
     PerCpu *ap = &percpu_data[cpu_id];
     memset(ap, 0, sizeof(PerCpu));
 
+    ap->self = ap;
     ap->cpu_id = cpu_id;
     ap->apic_id = apic_id;
     ap->current_thread = NULL;
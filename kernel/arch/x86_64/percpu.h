@@ -2,18 +2,29 @@
 #define ARCHOS_ARCH_X86_64_PERCPU_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "proc/thread.h"
 #include "proc/spinlock.h"
 #include "arch/x86_64/gdt.h"
+#include "arch/x86_64/msr.h"
 
 /* Maximum CPUs supported */
 #define MAX_CPUS 16
 
-/* Offset of kernel_rsp in PerCpu — must match assembly */
+/* PerCpu field offsets used from assembly (GS-relative); checked below */
+#define PERCPU_SELF_OFFSET        0
 #define PERCPU_KERNEL_RSP_OFFSET 24
+#define PERCPU_USER_RSP_OFFSET   32
+#define PERCPU_SIG_ARG_OFFSET    40
+
+/* Per-CPU data structure — one per processor.
+ *
+ * In kernel mode GS base points here; in user mode the pointer is parked in
+ * MSR_KERNEL_GS_BASE and every kernel entry from ring 3 swaps it back with
+ * swapgs. */
+typedef struct __attribute__((aligned(64))) PerCpu {
+    struct PerCpu *self;        /* Lets this_cpu() read GS:0, no rdmsr */
 
-/* Per-CPU data structure — one per processor */
-typedef struct __attribute__((aligned(64))) {
     /* Identity */
     uint32_t cpu_id;
     uint32_t apic_id;
@@ -21,6 +32,8 @@ typedef struct __attribute__((aligned(64))) {
     /* Current thread/process */
     Thread  *current_thread;
     uint64_t kernel_rsp;        /* Kernel stack top for SYSCALL entry */
+    uint64_t user_rsp;          /* SYSCALL entry scratch for the user RSP */
+    uint64_t sig_arg;           /* Signal handler RDI for the SYSRET path */
 
     /* Idle thread for this CPU */
     Thread  *idle_thread;
@@ -36,8 +49,25 @@ typedef struct __attribute__((aligned(64))) {
 
     /* AP startup synchronization */
     volatile int online;
+
+    /* Queued-spinlock wait nodes, one per nesting level */
+    McsNode  mcs_nodes[MCS_NODES_PER_CPU];
+    uint32_t mcs_depth;
+
+    /* RCU: grace period seen at the last quiescent state */
+    volatile uint64_t rcu_qs_seq;
+    volatile uint8_t  rcu_parked;   /* Halted for good; ignored by grace periods */
 } PerCpu;
 
+_Static_assert(offsetof(PerCpu, self) == PERCPU_SELF_OFFSET,
+               "PERCPU_SELF_OFFSET does not match PerCpu");
+_Static_assert(offsetof(PerCpu, kernel_rsp) == PERCPU_KERNEL_RSP_OFFSET,
+               "PERCPU_KERNEL_RSP_OFFSET does not match PerCpu");
+_Static_assert(offsetof(PerCpu, user_rsp) == PERCPU_USER_RSP_OFFSET,
+               "PERCPU_USER_RSP_OFFSET does not match PerCpu");
+_Static_assert(offsetof(PerCpu, sig_arg) == PERCPU_SIG_ARG_OFFSET,
+               "PERCPU_SIG_ARG_OFFSET does not match PerCpu");
+
 /* Global array of per-CPU data */
 extern PerCpu percpu_data[MAX_CPUS];
 extern uint32_t cpu_count;
@@ -48,26 +78,19 @@ void percpu_init_bsp(void);
 /* Initialize per-CPU data for an AP. Called on the AP itself. */
 void percpu_init_ap(uint32_t cpu_id, uint32_t apic_id);
 
-/* Get the current CPU's PerCpu structure via GS base. */
+/* Get the current CPU's PerCpu structure: one GS-relative load of the
+ * self pointer. Kernel mode only (GS must hold the kernel base). */
 static inline PerCpu *this_cpu(void) {
     PerCpu *p;
-    __asm__ volatile (
-        "mov %%gs:0, %0"  /* PerCpu starts with cpu_id, but we read the GS base */
-        : "=r"(p)
-    );
-    /* Actually, we store the pointer to PerCpu in GS base directly.
-     * Reading GS:0 gives the first 8 bytes of the struct starting at GS base.
-     * Instead, read MSR_GS_BASE for the pointer. */
-    uint32_t lo, hi;
-    __asm__ volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(0xC0000101));
-    return (PerCpu *)((uint64_t)hi << 32 | lo);
+    __asm__ volatile ("mov %%gs:%c1, %0" : "=r"(p) : "i"(PERCPU_SELF_OFFSET));
+    return p;
 }
 
-/* Set GS base to point to the given PerCpu struct. */
+/* Set GS base to point to the given PerCpu struct. The user-mode base
+ * (MSR_KERNEL_GS_BASE while in the kernel) starts out as 0. */
 static inline void percpu_set_gs_base(PerCpu *p) {
-    uint64_t addr = (uint64_t)p;
-    __asm__ volatile ("wrmsr" : : "c"(0xC0000101),
-                      "a"((uint32_t)addr), "d"((uint32_t)(addr >> 32)));
+    wrmsr(MSR_GS_BASE, (uint64_t)p);
+    wrmsr(MSR_KERNEL_GS_BASE, 0);
 }
 
 #endif /* ARCHOS_ARCH_X86_64_PERCPU_H */
@@ -2,17 +2,27 @@
 #include "arch/x86_64/pic.h"
 #include "arch/x86_64/isr.h"
 #include "arch/x86_64/io.h"
+#include "arch/x86_64/tsc.h"
 #include "proc/sched.h"
+#include "proc/preempt.h"
+#include "proc/rcu.h"
+#include "proc/workqueue.h"
 #include "lib/kprintf.h"
 
 static volatile uint64_t pit_ticks = 0;
 static uint32_t pit_freq = 0;
+static uint64_t last_tick_tsc = 0;
 
-/* Schedule every SCHED_QUANTUM ticks (100ms at 100 Hz) */
-#define SCHED_QUANTUM 10
+/* When this tick was due: a tick held off by disabled interrupts arrives
+ * late, and the reschedule it requests has been waiting since then. */
+static uint64_t pit_tick_due(uint64_t now) {
+    uint64_t period = tsc_from_ns(1000000000ULL / pit_freq);
+    if (last_tick_tsc == 0 || period == 0) return now;
+    uint64_t expected = last_tick_tsc + period;
+    return (now > expected) ? expected : now;
+}
 
 static void pit_handler(InterruptFrame *frame) {
-    (void)frame;
     pit_ticks++;
 
     /* Print a heartbeat every second */
@@ -21,10 +31,22 @@ static void pit_handler(InterruptFrame *frame) {
         kprintf("[TIMER] %lu seconds\n", seconds);
     }
 
-    /* Preemptive scheduling — interrupts already disabled by interrupt gate */
-    if (pit_ticks % SCHED_QUANTUM == 0) {
-        sched_schedule();
+    /* Hand expired delayed work to the worker pools */
+    workqueue_tick(pit_get_uptime_ms());
+
+    /* A tick that interrupted user mode is an RCU quiescent state */
+    rcu_check_callbacks((frame->cs & 3) != 0);
+
+    tsc_calibrate_tick(pit_ticks, pit_freq);
+
+    /* Preemptive scheduling — the scheduler charges the tick to the current
+     * thread's slice. The switch itself happens on interrupt exit, or later
+     * at the first preemption point if the thread is non-preemptible. */
+    uint64_t now = tsc_read();
+    if (sched_tick()) {
+        set_need_resched(pit_tick_due(now));
     }
+    last_tick_tsc = now;
 }
 
 void pit_init(uint32_t freq_hz) {
@@ -5,12 +5,14 @@
 
 #include "arch/x86_64/smp.h"
 #include "arch/x86_64/percpu.h"
+#include "arch/x86_64/syscall.h"
 #include "arch/x86_64/lapic.h"
 #include "arch/x86_64/gdt.h"
 #include "arch/x86_64/idt.h"
 #include "mm/vmm.h"
 #include "proc/thread.h"
 #include "proc/sched.h"
+#include "proc/rcu.h"
 #include "lib/kprintf.h"
 #include "lib/mem.h"
 #include <limine.h>
@@ -28,8 +30,10 @@ static void ap_entry(struct limine_smp_info *info) {
     uint32_t cpu_id = (uint32_t)info->extra_argument;
     uint32_t apic_id = info->lapic_id;
 
-    /* Initialize per-CPU data for this AP */
+    /* Initialize per-CPU data for this AP, and its SYSCALL MSRs so it can
+     * take syscalls once it runs user threads */
     percpu_init_ap(cpu_id, apic_id);
+    syscall_init_cpu();
 
     /* Load GDT and IDT (shared IDT, per-CPU GDT could be done later) */
     /* For now, APs use the BSP's GDT and IDT since they're the same */
@@ -44,7 +48,9 @@ static void ap_entry(struct limine_smp_info *info) {
 
     kprintf("[SMP] CPU %u (APIC %u) online\n", cpu_id, apic_id);
 
-    /* AP idle loop — wait for scheduler to assign work */
+    /* AP idle loop — wait for scheduler to assign work. APs run no RCU
+     * readers, so grace periods need not wait for them. */
+    rcu_cpu_park();
     __asm__ volatile ("sti");
     for (;;) {
         __asm__ volatile ("hlt");
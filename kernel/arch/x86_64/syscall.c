@@ -4,6 +4,7 @@
 #include "proc/thread.h"
 #include "proc/process.h"
 #include "proc/sched.h"
+#include "proc/preempt.h"
 #include "proc/fd.h"
 #include "mm/vmm.h"
 #include "mm/pmm.h"
@@ -18,21 +19,16 @@
 #include "drivers/tty.h"
 #include "fs/pipe.h"
 #include "fs/path.h"
+#include "fs/bcache.h"
 #include "proc/signal.h"
 #include "proc/waitqueue.h"
 #include "lib/string.h"
 #include "net/socket.h"
-
-/* Exported from syscall_entry.asm: user context saved during SYSCALL */
-extern uint64_t syscall_saved_user_rip;
-extern uint64_t syscall_saved_user_rsp;
-extern uint64_t syscall_saved_user_rflags;
-extern uint64_t syscall_saved_user_rbp;
-extern uint64_t syscall_saved_user_rbx;
-extern uint64_t syscall_saved_user_r12;
-extern uint64_t syscall_saved_user_r13;
-extern uint64_t syscall_saved_user_r14;
-extern uint64_t syscall_saved_user_r15;
+#include "proc/io_ring.h"
+#include "proc/spawn.h"
+#include "proc/pager.h"
+#include "ipc/endpoint.h"
+#include "proc/mmap.h"
 
 /* RFLAGS bits cleared by SFMASK on SYSCALL entry */
 #define RFLAGS_IF  (1ULL << 9)   /* Interrupt Flag */
@@ -43,9 +39,6 @@ extern uint64_t syscall_saved_user_r15;
 #define FD_STDOUT  1
 #define FD_STDERR  2
 
-/* Maximum ELF binary size for sys_exec */
-#define MAX_ELF_SIZE  (16 * 1024 * 1024)  /* 16 MB */
-
 /* exec() argv limits */
 #define MAX_EXEC_ARGS     32
 #define MAX_EXEC_ARG_DATA 4096
@@ -58,11 +51,14 @@ typedef struct {
     size_t data_used;
 } ExecArgv;
 
-/* Syscall handler table */
+/* Syscall handler table — filled in by syscall_init, read-only afterwards */
 static syscall_handler_t syscall_table[SYSCALL_MAX];
 
-/* Kernel RSP for SYSCALL entry — set by scheduler on context switch */
-uint64_t syscall_kernel_rsp;
+/* The user context pushed by syscall_entry.asm, at the top of the calling
+ * thread's kernel stack. Per-thread, so safe with syscalls on every CPU. */
+static SyscallFrame *syscall_user_frame(void) {
+    return (SyscallFrame *)(thread_current()->kernel_stack_top - sizeof(SyscallFrame));
+}
 
 /* --- Path resolution helper --- */
 
@@ -75,6 +71,29 @@ static int resolve_user_path(uint64_t path_addr, char *abs, size_t size) {
     return path_normalize(cwd, path, abs, size);
 }
 
+/* --- File descriptor helpers --- */
+
+/* dup2 within one table. Returns newfd or -EBADF. */
+static int fd_table_dup2(FdTable *ft, int oldfd, int newfd) {
+    if (oldfd < 0 || newfd < 0 || oldfd >= MAX_FDS || newfd >= MAX_FDS) return -EBADF;
+
+    VfsFile *src = fd_get(ft, oldfd);
+    if (src == NULL) return -EBADF;
+    if (oldfd == newfd) return newfd;
+
+    /* If newfd is open, close it first */
+    FdEntry *dst_entry = &ft->entries[newfd];
+    if (dst_entry->in_use) fd_entry_close(dst_entry);
+
+    /* Copy the file entry */
+    dst_entry->file = *src;
+    dst_entry->in_use = 1;
+
+    /* If it's a pipe or endpoint, bump the ref count */
+    fd_file_addref(&dst_entry->file);
+    return newfd;
+}
+
 /* --- Built-in syscall handlers --- */
 
 /* SYS_EXIT: terminate current process */
@@ -84,31 +103,7 @@ static int64_t sys_exit(uint64_t status, uint64_t a1, uint64_t a2,
     Process *p = proc_current();
     kprintf("[SYSCALL] exit(%lu) from pid=%u\n", status, p->pid);
 
-    /* Close all open file descriptors (critical for pipe EOF signaling) */
-    if (p->fd_table != NULL) {
-        for (int i = 0; i < MAX_FDS; i++) {
-            if (p->fd_table->entries[i].in_use) {
-                VfsFile *f = &p->fd_table->entries[i].file;
-                if (f->node && f->node->type == VFS_PIPE) {
-                    pipe_close(f->node);
-                }
-                p->fd_table->entries[i].in_use = 0;
-            }
-        }
-    }
-
-    /* Set exit status and mark as zombie for parent to reap */
-    p->exit_status = (int32_t)status;
-    p->state = PROC_ZOMBIE;
-
-    /* Notify parent of child exit */
-    if (p->parent != NULL) {
-        wq_wake(&p->parent->child_exit_wq);
-        sig_send(p->parent->pid, SIGCHLD);
-    }
-
-    thread_current()->state = THREAD_DEAD;
-    sched_schedule();
+    proc_exit(p, (int32_t)status);
     for (;;) __asm__ volatile ("hlt");
     __builtin_unreachable();  /* suppress -Wreturn-type */
 }
@@ -174,6 +169,7 @@ static int64_t sys_open(uint64_t path_addr, uint64_t flags, uint64_t mode,
         fd_free(p->fd_table, fd);
         return err;
     }
+    fd_file_addref(file);
     return fd;
 }
 
@@ -216,9 +212,7 @@ static int64_t sys_close(uint64_t fd, uint64_t a1, uint64_t a2,
     VfsFile *file = fd_get(p->fd_table, (int)fd);
     if (file == NULL) return -EBADF;
 
-    if (file->node && file->node->type == VFS_PIPE) {
-        pipe_close(file->node);
-    }
+    fd_file_release(file);
     vfs_close(file);
     fd_free(p->fd_table, (int)fd);
     return 0;
@@ -311,6 +305,22 @@ static int64_t sys_readdir(uint64_t path_addr, uint64_t entries_addr, uint64_t m
     return vfs_readdir(abs, entries, (uint32_t)max);
 }
 
+/* SYS_READDIR_AT: list the next batch of directory entries after the
+ * cursor at cursor_addr, and advance it */
+static int64_t sys_readdir_at(uint64_t path_addr, uint64_t entries_addr, uint64_t max,
+                              uint64_t cursor_addr, uint64_t a4, uint64_t a5) {
+    (void)a4; (void)a5;
+
+    if (max > 0 && !user_ptr_valid((void *)entries_addr, max * sizeof(VfsDirEntry))) return -EINVAL;
+    if (!user_ptr_valid((void *)cursor_addr, sizeof(uint64_t))) return -EINVAL;
+
+    char abs[PATH_MAX];
+    int perr = resolve_user_path(path_addr, abs, PATH_MAX);
+    if (perr != 0) return perr;
+
+    return vfs_readdir_at(abs, (uint64_t *)cursor_addr, (VfsDirEntry *)entries_addr, (uint32_t)max);
+}
+
 /* SYS_UNLINK: delete a file */
 static int64_t sys_unlink(uint64_t path_addr, uint64_t a1, uint64_t a2,
                           uint64_t a3, uint64_t a4, uint64_t a5) {
@@ -333,12 +343,13 @@ static int32_t wait_encode_stopped(int signo) {
 
 #define WNOHANG 1
 
-/* SYS_WAIT: wait for a child to exit or stop, return child PID */
+/* SYS_WAIT: wait for a child to exit or stop, return child PID.
+ * Arguments follow waitpid(pid, status, options); any child matches. */
 static Spinlock wait_lock = SPINLOCK_INIT;
 
-static int64_t sys_wait(uint64_t status_addr, uint64_t flags, uint64_t a2,
+static int64_t sys_wait(uint64_t pid, uint64_t status_addr, uint64_t flags,
                         uint64_t a3, uint64_t a4, uint64_t a5) {
-    (void)a2; (void)a3; (void)a4; (void)a5;
+    (void)pid; (void)a3; (void)a4; (void)a5;
     Process *p = proc_current();
     if (p == NULL) return -ENOSYS;
 
@@ -385,6 +396,23 @@ static int64_t sys_wait(uint64_t status_addr, uint64_t flags, uint64_t a2,
     }
 }
 
+/* The caller's user context, for a fork child to resume with RAX=0 */
+static ForkContext fork_context_from_frame(void) {
+    const SyscallFrame *frame = syscall_user_frame();
+    ForkContext ctx = {
+        .user_rip    = frame->rcx,
+        .user_rsp    = frame->rsp,
+        .user_rflags = frame->r11,
+        .user_rbp    = frame->rbp,
+        .user_rbx    = frame->rbx,
+        .user_r12    = frame->r12,
+        .user_r13    = frame->r13,
+        .user_r14    = frame->r14,
+        .user_r15    = frame->r15,
+    };
+    return ctx;
+}
+
 /* SYS_FORK: create child process */
 static int64_t sys_fork(uint64_t a0, uint64_t a1, uint64_t a2,
                         uint64_t a3, uint64_t a4, uint64_t a5) {
@@ -392,53 +420,38 @@ static int64_t sys_fork(uint64_t a0, uint64_t a1, uint64_t a2,
     Process *parent = proc_current();
     if (parent == NULL) return -ENOSYS;
 
-    ForkContext ctx = {
-        .user_rip    = syscall_saved_user_rip,
-        .user_rsp    = syscall_saved_user_rsp,
-        .user_rflags = syscall_saved_user_rflags,
-        .user_rbp    = syscall_saved_user_rbp,
-        .user_rbx    = syscall_saved_user_rbx,
-        .user_r12    = syscall_saved_user_r12,
-        .user_r13    = syscall_saved_user_r13,
-        .user_r14    = syscall_saved_user_r14,
-        .user_r15    = syscall_saved_user_r15,
-    };
-
+    ForkContext ctx = fork_context_from_frame();
     Process *child = proc_fork(parent, &ctx);
     if (child == NULL) return -ENOMEM;
 
     return (int64_t)child->pid;
 }
 
-/* Read an ELF binary from VFS into a kmalloc'd buffer.
- * Caller must kfree(*out_buf) on success. */
-static int exec_read_elf(const char *path, void **out_buf, uint64_t *out_size) {
-    VfsFile file;
-    int err = vfs_open(path, O_RDONLY, &file);
-    if (err != 0) return err;
+/* SYS_VFORK: create a child that borrows our address space; we stay
+ * suspended until it calls exec or exit */
+static int64_t sys_vfork(uint64_t a0, uint64_t a1, uint64_t a2,
+                         uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    Process *parent = proc_current();
+    if (parent == NULL) return -ENOSYS;
 
-    uint64_t file_size = file.node->size;
-    if (file_size == 0 || file_size > MAX_ELF_SIZE) {
-        vfs_close(&file);
-        return -EINVAL;
-    }
+    ForkContext ctx = fork_context_from_frame();
+    Process *child = proc_vfork(parent, &ctx);
+    if (child == NULL) return -ENOMEM;
 
-    void *elf_buf = kmalloc(file_size, 0);
-    if (elf_buf == NULL) {
-        vfs_close(&file);
-        return -ENOMEM;
-    }
+    proc_vfork_wait(child);
+    return (int64_t)child->pid;
+}
 
-    int bytes = vfs_read(&file, elf_buf, (uint32_t)file_size);
+/* Open an executable through the exec page cache. The caller holds a
+ * reference on the file on success. */
+static int exec_open_file(const char *path, PagerFile **out) {
+    VfsFile file;
+    int err = vfs_open(path, O_RDONLY, &file);
+    if (err != 0) return err;
+    err = pager_open(file.node, out);
     vfs_close(&file);
-    if (bytes < 0 || (uint64_t)bytes != file_size) {
-        kfree(elf_buf);
-        return -EIO;
-    }
-
-    *out_buf = elf_buf;
-    *out_size = file_size;
-    return 0;
+    return err;
 }
 
 /* Copy argv strings from the current (old) user address space into a kernel buffer.
@@ -482,9 +495,24 @@ static int exec_copy_argv(uint64_t argv_addr, ExecArgv *args) {
     return 0;
 }
 
+/* Auxiliary vector handed to the new image: AT_* pairs ending in AT_NULL */
+#define EXEC_AUXV_MAX 8
+
+typedef struct {
+    uint64_t entries[EXEC_AUXV_MAX][2];
+    int      count;
+} ExecAuxv;
+
+static void exec_auxv_add(ExecAuxv *aux, uint64_t type, uint64_t val) {
+    aux->entries[aux->count][0] = type;
+    aux->entries[aux->count][1] = val;
+    aux->count++;
+}
+
 /* Write argv data onto the new user stack. Called AFTER paging_write_cr3(new_pml4)
- * so kernel can write directly to user virtual addresses (no SMAP). */
-static void exec_setup_user_stack(const ExecArgv *args,
+ * so kernel can write directly to user virtual addresses (no SMAP).
+ * Layout, upwards from argv: argv[], NULL, envp NULL, auxv, AT_NULL. */
+static void exec_setup_user_stack(const ExecArgv *args, const ExecAuxv *aux,
                                   uint64_t *out_rsp, uint64_t *out_argv) {
     uint64_t sp = USER_STACK_TOP;
     uint64_t str_addrs[MAX_EXEC_ARGS];
@@ -500,22 +528,180 @@ static void exec_setup_user_stack(const ExecArgv *args,
     /* 2. Align to 8 bytes */
     sp &= ~7ULL;
 
-    /* 3. NULL terminator for argv array */
+    /* 3. Auxiliary vector, AT_NULL-terminated, then the empty envp */
+    sp -= 16;
+    ((uint64_t *)sp)[0] = AT_NULL;
+    ((uint64_t *)sp)[1] = 0;
+    for (int i = aux->count - 1; i >= 0; i--) {
+        sp -= 16;
+        ((uint64_t *)sp)[0] = aux->entries[i][0];
+        ((uint64_t *)sp)[1] = aux->entries[i][1];
+    }
+    sp -= 8;
+    *(uint64_t *)sp = 0;
+
+    /* 4. NULL terminator for argv array */
     sp -= 8;
     *(uint64_t *)sp = 0;
 
-    /* 4. argv pointers (reverse order, growing down) */
+    /* 5. argv pointers (reverse order, growing down) */
     for (int i = args->argc - 1; i >= 0; i--) {
         sp -= 8;
         *(uint64_t *)sp = str_addrs[i];
     }
-    *out_argv = (args->argc > 0) ? sp : 0;
+    *out_argv = sp;
 
-    /* 5. Align RSP to 16 bytes (ABI) */
+    /* 6. Align RSP to 16 bytes (ABI) */
     sp &= ~15ULL;
     *out_rsp = sp;
 }
 
+/* Copy len bytes at offset off of a cached file into buf. Returns 0, or
+ * -EINVAL if the range runs past the file. */
+static int exec_read_cached(const PagerFile *file, uint64_t off, void *buf,
+                            uint64_t len) {
+    if (off > file->size || len > file->size - off) return -EINVAL;
+    uint8_t *dst = buf;
+    while (len > 0) {
+        uint64_t in_page = off & (PAGE_SIZE - 1);
+        uint64_t n = PAGE_SIZE - in_page;
+        if (n > len) n = len;
+        memcpy(dst, (const uint8_t *)pager_page_data(file, off / PAGE_SIZE) + in_page, n);
+        dst += n;
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Get a cached file's headers and PT_LOAD segments. */
+static int exec_parse(const PagerFile *file, ElfLoadResult *result) {
+    uint64_t hdr_len = (file->size < PAGE_SIZE) ? file->size : PAGE_SIZE;
+    return elf_parse(pager_page_data(file, 0), hdr_len, file->size, result);
+}
+
+/* Set up the interpreter a dynamically linked program names in PT_INTERP.
+ * It must be a shared object with no interpreter of its own, and is placed
+ * at USER_INTERP_BASE. On success the caller owns *map. */
+static int exec_open_interp(const PagerFile *prog, const ElfLoadResult *prog_info,
+                            ElfMap *map, ElfLoadResult *result) {
+    char path[ELF_INTERP_MAX];
+    int err = exec_read_cached(prog, prog_info->interp_offset, path,
+                               prog_info->interp_size);
+    if (err != 0) return err;
+    if (path[0] != '/' || path[prog_info->interp_size - 1] != '\0') return -EINVAL;
+
+    PagerFile *file;
+    err = exec_open_file(path, &file);
+    if (err != 0) return err;
+
+    err = exec_parse(file, result);
+    if (err == 0 && (result->type != ET_DYN || result->interp_size != 0)) {
+        kprintf("[EXEC] Interpreter %s is not a shared library\n", path);
+        err = -EINVAL;
+    }
+    if (err == 0) {
+        err = elf_rebase(result, USER_INTERP_BASE,
+                         USER_INTERP_BASE + USER_INTERP_SIZE);
+    }
+    if (err != 0) { pager_put(file); return err; }
+
+    pager_mark_library(file);
+    map->file = file;
+    map->nsegs = result->nsegs;
+    memcpy(map->segs, result->segs, sizeof(result->segs));
+    return 0;
+}
+
+/* Drop an image's references on its binary and interpreter */
+static void exec_release_maps(UserImage *img) {
+    pager_map_release(&img->map);
+    pager_map_release(&img->interp);
+}
+
+/* Set up the ELF at abs in a fresh address space with a user stack holding
+ * args. Segments are not mapped: they fault in from the exec page cache.
+ * A dynamically linked program starts in its interpreter, which finds the
+ * program through the auxiliary vector.
+ * On success the caller owns img->pml4, img->map and img->interp. */
+static int exec_build_image(const char *abs, const ExecArgv *args, UserImage *img) {
+    memset(&img->map, 0, sizeof(img->map));
+    memset(&img->interp, 0, sizeof(img->interp));
+
+    /* 1. Get the binary's cached pages (reads it on first exec) */
+    PagerFile *file;
+    int err = exec_open_file(abs, &file);
+    if (err != 0) return err;
+    img->map.file = file;
+
+    /* 2. Parse headers from the first cached page */
+    ElfLoadResult result;
+    err = exec_parse(file, &result);
+    if (err == 0 && result.type != ET_EXEC) err = -EINVAL;
+    if (err != 0) { exec_release_maps(img); return err; }
+    img->map.nsegs = result.nsegs;
+    memcpy(img->map.segs, result.segs, sizeof(result.segs));
+
+    ExecAuxv aux = { .count = 0 };
+    exec_auxv_add(&aux, AT_PHDR, result.phdr);
+    exec_auxv_add(&aux, AT_PHENT, result.phentsize);
+    exec_auxv_add(&aux, AT_PHNUM, result.phnum);
+    exec_auxv_add(&aux, AT_PAGESZ, PAGE_SIZE);
+    exec_auxv_add(&aux, AT_ENTRY, result.entry_point);
+    img->entry = result.entry_point;
+
+    /* 3. Dynamically linked: enter the interpreter instead */
+    if (result.interp_size != 0) {
+        ElfLoadResult interp;
+        err = exec_open_interp(file, &result, &img->interp, &interp);
+        if (err != 0) { exec_release_maps(img); return err; }
+        exec_auxv_add(&aux, AT_BASE, USER_INTERP_BASE);
+        img->entry = interp.entry_point;
+    }
+
+    /* 4. Create fresh user address space */
+    uint64_t new_pml4 = vmm_create_user_pml4();
+    if (new_pml4 == 0) { exec_release_maps(img); return -ENOMEM; }
+
+    /* 5. Map user stack */
+    err = vmm_map_user_stack(new_pml4);
+    if (err != 0) {
+        vmm_free_user_pages(new_pml4);
+        exec_release_maps(img);
+        return err;
+    }
+
+    /* 6. Write argv and auxv onto it. Interrupts are off and the kernel
+     * half is shared, so briefly running on the new tables is safe. */
+    uint64_t cur_pml4 = paging_read_cr3();
+    paging_write_cr3(new_pml4);
+    exec_setup_user_stack(args, &aux, &img->user_rsp, &img->argv);
+    paging_write_cr3(cur_pml4);
+
+    img->pml4 = new_pml4;
+    img->argc = (uint64_t)args->argc;
+    img->brk_start = result.brk_start;
+    return 0;
+}
+
+/* Free an image that will not run */
+static void exec_discard_image(UserImage *img) {
+    vmm_free_user_pages(img->pml4);
+    exec_release_maps(img);
+}
+
+/* Apply the executable's setuid/setgid bits to p */
+static void exec_apply_setid(Process *p, const char *abs) {
+    VfsNode *exec_node = vfs_resolve(abs);
+    if (exec_node == NULL) return;
+    if (exec_node->mode & S_ISUID) {
+        p->euid = exec_node->uid;
+    }
+    if (exec_node->mode & S_ISGID) {
+        p->egid = exec_node->gid;
+    }
+}
+
 /* SYS_EXEC: replace process image with new ELF binary */
 static int64_t sys_exec(uint64_t path_addr, uint64_t argv_addr, uint64_t a2,
                         uint64_t a3, uint64_t a4, uint64_t a5) {
@@ -532,52 +718,149 @@ static int64_t sys_exec(uint64_t path_addr, uint64_t argv_addr, uint64_t a2,
     int argerr = exec_copy_argv(argv_addr, &args);
     if (argerr != 0) return argerr;
 
-    /* 2. Read ELF binary from VFS */
-    void *elf_buf;
-    uint64_t file_size;
-    int err = exec_read_elf(abs, &elf_buf, &file_size);
+    /* 2. Build the new image */
+    UserImage img;
+    int err = exec_build_image(abs, &args, &img);
     if (err != 0) return err;
 
-    /* 3. Create fresh user address space */
+    /* The I/O ring lives in the old image; in-flight requests still
+     * reference its buffers */
+    err = io_ring_release(p, 1);
+    if (err != 0) { exec_discard_image(&img); return err; }
+
+    /* 3. Check setuid/setgid bits on the executable */
+    exec_apply_setid(p, abs);
+
+    /* Shared mappings do not survive exec */
+    mmap_release(p);
+
+    /* 4. Switch to new address space. A vfork child's old one belongs to
+     * its parent, which resumes now. */
     uint64_t old_pml4 = p->page_table;
-    uint64_t new_pml4 = vmm_create_user_pml4();
-    if (new_pml4 == 0) { kfree(elf_buf); return -ENOMEM; }
+    UserImage old_image = p->image;
+    int borrowed = (p->vfork_parent != NULL);
+    p->page_table = img.pml4;
+    p->brk_start = img.brk_start;
+    p->brk_current = img.brk_start;
+    p->image = img;
+    paging_write_cr3(img.pml4);
+    if (borrowed) {
+        proc_vfork_release(p);
+    } else {
+        vmm_free_user_pages(old_pml4);
+        exec_release_maps(&old_image);
+    }
 
-    /* 4. Load ELF segments */
-    ElfLoadResult result;
-    err = elf_load(elf_buf, file_size, new_pml4, &result);
-    kfree(elf_buf);
-    if (err != 0) { vmm_destroy_user_pml4(new_pml4); return err; }
+    kprintf("[EXEC] pid=%u loaded '%s' argc=%d entry=0x%lx\n",
+            p->pid, abs, args.argc, img.entry);
+    jump_to_usermode(img.entry, img.user_rsp, img.argc, img.argv);
+}
 
-    /* 5. Map user stack */
-    err = vmm_map_user_stack(new_pml4);
-    if (err != 0) { vmm_free_user_pages(new_pml4); return err; }
+/* Kernel-side copy of a SYS_SPAWN request: too large for the kernel stack */
+typedef struct {
+    char         abs[PATH_MAX];
+    ExecArgv     args;
+    SpawnRequest req;
+    char         open_paths[SPAWN_MAX_ACTIONS][PATH_MAX];
+} SpawnPlan;
+
+/* Copy and validate the request while the caller's memory is mapped */
+static int spawn_copy_request(uint64_t path_addr, uint64_t argv_addr,
+                              uint64_t req_addr, SpawnPlan *plan) {
+    int err = resolve_user_path(path_addr, plan->abs, PATH_MAX);
+    if (err != 0) return err;
+    err = exec_copy_argv(argv_addr, &plan->args);
+    if (err != 0) return err;
 
-    /* 6. Check setuid/setgid bits on the executable */
-    VfsNode *exec_node = vfs_resolve(abs);
-    if (exec_node != NULL) {
-        if (exec_node->mode & S_ISUID) {
-            p->euid = exec_node->uid;
+    memset(&plan->req, 0, sizeof(plan->req));
+    if (req_addr == 0) return 0;
+    if (!user_ptr_valid((const void *)req_addr, sizeof(SpawnRequest))) return -EINVAL;
+    plan->req = *(const SpawnRequest *)req_addr;
+    if (plan->req.nactions > SPAWN_MAX_ACTIONS) return -EINVAL;
+
+    for (uint32_t i = 0; i < plan->req.nactions; i++) {
+        const SpawnFileAction *fa = &plan->req.actions[i];
+        if (fa->type != SPAWN_FA_OPEN) continue;
+        err = resolve_user_path(fa->path, plan->open_paths[i], PATH_MAX);
+        if (err != 0) return err;
+    }
+    return 0;
+}
+
+/* Run the file actions, in order, against the child's fd table */
+static int spawn_apply_actions(FdTable *ft, const SpawnPlan *plan) {
+    for (uint32_t i = 0; i < plan->req.nactions; i++) {
+        const SpawnFileAction *fa = &plan->req.actions[i];
+        int err;
+        switch (fa->type) {
+        case SPAWN_FA_CLOSE:
+            if (fd_get(ft, fa->fd) == NULL) return -EBADF;
+            fd_entry_close(&ft->entries[fa->fd]);
+            break;
+        case SPAWN_FA_DUP2:
+            err = fd_table_dup2(ft, fa->fd, fa->newfd);
+            if (err < 0) return err;
+            break;
+        case SPAWN_FA_OPEN: {
+            if (fa->fd < 0 || fa->fd >= MAX_FDS) return -EBADF;
+            VfsFile file;
+            err = vfs_open(plan->open_paths[i], fa->oflags, &file);
+            if (err != 0) return err;
+            FdEntry *e = &ft->entries[fa->fd];
+            if (e->in_use) fd_entry_close(e);
+            e->file = file;
+            e->in_use = 1;
+            fd_file_addref(&e->file);
+            break;
         }
-        if (exec_node->mode & S_ISGID) {
-            p->egid = exec_node->gid;
+        default:
+            return -EINVAL;
         }
     }
+    return 0;
+}
 
-    /* 7. Switch to new address space */
-    p->page_table = new_pml4;
-    p->brk_start = result.brk_start;
-    p->brk_current = result.brk_start;
-    vmm_free_user_pages(old_pml4);
-    paging_write_cr3(new_pml4);
+/* SYS_SPAWN: start a new process from an ELF path, with file actions and
+ * an optional process group; returns the child's pid */
+static int64_t sys_spawn(uint64_t path_addr, uint64_t argv_addr, uint64_t req_addr,
+                         uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return -ENOSYS;
 
-    /* 8. Write argv onto new user stack */
-    uint64_t user_rsp, argv_ptr;
-    exec_setup_user_stack(&args, &user_rsp, &argv_ptr);
+    SpawnPlan *plan = kmalloc(sizeof(SpawnPlan), 0);
+    if (plan == NULL) return -ENOMEM;
+
+    UserImage img;
+    FdTable *fds = NULL;
+    int err = spawn_copy_request(path_addr, argv_addr, req_addr, plan);
+    if (err == 0) err = exec_build_image(plan->abs, &plan->args, &img);
+    if (err != 0) { kfree(plan); return err; }
+
+    fds = fd_table_dup(p->fd_table);
+    err = (fds == NULL) ? -ENOMEM : spawn_apply_actions(fds, plan);
+    Process *child = NULL;
+    if (err == 0) {
+        child = proc_spawn(p, &img, fds);
+        if (child == NULL) err = -ENOMEM;
+    }
+    if (err != 0) {
+        if (fds != NULL) {
+            fd_table_close_all(fds);
+            kfree(fds);
+        }
+        exec_discard_image(&img);
+        kfree(plan);
+        return err;
+    }
 
-    kprintf("[EXEC] pid=%u loaded '%s' argc=%d entry=0x%lx\n",
-            p->pid, abs, args.argc, result.entry_point);
-    jump_to_usermode(result.entry_point, user_rsp, (uint64_t)args.argc, argv_ptr);
+    /* Set up before the child first runs: no setpgid race with the caller */
+    exec_apply_setid(child, plan->abs);
+    if (plan->req.flags & SPAWN_SETPGROUP) {
+        child->pgid = plan->req.pgid ? (pid_t)plan->req.pgid : child->pid;
+    }
+    kfree(plan);
+    return (int64_t)child->pid;
 }
 
 /* SYS_DUP2: duplicate a file descriptor */
@@ -587,30 +870,7 @@ static int64_t sys_dup2(uint64_t oldfd, uint64_t newfd, uint64_t a2,
     Process *p = proc_current();
     if (p == NULL || p->fd_table == NULL) return -ENOSYS;
     if (oldfd >= MAX_FDS || newfd >= MAX_FDS) return -EBADF;
-    if (oldfd == newfd) return (int64_t)newfd;
-
-    VfsFile *src = fd_get(p->fd_table, (int)oldfd);
-    if (src == NULL) return -EBADF;
-
-    /* If newfd is open, close it first */
-    FdEntry *dst_entry = &p->fd_table->entries[newfd];
-    if (dst_entry->in_use) {
-        if (dst_entry->file.node && dst_entry->file.node->type == VFS_PIPE) {
-            pipe_close(dst_entry->file.node);
-        }
-        dst_entry->in_use = 0;
-    }
-
-    /* Copy the file entry */
-    dst_entry->file = *src;
-    dst_entry->in_use = 1;
-
-    /* If it's a pipe, bump the ref count */
-    if (dst_entry->file.node && dst_entry->file.node->type == VFS_PIPE) {
-        pipe_addref(dst_entry->file.node);
-    }
-
-    return (int64_t)newfd;
+    return fd_table_dup2(p->fd_table, (int)oldfd, (int)newfd);
 }
 
 /* Initialize a pipe fd entry */
@@ -697,7 +957,7 @@ static int64_t sys_sigreturn(uint64_t a0, uint64_t a1, uint64_t a2,
     if (p == NULL) return -ENOSYS;
 
     /* Read SignalFrame from user RSP */
-    uint64_t user_rsp = syscall_saved_user_rsp;
+    uint64_t user_rsp = syscall_user_frame()->rsp;
     if (!user_ptr_valid((void *)user_rsp, sizeof(SignalFrame))) return -EINVAL;
 
     SignalFrame *sf = (SignalFrame *)user_rsp;
@@ -727,6 +987,26 @@ static int64_t sys_fstat(uint64_t fd, uint64_t stat_addr, uint64_t a2,
     return 0;
 }
 
+/* SYS_FSYNC: write an open file's cached data and metadata to disk */
+static int64_t sys_fsync(uint64_t fd, uint64_t a1, uint64_t a2,
+                         uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return -ENOSYS;
+    VfsFile *file = fd_get(p->fd_table, (int)fd);
+    if (file == NULL) return -EBADF;
+    return vfs_fsync(file);
+}
+
+/* SYS_SYNC: write every dirty buffer and filesystem's metadata to disk */
+static int64_t sys_sync(uint64_t a0, uint64_t a1, uint64_t a2,
+                        uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    int rc = vfs_sync();
+    if (bcache_flush(NULL) != 0) rc = -EIO;
+    return rc;
+}
+
 /* SYS_DUP: duplicate a file descriptor to the lowest free fd */
 static int64_t sys_dup(uint64_t oldfd, uint64_t a1, uint64_t a2,
                        uint64_t a3, uint64_t a4, uint64_t a5) {
@@ -742,10 +1022,7 @@ static int64_t sys_dup(uint64_t oldfd, uint64_t a1, uint64_t a2,
 
     FdEntry *dst_entry = &p->fd_table->entries[newfd];
     dst_entry->file = *src;
-
-    if (dst_entry->file.node && dst_entry->file.node->type == VFS_PIPE) {
-        pipe_addref(dst_entry->file.node);
-    }
+    fd_file_addref(&dst_entry->file);
 
     return (int64_t)newfd;
 }
@@ -922,6 +1199,30 @@ static int64_t sys_umask(uint64_t new_mask, uint64_t a1, uint64_t a2,
     return (int64_t)old;
 }
 
+/* SYS_SCHED_SETSCHEDULER: set a process's scheduling policy and priority,
+ * for its main thread and its io_ring workers. Real-time policies are
+ * root only; others may only change themselves or processes of their
+ * own user. */
+static int64_t sys_sched_setscheduler(uint64_t pid_arg, uint64_t policy, uint64_t prio,
+                                      uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    Process *cur = proc_current();
+    if (cur == NULL) return -ENOSYS;
+
+    Process *target = (pid_arg == 0) ? cur : proc_get_by_pid((uint32_t)pid_arg);
+    if (target == NULL || target->main_thread == NULL) return -ESRCH;
+    if (cur->euid != 0) {
+        if (policy != SCHED_NORMAL) return -EPERM;
+        if (target->uid != cur->euid) return -EPERM;
+    }
+
+    if (sched_setscheduler(target->main_thread, (int)policy, (int)prio) != 0) {
+        return -EINVAL;
+    }
+    io_ring_setscheduler(target, (int)policy, (int)prio);
+    return 0;
+}
+
 /* --- Socket syscalls --- */
 
 /* SYS_SOCKET: create a socket */
@@ -1065,6 +1366,131 @@ static int64_t sys_recvfrom(uint64_t fd, uint64_t buf_addr, uint64_t len,
     return ret;
 }
 
+/* SYS_IO_RING_SETUP: map an async I/O ring; returns its user address */
+static int64_t sys_io_ring_setup(uint64_t entries, uint64_t a1, uint64_t a2,
+                                 uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    if (entries > IO_RING_MAX_ENTRIES) return -EINVAL;
+    return io_ring_setup((uint32_t)entries);
+}
+
+/* SYS_IO_RING_ENTER: submit queued SQEs and optionally wait for CQEs */
+static int64_t sys_io_ring_enter(uint64_t to_submit, uint64_t min_complete, uint64_t a2,
+                                 uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    if (to_submit > UINT32_MAX || min_complete > UINT32_MAX) return -EINVAL;
+    return io_ring_enter((uint32_t)to_submit, (uint32_t)min_complete);
+}
+
+/* --- IPC syscalls --- */
+
+/* Helper: get the endpoint behind fd */
+static VfsNode *fd_to_endpoint(int fd) {
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return NULL;
+    VfsFile *f = fd_get(p->fd_table, fd);
+    if (f == NULL || f->node == NULL || f->node->type != VFS_ENDPOINT) return NULL;
+    return f->node;
+}
+
+/* SYS_IPC_ENDPOINT: create a synchronous IPC endpoint; returns its fd */
+static int64_t sys_ipc_endpoint(uint64_t a0, uint64_t a1, uint64_t a2,
+                                uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return -ENOSYS;
+
+    VfsNode *ep = ipc_endpoint_create();
+    if (ep == NULL) return -ENOMEM;
+
+    int fd = fd_alloc(p->fd_table);
+    if (fd < 0) { ipc_endpoint_close(ep); return -ENOMEM; }
+
+    VfsFile *f = fd_get(p->fd_table, fd);
+    f->node = ep;
+    f->offset = 0;
+    f->flags = O_RDWR;
+    return fd;
+}
+
+/* SYS_IPC_CALL: send a message and wait for the reply */
+static int64_t sys_ipc_call(uint64_t fd, uint64_t msg_addr, uint64_t a2,
+                            uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    if (!user_ptr_valid((void *)msg_addr, sizeof(IpcMsg))) return -EINVAL;
+    VfsNode *ep = fd_to_endpoint((int)fd);
+    if (ep == NULL) return -EBADF;
+    return ipc_call(ep, (IpcMsg *)msg_addr);
+}
+
+/* SYS_IPC_RECV: wait for a call */
+static int64_t sys_ipc_recv(uint64_t fd, uint64_t msg_addr, uint64_t a2,
+                            uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    if (!user_ptr_valid((void *)msg_addr, sizeof(IpcMsg))) return -EINVAL;
+    VfsNode *ep = fd_to_endpoint((int)fd);
+    if (ep == NULL) return -EBADF;
+    return ipc_recv(ep, (IpcMsg *)msg_addr);
+}
+
+/* SYS_IPC_REPLY: reply to the call being served */
+static int64_t sys_ipc_reply(uint64_t msg_addr, uint64_t a1, uint64_t a2,
+                             uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    if (!user_ptr_valid((void *)msg_addr, sizeof(IpcMsg))) return -EINVAL;
+    return ipc_reply((const IpcMsg *)msg_addr);
+}
+
+/* SYS_IPC_REPLY_RECV: reply, then wait for the next call */
+static int64_t sys_ipc_reply_recv(uint64_t fd, uint64_t msg_addr, uint64_t a2,
+                                  uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    if (!user_ptr_valid((void *)msg_addr, sizeof(IpcMsg))) return -EINVAL;
+    VfsNode *ep = fd_to_endpoint((int)fd);
+    if (ep == NULL) return -EBADF;
+    return ipc_reply_recv(ep, (IpcMsg *)msg_addr);
+}
+
+/* --- Memory mapping syscalls --- */
+
+/* SYS_MMAP: map a shared memory object; returns the address */
+static int64_t sys_mmap(uint64_t addr, uint64_t len, uint64_t prot,
+                        uint64_t flags, uint64_t fd, uint64_t off) {
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return -ENOSYS;
+    VfsFile *file = fd_get(p->fd_table, (int)fd);
+    if (file == NULL) return -EBADF;
+    return mmap_map(p, addr, len, (uint32_t)prot, (uint32_t)flags, file, off);
+}
+
+/* SYS_MUNMAP: remove mappings in a range */
+static int64_t sys_munmap(uint64_t addr, uint64_t len, uint64_t a2,
+                          uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    Process *p = proc_current();
+    if (p == NULL || p->page_table == 0) return -ENOSYS;
+    return mmap_unmap(p, addr, len);
+}
+
+/* SYS_FTRUNCATE: set the size of an open regular file */
+static int64_t sys_ftruncate(uint64_t fd, uint64_t length, uint64_t a2,
+                             uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    Process *p = proc_current();
+    if (p == NULL || p->fd_table == NULL) return -ENOSYS;
+    VfsFile *file = fd_get(p->fd_table, (int)fd);
+    if (file == NULL) return -EBADF;
+    if ((file->flags & O_ACCMODE) == O_RDONLY) return -EBADF;
+
+    /* File offsets are 32-bit below the VFS */
+    VfsNode *node = file->node;
+    if (node->type != VFS_FILE || length > UINT32_MAX) return -EINVAL;
+    if (node->ops == NULL || node->ops->truncate == NULL) return -EINVAL;
+    node->ops->truncate(node, length);
+    node->data_gen++;
+    return 0;
+}
+
 /* --- Dispatcher --- */
 
 int64_t syscall_dispatch(uint64_t num, uint64_t a0, uint64_t a1, uint64_t a2,
@@ -1072,7 +1498,11 @@ int64_t syscall_dispatch(uint64_t num, uint64_t a0, uint64_t a1, uint64_t a2,
     if (num >= SYSCALL_MAX || syscall_table[num] == NULL) {
         return -ENOSYS;
     }
-    return syscall_table[num](a0, a1, a2, a3, a4, a5);
+    int64_t ret = syscall_table[num](a0, a1, a2, a3, a4, a5);
+
+    /* Returning to user mode is a preemption point */
+    preempt_syscall_exit();
+    return ret;
 }
 
 /* --- Registration --- */
@@ -1085,7 +1515,7 @@ void syscall_register(uint32_t num, syscall_handler_t handler) {
 
 /* --- Initialization --- */
 
-void syscall_init(void) {
+void syscall_init_cpu(void) {
     /* 1. Enable SYSCALL/SYSRET in EFER */
     uint64_t efer = rdmsr(MSR_EFER);
     wrmsr(MSR_EFER, efer | EFER_SCE);
@@ -1102,8 +1532,12 @@ void syscall_init(void) {
 
     /* 4. Set SFMASK: clear IF (bit 9) and DF (bit 10) on SYSCALL entry */
     wrmsr(MSR_SFMASK, RFLAGS_IF | RFLAGS_DF);
+}
+
+void syscall_init(void) {
+    syscall_init_cpu();
 
-    /* 5. Register built-in handlers */
+    /* Register built-in handlers */
     syscall_register(SYS_EXIT,   sys_exit);
     syscall_register(SYS_WRITE,  sys_write);
     syscall_register(SYS_GETPID, sys_getpid);
@@ -1148,7 +1582,23 @@ void syscall_init(void) {
     syscall_register(SYS_RECV,      sys_recv);
     syscall_register(SYS_SENDTO,    sys_sendto);
     syscall_register(SYS_RECVFROM,  sys_recvfrom);
+    syscall_register(SYS_IO_RING_SETUP, sys_io_ring_setup);
+    syscall_register(SYS_IO_RING_ENTER, sys_io_ring_enter);
+    syscall_register(SYS_SPAWN,     sys_spawn);
+    syscall_register(SYS_VFORK,     sys_vfork);
+    syscall_register(SYS_SCHED_SETSCHEDULER, sys_sched_setscheduler);
+    syscall_register(SYS_IPC_ENDPOINT,   sys_ipc_endpoint);
+    syscall_register(SYS_IPC_CALL,       sys_ipc_call);
+    syscall_register(SYS_IPC_RECV,       sys_ipc_recv);
+    syscall_register(SYS_IPC_REPLY,      sys_ipc_reply);
+    syscall_register(SYS_IPC_REPLY_RECV, sys_ipc_reply_recv);
+    syscall_register(SYS_MMAP,      sys_mmap);
+    syscall_register(SYS_MUNMAP,    sys_munmap);
+    syscall_register(SYS_FTRUNCATE, sys_ftruncate);
+    syscall_register(SYS_FSYNC, sys_fsync);
+    syscall_register(SYS_SYNC, sys_sync);
+    syscall_register(SYS_READDIR_AT, sys_readdir_at);
 
     kprintf("[SYSCALL] Initialized (LSTAR=0x%lx, STAR=0x%lx)\n",
-            (uint64_t)syscall_entry, star);
+            (uint64_t)syscall_entry, rdmsr(MSR_STAR));
 }
@@ -51,6 +51,22 @@
 #define SYS_RECV      41
 #define SYS_SENDTO    42
 #define SYS_RECVFROM  43
+#define SYS_IO_RING_SETUP 44
+#define SYS_IO_RING_ENTER 45
+#define SYS_SPAWN     46
+#define SYS_VFORK     47
+#define SYS_SCHED_SETSCHEDULER 48
+#define SYS_IPC_ENDPOINT   49
+#define SYS_IPC_CALL       50
+#define SYS_IPC_RECV       51
+#define SYS_IPC_REPLY      52
+#define SYS_IPC_REPLY_RECV 53
+#define SYS_MMAP      54
+#define SYS_MUNMAP    55
+#define SYS_FTRUNCATE 56
+#define SYS_FSYNC     57
+#define SYS_SYNC      58
+#define SYS_READDIR_AT 59
 
 /* Syscall handler type: up to 6 arguments, returns int64_t */
 typedef int64_t (*syscall_handler_t)(uint64_t, uint64_t, uint64_t,
@@ -59,16 +75,16 @@ typedef int64_t (*syscall_handler_t)(uint64_t, uint64_t, uint64_t,
 /* Initialize SYSCALL/SYSRET MSRs and register built-in handlers. */
 void syscall_init(void);
 
+/* Program this CPU's SYSCALL/SYSRET MSRs. syscall_init does it for the BSP;
+ * each AP calls it during bring-up. */
+void syscall_init_cpu(void);
+
 /* Register a syscall handler for the given number. */
 void syscall_register(uint32_t num, syscall_handler_t handler);
 
 /* Assembly entry point for SYSCALL instruction. */
 extern void syscall_entry(void);
 
-/* Kernel stack pointer for SYSCALL — updated by scheduler on context switch.
- * Single-CPU only; SMP would need per-CPU storage. */
-extern uint64_t syscall_kernel_rsp;
-
 /* C dispatcher called from syscall_entry.asm */
 int64_t syscall_dispatch(uint64_t num, uint64_t a0, uint64_t a1, uint64_t a2,
                          uint64_t a3, uint64_t a4, uint64_t a5);
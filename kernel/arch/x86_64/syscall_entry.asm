@@ -5,22 +5,33 @@
 ;   RSP = user stack (not swapped by hardware)
 ;   RAX = syscall number
 ;   RDI, RSI, RDX, R10, R8, R9 = args 0-5
+;
+; SWAPGS makes GS point at this CPU's PerCpu, so both scratch space for the
+; user RSP and the kernel stack top are per-CPU and several CPUs can be in
+; here at once.  IF is clear (SFMASK) until SYSRET, so nothing can observe
+; the swapped GS before the stack switch.
+
+; PerCpu field offsets — must match PERCPU_*_OFFSET in percpu.h
+%define PERCPU_KERNEL_RSP  24
+%define PERCPU_USER_RSP    32
+%define PERCPU_SIG_ARG     40
 
 section .text
 global syscall_entry
 extern syscall_dispatch
-extern syscall_kernel_rsp
 extern sig_maybe_deliver
-extern sig_pending_arg
 
 syscall_entry:
-    ; Save user RSP to scratch space (can't trust user stack)
-    mov [rel syscall_user_rsp], rsp
+    swapgs
+    ; Save user RSP to per-CPU scratch (can't trust user stack)
+    mov [gs:PERCPU_USER_RSP], rsp
     ; Load kernel stack (set by scheduler on context switch)
-    mov rsp, [rel syscall_kernel_rsp]
+    mov rsp, [gs:PERCPU_KERNEL_RSP]
 
-    ; Build frame: push user context (callee-saved + return info)
-    push qword [rel syscall_user_rsp]   ; user RSP
+    ; Build frame: push user context (callee-saved + return info).
+    ; The frame sits at the top of the thread's kernel stack, where fork
+    ; and sigreturn find it (SyscallFrame in signal.h).
+    push qword [gs:PERCPU_USER_RSP]     ; user RSP
     push r11                             ; user RFLAGS
     push rcx                             ; user RIP
     push rbx                             ; callee-saved regs
@@ -30,18 +41,6 @@ syscall_entry:
     push r14
     push r15
 
-    ; Save user context to globals for fork()
-    mov [rel syscall_saved_user_rip], rcx
-    mov [rel syscall_saved_user_rflags], r11
-    push qword [rel syscall_user_rsp]
-    pop qword [rel syscall_saved_user_rsp]
-    mov [rel syscall_saved_user_rbp], rbp
-    mov [rel syscall_saved_user_rbx], rbx
-    mov [rel syscall_saved_user_r12], r12
-    mov [rel syscall_saved_user_r13], r13
-    mov [rel syscall_saved_user_r14], r14
-    mov [rel syscall_saved_user_r15], r15
-
     ; Shuffle registers for C calling convention:
     ;   syscall_dispatch(num, a0, a1, a2, a3, a4, a5)
     ;   RDI=num  RSI=a0  RDX=a1  RCX=a2  R8=a3  R9=a4  [rsp]=a5
@@ -62,10 +61,10 @@ syscall_entry:
     ; sig_maybe_deliver(frame_ptr=rsp, syscall_ret=rax)
     mov rdi, rsp            ; SyscallFrame pointer
     mov rsi, rax            ; syscall return value
-    mov qword [rel sig_pending_arg], 0
+    mov qword [gs:PERCPU_SIG_ARG], 0
     call sig_maybe_deliver
     ; RAX = (possibly modified) return value
-    ; sig_pending_arg = signo for handler RDI, or 0
+    ; PerCpu.sig_arg = signo for handler RDI, or 0
 
     ; Restore callee-saved registers and user context
     pop r15
@@ -78,30 +77,9 @@ syscall_entry:
     pop r11                 ; user RFLAGS
 
     ; Load signal handler arg into RDI (0 if no signal)
-    mov rdi, [rel sig_pending_arg]
+    mov rdi, [gs:PERCPU_SIG_ARG]
 
     pop rsp                 ; user RSP
 
+    swapgs                  ; restore user GS base
     o64 sysret              ; return to user mode (64-bit SYSRET)
-
-section .bss
-syscall_user_rsp: resq 1   ; scratch for user RSP (single-CPU only)
-
-global syscall_saved_user_rip
-global syscall_saved_user_rsp
-global syscall_saved_user_rflags
-global syscall_saved_user_rbp
-global syscall_saved_user_rbx
-global syscall_saved_user_r12
-global syscall_saved_user_r13
-global syscall_saved_user_r14
-global syscall_saved_user_r15
-syscall_saved_user_rip:    resq 1
-syscall_saved_user_rsp:    resq 1
-syscall_saved_user_rflags: resq 1
-syscall_saved_user_rbp:    resq 1
-syscall_saved_user_rbx:    resq 1
-syscall_saved_user_r12:    resq 1
-syscall_saved_user_r13:    resq 1
-syscall_saved_user_r14:    resq 1
-syscall_saved_user_r15:    resq 1
@@ -0,0 +1,35 @@
+/* arc_os — Time-stamp counter clock
+ *
+ * Fine-grained timestamps for latency accounting, where 10 ms PIT ticks
+ * are too coarse. The rate is measured against the PIT once at boot and
+ * assumed constant (invariant TSC). */
+
+#include "arch/x86_64/tsc.h"
+#include "lib/kprintf.h"
+
+static uint64_t tsc_khz;
+static uint64_t calibrate_start;
+
+void tsc_calibrate_tick(uint64_t ticks, uint32_t pit_hz) {
+    if (tsc_khz != 0 || pit_hz == 0) return;
+
+    /* Start on a tick edge, not partway through the first tick */
+    if (ticks == 1) {
+        calibrate_start = tsc_read();
+    } else if (ticks == 1 + TSC_CALIBRATE_TICKS) {
+        uint64_t ms = (TSC_CALIBRATE_TICKS * 1000ULL) / pit_hz;
+        tsc_khz = (tsc_read() - calibrate_start) / ms;
+        kprintf("[TSC] Calibrated at %lu kHz\n", tsc_khz);
+    }
+}
+
+uint64_t tsc_to_ns(uint64_t cycles) {
+    if (tsc_khz == 0) return 0;
+    /* Split to avoid overflowing cycles * 10^6 */
+    return (cycles / tsc_khz) * 1000000ULL +
+           ((cycles % tsc_khz) * 1000000ULL) / tsc_khz;
+}
+
+uint64_t tsc_from_ns(uint64_t ns) {
+    return (ns / 1000000ULL) * tsc_khz + ((ns % 1000000ULL) * tsc_khz) / 1000000ULL;
+}
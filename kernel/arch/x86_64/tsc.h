@@ -0,0 +1,26 @@
+#ifndef ARCHOS_ARCH_X86_64_TSC_H
+#define ARCHOS_ARCH_X86_64_TSC_H
+
+#include <stdint.h>
+
+/* PIT ticks the TSC is measured over before tsc_to_ns() is usable */
+#define TSC_CALIBRATE_TICKS 10
+
+/* Read the time-stamp counter. */
+static inline uint64_t tsc_read(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Called from the PIT handler with the tick count: measures the TSC rate
+ * over the first TSC_CALIBRATE_TICKS ticks, without busy-waiting. */
+void tsc_calibrate_tick(uint64_t ticks, uint32_t pit_hz);
+
+/* Convert a TSC cycle count to nanoseconds. Returns 0 until calibrated. */
+uint64_t tsc_to_ns(uint64_t cycles);
+
+/* Convert nanoseconds to TSC cycles. Returns 0 until calibrated. */
+uint64_t tsc_from_ns(uint64_t ns);
+
+#endif /* ARCHOS_ARCH_X86_64_TSC_H */
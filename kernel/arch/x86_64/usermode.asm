@@ -20,6 +20,10 @@ global jump_to_usermode
 %define RFLAGS_IF       0x202   ; RFLAGS with Interrupt Flag set
 
 jump_to_usermode:
+    ; No interrupts between SWAPGS and IRETQ: a kernel-mode IRQ there would
+    ; run with the user GS base. IRETQ reloads IF from the frame.
+    cli
+
     ; Save argc/argv before building IRETQ frame clobbers RDX/RCX
     mov r8, rdx             ; r8 = argc
     mov r9, rcx             ; r9 = argv_ptr
@@ -50,6 +54,7 @@ jump_to_usermode:
     xor r14, r14
     xor r15, r15
 
+    swapgs                  ; GS base -> user (PerCpu parked in KERNEL_GS_BASE)
     iretq
 
 ; void fork_return_to_user(const ForkContext *ctx)
@@ -69,6 +74,8 @@ jump_to_usermode:
 global fork_return_to_user
 
 fork_return_to_user:
+    cli                     ; As above: SYSRET restores IF from R11
+
     ; Load callee-saved registers from ForkContext (must finish before zeroing RDI)
     mov rbp, [rdi + 24]
     mov rbx, [rdi + 32]
@@ -91,4 +98,5 @@ fork_return_to_user:
     xor r10, r10
     xor rdi, rdi            ; Zero RDI last (was struct pointer)
 
+    swapgs                  ; GS base -> user (PerCpu parked in KERNEL_GS_BASE)
     o64 sysret
@@ -10,6 +10,9 @@
 #include "proc/thread.h"
 #include "proc/sched.h"
 #include "proc/process.h"
+#include "proc/rcu.h"
+#include "proc/workqueue.h"
+#include "proc/pager.h"
 #include "arch/x86_64/syscall.h"
 #include "proc/init.h"
 #include "drivers/acpi.h"
@@ -30,6 +33,8 @@
 #include "fs/fat32.h"
 #include "fs/devfs.h"
 #include "fs/procfs.h"
+#include "fs/shmfs.h"
+#include "fs/flusher.h"
 #include <stddef.h>
 #include <stdint.h>
 
@@ -135,6 +140,26 @@ static void heap_self_test(void) {
     kmalloc_dump_stats();
 }
 
+/* Copy a file within the VFS and mark the copy executable. */
+static int copy_executable(const char *src, const char *dst) {
+    VfsFile sf, df;
+    int err = vfs_open(src, O_RDONLY, &sf);
+    if (err != 0) return err;
+    err = vfs_open(dst, O_CREAT | O_WRONLY, &df);
+    if (err == 0) {
+        uint8_t tmpbuf[4096];
+        int nr;
+        while ((nr = vfs_read(&sf, tmpbuf, sizeof(tmpbuf))) > 0) {
+            vfs_write(&df, tmpbuf, (uint32_t)nr);
+        }
+        /* Mark as executable */
+        if (df.node) df.node->mode = 0755;
+        vfs_close(&df);
+    }
+    vfs_close(&sf);
+    return err;
+}
+
 /* Initialize VFS with ramfs, load boot modules, create /etc/hostname. */
 static void vfs_setup(const BootInfo *info) {
     vfs_init();
@@ -202,38 +227,33 @@ static void vfs_setup(const BootInfo *info) {
                 strncpy(dst + dlen, boot_entries[i].name, sizeof(dst) - dlen - 1);
                 dst[sizeof(dst) - 1] = '\0';
 
-                /* Skip kernel.elf and the 5 main programs */
+                /* Skip kernel.elf, the 5 main programs and the shared library */
                 if (strcmp(boot_entries[i].name, "kernel.elf") == 0 ||
                     strcmp(boot_entries[i].name, "init") == 0 ||
                     strcmp(boot_entries[i].name, "login") == 0 ||
                     strcmp(boot_entries[i].name, "shell") == 0 ||
                     strcmp(boot_entries[i].name, "hello") == 0 ||
-                    strcmp(boot_entries[i].name, "echo") == 0) {
+                    strcmp(boot_entries[i].name, "echo") == 0 ||
+                    strcmp(boot_entries[i].name, "libarc.so") == 0) {
                     continue;
                 }
 
-                VfsFile sf, df;
-                if (vfs_open(src, O_RDONLY, &sf) == 0) {
-                    if (vfs_open(dst, O_CREAT | O_WRONLY, &df) == 0) {
-                        uint8_t tmpbuf[4096];
-                        int nr;
-                        while ((nr = vfs_read(&sf, tmpbuf, sizeof(tmpbuf))) > 0) {
-                            vfs_write(&df, tmpbuf, (uint32_t)nr);
-                        }
-                        /* Mark as executable */
-                        if (df.node) df.node->mode = 0755;
-                        vfs_close(&df);
-                    }
-                    vfs_close(&sf);
-                }
+                copy_executable(src, dst);
             }
         }
         kprintf("[VFS] Created /bin with coreutils\n");
     }
 
+    /* The shared C library, which is also the program interpreter */
+    vfs_mkdir("/lib", 0755);
+    if (copy_executable("/boot/libarc.so", "/lib/libarc.so") == 0) {
+        kprintf("[VFS] Installed /lib/libarc.so\n");
+    }
+
     /* Mount devfs at /dev */
     VfsNode *dev_root = devfs_init();
     if (dev_root) {
+        devfs_attach("shm", shmfs_init());
         vfs_mount("/dev", dev_root);
         kprintf("[VFS] Mounted devfs at /dev\n");
     }
@@ -291,6 +311,8 @@ void kmain(void) {
 
     serial_puts("[BOOT] stage: GDT\n");
     gdt_init();
+    /* GS must point at CPU 0's PerCpu before anything calls this_cpu() */
+    percpu_init_bsp();
     serial_puts("[BOOT] stage: IDT\n");
     idt_init();
     serial_puts("[BOOT] stage: PIC\n");
@@ -338,6 +360,7 @@ void kmain(void) {
     sched_init();
     proc_init();
     syscall_init();
+    pager_init();
 
     /* Initialize TTY and PS/2 keyboard (TTY first — keyboard handler calls tty_input_char) */
     tty_init();
@@ -353,9 +376,6 @@ void kmain(void) {
         if (acpi && acpi->local_apic_address != 0) {
             uint64_t hhdm = vmm_get_hhdm_offset();
 
-            /* Initialize BSP's per-CPU data */
-            percpu_init_bsp();
-
             /* Initialize BSP's Local APIC */
             lapic_init(acpi->local_apic_address + hhdm);
             percpu_data[0].apic_id = lapic_id();
@@ -401,6 +421,12 @@ void kmain(void) {
         }
     }
 
+    /* Kernel worker threads for deferred work (after SMP: one pool per CPU) */
+    workqueue_init();
+
+    /* Background write-back of dirty disk buffers */
+    flusher_init();
+
     /* Launch init process from boot module */
     if (init_launch(info) != 0) {
         kprintf("[BOOT] WARNING: init_launch failed, falling back to test threads\n");
@@ -422,8 +448,11 @@ void kmain(void) {
     kprintf("[BOOT] Preemptive multitasking active.\n");
     __asm__ volatile ("sti");
 
-    /* Idle loop — HLT wakes on interrupt, then halts again */
+    /* Idle loop — HLT wakes on interrupt, then halts again. Idle is an RCU
+     * quiescent state, and the place where deferred RCU callbacks run. */
     for (;;) {
+        rcu_note_qs();
+        rcu_process_callbacks();
         __asm__ volatile ("hlt");
     }
 }
@@ -206,3 +206,15 @@ uint16_t virtq_pop_used(Virtqueue *vq, uint32_t *len) {
     vq->last_used_idx++;
     return desc_head;
 }
+
+void virtq_disable_irq(Virtqueue *vq) {
+    vq->avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
+    virtio_mb();
+}
+
+int virtq_enable_irq(Virtqueue *vq) {
+    vq->avail->flags &= (uint16_t)~VRING_AVAIL_F_NO_INTERRUPT;
+    /* Flag store must be visible before we re-check the used index */
+    virtio_mb();
+    return virtq_has_used(vq);
+}
@@ -27,6 +27,9 @@
 #define VRING_DESC_F_NEXT           0x01  /* Descriptor chains via next field */
 #define VRING_DESC_F_WRITE          0x02  /* Device writes (vs reads) */
 
+/* Available ring flags */
+#define VRING_AVAIL_F_NO_INTERRUPT  0x01  /* Driver does not want used IRQs */
+
 /* Maximum virtqueues per device */
 #define VIRTIO_MAX_QUEUES  4
 
@@ -115,4 +118,13 @@ int virtq_has_used(Virtqueue *vq);
 /* Pop a used entry. Sets *len to bytes written. Returns descriptor head index. */
 uint16_t virtq_pop_used(Virtqueue *vq, uint32_t *len);
 
+/* Ask the device not to interrupt when it adds used entries. Only a hint:
+ * a legacy device may still raise an interrupt that is already in flight. */
+void virtq_disable_irq(Virtqueue *vq);
+
+/* Re-enable used-ring interrupts. Returns non-zero if entries arrived
+ * before the device could see the change — the caller must poll again,
+ * since no interrupt will be raised for them. */
+int virtq_enable_irq(Virtqueue *vq);
+
 #endif /* ARCHOS_DRIVERS_VIRTIO_H */
@@ -10,6 +10,7 @@
 #include "lib/kprintf.h"
 #include "net/netif.h"
 #include "net/ethernet.h"
+#include "net/napi.h"
 
 #define RX_BUF_COUNT  16
 #define POLL_TIMEOUT  10000000
@@ -32,6 +33,9 @@ static NetRxBuf rx_bufs[RX_BUF_COUNT];
 /* NetIf for the network stack */
 static NetIf net_nif;
 
+/* RX poll context */
+static Napi net_napi;
+
 /* Forward declaration for rx dispatch */
 static void net_rx_dispatch(const void *frame, uint32_t len);
 
@@ -74,11 +78,27 @@ static int rx_bufs_init(void) {
 
 /* --- IRQ handler --- */
 
+/* RX processing runs the whole stack (ARP, IP, TCP, socket wakeups), so it
+ * is deferred to a NAPI poll context instead of running inside the
+ * interrupt.  The interrupt stays masked until a pass drains the ring. */
+static int net_rx_poll(Napi *napi, int budget) {
+    (void)napi;
+    int done = virtio_net_poll_rx(budget);
+    if (done < budget) {
+        /* A frame may have landed after the last check but before the
+         * device saw interrupts re-enabled; it would raise no IRQ. */
+        if (virtq_enable_irq(&net_vdev.queues[RX_QUEUE]))
+            napi_schedule(&net_napi);
+    }
+    return done;
+}
+
 static void virtio_net_irq_handler(InterruptFrame *frame) {
     (void)frame;
     /* Reading ISR status clears the interrupt */
     inb(net_vdev.io_base + VIRTIO_REG_ISR_STATUS);
-    virtio_net_poll_rx();
+    virtq_disable_irq(&net_vdev.queues[RX_QUEUE]);
+    napi_schedule(&net_napi);
 }
 
 /* --- Public API --- */
@@ -119,6 +139,7 @@ int virtio_net_init(void) {
     }
 
     /* Register IRQ handler */
+    napi_init(&net_napi, net_rx_poll, NAPI_POLL_WEIGHT);
     uint8_t irq = pci->irq_line;
     isr_register_handler(IRQ_BASE + irq, virtio_net_irq_handler);
     pic_unmask(irq);
@@ -177,13 +198,13 @@ int virtio_net_send(const void *data, uint32_t len) {
     return (timeout > 0) ? 0 : -1;
 }
 
-int virtio_net_poll_rx(void) {
+int virtio_net_poll_rx(int budget) {
     if (!net_initialized) return 0;
 
     Virtqueue *vq = &net_vdev.queues[RX_QUEUE];
     int count = 0;
 
-    while (virtq_has_used(vq)) {
+    while (count < budget && virtq_has_used(vq)) {
         uint32_t used_len;
         uint16_t desc_head = virtq_pop_used(vq, &used_len);
 
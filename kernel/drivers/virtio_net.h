@@ -26,8 +26,9 @@ int virtio_net_init(void);
 /* Send an Ethernet frame (without virtio-net header — driver prepends it). */
 int virtio_net_send(const void *data, uint32_t len);
 
-/* Poll receive queue. Dispatches to net stack. Returns packets processed. */
-int virtio_net_poll_rx(void);
+/* Poll receive queue for at most `budget` frames. Dispatches to net stack.
+ * Returns frames processed; fewer than `budget` means the ring is drained. */
+int virtio_net_poll_rx(int budget);
 
 /* Get the device MAC address. */
 void virtio_net_get_mac(uint8_t mac[6]);
@@ -0,0 +1,386 @@
+/* arc_os — Block buffer cache */
+
+#include "fs/bcache.h"
+#include "fs/vfs.h"
+#include "mm/pmm.h"
+#include "mm/kmalloc.h"
+#include "lib/mem.h"
+#include "arch/x86_64/pit.h"
+
+#define SECTOR_SIZE 512
+
+static Buffer *buffers[BCACHE_MAX_BUFFERS];     /* CLOCK ring */
+static uint32_t buffer_count;
+static uint32_t clock_hand;
+static uint32_t dirty_count;
+static Buffer *hash_table[BCACHE_HASH_SIZE];
+
+static struct {
+    const BlockDevice *dev;
+    BcacheStats        stats;
+} dev_stats[BLKDEV_MAX];
+
+static BcacheStats *bcache_stats_for(const BlockDevice *dev) {
+    for (int i = 0; i < BLKDEV_MAX; i++) {
+        if (dev_stats[i].dev == dev) return &dev_stats[i].stats;
+        if (dev_stats[i].dev == NULL) {
+            dev_stats[i].dev = dev;
+            return &dev_stats[i].stats;
+        }
+    }
+    return NULL;
+}
+
+/* --- Hash table --- */
+
+static uint32_t bcache_hash(const BlockDevice *dev, uint64_t sector) {
+    uint64_t h = (sector ^ ((uintptr_t)dev >> 4)) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32) % BCACHE_HASH_SIZE;
+}
+
+static Buffer *bcache_find(const BlockDevice *dev, uint64_t sector) {
+    for (Buffer *b = hash_table[bcache_hash(dev, sector)]; b != NULL; b = b->hash_next) {
+        if (b->dev == dev && b->sector == sector) return b;
+    }
+    return NULL;
+}
+
+static void bcache_hash_insert(Buffer *b) {
+    uint32_t h = bcache_hash(b->dev, b->sector);
+    b->hash_next = hash_table[h];
+    hash_table[h] = b;
+}
+
+/* Unhash b and mark it free for reuse */
+static void bcache_forget(Buffer *b) {
+    Buffer **link = &hash_table[bcache_hash(b->dev, b->sector)];
+    while (*link != NULL && *link != b) link = &(*link)->hash_next;
+    if (*link == b) *link = b->hash_next;
+    b->hash_next = NULL;
+    b->dev = NULL;
+    b->valid = 0;
+    if (b->dirty) dirty_count--;
+    b->dirty = 0;
+}
+
+/* --- Write-back and eviction --- */
+
+static int bcache_writeback(Buffer *b) {
+    if (b->dev->write(b->dev, b->sector, b->count, b->data) != 0) return -EIO;
+    b->dirty = 0;
+    dirty_count--;
+    BcacheStats *st = bcache_stats_for(b->dev);
+    if (st != NULL) st->writebacks++;
+    return 0;
+}
+
+/* CLOCK: skip buffers in use, give recently used ones a second chance,
+ * write back a dirty victim before reusing it */
+static Buffer *bcache_evict(void) {
+    for (uint32_t step = 0; step < 2 * buffer_count; step++) {
+        Buffer *b = buffers[clock_hand];
+        clock_hand = (clock_hand + 1) % buffer_count;
+        if (b->refs > 0) continue;
+        if (b->referenced) {
+            b->referenced = 0;
+            continue;
+        }
+        if (b->dev != NULL) {
+            if (b->dirty && bcache_writeback(b) != 0) continue;
+            bcache_forget(b);
+        }
+        return b;
+    }
+    return NULL;
+}
+
+static Buffer *bcache_new_buffer(void) {
+    if (buffer_count >= BCACHE_MAX_BUFFERS) return NULL;
+    Buffer *b = kmalloc(sizeof(Buffer), GFP_ZERO);
+    if (b == NULL) return NULL;
+    buffers[buffer_count++] = b;
+    return b;
+}
+
+/* A free buffer: a new one while memory is plentiful, else a recycled one */
+static Buffer *bcache_alloc(void) {
+    Buffer *b = NULL;
+    if (pmm_get_free_pages() >= BCACHE_MIN_FREE_PAGES) b = bcache_new_buffer();
+    if (b == NULL && buffer_count > 0) b = bcache_evict();
+    if (b == NULL) b = bcache_new_buffer();
+    return b;
+}
+
+static int bcache_resize(Buffer *b, uint32_t count) {
+    if (b->data != NULL && b->count == count) return 0;
+    uint8_t *data = kmalloc((size_t)count * SECTOR_SIZE, 0);
+    if (data == NULL) return -ENOMEM;
+    kfree(b->data);
+    b->data = data;
+    b->count = count;
+    return 0;
+}
+
+/* --- Public API --- */
+
+static Buffer *bcache_lookup(BlockDevice *dev, uint64_t sector, uint32_t count, int fill) {
+    if (dev == NULL || count == 0) return NULL;
+    BcacheStats *st = bcache_stats_for(dev);
+
+    Buffer *b = bcache_find(dev, sector);
+    if (b != NULL && b->count == count && (b->valid || !fill)) {
+        if (st != NULL) st->hits++;
+        b->refs++;
+        b->referenced = 1;
+        return b;
+    }
+
+    if (b != NULL && b->count != count) {
+        /* Cached with another size: only reshaped while nobody holds it */
+        if (b->refs > 0) return NULL;
+        if (b->dirty && bcache_writeback(b) != 0) return NULL;
+        b->valid = 0;
+    } else if (b == NULL) {
+        b = bcache_alloc();
+        if (b == NULL) return NULL;
+        b->dev = dev;
+        b->sector = sector;
+        bcache_hash_insert(b);
+    }
+    if (st != NULL) st->misses++;
+
+    if (bcache_resize(b, count) != 0) {
+        if (b->refs == 0) bcache_forget(b);
+        return NULL;
+    }
+    if (fill) {
+        if (dev->read(dev, sector, count, b->data) != 0) {
+            if (b->refs == 0) bcache_forget(b);
+            return NULL;
+        }
+        b->valid = 1;
+    }
+    b->refs++;
+    b->referenced = 1;
+    return b;
+}
+
+Buffer *bcache_read(BlockDevice *dev, uint64_t sector, uint32_t count) {
+    return bcache_lookup(dev, sector, count, 1);
+}
+
+Buffer *bcache_get(BlockDevice *dev, uint64_t sector, uint32_t count) {
+    return bcache_lookup(dev, sector, count, 0);
+}
+
+void bcache_mark_dirty(Buffer *b) {
+    b->valid = 1;
+    if (!b->dirty) {
+        b->dirty = 1;
+        b->dirtied_ms = pit_get_uptime_ms();
+        dirty_count++;
+    }
+}
+
+void bcache_release(Buffer *b) {
+    if (b == NULL || b->refs == 0) return;
+    b->refs--;
+    /* Never filled: a later read must go to the disk */
+    if (b->refs == 0 && !b->valid) bcache_forget(b);
+}
+
+/* --- Direct transfers --- */
+
+static int bcache_dev_read(BlockDevice *dev, uint64_t sector, uint32_t count, uint8_t *buf) {
+    while (count > 0) {
+        uint32_t n = count < BCACHE_IO_MAX_SECTORS ? count : BCACHE_IO_MAX_SECTORS;
+        if (dev->read(dev, sector, n, buf) != 0) return -EIO;
+        sector += n;
+        count -= n;
+        buf += (size_t)n * SECTOR_SIZE;
+    }
+    return 0;
+}
+
+static int bcache_dev_write(BlockDevice *dev, uint64_t sector, uint32_t count, const uint8_t *buf) {
+    while (count > 0) {
+        uint32_t n = count < BCACHE_IO_MAX_SECTORS ? count : BCACHE_IO_MAX_SECTORS;
+        if (dev->write(dev, sector, n, buf) != 0) return -EIO;
+        sector += n;
+        count -= n;
+        buf += (size_t)n * SECTOR_SIZE;
+    }
+    return 0;
+}
+
+int bcache_read_direct(BlockDevice *dev, uint64_t sector, uint32_t count,
+                       uint32_t block, void *buf) {
+    if (dev == NULL || block == 0 || count % block != 0) return -EINVAL;
+    BcacheStats *st = bcache_stats_for(dev);
+    uint8_t *out = buf;
+    uint32_t run = 0;           /* Uncached blocks waiting to be read */
+
+    for (uint32_t off = 0; off < count; off += block) {
+        Buffer *b = bcache_find(dev, sector + off);
+        if (b != NULL && b->count != block) {
+            /* Cached with another shape: make sure the disk is current */
+            if (b->dirty && bcache_writeback(b) != 0) return -EIO;
+            b = NULL;
+        }
+        if (b == NULL || !b->valid) {
+            run += block;
+            if (st != NULL) st->misses++;
+            continue;
+        }
+        if (run > 0 && bcache_dev_read(dev, sector + off - run, run,
+                                       out + (size_t)(off - run) * SECTOR_SIZE) != 0) {
+            return -EIO;
+        }
+        run = 0;
+        memcpy(out + (size_t)off * SECTOR_SIZE, b->data, (size_t)block * SECTOR_SIZE);
+        b->referenced = 1;
+        if (st != NULL) st->hits++;
+    }
+    if (run > 0 && bcache_dev_read(dev, sector + count - run, run,
+                                   out + (size_t)(count - run) * SECTOR_SIZE) != 0) {
+        return -EIO;
+    }
+    return 0;
+}
+
+int bcache_write_direct(BlockDevice *dev, uint64_t sector, uint32_t count,
+                        uint32_t block, const void *buf) {
+    if (dev == NULL || block == 0 || count % block != 0) return -EINVAL;
+    const uint8_t *in = buf;
+
+    /* Drop differently shaped copies first so none is written back over
+     * the new data later */
+    for (uint32_t off = 0; off < count; off += block) {
+        Buffer *b = bcache_find(dev, sector + off);
+        if (b != NULL && b->count != block && b->refs == 0) bcache_forget(b);
+    }
+    if (bcache_dev_write(dev, sector, count, in) != 0) return -EIO;
+
+    for (uint32_t off = 0; off < count; off += block) {
+        Buffer *b = bcache_find(dev, sector + off);
+        if (b == NULL || b->count != block) continue;
+        memcpy(b->data, in + (size_t)off * SECTOR_SIZE, (size_t)block * SECTOR_SIZE);
+        b->valid = 1;
+        if (b->dirty) {
+            b->dirty = 0;
+            dirty_count--;
+        }
+    }
+    return 0;
+}
+
+#define BCACHE_PREFETCH_RUN 64      /* Buffers filled by one request */
+
+/* Fill `n` new buffers for the uncached run of blocks at `sector` with
+ * one device request through a bounce buffer */
+static int bcache_prefetch_run(BlockDevice *dev, uint64_t sector, uint32_t n, uint32_t block) {
+    Buffer *run[BCACHE_PREFETCH_RUN];
+    uint32_t got = 0;
+    while (got < n) {
+        Buffer *b = bcache_alloc();
+        if (b == NULL || bcache_resize(b, block) != 0) break;
+        b->dev = dev;
+        b->sector = sector + (uint64_t)got * block;
+        b->refs = 1;            /* Keeps the run's own buffers from being recycled */
+        bcache_hash_insert(b);
+        run[got++] = b;
+    }
+
+    uint8_t *bounce = (got > 0) ? kmalloc((size_t)got * block * SECTOR_SIZE, 0) : NULL;
+    int ok = bounce != NULL && dev->read(dev, sector, got * block, bounce) == 0;
+    for (uint32_t i = 0; i < got; i++) {
+        run[i]->refs = 0;
+        if (ok) {
+            memcpy(run[i]->data, bounce + (size_t)i * block * SECTOR_SIZE,
+                   (size_t)block * SECTOR_SIZE);
+            run[i]->valid = 1;
+        } else {
+            bcache_forget(run[i]);
+        }
+    }
+    kfree(bounce);
+    return ok ? (int)got : -EIO;
+}
+
+int bcache_prefetch(BlockDevice *dev, uint64_t sector, uint32_t count, uint32_t block) {
+    if (dev == NULL || block == 0 || block > BCACHE_IO_MAX_SECTORS) return 0;
+    uint32_t max_run = BCACHE_IO_MAX_SECTORS / block;
+    if (max_run > BCACHE_PREFETCH_RUN) max_run = BCACHE_PREFETCH_RUN;
+    int filled = 0;
+    uint32_t off = 0;
+    while (off + block <= count) {
+        /* Cached blocks, whatever their state, are left alone */
+        if (bcache_find(dev, sector + off) != NULL) {
+            off += block;
+            continue;
+        }
+        uint32_t n = 1;
+        while (n < max_run && off + (n + 1) * block <= count &&
+               bcache_find(dev, sector + off + n * block) == NULL) {
+            n++;
+        }
+        int got = bcache_prefetch_run(dev, sector + off, n, block);
+        if (got <= 0) break;
+        filled += got;
+        if ((uint32_t)got < n) break;
+        off += n * block;
+    }
+    return filled;
+}
+
+int bcache_flush(BlockDevice *dev) {
+    int rc = 0;
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        Buffer *b = buffers[i];
+        if (b->dev == NULL || !b->dirty) continue;
+        if (dev != NULL && b->dev != dev) continue;
+        if (bcache_writeback(b) != 0) rc = -EIO;
+    }
+    return rc;
+}
+
+int bcache_flush_aged(uint64_t now_ms, uint64_t age_ms) {
+    int written = 0, rc = 0;
+    for (uint32_t i = 0; i < buffer_count && dirty_count > 0; i++) {
+        Buffer *b = buffers[i];
+        if (b->dev == NULL || !b->dirty) continue;
+        if (now_ms - b->dirtied_ms < age_ms) continue;
+        if (bcache_writeback(b) != 0) {
+            rc = -EIO;
+            continue;
+        }
+        written++;
+    }
+    return rc != 0 ? rc : written;
+}
+
+void bcache_invalidate(BlockDevice *dev) {
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        Buffer *b = buffers[i];
+        if (b->dev == dev && dev != NULL && b->refs == 0) bcache_forget(b);
+    }
+}
+
+void bcache_get_stats(const BlockDevice *dev, BcacheStats *out) {
+    out->hits = out->misses = out->writebacks = 0;
+    for (int i = 0; i < BLKDEV_MAX; i++) {
+        if (dev_stats[i].dev == dev && dev != NULL) {
+            *out = dev_stats[i].stats;
+            return;
+        }
+    }
+}
+
+void bcache_get_usage(uint32_t *count, uint64_t *bytes, uint32_t *dirty) {
+    *count = buffer_count;
+    *bytes = 0;
+    *dirty = dirty_count;
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        if (buffers[i]->data != NULL) *bytes += (uint64_t)buffers[i]->count * SECTOR_SIZE;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef ARCHOS_FS_BCACHE_H
+#define ARCHOS_FS_BCACHE_H
+
+#include <stdint.h>
+#include "drivers/blkdev.h"
+
+/* Block buffer cache between filesystems and block devices.
+ *
+ * A buffer holds `count` sectors of one device starting at `sector` and is
+ * found by hashing (device, sector).  Filesystems read and modify blocks
+ * in place through buffers instead of going to the device each time:
+ * bcache_read returns a referenced buffer, the caller marks it dirty if
+ * it changed it and releases it when done.  Dirty buffers reach the disk
+ * on bcache_flush (fsync/sync), when the flusher thread finds them old
+ * enough (bcache_flush_aged), or when they are evicted.
+ *
+ * The cache grows up to BCACHE_MAX_BUFFERS while memory is plentiful;
+ * past that, or when free pages drop below BCACHE_MIN_FREE_PAGES, a CLOCK
+ * sweep recycles the least recently used unreferenced buffer.  Like the
+ * filesystems above it, the cache relies on its callers being serialised
+ * (syscalls run with interrupts off). */
+
+#define BCACHE_MAX_BUFFERS     256
+#define BCACHE_HASH_SIZE       128
+#define BCACHE_MIN_FREE_PAGES  256     /* 1 MiB */
+#define BCACHE_DIRTY_HIGH      (BCACHE_MAX_BUFFERS / 2)  /* Flush all past this */
+#define BCACHE_IO_MAX_SECTORS  256     /* Largest direct request: 128 KiB */
+
+typedef struct Buffer {
+    BlockDevice   *dev;
+    uint64_t       sector;      /* First sector */
+    uint32_t       count;       /* Sectors held */
+    uint32_t       refs;        /* Callers holding it; never evicted if > 0 */
+    uint8_t        valid;       /* data matches the disk or newer */
+    uint8_t        dirty;       /* data is newer than the disk */
+    uint8_t        referenced;  /* CLOCK bit, set on every lookup */
+    uint8_t       *data;
+    uint64_t       dirtied_ms;  /* Uptime when it last went from clean to dirty */
+    struct Buffer *hash_next;
+} Buffer;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;        /* Dirty buffers written to the device */
+} BcacheStats;
+
+/* Return the buffer for `count` sectors of dev at `sector`, read from the
+ * device if not cached. Returns NULL on I/O error or out of memory. */
+Buffer *bcache_read(BlockDevice *dev, uint64_t sector, uint32_t count);
+
+/* Like bcache_read, but does not read a missing block from the device:
+ * for callers about to overwrite all of it. */
+Buffer *bcache_get(BlockDevice *dev, uint64_t sector, uint32_t count);
+
+/* The buffer's contents changed; write them back later. */
+void bcache_mark_dirty(Buffer *b);
+
+/* Drop a reference taken by bcache_read or bcache_get. */
+void bcache_release(Buffer *b);
+
+/* Direct transfers for large sequential I/O: move `count` sectors at
+ * `sector`, made of blocks of `block` sectors, between the device and buf
+ * in as few requests as possible (each at most BCACHE_IO_MAX_SECTORS)
+ * without passing through or filling the cache.  Cached blocks in the
+ * range stay coherent: a read takes them from the cache, a write updates
+ * them and leaves them clean.  Return 0 or -EIO. */
+int bcache_read_direct(BlockDevice *dev, uint64_t sector, uint32_t count,
+                       uint32_t block, void *buf);
+int bcache_write_direct(BlockDevice *dev, uint64_t sector, uint32_t count,
+                        uint32_t block, const void *buf);
+
+/* Readahead: bring the blocks of `block` sectors making up `count`
+ * sectors at `sector` into the cache, reading the missing ones in as few
+ * requests as possible.  Best effort: stops at the first read error or
+ * when no buffer is free.  Returns the number of blocks read. */
+int bcache_prefetch(BlockDevice *dev, uint64_t sector, uint32_t count, uint32_t block);
+
+/* Write back every dirty buffer of dev (NULL for all devices).
+ * Returns 0, or -EIO if any write failed (those stay dirty). */
+int bcache_flush(BlockDevice *dev);
+
+/* Write back the buffers that have been dirty for at least age_ms.
+ * Returns how many were written, or -EIO if any write failed. */
+int bcache_flush_aged(uint64_t now_ms, uint64_t age_ms);
+
+/* Forget every cached block of dev without writing it back, e.g. before
+ * mounting. Buffers still referenced are left alone. */
+void bcache_invalidate(BlockDevice *dev);
+
+/* Snapshot dev's hit, miss and write-back counts. */
+void bcache_get_stats(const BlockDevice *dev, BcacheStats *out);
+
+/* Buffers allocated, bytes they hold and how many are dirty. */
+void bcache_get_usage(uint32_t *count, uint64_t *bytes, uint32_t *dirty);
+
+#endif /* ARCHOS_FS_BCACHE_H */
@@ -0,0 +1,160 @@
+/* arc_os — Directory entry cache */
+
+#include "fs/dcache.h"
+#include "lib/mem.h"
+#include "lib/string.h"
+#include "proc/spinlock.h"
+
+typedef struct DcacheEntry {
+    VfsNode            *dir;        /* NULL: entry unused */
+    VfsNode            *node;       /* NULL: negative entry */
+    struct DcacheEntry *hash_next;
+    struct DcacheEntry *lru_prev;   /* Towards most recently used */
+    struct DcacheEntry *lru_next;
+    char                name[DCACHE_NAME_MAX + 1];
+} DcacheEntry;
+
+static DcacheEntry entries[DCACHE_SIZE];
+static DcacheEntry *hash_table[DCACHE_HASH_SIZE];
+static DcacheEntry *lru_head;       /* Most recently used */
+static DcacheEntry *lru_tail;       /* Next to recycle */
+static uint32_t generation;
+static DcacheStats stats;
+static Spinlock dcache_lock = SPINLOCK_INIT;
+
+/* --- Hash table and LRU list --- */
+
+static uint32_t dcache_hash(const VfsNode *dir, const char *name) {
+    uint32_t h = (uint32_t)((uintptr_t)dir >> 4) * 0x9E3779B1u;
+    while (*name) h = (h ^ (uint8_t)*name++) * 16777619u;   /* FNV-1a */
+    return h % DCACHE_HASH_SIZE;
+}
+
+static void lru_remove(DcacheEntry *e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else lru_tail = e->lru_prev;
+}
+
+static void lru_push_front(DcacheEntry *e) {
+    e->lru_prev = NULL;
+    e->lru_next = lru_head;
+    if (lru_head) lru_head->lru_prev = e;
+    lru_head = e;
+    if (lru_tail == NULL) lru_tail = e;
+}
+
+static void lru_push_back(DcacheEntry *e) {
+    e->lru_next = NULL;
+    e->lru_prev = lru_tail;
+    if (lru_tail) lru_tail->lru_next = e;
+    lru_tail = e;
+    if (lru_head == NULL) lru_head = e;
+}
+
+/* Unhash e and queue it to be recycled first */
+static void dcache_forget(DcacheEntry *e) {
+    DcacheEntry **link = &hash_table[dcache_hash(e->dir, e->name)];
+    while (*link != NULL && *link != e) link = &(*link)->hash_next;
+    if (*link == e) *link = e->hash_next;
+    e->hash_next = NULL;
+    e->dir = NULL;
+    e->node = NULL;
+    lru_remove(e);
+    lru_push_back(e);
+}
+
+static DcacheEntry *dcache_find(const VfsNode *dir, const char *name) {
+    for (DcacheEntry *e = hash_table[dcache_hash(dir, name)]; e != NULL; e = e->hash_next) {
+        if (e->dir == dir && strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+/* --- Public API --- */
+
+void dcache_init(void) {
+    spinlock_acquire(&dcache_lock);
+    memset(entries, 0, sizeof(entries));
+    memset(hash_table, 0, sizeof(hash_table));
+    lru_head = lru_tail = NULL;
+    for (int i = 0; i < DCACHE_SIZE; i++) lru_push_back(&entries[i]);
+    generation++;
+    spinlock_release(&dcache_lock);
+}
+
+int dcache_lookup(VfsNode *dir, const char *name, VfsNode **out) {
+    if (strlen(name) > DCACHE_NAME_MAX) return 0;
+    spinlock_acquire(&dcache_lock);
+    DcacheEntry *e = dcache_find(dir, name);
+    if (e == NULL) {
+        stats.misses++;
+        spinlock_release(&dcache_lock);
+        return 0;
+    }
+    lru_remove(e);
+    lru_push_front(e);
+    *out = e->node;
+    stats.hits++;
+    if (e->node == NULL) stats.negative_hits++;
+    spinlock_release(&dcache_lock);
+    return 1;
+}
+
+uint32_t dcache_generation(void) {
+    return __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+}
+
+void dcache_insert(VfsNode *dir, const char *name, VfsNode *node, uint32_t gen) {
+    size_t len = strlen(name);
+    if (len > DCACHE_NAME_MAX) return;
+    spinlock_acquire(&dcache_lock);
+    if (gen != generation || lru_tail == NULL) {
+        spinlock_release(&dcache_lock);
+        return;
+    }
+
+    DcacheEntry *e = dcache_find(dir, name);
+    if (e == NULL) {
+        e = lru_tail;
+        if (e->dir != NULL) {
+            stats.evictions++;
+            dcache_forget(e);
+        }
+        e->dir = dir;
+        memcpy(e->name, name, len + 1);
+        uint32_t h = dcache_hash(dir, name);
+        e->hash_next = hash_table[h];
+        hash_table[h] = e;
+    }
+    e->node = node;
+    lru_remove(e);
+    lru_push_front(e);
+    spinlock_release(&dcache_lock);
+}
+
+void dcache_invalidate_dir(VfsNode *dir) {
+    spinlock_acquire(&dcache_lock);
+    generation++;
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        if (entries[i].dir == dir && dir != NULL) dcache_forget(&entries[i]);
+    }
+    spinlock_release(&dcache_lock);
+}
+
+void dcache_invalidate_node(VfsNode *node) {
+    spinlock_acquire(&dcache_lock);
+    generation++;
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        if (entries[i].dir == NULL) continue;
+        if (entries[i].dir == node || entries[i].node == node) dcache_forget(&entries[i]);
+    }
+    spinlock_release(&dcache_lock);
+}
+
+void dcache_get_stats(DcacheStats *out) {
+    spinlock_acquire(&dcache_lock);
+    *out = stats;
+    spinlock_release(&dcache_lock);
+}
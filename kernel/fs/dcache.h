@@ -0,0 +1,58 @@
+#ifndef ARCHOS_FS_DCACHE_H
+#define ARCHOS_FS_DCACHE_H
+
+#include <stdint.h>
+#include "fs/vfs.h"
+
+/* Directory entry cache for path resolution.
+ *
+ * Remembers the result of looking up a name in a directory, keyed by
+ * (directory node, name): the child node, or NULL for a name that does not
+ * exist (a negative entry), so repeated stats and PATH searches for missing
+ * commands do not reach the filesystem.  Only directories flagged
+ * VFS_NODE_DCACHE are cached, i.e. those whose children appear and
+ * disappear only through the VFS.
+ *
+ * The VFS drops a directory's entries whenever a name is created or
+ * removed in it (and the entries under a removed directory), rather than
+ * patching single names, since filesystems such as FAT32 match names case-
+ * insensitively.  A fixed pool of DCACHE_SIZE entries is recycled least
+ * recently used first; names longer than DCACHE_NAME_MAX are not cached. */
+
+#define DCACHE_SIZE       256
+#define DCACHE_HASH_SIZE  128
+#define DCACHE_NAME_MAX   39
+
+typedef struct {
+    uint64_t hits;              /* Lookups answered from the cache */
+    uint64_t negative_hits;     /* ... of which for missing names */
+    uint64_t misses;
+    uint64_t evictions;         /* Entries recycled while still valid */
+} DcacheStats;
+
+/* Forget every entry (new root filesystem). */
+void dcache_init(void);
+
+/* Look up name in dir. Returns 1 on a hit with *out set (NULL for a
+ * negative entry), 0 if the cache has no answer. */
+int dcache_lookup(VfsNode *dir, const char *name, VfsNode **out);
+
+/* Snapshot taken before asking the filesystem; see dcache_insert. */
+uint32_t dcache_generation(void);
+
+/* Remember that name in dir resolves to node (NULL: does not exist).
+ * Dropped if anything was invalidated since gen was taken, because the
+ * filesystem's answer may already be stale. */
+void dcache_insert(VfsNode *dir, const char *name, VfsNode *node, uint32_t gen);
+
+/* Forget every entry in dir. */
+void dcache_invalidate_dir(VfsNode *dir);
+
+/* Forget every entry in or resolving to node, which its filesystem is
+ * about to free. */
+void dcache_invalidate_node(VfsNode *node);
+
+/* Snapshot the cache counters. */
+void dcache_get_stats(DcacheStats *out);
+
+#endif /* ARCHOS_FS_DCACHE_H */
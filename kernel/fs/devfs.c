@@ -74,21 +74,20 @@ static const VfsOps devfs_tty_ops = {
 
 /* --- /dev directory ops --- */
 
+/* Devices first, then filesystems attached under /dev (e.g. /dev/shm) */
+#define DEV_MAX_ENTRIES 8
+
 static struct {
     const char *name;
-    DevfsNode  *node;
-} dev_entries[] = {
-    { "null", &dev_null_node },
-    { "zero", &dev_zero_node },
-    { "tty",  &dev_tty_node },
-};
-#define DEV_ENTRY_COUNT 3
+    VfsNode    *node;
+} dev_entries[DEV_MAX_ENTRIES];
+static int dev_entry_count;
 
 static VfsNode *devfs_dir_lookup(VfsNode *dir, const char *name) {
     (void)dir;
-    for (int i = 0; i < DEV_ENTRY_COUNT; i++) {
+    for (int i = 0; i < dev_entry_count; i++) {
         if (strcmp(name, dev_entries[i].name) == 0) {
-            return &dev_entries[i].node->vnode;
+            return dev_entries[i].node;
         }
     }
     return NULL;
@@ -96,12 +95,12 @@ static VfsNode *devfs_dir_lookup(VfsNode *dir, const char *name) {
 
 static int devfs_dir_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
     (void)dir;
-    uint32_t count = DEV_ENTRY_COUNT < max ? DEV_ENTRY_COUNT : max;
+    uint32_t count = (uint32_t)dev_entry_count < max ? (uint32_t)dev_entry_count : max;
     for (uint32_t i = 0; i < count; i++) {
         strncpy(entries[i].name, dev_entries[i].name, VFS_NAME_MAX - 1);
         entries[i].name[VFS_NAME_MAX - 1] = '\0';
-        entries[i].inode_num = dev_entries[i].node->vnode.inode_num;
-        entries[i].type = dev_entries[i].node->vnode.type;
+        entries[i].inode_num = dev_entries[i].node->inode_num;
+        entries[i].type = dev_entries[i].node->type;
     }
     return (int)count;
 }
@@ -124,10 +123,24 @@ static void devfs_init_node(DevfsNode *dn, uint64_t ino, uint8_t type,
     dn->dev_type = dev_type;
 }
 
+int devfs_attach(const char *name, VfsNode *node) {
+    if (node == NULL) return -EINVAL;
+    if (dev_entry_count >= DEV_MAX_ENTRIES) return -ENOMEM;
+    dev_entries[dev_entry_count].name = name;
+    dev_entries[dev_entry_count].node = node;
+    dev_entry_count++;
+    return VFS_OK;
+}
+
 VfsNode *devfs_init(void) {
     devfs_init_node(&dev_root_node, 1000, VFS_DIRECTORY, 0755, &devfs_dir_ops, 0);
     devfs_init_node(&dev_null_node, 1001, VFS_FILE, 0666, &devfs_null_ops, DEV_NULL);
     devfs_init_node(&dev_zero_node, 1002, VFS_FILE, 0666, &devfs_zero_ops, DEV_ZERO);
     devfs_init_node(&dev_tty_node,  1003, VFS_FILE, 0666, &devfs_tty_ops,  DEV_TTY);
+
+    dev_entry_count = 0;
+    devfs_attach("null", &dev_null_node.vnode);
+    devfs_attach("zero", &dev_zero_node.vnode);
+    devfs_attach("tty",  &dev_tty_node.vnode);
     return &dev_root_node.vnode;
 }
@@ -7,4 +7,8 @@
  * All nodes are statically allocated — no kmalloc needed. */
 VfsNode *devfs_init(void);
 
+/* Add node (typically another filesystem's root directory) as /dev/<name>.
+ * name must stay valid. Returns 0, -EINVAL or -ENOMEM (table full). */
+int devfs_attach(const char *name, VfsNode *node);
+
 #endif /* ARCHOS_FS_DEVFS_H */
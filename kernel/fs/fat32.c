@@ -1,5 +1,7 @@
 #include "fs/fat32.h"
 #include "drivers/blkdev.h"
+#include "fs/bcache.h"
+#include "fs/dcache.h"
 #include "mm/kmalloc.h"
 #include "lib/mem.h"
 #include "lib/string.h"
@@ -8,32 +10,6 @@
 #define SECTOR_SIZE 512
 #define CASE_OFFSET ('a' - 'A')
 
-/* --- Node cache: avoids duplicate VfsNodes for the same cluster --- */
-
-#define NODE_CACHE_SIZE 256
-
-static struct {
-    uint32_t cluster;
-    VfsNode *node;
-} node_cache[NODE_CACHE_SIZE];
-static int node_cache_count;
-
-static VfsNode *cache_lookup(uint32_t cluster) {
-    for (int i = 0; i < node_cache_count; i++) {
-        if (node_cache[i].cluster == cluster)
-            return node_cache[i].node;
-    }
-    return NULL;
-}
-
-static void cache_insert(uint32_t cluster, VfsNode *node) {
-    if (node_cache_count < NODE_CACHE_SIZE) {
-        node_cache[node_cache_count].cluster = cluster;
-        node_cache[node_cache_count].node = node;
-        node_cache_count++;
-    }
-}
-
 /* --- Forward declarations for VfsOps --- */
 
 static int fat32_read(VfsNode *node, void *buf, uint32_t offset, uint32_t size);
@@ -43,11 +19,17 @@ static VfsNode *fat32_create(VfsNode *dir, const char *name, uint8_t type);
 static int fat32_unlink(VfsNode *dir, const char *name);
 static int fat32_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max);
 static void fat32_truncate(VfsNode *node, uint64_t size);
+static int fat32_fsync(VfsNode *node);
+static void fat32_readahead(VfsNode *node, uint64_t offset, uint32_t size);
 
 static const VfsOps fat32_file_ops = {
     .read     = fat32_read,
     .write    = fat32_write,
     .truncate = fat32_truncate,
+    .sync     = fat32_fsync,
+    .readahead = fat32_readahead,
+    .ref      = fat32_node_get,
+    .unref    = fat32_node_put,
 };
 
 static const VfsOps fat32_dir_ops = {
@@ -56,9 +38,370 @@ static const VfsOps fat32_dir_ops = {
     .create  = fat32_create,
     .unlink  = fat32_unlink,
     .readdir = fat32_readdir,
+    .sync    = fat32_fsync,
+    .ref     = fat32_node_get,
+    .unref   = fat32_node_put,
 };
 
-static uint64_t next_fat_inode = 0x10000;  /* Start high to avoid collision with ramfs */
+/* --- Node cache (see FAT32_NODE_CACHE) --- */
+
+static Fat32Volume *fat32_volumes;      /* Mounted, newest first */
+
+static void fat32_extents_drop(Fat32NodeInfo *info);
+static void fat32_prealloc_drop(Fat32NodeInfo *info);
+static void fat32_dir_index_drop(Fat32NodeInfo *dir);
+static void fat32_free_chain(Fat32Volume *vol, uint32_t cluster);
+static void fat32_sync_later(Fat32Volume *vol);
+
+static uint32_t node_hash(uint32_t entry_cluster, uint32_t entry_idx) {
+    return ((entry_cluster * 0x9E3779B1u) ^ entry_idx) % FAT32_NODE_HASH;
+}
+
+static void lru_remove(Fat32Volume *vol, Fat32NodeInfo *info) {
+    if (info->lru_prev) info->lru_prev->lru_next = info->lru_next;
+    else vol->lru_head = info->lru_next;
+    if (info->lru_next) info->lru_next->lru_prev = info->lru_prev;
+    else vol->lru_tail = info->lru_prev;
+    info->lru_prev = info->lru_next = NULL;
+}
+
+static void lru_push_front(Fat32Volume *vol, Fat32NodeInfo *info) {
+    info->lru_prev = NULL;
+    info->lru_next = vol->lru_head;
+    if (vol->lru_head) vol->lru_head->lru_prev = info;
+    vol->lru_head = info;
+    if (vol->lru_tail == NULL) vol->lru_tail = info;
+}
+
+static Fat32NodeInfo *cache_lookup(Fat32Volume *vol, uint32_t entry_cluster, uint32_t entry_idx) {
+    Fat32NodeInfo *info = vol->node_hash[node_hash(entry_cluster, entry_idx)];
+    while (info != NULL &&
+           (info->dir_entry_cluster != entry_cluster || info->dir_entry_idx != entry_idx)) {
+        info = info->hash_next;
+    }
+    return info;
+}
+
+/* Mark a node most recently used */
+static void cache_touch(Fat32NodeInfo *info) {
+    if (info->cached && info->refs == 0) {
+        lru_remove(info->vol, info);
+        lru_push_front(info->vol, info);
+    }
+}
+
+static void node_free(Fat32NodeInfo *info) {
+    dcache_invalidate_node(info->node);
+    fat32_extents_drop(info);
+    fat32_prealloc_drop(info);
+    if (info->orphan && info->first_cluster != 0) {
+        fat32_free_chain(info->vol, info->first_cluster);
+        fat32_sync_later(info->vol);
+    }
+    fat32_dir_index_drop(info);
+    kfree(info->node);
+    kfree(info);
+}
+
+/* Take a node out of the hash: its entry is gone, or it is being evicted.
+ * Freed now unless an open file still holds it. */
+static void cache_remove(Fat32NodeInfo *info) {
+    Fat32Volume *vol = info->vol;
+    if (!info->cached) return;
+    Fat32NodeInfo **link = &vol->node_hash[node_hash(info->dir_entry_cluster, info->dir_entry_idx)];
+    while (*link != info) link = &(*link)->hash_next;
+    *link = info->hash_next;
+    info->hash_next = NULL;
+    info->cached = 0;
+    vol->node_count--;
+    if (info->refs == 0) {
+        lru_remove(vol, info);
+        node_free(info);
+    }
+}
+
+/* Make room for one more node by freeing the least recently used
+ * unreferenced ones */
+static void cache_insert(Fat32NodeInfo *info) {
+    Fat32Volume *vol = info->vol;
+    while (vol->node_count >= FAT32_NODE_CACHE && vol->lru_tail != NULL) {
+        cache_remove(vol->lru_tail);
+    }
+    uint32_t h = node_hash(info->dir_entry_cluster, info->dir_entry_idx);
+    info->hash_next = vol->node_hash[h];
+    vol->node_hash[h] = info;
+    info->cached = 1;
+    vol->node_count++;
+    lru_push_front(vol, info);
+}
+
+void fat32_node_get(VfsNode *node) {
+    Fat32NodeInfo *info = (Fat32NodeInfo *)node->private_data;
+    if (info->refs++ == 0 && info->cached) lru_remove(info->vol, info);
+}
+
+void fat32_node_put(VfsNode *node) {
+    Fat32NodeInfo *info = (Fat32NodeInfo *)node->private_data;
+    if (info->refs == 0 || --info->refs > 0) return;
+    if (info->cached) lru_push_front(info->vol, info);
+    else node_free(info);
+}
+
+/* Inode numbers come from where a node's directory entry lives on disk,
+ * so a node evicted from the cache comes back with the same one and
+ * readdir can report it without a lookup. Data clusters start at 2, which
+ * keeps them clear of ramfs numbers; the root has no entry and takes the
+ * reserved cluster 1. */
+#define FAT32_ROOT_INO  (1ULL << 16)
+
+static uint64_t fat32_inode_num(const Fat32Volume *vol, uint32_t entry_cluster, uint32_t entry_idx) {
+    if (entry_cluster == 0) return FAT32_ROOT_INO;
+    uint32_t epc = vol->bytes_per_cluster / sizeof(Fat32DirEntry);
+    return ((uint64_t)entry_cluster << 16) | (entry_idx % epc);
+}
+
+/* Schedule a deferred FAT write-back; repeated calls before it runs coalesce. */
+static void fat32_sync_later(Fat32Volume *vol) {
+    queue_delayed_work(&vol->sync_work, FAT32_SYNC_DELAY_MS);
+}
+
+/* --- Free-cluster map --- */
+
+static int fat32_map_used(const Fat32Volume *vol, uint32_t cluster) {
+    return (vol->free_map[cluster / 8] >> (cluster % 8)) & 1;
+}
+
+static void fat32_map_mark(Fat32Volume *vol, uint32_t cluster, int used) {
+    if (used) vol->free_map[cluster / 8] |= (uint8_t)(1u << (cluster % 8));
+    else vol->free_map[cluster / 8] &= (uint8_t)~(1u << (cluster % 8));
+}
+
+/* A FAT entry went from used to free or back */
+static void fat32_note_free(Fat32Volume *vol, uint32_t cluster, int freed) {
+    if (vol->free_map != NULL) fat32_map_mark(vol, cluster, !freed);
+    if (vol->free_count != FAT32_FREE_UNKNOWN) {
+        vol->free_count = freed ? vol->free_count + 1 : vol->free_count - 1;
+    }
+    vol->fsinfo_dirty = 1;
+}
+
+/* Build the map from the FAT, read in requests of BCACHE_IO_MAX_SECTORS;
+ * cached FAT pages may be newer than the disk and go on top.  Counts the
+ * free clusters exactly on the way. */
+static int fat32_free_map_build(Fat32Volume *vol) {
+    if (vol->free_map != NULL) return 0;
+    uint32_t end = vol->total_clusters + 2;
+    uint32_t bytes = (end + 7) / 8;
+    uint32_t per_sector = SECTOR_SIZE / sizeof(uint32_t);
+    uint32_t sectors = (end + per_sector - 1) / per_sector;
+    if (sectors > vol->fat_sectors) sectors = vol->fat_sectors;
+
+    uint8_t *map = kmalloc(bytes, GFP_ZERO);
+    uint32_t *chunk = kmalloc(BCACHE_IO_MAX_SECTORS * SECTOR_SIZE, 0);
+    if (map == NULL || chunk == NULL) {
+        kfree(map);
+        kfree(chunk);
+        return -ENOMEM;
+    }
+    vol->free_map = map;
+
+    for (uint32_t s = 0; s < sectors; s += BCACHE_IO_MAX_SECTORS) {
+        uint32_t n = sectors - s;
+        if (n > BCACHE_IO_MAX_SECTORS) n = BCACHE_IO_MAX_SECTORS;
+        if (vol->dev->read(vol->dev, vol->fat_start + s, n, chunk) != 0) {
+            kprintf("[FAT32] Failed to read FAT sectors %u-%u\n", s, s + n - 1);
+            kfree(chunk);
+            kfree(map);
+            vol->free_map = NULL;
+            return -EIO;
+        }
+        uint32_t base = s * per_sector;
+        for (uint32_t i = 0; i < n * per_sector && base + i < end; i++) {
+            if ((chunk[i] & FAT32_ENTRY_MASK) != FAT32_FREE) fat32_map_mark(vol, base + i, 1);
+        }
+    }
+    kfree(chunk);
+
+    for (int i = 0; i < FAT32_FAT_PAGES; i++) {
+        const Fat32FatPage *p = &vol->fat_pages[i];
+        if (!p->valid) continue;
+        uint32_t base = p->page * FAT32_FAT_PAGE_ENTRIES;
+        for (uint32_t e = 0; e < FAT32_FAT_PAGE_ENTRIES && base + e < end; e++) {
+            fat32_map_mark(vol, base + e, (p->entries[e] & FAT32_ENTRY_MASK) != FAT32_FREE);
+        }
+    }
+
+    /* Reserved clusters 0 and 1, anything the FAT does not cover and the
+     * padding bits are never handed out */
+    fat32_map_mark(vol, 0, 1);
+    fat32_map_mark(vol, 1, 1);
+    for (uint32_t c = sectors * per_sector; c < bytes * 8; c++) fat32_map_mark(vol, c, 1);
+
+    uint32_t free = 0;
+    for (uint32_t c = 2; c < end; c++) {
+        if (!fat32_map_used(vol, c)) free++;
+    }
+    if (free != vol->free_count) {
+        vol->free_count = free;
+        vol->fsinfo_dirty = 1;
+    }
+    return 0;
+}
+
+/* First cluster in [from, to) the map shows free, or 0 */
+static uint32_t fat32_map_next_free(const Fat32Volume *vol, uint32_t from, uint32_t to) {
+    uint32_t c = from;
+    while (c < to) {
+        if (c % 8 == 0 && vol->free_map[c / 8] == 0xFF) {
+            c += 8;
+            continue;
+        }
+        if (!fat32_map_used(vol, c)) return c;
+        c++;
+    }
+    return 0;
+}
+
+/* Free clusters in a row from `cluster`, at most max */
+static uint32_t fat32_map_run(const Fat32Volume *vol, uint32_t cluster, uint32_t max) {
+    uint32_t end = vol->total_clusters + 2;
+    uint32_t n = 0;
+    while (n < max && cluster + n < end && !fat32_map_used(vol, cluster + n)) n++;
+    return n;
+}
+
+/* Search from the next-free hint, wrapping once, for the first run of at
+ * least `want` free clusters, else settle for the first free one.  *len
+ * gets the run's length, at most max. Returns 0 if the map shows none. */
+static uint32_t fat32_map_find(const Fat32Volume *vol, uint32_t want, uint32_t max,
+                               uint32_t *len) {
+    uint32_t end = vol->total_clusters + 2;
+    uint32_t hint = (vol->next_free >= 2 && vol->next_free < end) ? vol->next_free : 2;
+    uint32_t first = 0, first_len = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t c = pass == 0 ? hint : 2;
+        uint32_t to = pass == 0 ? end : hint;
+        while ((c = fat32_map_next_free(vol, c, to)) != 0) {
+            uint32_t n = fat32_map_run(vol, c, max);
+            if (n >= want) {
+                *len = n;
+                return c;
+            }
+            if (first == 0) {
+                first = c;
+                first_len = n;
+            }
+            c += n;
+        }
+    }
+    *len = first_len;
+    return first;
+}
+
+/* --- Paged FAT --- */
+
+/* Sectors in a page: the last one may be short */
+static uint32_t fat32_fat_page_sectors(Fat32Volume *vol, uint32_t page) {
+    uint32_t left = vol->fat_sectors - page * FAT32_FAT_PAGE_SECTORS;
+    return left < FAT32_FAT_PAGE_SECTORS ? left : FAT32_FAT_PAGE_SECTORS;
+}
+
+/* Write a page's dirty sectors to every FAT copy, a request per run.
+ * Callers flush the data clusters first. */
+static int fat32_fat_writeback(Fat32Volume *vol, Fat32FatPage *p) {
+    uint32_t n = fat32_fat_page_sectors(vol, p->page);
+    uint32_t first = p->page * FAT32_FAT_PAGE_SECTORS;
+    uint32_t s = 0;
+    while (s < n) {
+        if (!(p->dirty & (1u << s))) {
+            s++;
+            continue;
+        }
+        uint32_t run = 1;
+        while (s + run < n && (p->dirty & (1u << (s + run)))) run++;
+        for (uint32_t copy = 0; copy < vol->num_fats; copy++) {
+            uint64_t sector = vol->fat_start + (uint64_t)copy * vol->fat_sectors + first + s;
+            if (vol->dev->write(vol->dev, sector, run,
+                                (uint8_t *)p->entries + s * SECTOR_SIZE) != 0) {
+                kprintf("[FAT32] Failed to sync FAT sector %u\n", first + s);
+                return -EIO;
+            }
+        }
+        s += run;
+    }
+    p->dirty = 0;
+    vol->fat_dirty--;
+    return 0;
+}
+
+/* The cached page holding FAT page `page`, read in one request on a
+ * miss. A dirty victim is written back, after the clusters it links. */
+static Fat32FatPage *fat32_fat_page(Fat32Volume *vol, uint32_t page) {
+    Fat32FatPage *p = &vol->fat_pages[vol->fat_last];
+    if (p->valid && p->page == page) {
+        p->referenced = 1;
+        return p;
+    }
+    for (uint32_t i = 0; i < FAT32_FAT_PAGES; i++) {
+        p = &vol->fat_pages[i];
+        if (p->valid && p->page == page) {
+            p->referenced = 1;
+            vol->fat_last = i;
+            return p;
+        }
+    }
+
+    /* CLOCK: free slots first, then one not used since the hand last passed */
+    uint32_t slot;
+    for (;;) {
+        slot = vol->fat_hand;
+        p = &vol->fat_pages[slot];
+        vol->fat_hand = (vol->fat_hand + 1) % FAT32_FAT_PAGES;
+        if (!p->valid || !p->referenced) break;
+        p->referenced = 0;
+    }
+    if (p->dirty) {
+        if (bcache_flush(vol->dev) != 0) return NULL;
+        if (fat32_fat_writeback(vol, p) != 0) return NULL;
+    }
+    if (p->entries == NULL) {
+        p->entries = kmalloc(FAT32_FAT_PAGE_SECTORS * SECTOR_SIZE, 0);
+        if (p->entries == NULL) return NULL;
+    }
+    p->valid = 0;
+    if (vol->dev->read(vol->dev, vol->fat_start + page * FAT32_FAT_PAGE_SECTORS,
+                       fat32_fat_page_sectors(vol, page), p->entries) != 0) {
+        kprintf("[FAT32] Failed to read FAT page %u\n", page);
+        return NULL;
+    }
+    p->page = page;
+    p->valid = 1;
+    p->referenced = 1;
+    vol->fat_last = slot;
+    return p;
+}
+
+/* A cluster's FAT entry; FAT32_BAD_CLUSTER if it cannot be read */
+static uint32_t fat32_fat_get(Fat32Volume *vol, uint32_t cluster) {
+    Fat32FatPage *p = fat32_fat_page(vol, cluster / FAT32_FAT_PAGE_ENTRIES);
+    if (p == NULL) return FAT32_BAD_CLUSTER;
+    return p->entries[cluster % FAT32_FAT_PAGE_ENTRIES] & FAT32_ENTRY_MASK;
+}
+
+/* Set a cluster's FAT entry, keeping its reserved top bits */
+static int fat32_fat_set(Fat32Volume *vol, uint32_t cluster, uint32_t value) {
+    Fat32FatPage *p = fat32_fat_page(vol, cluster / FAT32_FAT_PAGE_ENTRIES);
+    if (p == NULL) return -EIO;
+    uint32_t idx = cluster % FAT32_FAT_PAGE_ENTRIES;
+    uint32_t old = p->entries[idx] & FAT32_ENTRY_MASK;
+    p->entries[idx] = (p->entries[idx] & ~FAT32_ENTRY_MASK) | (value & FAT32_ENTRY_MASK);
+    if ((old == FAT32_FREE) != ((value & FAT32_ENTRY_MASK) == FAT32_FREE)) {
+        fat32_note_free(vol, cluster, old != FAT32_FREE);
+    }
+    if (p->dirty == 0) vol->fat_dirty++;
+    p->dirty |= 1u << (idx / (SECTOR_SIZE / sizeof(uint32_t)));
+    return 0;
+}
 
 /* --- Cluster helpers --- */
 
@@ -67,7 +410,7 @@ static uint32_t cluster_to_sector(Fat32Volume *vol, uint32_t cluster) {
 }
 
 static uint32_t fat32_next_cluster(Fat32Volume *vol, uint32_t cluster) {
-    uint32_t entry = vol->fat[cluster] & FAT32_ENTRY_MASK;
+    uint32_t entry = fat32_fat_get(vol, cluster);
     if (entry >= FAT32_EOC) return 0;  /* End of chain */
     if (entry == FAT32_BAD_CLUSTER) return 0;
     return entry;
@@ -82,48 +425,153 @@ static inline void fat32_set_entry_cluster(Fat32DirEntry *e, uint32_t cluster) {
     e->first_cluster_hi = (cluster >> 16) & 0xFFFF;
 }
 
-static int fat32_read_cluster(Fat32Volume *vol, uint32_t cluster, void *buf) {
+/* The cached buffer for a cluster, read from disk unless the caller is
+ * about to overwrite all of it. Release with bcache_release. */
+static Buffer *fat32_get_cluster(Fat32Volume *vol, uint32_t cluster, int fill) {
     uint32_t sector = cluster_to_sector(vol, cluster);
-    return vol->dev->read(vol->dev, sector, vol->sectors_per_cluster, buf);
+    if (fill) return bcache_read(vol->dev, sector, vol->sectors_per_cluster);
+    return bcache_get(vol->dev, sector, vol->sectors_per_cluster);
 }
 
-static int fat32_write_cluster(Fat32Volume *vol, uint32_t cluster, const void *buf) {
-    uint32_t sector = cluster_to_sector(vol, cluster);
-    return vol->dev->write(vol->dev, sector, vol->sectors_per_cluster, buf);
+/* --- FAT manipulation --- */
+
+/* Give back reserved clusters: they were never in the FAT */
+static void fat32_prealloc_release(Fat32Volume *vol, Fat32Prealloc *pa) {
+    for (uint32_t i = 0; i < pa->count; i++) fat32_map_mark(vol, pa->start + i, 0);
+    pa->owner = NULL;
+    pa->count = 0;
 }
 
-/* --- FAT manipulation --- */
+static Fat32Prealloc *fat32_prealloc_find(Fat32Volume *vol, const void *owner) {
+    for (int i = 0; i < FAT32_PREALLOC_SLOTS; i++) {
+        if (vol->prealloc[i].owner == owner) return &vol->prealloc[i];
+    }
+    return NULL;
+}
 
-static uint32_t fat32_alloc_cluster(Fat32Volume *vol) {
-    for (uint32_t i = 2; i < vol->total_clusters + 2; i++) {
-        if ((vol->fat[i] & FAT32_ENTRY_MASK) == FAT32_FREE) {
-            vol->fat[i] = (vol->fat[i] & ~FAT32_ENTRY_MASK) | (FAT32_EOC & FAT32_ENTRY_MASK);
-            vol->fat_dirty = 1;
-            return i;
+/* Reserve [start, start + count) for owner in a free slot, else in the
+ * next one round */
+static void fat32_prealloc_set(Fat32Volume *vol, const void *owner,
+                               uint32_t start, uint32_t count) {
+    Fat32Prealloc *pa = fat32_prealloc_find(vol, NULL);
+    if (pa == NULL) {
+        pa = &vol->prealloc[vol->prealloc_hand];
+        vol->prealloc_hand = (vol->prealloc_hand + 1) % FAT32_PREALLOC_SLOTS;
+        fat32_prealloc_release(vol, pa);
+    }
+    for (uint32_t i = 0; i < count; i++) fat32_map_mark(vol, start + i, 1);
+    pa->owner = owner;
+    pa->start = start;
+    pa->count = count;
+}
+
+/* Drop a file's reservation, e.g. when it is truncated or unlinked */
+static void fat32_prealloc_drop(Fat32NodeInfo *info) {
+    Fat32Prealloc *pa = fat32_prealloc_find(info->vol, info);
+    if (pa != NULL) fat32_prealloc_release(info->vol, pa);
+}
+
+/* fat32_map_find, taking back every reservation if that is the only way
+ * to find space */
+static uint32_t fat32_find_free(Fat32Volume *vol, uint32_t want, uint32_t max, uint32_t *len) {
+    uint32_t c = fat32_map_find(vol, want, max, len);
+    if (c != 0) return c;
+    for (int i = 0; i < FAT32_PREALLOC_SLOTS; i++) {
+        if (vol->prealloc[i].owner != NULL) fat32_prealloc_release(vol, &vol->prealloc[i]);
+    }
+    return fat32_map_find(vol, want, max, len);
+}
+
+/* Allocate one cluster as the end of a chain: `goal` if it is free (the
+ * one after the cluster being extended), else the first free one from
+ * the next-free hint on.  Returns 0 when the volume is full. */
+static uint32_t fat32_alloc_cluster(Fat32Volume *vol, uint32_t goal) {
+    uint32_t cluster = 0, len;
+    if (fat32_free_map_build(vol) == 0) {
+        if (goal >= 2 && goal < vol->total_clusters + 2 && !fat32_map_used(vol, goal)) {
+            cluster = goal;
+        } else {
+            cluster = fat32_find_free(vol, 1, 1, &len);
+        }
+    } else {
+        /* No memory for the map: scan the FAT itself */
+        for (uint32_t i = 2; i < vol->total_clusters + 2 && cluster == 0; i++) {
+            if (fat32_fat_get(vol, i) == FAT32_FREE) cluster = i;
         }
     }
-    return 0;  /* Disk full */
+    if (cluster == 0 || fat32_fat_set(vol, cluster, FAT32_EOC) != 0) return 0;
+    vol->next_free = cluster + 1;
+    return cluster;
 }
 
 static void fat32_free_chain(Fat32Volume *vol, uint32_t cluster) {
     while (cluster != 0 && cluster < vol->total_clusters + 2) {
         uint32_t next = fat32_next_cluster(vol, cluster);
-        vol->fat[cluster] = (vol->fat[cluster] & ~FAT32_ENTRY_MASK) | FAT32_FREE;
-        vol->fat_dirty = 1;
+        if (fat32_fat_set(vol, cluster, FAT32_FREE) != 0) return;
         cluster = next;
     }
 }
 
 static uint32_t fat32_extend_chain(Fat32Volume *vol, uint32_t last) {
-    uint32_t new_cluster = fat32_alloc_cluster(vol);
+    uint32_t new_cluster = fat32_alloc_cluster(vol, last != 0 ? last + 1 : 0);
     if (new_cluster == 0) return 0;
-    if (last != 0) {
-        vol->fat[last] = (vol->fat[last] & ~FAT32_ENTRY_MASK) | (new_cluster & FAT32_ENTRY_MASK);
-        vol->fat_dirty = 1;
+    if (last != 0 && fat32_fat_set(vol, last, new_cluster) != 0) {
+        fat32_fat_set(vol, new_cluster, FAT32_FREE);
+        return 0;
     }
     return new_cluster;
 }
 
+/* Allocate up to `want` clusters for a file whose chain ends at `last`
+ * (0 if it has none), contiguous with it when possible, and link them in.
+ * A file that already has clusters is being appended to, so up to
+ * FAT32_PREALLOC_CLUSTERS free ones past the run are reserved for its
+ * next write.  Returns how many were allocated, starting at *start; 0
+ * when the volume is full or the FAT cannot be updated. */
+static uint32_t fat32_alloc_run(Fat32NodeInfo *info, uint32_t last, uint32_t want,
+                                uint32_t *start) {
+    Fat32Volume *vol = info->vol;
+    if (fat32_free_map_build(vol) != 0) {
+        /* No map: a cluster at a time */
+        *start = last != 0 ? fat32_extend_chain(vol, last) : fat32_alloc_cluster(vol, 0);
+        return *start != 0;
+    }
+
+    uint32_t first, avail, n;
+    Fat32Prealloc *pa = fat32_prealloc_find(vol, info);
+    if (pa != NULL && last != 0 && pa->start == last + 1) {
+        /* Carry on into the reservation */
+        first = pa->start;
+        n = want < pa->count ? want : pa->count;
+        pa->start += n;
+        pa->count -= n;
+        if (pa->count == 0) pa->owner = NULL;
+    } else {
+        if (pa != NULL) fat32_prealloc_release(vol, pa);
+        uint32_t max = want + (last != 0 ? FAT32_PREALLOC_CLUSTERS : 0);
+        avail = last != 0 ? fat32_map_run(vol, last + 1, max) : 0;
+        if (avail > 0) first = last + 1;
+        else first = fat32_find_free(vol, want, max, &avail);
+        if (first == 0) return 0;
+        n = want < avail ? want : avail;
+        if (avail > n) fat32_prealloc_set(vol, info, first + n, avail - n);
+    }
+
+    uint32_t linked = 0;
+    while (linked < n) {
+        uint32_t next = linked + 1 < n ? first + linked + 1 : FAT32_EOC;
+        if (fat32_fat_set(vol, first + linked, next) != 0) break;
+        linked++;
+    }
+    if (linked < n || (last != 0 && fat32_fat_set(vol, last, first) != 0)) {
+        while (linked > 0) fat32_fat_set(vol, first + --linked, FAT32_FREE);
+        return 0;
+    }
+    vol->next_free = first + n;
+    *start = first;
+    return n;
+}
+
 /* --- 8.3 name conversion --- */
 
 /* Convert FAT32 "HELLO   TXT" to "hello.txt" */
@@ -210,11 +658,12 @@ static int fat32_name_match(const Fat32DirEntry *entry, const char *name) {
 
 static VfsNode *fat32_alloc_node(Fat32Volume *vol, uint8_t type,
                                   uint32_t first_cluster,
-                                  uint32_t dir_cluster, uint32_t entry_idx) {
+                                  uint32_t entry_cluster, uint32_t entry_idx) {
     /* Check cache first */
-    if (first_cluster != 0) {
-        VfsNode *cached = cache_lookup(first_cluster);
-        if (cached) return cached;
+    Fat32NodeInfo *cached = cache_lookup(vol, entry_cluster, entry_idx);
+    if (cached) {
+        cache_touch(cached);
+        return cached->node;
     }
 
     Fat32NodeInfo *info = kmalloc(sizeof(Fat32NodeInfo), GFP_ZERO);
@@ -227,21 +676,20 @@ static VfsNode *fat32_alloc_node(Fat32Volume *vol, uint8_t type,
     }
 
     info->vol = vol;
+    info->node = node;
     info->first_cluster = first_cluster;
-    info->dir_cluster = dir_cluster;
+    info->dir_entry_cluster = entry_cluster;
     info->dir_entry_idx = entry_idx;
 
-    node->inode_num = next_fat_inode++;
+    node->inode_num = fat32_inode_num(vol, entry_cluster, entry_idx);
     node->type = type;
     node->size = 0;
+    node->flags = (type == VFS_DIRECTORY) ? VFS_NODE_DCACHE : 0;
     node->mode = (type == VFS_DIRECTORY) ? 0755 : 0644;
     node->ops = (type == VFS_DIRECTORY) ? &fat32_dir_ops : &fat32_file_ops;
     node->private_data = info;
 
-    if (first_cluster != 0) {
-        cache_insert(first_cluster, node);
-    }
-
+    cache_insert(info);
     return node;
 }
 
@@ -251,14 +699,14 @@ static Fat32NodeInfo *to_fat32(VfsNode *node) {
 
 /* --- Cluster chain read/write --- */
 
+/* Directories are read by walking their chain from the first cluster;
+ * they grow through fat32_dir_take_slot rather than a file's extent map. */
+
 static int fat32_read_chain(Fat32Volume *vol, uint32_t start_cluster,
                              uint32_t offset, void *buf, uint32_t size) {
     if (start_cluster == 0) return 0;
 
     uint32_t bpc = vol->bytes_per_cluster;
-    uint8_t *cluster_buf = kmalloc(bpc, 0);
-    if (!cluster_buf) return -ENOMEM;
-
     uint32_t bytes_read = 0;
     uint32_t cluster = start_cluster;
     uint32_t cluster_offset = 0;  /* Byte offset from start of chain */
@@ -271,10 +719,8 @@ static int fat32_read_chain(Fat32Volume *vol, uint32_t start_cluster,
 
     /* Read data */
     while (cluster != 0 && bytes_read < size) {
-        if (fat32_read_cluster(vol, cluster, cluster_buf) != 0) {
-            kfree(cluster_buf);
-            return -EIO;
-        }
+        Buffer *b = fat32_get_cluster(vol, cluster, 1);
+        if (b == NULL) return -EIO;
 
         uint32_t in_cluster_off = 0;
         if (cluster_offset < offset) {
@@ -285,118 +731,233 @@ static int fat32_read_chain(Fat32Volume *vol, uint32_t start_cluster,
         uint32_t to_copy = size - bytes_read;
         if (to_copy > avail) to_copy = avail;
 
-        memcpy((uint8_t *)buf + bytes_read, cluster_buf + in_cluster_off, to_copy);
+        memcpy((uint8_t *)buf + bytes_read, b->data + in_cluster_off, to_copy);
+        bcache_release(b);
         bytes_read += to_copy;
 
         cluster_offset += bpc;
         cluster = fat32_next_cluster(vol, cluster);
     }
 
-    kfree(cluster_buf);
     return (int)bytes_read;
 }
 
-/* Zero-fill and write a newly allocated cluster. Returns 0 on success, -EIO on failure. */
-static int fat32_init_cluster(Fat32Volume *vol, uint32_t cluster, uint8_t *cluster_buf) {
-    memset(cluster_buf, 0, vol->bytes_per_cluster);
-    return fat32_write_cluster(vol, cluster, cluster_buf) != 0 ? -EIO : 0;
+/* Zero-fill a newly allocated cluster. Returns 0 on success, -ENOMEM on failure. */
+static int fat32_init_cluster(Fat32Volume *vol, uint32_t cluster) {
+    Buffer *b = fat32_get_cluster(vol, cluster, 0);
+    if (b == NULL) return -ENOMEM;
+    memset(b->data, 0, vol->bytes_per_cluster);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    return 0;
 }
 
-/* Walk/extend chain and write data to disk. Updates *first_cluster_ptr if file was empty. */
-static int fat32_write_chain(Fat32Volume *vol, uint32_t *first_cluster_ptr,
-                              uint32_t offset, const void *buf, uint32_t size) {
-    uint32_t bpc = vol->bytes_per_cluster;
-    uint8_t *cluster_buf = kmalloc(bpc, 0);
-    if (!cluster_buf) return -ENOMEM;
+/* --- File extent map --- */
 
-    uint32_t bytes_written = 0;
-    uint32_t cluster = *first_cluster_ptr;
-    uint32_t prev_cluster = 0;
-    uint32_t cluster_offset = 0;
+#define FAT32_EXTENTS_INIT 4
 
-    /* If file has no clusters yet, allocate the first one */
-    if (cluster == 0) {
-        cluster = fat32_alloc_cluster(vol);
-        if (cluster == 0) { kfree(cluster_buf); return -ENOSPC; }
-        *first_cluster_ptr = cluster;
-        fat32_init_cluster(vol, cluster, cluster_buf);
-    }
+/* Spans of at least this many whole, contiguous clusters bypass the buffer
+ * cache: one device request per run instead of one per cluster, and a big
+ * sequential transfer does not flush everything else out of the cache. */
+#define FAT32_DIRECT_MIN_CLUSTERS 2
 
-    /* Skip clusters until we reach the offset */
-    while (cluster != 0 && cluster_offset + bpc <= offset) {
-        prev_cluster = cluster;
-        cluster_offset += bpc;
-        cluster = fat32_next_cluster(vol, cluster);
-        /* Need to extend chain to reach offset */
-        if (cluster == 0 && cluster_offset + bpc <= offset) {
-            cluster = fat32_extend_chain(vol, prev_cluster);
-            if (cluster == 0) { kfree(cluster_buf); return -ENOSPC; }
-            fat32_init_cluster(vol, cluster, cluster_buf);
+static void fat32_extents_drop(Fat32NodeInfo *info) {
+    kfree(info->extents);
+    info->extents = NULL;
+    info->extent_count = 0;
+    info->extent_cap = 0;
+    info->mapped_clusters = 0;
+    info->extents_valid = 0;
+}
+
+/* Add the next cluster of the chain to the map, merging it into the last
+ * run when it is physically adjacent. Returns 0 or -ENOMEM. */
+static int fat32_extents_append(Fat32NodeInfo *info, uint32_t cluster) {
+    if (info->extent_count > 0) {
+        Fat32Extent *last = &info->extents[info->extent_count - 1];
+        if (last->disk_cluster + last->count == cluster) {
+            last->count++;
+            info->mapped_clusters++;
+            return 0;
         }
     }
-
-    /* Extend if we still need a cluster at the offset position */
-    if (cluster == 0) {
-        cluster = fat32_extend_chain(vol, prev_cluster);
-        if (cluster == 0) { kfree(cluster_buf); return -ENOSPC; }
-        fat32_init_cluster(vol, cluster, cluster_buf);
+    if (info->extent_count == info->extent_cap) {
+        uint32_t cap = info->extent_cap ? info->extent_cap * 2 : FAT32_EXTENTS_INIT;
+        Fat32Extent *ext = krealloc(info->extents, cap * sizeof(Fat32Extent));
+        if (ext == NULL) return -ENOMEM;
+        info->extents = ext;
+        info->extent_cap = cap;
     }
+    Fat32Extent *e = &info->extents[info->extent_count++];
+    e->file_cluster = info->mapped_clusters;
+    e->disk_cluster = cluster;
+    e->count = 1;
+    info->mapped_clusters++;
+    return 0;
+}
 
-    /* Write data */
-    while (cluster != 0 && bytes_written < size) {
-        /* Read existing cluster data for partial writes */
-        if (fat32_read_cluster(vol, cluster, cluster_buf) != 0) {
-            kfree(cluster_buf);
-            return -EIO;
-        }
+/* Build the map from the FAT unless it is current. One pass over the
+ * chain, bounded by the volume size in case the chain loops. */
+static int fat32_extents_build(Fat32NodeInfo *info) {
+    if (info->extents_valid) return 0;
+    fat32_extents_drop(info);
 
-        uint32_t in_cluster_off = 0;
-        if (cluster_offset < offset) {
-            in_cluster_off = offset - cluster_offset;
+    Fat32Volume *vol = info->vol;
+    uint32_t cluster = info->first_cluster;
+    for (uint32_t n = 0; cluster != 0 && n < vol->total_clusters; n++) {
+        if (fat32_extents_append(info, cluster) != 0) {
+            fat32_extents_drop(info);
+            return -ENOMEM;
         }
+        cluster = fat32_next_cluster(vol, cluster);
+    }
+    info->extents_valid = 1;
+    return 0;
+}
 
-        uint32_t avail = bpc - in_cluster_off;
-        uint32_t to_copy = size - bytes_written;
-        if (to_copy > avail) to_copy = avail;
+/* The run holding the file's idx-th cluster, or NULL past the end */
+static const Fat32Extent *fat32_extent_find(const Fat32NodeInfo *info, uint32_t idx) {
+    if (idx >= info->mapped_clusters) return NULL;
+    uint32_t lo = 0, hi = info->extent_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (info->extents[mid].file_cluster <= idx) lo = mid;
+        else hi = mid;
+    }
+    return &info->extents[lo];
+}
 
-        memcpy(cluster_buf + in_cluster_off, (const uint8_t *)buf + bytes_written, to_copy);
+/* Disk cluster holding the file's idx-th cluster, or 0 past the end */
+static uint32_t fat32_extent_cluster(const Fat32NodeInfo *info, uint32_t idx) {
+    const Fat32Extent *e = fat32_extent_find(info, idx);
+    return e ? e->disk_cluster + (idx - e->file_cluster) : 0;
+}
 
-        if (fat32_write_cluster(vol, cluster, cluster_buf) != 0) {
-            kfree(cluster_buf);
-            return -EIO;
+/* How many clusters from the file's idx-th one are contiguous on disk,
+ * at most max */
+static uint32_t fat32_extent_run(const Fat32NodeInfo *info, uint32_t idx, uint32_t max) {
+    const Fat32Extent *e = fat32_extent_find(info, idx);
+    if (e == NULL) return 0;
+    uint32_t run = e->count - (idx - e->file_cluster);
+    return run < max ? run : max;
+}
+
+/* Grow a file's chain (and map) to at least `clusters` clusters, zeroing
+ * the new ones except those the caller is about to overwrite whole (bytes
+ * [skip_from, skip_to)). Returns 0, -ENOSPC or -ENOMEM; clusters added
+ * before a failure stay in the chain. */
+static int fat32_extents_grow(Fat32NodeInfo *info, uint32_t clusters,
+                              uint64_t skip_from, uint64_t skip_to) {
+    Fat32Volume *vol = info->vol;
+    while (info->mapped_clusters < clusters) {
+        uint32_t last = info->mapped_clusters > 0
+            ? fat32_extent_cluster(info, info->mapped_clusters - 1) : 0;
+        uint32_t first;
+        uint32_t n = fat32_alloc_run(info, last, clusters - info->mapped_clusters, &first);
+        if (n == 0) return -ENOSPC;
+        if (last == 0) info->first_cluster = first;
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t start = (uint64_t)info->mapped_clusters * vol->bytes_per_cluster;
+            if (start < skip_from || start + vol->bytes_per_cluster > skip_to) {
+                fat32_init_cluster(vol, first + i);
+            }
+            if (fat32_extents_append(info, first + i) != 0) {
+                /* In the FAT but not the map: rebuild on next access */
+                info->extents_valid = 0;
+                return -ENOMEM;
+            }
         }
+    }
+    return 0;
+}
 
-        bytes_written += to_copy;
-        cluster_offset += bpc;
-        prev_cluster = cluster;
-        cluster = fat32_next_cluster(vol, cluster);
+static int fat32_read_file(Fat32NodeInfo *info, uint32_t offset, void *buf, uint32_t size) {
+    int rc = fat32_extents_build(info);
+    if (rc != 0) return rc;
 
-        /* Extend chain if more data to write */
-        if (cluster == 0 && bytes_written < size) {
-            cluster = fat32_extend_chain(vol, prev_cluster);
-            if (cluster == 0) { kfree(cluster_buf); return -ENOSPC; }
-            fat32_init_cluster(vol, cluster, cluster_buf);
+    Fat32Volume *vol = info->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+    uint32_t done = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t cluster = fat32_extent_cluster(info, pos / bpc);
+        if (cluster == 0) break;
+
+        /* Whole contiguous clusters: one request straight into buf */
+        uint32_t run = (pos % bpc == 0)
+            ? fat32_extent_run(info, pos / bpc, (size - done) / bpc) : 0;
+        if (run >= FAT32_DIRECT_MIN_CLUSTERS) {
+            if (bcache_read_direct(vol->dev, cluster_to_sector(vol, cluster),
+                                   run * vol->sectors_per_cluster,
+                                   vol->sectors_per_cluster,
+                                   (uint8_t *)buf + done) != 0) {
+                return done > 0 ? (int)done : -EIO;
+            }
+            done += run * bpc;
+            continue;
         }
-    }
 
-    kfree(cluster_buf);
-    return (int)bytes_written;
+        Buffer *b = fat32_get_cluster(vol, cluster, 1);
+        if (b == NULL) return done > 0 ? (int)done : -EIO;
+        uint32_t in_cluster_off = pos % bpc;
+        uint32_t to_copy = bpc - in_cluster_off;
+        if (to_copy > size - done) to_copy = size - done;
+        memcpy((uint8_t *)buf + done, b->data + in_cluster_off, to_copy);
+        bcache_release(b);
+        done += to_copy;
+    }
+    return (int)done;
 }
 
-/* --- Directory entry helpers --- */
+static int fat32_write_file(Fat32NodeInfo *info, uint32_t offset,
+                            const void *buf, uint32_t size) {
+    int rc = fat32_extents_build(info);
+    if (rc != 0) return rc;
 
-/* Read the idx-th 32-byte dir entry from a directory's cluster chain */
-static int fat32_read_dir_entry(Fat32Volume *vol, uint32_t dir_cluster,
-                                 uint32_t idx, Fat32DirEntry *out) {
-    uint32_t byte_offset = idx * sizeof(Fat32DirEntry);
-    return fat32_read_chain(vol, dir_cluster, byte_offset, out, sizeof(Fat32DirEntry));
-}
+    Fat32Volume *vol = info->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+    uint64_t end = (uint64_t)offset + size;
+    rc = fat32_extents_grow(info, (uint32_t)((end + bpc - 1) / bpc), offset, end);
+
+    /* Out of space: write what the chain now covers */
+    uint64_t mapped = (uint64_t)info->mapped_clusters * bpc;
+    if (rc != 0) {
+        if (mapped <= offset) return rc;
+        if (end > mapped) size = (uint32_t)(mapped - offset);
+    }
+
+    uint32_t done = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t cluster = fat32_extent_cluster(info, pos / bpc);
+
+        uint32_t run = (pos % bpc == 0)
+            ? fat32_extent_run(info, pos / bpc, (size - done) / bpc) : 0;
+        if (run >= FAT32_DIRECT_MIN_CLUSTERS) {
+            if (bcache_write_direct(vol->dev, cluster_to_sector(vol, cluster),
+                                    run * vol->sectors_per_cluster,
+                                    vol->sectors_per_cluster,
+                                    (const uint8_t *)buf + done) != 0) {
+                return done > 0 ? (int)done : -EIO;
+            }
+            done += run * bpc;
+            continue;
+        }
 
-/* Write a dir entry back at the given index */
-static int fat32_write_dir_entry(Fat32Volume *vol, uint32_t dir_cluster,
-                                  uint32_t idx, const Fat32DirEntry *entry) {
-    uint32_t byte_offset = idx * sizeof(Fat32DirEntry);
-    return fat32_write_chain(vol, &dir_cluster, byte_offset, entry, sizeof(Fat32DirEntry));
+        uint32_t in_cluster_off = pos % bpc;
+        uint32_t to_copy = bpc - in_cluster_off;
+        if (to_copy > size - done) to_copy = size - done;
+
+        /* Partial writes need the existing cluster data; whole ones don't */
+        Buffer *b = fat32_get_cluster(vol, cluster, to_copy < bpc);
+        if (b == NULL) return done > 0 ? (int)done : -EIO;
+        memcpy(b->data + in_cluster_off, (const uint8_t *)buf + done, to_copy);
+        bcache_mark_dirty(b);
+        bcache_release(b);
+        done += to_copy;
+    }
+    return (int)done;
 }
 
 /* --- Directory entry walker --- */
@@ -416,23 +977,19 @@ static int fat32_walk_dir(Fat32Volume *vol, uint32_t dir_cluster,
     uint32_t base_idx = 0;
 
     while (cluster != 0) {
-        uint8_t *buf = kmalloc(vol->bytes_per_cluster, 0);
-        if (!buf) return -ENOMEM;
-        if (fat32_read_cluster(vol, cluster, buf) != 0) {
-            kfree(buf);
-            return -EIO;
-        }
+        Buffer *b = fat32_get_cluster(vol, cluster, 1);
+        if (b == NULL) return -EIO;
 
-        Fat32DirEntry *entries = (Fat32DirEntry *)buf;
+        Fat32DirEntry *entries = (Fat32DirEntry *)b->data;
         for (uint32_t i = 0; i < epc; i++) {
             int rc = visitor(&entries[i], base_idx + i, ctx);
             if (rc != DIR_WALK_CONTINUE) {
-                kfree(buf);
+                bcache_release(b);
                 return rc;
             }
         }
 
-        kfree(buf);
+        bcache_release(b);
         base_idx += epc;
         cluster = fat32_next_cluster(vol, cluster);
     }
@@ -450,43 +1007,217 @@ static int fat32_entry_filter(const Fat32DirEntry *e) {
     return 0;
 }
 
-typedef struct {
-    int slot;
-} FreeSlotCtx;
+/* --- Directory index --- */
+
+#define FAT32_DIR_TABLE_MIN 16
 
-static int free_slot_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
-    if (e->name[0] == FAT32_DIR_END || e->name[0] == FAT32_DIR_FREE) {
-        FreeSlotCtx *ctx = (FreeSlotCtx *)arg;
-        ctx->slot = (int)idx;
-        return DIR_WALK_STOP;
+/* Append v to a kmalloc'd array, doubling it when full */
+static int fat32_u32_push(uint32_t **arr, uint32_t *count, uint32_t *cap, uint32_t v) {
+    if (*count == *cap) {
+        uint32_t new_cap = *cap ? *cap * 2 : 8;
+        uint32_t *grown = krealloc(*arr, new_cap * sizeof(uint32_t));
+        if (grown == NULL) return -ENOMEM;
+        *arr = grown;
+        *cap = new_cap;
     }
-    return DIR_WALK_CONTINUE;
+    (*arr)[(*count)++] = v;
+    return 0;
+}
+
+static uint32_t fat32_name_hash(const uint8_t name[11]) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 11; i++) h = (h ^ name[i]) * 16777619u;    /* FNV-1a */
+    return h;
+}
+
+static Fat32DirName *fat32_dirname_find(Fat32DirIndex *di, const uint8_t name[11]) {
+    if (di->table_size == 0) return NULL;
+    uint32_t mask = di->table_size - 1;
+    for (uint32_t i = fat32_name_hash(name) & mask; ; i = (i + 1) & mask) {
+        Fat32DirName *n = &di->names[i];
+        if (n->state == FAT32_DIRNAME_EMPTY) return NULL;
+        if (n->state == FAT32_DIRNAME_USED && memcmp(n->name, name, 11) == 0) return n;
+    }
+}
+
+/* Put a name the table does not hold into the first reusable bucket */
+static void fat32_dirname_place(Fat32DirIndex *di, const uint8_t name[11], uint32_t slot) {
+    uint32_t mask = di->table_size - 1;
+    uint32_t i = fat32_name_hash(name) & mask;
+    while (di->names[i].state == FAT32_DIRNAME_USED) i = (i + 1) & mask;
+    if (di->names[i].state == FAT32_DIRNAME_DELETED) di->deleted--;
+    memcpy(di->names[i].name, name, 11);
+    di->names[i].state = FAT32_DIRNAME_USED;
+    di->names[i].slot = slot;
+    di->used++;
+}
+
+/* Add a name, first growing the table (and dropping tombstones) if it
+ * would pass three-quarters full */
+static int fat32_dirname_insert(Fat32DirIndex *di, const uint8_t name[11], uint32_t slot) {
+    if ((di->used + di->deleted + 1) * 4 > di->table_size * 3) {
+        uint32_t size = FAT32_DIR_TABLE_MIN;
+        while (size < (di->used + 1) * 2) size *= 2;
+        Fat32DirName *table = kmalloc(size * sizeof(Fat32DirName), GFP_ZERO);
+        if (table == NULL) return -ENOMEM;
+        Fat32DirName *old = di->names;
+        uint32_t old_size = di->table_size;
+        di->names = table;
+        di->table_size = size;
+        di->used = di->deleted = 0;
+        for (uint32_t i = 0; i < old_size; i++) {
+            if (old[i].state == FAT32_DIRNAME_USED) {
+                fat32_dirname_place(di, old[i].name, old[i].slot);
+            }
+        }
+        kfree(old);
+    }
+    fat32_dirname_place(di, name, slot);
+    return 0;
+}
+
+static void fat32_dirname_remove(Fat32DirIndex *di, Fat32DirName *n) {
+    n->state = FAT32_DIRNAME_DELETED;
+    di->used--;
+    di->deleted++;
+}
+
+/* The record for a name, matched like fat32_name_match */
+static Fat32DirName *fat32_dir_find_name(Fat32DirIndex *di, const char *name) {
+    uint8_t key[11];
+    if (fat32_str_to_name(name, key) == 0) return fat32_dirname_find(di, key);
+
+    /* Not 8.3 itself, but it may still spell an entry's readable form */
+    Fat32DirEntry e;
+    for (uint32_t i = 0; i < di->table_size; i++) {
+        if (di->names[i].state != FAT32_DIRNAME_USED) continue;
+        memcpy(e.name, di->names[i].name, 11);
+        if (fat32_name_match(&e, name)) return &di->names[i];
+    }
+    return NULL;
 }
 
-/* Find a free slot (0x00 or 0xE5) in directory, or extend it. Returns index or -1. */
-static int fat32_find_free_dir_slot(Fat32Volume *vol, uint32_t dir_cluster) {
-    FreeSlotCtx ctx = { .slot = -1 };
-    int rc = fat32_walk_dir(vol, dir_cluster, free_slot_visitor, &ctx);
-    if (rc == DIR_WALK_STOP) return ctx.slot;
-    if (rc < 0) return -1;
+static void fat32_dir_index_drop(Fat32NodeInfo *dir) {
+    Fat32DirIndex *di = dir->dir_index;
+    if (di == NULL) return;
+    kfree(di->clusters);
+    kfree(di->names);
+    kfree(di->free_slots);
+    kfree(di);
+    dir->dir_index = NULL;
+}
 
-    /* No free slot — extend the directory */
+/* Record the next cluster of the chain and, up to the end-of-directory
+ * mark (*ended once seen), its entries */
+static int fat32_dir_index_cluster(Fat32Volume *vol, Fat32DirIndex *di,
+                                   uint32_t cluster, int *ended) {
     uint32_t epc = vol->bytes_per_cluster / sizeof(Fat32DirEntry);
-    uint32_t cluster = dir_cluster;
-    uint32_t prev = 0;
-    uint32_t count = 0;
-    while (cluster != 0) {
-        prev = cluster;
+    uint32_t base = di->cluster_count * epc;
+    if (fat32_u32_push(&di->clusters, &di->cluster_count, &di->cluster_cap, cluster) != 0) {
+        return -ENOMEM;
+    }
+    if (*ended) return 0;
+
+    Buffer *b = fat32_get_cluster(vol, cluster, 1);
+    if (b == NULL) return -EIO;
+    const Fat32DirEntry *e = (const Fat32DirEntry *)b->data;
+    int rc = 0;
+    for (uint32_t i = 0; i < epc && rc == 0; i++) {
+        if (e[i].name[0] == FAT32_DIR_END) {
+            di->end = base + i;
+            *ended = 1;
+            break;
+        }
+        if (e[i].name[0] == FAT32_DIR_FREE) {
+            rc = fat32_u32_push(&di->free_slots, &di->free_count, &di->free_cap, base + i);
+        } else if (fat32_entry_filter(&e[i]) == 0 && e[i].name[0] != '.' &&
+                   fat32_dirname_find(di, e[i].name) == NULL) {
+            rc = fat32_dirname_insert(di, e[i].name, base + i);
+        }
+    }
+    bcache_release(b);
+    return rc;
+}
+
+/* The directory's index, built on first use. NULL on I/O error or out
+ * of memory. */
+static Fat32DirIndex *fat32_dir_index(Fat32NodeInfo *dir) {
+    if (dir->dir_index != NULL) return dir->dir_index;
+    Fat32Volume *vol = dir->vol;
+    Fat32DirIndex *di = kmalloc(sizeof(Fat32DirIndex), GFP_ZERO);
+    if (di == NULL) return NULL;
+    dir->dir_index = di;
+
+    int ended = 0;
+    uint32_t cluster = dir->first_cluster;
+    for (uint32_t n = 0; cluster != 0 && n < vol->total_clusters; n++) {
+        if (fat32_dir_index_cluster(vol, di, cluster, &ended) != 0) {
+            fat32_dir_index_drop(dir);
+            return NULL;
+        }
         cluster = fat32_next_cluster(vol, cluster);
-        count++;
     }
-    cluster = fat32_extend_chain(vol, prev);
-    if (cluster == 0) return -1;
-    uint8_t *zero_buf = kmalloc(vol->bytes_per_cluster, GFP_ZERO);
-    if (!zero_buf) return -1;
-    fat32_write_cluster(vol, cluster, zero_buf);
-    kfree(zero_buf);
-    return (int)(count * epc);
+    if (!ended) di->end = di->cluster_count * (vol->bytes_per_cluster / sizeof(Fat32DirEntry));
+    return di;
+}
+
+/* Disk cluster holding a directory slot */
+static uint32_t fat32_dir_slot_cluster(Fat32Volume *vol, const Fat32DirIndex *di, uint32_t slot) {
+    return di->clusters[slot / (vol->bytes_per_cluster / sizeof(Fat32DirEntry))];
+}
+
+/* A slot for a new entry: a deleted one, else the first never used,
+ * growing the directory by a zeroed cluster when it is full. Returns
+ * the slot or negative errno. */
+static int fat32_dir_take_slot(Fat32NodeInfo *dir, Fat32DirIndex *di) {
+    if (di->free_count > 0) return (int)di->free_slots[--di->free_count];
+
+    Fat32Volume *vol = dir->vol;
+    if (di->end == di->cluster_count * (vol->bytes_per_cluster / sizeof(Fat32DirEntry))) {
+        uint32_t cluster = fat32_extend_chain(vol, di->clusters[di->cluster_count - 1]);
+        if (cluster == 0) return -ENOSPC;
+        if (fat32_init_cluster(vol, cluster) != 0) return -ENOMEM;
+        if (fat32_u32_push(&di->clusters, &di->cluster_count, &di->cluster_cap, cluster) != 0) {
+            return -ENOMEM;
+        }
+    }
+    return (int)di->end++;
+}
+
+/* Copy the slot-th entry of a directory out of or into `cluster`, the
+ * disk cluster holding it */
+static int fat32_entry_read(Fat32Volume *vol, uint32_t cluster, uint32_t slot,
+                            Fat32DirEntry *out) {
+    Buffer *b = fat32_get_cluster(vol, cluster, 1);
+    if (b == NULL) return -EIO;
+    uint32_t epc = vol->bytes_per_cluster / sizeof(Fat32DirEntry);
+    memcpy(out, (Fat32DirEntry *)b->data + slot % epc, sizeof(Fat32DirEntry));
+    bcache_release(b);
+    return 0;
+}
+
+static int fat32_entry_write(Fat32Volume *vol, uint32_t cluster, uint32_t slot,
+                             const Fat32DirEntry *entry) {
+    Buffer *b = fat32_get_cluster(vol, cluster, 1);
+    if (b == NULL) return -EIO;
+    uint32_t epc = vol->bytes_per_cluster / sizeof(Fat32DirEntry);
+    memcpy((Fat32DirEntry *)b->data + slot % epc, entry, sizeof(Fat32DirEntry));
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    return 0;
+}
+
+/* Store a file's size and first cluster in its directory entry */
+static void fat32_update_dir_entry(VfsNode *node) {
+    Fat32NodeInfo *info = to_fat32(node);
+    if (!info->cached) return;      /* Unlinked: the slot may be reused */
+    Fat32DirEntry dentry;
+    if (fat32_entry_read(info->vol, info->dir_entry_cluster, info->dir_entry_idx, &dentry) != 0) {
+        return;
+    }
+    dentry.file_size = (uint32_t)node->size;
+    fat32_set_entry_cluster(&dentry, info->first_cluster);
+    fat32_entry_write(info->vol, info->dir_entry_cluster, info->dir_entry_idx, &dentry);
 }
 
 /* --- VfsOps implementations --- */
@@ -497,6 +1228,7 @@ static int fat32_read(VfsNode *node, void *buf, uint32_t offset, uint32_t size)
         if (offset >= node->size) return 0;
         uint32_t avail = (uint32_t)(node->size - offset);
         if (size > avail) size = avail;
+        return fat32_read_file(info, offset, buf, size);
     }
     return fat32_read_chain(info->vol, info->first_cluster, offset, buf, size);
 }
@@ -505,7 +1237,7 @@ static int fat32_write(VfsNode *node, const void *buf, uint32_t offset, uint32_t
     Fat32NodeInfo *info = to_fat32(node);
     if (node->type != VFS_FILE) return -EISDIR;
 
-    int written = fat32_write_chain(info->vol, &info->first_cluster, offset, buf, size);
+    int written = fat32_write_file(info, offset, buf, size);
     if (written <= 0) return written;
 
     /* Update file size */
@@ -514,71 +1246,52 @@ static int fat32_write(VfsNode *node, const void *buf, uint32_t offset, uint32_t
         node->size = end;
     }
 
-    /* Update directory entry on disk */
-    Fat32DirEntry dentry;
-    if (fat32_read_dir_entry(info->vol, info->dir_cluster, info->dir_entry_idx, &dentry) > 0) {
-        dentry.file_size = (uint32_t)node->size;
-        fat32_set_entry_cluster(&dentry, info->first_cluster);
-        fat32_write_dir_entry(info->vol, info->dir_cluster, info->dir_entry_idx, &dentry);
-    }
-
-    fat32_sync();
+    fat32_update_dir_entry(node);
+    fat32_sync_later(info->vol);
     return written;
 }
 
-typedef struct {
-    const char *name;
-    Fat32Volume *vol;
-    uint32_t dir_cluster;
-    VfsNode *result;
-} LookupCtx;
-
-static int lookup_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
-    int f = fat32_entry_filter(e);
-    if (f < 0) return DIR_WALK_STOP;
-    if (f > 0) return DIR_WALK_CONTINUE;
-    if (e->name[0] == '.' && e->name[1] == ' ') return DIR_WALK_CONTINUE;
-    if (e->name[0] == '.' && e->name[1] == '.' && e->name[2] == ' ') return DIR_WALK_CONTINUE;
-
-    LookupCtx *ctx = (LookupCtx *)arg;
-    if (fat32_name_match(e, ctx->name)) {
-        uint32_t fc = fat32_entry_cluster(e);
-        uint8_t type = (e->attr & FAT32_ATTR_DIRECTORY) ? VFS_DIRECTORY : VFS_FILE;
-        ctx->result = fat32_alloc_node(ctx->vol, type, fc, ctx->dir_cluster, idx);
-        if (ctx->result) ctx->result->size = e->file_size;
-        return DIR_WALK_STOP;
-    }
-    return DIR_WALK_CONTINUE;
-}
-
 static VfsNode *fat32_lookup(VfsNode *dir, const char *name) {
     Fat32NodeInfo *dir_info = to_fat32(dir);
-    LookupCtx ctx = { .name = name, .vol = dir_info->vol,
-                       .dir_cluster = dir_info->first_cluster, .result = NULL };
-    fat32_walk_dir(dir_info->vol, dir_info->first_cluster, lookup_visitor, &ctx);
-    return ctx.result;
+    cache_touch(dir_info);
+    Fat32Volume *vol = dir_info->vol;
+    Fat32DirIndex *di = fat32_dir_index(dir_info);
+    if (di == NULL) return NULL;
+    Fat32DirName *n = fat32_dir_find_name(di, name);
+    if (n == NULL) return NULL;
+
+    uint32_t cluster = fat32_dir_slot_cluster(vol, di, n->slot);
+    Fat32DirEntry e;
+    if (fat32_entry_read(vol, cluster, n->slot, &e) != 0) return NULL;
+    uint8_t type = (e.attr & FAT32_ATTR_DIRECTORY) ? VFS_DIRECTORY : VFS_FILE;
+    VfsNode *node = fat32_alloc_node(vol, type, fat32_entry_cluster(&e), cluster, n->slot);
+    if (node) node->size = e.file_size;
+    return node;
 }
 
 static VfsNode *fat32_create(VfsNode *dir, const char *name, uint8_t type) {
     Fat32NodeInfo *dir_info = to_fat32(dir);
+    cache_touch(dir_info);
     Fat32Volume *vol = dir_info->vol;
 
-    /* Check duplicate */
-    if (fat32_lookup(dir, name) != NULL) return NULL;
-
     /* Build 8.3 name */
     uint8_t fat_name[11];
     if (fat32_str_to_name(name, fat_name) != 0) return NULL;
 
+    /* Check duplicate */
+    Fat32DirIndex *di = fat32_dir_index(dir_info);
+    if (di == NULL || fat32_dirname_find(di, fat_name) != NULL) return NULL;
+
     /* Allocate cluster for directories */
     uint32_t new_cluster = 0;
     if (type == VFS_DIRECTORY) {
-        new_cluster = fat32_alloc_cluster(vol);
+        new_cluster = fat32_alloc_cluster(vol, 0);
         if (new_cluster == 0) return NULL;
         /* Zero and init . and .. entries */
-        uint8_t *cbuf = kmalloc(vol->bytes_per_cluster, GFP_ZERO);
-        if (!cbuf) return NULL;
-        Fat32DirEntry *dot_entries = (Fat32DirEntry *)cbuf;
+        Buffer *b = fat32_get_cluster(vol, new_cluster, 0);
+        if (!b) return NULL;
+        memset(b->data, 0, vol->bytes_per_cluster);
+        Fat32DirEntry *dot_entries = (Fat32DirEntry *)b->data;
         /* . entry */
         memcpy(dot_entries[0].name, ".          ", 11);
         dot_entries[0].attr = FAT32_ATTR_DIRECTORY;
@@ -587,13 +1300,18 @@ static VfsNode *fat32_create(VfsNode *dir, const char *name, uint8_t type) {
         memcpy(dot_entries[1].name, "..         ", 11);
         dot_entries[1].attr = FAT32_ATTR_DIRECTORY;
         fat32_set_entry_cluster(&dot_entries[1], dir_info->first_cluster);
-        fat32_write_cluster(vol, new_cluster, cbuf);
-        kfree(cbuf);
+        bcache_mark_dirty(b);
+        bcache_release(b);
     }
 
     /* Find free dir entry slot */
-    int slot = fat32_find_free_dir_slot(vol, dir_info->first_cluster);
-    if (slot < 0) return NULL;
+    int slot = fat32_dir_take_slot(dir_info, di);
+    if (slot < 0) {
+        /* The chain may have grown behind the index */
+        fat32_dir_index_drop(dir_info);
+        return NULL;
+    }
+    uint32_t entry_cluster = fat32_dir_slot_cluster(vol, di, (uint32_t)slot);
 
     /* Build directory entry */
     Fat32DirEntry dentry;
@@ -603,56 +1321,61 @@ static VfsNode *fat32_create(VfsNode *dir, const char *name, uint8_t type) {
     fat32_set_entry_cluster(&dentry, new_cluster);
     dentry.file_size = 0;
 
-    fat32_write_dir_entry(vol, dir_info->first_cluster, (uint32_t)slot, &dentry);
-    fat32_sync();
+    fat32_entry_write(vol, entry_cluster, (uint32_t)slot, &dentry);
+    if (fat32_dirname_insert(di, fat_name, (uint32_t)slot) != 0) fat32_dir_index_drop(dir_info);
+    fat32_sync_later(vol);
 
-    VfsNode *node = fat32_alloc_node(vol, type, new_cluster,
-                                      dir_info->first_cluster, (uint32_t)slot);
+    VfsNode *node = fat32_alloc_node(vol, type, new_cluster, entry_cluster, (uint32_t)slot);
     return node;
 }
 
-typedef struct {
-    const char *name;
-    Fat32Volume *vol;
-    uint32_t dir_cluster;
-    int result;
-} UnlinkCtx;
-
-static int unlink_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
-    int f = fat32_entry_filter(e);
-    if (f < 0) return DIR_WALK_STOP;
-    if (f > 0) return DIR_WALK_CONTINUE;
-
-    UnlinkCtx *ctx = (UnlinkCtx *)arg;
-    if (fat32_name_match(e, ctx->name)) {
-        uint32_t fc = fat32_entry_cluster(e);
-        if (fc != 0) fat32_free_chain(ctx->vol, fc);
-        e->name[0] = FAT32_DIR_FREE;
-        fat32_write_dir_entry(ctx->vol, ctx->dir_cluster, idx, e);
-        fat32_sync();
-        ctx->result = VFS_OK;
-        return DIR_WALK_STOP;
-    }
-    return DIR_WALK_CONTINUE;
-}
-
 static int fat32_unlink(VfsNode *dir, const char *name) {
     Fat32NodeInfo *dir_info = to_fat32(dir);
-    UnlinkCtx ctx = { .name = name, .vol = dir_info->vol,
-                       .dir_cluster = dir_info->first_cluster, .result = -ENOENT };
-    int rc = fat32_walk_dir(dir_info->vol, dir_info->first_cluster, unlink_visitor, &ctx);
-    if (rc < 0) return rc;
-    return ctx.result;
+    cache_touch(dir_info);
+    Fat32Volume *vol = dir_info->vol;
+    Fat32DirIndex *di = fat32_dir_index(dir_info);
+    if (di == NULL) return -EIO;
+    Fat32DirName *n = fat32_dir_find_name(di, name);
+    if (n == NULL) return -ENOENT;
+
+    uint32_t slot = n->slot;
+    uint32_t cluster = fat32_dir_slot_cluster(vol, di, slot);
+    Fat32DirEntry e;
+    if (fat32_entry_read(vol, cluster, slot, &e) != 0) return -EIO;
+    uint32_t fc = fat32_entry_cluster(&e);
+    Fat32NodeInfo *victim = cache_lookup(vol, cluster, slot);
+    if (victim != NULL && victim->refs > 0) {
+        /* Still open: reads and writes through it keep using its own
+         * clusters, freed when the last reference goes */
+        victim->orphan = 1;
+        fc = 0;
+    }
+    if (victim != NULL) {
+        fat32_extents_drop(victim);
+        fat32_prealloc_drop(victim);
+        fat32_dir_index_drop(victim);
+        cache_remove(victim);
+    }
+    if (fc != 0) fat32_free_chain(vol, fc);
+    e.name[0] = FAT32_DIR_FREE;
+    fat32_entry_write(vol, cluster, slot, &e);
+    fat32_dirname_remove(di, n);
+    if (fat32_u32_push(&di->free_slots, &di->free_count, &di->free_cap, slot) != 0) {
+        fat32_dir_index_drop(dir_info);
+    }
+    fat32_sync_later(vol);
+    return VFS_OK;
 }
 
 typedef struct {
+    Fat32Volume *vol;
+    const Fat32DirIndex *di;
     VfsDirEntry *out;
     uint32_t max;
     uint32_t count;
 } ReaddirCtx;
 
 static int readdir_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
-    (void)idx;
     int f = fat32_entry_filter(e);
     if (f < 0) return DIR_WALK_STOP;
     if (f > 0) return DIR_WALK_CONTINUE;
@@ -660,7 +1383,8 @@ static int readdir_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
 
     ReaddirCtx *ctx = (ReaddirCtx *)arg;
     fat32_name_to_str(e, ctx->out[ctx->count].name);
-    ctx->out[ctx->count].inode_num = fat32_entry_cluster(e);
+    ctx->out[ctx->count].inode_num =
+        fat32_inode_num(ctx->vol, fat32_dir_slot_cluster(ctx->vol, ctx->di, idx), idx);
     ctx->out[ctx->count].type = (e->attr & FAT32_ATTR_DIRECTORY) ? VFS_DIRECTORY : VFS_FILE;
     ctx->count++;
     if (ctx->count >= ctx->max) return DIR_WALK_STOP;
@@ -669,7 +1393,10 @@ static int readdir_visitor(Fat32DirEntry *e, uint32_t idx, void *arg) {
 
 static int fat32_readdir(VfsNode *dir, VfsDirEntry *out, uint32_t max) {
     Fat32NodeInfo *dir_info = to_fat32(dir);
-    ReaddirCtx ctx = { .out = out, .max = max, .count = 0 };
+    cache_touch(dir_info);
+    Fat32DirIndex *di = fat32_dir_index(dir_info);
+    if (di == NULL) return -ENOMEM;
+    ReaddirCtx ctx = { .vol = dir_info->vol, .di = di, .out = out, .max = max, .count = 0 };
     fat32_walk_dir(dir_info->vol, dir_info->first_cluster, readdir_visitor, &ctx);
     return (int)ctx.count;
 }
@@ -677,6 +1404,8 @@ static int fat32_readdir(VfsNode *dir, VfsDirEntry *out, uint32_t max) {
 static void fat32_truncate(VfsNode *node, uint64_t size) {
     Fat32NodeInfo *info = to_fat32(node);
     if (node->type != VFS_FILE) return;
+    fat32_extents_drop(info);
+    fat32_prealloc_drop(info);
 
     if (size == 0) {
         if (info->first_cluster != 0) {
@@ -694,55 +1423,133 @@ static void fat32_truncate(VfsNode *node, uint64_t size) {
         }
         if (cluster != 0) {
             uint32_t next = fat32_next_cluster(info->vol, cluster);
-            /* Mark current as EOC */
-            info->vol->fat[cluster] = (info->vol->fat[cluster] & ~FAT32_ENTRY_MASK) |
-                                       (FAT32_EOC & FAT32_ENTRY_MASK);
-            info->vol->fat_dirty = 1;
-            /* Free the rest */
-            if (next != 0) fat32_free_chain(info->vol, next);
+            /* Mark current as EOC, then free the rest */
+            if (fat32_fat_set(info->vol, cluster, FAT32_EOC) == 0 && next != 0) {
+                fat32_free_chain(info->vol, next);
+            }
         }
         node->size = size;
     }
 
-    /* Update dir entry */
-    Fat32DirEntry dentry;
-    if (fat32_read_dir_entry(info->vol, info->dir_cluster, info->dir_entry_idx, &dentry) > 0) {
-        dentry.file_size = (uint32_t)node->size;
-        fat32_set_entry_cluster(&dentry, info->first_cluster);
-        fat32_write_dir_entry(info->vol, info->dir_cluster, info->dir_entry_idx, &dentry);
-    }
-    fat32_sync();
+    fat32_update_dir_entry(node);
+    fat32_sync_later(info->vol);
 }
 
-/* --- Sync --- */
-
-int fat32_sync(void) {
-    /* Find the volume from the root node cache — simple approach */
-    if (node_cache_count == 0) return -1;
-    Fat32NodeInfo *info = (Fat32NodeInfo *)node_cache[0].node->private_data;
-    Fat32Volume *vol = info->vol;
+/* --- FSInfo --- */
 
-    if (!vol->fat_dirty) return 0;
+/* Take the free count and next-free hint from FSInfo if it looks sane */
+static void fat32_read_fsinfo(Fat32Volume *vol, uint32_t sector) {
+    Fat32FsInfo fsi;
+    if (vol->dev->read(vol->dev, sector, 1, &fsi) != 0) return;
+    if (fsi.lead_sig != FAT32_FSINFO_LEAD_SIG || fsi.struct_sig != FAT32_FSINFO_STRUCT_SIG ||
+        fsi.trail_sig != FAT32_FSINFO_TRAIL_SIG) {
+        return;
+    }
+    vol->fsinfo_sector = sector;
+    if (fsi.free_count <= vol->total_clusters) vol->free_count = fsi.free_count;
+    if (fsi.next_free >= 2 && fsi.next_free < vol->total_clusters + 2) {
+        vol->next_free = fsi.next_free;
+    }
+}
 
-    /* Write FAT sectors back to disk */
-    uint8_t sector_buf[SECTOR_SIZE];
-    for (uint32_t s = 0; s < vol->fat_sectors; s++) {
-        memcpy(sector_buf, (uint8_t *)vol->fat + s * SECTOR_SIZE, SECTOR_SIZE);
-        if (vol->dev->write(vol->dev, vol->fat_start + s, 1, sector_buf) != 0) {
-            kprintf("[FAT32] Failed to sync FAT sector %u\n", s);
+static int fat32_write_fsinfo(Fat32Volume *vol) {
+    if (vol->fsinfo_sector != 0) {
+        Fat32FsInfo fsi;
+        if (vol->dev->read(vol->dev, vol->fsinfo_sector, 1, &fsi) != 0) return -EIO;
+        fsi.free_count = vol->free_count;
+        fsi.next_free = vol->next_free;
+        if (vol->dev->write(vol->dev, vol->fsinfo_sector, 1, &fsi) != 0) {
+            kprintf("[FAT32] Failed to write FSInfo\n");
             return -EIO;
         }
     }
+    vol->fsinfo_dirty = 0;
+    return 0;
+}
+
+/* --- Sync --- */
 
-    vol->fat_dirty = 0;
+static int fat32_sync_volume(Fat32Volume *vol) {
+    /* File data and directory entries first, then the FAT that links them */
+    if (bcache_flush(vol->dev) != 0) {
+        kprintf("[FAT32] Failed to write back cached clusters\n");
+        return -EIO;
+    }
+    /* Then only the FAT sectors that changed */
+    for (uint32_t i = 0; i < FAT32_FAT_PAGES && vol->fat_dirty > 0; i++) {
+        Fat32FatPage *p = &vol->fat_pages[i];
+        if (p->dirty && fat32_fat_writeback(vol, p) != 0) return -EIO;
+    }
+    /* FSInfo last: only a hint, but it should describe the FAT on disk */
+    if (vol->fsinfo_dirty) return fat32_write_fsinfo(vol);
     return 0;
 }
 
+/* fsync: the volume's clusters and FAT, not just the node's. Neither
+ * buffers nor FAT sectors are tracked per file. */
+static int fat32_fsync(VfsNode *node) {
+    return fat32_sync_volume(to_fat32(node)->vol);
+}
+
+static void fat32_sync_work_fn(Work *work) {
+    Fat32Volume *vol = (Fat32Volume *)((uint8_t *)work - offsetof(Fat32Volume, sync_work));
+    fat32_sync_volume(vol);
+}
+
+/* --- Readahead --- */
+
+static void fat32_ra_work_fn(Work *work) {
+    Fat32Volume *vol = (Fat32Volume *)((uint8_t *)work - offsetof(Fat32Volume, ra_work));
+    for (uint32_t i = 0; i < vol->ra_count; i++) {
+        bcache_prefetch(vol->dev, cluster_to_sector(vol, vol->ra_runs[i].cluster),
+                        vol->ra_runs[i].count * vol->sectors_per_cluster,
+                        vol->sectors_per_cluster);
+    }
+    vol->ra_count = 0;
+}
+
+/* Queue the file's clusters under [offset, offset+size) for the worker.
+ * Only disk cluster numbers are kept, so the node may go away meanwhile;
+ * a cluster freed and reused by then is read as it is on disk, which is
+ * what the cache would read anyway. The worker only runs once the reader
+ * blocks or is preempted, and disk I/O is polled, so the gain is fewer,
+ * larger requests rather than reads overlapped with the reader. */
+static void fat32_readahead(VfsNode *node, uint64_t offset, uint32_t size) {
+    Fat32NodeInfo *info = to_fat32(node);
+    Fat32Volume *vol = info->vol;
+    if (size == 0 || fat32_extents_build(info) != 0) return;
+
+    uint32_t bpc = vol->bytes_per_cluster;
+    uint32_t idx = (uint32_t)(offset / bpc);
+    uint32_t last = (uint32_t)((offset + size - 1) / bpc);
+    while (idx <= last && vol->ra_count < FAT32_RA_RUNS) {
+        uint32_t cluster = fat32_extent_cluster(info, idx);
+        if (cluster == 0) break;
+        uint32_t run = fat32_extent_run(info, idx, last - idx + 1);
+        vol->ra_runs[vol->ra_count].cluster = cluster;
+        vol->ra_runs[vol->ra_count].count = run;
+        vol->ra_count++;
+        idx += run;
+    }
+    queue_work(&vol->ra_work);
+}
+
+int fat32_sync(void) {
+    int rc = 0;
+    for (Fat32Volume *vol = fat32_volumes; vol != NULL; vol = vol->next) {
+        if (fat32_sync_volume(vol) != 0) rc = -EIO;
+    }
+    return rc;
+}
+
 /* --- Mount --- */
 
 VfsNode *fat32_mount(BlockDevice *dev) {
     if (dev == NULL) return NULL;
 
+    /* Whatever was cached for this device belongs to an earlier mount */
+    bcache_invalidate(dev);
+
     /* Read boot sector */
     uint8_t sector_buf[SECTOR_SIZE];
     if (dev->read(dev, 0, 1, sector_buf) != 0) {
@@ -769,6 +1576,10 @@ VfsNode *fat32_mount(BlockDevice *dev) {
         kprintf("[FAT32] sectors_per_cluster is zero\n");
         return NULL;
     }
+    if (bpb->num_fats == 0) {
+        kprintf("[FAT32] num_fats is zero\n");
+        return NULL;
+    }
 
     /* Allocate volume context */
     Fat32Volume *vol = kmalloc(sizeof(Fat32Volume), GFP_ZERO);
@@ -779,6 +1590,7 @@ VfsNode *fat32_mount(BlockDevice *dev) {
     vol->bytes_per_cluster = (uint32_t)bpb->sectors_per_cluster * SECTOR_SIZE;
     vol->fat_start = bpb->reserved_sectors;
     vol->fat_sectors = bpb->fat_size_32;
+    vol->num_fats = bpb->num_fats;
     vol->root_cluster = bpb->root_cluster;
 
     /* Data region starts after reserved + all FATs */
@@ -789,44 +1601,40 @@ VfsNode *fat32_mount(BlockDevice *dev) {
     uint32_t data_sectors = total_sectors - vol->data_start;
     vol->total_clusters = data_sectors / bpb->sectors_per_cluster;
 
+    /* Allocation hints; the free map itself waits for the first allocation */
+    vol->free_count = FAT32_FREE_UNKNOWN;
+    vol->next_free = 2;
+    if (bpb->fs_info != 0 && bpb->fs_info < bpb->reserved_sectors) {
+        fat32_read_fsinfo(vol, bpb->fs_info);
+    }
+
     kprintf("[FAT32] BPB: spc=%u fat_start=%u data_start=%u root_cluster=%u total_clusters=%u\n",
             vol->sectors_per_cluster, vol->fat_start, vol->data_start,
             vol->root_cluster, vol->total_clusters);
 
-    /* Load entire FAT into memory */
-    uint32_t fat_bytes = vol->fat_sectors * SECTOR_SIZE;
-    vol->fat = kmalloc(fat_bytes, 0);
-    if (!vol->fat) {
-        kprintf("[FAT32] Failed to allocate FAT cache (%u bytes)\n", fat_bytes);
-        kfree(vol);
-        return NULL;
-    }
-
-    /* Read FAT sectors one at a time */
-    for (uint32_t s = 0; s < vol->fat_sectors; s++) {
-        if (dev->read(dev, vol->fat_start + s, 1,
-                      (uint8_t *)vol->fat + s * SECTOR_SIZE) != 0) {
-            kprintf("[FAT32] Failed to read FAT sector %u\n", s);
-            kfree(vol->fat);
-            kfree(vol);
-            return NULL;
-        }
-    }
-
-    vol->fat_dirty = 0;
-
-    /* Reset node cache */
-    node_cache_count = 0;
+    work_init(&vol->sync_work, fat32_sync_work_fn);
+    work_init(&vol->ra_work, fat32_ra_work_fn);
 
     /* Create root VfsNode */
     VfsNode *root = fat32_alloc_node(vol, VFS_DIRECTORY, vol->root_cluster, 0, 0);
     if (!root) {
-        kfree(vol->fat);
+        for (int i = 0; i < FAT32_FAT_PAGES; i++) kfree(vol->fat_pages[i].entries);
         kfree(vol);
         return NULL;
     }
     vol->root_node = root;
+    fat32_node_get(root);           /* The mount's reference */
+
+    /* Replaces any earlier mount of the device */
+    Fat32Volume **link = &fat32_volumes;
+    while (*link != NULL) {
+        if ((*link)->dev == dev) *link = (*link)->next;
+        else link = &(*link)->next;
+    }
+    vol->next = fat32_volumes;
+    fat32_volumes = vol;
 
-    kprintf("[FAT32] Volume mounted, FAT cached (%u bytes)\n", fat_bytes);
+    kprintf("[FAT32] Volume mounted, FAT paged on demand (%u sectors x %u)\n",
+            vol->fat_sectors, vol->num_fats);
     return root;
 }
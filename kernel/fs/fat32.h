@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include "fs/vfs.h"
+#include "proc/workqueue.h"
+#include "fs/flusher.h"
 
 /* Forward declaration */
 typedef struct BlockDevice BlockDevice;
@@ -22,6 +24,12 @@ typedef struct BlockDevice BlockDevice;
 #define FAT32_ENTRY_MASK      0x0FFFFFFF  /* Top 4 bits reserved */
 #define FAT32_BAD_CLUSTER     0x0FFFFFF7
 
+/* FSInfo sector signatures */
+#define FAT32_FSINFO_LEAD_SIG   0x41615252
+#define FAT32_FSINFO_STRUCT_SIG 0x61417272
+#define FAT32_FSINFO_TRAIL_SIG  0xAA550000
+#define FAT32_FREE_UNKNOWN      0xFFFFFFFF  /* FSInfo free count not known */
+
 /* Directory entry markers */
 #define FAT32_DIR_FREE        0xE5  /* Deleted entry */
 #define FAT32_DIR_END         0x00  /* No more entries */
@@ -58,6 +66,17 @@ typedef struct {
     uint8_t  fs_type[8];
 } __attribute__((packed)) Fat32Bpb;
 
+/* FSInfo sector (BPB fs_info): allocation hints, not authoritative */
+typedef struct {
+    uint32_t lead_sig;
+    uint8_t  reserved1[480];
+    uint32_t struct_sig;
+    uint32_t free_count;            /* Free clusters, or FAT32_FREE_UNKNOWN */
+    uint32_t next_free;             /* Where to start looking for one */
+    uint8_t  reserved2[12];
+    uint32_t trail_sig;
+} __attribute__((packed)) Fat32FsInfo;
+
 /* 32-byte FAT32 directory entry */
 typedef struct {
     uint8_t  name[11];              /* 8.3 short name */
@@ -74,8 +93,60 @@ typedef struct {
     uint32_t file_size;
 } __attribute__((packed)) Fat32DirEntry;
 
-/* Runtime volume context */
+/* The FAT is paged in on demand rather than loaded at mount: a volume
+ * caches up to FAT32_FAT_PAGES pages of FAT32_FAT_PAGE_SECTORS sectors,
+ * recycled CLOCK-style.  Changes mark single sectors dirty; sync writes
+ * only those, to every copy of the FAT. */
+#define FAT32_FAT_PAGE_SECTORS  8       /* One dirty bit each in Fat32FatPage */
+#define FAT32_FAT_PAGE_ENTRIES  (FAT32_FAT_PAGE_SECTORS * 512 / 4)
+#define FAT32_FAT_PAGES         32      /* 128 KiB: 32768 clusters mapped */
+
+typedef struct {
+    uint32_t *entries;              /* FAT32_FAT_PAGE_ENTRIES, allocated on first use */
+    uint32_t  page;                 /* Page index within the FAT */
+    uint8_t   valid;                /* entries hold that page */
+    uint8_t   referenced;           /* CLOCK bit */
+    uint8_t   dirty;                /* Bit per sector changed since last sync */
+} Fat32FatPage;
+
+/* Clusters set aside past the end of a file being appended to, so its
+ * next writes stay contiguous even while other files grow.  Reserved
+ * clusters are free in the FAT and marked used only in the free map; a
+ * volume keeps FAT32_PREALLOC_SLOTS reservations, dropped on truncate,
+ * unlink, reuse of the slot or when the volume runs out of space. */
+#define FAT32_PREALLOC_CLUSTERS 16
+#define FAT32_PREALLOC_SLOTS    8
+
 typedef struct {
+    const void *owner;              /* Fat32NodeInfo appending, NULL if unused */
+    uint32_t    start;              /* First reserved cluster */
+    uint32_t    count;
+} Fat32Prealloc;
+
+/* Nodes are cached per volume, hashed by the location of their directory
+ * entry: unlike the first cluster it exists from the moment a file is
+ * created and stays put while it does, so a file never has two VfsNodes.
+ * Open files hold a reference (fat32_node_get/put, taken by the fd layer)
+ * and the mount holds one on the root.  Unreferenced nodes stay cached on
+ * an LRU list, and the least recently used are freed once a volume holds
+ * FAT32_NODE_CACHE nodes; a directory's index goes with its node. */
+#define FAT32_NODE_HASH         64
+#define FAT32_NODE_CACHE        256
+
+typedef struct Fat32NodeInfo Fat32NodeInfo;
+
+/* Readahead: runs of disk clusters waiting for the volume's worker to
+ * read them into the buffer cache.  Requests past FAT32_RA_RUNS pending
+ * runs are dropped; they are only hints. */
+#define FAT32_RA_RUNS           8
+
+typedef struct {
+    uint32_t cluster;               /* First disk cluster */
+    uint32_t count;
+} Fat32RaRun;
+
+/* Runtime volume context */
+typedef struct Fat32Volume {
     BlockDevice *dev;               /* Underlying block device */
     uint8_t   sectors_per_cluster;
     uint32_t  bytes_per_cluster;
@@ -83,25 +154,116 @@ typedef struct {
     uint32_t  data_start;           /* First sector of data region */
     uint32_t  root_cluster;
     uint32_t  total_clusters;
-    uint32_t *fat;                  /* Cached FAT table */
     uint32_t  fat_sectors;          /* Number of sectors in one FAT */
-    int       fat_dirty;            /* Nonzero if FAT modified since last sync */
+    uint8_t   num_fats;             /* Copies of the FAT, kept identical */
+    Fat32FatPage fat_pages[FAT32_FAT_PAGES];
+    uint32_t  fat_hand;             /* CLOCK hand over fat_pages */
+    uint32_t  fat_last;             /* Slot used last: sequential scans stay there */
+    uint32_t  fat_dirty;            /* Pages with dirty sectors */
+    uint8_t  *free_map;             /* Bit per cluster, set if used or reserved;
+                                       built on the first allocation */
+    uint32_t  free_count;           /* Free clusters in the FAT, or FAT32_FREE_UNKNOWN */
+    uint32_t  next_free;            /* Allocation searches start here */
+    uint32_t  fsinfo_sector;        /* 0 if the volume has no valid FSInfo */
+    uint8_t   fsinfo_dirty;         /* free_count/next_free changed since sync */
+    Fat32Prealloc prealloc[FAT32_PREALLOC_SLOTS];
+    uint32_t  prealloc_hand;        /* Next slot to reuse when all are taken */
+    Fat32NodeInfo *node_hash[FAT32_NODE_HASH];
+    Fat32NodeInfo *lru_head;        /* Unreferenced nodes, most recently used */
+    Fat32NodeInfo *lru_tail;        /* Next to evict */
+    uint32_t  node_count;           /* Nodes in node_hash */
     VfsNode  *root_node;            /* VFS root for this volume */
+    Work      sync_work;            /* Deferred cluster and FAT write-back */
+    Fat32RaRun ra_runs[FAT32_RA_RUNS];
+    uint32_t  ra_count;
+    Work      ra_work;              /* Reads ra_runs into the buffer cache */
+    struct Fat32Volume *next;       /* Mounted volumes, for fat32_sync */
 } Fat32Volume;
 
-/* Per-node metadata (attached via VfsNode.private_data) */
+/* Writes leave dirty clusters in the buffer cache and FAT changes in
+ * memory.  The flusher writes clusters back once they are old enough; the
+ * FAT follows, after the clusters it links, the same age after the first
+ * change, so a burst of appends costs one flush.  fsync and sync write
+ * both at once. */
+#define FAT32_SYNC_DELAY_MS FLUSHER_DIRTY_AGE_MS
+
+/* A run of physically contiguous clusters in a file's chain */
 typedef struct {
+    uint32_t file_cluster;          /* Index of the run's first cluster in the file */
+    uint32_t disk_cluster;          /* Its cluster number on the volume */
+    uint32_t count;                 /* Clusters in the run */
+} Fat32Extent;
+
+/* A name in a directory index: open addressing, linear probing */
+#define FAT32_DIRNAME_EMPTY     0
+#define FAT32_DIRNAME_USED      1
+#define FAT32_DIRNAME_DELETED   2
+
+typedef struct {
+    uint8_t  name[11];              /* On-disk 8.3 name */
+    uint8_t  state;                 /* FAT32_DIRNAME_* */
+    uint32_t slot;                  /* Entry index in the directory */
+} Fat32DirName;
+
+/* In-memory index of a directory, built by one walk of its chain on
+ * first access and kept in step by create and unlink: the disk cluster
+ * of each link of the chain, the names hashed to their slots and the
+ * slots free for reuse.  Lookup and create are a hash probe instead of
+ * a scan of every entry, and an entry is reached without walking the
+ * chain. */
+typedef struct {
+    uint32_t     *clusters;         /* The chain, in order */
+    uint32_t      cluster_count;
+    uint32_t      cluster_cap;
+    Fat32DirName *names;            /* table_size slots, a power of two */
+    uint32_t      table_size;
+    uint32_t      used;             /* Names present */
+    uint32_t      deleted;          /* Tombstones, dropped when the table grows */
+    uint32_t     *free_slots;       /* Deleted entries, reused last-in first-out */
+    uint32_t      free_count;
+    uint32_t      free_cap;
+    uint32_t      end;              /* First slot never used: all past it are free */
+} Fat32DirIndex;
+
+/* Per-node metadata (attached via VfsNode.private_data).
+ *
+ * Regular files map file offsets to clusters through an extent list
+ * sorted by file_cluster, built from the FAT on first access and extended
+ * as writes grow the chain, so reaching any offset is a binary search
+ * rather than a walk from the first cluster.  Truncate and unlink drop
+ * it; the next access rebuilds it. */
+struct Fat32NodeInfo {
     Fat32Volume *vol;
+    VfsNode     *node;              /* The node this is attached to */
+    Fat32NodeInfo *hash_next;       /* Volume's node_hash chain */
+    Fat32NodeInfo *lru_prev;        /* Towards most recently used */
+    Fat32NodeInfo *lru_next;
+    uint32_t     refs;              /* Open files; unreferenced nodes are on the LRU */
+    uint8_t      cached;            /* In node_hash: cleared once unlinked */
+    uint8_t      orphan;            /* Unlinked while open: the chain goes with the last put */
     uint32_t     first_cluster;     /* First cluster of this file/dir */
-    uint32_t     dir_cluster;       /* Parent directory's first cluster */
+    uint32_t     dir_entry_cluster; /* Parent directory cluster holding the entry */
     uint32_t     dir_entry_idx;     /* Index within parent directory */
-} Fat32NodeInfo;
+    Fat32DirIndex *dir_index;       /* Directories only, NULL until first used */
+    Fat32Extent *extents;           /* Cluster map (files only) */
+    uint32_t     extent_count;
+    uint32_t     extent_cap;
+    uint32_t     mapped_clusters;   /* Clusters the map covers: the whole chain */
+    uint8_t      extents_valid;     /* Map matches the FAT */
+};
 
 /* Mount a FAT32 volume from the given block device.
  * Returns the root VfsNode, or NULL on failure. */
 VfsNode *fat32_mount(BlockDevice *dev);
 
-/* Flush dirty FAT sectors back to disk. Returns 0 on success. */
+/* Flush cached clusters and dirty FAT sectors of every mounted volume
+ * back to disk. Returns 0 on success. */
 int fat32_sync(void);
 
+/* Node references held by open files (the VfsOps ref/unref hooks) and
+ * the mount.  A node nobody references may be freed when its volume
+ * needs room. */
+void fat32_node_get(VfsNode *node);
+void fat32_node_put(VfsNode *node);
+
 #endif /* ARCHOS_FS_FAT32_H */
@@ -0,0 +1,79 @@
+/* arc_os — Buffer cache flusher thread */
+
+#include "fs/flusher.h"
+#include "fs/bcache.h"
+#include "mm/pmm.h"
+#include "proc/thread.h"
+#include "proc/sched.h"
+#include "proc/waitqueue.h"
+#include "proc/workqueue.h"
+#include "arch/x86_64/pit.h"
+#include "lib/kprintf.h"
+
+static WaitQueue flusher_wq = WAITQUEUE_INIT;
+static Spinlock flusher_lock = SPINLOCK_INIT;
+static int flusher_wanted;
+
+static void flusher_timer_fn(Work *work);
+static Work flusher_timer = WORK_INIT(flusher_timer_fn);
+
+/* Periodic tick: wake the thread and re-arm */
+static void flusher_timer_fn(Work *work) {
+    flusher_kick();
+    queue_delayed_work(work, FLUSHER_INTERVAL_MS);
+}
+
+void flusher_kick(void) {
+    spinlock_acquire(&flusher_lock);
+    flusher_wanted = 1;
+    spinlock_release(&flusher_lock);
+    wq_wake(&flusher_wq);
+}
+
+int flusher_run(uint64_t now_ms) {
+    uint32_t buffers, dirty;
+    uint64_t bytes;
+    bcache_get_usage(&buffers, &bytes, &dirty);
+    if (dirty == 0) return 0;
+
+    /* Dirty buffers cannot be recycled until written: under pressure,
+     * write them all rather than wait for them to age */
+    if (pmm_get_free_pages() < BCACHE_MIN_FREE_PAGES || dirty > BCACHE_DIRTY_HIGH) {
+        int rc = bcache_flush(NULL);
+        return rc != 0 ? rc : (int)dirty;
+    }
+    return bcache_flush_aged(now_ms, FLUSHER_DIRTY_AGE_MS);
+}
+
+/* Each pass runs in syscall context (interrupts off except while asleep),
+ * like the workqueue workers, since the filesystems rely on that */
+static void flusher_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        uint64_t flags = spin_irq_save();
+        spinlock_acquire(&flusher_lock);
+        while (!flusher_wanted) {
+            wq_sleep(&flusher_wq, &flusher_lock);
+            spinlock_acquire(&flusher_lock);
+        }
+        flusher_wanted = 0;
+        spinlock_release(&flusher_lock);
+
+        if (flusher_run(pit_get_uptime_ms()) < 0) {
+            kprintf("[FLUSH] Write-back failed; retrying next interval\n");
+        }
+        spin_irq_restore(flags);
+    }
+}
+
+void flusher_init(void) {
+    Thread *t = thread_create(flusher_main, NULL);
+    if (t == NULL) {
+        kprintf("[FLUSH] Failed to start flusher thread\n");
+        return;
+    }
+    sched_add_thread(t);
+    queue_delayed_work(&flusher_timer, FLUSHER_INTERVAL_MS);
+    kprintf("[FLUSH] Flusher started (every %u ms, age %u ms)\n",
+            (uint32_t)FLUSHER_INTERVAL_MS, (uint32_t)FLUSHER_DIRTY_AGE_MS);
+}
@@ -0,0 +1,27 @@
+#ifndef ARCHOS_FS_FLUSHER_H
+#define ARCHOS_FS_FLUSHER_H
+
+#include <stdint.h>
+
+/* Background write-back of the buffer cache.
+ *
+ * A kernel thread wakes every FLUSHER_INTERVAL_MS and writes back the
+ * buffers that have been dirty for FLUSHER_DIRTY_AGE_MS, so writes return
+ * as soon as the cache holds them and bursts of small writes to the same
+ * blocks reach the disk once.  When memory runs low, or more than
+ * BCACHE_DIRTY_HIGH buffers are dirty, it writes back everything.
+ * fsync and sync force write-back immediately. */
+
+#define FLUSHER_INTERVAL_MS   1000
+#define FLUSHER_DIRTY_AGE_MS  5000
+
+/* Start the flusher thread and its timer. Call after workqueue_init. */
+void flusher_init(void);
+
+/* Wake the flusher now instead of at its next interval. */
+void flusher_kick(void);
+
+/* One flusher pass at uptime now_ms. Returns buffers written or -EIO. */
+int flusher_run(uint64_t now_ms);
+
+#endif /* ARCHOS_FS_FLUSHER_H */
@@ -81,11 +81,15 @@ static int pipe_write(VfsNode *node, const void *buf, uint32_t offset, uint32_t
 }
 
 static const VfsOps pipe_read_ops = {
-    .read = pipe_read,
+    .read  = pipe_read,
+    .ref   = pipe_addref,
+    .unref = pipe_close,
 };
 
 static const VfsOps pipe_write_ops = {
     .write = pipe_write,
+    .ref   = pipe_addref,
+    .unref = pipe_close,
 };
 
 /* --- Public API --- */
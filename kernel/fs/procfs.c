@@ -3,6 +3,13 @@
 #include "mm/kmalloc.h"
 #include "arch/x86_64/pit.h"
 #include "proc/process.h"
+#include "proc/fd.h"
+#include "proc/pager.h"
+#include "fs/shmfs.h"
+#include "fs/bcache.h"
+#include "drivers/blkdev.h"
+#include "proc/sched.h"
+#include "proc/preempt.h"
 #include "lib/mem.h"
 #include "lib/string.h"
 
@@ -48,6 +55,10 @@ static int gen_meminfo(char *buf, int bufsz, void *ctx) {
     uint64_t free_kb = (free_pages * PAGE_SIZE) / 1024;
     HeapStats hs;
     kmalloc_get_stats(&hs);
+    PagerStats ps;
+    pager_get_stats(&ps);
+    ShmfsStats ss;
+    shmfs_get_stats(&ss);
 
     pos = procfs_append_str(buf, pos, bufsz, "MemTotal: ");
     pos = procfs_append_u64(buf, pos, bufsz, total_kb);
@@ -59,7 +70,17 @@ static int gen_meminfo(char *buf, int bufsz, void *ctx) {
     pos = procfs_append_u64(buf, pos, bufsz, hs.total_free);
     pos = procfs_append_str(buf, pos, bufsz, " B\nHeapMapped: ");
     pos = procfs_append_u64(buf, pos, bufsz, hs.heap_mapped);
-    pos = procfs_append_str(buf, pos, bufsz, " B\n");
+    pos = procfs_append_str(buf, pos, bufsz, " B\nExecCached: ");
+    pos = procfs_append_u64(buf, pos, bufsz, (ps.cached_pages * PAGE_SIZE) / 1024);
+    pos = procfs_append_str(buf, pos, bufsz, " kB\nSharedLib: ");
+    pos = procfs_append_u64(buf, pos, bufsz, (ps.lib_pages * PAGE_SIZE) / 1024);
+    pos = procfs_append_str(buf, pos, bufsz, " kB\nSharedLibMaps: ");
+    pos = procfs_append_u64(buf, pos, bufsz, ps.lib_maps);
+    pos = procfs_append_str(buf, pos, bufsz, "\nShmem: ");
+    pos = procfs_append_u64(buf, pos, bufsz, (ss.pages * PAGE_SIZE) / 1024);
+    pos = procfs_append_str(buf, pos, bufsz, " kB\nShmemObjects: ");
+    pos = procfs_append_u64(buf, pos, bufsz, ss.objects);
+    pos = procfs_append_str(buf, pos, bufsz, "\n");
 
     return pos;
 }
@@ -85,6 +106,59 @@ static int gen_uptime(char *buf, int bufsz, void *ctx) {
     return pos;
 }
 
+static int gen_preempt(char *buf, int bufsz, void *ctx) {
+    (void)ctx;
+    int pos = 0;
+    PreemptStats st;
+    preempt_get_stats(&st);
+
+    /* Longest time a due reschedule waited for a preemption point */
+    pos = procfs_append_str(buf, pos, bufsz, "Preemptions: ");
+    pos = procfs_append_u64(buf, pos, bufsz, st.count);
+    pos = procfs_append_str(buf, pos, bufsz, "\nMaxLatency: ");
+    pos = procfs_append_u64(buf, pos, bufsz, st.max_ns / 1000);
+    pos = procfs_append_str(buf, pos, bufsz, " us\nMaxSite: ");
+    pos = procfs_append_str(buf, pos, bufsz, st.max_site ? st.max_site : "none");
+    pos = procfs_append_str(buf, pos, bufsz, "\n");
+
+    return pos;
+}
+
+static int gen_bcache(char *buf, int bufsz, void *ctx) {
+    (void)ctx;
+    int pos = 0;
+    uint32_t buffers, dirty;
+    uint64_t bytes;
+    bcache_get_usage(&buffers, &bytes, &dirty);
+
+    pos = procfs_append_str(buf, pos, bufsz, "Buffers: ");
+    pos = procfs_append_u64(buf, pos, bufsz, buffers);
+    pos = procfs_append_str(buf, pos, bufsz, "\nCached: ");
+    pos = procfs_append_u64(buf, pos, bufsz, bytes / 1024);
+    pos = procfs_append_str(buf, pos, bufsz, " kB\nDirty: ");
+    pos = procfs_append_u64(buf, pos, bufsz, dirty);
+    pos = procfs_append_str(buf, pos, bufsz, "\n");
+
+    /* One line per registered block device */
+    for (int i = 0; i < BLKDEV_MAX; i++) {
+        BlockDevice *dev = blkdev_get(i);
+        if (dev == NULL) continue;
+        BcacheStats st;
+        bcache_get_stats(dev, &st);
+        pos = procfs_append_str(buf, pos, bufsz, "blk");
+        pos = procfs_append_u64(buf, pos, bufsz, (uint64_t)i);
+        pos = procfs_append_str(buf, pos, bufsz, ": hits ");
+        pos = procfs_append_u64(buf, pos, bufsz, st.hits);
+        pos = procfs_append_str(buf, pos, bufsz, " misses ");
+        pos = procfs_append_u64(buf, pos, bufsz, st.misses);
+        pos = procfs_append_str(buf, pos, bufsz, " writebacks ");
+        pos = procfs_append_u64(buf, pos, bufsz, st.writebacks);
+        pos = procfs_append_str(buf, pos, bufsz, "\n");
+    }
+
+    return pos;
+}
+
 static int gen_pid_status(char *buf, int bufsz, void *ctx) {
     uint32_t pid = (uint32_t)(uintptr_t)ctx;
     Process *p = proc_get_by_pid(pid);
@@ -118,6 +192,71 @@ static int gen_pid_status(char *buf, int bufsz, void *ctx) {
     return pos;
 }
 
+static int gen_pid_sched(char *buf, int bufsz, void *ctx) {
+    static const char *const lat_labels[SCHED_LAT_BUCKETS] = {
+        "<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms",
+    };
+    uint32_t pid = (uint32_t)(uintptr_t)ctx;
+    Process *p = proc_get_by_pid(pid);
+    if (p == NULL || p->main_thread == NULL) return 0;
+    const Thread *t = p->main_thread;
+
+    const char *policy_str;
+    switch (t->policy) {
+    case SCHED_FIFO: policy_str = "fifo"; break;
+    case SCHED_RR:   policy_str = "rr"; break;
+    default:         policy_str = "normal"; break;
+    }
+
+    int pos = 0;
+    pos = procfs_append_str(buf, pos, bufsz, "Policy: ");
+    pos = procfs_append_str(buf, pos, bufsz, policy_str);
+    pos = procfs_append_str(buf, pos, bufsz, "\nPriority: ");
+    pos = procfs_append_u64(buf, pos, bufsz, t->rt_priority);
+    pos = procfs_append_str(buf, pos, bufsz, "\nEffectivePriority: ");
+    pos = procfs_append_u64(buf, pos, bufsz, t->prio);
+
+    /* Wakeup latency, recorded while the thread is real-time */
+    pos = procfs_append_str(buf, pos, bufsz, "\nWakeups: ");
+    pos = procfs_append_u64(buf, pos, bufsz, t->latency.count);
+    pos = procfs_append_str(buf, pos, bufsz, "\nMaxLatency: ");
+    pos = procfs_append_u64(buf, pos, bufsz, t->latency.max_ns / 1000);
+    pos = procfs_append_str(buf, pos, bufsz, " us\n");
+    for (int i = 0; i < SCHED_LAT_BUCKETS; i++) {
+        pos = procfs_append_str(buf, pos, bufsz, "Latency");
+        pos = procfs_append_str(buf, pos, bufsz, lat_labels[i]);
+        pos = procfs_append_str(buf, pos, bufsz, ": ");
+        pos = procfs_append_u64(buf, pos, bufsz, t->latency.buckets[i]);
+        pos = procfs_append_str(buf, pos, bufsz, "\n");
+    }
+
+    return pos;
+}
+
+/* Readahead statistics of each open fd whose reads have been tracked */
+static int gen_pid_readahead(char *buf, int bufsz, void *ctx) {
+    uint32_t pid = (uint32_t)(uintptr_t)ctx;
+    Process *p = proc_get_by_pid(pid);
+    if (p == NULL || p->fd_table == NULL) return 0;
+
+    int pos = 0;
+    for (int fd = 0; fd < MAX_FDS; fd++) {
+        const FdEntry *e = &p->fd_table->entries[fd];
+        if (!e->in_use || e->file.ra.hits + e->file.ra.misses == 0) continue;
+        pos = procfs_append_str(buf, pos, bufsz, "fd ");
+        pos = procfs_append_u64(buf, pos, bufsz, (uint64_t)fd);
+        pos = procfs_append_str(buf, pos, bufsz, ": hits ");
+        pos = procfs_append_u64(buf, pos, bufsz, e->file.ra.hits);
+        pos = procfs_append_str(buf, pos, bufsz, " misses ");
+        pos = procfs_append_u64(buf, pos, bufsz, e->file.ra.misses);
+        pos = procfs_append_str(buf, pos, bufsz, " ahead ");
+        pos = procfs_append_u64(buf, pos, bufsz, e->file.ra.bytes);
+        pos = procfs_append_str(buf, pos, bufsz, "\n");
+    }
+
+    return pos;
+}
+
 /* --- Node types --- */
 
 typedef struct {
@@ -157,6 +296,8 @@ static const VfsOps procfs_file_ops = {
 
 static ProcfsFileNode meminfo_node;
 static ProcfsFileNode uptime_node;
+static ProcfsFileNode preempt_node;
+static ProcfsFileNode bcache_node;
 
 #define PROCFS_PID_POOL 8
 static ProcfsDirNode pid_dirs[PROCFS_PID_POOL];
@@ -168,21 +309,34 @@ static ProcfsDirNode procfs_root_node;
 
 /* --- Directory ops for /proc/[pid] --- */
 
+/* Files in each /proc/[pid] directory */
+static const struct {
+    const char   *name;
+    procfs_gen_fn generate;
+} pid_files[] = {
+    { "status", gen_pid_status },
+    { "sched",  gen_pid_sched },
+    { "readahead", gen_pid_readahead },
+};
+#define PROCFS_PID_FILES (sizeof(pid_files) / sizeof(pid_files[0]))
+
 static VfsNode *procfs_pid_lookup(VfsNode *dir, const char *name) {
     ProcfsDirNode *pd = (ProcfsDirNode *)dir;
-    if (strcmp(name, "status") != 0) return NULL;
+    uint32_t idx = 0;
+    while (idx < PROCFS_PID_FILES && strcmp(name, pid_files[idx].name) != 0) idx++;
+    if (idx == PROCFS_PID_FILES) return NULL;
 
     int slot = pid_status_next % PROCFS_PID_POOL;
     pid_status_next++;
 
     ProcfsFileNode *fn = &pid_status_nodes[slot];
-    fn->vnode.inode_num = 3000 + pd->pid * 10 + 1;
+    fn->vnode.inode_num = 3000 + pd->pid * 10 + 1 + idx;
     fn->vnode.type = VFS_FILE;
     fn->vnode.size = 0;
     fn->vnode.mode = 0444;
     fn->vnode.ops = &procfs_file_ops;
     fn->vnode.private_data = fn;
-    fn->generate = gen_pid_status;
+    fn->generate = pid_files[idx].generate;
     fn->gen_ctx = (void *)(uintptr_t)pd->pid;
 
     return &fn->vnode;
@@ -190,12 +344,14 @@ static VfsNode *procfs_pid_lookup(VfsNode *dir, const char *name) {
 
 static int procfs_pid_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
     (void)dir;
-    if (max < 1) return 0;
-    strncpy(entries[0].name, "status", VFS_NAME_MAX - 1);
-    entries[0].name[VFS_NAME_MAX - 1] = '\0';
-    entries[0].inode_num = 0;
-    entries[0].type = VFS_FILE;
-    return 1;
+    uint32_t count = 0;
+    for (; count < PROCFS_PID_FILES && count < max; count++) {
+        strncpy(entries[count].name, pid_files[count].name, VFS_NAME_MAX - 1);
+        entries[count].name[VFS_NAME_MAX - 1] = '\0';
+        entries[count].inode_num = 0;
+        entries[count].type = VFS_FILE;
+    }
+    return (int)count;
 }
 
 static const VfsOps procfs_pid_dir_ops = {
@@ -221,6 +377,8 @@ static VfsNode *procfs_root_lookup(VfsNode *dir, const char *name) {
     (void)dir;
     if (strcmp(name, "meminfo") == 0) return &meminfo_node.vnode;
     if (strcmp(name, "uptime") == 0) return &uptime_node.vnode;
+    if (strcmp(name, "preempt") == 0) return &preempt_node.vnode;
+    if (strcmp(name, "bcache") == 0) return &bcache_node.vnode;
 
     uint32_t pid;
     if (procfs_parse_uint(name, &pid) != 0) return NULL;
@@ -299,6 +457,20 @@ static int procfs_root_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max)
         entries[count].type = VFS_FILE;
         count++;
     }
+    if (count < max) {
+        strncpy(entries[count].name, "preempt", VFS_NAME_MAX - 1);
+        entries[count].name[VFS_NAME_MAX - 1] = '\0';
+        entries[count].inode_num = preempt_node.vnode.inode_num;
+        entries[count].type = VFS_FILE;
+        count++;
+    }
+    if (count < max) {
+        strncpy(entries[count].name, "bcache", VFS_NAME_MAX - 1);
+        entries[count].name[VFS_NAME_MAX - 1] = '\0';
+        entries[count].inode_num = bcache_node.vnode.inode_num;
+        entries[count].type = VFS_FILE;
+        count++;
+    }
 
     struct procfs_readdir_ctx ctx = { entries, max, count };
     proc_foreach(procfs_enum_pid, &ctx);
@@ -336,6 +508,8 @@ VfsNode *procfs_init(void) {
 
     procfs_init_file(&meminfo_node, 2001, gen_meminfo, NULL);
     procfs_init_file(&uptime_node, 2002, gen_uptime, NULL);
+    procfs_init_file(&preempt_node, 2003, gen_preempt, NULL);
+    procfs_init_file(&bcache_node, 2004, gen_bcache, NULL);
 
     pid_dirs_next = 0;
     pid_status_next = 0;
@@ -1,23 +1,55 @@
 #include "fs/ramfs.h"
+#include "mm/pmm.h"
+#include "mm/vmm.h"
 #include "mm/kmalloc.h"
 #include "lib/mem.h"
 #include "lib/string.h"
 
 #define RAMFS_NAME_MAX     255
-#define RAMFS_INIT_CAP     512    /* Initial file data capacity */
-#define RAMFS_MAX_CHILDREN 128    /* Max entries per directory */
+#define RAMFS_DIR_MIN      16     /* Initial hash buckets and slots */
+
+/* File data lives in page frames indexed by a radix tree of
+ * RAMFS_RADIX_SLOTS-way nodes. A tree of height 0 is at most the single
+ * page 0; each level multiplies the pages covered by RAMFS_RADIX_SLOTS.
+ * Missing pages are holes and read as zeros. */
+#define RAMFS_RADIX_SHIFT  6
+#define RAMFS_RADIX_SLOTS  (1U << RAMFS_RADIX_SHIFT)
+#define RAMFS_RADIX_MASK   (RAMFS_RADIX_SLOTS - 1)
+
+typedef struct {
+    void *slots[RAMFS_RADIX_SLOTS];   /* Child nodes, or pages at the bottom */
+} RamfsRadix;
 
 typedef struct RamfsDirEntry {
-    char name[RAMFS_NAME_MAX + 1];
-    struct RamfsNode *node;
+    struct RamfsDirEntry *hash_next;   /* Bucket chain */
+    struct RamfsNode     *node;
+    uint64_t              pos;         /* readdir cursor position */
+    uint32_t              hash;
+    uint32_t              slot;        /* Index in RamfsDir.order */
+    char                  name[];      /* Allocated to fit */
 } RamfsDirEntry;
 
+/* A directory's entries, hashed by name and kept in creation order for
+ * readdir. Unlinking leaves a NULL slot in order[], squeezed out when the
+ * array fills up or is mostly unused. Entries keep the pos they were created
+ * with, so a readdir cursor (the next pos to return) stays valid across
+ * creates and unlinks. */
+typedef struct {
+    RamfsDirEntry **buckets;
+    uint32_t        nbuckets;     /* Power of two, 0 until the first entry */
+    RamfsDirEntry **order;
+    uint32_t        order_len;
+    uint32_t        order_cap;
+    uint32_t        count;        /* Entries */
+    uint64_t        next_pos;
+} RamfsDir;
+
 typedef struct RamfsNode {
     VfsNode          vnode;        /* Embedded VFS node */
-    uint8_t         *data;         /* File content (NULL for dirs) */
-    uint32_t         capacity;     /* Allocated data capacity */
-    RamfsDirEntry   *children;     /* Directory children array (NULL for files) */
-    uint32_t         num_children;
+    void            *pages;        /* Radix tree root, or page 0 at height 0 */
+    uint32_t         height;       /* Levels of RamfsRadix above the pages */
+    uint64_t         nr_pages;     /* Page frames held */
+    RamfsDir        *dir;          /* Directory entries (NULL for files) */
 } RamfsNode;
 
 static uint64_t next_inode = 1;
@@ -29,16 +61,18 @@ static VfsNode *ramfs_lookup(VfsNode *dir, const char *name);
 static VfsNode *ramfs_create(VfsNode *dir, const char *name, uint8_t type);
 static int ramfs_unlink(VfsNode *dir, const char *name);
 static int ramfs_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max);
+static int ramfs_readdir_at(VfsNode *dir, uint64_t *cursor, VfsDirEntry *entries, uint32_t max);
 static void ramfs_truncate(VfsNode *node, uint64_t size);
 
 static const VfsOps ramfs_ops = {
-    .read     = ramfs_read,
-    .write    = ramfs_write,
-    .lookup   = ramfs_lookup,
-    .create   = ramfs_create,
-    .unlink   = ramfs_unlink,
-    .readdir  = ramfs_readdir,
-    .truncate = ramfs_truncate,
+    .read       = ramfs_read,
+    .write      = ramfs_write,
+    .lookup     = ramfs_lookup,
+    .create     = ramfs_create,
+    .unlink     = ramfs_unlink,
+    .readdir    = ramfs_readdir,
+    .truncate   = ramfs_truncate,
+    .readdir_at = ramfs_readdir_at,
 };
 
 /* Get the RamfsNode from a VfsNode (they share the same address) */
@@ -56,8 +90,9 @@ static RamfsNode *ramfs_alloc_node(uint8_t type) {
     rn->vnode.private_data = rn;
 
     if (type == VFS_DIRECTORY) {
-        rn->children = kmalloc(sizeof(RamfsDirEntry) * RAMFS_MAX_CHILDREN, GFP_ZERO);
-        if (rn->children == NULL) {
+        rn->vnode.flags = VFS_NODE_DCACHE;
+        rn->dir = kmalloc(sizeof(RamfsDir), GFP_ZERO);
+        if (rn->dir == NULL) {
             kfree(rn);
             return NULL;
         }
@@ -66,146 +101,392 @@ static RamfsNode *ramfs_alloc_node(uint8_t type) {
     return rn;
 }
 
+/* --- File pages --- */
+
+static uint8_t *page_ptr(uint64_t phys) {
+    return (uint8_t *)(phys + vmm_get_hhdm_offset());
+}
+
+/* Pages covered by a tree of the given height */
+static uint64_t ramfs_span(uint32_t height) {
+    return 1ULL << (RAMFS_RADIX_SHIFT * height);
+}
+
+/* Slot for page `index` in a node `height` levels above the pages */
+static uint32_t ramfs_slot(uint64_t index, uint32_t height) {
+    return (uint32_t)(index >> (RAMFS_RADIX_SHIFT * (height - 1))) & RAMFS_RADIX_MASK;
+}
+
+/* The page holding file page `index`, or NULL for a hole */
+static uint8_t *ramfs_page_find(RamfsNode *rn, uint64_t index) {
+    if (index >= ramfs_span(rn->height)) return NULL;
+    void *slot = rn->pages;
+    for (uint32_t h = rn->height; h > 0 && slot != NULL; h--) {
+        slot = ((RamfsRadix *)slot)->slots[ramfs_slot(index, h)];
+    }
+    return slot;
+}
+
+/* The page holding file page `index`, filling a hole with a zeroed page
+ * (and the tree above it) first. NULL when out of memory. */
+static uint8_t *ramfs_page_get(RamfsNode *rn, uint64_t index) {
+    while (index >= ramfs_span(rn->height)) {
+        if (rn->pages != NULL) {
+            RamfsRadix *top = kmalloc(sizeof(RamfsRadix), GFP_ZERO);
+            if (top == NULL) return NULL;
+            top->slots[0] = rn->pages;
+            rn->pages = top;
+        }
+        rn->height++;
+    }
+
+    void **slot = &rn->pages;
+    for (uint32_t h = rn->height; h > 0; h--) {
+        if (*slot == NULL) {
+            *slot = kmalloc(sizeof(RamfsRadix), GFP_ZERO);
+            if (*slot == NULL) return NULL;
+        }
+        slot = &((RamfsRadix *)*slot)->slots[ramfs_slot(index, h)];
+    }
+    if (*slot == NULL) {
+        uint64_t phys = pmm_alloc_page();
+        if (phys == 0) return NULL;
+        memset(page_ptr(phys), 0, PAGE_SIZE);
+        *slot = page_ptr(phys);
+        rn->nr_pages++;
+    }
+    return *slot;
+}
+
+/* Free the pages from `first` on in the subtree at *slot, which covers
+ * the pages from `base`. Returns 1 if the subtree is now empty (and has
+ * been freed itself). */
+static int ramfs_free_subtree(RamfsNode *rn, void **slot, uint32_t height,
+                              uint64_t base, uint64_t first) {
+    if (*slot == NULL) return 1;
+    if (height == 0) {
+        if (base < first) return 0;
+        pmm_free_page((uint64_t)(uintptr_t)*slot - vmm_get_hhdm_offset());
+        *slot = NULL;
+        rn->nr_pages--;
+        return 1;
+    }
+
+    RamfsRadix *node = *slot;
+    uint64_t span = ramfs_span(height - 1);
+    int empty = 1;
+    for (uint32_t i = 0; i < RAMFS_RADIX_SLOTS; i++) {
+        uint64_t child = base + i * span;
+        if (child + span > first) {
+            if (!ramfs_free_subtree(rn, &node->slots[i], height - 1, child, first)) empty = 0;
+        } else if (node->slots[i] != NULL) {
+            empty = 0;
+        }
+    }
+    if (empty) {
+        kfree(node);
+        *slot = NULL;
+    }
+    return empty;
+}
+
+/* Free every page from `first` on, then drop top levels that only lead
+ * to their first slot */
+static void ramfs_free_pages(RamfsNode *rn, uint64_t first) {
+    ramfs_free_subtree(rn, &rn->pages, rn->height, 0, first);
+    if (rn->pages == NULL) {
+        rn->height = 0;
+        return;
+    }
+    while (rn->height > 0) {
+        RamfsRadix *top = rn->pages;
+        uint32_t i = 1;
+        while (i < RAMFS_RADIX_SLOTS && top->slots[i] == NULL) i++;
+        if (i < RAMFS_RADIX_SLOTS) break;
+        rn->pages = top->slots[0];
+        rn->height--;
+        kfree(top);
+    }
+}
+
+/* --- File ops --- */
+
 static int ramfs_read(VfsNode *node, void *buf, uint32_t offset, uint32_t size) {
     RamfsNode *rn = to_ramfs(node);
     if (node->type != VFS_FILE) return -EISDIR;
     if (offset >= node->size) return 0;
-
-    uint32_t avail = (uint32_t)(node->size - offset);
-    uint32_t to_read = (size < avail) ? size : avail;
-    memcpy(buf, rn->data + offset, to_read);
-    return (int)to_read;
+    if (size > node->size - offset) size = (uint32_t)(node->size - offset);
+
+    uint32_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)offset + done;
+        uint32_t in_page = (uint32_t)(pos % PAGE_SIZE);
+        uint32_t chunk = PAGE_SIZE - in_page;
+        if (chunk > size - done) chunk = size - done;
+        const uint8_t *page = ramfs_page_find(rn, pos / PAGE_SIZE);
+        if (page != NULL) {
+            memcpy((uint8_t *)buf + done, page + in_page, chunk);
+        } else {
+            memset((uint8_t *)buf + done, 0, chunk);
+        }
+        done += chunk;
+    }
+    return (int)size;
 }
 
+/* Only the pages written to are allocated; a short count means memory
+ * ran out part way */
 static int ramfs_write(VfsNode *node, const void *buf, uint32_t offset, uint32_t size) {
     RamfsNode *rn = to_ramfs(node);
     if (node->type != VFS_FILE) return -EISDIR;
 
-    uint32_t end = offset + size;
+    uint32_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)offset + done;
+        uint32_t in_page = (uint32_t)(pos % PAGE_SIZE);
+        uint32_t chunk = PAGE_SIZE - in_page;
+        if (chunk > size - done) chunk = size - done;
+        uint8_t *page = ramfs_page_get(rn, pos / PAGE_SIZE);
+        if (page == NULL) break;
+        memcpy(page + in_page, (const uint8_t *)buf + done, chunk);
+        done += chunk;
+    }
+    if (done == 0 && size > 0) return -ENOMEM;
 
-    /* Grow buffer if needed */
-    if (end > rn->capacity) {
-        uint32_t new_cap = rn->capacity ? rn->capacity : RAMFS_INIT_CAP;
-        while (new_cap < end) {
-            new_cap *= 2;
-        }
-        uint8_t *new_data = krealloc(rn->data, new_cap);
-        if (new_data == NULL) return -ENOMEM;
-        /* Zero the gap between old capacity and new capacity */
-        if (new_cap > rn->capacity) {
-            memset(new_data + rn->capacity, 0, new_cap - rn->capacity);
+    if ((uint64_t)offset + done > node->size) {
+        node->size = (uint64_t)offset + done;
+    }
+
+    return (int)done;
+}
+
+/* --- Directories --- */
+
+static uint32_t ramfs_name_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    while (*name) h = (h ^ (uint8_t)*name++) * 16777619u;    /* FNV-1a */
+    return h;
+}
+
+/* The chain link pointing at the entry for `name`, or NULL */
+static RamfsDirEntry **ramfs_find_child(RamfsDir *d, const char *name) {
+    if (d->nbuckets == 0) return NULL;
+    uint32_t h = ramfs_name_hash(name);
+    RamfsDirEntry **link = &d->buckets[h & (d->nbuckets - 1)];
+    while (*link != NULL && ((*link)->hash != h || strcmp((*link)->name, name) != 0)) {
+        link = &(*link)->hash_next;
+    }
+    return (*link != NULL) ? link : NULL;
+}
+
+static int ramfs_dir_rehash(RamfsDir *d, uint32_t nbuckets) {
+    RamfsDirEntry **buckets = kmalloc(nbuckets * sizeof(RamfsDirEntry *), GFP_ZERO);
+    if (buckets == NULL) return -ENOMEM;
+    for (uint32_t i = 0; i < d->nbuckets; i++) {
+        RamfsDirEntry *e = d->buckets[i];
+        while (e != NULL) {
+            RamfsDirEntry *next = e->hash_next;
+            uint32_t b = e->hash & (nbuckets - 1);
+            e->hash_next = buckets[b];
+            buckets[b] = e;
+            e = next;
         }
-        rn->data = new_data;
-        rn->capacity = new_cap;
     }
+    kfree(d->buckets);
+    d->buckets = buckets;
+    d->nbuckets = nbuckets;
+    return 0;
+}
+
+/* Close up the unlinked slots of order[] */
+static void ramfs_dir_squeeze(RamfsDir *d) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < d->order_len; i++) {
+        if (d->order[i] == NULL) continue;
+        d->order[i]->slot = n;
+        d->order[n++] = d->order[i];
+    }
+    d->order_len = n;
+}
 
-    memcpy(rn->data + offset, buf, size);
+/* Room for one more slot at the end of order[]: squeeze out the unlinked
+ * ones if they are at least half, else grow the array */
+static int ramfs_dir_reserve(RamfsDir *d) {
+    if (d->order_len < d->order_cap) return 0;
+    if (d->order_len > 0 && d->count * 2 <= d->order_len) {
+        ramfs_dir_squeeze(d);
+        return 0;
+    }
+    uint32_t cap = d->order_cap ? d->order_cap * 2 : RAMFS_DIR_MIN;
+    RamfsDirEntry **order = krealloc(d->order, cap * sizeof(RamfsDirEntry *));
+    if (order == NULL) return -ENOMEM;
+    d->order = order;
+    d->order_cap = cap;
+    return 0;
+}
 
-    if (end > node->size) {
-        node->size = end;
+static int ramfs_dir_add(RamfsDir *d, const char *name, RamfsNode *node) {
+    /* Keep chains about one entry long; a failed grow only lengthens them */
+    if (d->count + 1 > d->nbuckets &&
+        ramfs_dir_rehash(d, d->nbuckets ? d->nbuckets * 2 : RAMFS_DIR_MIN) != 0 &&
+        d->nbuckets == 0) {
+        return -ENOMEM;
     }
+    if (ramfs_dir_reserve(d) != 0) return -ENOMEM;
+
+    size_t len = strlen(name);
+    if (len > RAMFS_NAME_MAX) len = RAMFS_NAME_MAX;
+    RamfsDirEntry *e = kmalloc(sizeof(RamfsDirEntry) + len + 1, 0);
+    if (e == NULL) return -ENOMEM;
+    memcpy(e->name, name, len);
+    e->name[len] = '\0';
+    e->node = node;
+    e->hash = ramfs_name_hash(e->name);
+    e->pos = d->next_pos++;
+    e->slot = d->order_len;
+    d->order[d->order_len++] = e;
+
+    uint32_t b = e->hash & (d->nbuckets - 1);
+    e->hash_next = d->buckets[b];
+    d->buckets[b] = e;
+    d->count++;
+    return 0;
+}
 
-    return (int)size;
+/* Unlink the entry `link` points at and free it (not its node) */
+static void ramfs_dir_remove(RamfsDir *d, RamfsDirEntry **link) {
+    RamfsDirEntry *e = *link;
+    *link = e->hash_next;
+    d->order[e->slot] = NULL;
+    while (d->order_len > 0 && d->order[d->order_len - 1] == NULL) d->order_len--;
+    d->count--;
+    kfree(e);
+
+    /* Shrink both tables once three quarters unused; best effort */
+    if (d->nbuckets > RAMFS_DIR_MIN && d->count < d->nbuckets / 4) {
+        ramfs_dir_rehash(d, d->nbuckets / 2);
+    }
+    if (d->order_cap > RAMFS_DIR_MIN && d->count < d->order_cap / 4) {
+        ramfs_dir_squeeze(d);
+        RamfsDirEntry **order = krealloc(d->order, d->order_cap / 2 * sizeof(RamfsDirEntry *));
+        if (order != NULL) {
+            d->order = order;
+            d->order_cap /= 2;
+        }
+    }
+}
+
+/* First slot of order[] whose entry has pos >= cursor, skipping unlinked
+ * slots; positions only grow along the array */
+static uint32_t ramfs_dir_seek(const RamfsDir *d, uint64_t cursor) {
+    uint32_t lo = 0, hi = d->order_len;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t m = mid;
+        while (m < hi && d->order[m] == NULL) m++;
+        if (m < hi && d->order[m]->pos < cursor) {
+            lo = m + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
 }
 
-/* Find child by name in a directory, return index or UINT32_MAX if not found */
-static uint32_t ramfs_find_child(RamfsNode *parent, const char *name) {
-    for (uint32_t i = 0; i < parent->num_children; i++) {
-        if (strcmp(parent->children[i].name, name) == 0) return i;
+/* Free a ramfs node and its owned buffers */
+static void ramfs_free_node(RamfsNode *rn) {
+    ramfs_free_pages(rn, 0);
+    if (rn->dir) {
+        kfree(rn->dir->buckets);
+        kfree(rn->dir->order);
+        kfree(rn->dir);
     }
-    return UINT32_MAX;
+    kfree(rn);
 }
 
 static VfsNode *ramfs_lookup(VfsNode *dir, const char *name) {
     RamfsNode *rn = to_ramfs(dir);
     if (dir->type != VFS_DIRECTORY) return NULL;
 
-    uint32_t idx = ramfs_find_child(rn, name);
-    if (idx == UINT32_MAX) return NULL;
-    return &rn->children[idx].node->vnode;
+    RamfsDirEntry **link = ramfs_find_child(rn->dir, name);
+    if (link == NULL) return NULL;
+    return &(*link)->node->vnode;
 }
 
 static VfsNode *ramfs_create(VfsNode *dir, const char *name, uint8_t type) {
     RamfsNode *parent = to_ramfs(dir);
     if (dir->type != VFS_DIRECTORY) return NULL;
-    if (parent->num_children >= RAMFS_MAX_CHILDREN) return NULL;
 
     /* Check for duplicate */
     if (ramfs_lookup(dir, name) != NULL) return NULL;
 
     RamfsNode *child = ramfs_alloc_node(type);
     if (child == NULL) return NULL;
-
-    RamfsDirEntry *entry = &parent->children[parent->num_children];
-    strncpy(entry->name, name, RAMFS_NAME_MAX);
-    entry->name[RAMFS_NAME_MAX] = '\0';
-    entry->node = child;
-    parent->num_children++;
+    if (ramfs_dir_add(parent->dir, name, child) != 0) {
+        ramfs_free_node(child);
+        return NULL;
+    }
 
     return &child->vnode;
 }
 
-/* Free a ramfs node and its owned buffers */
-static void ramfs_free_node(RamfsNode *rn) {
-    if (rn->data) kfree(rn->data);
-    if (rn->children) kfree(rn->children);
-    kfree(rn);
-}
-
 static int ramfs_unlink(VfsNode *dir, const char *name) {
     RamfsNode *parent = to_ramfs(dir);
     if (dir->type != VFS_DIRECTORY) return -ENOTDIR;
 
-    uint32_t idx = ramfs_find_child(parent, name);
-    if (idx == UINT32_MAX) return -ENOENT;
+    RamfsDirEntry **link = ramfs_find_child(parent->dir, name);
+    if (link == NULL) return -ENOENT;
 
-    RamfsNode *child = parent->children[idx].node;
+    RamfsNode *child = (*link)->node;
 
     /* Don't unlink non-empty directories */
-    if (child->vnode.type == VFS_DIRECTORY && child->num_children > 0) {
+    if (child->vnode.type == VFS_DIRECTORY && child->dir->count > 0) {
         return -ENOTEMPTY;
     }
 
+    ramfs_dir_remove(parent->dir, link);
     ramfs_free_node(child);
 
-    /* Compact the children array */
-    for (uint32_t j = idx; j + 1 < parent->num_children; j++) {
-        parent->children[j] = parent->children[j + 1];
-    }
-    parent->num_children--;
-
     return VFS_OK;
 }
 
-static int ramfs_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
+static int ramfs_readdir_at(VfsNode *dir, uint64_t *cursor, VfsDirEntry *entries, uint32_t max) {
     RamfsNode *rn = to_ramfs(dir);
     if (dir->type != VFS_DIRECTORY) return -ENOTDIR;
 
-    uint32_t count = (rn->num_children < max) ? rn->num_children : max;
-    for (uint32_t i = 0; i < count; i++) {
-        strncpy(entries[i].name, rn->children[i].name, RAMFS_NAME_MAX);
-        entries[i].name[RAMFS_NAME_MAX] = '\0';
-        entries[i].inode_num = rn->children[i].node->vnode.inode_num;
-        entries[i].type = rn->children[i].node->vnode.type;
+    const RamfsDir *d = rn->dir;
+    uint32_t count = 0;
+    for (uint32_t i = ramfs_dir_seek(d, *cursor); i < d->order_len && count < max; i++) {
+        const RamfsDirEntry *e = d->order[i];
+        if (e == NULL) continue;
+        strncpy(entries[count].name, e->name, RAMFS_NAME_MAX);
+        entries[count].name[RAMFS_NAME_MAX] = '\0';
+        entries[count].inode_num = e->node->vnode.inode_num;
+        entries[count].type = e->node->vnode.type;
+        count++;
+        *cursor = e->pos + 1;
     }
 
     return (int)count;
 }
 
+static int ramfs_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
+    uint64_t cursor = 0;
+    return ramfs_readdir_at(dir, &cursor, entries, max);
+}
+
+/* Shrinking frees the pages wholly past the new end and zeroes the rest
+ * of the last one; growing leaves a hole */
 static void ramfs_truncate(VfsNode *node, uint64_t size) {
     RamfsNode *rn = to_ramfs(node);
     if (node->type != VFS_FILE) return;
 
-    if (size == 0) {
-        if (rn->data) {
-            kfree(rn->data);
-            rn->data = NULL;
-        }
-        rn->capacity = 0;
-        node->size = 0;
-    } else if (size < node->size) {
-        node->size = size;
+    if (size < node->size) {
+        ramfs_free_pages(rn, (size + PAGE_SIZE - 1) / PAGE_SIZE);
+        uint8_t *last = (size % PAGE_SIZE) ? ramfs_page_find(rn, size / PAGE_SIZE) : NULL;
+        if (last != NULL) memset(last + size % PAGE_SIZE, 0, PAGE_SIZE - size % PAGE_SIZE);
     }
+    node->size = size;
 }
 
 VfsNode *ramfs_init(void) {
@@ -0,0 +1,316 @@
+/* arc_os — /dev/shm: POSIX shared memory objects
+ *
+ * Objects are kept in a flat table; /dev/shm has no subdirectories.  The
+ * table, names and reference counts are under shm_lock.  Like ramfs, data
+ * reads and writes are not serialized against each other. */
+
+#include "fs/shmfs.h"
+#include "mm/pmm.h"
+#include "mm/vmm.h"
+#include "mm/kmalloc.h"
+#include "proc/spinlock.h"
+#include "lib/mem.h"
+#include "lib/string.h"
+
+#define SHMFS_NAME_MAX  255
+
+typedef struct {
+    VfsNode   vnode;
+    char      name[SHMFS_NAME_MAX + 1];
+    uint8_t   linked;       /* Still named in /dev/shm */
+    uint32_t  refs;         /* Open file descriptors and mappings */
+    uint32_t  maps;         /* Mappings, of those */
+    uint64_t  nr_pages;     /* Length of pages[] */
+    uint64_t *pages;        /* Frame of each page, or 0 (reads as zeros) */
+} ShmObject;
+
+static VfsNode    shm_root;
+static ShmObject *objects[SHMFS_MAX_OBJECTS];
+static Spinlock   shm_lock = SPINLOCK_INIT;
+static uint64_t   next_inode;
+static ShmfsStats stats;
+
+static const VfsOps shmfs_file_ops;
+
+static ShmObject *to_shm(VfsNode *node) {
+    return (ShmObject *)node->private_data;
+}
+
+static uint8_t *frame_ptr(uint64_t phys) {
+    return (uint8_t *)(phys + vmm_get_hhdm_offset());
+}
+
+/* --- Objects --- */
+
+static int shmfs_find(const char *name) {
+    for (int i = 0; i < SHMFS_MAX_OBJECTS; i++) {
+        if (objects[i] && objects[i]->linked && strcmp(objects[i]->name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Free frames from page `first` on and shorten pages[] to end there */
+static void shmfs_free_pages(ShmObject *obj, uint64_t first) {
+    for (uint64_t i = first; i < obj->nr_pages; i++) {
+        if (obj->pages[i]) {
+            pmm_free_page(obj->pages[i]);
+            stats.pages--;
+        }
+    }
+    if (first < obj->nr_pages) obj->nr_pages = first;
+}
+
+/* Free obj once it has no name, fd or mapping left (shm_lock held) */
+static void shmfs_maybe_free(ShmObject *obj) {
+    if (obj->linked || obj->refs > 0) return;
+    for (int i = 0; i < SHMFS_MAX_OBJECTS; i++) {
+        if (objects[i] == obj) objects[i] = NULL;
+    }
+    shmfs_free_pages(obj, 0);
+    kfree(obj->pages);
+    kfree(obj);
+    stats.objects--;
+}
+
+/* Grow pages[] to cover at least n pages */
+static int shmfs_reserve(ShmObject *obj, uint64_t n) {
+    if (n <= obj->nr_pages) return 0;
+    uint64_t *pages = krealloc(obj->pages, n * sizeof(uint64_t));
+    if (pages == NULL) return -ENOMEM;
+    memset(pages + obj->nr_pages, 0, (n - obj->nr_pages) * sizeof(uint64_t));
+    obj->pages = pages;
+    obj->nr_pages = n;
+    return 0;
+}
+
+uint64_t shmfs_frame(VfsNode *node, uint64_t index) {
+    ShmObject *obj = to_shm(node);
+    if (shmfs_reserve(obj, index + 1) != 0) return 0;
+    if (obj->pages[index] == 0) {
+        uint64_t phys = pmm_alloc_page();
+        if (phys == 0) return 0;
+        memset(frame_ptr(phys), 0, PAGE_SIZE);
+        obj->pages[index] = phys;
+        stats.pages++;
+    }
+    return obj->pages[index];
+}
+
+/* --- File ops --- */
+
+static int shmfs_read(VfsNode *node, void *buf, uint32_t offset, uint32_t size) {
+    ShmObject *obj = to_shm(node);
+    if (offset >= node->size) return 0;
+    if (size > node->size - offset) size = (uint32_t)(node->size - offset);
+
+    uint32_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)offset + done;
+        uint64_t index = pos / PAGE_SIZE;
+        uint32_t in_page = (uint32_t)(pos % PAGE_SIZE);
+        uint32_t chunk = PAGE_SIZE - in_page;
+        if (chunk > size - done) chunk = size - done;
+
+        uint64_t phys = (index < obj->nr_pages) ? obj->pages[index] : 0;
+        if (phys) {
+            memcpy((uint8_t *)buf + done, frame_ptr(phys) + in_page, chunk);
+        } else {
+            memset((uint8_t *)buf + done, 0, chunk);
+        }
+        done += chunk;
+    }
+    return (int)done;
+}
+
+static int shmfs_write(VfsNode *node, const void *buf, uint32_t offset, uint32_t size) {
+    uint32_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)offset + done;
+        uint32_t in_page = (uint32_t)(pos % PAGE_SIZE);
+        uint32_t chunk = PAGE_SIZE - in_page;
+        if (chunk > size - done) chunk = size - done;
+
+        uint64_t phys = shmfs_frame(node, pos / PAGE_SIZE);
+        if (phys == 0) break;
+        memcpy(frame_ptr(phys) + in_page, (const uint8_t *)buf + done, chunk);
+        done += chunk;
+    }
+    if (done == 0 && size > 0) return -ENOMEM;
+
+    if ((uint64_t)offset + done > node->size) node->size = (uint64_t)offset + done;
+    return (int)done;
+}
+
+static void shmfs_truncate(VfsNode *node, uint64_t size) {
+    ShmObject *obj = to_shm(node);
+    if (size < node->size) {
+        /* Bytes past the new end read as zeros if the object grows again */
+        uint64_t keep = PAGE_ALIGN_UP(size) / PAGE_SIZE;
+        uint32_t tail = (uint32_t)(size % PAGE_SIZE);
+        if (tail != 0 && keep - 1 < obj->nr_pages && obj->pages[keep - 1]) {
+            memset(frame_ptr(obj->pages[keep - 1]) + tail, 0, PAGE_SIZE - tail);
+        }
+
+        spinlock_acquire(&shm_lock);
+        if (obj->maps == 0) {
+            shmfs_free_pages(obj, keep);
+        } else {
+            /* Other processes may still have the frames mapped */
+            for (uint64_t i = keep; i < obj->nr_pages; i++) {
+                if (obj->pages[i]) memset(frame_ptr(obj->pages[i]), 0, PAGE_SIZE);
+            }
+        }
+        spinlock_release(&shm_lock);
+    }
+    node->size = size;
+}
+
+static const VfsOps shmfs_file_ops = {
+    .read     = shmfs_read,
+    .write    = shmfs_write,
+    .truncate = shmfs_truncate,
+    .ref      = shmfs_get,
+    .unref    = shmfs_put,
+};
+
+/* --- Directory ops --- */
+
+static VfsNode *shmfs_lookup(VfsNode *dir, const char *name) {
+    (void)dir;
+    spinlock_acquire(&shm_lock);
+    int i = shmfs_find(name);
+    VfsNode *node = (i >= 0) ? &objects[i]->vnode : NULL;
+    spinlock_release(&shm_lock);
+    return node;
+}
+
+static VfsNode *shmfs_create(VfsNode *dir, const char *name, uint8_t type) {
+    (void)dir;
+    if (type != VFS_FILE || strlen(name) > SHMFS_NAME_MAX) return NULL;
+
+    ShmObject *obj = kmalloc(sizeof(ShmObject), GFP_ZERO);
+    if (obj == NULL) return NULL;
+
+    spinlock_acquire(&shm_lock);
+    int slot = -1;
+    for (int i = 0; i < SHMFS_MAX_OBJECTS; i++) {
+        if (objects[i] == NULL) { slot = i; break; }
+    }
+    if (slot < 0 || shmfs_find(name) >= 0) {
+        spinlock_release(&shm_lock);
+        kfree(obj);
+        return NULL;
+    }
+
+    obj->vnode.inode_num = next_inode++;
+    obj->vnode.type = VFS_FILE;
+    obj->vnode.mode = 0600;
+    obj->vnode.ops = &shmfs_file_ops;
+    obj->vnode.private_data = obj;
+    strncpy(obj->name, name, SHMFS_NAME_MAX);
+    obj->linked = 1;
+    objects[slot] = obj;
+    stats.objects++;
+    spinlock_release(&shm_lock);
+    return &obj->vnode;
+}
+
+static int shmfs_unlink(VfsNode *dir, const char *name) {
+    (void)dir;
+    spinlock_acquire(&shm_lock);
+    int i = shmfs_find(name);
+    if (i < 0) {
+        spinlock_release(&shm_lock);
+        return -ENOENT;
+    }
+    /* Open fds and mappings keep the object, but the name is free again */
+    objects[i]->linked = 0;
+    shmfs_maybe_free(objects[i]);
+    spinlock_release(&shm_lock);
+    return VFS_OK;
+}
+
+static int shmfs_readdir(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
+    (void)dir;
+    uint32_t count = 0;
+    spinlock_acquire(&shm_lock);
+    for (int i = 0; i < SHMFS_MAX_OBJECTS && count < max; i++) {
+        ShmObject *obj = objects[i];
+        if (obj == NULL || !obj->linked) continue;
+        strncpy(entries[count].name, obj->name, VFS_NAME_MAX - 1);
+        entries[count].name[VFS_NAME_MAX - 1] = '\0';
+        entries[count].inode_num = obj->vnode.inode_num;
+        entries[count].type = VFS_FILE;
+        count++;
+    }
+    spinlock_release(&shm_lock);
+    return (int)count;
+}
+
+static const VfsOps shmfs_dir_ops = {
+    .lookup  = shmfs_lookup,
+    .create  = shmfs_create,
+    .unlink  = shmfs_unlink,
+    .readdir = shmfs_readdir,
+};
+
+/* --- Public API --- */
+
+VfsNode *shmfs_init(void) {
+    memset(objects, 0, sizeof(objects));
+    memset(&stats, 0, sizeof(stats));
+    next_inode = 3001;
+
+    shm_root.inode_num = 3000;
+    shm_root.type = VFS_DIRECTORY;
+    shm_root.flags = VFS_NODE_DCACHE;
+    shm_root.mode = 01777;          /* Anyone may create objects */
+    shm_root.ops = &shmfs_dir_ops;
+    shm_root.private_data = NULL;
+    return &shm_root;
+}
+
+int shmfs_is_object(const VfsNode *node) {
+    return node != NULL && node->ops == &shmfs_file_ops;
+}
+
+void shmfs_get(VfsNode *node) {
+    spinlock_acquire(&shm_lock);
+    to_shm(node)->refs++;
+    spinlock_release(&shm_lock);
+}
+
+void shmfs_put(VfsNode *node) {
+    ShmObject *obj = to_shm(node);
+    spinlock_acquire(&shm_lock);
+    obj->refs--;
+    shmfs_maybe_free(obj);
+    spinlock_release(&shm_lock);
+}
+
+void shmfs_map_get(VfsNode *node) {
+    ShmObject *obj = to_shm(node);
+    spinlock_acquire(&shm_lock);
+    obj->refs++;
+    obj->maps++;
+    stats.maps++;
+    spinlock_release(&shm_lock);
+}
+
+void shmfs_map_put(VfsNode *node) {
+    ShmObject *obj = to_shm(node);
+    spinlock_acquire(&shm_lock);
+    obj->maps--;
+    stats.maps--;
+    obj->refs--;
+    shmfs_maybe_free(obj);
+    spinlock_release(&shm_lock);
+}
+
+void shmfs_get_stats(ShmfsStats *out) {
+    spinlock_acquire(&shm_lock);
+    *out = stats;
+    spinlock_release(&shm_lock);
+}
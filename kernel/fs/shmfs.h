@@ -0,0 +1,48 @@
+#ifndef ARCHOS_FS_SHMFS_H
+#define ARCHOS_FS_SHMFS_H
+
+#include <stdint.h>
+#include "fs/vfs.h"
+
+/* POSIX shared memory objects, the files of /dev/shm.
+ *
+ * An object's contents live in whole page frames, allocated on first
+ * write or mapping and zero until then, so mmap can put the same frames
+ * into any number of address spaces: data written by one process is seen
+ * by the others without a copy.  ftruncate sets the size; shm_open and
+ * shm_unlink are open and unlink under /dev/shm.
+ *
+ * An object lives while it has a name, an open file descriptor or a
+ * mapping.  Shrinking an object that is still mapped zeroes the pages cut
+ * off but keeps their frames until the object goes away. */
+
+#define SHMFS_MAX_OBJECTS  64
+
+typedef struct {
+    uint32_t objects;       /* Objects alive, named or not */
+    uint64_t pages;         /* Frames they hold */
+    uint32_t maps;          /* Mappings of them in all processes */
+} ShmfsStats;
+
+/* Initialize shmfs and return the /dev/shm directory node. */
+VfsNode *shmfs_init(void);
+
+/* Is node a shared memory object? */
+int shmfs_is_object(const VfsNode *node);
+
+/* Take or drop a reference for an open file descriptor. */
+void shmfs_get(VfsNode *node);
+void shmfs_put(VfsNode *node);
+
+/* Take or drop a reference for a mapping of the object. */
+void shmfs_map_get(VfsNode *node);
+void shmfs_map_put(VfsNode *node);
+
+/* Physical address of page `index` of the object, allocating a zeroed
+ * frame if it has none yet. Returns 0 if out of memory. */
+uint64_t shmfs_frame(VfsNode *node, uint64_t index);
+
+/* Snapshot object and frame counts. */
+void shmfs_get_stats(ShmfsStats *out);
+
+#endif /* ARCHOS_FS_SHMFS_H */
@@ -1,16 +1,30 @@
 #include "fs/vfs.h"
+#include "fs/dcache.h"
+#include "mm/kmalloc.h"
+#include "lib/mem.h"
 #include "lib/string.h"
 #include "proc/process.h"
+#include "proc/rcu.h"
+#include "proc/spinlock.h"
+#include "proc/preempt.h"
 
 static VfsNode *vfs_root;
 
-/* Mount table — supports up to 8 mount points */
+/* Regular-file reads and writes are passed to the filesystem in chunks of
+ * at most this many bytes, with a preemption point between chunks, so a
+ * large transfer does not hold the CPU for its whole length. */
+#define VFS_IO_CHUNK  (64 * 1024)
+
+/* Mount table — supports up to 8 mount points.
+ * Read under RCU: a slot is fully written before mount_count publishes it,
+ * so path lookups scan the table without taking mount_lock. */
 #define VFS_MAX_MOUNTS 8
 static struct {
     char name[VFS_NAME_MAX];
     VfsNode *root;
 } mount_table[VFS_MAX_MOUNTS];
 static int mount_count;
+static Spinlock mount_lock = SPINLOCK_INIT;  /* Serializes vfs_mount */
 
 int vfs_check_perm(const VfsNode *node, uint32_t uid, uint32_t gid, int want) {
     /* Root bypasses all permission checks */
@@ -33,10 +47,12 @@ int vfs_check_perm(const VfsNode *node, uint32_t uid, uint32_t gid, int want) {
 
 void vfs_init(void) {
     vfs_root = NULL;
+    dcache_init();
 }
 
 void vfs_set_root(VfsNode *root) {
     vfs_root = root;
+    dcache_init();
 }
 
 VfsNode *vfs_get_root(void) {
@@ -65,11 +81,34 @@ static const char *path_next_component(const char *path, char *comp, size_t comp
 
 /* Find a mount point by top-level name. Returns mount root or NULL. */
 static VfsNode *vfs_find_mount(const char *name) {
-    for (int i = 0; i < mount_count; i++) {
-        if (mount_table[i].root && strcmp(name, mount_table[i].name) == 0)
-            return mount_table[i].root;
+    VfsNode *root = NULL;
+    rcu_read_lock();
+    int n = rcu_dereference(mount_count);
+    for (int i = 0; i < n; i++) {
+        VfsNode *r = rcu_dereference(mount_table[i].root);
+        if (r && strcmp(name, mount_table[i].name) == 0) {
+            root = r;
+            break;
+        }
+    }
+    rcu_read_unlock();
+    return root;
+}
+
+/* Look up one component in dir, through the dentry cache where dir allows
+ * it. Top-level names the root filesystem lacks fall through to mounts. */
+static VfsNode *vfs_lookup_child(VfsNode *dir, const char *name) {
+    int cached = (dir->flags & VFS_NODE_DCACHE) != 0;
+    VfsNode *child;
+    if (cached && dcache_lookup(dir, name, &child)) return child;
+
+    uint32_t gen = dcache_generation();
+    child = dir->ops->lookup(dir, name);
+    if (child == NULL && dir == vfs_root) {
+        child = vfs_find_mount(name);
     }
-    return NULL;
+    if (cached) dcache_insert(dir, name, child, gen);
+    return child;
 }
 
 /* Resolve parent directory and extract the final component name.
@@ -119,10 +158,7 @@ static VfsNode *vfs_resolve_parent(const char *path, char *name_out, size_t name
             return NULL;
         }
 
-        VfsNode *child = node->ops->lookup(node, comp);
-        if (child == NULL && node == vfs_root) {
-            child = vfs_find_mount(comp);
-        }
+        VfsNode *child = vfs_lookup_child(node, comp);
         if (child == NULL) {
             *errno_out = ENOENT;
             return NULL;
@@ -155,10 +191,7 @@ VfsNode *vfs_resolve(const char *path) {
             return NULL;
         }
 
-        VfsNode *child = node->ops->lookup(node, comp);
-        if (child == NULL && node == vfs_root) {
-            child = vfs_find_mount(comp);
-        }
+        VfsNode *child = vfs_lookup_child(node, comp);
         if (child == NULL) return NULL;
         node = child;
     }
@@ -172,6 +205,8 @@ int vfs_open(const char *path, uint32_t flags, VfsFile *out) {
     VfsNode *node = vfs_resolve(path);
 
     if (node != NULL) {
+        if ((flags & (O_CREAT | O_EXCL)) == (O_CREAT | O_EXCL)) return -EEXIST;
+
         /* Permission check on existing file */
         Process *p = proc_current();
         if (p != NULL) {
@@ -210,6 +245,7 @@ int vfs_open(const char *path, uint32_t flags, VfsFile *out) {
 
         node = parent->ops->create(parent, name, VFS_FILE);
         if (node == NULL) return -ENOMEM;
+        dcache_invalidate_dir(parent);
 
         /* Set ownership and default mode (apply umask) on new file */
         if (p != NULL) {
@@ -228,11 +264,13 @@ int vfs_open(const char *path, uint32_t flags, VfsFile *out) {
     /* Truncate if requested */
     if ((flags & O_TRUNC) && node->ops && node->ops->truncate) {
         node->ops->truncate(node, 0);
+        node->data_gen++;
     }
 
     out->node = node;
     out->flags = flags;
     out->offset = (flags & O_APPEND) ? node->size : 0;
+    out->ra = (VfsReadahead){ 0 };
 
     return VFS_OK;
 }
@@ -245,6 +283,43 @@ int vfs_close(VfsFile *file) {
     return VFS_OK;
 }
 
+/* Ask the filesystem for [start, start+size) clipped to the file */
+static void vfs_ra_request(VfsFile *file, uint64_t start, uint32_t size) {
+    VfsNode *node = file->node;
+    if (start >= node->size) return;
+    if (size > node->size - start) size = (uint32_t)(node->size - start);
+    node->ops->readahead(node, start, size);
+    file->ra.bytes += size;
+}
+
+/* Account for a read of [pos, pos+len) and keep the next window ahead of
+ * a sequential reader */
+static void vfs_readahead(VfsFile *file, uint64_t pos, uint32_t len) {
+    VfsReadahead *ra = &file->ra;
+    uint64_t end = pos + len;
+    if (ra->size > 0 && pos >= ra->stream_start && end <= ra->start + ra->size) ra->hits++;
+    else ra->misses++;
+
+    if (pos != ra->next) {
+        ra->size = 0;               /* Not sequential: stop reading ahead */
+    } else if (ra->size == 0 || end > ra->start + ra->size) {
+        /* New stream, or the reader overtook the window: restart past it */
+        uint64_t size = ra->size ? (uint64_t)ra->size * 2 : (uint64_t)len * 4;
+        if (size < VFS_RA_MIN) size = VFS_RA_MIN;
+        if (size > VFS_RA_MAX) size = VFS_RA_MAX;
+        if (ra->size == 0) ra->stream_start = end;
+        ra->start = end;
+        ra->size = (uint32_t)size;
+        vfs_ra_request(file, ra->start, ra->size);
+    } else if (end > ra->start) {
+        /* Into the newest window: request the one after it */
+        ra->start += ra->size;
+        ra->size = (ra->size * 2 < VFS_RA_MAX) ? ra->size * 2 : VFS_RA_MAX;
+        vfs_ra_request(file, ra->start, ra->size);
+    }
+    ra->next = end;
+}
+
 int vfs_read(VfsFile *file, void *buf, uint32_t size) {
     if (file == NULL || file->node == NULL || buf == NULL) return -EINVAL;
     if ((file->flags & O_ACCMODE) == O_WRONLY) return -EINVAL;
@@ -252,11 +327,30 @@ int vfs_read(VfsFile *file, void *buf, uint32_t size) {
     VfsNode *node = file->node;
     if (node->ops == NULL || node->ops->read == NULL) return -EINVAL;
 
-    int n = node->ops->read(node, buf, (uint32_t)file->offset, size);
-    if (n > 0) {
+    /* Other nodes (pipes, devices, sockets) take the request whole */
+    if (node->type != VFS_FILE) {
+        int n = node->ops->read(node, buf, (uint32_t)file->offset, size);
+        if (n > 0) {
+            file->offset += (uint64_t)n;
+        }
+        return n;
+    }
+
+    /* Requested first, so the filesystem can overlap it with this read */
+    if (node->ops->readahead != NULL && size > 0) vfs_readahead(file, file->offset, size);
+
+    uint32_t done = 0;
+    while (done < size) {
+        if (done > 0) cond_resched();
+        uint32_t len = size - done;
+        if (len > VFS_IO_CHUNK) len = VFS_IO_CHUNK;
+        int n = node->ops->read(node, (uint8_t *)buf + done, (uint32_t)file->offset, len);
+        if (n < 0) return done > 0 ? (int)done : n;
         file->offset += (uint64_t)n;
+        done += (uint32_t)n;
+        if ((uint32_t)n < len) break;
     }
-    return n;
+    return (int)done;
 }
 
 int vfs_write(VfsFile *file, const void *buf, uint32_t size) {
@@ -271,11 +365,52 @@ int vfs_write(VfsFile *file, const void *buf, uint32_t size) {
         file->offset = node->size;
     }
 
-    int n = node->ops->write(node, buf, (uint32_t)file->offset, size);
-    if (n > 0) {
+    if (node->type != VFS_FILE) {
+        int n = node->ops->write(node, buf, (uint32_t)file->offset, size);
+        if (n > 0) {
+            file->offset += (uint64_t)n;
+            node->data_gen++;
+        }
+        return n;
+    }
+
+    uint32_t done = 0;
+    while (done < size) {
+        if (done > 0) cond_resched();
+        uint32_t len = size - done;
+        if (len > VFS_IO_CHUNK) len = VFS_IO_CHUNK;
+        int n = node->ops->write(node, (const uint8_t *)buf + done,
+                                 (uint32_t)file->offset, len);
+        if (n < 0) return done > 0 ? (int)done : n;
+        if (n > 0) node->data_gen++;
         file->offset += (uint64_t)n;
+        done += (uint32_t)n;
+        if ((uint32_t)n < len) break;
+    }
+    return (int)done;
+}
+
+int vfs_fsync(VfsFile *file) {
+    if (file == NULL || file->node == NULL) return -EINVAL;
+    VfsNode *node = file->node;
+    if (node->type != VFS_FILE && node->type != VFS_DIRECTORY) return -EINVAL;
+    if (node->ops == NULL || node->ops->sync == NULL) return VFS_OK;
+    return node->ops->sync(node);
+}
+
+int vfs_sync(void) {
+    int rc = VFS_OK;
+    if (vfs_root && vfs_root->ops && vfs_root->ops->sync) {
+        if (vfs_root->ops->sync(vfs_root) != 0) rc = -EIO;
+    }
+    /* Mounts are never removed, so the slots stay valid across the
+     * (possibly long) sync calls without holding the RCU read lock */
+    int n = rcu_dereference(mount_count);
+    for (int i = 0; i < n; i++) {
+        VfsNode *r = rcu_dereference(mount_table[i].root);
+        if (r && r->ops && r->ops->sync && r->ops->sync(r) != 0) rc = -EIO;
     }
-    return n;
+    return rc;
 }
 
 int vfs_seek(VfsFile *file, int64_t offset, int whence) {
@@ -343,6 +478,7 @@ int vfs_mkdir(const char *path, uint32_t mode) {
 
     VfsNode *dir = parent->ops->create(parent, name, VFS_DIRECTORY);
     if (dir == NULL) return -ENOMEM;
+    dcache_invalidate_dir(parent);
 
     /* Apply umask to requested mode */
     if (p != NULL) {
@@ -355,6 +491,26 @@ int vfs_mkdir(const char *path, uint32_t mode) {
     return VFS_OK;
 }
 
+/* Fill entries from the mount table, starting at slot *next and moving
+ * it past the slots listed */
+static int vfs_list_mounts(uint32_t *next, VfsDirEntry *entries, uint32_t max) {
+    uint32_t count = 0;
+    rcu_read_lock();
+    uint32_t n = (uint32_t)rcu_dereference(mount_count);
+    for (; *next < n && count < max; (*next)++) {
+        VfsNode *r = rcu_dereference(mount_table[*next].root);
+        if (r) {
+            strncpy(entries[count].name, mount_table[*next].name, VFS_NAME_MAX - 1);
+            entries[count].name[VFS_NAME_MAX - 1] = '\0';
+            entries[count].inode_num = r->inode_num;
+            entries[count].type = r->type;
+            count++;
+        }
+    }
+    rcu_read_unlock();
+    return (int)count;
+}
+
 int vfs_readdir(const char *path, VfsDirEntry *entries, uint32_t max) {
     if (entries == NULL) return -EINVAL;
 
@@ -367,15 +523,61 @@ int vfs_readdir(const char *path, VfsDirEntry *entries, uint32_t max) {
 
     /* If listing root, append all mount entries */
     if (node == vfs_root && count >= 0) {
-        for (int i = 0; i < mount_count && (uint32_t)count < max; i++) {
-            if (mount_table[i].root) {
-                strncpy(entries[count].name, mount_table[i].name, VFS_NAME_MAX - 1);
-                entries[count].name[VFS_NAME_MAX - 1] = '\0';
-                entries[count].inode_num = mount_table[i].root->inode_num;
-                entries[count].type = mount_table[i].root->type;
-                count++;
-            }
-        }
+        uint32_t slot = 0;
+        count += vfs_list_mounts(&slot, entries + count, max - (uint32_t)count);
+    }
+
+    return count;
+}
+
+/* A directory's own entries from *cursor on. Without readdir_at the
+ * cursor counts entries already returned, and the listing is read from
+ * the start each time. */
+static int vfs_readdir_node(VfsNode *node, uint64_t *cursor, VfsDirEntry *entries, uint32_t max) {
+    if (node->ops->readdir_at != NULL) return node->ops->readdir_at(node, cursor, entries, max);
+    if (node->ops->readdir == NULL) return -EINVAL;
+    if (*cursor == 0) {
+        int count = node->ops->readdir(node, entries, max);
+        if (count > 0) *cursor = (uint64_t)count;
+        return count;
+    }
+    if (*cursor > UINT32_MAX - max) return 0;
+
+    uint32_t want = (uint32_t)*cursor + max;
+    VfsDirEntry *all = kmalloc((size_t)want * sizeof(VfsDirEntry), 0);
+    if (all == NULL) return -ENOMEM;
+    int count = node->ops->readdir(node, all, want);
+    if (count > (int)*cursor) {
+        memcpy(entries, all + *cursor, ((size_t)count - *cursor) * sizeof(VfsDirEntry));
+        count -= (int)*cursor;
+        *cursor += (uint64_t)count;
+    } else if (count >= 0) {
+        count = 0;
+    }
+    kfree(all);
+    return count;
+}
+
+int vfs_readdir_at(const char *path, uint64_t *cursor, VfsDirEntry *entries, uint32_t max) {
+    if (entries == NULL || cursor == NULL) return -EINVAL;
+
+    VfsNode *node = vfs_resolve(path);
+    if (node == NULL) return -ENOENT;
+    if (node->type != VFS_DIRECTORY) return -ENOTDIR;
+    if (node->ops == NULL) return -EINVAL;
+
+    int count = 0;
+    if (!(*cursor & VFS_CURSOR_MOUNTS)) {
+        count = vfs_readdir_node(node, cursor, entries, max);
+        if (count < 0 || (uint32_t)count == max || node != vfs_root) return count;
+        *cursor = VFS_CURSOR_MOUNTS;
+    }
+
+    /* The root's own entries are done: go on with the mount points */
+    if (node == vfs_root) {
+        uint32_t slot = (uint32_t)(*cursor & ~VFS_CURSOR_MOUNTS);
+        count += vfs_list_mounts(&slot, entries + count, max - (uint32_t)count);
+        *cursor = VFS_CURSOR_MOUNTS | slot;
     }
 
     return count;
@@ -400,7 +602,18 @@ int vfs_unlink(const char *path) {
         return -EINVAL;
     }
 
-    return parent->ops->unlink(parent, name);
+    /* The victim's own entries go too: its node may be freed and reused */
+    VfsNode *victim = NULL;
+    if ((parent->flags & VFS_NODE_DCACHE) && parent->ops->lookup) {
+        victim = vfs_lookup_child(parent, name);
+    }
+
+    int ret = parent->ops->unlink(parent, name);
+    if (ret == 0) {
+        dcache_invalidate_dir(parent);
+        if (victim != NULL) dcache_invalidate_dir(victim);
+    }
+    return ret;
 }
 
 int vfs_mount(const char *path, VfsNode *fs_root) {
@@ -411,19 +624,31 @@ int vfs_mount(const char *path, VfsNode *fs_root) {
     const char *name = path + 1;
     if (*name == '\0' || strchr(name, '/') != NULL) return -EINVAL;
 
+    spinlock_acquire(&mount_lock);
+
     /* Check for duplicate */
     for (int i = 0; i < mount_count; i++) {
         if (mount_table[i].root && strcmp(mount_table[i].name, name) == 0) {
+            spinlock_release(&mount_lock);
             return -EEXIST;
         }
     }
 
-    if (mount_count >= VFS_MAX_MOUNTS) return -ENOMEM;
+    if (mount_count >= VFS_MAX_MOUNTS) {
+        spinlock_release(&mount_lock);
+        return -ENOMEM;
+    }
+
+    /* Fill the slot, then publish it to lockless readers */
+    int slot = mount_count;
+    strncpy(mount_table[slot].name, name, VFS_NAME_MAX - 1);
+    mount_table[slot].name[VFS_NAME_MAX - 1] = '\0';
+    rcu_assign_pointer(mount_table[slot].root, fs_root);
+    rcu_assign_pointer(mount_count, slot + 1);
 
-    strncpy(mount_table[mount_count].name, name, VFS_NAME_MAX - 1);
-    mount_table[mount_count].name[VFS_NAME_MAX - 1] = '\0';
-    mount_table[mount_count].root = fs_root;
-    mount_count++;
+    spinlock_release(&mount_lock);
 
+    /* Drop a cached miss for the mount point's name */
+    dcache_invalidate_dir(vfs_root);
     return VFS_OK;
 }
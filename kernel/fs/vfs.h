@@ -9,6 +9,10 @@
 #define VFS_DIRECTORY 1
 #define VFS_PIPE      2
 #define VFS_SOCKET    3
+#define VFS_ENDPOINT  4
+
+/* Node flags */
+#define VFS_NODE_DCACHE 0x01  /* Directory: lookups may be cached (fs/dcache.h) */
 
 /* Maximum length of a path component name (excluding NUL) */
 #define VFS_NAME_MAX  256
@@ -18,6 +22,7 @@
 #define O_WRONLY   0x01
 #define O_RDWR     0x02
 #define O_CREAT    0x40
+#define O_EXCL     0x80     /* With O_CREAT: fail if the file exists */
 #define O_TRUNC    0x200
 #define O_APPEND   0x400
 
@@ -36,6 +41,7 @@
 #define EBADF        9
 #define ENOMEM      12
 #define EEXIST      17
+#define ENODEV      19
 #define ENOTDIR     20
 #define EISDIR      21
 #define EINVAL      22
@@ -51,6 +57,10 @@
 #define E2BIG        7
 #define EACCES      13
 #define EPERM        1
+#define EFAULT      14
+#define EBUSY       16
+#define ETIME       62
+#define ECANCELED  125
 
 /* Forward declarations */
 typedef struct VfsNode VfsNode;
@@ -69,6 +79,18 @@ typedef struct VfsDirEntry VfsDirEntry;
  * unlink:   Remove a child by name from 'dir'. Returns 0 on success.
  * readdir:  Fill 'entries' with up to 'max' directory entries. Returns entry count (>=0).
  * truncate: Set node size to 'size', discarding data beyond. No return value.
+ * sync:     Write the node's cached data and metadata to its device. Returns 0
+ *           or -EIO. NULL means nothing is cached (in-memory filesystems).
+ * readahead: Start bringing 'size' bytes at 'offset' into the filesystem's
+ *           cache without waiting for them; a hint, so errors are dropped.
+ *           NULL means reads gain nothing from it (in-memory filesystems).
+ * readdir_at: Like readdir, but from '*cursor' (0 for the start), which it
+ *           moves past the entries returned. Entries created or removed
+ *           between calls do not make others repeat or go missing. NULL
+ *           means the VFS pages through readdir by entry count instead.
+ * ref:      An fd now refers to the node (open, dup, fork): take a reference.
+ * unref:    An fd referring to the node was closed: drop its reference.
+ *           NULL for both means the node's lifetime does not follow open fds.
  */
 typedef struct {
     int      (*read)(VfsNode *node, void *buf, uint32_t offset, uint32_t size);
@@ -78,25 +100,52 @@ typedef struct {
     int      (*unlink)(VfsNode *dir, const char *name);
     int      (*readdir)(VfsNode *dir, VfsDirEntry *entries, uint32_t max);
     void     (*truncate)(VfsNode *node, uint64_t size);
+    int      (*sync)(VfsNode *node);
+    void     (*readahead)(VfsNode *node, uint64_t offset, uint32_t size);
+    int      (*readdir_at)(VfsNode *dir, uint64_t *cursor, VfsDirEntry *entries, uint32_t max);
+    void     (*ref)(VfsNode *node);
+    void     (*unref)(VfsNode *node);
 } VfsOps;
 
 /* VFS Node — inode equivalent */
 struct VfsNode {
     uint64_t       inode_num;
     uint8_t        type;          /* VFS_FILE or VFS_DIRECTORY */
+    uint8_t        flags;         /* VFS_NODE_* */
     uint64_t       size;
     uint32_t       mode;
     uint32_t       uid;
     uint32_t       gid;
+    uint32_t       data_gen;      /* Bumped on write/truncate: lets caches spot changes */
     const VfsOps  *ops;
     void          *private_data;  /* fs-specific (RamfsNode* etc.) */
 };
 
+/* Readahead bounds: the first window, and the most a window grows to */
+#define VFS_RA_MIN    (16 * 1024)
+#define VFS_RA_MAX    (128 * 1024)
+
+/* Sequential readahead state of an open file (see vfs_read).  A read
+ * starting where the last one ended continues a stream; the first opens
+ * a window just past it, and each time the reader moves into the newest
+ * window the next one, twice as large up to VFS_RA_MAX, is requested.
+ * Any other read ends the stream. */
+typedef struct {
+    uint64_t  next;           /* Where a sequential read would start */
+    uint64_t  stream_start;   /* First byte requested ahead for this stream */
+    uint64_t  start;          /* Newest window */
+    uint32_t  size;           /* 0: no stream */
+    uint64_t  hits;           /* Reads wholly inside data requested ahead */
+    uint64_t  misses;         /* Other reads */
+    uint64_t  bytes;          /* Requested ahead, in total */
+} VfsReadahead;
+
 /* Open file handle */
 typedef struct {
-    VfsNode  *node;
-    uint64_t  offset;
-    uint32_t  flags;
+    VfsNode      *node;
+    uint64_t      offset;
+    uint32_t      flags;
+    VfsReadahead  ra;
 } VfsFile;
 
 /* Directory entry (for readdir) */
@@ -147,12 +196,24 @@ int vfs_read(VfsFile *file, void *buf, uint32_t size);
 int vfs_write(VfsFile *file, const void *buf, uint32_t size);
 int vfs_seek(VfsFile *file, int64_t offset, int whence);
 
+/* Durability: write an open file's cached data and metadata to its device,
+ * or every mounted filesystem's. Return 0, -EINVAL (not a file or
+ * directory) or -EIO. */
+int vfs_fsync(VfsFile *file);
+int vfs_sync(void);
+
 /* Metadata operations */
 int vfs_stat(const char *path, VfsStat *out);
 
 /* Directory operations */
 int vfs_mkdir(const char *path, uint32_t mode);
 int vfs_readdir(const char *path, VfsDirEntry *entries, uint32_t max);
+
+/* List a directory in batches: start with *cursor = 0 and call again
+ * with the updated cursor until it returns 0. Entries of the root come
+ * before the mount points, whose cursors have VFS_CURSOR_MOUNTS set. */
+#define VFS_CURSOR_MOUNTS  (1ULL << 63)
+int vfs_readdir_at(const char *path, uint64_t *cursor, VfsDirEntry *entries, uint32_t max);
 int vfs_unlink(const char *path);
 
 /* Mount a filesystem root at a mount point (e.g., "/disk").
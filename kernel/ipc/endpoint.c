@@ -0,0 +1,250 @@
+/* arc_os — Synchronous IPC endpoints
+ *
+ * Each blocked party waits on an IpcWait on its own kernel stack.  A
+ * message is copied out of the sender's address space into that IpcWait
+ * (the buffer into a kmalloc'd bounce copy) before the sender blocks, and
+ * into the receiver's address space once the receiver runs again, so
+ * neither side ever touches the other's page tables.  A caller's IpcWait
+ * carries its call to the server and then the reply back.
+ *
+ * Like the rest of the system-call layer this relies on interrupts being
+ * off between marking a thread blocked and switching away. */
+
+#include "ipc/endpoint.h"
+#include "proc/sched.h"
+#include "proc/spinlock.h"
+#include "mm/kmalloc.h"
+#include "lib/mem.h"
+#include "user_access.h"
+
+typedef struct IpcWait {
+    Thread         *thread;
+    IpcMsg          msg;        /* Message in flight: the call, then the reply */
+    uint8_t        *data;       /* Bounce copy of msg.len buffer bytes, or NULL */
+    uint64_t        rbuf;       /* Where this thread receives a buffer */
+    uint32_t        rcap;
+    int             status;     /* Call result, set with the reply */
+    struct IpcWait *peer;       /* Receiver: the call it was handed */
+    struct IpcWait *next;
+} IpcWait;
+
+typedef struct {
+    VfsNode   vnode;
+    Spinlock  lock;
+    uint32_t  refs;             /* File descriptors referring to it */
+    IpcWait  *callers;          /* Calls no receiver has taken yet (FIFO) */
+    IpcWait  *callers_tail;
+    IpcWait  *receivers;        /* Server threads blocked in recv */
+} Endpoint;
+
+static Endpoint *to_endpoint(VfsNode *node) {
+    return (Endpoint *)node->private_data;
+}
+
+/* --- Message copies --- */
+
+/* Record where the caller's thread receives, rejecting a bad buffer before
+ * anything blocks. */
+static int ipc_wait_init(IpcWait *w, const IpcMsg *msg) {
+    memset(w, 0, sizeof(*w));
+    w->thread = thread_current();
+    w->rbuf = msg->buf;
+    w->rcap = msg->cap;
+    if (w->rcap > IPC_BUF_MAX) w->rcap = IPC_BUF_MAX;
+    if (w->rcap > 0 && !user_ptr_valid((const void *)w->rbuf, w->rcap)) return -EINVAL;
+    return 0;
+}
+
+/* Copy the message to send from the current address space into w. */
+static int ipc_load(IpcWait *w, const IpcMsg *msg) {
+    uint32_t len = msg->len;
+    if (len > IPC_BUF_MAX) return -EINVAL;
+
+    uint8_t *data = NULL;
+    if (len > 0) {
+        if (!user_ptr_valid((const void *)msg->buf, len)) return -EINVAL;
+        data = kmalloc(len, 0);
+        if (data == NULL) return -ENOMEM;
+        memcpy(data, (const void *)msg->buf, len);
+    }
+    w->msg = *msg;
+    w->data = data;
+    return 0;
+}
+
+/* Copy the message held by from into the current address space, into the
+ * buffer self receives in. Frees the bounce copy. */
+static void ipc_deliver(const IpcWait *self, IpcWait *from, IpcMsg *msg) {
+    uint32_t len = (from->msg.len < self->rcap) ? from->msg.len : self->rcap;
+    msg->tag = from->msg.tag;
+    memcpy(msg->words, from->msg.words, sizeof(msg->words));
+    if (len > 0) memcpy((void *)self->rbuf, from->data, len);
+    msg->len = len;
+
+    kfree(from->data);
+    from->data = NULL;
+}
+
+/* --- Endpoint queues (ep->lock held) --- */
+
+static void ipc_queue_caller(Endpoint *ep, IpcWait *w) {
+    w->next = NULL;
+    if (ep->callers_tail) {
+        ep->callers_tail->next = w;
+    } else {
+        ep->callers = w;
+    }
+    ep->callers_tail = w;
+}
+
+static IpcWait *ipc_take_caller(Endpoint *ep) {
+    IpcWait *w = ep->callers;
+    if (w == NULL) return NULL;
+    ep->callers = w->next;
+    if (ep->callers == NULL) ep->callers_tail = NULL;
+    w->next = NULL;
+    return w;
+}
+
+/* Start serving caller c: hand its message to the current thread. */
+static int ipc_accept(const IpcWait *self, IpcWait *c, IpcMsg *msg) {
+    ipc_deliver(self, c, msg);
+    thread_current()->ipc_caller = c;
+    return 0;
+}
+
+/* Wait on ep for a call; with a caller to resume, switch straight to it.
+ * Returns the call taken. */
+static IpcWait *ipc_wait_call(Endpoint *ep, IpcWait *self, Thread *resume) {
+    spinlock_acquire(&ep->lock);
+    IpcWait *c = ipc_take_caller(ep);
+    if (c != NULL) {
+        spinlock_release(&ep->lock);
+        if (resume) sched_add_thread(resume);
+        return c;
+    }
+
+    self->next = ep->receivers;
+    ep->receivers = self;
+    self->thread->state = THREAD_BLOCKED;
+    spinlock_release(&ep->lock);
+
+    if (resume) {
+        sched_handoff(resume);
+    } else {
+        sched_yield();
+    }
+    return self->peer;
+}
+
+/* Endpoints are only called through, never read or written; open fds
+ * hold references on them */
+static const VfsOps endpoint_ops = {
+    .ref   = ipc_endpoint_addref,
+    .unref = ipc_endpoint_close,
+};
+
+/* --- Public API --- */
+
+VfsNode *ipc_endpoint_create(void) {
+    Endpoint *ep = kmalloc(sizeof(Endpoint), GFP_ZERO);
+    if (ep == NULL) return NULL;
+    ep->vnode.type = VFS_ENDPOINT;
+    ep->vnode.mode = 0600;
+    ep->vnode.ops = &endpoint_ops;
+    ep->vnode.private_data = ep;
+    ep->lock = (Spinlock)SPINLOCK_INIT;
+    ep->refs = 1;
+    return &ep->vnode;
+}
+
+void ipc_endpoint_addref(VfsNode *node) {
+    to_endpoint(node)->refs++;
+}
+
+void ipc_endpoint_close(VfsNode *node) {
+    Endpoint *ep = to_endpoint(node);
+    if (--ep->refs == 0) kfree(ep);
+}
+
+int ipc_call(VfsNode *node, IpcMsg *msg) {
+    Endpoint *ep = to_endpoint(node);
+    IpcWait w;
+    int err = ipc_wait_init(&w, msg);
+    if (err == 0) err = ipc_load(&w, msg);
+    if (err != 0) return err;
+
+    spinlock_acquire(&ep->lock);
+    IpcWait *r = ep->receivers;
+    if (r != NULL) {
+        ep->receivers = r->next;
+        r->peer = &w;
+    } else {
+        ipc_queue_caller(ep, &w);
+    }
+    w.thread->state = THREAD_BLOCKED;
+    spinlock_release(&ep->lock);
+
+    /* A waiting server runs at once, on this thread's time slice */
+    if (r != NULL) {
+        sched_handoff(r->thread);
+    } else {
+        sched_yield();
+    }
+
+    /* Woken by the reply (or by the server's exit) */
+    if (w.status != 0) return w.status;
+    ipc_deliver(&w, &w, msg);
+    return 0;
+}
+
+int ipc_recv(VfsNode *node, IpcMsg *msg) {
+    if (thread_current()->ipc_caller != NULL) return -EBUSY;
+
+    IpcWait self;
+    int err = ipc_wait_init(&self, msg);
+    if (err != 0) return err;
+
+    IpcWait *c = ipc_wait_call(to_endpoint(node), &self, NULL);
+    return ipc_accept(&self, c, msg);
+}
+
+int ipc_reply(const IpcMsg *msg) {
+    Thread *t = thread_current();
+    IpcWait *c = t->ipc_caller;
+    if (c == NULL) return -EINVAL;
+
+    int err = ipc_load(c, msg);
+    if (err != 0) return err;
+    t->ipc_caller = NULL;
+    sched_add_thread(c->thread);
+    return 0;
+}
+
+int ipc_reply_recv(VfsNode *node, IpcMsg *msg) {
+    Thread *t = thread_current();
+    IpcWait self;
+    int err = ipc_wait_init(&self, msg);
+    if (err != 0) return err;
+
+    /* Load the reply; the caller runs once this thread has a new call or
+     * blocks waiting for one */
+    IpcWait *c = t->ipc_caller;
+    if (c != NULL) {
+        err = ipc_load(c, msg);
+        if (err != 0) return err;
+        t->ipc_caller = NULL;
+    }
+
+    IpcWait *next = ipc_wait_call(to_endpoint(node), &self,
+                                  c ? c->thread : NULL);
+    return ipc_accept(&self, next, msg);
+}
+
+void ipc_thread_exit(Thread *t) {
+    IpcWait *c = t->ipc_caller;
+    if (c == NULL) return;
+    t->ipc_caller = NULL;
+    c->status = -EPIPE;
+    sched_add_thread(c->thread);
+}
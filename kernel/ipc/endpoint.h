@@ -0,0 +1,64 @@
+#ifndef ARCHOS_IPC_ENDPOINT_H
+#define ARCHOS_IPC_ENDPOINT_H
+
+#include <stdint.h>
+#include "fs/vfs.h"
+#include "proc/thread.h"
+
+/* Synchronous IPC endpoints (L4-style call/reply).
+ *
+ * A client calls an endpoint and blocks until a server thread replies; a
+ * server receives the call, does the work and replies, usually in the
+ * same system call as it waits for the next one (reply_recv).  A message
+ * is a tag plus IPC_MSG_WORDS message registers, optionally with up to
+ * IPC_BUF_MAX bytes from a user buffer.
+ *
+ * When the other side is already waiting, the kernel switches straight
+ * to it (sched_handoff) instead of waking it through the run queue, so a
+ * round trip is two system calls and two context switches.  A server
+ * thread owes a reply to at most one caller at a time; if it exits
+ * without replying, the call fails with -EPIPE.
+ *
+ * Endpoints are file descriptors, shared with children through fork.
+ * The layout below is ABI: libc/include/ipc.h mirrors it. */
+
+#define IPC_MSG_WORDS  6
+#define IPC_BUF_MAX    4096
+
+/* Message as laid out in user memory */
+typedef struct {
+    uint64_t tag;                   /* Call: operation label; reply: result */
+    uint64_t words[IPC_MSG_WORDS];  /* Message registers */
+    uint64_t buf;                   /* User buffer, or 0 */
+    uint32_t len;                   /* Bytes of buf to send; set to bytes received */
+    uint32_t cap;                   /* Bytes buf can receive; excess is dropped */
+} IpcMsg;
+
+/* Create an endpoint. Returns its VfsNode, or NULL on allocation failure. */
+VfsNode *ipc_endpoint_create(void);
+
+/* Reference counting for the fds that refer to an endpoint (dup, fork,
+ * close). The last close frees it. */
+void ipc_endpoint_addref(VfsNode *node);
+void ipc_endpoint_close(VfsNode *node);
+
+/* Send msg to a server on ep and wait for the reply, which overwrites
+ * msg. Returns 0, or -EPIPE if the server exited without replying. */
+int ipc_call(VfsNode *ep, IpcMsg *msg);
+
+/* Wait for a call on ep and store it in msg; the calling thread then owes
+ * the caller a reply. Returns 0, or -EBUSY if a reply is still owed. */
+int ipc_recv(VfsNode *ep, IpcMsg *msg);
+
+/* Send msg as the reply to the call being served. Returns 0, or -EINVAL
+ * if no reply is owed. */
+int ipc_reply(const IpcMsg *msg);
+
+/* Reply with msg (if a reply is owed), then wait for the next call on ep
+ * and store it in msg. */
+int ipc_reply_recv(VfsNode *ep, IpcMsg *msg);
+
+/* Thread exit: fail the call t still owes a reply to. */
+void ipc_thread_exit(Thread *t);
+
+#endif /* ARCHOS_IPC_ENDPOINT_H */
@@ -2,17 +2,21 @@
 #include "mm/pmm.h"
 #include "arch/x86_64/paging.h"
 #include "proc/spinlock.h"
+#include "proc/preempt.h"
 #include "lib/mem.h"
 #include "lib/kprintf.h"
 
 /* SMP-safe: protects kernel page table modifications */
 static Spinlock vmm_lock = SPINLOCK_INIT;
 
-/* Errno value needed for vmm_map_user_stack (defined in fs/vfs.h;
+/* Errno values needed for vmm_map_user_stack (defined in fs/vfs.h;
  * duplicated here to avoid mm→fs layer dependency). */
 #ifndef ENOMEM
 #define ENOMEM 12
 #endif
+#ifndef EFAULT
+#define EFAULT 14
+#endif
 
 /* Huge page sizes and masks */
 #define PAGE_SIZE_2MB       0x200000ULL
@@ -54,6 +58,8 @@ static uint64_t vmm_flags_to_pte(uint32_t flags) {
     if (flags & VMM_FLAG_WRITABLE) pte |= PTE_WRITABLE;
     if (flags & VMM_FLAG_USER)     pte |= PTE_USER;
     if (flags & VMM_FLAG_NOEXEC)   pte |= PTE_NX;
+    if (flags & VMM_FLAG_SHARED)   pte |= PTE_SHARED;
+    if (flags & VMM_FLAG_COW)      pte |= PTE_COW;
     return pte;
 }
 
@@ -63,6 +69,8 @@ static uint32_t pte_to_vmm_flags(uint64_t pte_flags) {
     if (pte_flags & PTE_WRITABLE) flags |= VMM_FLAG_WRITABLE;
     if (pte_flags & PTE_USER)     flags |= VMM_FLAG_USER;
     if (pte_flags & PTE_NX)       flags |= VMM_FLAG_NOEXEC;
+    if (pte_flags & PTE_SHARED)   flags |= VMM_FLAG_SHARED;
+    if (pte_flags & PTE_COW)      flags |= VMM_FLAG_COW;
     return flags;
 }
 
@@ -235,11 +243,16 @@ uint64_t vmm_get_phys_in(uint64_t pml4_phys, uint64_t virt) {
 /* --- Address space fork/teardown --- */
 
 /* Copy a single user page and map the copy into the destination address space.
- * Returns 0 on success, -1 on OOM. */
+ * A shared frame is mapped as-is. Returns 0 on success, -1 on OOM. */
 static int fork_copy_page(uint64_t src_pte, uint64_t dst_pml4, uint64_t vaddr) {
     uint64_t src_phys = src_pte & PTE_ADDR_MASK;
     uint64_t flags = src_pte & ~PTE_ADDR_MASK;
 
+    if (src_pte & PTE_SHARED) {
+        vmm_map_page_in(dst_pml4, vaddr, src_phys, pte_to_vmm_flags(flags));
+        return 0;
+    }
+
     uint64_t dst_phys = pmm_alloc_page();
     if (dst_phys == 0) return -1;
 
@@ -281,6 +294,11 @@ uint64_t vmm_fork_address_space(uint64_t src_pml4_phys) {
                         return 0;
                     }
                 }
+
+                /* Preemption point after each page table (up to 2 MiB
+                 * copied). Page tables of a live address space are never
+                 * freed, so src_pd stays valid across a switch. */
+                cond_resched();
             }
         }
     }
@@ -288,11 +306,11 @@ uint64_t vmm_fork_address_space(uint64_t src_pml4_phys) {
     return dst_pml4_phys;
 }
 
-/* Free all present leaf pages in a page table, then free the PT page itself. */
+/* Free all present, owned leaf pages in a page table, then free the PT page itself. */
 static void free_pt_and_leaves(uint64_t pt_phys) {
     uint64_t *pt = (uint64_t *)phys_to_virt(pt_phys);
     for (int i = 0; i < PT_ENTRIES; i++) {
-        if (pt[i] & PTE_PRESENT) {
+        if ((pt[i] & PTE_PRESENT) && !(pt[i] & PTE_SHARED)) {
             pmm_free_page(pt[i] & PTE_ADDR_MASK);
         }
     }
@@ -325,6 +343,21 @@ void vmm_free_user_pages(uint64_t pml4_phys) {
     pmm_free_page(pml4_phys);
 }
 
+int vmm_resolve_cow(uint64_t pml4_phys, uint64_t virt) {
+    uint64_t *pte = walk_to_pt_entry(pml4_phys, virt);
+    if (pte == NULL || !(*pte & PTE_PRESENT) || !(*pte & PTE_COW)) return -EFAULT;
+
+    uint64_t copy = pmm_alloc_page();
+    if (copy == 0) return -ENOMEM;
+    memcpy(phys_to_virt(copy), phys_to_virt(*pte & PTE_ADDR_MASK), PAGE_SIZE);
+
+    /* A private frame: owned, writable, no longer copy-on-write */
+    uint64_t flags = *pte & ~(PTE_ADDR_MASK | PTE_SHARED | PTE_COW);
+    *pte = copy | flags | PTE_WRITABLE;
+    paging_invlpg(PAGE_ALIGN_DOWN(virt));
+    return 0;
+}
+
 int vmm_map_user_stack(uint64_t pml4_phys) {
     uint64_t stack_bottom = USER_STACK_TOP - (USER_STACK_PAGES * PAGE_SIZE);
     for (uint64_t vaddr = stack_bottom; vaddr < USER_STACK_TOP; vaddr += PAGE_SIZE) {
@@ -8,6 +8,8 @@
 #define VMM_FLAG_WRITABLE  (1 << 0)
 #define VMM_FLAG_USER      (1 << 1)
 #define VMM_FLAG_NOEXEC    (1 << 2)
+#define VMM_FLAG_SHARED    (1 << 3)  /* Frame not owned: never freed or copied with the space */
+#define VMM_FLAG_COW       (1 << 4)  /* Read-only until a write fault copies the frame */
 
 /* Initialize VMM: create kernel page tables and switch CR3. */
 void vmm_init(const BootInfo *info);
@@ -32,6 +34,10 @@ uint64_t vmm_get_hhdm_offset(void);
 #define USER_STACK_PAGES  4   /* 16 KB */
 #define USER_BASE         0x0000000000400000ULL  /* Default ELF load address */
 #define USER_HEAP_BASE    0x0000000010000000ULL
+#define USER_INTERP_BASE  0x00007E0000000000ULL  /* Program interpreter (libarc.so) */
+#define USER_INTERP_SIZE  0x0000000040000000ULL  /* 1 GB window for it */
+#define USER_MMAP_BASE    0x0000600000000000ULL  /* mmap window, up to the interpreter */
+#define USER_MMAP_END     USER_INTERP_BASE
 
 /* Create a new PML4 for a user process (copies kernel-half entries 256-511). */
 uint64_t vmm_create_user_pml4(void);
@@ -49,13 +55,20 @@ void vmm_unmap_page_in(uint64_t pml4, uint64_t virt);
 uint64_t vmm_get_phys_in(uint64_t pml4, uint64_t virt);
 
 /* Fork a user address space: create new PML4, copy all user-half pages.
+ * Shared frames are mapped again rather than copied.
  * Returns new PML4 physical address, or 0 on failure. */
 uint64_t vmm_fork_address_space(uint64_t src_pml4_phys);
 
 /* Free all user-half leaf pages AND page table structures for a PML4.
+ * Shared frames are left to their owner.
  * After this, the PML4 is destroyed (cannot be reused). */
 void vmm_free_user_pages(uint64_t pml4_phys);
 
+/* Resolve a write fault on a copy-on-write page: give this address space
+ * a private, writable copy of the frame. Returns 0 on success, -EFAULT if
+ * virt is not a copy-on-write mapping, or -ENOMEM. */
+int vmm_resolve_cow(uint64_t pml4_phys, uint64_t virt);
+
 /* Allocate and map zeroed user stack pages in the given address space.
  * Returns 0 on success, negative errno on failure. */
 int vmm_map_user_stack(uint64_t pml4_phys);
@@ -4,41 +4,92 @@
 #include "net/ethernet.h"
 #include "lib/mem.h"
 #include "lib/kprintf.h"
+#include "proc/rcu.h"
+#include "proc/spinlock.h"
 
-typedef struct {
-    uint32_t ip;
-    uint8_t  mac[ETH_ALEN];
-    uint8_t  valid;
+/* ARP cache under RCU.  Entries are immutable once published in a slot; an
+ * update installs a fresh entry and retires the old one through call_rcu,
+ * so arp_lookup() takes no lock.  Entries come from a static pool because
+ * arp_insert runs in IRQ context, where kmalloc is not safe. */
+typedef struct ArpEntry {
+    RcuHead          rcu;
+    uint32_t         ip;
+    uint8_t          mac[ETH_ALEN];
+    struct ArpEntry *free_next;
 } ArpEntry;
 
-static ArpEntry arp_cache[ARP_CACHE_SIZE];
+/* Twice the cache size leaves a full cache's worth of entries in flight */
+#define ARP_POOL_SIZE (ARP_CACHE_SIZE * 2)
+
+static ArpEntry  arp_pool[ARP_POOL_SIZE];
+static ArpEntry *arp_free_list;
+static ArpEntry *arp_cache[ARP_CACHE_SIZE];  /* RCU-protected slots */
 static int arp_next_slot;  /* round-robin eviction */
+static Spinlock arp_lock = SPINLOCK_INIT;    /* Serializes updaters */
+
+/* RCU callback: return a retired entry to the pool. */
+static void arp_entry_free(RcuHead *head) {
+    ArpEntry *e = (ArpEntry *)head;
+    spinlock_acquire(&arp_lock);
+    e->free_next = arp_free_list;
+    arp_free_list = e;
+    spinlock_release(&arp_lock);
+}
 
 void arp_init(void) {
     memset(arp_cache, 0, sizeof(arp_cache));
+    memset(arp_pool, 0, sizeof(arp_pool));
+    arp_free_list = NULL;
+    for (int i = ARP_POOL_SIZE - 1; i >= 0; i--) {
+        arp_pool[i].free_next = arp_free_list;
+        arp_free_list = &arp_pool[i];
+    }
     arp_next_slot = 0;
 }
 
 void arp_insert(uint32_t ip, const uint8_t mac[ETH_ALEN]) {
-    /* Update existing entry if present */
+    spinlock_acquire(&arp_lock);
+
+    /* Update existing entry if present; otherwise take the next slot
+     * (round-robin eviction) */
+    int slot = -1;
     for (int i = 0; i < ARP_CACHE_SIZE; i++) {
-        if (arp_cache[i].valid && arp_cache[i].ip == ip) {
-            memcpy(arp_cache[i].mac, mac, ETH_ALEN);
-            return;
+        if (arp_cache[i] && arp_cache[i]->ip == ip) {
+            slot = i;
+            break;
         }
     }
-    /* Insert into next slot (round-robin eviction) */
-    ArpEntry *e = &arp_cache[arp_next_slot];
+    if (slot >= 0 && memcmp(arp_cache[slot]->mac, mac, ETH_ALEN) == 0) {
+        spinlock_release(&arp_lock);  /* Unchanged — the common refresh */
+        return;
+    }
+
+    ArpEntry *e = arp_free_list;
+    if (e == NULL) {
+        /* Every spare entry awaits a grace period; drop this update */
+        spinlock_release(&arp_lock);
+        return;
+    }
+    arp_free_list = e->free_next;
     e->ip = ip;
     memcpy(e->mac, mac, ETH_ALEN);
-    e->valid = 1;
-    arp_next_slot = (arp_next_slot + 1) % ARP_CACHE_SIZE;
+
+    if (slot < 0) {
+        slot = arp_next_slot;
+        arp_next_slot = (arp_next_slot + 1) % ARP_CACHE_SIZE;
+    }
+    ArpEntry *old = arp_cache[slot];
+    rcu_assign_pointer(arp_cache[slot], e);
+    spinlock_release(&arp_lock);
+
+    if (old) call_rcu(&old->rcu, arp_entry_free);
 }
 
 const uint8_t *arp_lookup(uint32_t ip) {
     for (int i = 0; i < ARP_CACHE_SIZE; i++) {
-        if (arp_cache[i].valid && arp_cache[i].ip == ip)
-            return arp_cache[i].mac;
+        ArpEntry *e = rcu_dereference(arp_cache[i]);
+        if (e && e->ip == ip)
+            return e->mac;
     }
     return NULL;
 }
@@ -31,7 +31,9 @@ void arp_init(void);
 /* Process incoming ARP (called from eth_rx). */
 void arp_rx(struct NetIf *nif, const void *data, uint32_t len);
 
-/* Look up MAC for an IP. Returns pointer to 6-byte MAC, or NULL. */
+/* Look up MAC for an IP. Returns pointer to 6-byte MAC, or NULL.
+ * Lockless: call inside rcu_read_lock(); the MAC is valid until
+ * rcu_read_unlock(). */
 const uint8_t *arp_lookup(uint32_t ip);
 
 /* Insert a static ARP entry. */
@@ -8,6 +8,7 @@
 #include "net/tcp.h"
 #include "lib/mem.h"
 #include "lib/kprintf.h"
+#include "proc/rcu.h"
 
 static uint16_t ip_id_counter = 1;
 
@@ -82,13 +83,17 @@ int ipv4_send(struct NetIf *nif, uint32_t dst_ip, uint8_t protocol,
     if ((dst_ip & nif->netmask) != (nif->ip_addr & nif->netmask))
         next_hop = nif->gateway;
 
-    /* ARP lookup for next-hop MAC */
+    /* ARP lookup for next-hop MAC (entry pinned by the RCU read section) */
+    rcu_read_lock();
     const uint8_t *dst_mac = arp_lookup(next_hop);
     if (!dst_mac) {
+        rcu_read_unlock();
         /* No ARP entry — drop (QEMU ARPs us first, so this is rare) */
         kprintf("[IPv4] No ARP entry for next-hop, dropping\n");
         return -1;
     }
 
-    return eth_send(nif, dst_mac, ETH_TYPE_IPV4, pkt, total_len);
+    int ret = eth_send(nif, dst_mac, ETH_TYPE_IPV4, pkt, total_len);
+    rcu_read_unlock();
+    return ret;
 }
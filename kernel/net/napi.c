@@ -0,0 +1,35 @@
+/* arc_os — NAPI-style budgeted receive polling */
+
+#include "net/napi.h"
+#include "proc/sched.h"
+
+static void napi_work_fn(Work *work) {
+    Napi *napi = (Napi *)work;
+
+    int done = napi->poll(napi, napi->weight);
+    napi->nr_polls++;
+    napi->nr_frames += (uint64_t)done;
+
+    if (done >= napi->weight) {
+        /* More frames are likely waiting and the device interrupt is still
+         * masked: go round again, but let other threads run first. */
+        napi->nr_budget_exhausted++;
+        queue_work(&napi->work);
+        sched_yield();
+    }
+}
+
+void napi_init(Napi *napi, napi_poll_t poll, int weight) {
+    work_init(&napi->work, napi_work_fn);
+    napi->poll = poll;
+    napi->weight = weight > 0 ? weight : NAPI_POLL_WEIGHT;
+    napi->nr_schedules = 0;
+    napi->nr_polls = 0;
+    napi->nr_frames = 0;
+    napi->nr_budget_exhausted = 0;
+}
+
+void napi_schedule(Napi *napi) {
+    napi->nr_schedules++;
+    queue_work(&napi->work);
+}
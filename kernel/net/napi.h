@@ -0,0 +1,42 @@
+#ifndef ARCHOS_NET_NAPI_H
+#define ARCHOS_NET_NAPI_H
+
+#include <stdint.h>
+#include "proc/workqueue.h"
+
+/* NAPI-style receive polling.
+ *
+ * A driver's RX interrupt masks further device interrupts and calls
+ * napi_schedule(); the actual frame processing then runs from a work item
+ * in bounded passes of at most `weight` frames.  A pass that uses its whole
+ * budget re-queues the poll and yields, so a flood costs one interrupt per
+ * burst instead of one per frame and cannot starve other threads.  Once a
+ * pass finds the ring drained, the driver re-enables its interrupt. */
+
+/* Default frames per poll pass */
+#define NAPI_POLL_WEIGHT 16
+
+struct Napi;
+
+/* Process up to `budget` frames. Returns the number processed; a return
+ * below `budget` means the ring is drained and the driver has re-armed
+ * its interrupt. */
+typedef int (*napi_poll_t)(struct Napi *napi, int budget);
+
+typedef struct Napi {
+    Work         work;              /* Must be first: work fn casts back */
+    napi_poll_t  poll;
+    int          weight;
+    uint64_t     nr_schedules;      /* napi_schedule calls (~ RX interrupts) */
+    uint64_t     nr_polls;          /* Poll passes run */
+    uint64_t     nr_frames;         /* Frames processed */
+    uint64_t     nr_budget_exhausted;  /* Passes that hit the budget */
+} Napi;
+
+/* Initialize a poll context. weight <= 0 selects NAPI_POLL_WEIGHT. */
+void napi_init(Napi *napi, napi_poll_t poll, int weight);
+
+/* Request a poll pass. Safe from IRQ context; coalesces while pending. */
+void napi_schedule(Napi *napi);
+
+#endif /* ARCHOS_NET_NAPI_H */
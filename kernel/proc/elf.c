@@ -24,8 +24,8 @@ static int elf_validate_header(const Elf64_Ehdr *ehdr, size_t size) {
         kprintf("[ELF] Not little-endian\n");
         return -EINVAL;
     }
-    if (ehdr->e_type != ET_EXEC) {
-        kprintf("[ELF] Not an executable (type=%u)\n", ehdr->e_type);
+    if (ehdr->e_type != ET_EXEC && ehdr->e_type != ET_DYN) {
+        kprintf("[ELF] Not an executable or shared object (type=%u)\n", ehdr->e_type);
         return -EINVAL;
     }
     if (ehdr->e_machine != EM_X86_64) {
@@ -45,11 +45,11 @@ static int elf_validate_header(const Elf64_Ehdr *ehdr, size_t size) {
 
 /* Copy file data that overlaps with a single mapped page. */
 static void elf_copy_page_data(void *page_virt, uint64_t vaddr,
-                               const Elf64_Phdr *phdr, const void *data) {
-    if (phdr->p_filesz == 0) return;
+                               const ElfSegment *seg, const void *data) {
+    if (seg->filesz == 0) return;
 
-    uint64_t file_start = phdr->p_vaddr;
-    uint64_t file_end   = phdr->p_vaddr + phdr->p_filesz;
+    uint64_t file_start = seg->vaddr;
+    uint64_t file_end   = seg->vaddr + seg->filesz;
     uint64_t page_start = vaddr;
     uint64_t page_end   = vaddr + PAGE_SIZE;
 
@@ -57,7 +57,7 @@ static void elf_copy_page_data(void *page_virt, uint64_t vaddr,
     uint64_t copy_end   = (file_end < page_end) ? file_end : page_end;
 
     if (copy_start < copy_end) {
-        uint64_t file_offset = phdr->p_offset + (copy_start - phdr->p_vaddr);
+        uint64_t file_offset = seg->offset + (copy_start - seg->vaddr);
         uint64_t page_offset = copy_start - page_start;
         memcpy((uint8_t *)page_virt + page_offset,
                (const uint8_t *)data + file_offset,
@@ -65,10 +65,8 @@ static void elf_copy_page_data(void *page_virt, uint64_t vaddr,
     }
 }
 
-/* Load a single PT_LOAD segment: validate bounds, map pages, copy data. */
-static int elf_load_segment(const Elf64_Phdr *phdr, const void *data,
-                            size_t file_size, uint64_t pml4_phys,
-                            uint64_t hhdm, uint64_t *highest_addr) {
+/* Validate a PT_LOAD segment's placement and file bounds. */
+static int elf_check_segment(const Elf64_Phdr *phdr, uint64_t file_size) {
     /* Verify segment is in user space */
     if (phdr->p_vaddr >= USER_VADDR_MAX ||
         phdr->p_vaddr + phdr->p_memsz > USER_VADDR_MAX) {
@@ -82,15 +80,35 @@ static int elf_load_segment(const Elf64_Phdr *phdr, const void *data,
         kprintf("[ELF] Segment file data extends past file\n");
         return -EINVAL;
     }
+    if (phdr->p_filesz > phdr->p_memsz) {
+        kprintf("[ELF] Segment file size exceeds memory size\n");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/* Validate a PT_INTERP header: a NUL-terminated path inside the file. The
+ * path's bytes are checked by whoever reads it. */
+static int elf_check_interp(const Elf64_Phdr *phdr, uint64_t file_size) {
+    if (phdr->p_filesz < 2 || phdr->p_filesz > ELF_INTERP_MAX ||
+        phdr->p_offset + phdr->p_filesz > file_size) {
+        kprintf("[ELF] Bad interpreter path\n");
+        return -EINVAL;
+    }
+    return 0;
+}
 
+/* Load a single PT_LOAD segment: map pages, copy data. */
+static int elf_load_segment(const ElfSegment *seg, const void *data,
+                            uint64_t pml4_phys, uint64_t hhdm) {
     /* Convert ELF flags to VMM flags */
     uint32_t vmm_flags = VMM_FLAG_USER;
-    if (phdr->p_flags & PF_W) vmm_flags |= VMM_FLAG_WRITABLE;
-    if (!(phdr->p_flags & PF_X)) vmm_flags |= VMM_FLAG_NOEXEC;
+    if (seg->flags & PF_W) vmm_flags |= VMM_FLAG_WRITABLE;
+    if (!(seg->flags & PF_X)) vmm_flags |= VMM_FLAG_NOEXEC;
 
     /* Map pages for this segment */
-    uint64_t seg_start = PAGE_ALIGN_DOWN(phdr->p_vaddr);
-    uint64_t seg_end = PAGE_ALIGN_UP(phdr->p_vaddr + phdr->p_memsz);
+    uint64_t seg_start = PAGE_ALIGN_DOWN(seg->vaddr);
+    uint64_t seg_end = PAGE_ALIGN_UP(seg->vaddr + seg->memsz);
 
     for (uint64_t vaddr = seg_start; vaddr < seg_end; vaddr += PAGE_SIZE) {
         uint64_t phys = pmm_alloc_page();
@@ -101,25 +119,19 @@ static int elf_load_segment(const Elf64_Phdr *phdr, const void *data,
 
         void *page_virt = (void *)(phys + hhdm);
         memset(page_virt, 0, PAGE_SIZE);
-        elf_copy_page_data(page_virt, vaddr, phdr, data);
+        elf_copy_page_data(page_virt, vaddr, seg, data);
         vmm_map_page_in(pml4_phys, vaddr, phys, vmm_flags);
     }
 
-    /* Track highest loaded address for brk */
-    uint64_t seg_top = phdr->p_vaddr + phdr->p_memsz;
-    if (seg_top > *highest_addr) {
-        *highest_addr = seg_top;
-    }
-
     kprintf("[ELF] Loaded segment: vaddr=0x%lx memsz=0x%lx filesz=0x%lx flags=%s%s%s\n",
-            phdr->p_vaddr, phdr->p_memsz, phdr->p_filesz,
-            (phdr->p_flags & PF_R) ? "r" : "-",
-            (phdr->p_flags & PF_W) ? "w" : "-",
-            (phdr->p_flags & PF_X) ? "x" : "-");
+            seg->vaddr, seg->memsz, seg->filesz,
+            (seg->flags & PF_R) ? "r" : "-",
+            (seg->flags & PF_W) ? "w" : "-",
+            (seg->flags & PF_X) ? "x" : "-");
     return 0;
 }
 
-int elf_load(const void *data, size_t size, uint64_t pml4_phys, ElfLoadResult *result) {
+int elf_parse(const void *data, size_t size, uint64_t file_size, ElfLoadResult *result) {
     if (data == NULL || result == NULL || size < sizeof(Elf64_Ehdr)) {
         return -EINVAL;
     }
@@ -129,20 +141,93 @@ int elf_load(const void *data, size_t size, uint64_t pml4_phys, ElfLoadResult *r
     if (err != 0) return err;
 
     uint64_t highest_addr = 0;
-    uint64_t hhdm = vmm_get_hhdm_offset();
-
-    /* Process each program header */
+    result->nsegs = 0;
+    result->type = ehdr->e_type;
+    result->phnum = ehdr->e_phnum;
+    result->phentsize = ehdr->e_phentsize;
+    result->phdr = 0;
+    result->interp_offset = 0;
+    result->interp_size = 0;
+
+    /* Collect each loadable program header */
     for (uint16_t i = 0; i < ehdr->e_phnum; i++) {
         const Elf64_Phdr *phdr = (const Elf64_Phdr *)
             ((const uint8_t *)data + ehdr->e_phoff + i * ehdr->e_phentsize);
 
+        if (phdr->p_type == PT_INTERP) {
+            err = elf_check_interp(phdr, file_size);
+            if (err != 0) return err;
+            result->interp_offset = phdr->p_offset;
+            result->interp_size = phdr->p_filesz;
+            continue;
+        }
+        if (phdr->p_type == PT_PHDR) {
+            result->phdr = phdr->p_vaddr;
+            continue;
+        }
         if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0) continue;
-        err = elf_load_segment(phdr, data, size, pml4_phys, hhdm, &highest_addr);
+        err = elf_check_segment(phdr, file_size);
         if (err != 0) return err;
+        if (result->nsegs == ELF_MAX_SEGMENTS) {
+            kprintf("[ELF] More than %u loadable segments\n", (uint32_t)ELF_MAX_SEGMENTS);
+            return -EINVAL;
+        }
+
+        ElfSegment *seg = &result->segs[result->nsegs++];
+        seg->vaddr  = phdr->p_vaddr;
+        seg->memsz  = phdr->p_memsz;
+        seg->offset = phdr->p_offset;
+        seg->filesz = phdr->p_filesz;
+        seg->flags  = phdr->p_flags;
+
+        /* Without PT_PHDR, the headers are wherever their bytes load */
+        if (result->phdr == 0 && phdr->p_offset <= ehdr->e_phoff &&
+            ehdr->e_phoff < phdr->p_offset + phdr->p_filesz) {
+            result->phdr = phdr->p_vaddr + (ehdr->e_phoff - phdr->p_offset);
+        }
+
+        /* Track highest loaded address for brk */
+        uint64_t seg_top = phdr->p_vaddr + phdr->p_memsz;
+        if (seg_top > highest_addr) {
+            highest_addr = seg_top;
+        }
     }
 
     result->entry_point = ehdr->e_entry;
     result->brk_start = PAGE_ALIGN_UP(highest_addr);
+    return 0;
+}
+
+int elf_rebase(ElfLoadResult *result, uint64_t base, uint64_t limit) {
+    if (result == NULL || result->type != ET_DYN) return -EINVAL;
+    if ((base & (PAGE_SIZE - 1)) != 0 || base > limit ||
+        result->brk_start > limit - base) {
+        kprintf("[ELF] Shared object does not fit at 0x%lx\n", base);
+        return -EINVAL;
+    }
+
+    for (uint32_t i = 0; i < result->nsegs; i++) {
+        result->segs[i].vaddr += base;
+    }
+    result->entry_point += base;
+    if (result->phdr != 0) result->phdr += base;
+    result->brk_start += base;
+    return 0;
+}
+
+int elf_load(const void *data, size_t size, uint64_t pml4_phys, ElfLoadResult *result) {
+    int err = elf_parse(data, size, size, result);
+    if (err != 0) return err;
+    if (result->type != ET_EXEC || result->interp_size != 0) {
+        kprintf("[ELF] Not a static executable\n");
+        return -EINVAL;
+    }
+
+    uint64_t hhdm = vmm_get_hhdm_offset();
+    for (uint32_t i = 0; i < result->nsegs; i++) {
+        err = elf_load_segment(&result->segs[i], data, pml4_phys, hhdm);
+        if (err != 0) return err;
+    }
 
     kprintf("[ELF] Loaded: entry=0x%lx brk_start=0x%lx\n",
             result->entry_point, result->brk_start);
@@ -27,6 +27,7 @@
 
 /* ELF type */
 #define ET_EXEC     2
+#define ET_DYN      3       /* Shared object (position-independent) */
 
 /* Machine type */
 #define EM_X86_64   62
@@ -34,12 +35,27 @@
 /* Program header type */
 #define PT_NULL     0
 #define PT_LOAD     1
+#define PT_DYNAMIC  2
+#define PT_INTERP   3
+#define PT_PHDR     6
 
 /* Program header flags */
 #define PF_X        (1 << 0)
 #define PF_W        (1 << 1)
 #define PF_R        (1 << 2)
 
+/* Auxiliary vector entry types, passed on the initial user stack */
+#define AT_NULL     0
+#define AT_PHDR     3       /* Program headers of the executable */
+#define AT_PHENT    4
+#define AT_PHNUM    5
+#define AT_PAGESZ   6
+#define AT_BASE     7       /* Load address of the interpreter */
+#define AT_ENTRY    9       /* Entry point of the executable */
+
+/* Longest PT_INTERP path, including the NUL */
+#define ELF_INTERP_MAX 128
+
 /* ELF64 file header */
 typedef struct {
     uint8_t  e_ident[EI_NIDENT];
@@ -70,13 +86,54 @@ typedef struct {
     uint64_t p_align;
 } Elf64_Phdr;
 
+/* Maximum PT_LOAD segments per binary */
+#define ELF_MAX_SEGMENTS 8
+
+/* A validated PT_LOAD segment */
+typedef struct {
+    uint64_t vaddr;
+    uint64_t memsz;
+    uint64_t offset;        /* File offset of vaddr */
+    uint64_t filesz;
+    uint32_t flags;         /* PF_* */
+} ElfSegment;
+
 /* Result of loading an ELF binary */
 typedef struct {
-    uint64_t entry_point;   /* Virtual address of ELF entry */
-    uint64_t brk_start;     /* First address past last loaded segment (page-aligned) */
+    uint64_t   entry_point; /* Virtual address of ELF entry */
+    uint64_t   brk_start;   /* First address past last loaded segment (page-aligned) */
+    uint16_t   type;        /* ET_EXEC or ET_DYN */
+    uint16_t   phnum;
+    uint16_t   phentsize;
+    uint64_t   phdr;        /* Virtual address of the program headers, or 0 */
+    uint64_t   interp_offset; /* PT_INTERP path in the file (interp_size 0: none) */
+    uint64_t   interp_size;
+    uint32_t   nsegs;
+    ElfSegment segs[ELF_MAX_SEGMENTS];
 } ElfLoadResult;
 
-/* Load an ELF64 binary into a process's address space.
+/* Demand-paged view of an exec'd binary: which file pages back which
+ * user addresses. Filled in by exec, consulted by the page-fault handler. */
+struct PagerFile;
+typedef struct {
+    struct PagerFile *file; /* Cached file contents (holds a reference), or NULL */
+    uint32_t          nsegs;
+    ElfSegment        segs[ELF_MAX_SEGMENTS];
+} ElfMap;
+
+/* Validate an ELF64 header and collect its PT_LOAD segments, mapping nothing.
+ * data: the first `size` bytes of the file (must cover the program headers)
+ * file_size: size of the whole file, for segment bounds checks
+ * Returns 0 on success, negative error code on failure. */
+int elf_parse(const void *data, size_t size, uint64_t file_size, ElfLoadResult *result);
+
+/* Move a parsed ET_DYN object to load address base (page-aligned), shifting
+ * its segments, entry point, program headers and break. The object must end
+ * at or below limit. Returns 0 on success, -EINVAL otherwise. */
+int elf_rebase(ElfLoadResult *result, uint64_t base, uint64_t limit);
+
+/* Load a static ELF64 executable into a process's address space, copying
+ * every page. Shared objects and programs needing an interpreter are refused.
  * data: pointer to ELF file in memory
  * size: size of ELF file
  * pml4_phys: physical address of process's PML4
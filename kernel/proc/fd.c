@@ -1,7 +1,6 @@
 #include "proc/fd.h"
 #include "lib/mem.h"
 #include "mm/kmalloc.h"
-#include "fs/pipe.h"
 
 void fd_table_init(FdTable *table) {
     memset(table, 0, sizeof(FdTable));
@@ -30,19 +29,37 @@ VfsFile *fd_get(FdTable *table, int fd) {
     return &table->entries[fd].file;
 }
 
+void fd_file_addref(VfsFile *file) {
+    VfsNode *node = file->node;
+    if (node != NULL && node->ops != NULL && node->ops->ref != NULL) node->ops->ref(node);
+}
+
+void fd_file_release(VfsFile *file) {
+    VfsNode *node = file->node;
+    if (node != NULL && node->ops != NULL && node->ops->unref != NULL) node->ops->unref(node);
+}
+
+void fd_entry_close(FdEntry *e) {
+    fd_file_release(&e->file);
+    vfs_close(&e->file);
+    e->in_use = 0;
+}
+
+void fd_table_close_all(FdTable *ft) {
+    for (int i = 0; i < MAX_FDS; i++) {
+        if (ft->entries[i].in_use) fd_entry_close(&ft->entries[i]);
+    }
+}
+
 FdTable *fd_table_dup(const FdTable *src) {
     if (src == NULL) return NULL;
     FdTable *dst = kmalloc(sizeof(FdTable), 0);
     if (dst == NULL) return NULL;
     memcpy(dst, src, sizeof(FdTable));
 
-    /* Bump pipe ref counts for the new table's references */
+    /* Take a node reference for each of the new table's open files */
     for (int i = 0; i < MAX_FDS; i++) {
-        if (dst->entries[i].in_use &&
-            dst->entries[i].file.node &&
-            dst->entries[i].file.node->type == VFS_PIPE) {
-            pipe_addref(dst->entries[i].file.node);
-        }
+        if (dst->entries[i].in_use) fd_file_addref(&dst->entries[i].file);
     }
     return dst;
 }
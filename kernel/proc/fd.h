@@ -30,6 +30,20 @@ void fd_free(FdTable *table, int fd);
 /* Get the VfsFile for a file descriptor. Returns NULL if invalid/unused. */
 VfsFile *fd_get(FdTable *table, int fd);
 
+/* A new fd now refers to file (open, dup, fork): take a reference on its
+ * node through the node's ref hook, if it has one. */
+void fd_file_addref(VfsFile *file);
+
+/* An fd referring to file is being closed: drop the reference on its node
+ * through the node's unref hook, if it has one. */
+void fd_file_release(VfsFile *file);
+
+/* Close an fd-table entry, dropping its reference on the open file. */
+void fd_entry_close(FdEntry *e);
+
+/* Close every open fd (critical for pipe EOF signaling). */
+void fd_table_close_all(FdTable *ft);
+
 /* Duplicate an entire fd table. Returns new table or NULL on failure. */
 FdTable *fd_table_dup(const FdTable *src);
 
@@ -9,6 +9,7 @@
 #include "mm/kmalloc.h"
 #include "arch/x86_64/gdt.h"
 #include "arch/x86_64/syscall.h"
+#include "arch/x86_64/percpu.h"
 #include "arch/x86_64/paging.h"
 #include "arch/x86_64/usermode.h"
 #include "lib/kprintf.h"
@@ -52,7 +53,7 @@ static void init_thread_entry(void *arg) {
     /* Set TSS.rsp0 and SYSCALL kernel RSP */
     Thread *t = thread_current();
     gdt_set_kernel_stack(t->kernel_stack_top);
-    syscall_kernel_rsp = t->kernel_stack_top;
+    this_cpu()->kernel_rsp = t->kernel_stack_top;
 
     /* Switch to the process's address space */
     paging_write_cr3(p->page_table);
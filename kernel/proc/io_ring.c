@@ -0,0 +1,439 @@
+/* arc_os — Asynchronous submission/completion rings
+ *
+ * The shared pages hold the header, the SQE array and the CQE array, in
+ * that order.  The kernel reads them through the HHDM so completions can be
+ * posted from any context (workers, the timeout workqueue) regardless of
+ * the current CR3.  Every index the kernel owns has a private copy in the
+ * IoRing; values read back from the shared header are treated as hostile.
+ *
+ * Lifetime: the ring holds one reference for its owner, one per live
+ * worker and one per in-flight request.  Lock order: ring->lock, then the
+ * ring's wait-queue locks. */
+
+#include "proc/io_ring.h"
+#include "proc/process.h"
+#include "proc/thread.h"
+#include "proc/sched.h"
+#include "proc/fd.h"
+#include "arch/x86_64/syscall.h"
+#include "mm/pmm.h"
+#include "mm/vmm.h"
+#include "mm/kmalloc.h"
+#include "fs/vfs.h"
+#include "lib/mem.h"
+#include <stddef.h>
+
+static uint32_t round_up_pow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+/* Drop a reference. Called with ring->lock held; releases it. */
+static void io_ring_put_locked(IoRing *ring) {
+    int last = (--ring->refs == 0);
+    spinlock_release(&ring->lock);
+    if (last) {
+        kfree(ring->reqs);
+        kfree(ring);
+    }
+}
+
+/* Post a CQE. Called with ring->lock held. */
+static void io_ring_post(IoRing *ring, uint64_t user_data, int64_t res) {
+    if (ring->dead) return;
+
+    uint32_t head = __atomic_load_n(&ring->hdr->cq_head, __ATOMIC_ACQUIRE);
+    if (ring->cq_tail - head > ring->cq_mask) {
+        ring->hdr->cq_overflow++;
+        return;
+    }
+
+    IoCqe *cqe = &ring->cqes[ring->cq_tail & ring->cq_mask];
+    cqe->user_data = user_data;
+    cqe->res = (int32_t)res;
+    cqe->flags = 0;
+    ring->cq_tail++;
+    /* Publish the entry before the new tail */
+    __atomic_store_n(&ring->hdr->cq_tail, ring->cq_tail, __ATOMIC_RELEASE);
+}
+
+/* CQEs posted but not yet consumed by user space. Called with ring->lock held. */
+static uint32_t io_ring_cq_ready(IoRing *ring) {
+    return ring->cq_tail - __atomic_load_n(&ring->hdr->cq_head, __ATOMIC_ACQUIRE);
+}
+
+static IoReq *io_req_alloc(IoRing *ring) {
+    IoReq *req = ring->free_reqs;
+    if (req == NULL) return NULL;
+    ring->free_reqs = req->next;
+    req->next = NULL;
+    ring->inflight++;
+    ring->refs++;
+    return req;
+}
+
+/* Complete an in-flight request and drop its reference. */
+static void io_req_complete(IoReq *req, int64_t res) {
+    IoRing *ring = req->ring;
+
+    if (req->file.node != NULL) {
+        fd_file_release(&req->file);
+        req->file.node = NULL;
+    }
+
+    spinlock_acquire(&ring->lock);
+    io_ring_post(ring, req->sqe.user_data, res);
+    req->next = ring->free_reqs;
+    ring->free_reqs = req;
+    ring->inflight--;
+    wq_wake_all(&ring->cq_wq);
+    io_ring_put_locked(ring);
+}
+
+/* --- Operations --- */
+
+/* Run an SQE through the matching syscall, so buffers and fds are checked
+ * exactly as for the synchronous call. */
+static int64_t io_exec(const IoSqe *sqe) {
+    uint64_t fd = (uint64_t)(int64_t)sqe->fd;
+    switch (sqe->opcode) {
+    case IO_OP_READ:
+        return syscall_dispatch(SYS_READ, fd, sqe->addr, sqe->len, 0, 0, 0);
+    case IO_OP_WRITE:
+        return syscall_dispatch(SYS_WRITE, fd, sqe->addr, sqe->len, 0, 0, 0);
+    case IO_OP_SEND:
+        return syscall_dispatch(SYS_SEND, fd, sqe->addr, sqe->len, 0, 0, 0);
+    case IO_OP_RECV:
+        return syscall_dispatch(SYS_RECV, fd, sqe->addr, sqe->len, 0, 0, 0);
+    case IO_OP_ACCEPT:
+        return syscall_dispatch(SYS_ACCEPT, fd, sqe->addr, 0, 0, 0, 0);
+    }
+    return -EINVAL;
+}
+
+/* Regular-file read/write at an explicit offset, or at the file position
+ * when off is IO_OFF_CURRENT. */
+static int64_t io_file_rw(VfsFile *file, const IoSqe *sqe) {
+    if (sqe->off == IO_OFF_CURRENT) return io_exec(sqe);
+
+    uint64_t saved = file->offset;
+    file->offset = sqe->off;
+    int64_t ret = io_exec(sqe);
+    file->offset = saved;
+    return ret;
+}
+
+/* --- Worker pool for operations that may block --- */
+
+/* Worker thread: runs queued requests in syscall context (interrupts off
+ * except while asleep) on behalf of the owner. Exits once the ring is
+ * dead and the queue is drained. */
+static void io_worker_main(void *arg) {
+    IoRing *ring = (IoRing *)arg;
+    uint64_t flags = spin_irq_save();
+
+    spinlock_acquire(&ring->lock);
+    for (;;) {
+        IoReq *req = ring->async_head;
+        if (req == NULL) {
+            if (ring->dead) break;
+            ring->idle_workers++;
+            wq_sleep(&ring->async_wq, &ring->lock);
+            spinlock_acquire(&ring->lock);
+            ring->idle_workers--;
+            continue;
+        }
+
+        ring->async_head = req->next;
+        if (ring->async_head == NULL) ring->async_tail = NULL;
+        int dead = ring->dead;
+        spinlock_release(&ring->lock);
+
+        /* Nobody will read the result of a request that never started */
+        io_req_complete(req, dead ? -ECANCELED : io_exec(&req->sqe));
+
+        spinlock_acquire(&ring->lock);
+    }
+    Thread *self = thread_current();
+    for (uint32_t i = 0; i < IO_RING_WORKERS; i++) {
+        if (ring->workers[i] == self) ring->workers[i] = NULL;
+    }
+    ring->nr_workers--;
+    io_ring_put_locked(ring);
+
+    spin_irq_restore(flags);
+}
+
+/* Start another worker. Called with ring->lock held. */
+static int io_ring_spawn_worker(IoRing *ring) {
+    Thread *t = thread_create(io_worker_main, ring);
+    if (t == NULL) return -ENOMEM;
+    if (proc_attach_thread(ring->owner, t) != 0) {
+        thread_destroy(t);
+        return -EAGAIN;
+    }
+    /* Workers run requests for the owner, in its scheduling class */
+    sched_fork(t, ring->owner->main_thread);
+    for (uint32_t i = 0; i < IO_RING_WORKERS; i++) {
+        if (ring->workers[i] == NULL) {
+            ring->workers[i] = t;
+            break;
+        }
+    }
+    ring->nr_workers++;
+    ring->refs++;
+    sched_add_thread(t);
+    return 0;
+}
+
+/* Hand a request to the worker pool, growing it up to IO_RING_WORKERS.
+ * Called with ring->lock held. Returns non-zero if no worker exists. */
+static int io_queue_async(IoRing *ring, IoReq *req) {
+    if (ring->idle_workers == 0 && ring->nr_workers < IO_RING_WORKERS) {
+        io_ring_spawn_worker(ring);
+    }
+    if (ring->nr_workers == 0) return -EAGAIN;
+
+    req->next = NULL;
+    if (ring->async_tail) {
+        ring->async_tail->next = req;
+    } else {
+        ring->async_head = req;
+    }
+    ring->async_tail = req;
+    wq_wake(&ring->async_wq);
+    return 0;
+}
+
+static void io_timeout_fn(Work *work) {
+    IoReq *req = (IoReq *)((uint8_t *)work - offsetof(IoReq, work));
+    io_req_complete(req, -ETIME);
+}
+
+/* --- Submission --- */
+
+/* Regular files never wait on another party (ramfs is in memory and
+ * virtio-blk polls for completion), so they complete inline. */
+static int io_is_inline_file(const VfsFile *file) {
+    return file != NULL && file->node != NULL && file->node->type == VFS_FILE;
+}
+
+/* Take a free request slot for `sqe`, or NULL if all are in flight. */
+static IoReq *io_req_get(IoRing *ring, const IoSqe *sqe) {
+    spinlock_acquire(&ring->lock);
+    IoReq *req = io_req_alloc(ring);
+    spinlock_release(&ring->lock);
+    if (req != NULL) {
+        req->sqe = *sqe;
+        req->file.node = NULL;
+    }
+    return req;
+}
+
+/* Pin the node behind an async request's fd until it completes: the owner
+ * may close the fd, or exit, while a worker still sleeps on the node. The
+ * op itself goes through the fd again and fails if it has gone. */
+static void io_req_hold_file(IoReq *req, Process *p) {
+    VfsFile *file = NULL;
+    if (req->sqe.fd >= 0 && p->fd_table != NULL) file = fd_get(p->fd_table, req->sqe.fd);
+    if (file == NULL || file->node == NULL) return;
+    req->file = *file;
+    fd_file_addref(&req->file);
+}
+
+/* Consume one SQE. Errors in the request itself are reported through its
+ * CQE; returns -EBUSY only if no request slot is free, in which case the
+ * SQE is left on the ring. Called without ring->lock, since inline file
+ * I/O can take a while on the block device. */
+static int io_submit_one(IoRing *ring, const IoSqe *sqe) {
+    Process *p = ring->owner;
+    VfsFile *file = NULL;
+    IoReq *req;
+    int64_t res;
+
+    switch (sqe->opcode) {
+    case IO_OP_NOP:
+        res = 0;
+        break;
+
+    case IO_OP_READ:
+    case IO_OP_WRITE:
+    case IO_OP_FSYNC:
+        if (sqe->fd >= 0 && p->fd_table != NULL) {
+            file = fd_get(p->fd_table, sqe->fd);
+        }
+        if (io_is_inline_file(file)) {
+            res = (sqe->opcode == IO_OP_FSYNC) ? vfs_fsync(file) : io_file_rw(file, sqe);
+            break;
+        }
+        if (sqe->opcode == IO_OP_FSYNC) {
+            res = (file == NULL) ? -EBADF : -EINVAL;
+            break;
+        }
+        /* Pipes, sockets and the TTY may block */
+        /* fall through */
+    case IO_OP_SEND:
+    case IO_OP_RECV:
+    case IO_OP_ACCEPT: {
+        req = io_req_get(ring, sqe);
+        if (req == NULL) return -EBUSY;
+        io_req_hold_file(req, p);
+        spinlock_acquire(&ring->lock);
+        int queued = (io_queue_async(ring, req) == 0);
+        spinlock_release(&ring->lock);
+        if (!queued) {
+            /* No worker could be started: run it here instead */
+            io_req_complete(req, io_exec(&req->sqe));
+        }
+        return 0;
+    }
+
+    case IO_OP_TIMEOUT:
+        req = io_req_get(ring, sqe);
+        if (req == NULL) return -EBUSY;
+        work_init(&req->work, io_timeout_fn);
+        queue_delayed_work(&req->work, sqe->off);
+        return 0;
+
+    default:
+        res = -EINVAL;
+        break;
+    }
+
+    spinlock_acquire(&ring->lock);
+    io_ring_post(ring, sqe->user_data, res);
+    spinlock_release(&ring->lock);
+    return 0;
+}
+
+/* --- Syscall entry points --- */
+
+int64_t io_ring_setup(uint32_t entries) {
+    Process *p = proc_current();
+    if (p == NULL || p->page_table == 0) return -EINVAL;
+    if (entries == 0 || entries > IO_RING_MAX_ENTRIES) return -EINVAL;
+    if (p->io_ring != NULL) return -EEXIST;
+
+    uint32_t sq_entries = round_up_pow2(entries);
+    uint32_t cq_entries = sq_entries * 2;
+    uint32_t sq_off = (sizeof(IoRingHeader) + 63) & ~63U;
+    uint32_t cq_off = sq_off + sq_entries * sizeof(IoSqe);
+    uint32_t size = cq_off + cq_entries * sizeof(IoCqe);
+    uint32_t nr_pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    IoRing *ring = kmalloc(sizeof(IoRing), GFP_ZERO);
+    if (ring == NULL) return -ENOMEM;
+    ring->reqs = kmalloc(cq_entries * sizeof(IoReq), GFP_ZERO);
+    uint64_t phys = pmm_alloc_contiguous(nr_pages);
+    if (ring->reqs == NULL || phys == 0) {
+        if (phys) {
+            for (uint32_t i = 0; i < nr_pages; i++) pmm_free_page(phys + i * PAGE_SIZE);
+        }
+        kfree(ring->reqs);
+        kfree(ring);
+        return -ENOMEM;
+    }
+
+    uint8_t *base = (uint8_t *)(phys + vmm_get_hhdm_offset());
+    memset(base, 0, nr_pages * PAGE_SIZE);
+    for (uint32_t i = 0; i < nr_pages; i++) {
+        uint64_t vaddr = IO_RING_USER_BASE + i * PAGE_SIZE;
+        /* A fork child inherits a private copy of the parent's ring pages */
+        uint64_t stale = vmm_get_phys_in(p->page_table, vaddr);
+        if (stale) pmm_free_page(stale & ~(uint64_t)(PAGE_SIZE - 1));
+        vmm_map_page_in(p->page_table, vaddr, phys + i * PAGE_SIZE,
+                        VMM_FLAG_USER | VMM_FLAG_WRITABLE | VMM_FLAG_NOEXEC);
+    }
+
+    ring->lock = (Spinlock)SPINLOCK_INIT;
+    ring->owner = p;
+    ring->hdr = (IoRingHeader *)base;
+    ring->sqes = (IoSqe *)(base + sq_off);
+    ring->cqes = (IoCqe *)(base + cq_off);
+    ring->sq_mask = sq_entries - 1;
+    ring->cq_mask = cq_entries - 1;
+    ring->phys = phys;
+    ring->nr_pages = nr_pages;
+    wq_init(&ring->async_wq);
+    wq_init(&ring->cq_wq);
+    ring->refs = 1;
+
+    for (uint32_t i = 0; i < cq_entries; i++) {
+        ring->reqs[i].ring = ring;
+        ring->reqs[i].next = ring->free_reqs;
+        ring->free_reqs = &ring->reqs[i];
+    }
+
+    ring->hdr->sq_mask = ring->sq_mask;
+    ring->hdr->sq_entries = sq_entries;
+    ring->hdr->cq_mask = ring->cq_mask;
+    ring->hdr->cq_entries = cq_entries;
+    ring->hdr->sq_off = sq_off;
+    ring->hdr->cq_off = cq_off;
+
+    p->io_ring = ring;
+    return (int64_t)IO_RING_USER_BASE;
+}
+
+int64_t io_ring_enter(uint32_t to_submit, uint32_t min_complete) {
+    Process *p = proc_current();
+    IoRing *ring = (p != NULL) ? p->io_ring : NULL;
+    if (ring == NULL) return -EINVAL;
+
+    /* The SQ side belongs to the owner's thread; no lock needed */
+    uint32_t avail = __atomic_load_n(&ring->hdr->sq_tail, __ATOMIC_ACQUIRE)
+                     - ring->sq_head;
+    if (avail > ring->sq_mask + 1) avail = ring->sq_mask + 1;
+    if (to_submit > avail) to_submit = avail;
+
+    uint32_t done = 0;
+    int err = 0;
+    while (done < to_submit) {
+        /* Copy once: user space may rewrite the slot underneath us */
+        IoSqe sqe = ring->sqes[ring->sq_head & ring->sq_mask];
+        err = io_submit_one(ring, &sqe);
+        if (err != 0) break;
+        ring->sq_head++;
+        done++;
+    }
+    __atomic_store_n(&ring->hdr->sq_head, ring->sq_head, __ATOMIC_RELEASE);
+
+    spinlock_acquire(&ring->lock);
+    if (min_complete > ring->cq_mask + 1) min_complete = ring->cq_mask + 1;
+    while (io_ring_cq_ready(ring) < min_complete && ring->inflight > 0) {
+        wq_sleep(&ring->cq_wq, &ring->lock);
+        spinlock_acquire(&ring->lock);
+    }
+    spinlock_release(&ring->lock);
+
+    if (done == 0 && err != 0) return err;
+    return done;
+}
+
+int io_ring_release(Process *p, int busy_check) {
+    IoRing *ring = p->io_ring;
+    if (ring == NULL) return 0;
+
+    spinlock_acquire(&ring->lock);
+    if (busy_check && ring->inflight > 0) {
+        spinlock_release(&ring->lock);
+        return -EBUSY;
+    }
+    ring->dead = 1;
+    p->io_ring = NULL;
+    wq_wake_all(&ring->async_wq);
+    io_ring_put_locked(ring);
+    return 0;
+}
+
+void io_ring_setscheduler(Process *p, int policy, int priority) {
+    IoRing *ring = p->io_ring;
+    if (ring == NULL) return;
+
+    spinlock_acquire(&ring->lock);
+    for (uint32_t i = 0; i < IO_RING_WORKERS; i++) {
+        if (ring->workers[i] != NULL) sched_setscheduler(ring->workers[i], policy, priority);
+    }
+    spinlock_release(&ring->lock);
+}
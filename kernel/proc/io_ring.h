@@ -0,0 +1,148 @@
+#ifndef ARCHOS_PROC_IO_RING_H
+#define ARCHOS_PROC_IO_RING_H
+
+#include <stdint.h>
+#include "proc/spinlock.h"
+#include "proc/waitqueue.h"
+#include "proc/workqueue.h"
+#include "fs/vfs.h"
+
+/* Asynchronous I/O rings (io_uring-style).
+ *
+ * A process maps one submission queue (SQ) and one completion queue (CQ)
+ * shared with the kernel.  It fills SQEs and advances sq_tail, then calls
+ * SYS_IO_RING_ENTER once for the whole batch; results appear as CQEs that
+ * user space reaps by reading cq_tail and advancing cq_head, with no
+ * syscall.
+ *
+ * Regular-file read/write/fsync and NOPs complete inline during enter.
+ * Operations that may block (sockets, pipes, the TTY) are handed to a
+ * small pool of per-ring worker threads that run in the owner's address
+ * space; timeouts ride on the kernel workqueue's delayed work.
+ *
+ * The layout below is ABI: libc/include/io_ring.h mirrors it. */
+
+/* --- Shared layout --- */
+
+#define IO_RING_MAX_ENTRIES  128        /* SQ entries; CQ is twice as large */
+#define IO_RING_USER_BASE    0x00007F0000000000ULL  /* Fixed user mapping */
+
+/* Opcodes */
+#define IO_OP_NOP      0
+#define IO_OP_READ     1
+#define IO_OP_WRITE    2
+#define IO_OP_FSYNC    3
+#define IO_OP_SEND     4
+#define IO_OP_RECV     5
+#define IO_OP_ACCEPT   6
+#define IO_OP_TIMEOUT  7
+
+/* IoSqe.off value meaning "use and advance the file position" */
+#define IO_OFF_CURRENT ((uint64_t)-1)
+
+/* Submission queue entry */
+typedef struct {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t reserved;
+    int32_t  fd;
+    uint64_t off;           /* File offset, or timeout in ms */
+    uint64_t addr;          /* User buffer */
+    uint32_t len;
+    uint32_t reserved2;
+    uint64_t user_data;     /* Copied to the CQE untouched */
+} IoSqe;
+
+/* Completion queue entry */
+typedef struct {
+    uint64_t user_data;
+    int32_t  res;           /* Syscall-style result: >= 0 or -errno */
+    uint32_t flags;
+} IoCqe;
+
+/* Ring header at the start of the mapping. Indices are free-running and
+ * masked on use. User space writes sq_tail and cq_head; the kernel writes
+ * everything else. */
+typedef struct {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+    uint32_t cq_entries;
+    uint32_t cq_overflow;   /* Completions dropped because the CQ was full */
+    uint32_t sq_off;        /* Byte offset of the IoSqe array */
+    uint32_t cq_off;        /* Byte offset of the IoCqe array */
+    uint32_t reserved;
+} IoRingHeader;
+
+/* --- Kernel side --- */
+
+#define IO_RING_WORKERS    2    /* Blocking ops in flight at once, per ring */
+#define IO_RING_MAX_PAGES  4
+
+struct IoRing;
+struct Process;
+
+/* In-flight request: a private copy of its SQE */
+typedef struct IoReq {
+    struct IoReq  *next;
+    Work           work;        /* Timeout expiry */
+    struct IoRing *ring;
+    IoSqe          sqe;
+    VfsFile        file;        /* Async ops: the fd's file, holding a node
+                                   reference until completion */
+} IoReq;
+
+typedef struct IoRing {
+    Spinlock        lock;
+    struct Process *owner;
+    IoRingHeader   *hdr;        /* Kernel (HHDM) view of the shared pages */
+    IoSqe          *sqes;
+    IoCqe          *cqes;
+    uint32_t        sq_head;    /* Authoritative copies of the kernel-owned */
+    uint32_t        cq_tail;    /* fields; user space may scribble on hdr */
+    uint32_t        sq_mask;
+    uint32_t        cq_mask;
+    uint64_t        phys;       /* Physically contiguous shared pages */
+    uint32_t        nr_pages;
+
+    IoReq          *reqs;       /* cq_entries requests, one per CQE slot */
+    IoReq          *free_reqs;
+    IoReq          *async_head; /* Waiting for a worker */
+    IoReq          *async_tail;
+    uint32_t        nr_workers;
+    uint32_t        idle_workers;
+    Thread         *workers[IO_RING_WORKERS];  /* Live workers; NULL slots free */
+    WaitQueue       async_wq;   /* Idle workers */
+    WaitQueue       cq_wq;      /* IO_RING_ENTER waiting for completions */
+
+    uint32_t        inflight;
+    uint32_t        refs;       /* Owner + live workers + in-flight requests */
+    uint8_t         dead;       /* Owner exited or exec'd */
+} IoRing;
+
+/* SYS_IO_RING_SETUP: map a ring of `entries` SQEs (rounded up to a power of
+ * two) into the calling process. Returns the user address of the header,
+ * or -EINVAL / -EEXIST / -ENOMEM. */
+int64_t io_ring_setup(uint32_t entries);
+
+/* SYS_IO_RING_ENTER: consume up to `to_submit` SQEs, then wait until at
+ * least `min_complete` CQEs are available. Returns the number of SQEs
+ * consumed, or a negative errno if none could be. */
+int64_t io_ring_enter(uint32_t to_submit, uint32_t min_complete);
+
+/* Detach the process's ring on exit or exec. In-flight requests still
+ * complete, but their CQEs are dropped. With `busy_check` set, fails with
+ * -EBUSY instead if requests are in flight (their buffers would vanish
+ * with the old address space). */
+int io_ring_release(struct Process *p, int busy_check);
+
+/* Move the process's ring workers to a new scheduling policy, as
+ * sched_setscheduler does for its main thread (which new workers inherit
+ * from). The policy must already have been accepted for the main thread. */
+void io_ring_setscheduler(struct Process *p, int policy, int priority);
+
+#endif /* ARCHOS_PROC_IO_RING_H */
@@ -0,0 +1,207 @@
+/* arc_os — Shared file mappings (mmap/munmap) */
+
+#include "proc/mmap.h"
+#include "proc/process.h"
+#include "fs/shmfs.h"
+#include "mm/pmm.h"
+#include "mm/vmm.h"
+#include "mm/kmalloc.h"
+
+static uint64_t region_end(const MmapRegion *r) {
+    return r->start + r->pages * PAGE_SIZE;
+}
+
+/* Is [addr, addr + size) page-aligned and inside the mmap window? */
+static int mmap_range_ok(uint64_t addr, uint64_t size) {
+    if ((addr & (PAGE_SIZE - 1)) != 0) return 0;
+    return addr >= USER_MMAP_BASE && addr < USER_MMAP_END &&
+           size <= USER_MMAP_END - addr;
+}
+
+static int mmap_range_free(const Process *p, uint64_t addr, uint64_t size) {
+    for (const MmapRegion *r = p->mmaps; r != NULL; r = r->next) {
+        if (r->start < addr + size && region_end(r) > addr) return 0;
+    }
+    return 1;
+}
+
+/* The hint if that range is free, else the lowest gap that fits */
+static uint64_t mmap_find_gap(const Process *p, uint64_t hint, uint64_t size) {
+    if (hint != 0 && mmap_range_ok(hint, size) && mmap_range_free(p, hint, size)) {
+        return hint;
+    }
+    uint64_t cand = USER_MMAP_BASE;
+    for (const MmapRegion *r = p->mmaps; r != NULL; r = r->next) {
+        if (cand + size <= r->start) break;
+        if (region_end(r) > cand) cand = region_end(r);
+    }
+    return mmap_range_ok(cand, size) ? cand : 0;
+}
+
+static uint32_t mmap_vmm_flags(uint32_t prot) {
+    uint32_t flags = VMM_FLAG_USER | VMM_FLAG_SHARED;
+    if (prot & PROT_WRITE) flags |= VMM_FLAG_WRITABLE;
+    if (!(prot & PROT_EXEC)) flags |= VMM_FLAG_NOEXEC;
+    return flags;
+}
+
+static void mmap_unmap_pages(Process *p, uint64_t lo, uint64_t hi) {
+    for (uint64_t va = lo; va < hi; va += PAGE_SIZE) {
+        vmm_unmap_page_in(p->page_table, va);
+    }
+}
+
+static void mmap_insert(Process *p, MmapRegion *region) {
+    MmapRegion **link = &p->mmaps;
+    while (*link != NULL && (*link)->start < region->start) link = &(*link)->next;
+    region->next = *link;
+    *link = region;
+}
+
+int64_t mmap_map(Process *p, uint64_t addr, uint64_t len, uint32_t prot,
+                 uint32_t flags, const VfsFile *file, uint64_t off) {
+    /* A vfork child's address space is its parent's */
+    if (p == NULL || p->page_table == 0 || p->vfork_parent != NULL) return -EINVAL;
+    if (len == 0 || len > USER_MMAP_END - USER_MMAP_BASE) return -EINVAL;
+    if ((off & (PAGE_SIZE - 1)) != 0) return -EINVAL;
+    if ((flags & (MAP_SHARED | MAP_PRIVATE)) != MAP_SHARED) return -EINVAL;
+    if (!shmfs_is_object(file->node)) return -ENODEV;
+
+    uint32_t acc = file->flags & O_ACCMODE;
+    if (acc == O_WRONLY) return -EACCES;
+    if ((prot & PROT_WRITE) && acc != O_RDWR) return -EACCES;
+
+    /* The whole range must lie within the object */
+    uint64_t size = PAGE_ALIGN_UP(len);
+    if (off > file->node->size || size > PAGE_ALIGN_UP(file->node->size) - off) {
+        return -EINVAL;
+    }
+
+    if (flags & MAP_FIXED) {
+        if (!mmap_range_ok(addr, size)) return -EINVAL;
+        int err = mmap_unmap(p, addr, size);
+        if (err != 0) return err;
+    } else {
+        addr = mmap_find_gap(p, addr, size);
+        if (addr == 0) return -ENOMEM;
+    }
+
+    MmapRegion *region = kmalloc(sizeof(MmapRegion), GFP_ZERO);
+    if (region == NULL) return -ENOMEM;
+    region->start = addr;
+    region->pages = size / PAGE_SIZE;
+    region->pgoff = off / PAGE_SIZE;
+    region->prot = prot;
+    region->node = file->node;
+
+    /* Map every page now; PROT_NONE leaves the range reserved but unmapped */
+    if (prot != PROT_NONE) {
+        uint32_t vflags = mmap_vmm_flags(prot);
+        for (uint64_t i = 0; i < region->pages; i++) {
+            uint64_t phys = shmfs_frame(file->node, region->pgoff + i);
+            if (phys == 0) {
+                mmap_unmap_pages(p, addr, addr + i * PAGE_SIZE);
+                kfree(region);
+                return -ENOMEM;
+            }
+            vmm_map_page_in(p->page_table, addr + i * PAGE_SIZE, phys, vflags);
+        }
+    }
+
+    shmfs_map_get(file->node);
+    mmap_insert(p, region);
+    return (int64_t)addr;
+}
+
+int mmap_unmap(Process *p, uint64_t addr, uint64_t len) {
+    if (len == 0 || len > USER_MMAP_END - USER_MMAP_BASE) return -EINVAL;
+    uint64_t end = addr + PAGE_ALIGN_UP(len);
+    if (!mmap_range_ok(addr, end - addr)) return -EINVAL;
+
+    /* Only a mapping reaching past both ends of the range is split in two;
+     * allocate its second half before changing anything */
+    MmapRegion *spare = NULL;
+    for (MmapRegion *r = p->mmaps; r != NULL; r = r->next) {
+        if (r->start < addr && region_end(r) > end) {
+            spare = kmalloc(sizeof(MmapRegion), 0);
+            if (spare == NULL) return -ENOMEM;
+            break;
+        }
+    }
+
+    MmapRegion **link = &p->mmaps;
+    MmapRegion *r;
+    while ((r = *link) != NULL) {
+        uint64_t rend = region_end(r);
+        if (rend <= addr || r->start >= end) {
+            link = &r->next;
+            continue;
+        }
+
+        uint64_t lo = (r->start > addr) ? r->start : addr;
+        uint64_t hi = (rend < end) ? rend : end;
+        mmap_unmap_pages(p, lo, hi);
+
+        if (lo == r->start && hi == rend) {
+            *link = r->next;
+            shmfs_map_put(r->node);
+            kfree(r);
+            continue;
+        }
+        if (lo == r->start) {
+            r->pgoff += (hi - r->start) / PAGE_SIZE;
+            r->start = hi;
+            r->pages = (rend - hi) / PAGE_SIZE;
+        } else if (hi == rend) {
+            r->pages = (lo - r->start) / PAGE_SIZE;
+        } else {
+            *spare = *r;
+            spare->start = hi;
+            spare->pgoff = r->pgoff + (hi - r->start) / PAGE_SIZE;
+            spare->pages = (rend - hi) / PAGE_SIZE;
+            r->pages = (lo - r->start) / PAGE_SIZE;
+            r->next = spare;
+            shmfs_map_get(r->node);
+            spare = NULL;
+        }
+        link = &r->next;
+    }
+    kfree(spare);
+    return 0;
+}
+
+int mmap_fork(Process *child, const Process *parent) {
+    MmapRegion **tail = &child->mmaps;
+    for (const MmapRegion *r = parent->mmaps; r != NULL; r = r->next) {
+        MmapRegion *copy = kmalloc(sizeof(MmapRegion), 0);
+        if (copy == NULL) {
+            /* The child never ran: its page tables go with it */
+            for (MmapRegion *c = child->mmaps; c != NULL; ) {
+                MmapRegion *next = c->next;
+                shmfs_map_put(c->node);
+                kfree(c);
+                c = next;
+            }
+            child->mmaps = NULL;
+            return -ENOMEM;
+        }
+        *copy = *r;
+        copy->next = NULL;
+        shmfs_map_get(copy->node);
+        *tail = copy;
+        tail = &copy->next;
+    }
+    return 0;
+}
+
+void mmap_release(Process *p) {
+    MmapRegion *r = p->mmaps;
+    p->mmaps = NULL;
+    while (r != NULL) {
+        MmapRegion *next = r->next;
+        mmap_unmap_pages(p, r->start, region_end(r));
+        shmfs_map_put(r->node);
+        kfree(r);
+        r = next;
+    }
+}
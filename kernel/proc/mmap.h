@@ -0,0 +1,57 @@
+#ifndef ARCHOS_PROC_MMAP_H
+#define ARCHOS_PROC_MMAP_H
+
+#include <stdint.h>
+#include "fs/vfs.h"
+
+/* File mappings made with mmap.
+ *
+ * Only shared mappings of /dev/shm objects are supported: every page of
+ * the range is mapped at mmap time to the object's own frame, so all
+ * processes mapping the object share its memory.  The frames belong to
+ * the object (VMM_FLAG_SHARED), and each mapping holds a reference on it.
+ * Mappings are placed in [USER_MMAP_BASE, USER_MMAP_END), are inherited
+ * across fork and go away on exec and exit.
+ *
+ * The constants below are ABI: libc/include/sys/mman.h mirrors them. */
+
+#define PROT_NONE   0x0
+#define PROT_READ   0x1
+#define PROT_WRITE  0x2
+#define PROT_EXEC   0x4
+
+#define MAP_SHARED   0x01
+#define MAP_PRIVATE  0x02
+#define MAP_FIXED    0x10
+
+/* One mapped range of a process, in its sorted list */
+typedef struct MmapRegion {
+    uint64_t           start;
+    uint64_t           pages;
+    uint64_t           pgoff;   /* Object page mapped at start */
+    uint32_t           prot;
+    VfsNode           *node;
+    struct MmapRegion *next;
+} MmapRegion;
+
+struct Process;
+
+/* Map len bytes of file, from page-aligned offset off, into p. addr is a
+ * hint, or the exact address with MAP_FIXED (replacing what is there).
+ * Returns the address, or -EINVAL, -EACCES (prot exceeds the open mode),
+ * -ENODEV (not a shared memory object) or -ENOMEM. */
+int64_t mmap_map(struct Process *p, uint64_t addr, uint64_t len, uint32_t prot,
+                 uint32_t flags, const VfsFile *file, uint64_t off);
+
+/* Unmap every mapped page in [addr, addr + len), trimming or splitting
+ * mappings that straddle the range. Returns 0, -EINVAL or -ENOMEM. */
+int mmap_unmap(struct Process *p, uint64_t addr, uint64_t len);
+
+/* fork: give child references to copies of parent's mappings (the pages
+ * themselves come across with the address space). Returns 0 or -ENOMEM. */
+int mmap_fork(struct Process *child, const struct Process *parent);
+
+/* exec/exit: unmap all of p's mappings and drop their references. */
+void mmap_release(struct Process *p);
+
+#endif /* ARCHOS_PROC_MMAP_H */
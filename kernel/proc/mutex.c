@@ -5,28 +5,102 @@ void mutex_init(Mutex *m) {
     m->guard = (Spinlock)SPINLOCK_INIT;
     m->owner = NULL;
     wq_init(&m->waiters);
+    m->held_next = NULL;
 }
 
+/* --- Priority inheritance --- */
+
+/* Highest priority among m's waiters (0 if none). */
+static uint8_t mutex_top_waiter_prio(Mutex *m) {
+    uint8_t prio = 0;
+    spinlock_acquire(&m->waiters.lock);
+    for (Thread *t = m->waiters.head; t != NULL; t = t->next) {
+        if (t->prio > prio) prio = t->prio;
+    }
+    spinlock_release(&m->waiters.lock);
+    return prio;
+}
+
+/* Lend prio to m's owner, and on along the chain of mutexes the owners
+ * are themselves blocked on. */
+static void mutex_pi_boost(Mutex *m, uint8_t prio) {
+    for (int depth = 0; m != NULL && depth < MUTEX_PI_MAX_DEPTH; depth++) {
+        Thread *owner = m->owner;
+        if (owner == NULL || owner->prio >= prio) return;
+        sched_set_inherited_prio(owner, prio);
+        m = owner->pi_blocked_on;
+        /* A blocked owner moves up among that mutex's waiters too */
+        if (m != NULL) wq_requeue(&m->waiters, owner);
+    }
+}
+
+/* Priority t is owed by the waiters of the mutexes it still holds. */
+static uint8_t mutex_pi_inherited(Thread *t) {
+    uint8_t prio = 0;
+    for (Mutex *m = t->pi_held; m != NULL; m = m->held_next) {
+        uint8_t w = mutex_top_waiter_prio(m);
+        if (w > prio) prio = w;
+    }
+    return prio;
+}
+
+static void mutex_take(Mutex *m, Thread *self) {
+    m->owner = self;
+    m->held_next = self->pi_held;
+    self->pi_held = m;
+}
+
+static void mutex_untake(Mutex *m, Thread *self) {
+    Mutex **link = &self->pi_held;
+    while (*link != NULL && *link != m) link = &(*link)->held_next;
+    if (*link == m) *link = m->held_next;
+    m->held_next = NULL;
+    m->owner = NULL;
+}
+
+/* --- Lock operations --- */
+
 void mutex_lock(Mutex *m) {
+    Thread *self = thread_current();
     spinlock_acquire(&m->guard);
 
     while (m->owner != NULL) {
+        self->pi_blocked_on = m;
+        mutex_pi_boost(m, self->prio);
+
         /* Sleep until woken by mutex_unlock.  Re-check in loop because
          * another thread may acquire between our wakeup and guard re-acquire. */
         wq_sleep(&m->waiters, &m->guard);
         spinlock_acquire(&m->guard);
     }
 
-    m->owner = thread_current();
+    self->pi_blocked_on = NULL;
+    mutex_take(m, self);
+
+    /* Waiters still queued now lend their priority to us */
+    uint8_t waiter_prio = mutex_top_waiter_prio(m);
+    if (waiter_prio > self->pi_priority) {
+        sched_set_inherited_prio(self, waiter_prio);
+    }
     spinlock_release(&m->guard);
 }
 
 void mutex_unlock(Mutex *m) {
+    Thread *self = thread_current();
     spinlock_acquire(&m->guard);
-    m->owner = NULL;
-    /* Wake one waiter — they will set themselves as owner */
+    mutex_untake(m, self);
+
+    /* Keep only what the waiters of other held mutexes still lend us */
+    if (self->pi_priority != 0) {
+        sched_set_inherited_prio(self, mutex_pi_inherited(self));
+    }
+
+    /* Wake the highest-priority waiter — it will set itself as owner */
     wq_wake(&m->waiters);
     spinlock_release(&m->guard);
+
+    /* Run the waiter now if it outranks us */
+    sched_preempt_check();
 }
 
 int mutex_trylock(Mutex *m) {
@@ -35,7 +109,7 @@ int mutex_trylock(Mutex *m) {
         spinlock_release(&m->guard);
         return -1;
     }
-    m->owner = thread_current();
+    mutex_take(m, thread_current());
     spinlock_release(&m->guard);
     return 0;
 }
@@ -9,26 +9,37 @@
  *
  * MUST NOT be acquired from interrupt context (will deadlock).
  * NOT recursive — re-locking from the same thread is undefined behavior.
- * Interrupts remain enabled while blocked (unlike spinlocks). */
-typedef struct {
-    Spinlock  guard;      /* Protects internal state */
-    Thread   *owner;      /* Current holder (NULL if unlocked) */
-    WaitQueue waiters;    /* Threads waiting to acquire */
+ * Interrupts remain enabled while blocked (unlike spinlocks).
+ *
+ * Priority inheritance: while a thread waits, the owner (and whatever
+ * owner it in turn waits for, up to MUTEX_PI_MAX_DEPTH) runs at no less
+ * than the waiter's priority, so a low-priority holder cannot keep a
+ * real-time waiter blocked behind medium-priority work. */
+typedef struct Mutex {
+    Spinlock      guard;      /* Protects internal state */
+    Thread       *owner;      /* Current holder (NULL if unlocked) */
+    WaitQueue     waiters;    /* Threads waiting to acquire */
+    struct Mutex *held_next;  /* Owner's list of held mutexes */
 } Mutex;
 
 #define MUTEX_INIT { \
     .guard = SPINLOCK_INIT, \
     .owner = NULL, \
-    .waiters = WAITQUEUE_INIT \
+    .waiters = WAITQUEUE_INIT, \
+    .held_next = NULL \
 }
 
+/* Longest chain of owners a waiter's priority is passed along */
+#define MUTEX_PI_MAX_DEPTH 8
+
 /* Initialize a mutex. */
 void mutex_init(Mutex *m);
 
 /* Acquire the mutex.  Blocks (sleeps) if already held by another thread. */
 void mutex_lock(Mutex *m);
 
-/* Release the mutex.  Wakes one blocked waiter if any. */
+/* Release the mutex.  Wakes the highest-priority waiter, if any, and drops
+ * any priority the caller inherited through it. */
 void mutex_unlock(Mutex *m);
 
 /* Try to acquire without blocking.  Returns 0 on success, -1 if busy. */
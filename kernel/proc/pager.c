@@ -0,0 +1,319 @@
+/* arc_os — Demand paging for exec'd binaries
+ *
+ * One table of cached binaries, keyed by VfsNode and validated against the
+ * node's inode number, size and data generation. Entries nobody maps stay
+ * cached and are evicted least-recently-used when a slot is needed; a
+ * stale or evicted entry that is still mapped leaves the table and is
+ * freed with its last reference. */
+
+#include "proc/pager.h"
+#include "proc/process.h"
+#include "proc/spinlock.h"
+#include "mm/vmm.h"
+#include "mm/pmm.h"
+#include "mm/kmalloc.h"
+#include "arch/x86_64/isr.h"
+#include "arch/x86_64/paging.h"
+#include "lib/mem.h"
+#include "lib/kprintf.h"
+
+/* Maximum user-space virtual address (canonical lower half) */
+#define USER_VADDR_MAX 0x0000800000000000ULL
+
+/* Page-fault error code bits */
+#define PFERR_PRESENT  (1 << 0)
+#define PFERR_WRITE    (1 << 1)
+
+static PagerFile *cache[PAGER_MAX_FILES];
+static Spinlock pager_lock = SPINLOCK_INIT;
+static uint64_t use_clock;
+static PagerStats stats;
+
+static inline void *frame_virt(uint64_t phys) {
+    return (void *)(phys + vmm_get_hhdm_offset());
+}
+
+/* --- File cache --- */
+
+static void pager_free(PagerFile *f) {
+    for (uint32_t i = 0; i < f->nr_pages; i++) {
+        pmm_free_page(f->pages[i]);
+    }
+    kfree(f->pages);
+    kfree(f);
+}
+
+/* Take slot i out of the table. Returns the entry if nobody maps it (the
+ * caller frees it outside the lock), else NULL. Caller holds pager_lock. */
+static PagerFile *pager_evict(int i) {
+    PagerFile *f = cache[i];
+    cache[i] = NULL;
+    f->cached = 0;
+    return (f->refs == 0) ? f : NULL;
+}
+
+/* Read the whole file into fresh frames. */
+static int pager_fill(VfsNode *node, PagerFile **out) {
+    PagerFile *f = kmalloc(sizeof(PagerFile), GFP_ZERO);
+    if (f == NULL) return -ENOMEM;
+    f->node = node;
+    f->inode_num = node->inode_num;
+    f->size = node->size;
+    f->data_gen = node->data_gen;
+
+    uint32_t nr_pages = (uint32_t)(PAGE_ALIGN_UP(f->size) / PAGE_SIZE);
+    f->pages = kmalloc(nr_pages * sizeof(uint64_t), 0);
+    if (f->pages == NULL) { kfree(f); return -ENOMEM; }
+
+    VfsFile file = { .node = node, .offset = 0, .flags = O_RDONLY };
+    int err = 0;
+    while (f->nr_pages < nr_pages) {
+        uint64_t phys = pmm_alloc_page();
+        if (phys == 0) { err = -ENOMEM; break; }
+        f->pages[f->nr_pages++] = phys;
+
+        void *dst = frame_virt(phys);
+        memset(dst, 0, PAGE_SIZE);
+        uint64_t left = f->size - (uint64_t)(f->nr_pages - 1) * PAGE_SIZE;
+        uint32_t len = (left < PAGE_SIZE) ? (uint32_t)left : PAGE_SIZE;
+        if (vfs_read(&file, dst, len) != (int)len) { err = -EIO; break; }
+    }
+    if (err != 0) {
+        pager_free(f);
+        return err;
+    }
+    *out = f;
+    return 0;
+}
+
+/* Put a new entry in a free slot, or in place of the least recently used
+ * unmapped one. With every slot mapped, the entry stays uncached. Returns
+ * an evicted entry for the caller to free. Caller holds pager_lock. */
+static PagerFile *pager_insert(PagerFile *f) {
+    int slot = -1;
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        if (cache[i] == NULL) { slot = i; break; }
+        if (cache[i]->refs == 0 &&
+            (slot < 0 || cache[i]->last_used < cache[slot]->last_used)) {
+            slot = i;
+        }
+    }
+    if (slot < 0) return NULL;
+
+    PagerFile *victim = (cache[slot] != NULL) ? pager_evict(slot) : NULL;
+    cache[slot] = f;
+    f->cached = 1;
+    return victim;
+}
+
+int pager_open(VfsNode *node, PagerFile **out) {
+    if (node == NULL || out == NULL) return -EINVAL;
+    if (node->size == 0 || node->size > PAGER_MAX_FILE_SIZE) return -EINVAL;
+
+    PagerFile *stale = NULL;
+    spinlock_acquire(&pager_lock);
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        PagerFile *f = cache[i];
+        if (f == NULL || f->node != node) continue;
+        if (f->inode_num == node->inode_num && f->size == node->size &&
+            f->data_gen == node->data_gen) {
+            f->refs++;
+            f->last_used = ++use_clock;
+            stats.hits++;
+            spinlock_release(&pager_lock);
+            *out = f;
+            return 0;
+        }
+        /* The file changed since it was cached */
+        stale = pager_evict(i);
+        break;
+    }
+    stats.misses++;
+    spinlock_release(&pager_lock);
+    if (stale != NULL) pager_free(stale);
+
+    PagerFile *f;
+    int err = pager_fill(node, &f);
+    if (err != 0) return err;
+
+    spinlock_acquire(&pager_lock);
+    f->refs = 1;
+    f->last_used = ++use_clock;
+    PagerFile *victim = pager_insert(f);
+    spinlock_release(&pager_lock);
+    if (victim != NULL) pager_free(victim);
+
+    *out = f;
+    return 0;
+}
+
+void pager_put(PagerFile *file) {
+    if (file == NULL) return;
+    spinlock_acquire(&pager_lock);
+    int dead = (--file->refs == 0 && !file->cached);
+    spinlock_release(&pager_lock);
+    if (dead) pager_free(file);
+}
+
+void pager_mark_library(PagerFile *file) {
+    spinlock_acquire(&pager_lock);
+    file->shared_lib = 1;
+    spinlock_release(&pager_lock);
+}
+
+const void *pager_page_data(const PagerFile *file, uint64_t index) {
+    if (index >= file->nr_pages) return NULL;
+    return frame_virt(file->pages[index]);
+}
+
+void pager_map_copy(ElfMap *dst, const ElfMap *src) {
+    *dst = *src;
+    if (dst->file == NULL) return;
+    spinlock_acquire(&pager_lock);
+    dst->file->refs++;
+    spinlock_release(&pager_lock);
+}
+
+void pager_map_release(ElfMap *map) {
+    PagerFile *f = map->file;
+    memset(map, 0, sizeof(*map));
+    pager_put(f);
+}
+
+void pager_get_stats(PagerStats *out) {
+    spinlock_acquire(&pager_lock);
+    *out = stats;
+    out->files = 0;
+    out->cached_pages = 0;
+    out->lib_files = 0;
+    out->lib_pages = 0;
+    out->lib_maps = 0;
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        if (cache[i] == NULL) continue;
+        out->files++;
+        out->cached_pages += cache[i]->nr_pages;
+        if (cache[i]->shared_lib) {
+            out->lib_files++;
+            out->lib_pages += cache[i]->nr_pages;
+            out->lib_maps += cache[i]->refs;
+        }
+    }
+    spinlock_release(&pager_lock);
+}
+
+/* --- Fault handling --- */
+
+/* The cached frame that can back `page` of seg as-is, or 0 if the page
+ * needs a private frame: the segment is not page-congruent with the file,
+ * or the page holds BSS that must read as zero. */
+static uint64_t pager_shared_frame(const PagerFile *f, const ElfSegment *seg,
+                                   uint64_t page) {
+    if (((seg->vaddr - seg->offset) & (PAGE_SIZE - 1)) != 0) return 0;
+
+    uint64_t file_end = seg->vaddr + seg->filesz;
+    if (page >= file_end) return 0;
+    if (page + PAGE_SIZE > file_end && seg->memsz > seg->filesz) return 0;
+
+    /* page may start below seg->vaddr; congruence keeps this >= 0 */
+    uint64_t off = seg->offset - (seg->vaddr - page);
+    uint64_t index = off / PAGE_SIZE;
+    return (index < f->nr_pages) ? f->pages[index] : 0;
+}
+
+/* Copy the file bytes seg places in `page` into dst (a zeroed frame). */
+static void pager_copy_segment(const PagerFile *f, const ElfSegment *seg,
+                               uint64_t page, uint8_t *dst) {
+    uint64_t start = (seg->vaddr > page) ? seg->vaddr : page;
+    uint64_t end = seg->vaddr + seg->filesz;
+    if (end > page + PAGE_SIZE) end = page + PAGE_SIZE;
+
+    while (start < end) {
+        uint64_t off = seg->offset + (start - seg->vaddr);
+        uint64_t in_page = off & (PAGE_SIZE - 1);
+        uint64_t len = PAGE_SIZE - in_page;
+        if (len > end - start) len = end - start;
+
+        const uint8_t *src = pager_page_data(f, off / PAGE_SIZE);
+        if (src == NULL) break;
+        memcpy(dst + (start - page), src + in_page, len);
+        start += len;
+    }
+}
+
+int pager_fault(uint64_t pml4, const ElfMap *map, uint64_t vaddr, int write) {
+    uint64_t page = PAGE_ALIGN_DOWN(vaddr);
+    const ElfSegment *seg = NULL;
+    for (uint32_t i = 0; i < map->nsegs; i++) {
+        const ElfSegment *s = &map->segs[i];
+        if (page >= PAGE_ALIGN_DOWN(s->vaddr) &&
+            page < PAGE_ALIGN_UP(s->vaddr + s->memsz)) {
+            seg = s;
+            break;
+        }
+    }
+    if (seg == NULL || map->file == NULL) return -EFAULT;
+    if (write && !(seg->flags & PF_W)) return -EFAULT;
+
+    uint32_t flags = VMM_FLAG_USER;
+    if (seg->flags & PF_W) flags |= VMM_FLAG_WRITABLE;
+    if (!(seg->flags & PF_X)) flags |= VMM_FLAG_NOEXEC;
+
+    uint64_t frame = pager_shared_frame(map->file, seg, page);
+    if (frame != 0 && !(write && (seg->flags & PF_W))) {
+        /* Text maps the cached frame; data does too, until written */
+        if (seg->flags & PF_W) {
+            flags = (flags & ~VMM_FLAG_WRITABLE) | VMM_FLAG_COW;
+        }
+        vmm_map_page_in(pml4, page, frame, flags | VMM_FLAG_SHARED);
+        __atomic_fetch_add(&stats.shared_faults, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    uint64_t phys = pmm_alloc_page();
+    if (phys == 0) return -ENOMEM;
+    uint8_t *dst = frame_virt(phys);
+    memset(dst, 0, PAGE_SIZE);
+    pager_copy_segment(map->file, seg, page, dst);
+    vmm_map_page_in(pml4, page, phys, flags);
+    __atomic_fetch_add(&stats.private_faults, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* #PF: resolve faults on lazily mapped or copy-on-write user pages, from
+ * user mode or from the kernel touching user buffers. Anything else is
+ * fatal, as before. */
+static void pager_page_fault(InterruptFrame *frame) {
+    uint64_t addr = paging_read_cr2();
+    int write = (frame->error_code & PFERR_WRITE) != 0;
+    int err = -EFAULT;
+
+    Process *p = proc_current();
+    if (p != NULL && addr < USER_VADDR_MAX) {
+        uint64_t pml4 = paging_read_cr3() & PTE_ADDR_MASK;
+        if (frame->error_code & PFERR_PRESENT) {
+            if (write) {
+                err = vmm_resolve_cow(pml4, addr);
+                if (err == 0) {
+                    __atomic_fetch_add(&stats.cow_copies, 1, __ATOMIC_RELAXED);
+                }
+            }
+        } else {
+            /* A vfork child runs in its parent's address space */
+            const Process *owner = (p->vfork_parent != NULL) ? p->vfork_parent : p;
+            if (pml4 == owner->page_table) {
+                err = pager_fault(pml4, &owner->image.map, addr, write);
+                if (err == -EFAULT) {
+                    err = pager_fault(pml4, &owner->image.interp, addr, write);
+                }
+            }
+        }
+    }
+
+    if (err != 0) isr_unhandled_exception(frame);
+}
+
+void pager_init(void) {
+    isr_register_handler(EXCEPTION_PAGE_FAULT, pager_page_fault);
+    kprintf("[PAGER] Demand paging enabled (%u cached binaries)\n",
+            (uint32_t)PAGER_MAX_FILES);
+}
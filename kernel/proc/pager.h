@@ -0,0 +1,85 @@
+#ifndef ARCHOS_PROC_PAGER_H
+#define ARCHOS_PROC_PAGER_H
+
+#include <stdint.h>
+#include "proc/elf.h"
+#include "fs/vfs.h"
+
+/* Demand paging for exec'd binaries.
+ *
+ * exec maps none of a binary's segments up front. The first touch of each
+ * page faults, and the handler maps it from a cache of the file's contents
+ * held in page frames:
+ *   - read-only (text) pages map the cached frame itself, shared by every
+ *     process running the binary;
+ *   - file-backed writable (data) pages map the cached frame copy-on-write;
+ *   - BSS, and pages mixing file bytes with BSS, get a private frame.
+ *
+ * The same applies to libarc.so, the interpreter of dynamically linked
+ * programs, so one copy of its text serves every process.
+ *
+ * A binary is read from its filesystem once, on first exec. Its frames stay
+ * cached while unused, until the slot goes to another file or the file is
+ * written. */
+
+#define PAGER_MAX_FILES      16                 /* Cached binaries */
+#define PAGER_MAX_FILE_SIZE  (16 * 1024 * 1024)
+
+typedef struct PagerFile {
+    VfsNode  *node;
+    uint64_t  inode_num;    /* Identity and version of the cached contents */
+    uint64_t  size;
+    uint32_t  data_gen;
+    uint32_t  refs;         /* ElfMaps using it */
+    uint8_t   cached;       /* Still findable in the cache table */
+    uint8_t   shared_lib;   /* Mapped as a program interpreter */
+    uint64_t  last_used;
+    uint32_t  nr_pages;
+    uint64_t *pages;        /* Frames holding the file, in file order */
+} PagerFile;
+
+typedef struct {
+    uint32_t files;          /* Binaries in the cache */
+    uint64_t cached_pages;   /* Frames they hold */
+    uint64_t hits;           /* exec found the binary cached */
+    uint64_t misses;         /* exec had to read it */
+    uint64_t shared_faults;  /* Faults served by mapping a cached frame */
+    uint64_t private_faults; /* Faults that needed a fresh frame */
+    uint64_t cow_copies;     /* Write faults on copy-on-write data */
+    uint32_t lib_files;      /* Cached shared libraries */
+    uint64_t lib_pages;      /* Frames they hold, mapped once for all users */
+    uint32_t lib_maps;       /* Images mapping them */
+} PagerStats;
+
+/* Register the page-fault handler. */
+void pager_init(void);
+
+/* Get the cached contents of node, reading the file on a miss. The caller
+ * holds a reference on success. Returns 0, -EINVAL (empty or too large),
+ * -ENOMEM or -EIO. */
+int pager_open(VfsNode *node, PagerFile **out);
+
+/* Drop a reference from pager_open. */
+void pager_put(PagerFile *file);
+
+/* Count the file as a shared library in the stats. */
+void pager_mark_library(PagerFile *file);
+
+/* Kernel pointer to page `index` of the file, or NULL past the end. */
+const void *pager_page_data(const PagerFile *file, uint64_t index);
+
+/* Copy an ElfMap, taking another reference on its file. */
+void pager_map_copy(ElfMap *dst, const ElfMap *src);
+
+/* Drop an ElfMap's file reference and clear it. */
+void pager_map_release(ElfMap *map);
+
+/* Map the page holding vaddr into pml4 as `map` describes. `write` is set
+ * for write faults. Returns 0, -EFAULT if no segment covers vaddr (or it
+ * is a write to a read-only segment), or -ENOMEM. */
+int pager_fault(uint64_t pml4, const ElfMap *map, uint64_t vaddr, int write);
+
+/* Snapshot cache and fault counters. */
+void pager_get_stats(PagerStats *out);
+
+#endif /* ARCHOS_PROC_PAGER_H */
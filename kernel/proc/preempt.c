@@ -0,0 +1,87 @@
+/* arc_os — Preemption points and the non-preemptible latency tracer
+ *
+ * A reschedule request records the TSC time it became due.  Whichever
+ * preemption point finally honours it charges the wait to the tracer, so
+ * the maximum is the longest stretch the kernel ran without a chance to
+ * preempt: a spinlock or preempt_disable() section, or a system call
+ * between two cond_resched() points.  A timer tick held off by disabled
+ * interrupts is backdated by the PIT handler to when it was due. */
+
+#include "proc/preempt.h"
+#include "proc/sched.h"
+#include "proc/spinlock.h"
+#include "arch/x86_64/tsc.h"
+
+#define RFLAGS_IF  (1ULL << 9)   /* Interrupt Flag */
+
+volatile int preempt_need_resched;
+static uint64_t resched_due_tsc;    /* When the pending request became due */
+static PreemptStats stats;
+
+void set_need_resched(uint64_t due_tsc) {
+    if (preempt_need_resched) return;
+    resched_due_tsc = due_tsc;
+    preempt_need_resched = 1;
+}
+
+void clear_need_resched(const char *site) {
+    if (!preempt_need_resched) return;
+    preempt_need_resched = 0;
+
+    uint64_t now = tsc_read();
+    uint64_t ns = (now > resched_due_tsc) ? tsc_to_ns(now - resched_due_tsc) : 0;
+    stats.count++;
+    if (ns > stats.max_ns) {
+        stats.max_ns = ns;
+        stats.max_site = site;
+    }
+}
+
+/* True if the current thread may be switched out here. */
+static int preempt_allowed(void) {
+    Thread *t = thread_current();
+    return t != NULL && t->preempt_count == 0 && t->rcu_read_depth == 0;
+}
+
+/* Honour the pending request. Interrupts are disabled. */
+static void preempt_switch(const char *site) {
+    clear_need_resched(site);
+    sched_yield();
+}
+
+void preempt_schedule(void) {
+    if (!preempt_allowed()) return;
+    uint64_t flags = spin_irq_save();
+    /* With interrupts off the caller is still non-preemptible (a system
+     * call, or an explicit cli section); the request stays pending */
+    if ((flags & RFLAGS_IF) && preempt_need_resched) {
+        preempt_switch("preempt_enable");
+    }
+    spin_irq_restore(flags);
+}
+
+void preempt_irq_exit(void) {
+    if (preempt_need_resched && preempt_allowed()) {
+        preempt_switch("irq");
+    }
+}
+
+void preempt_syscall_exit(void) {
+    if (preempt_need_resched && preempt_allowed()) {
+        preempt_switch("syscall");
+    }
+}
+
+void cond_resched(void) {
+    if (!preempt_allowed()) return;
+    uint64_t flags = spin_irq_save();
+    /* Take a timer tick left pending while interrupts were off; its
+     * interrupt exit may already switch */
+    if (!(flags & RFLAGS_IF)) irq_window();
+    if (preempt_need_resched) preempt_switch("cond_resched");
+    spin_irq_restore(flags);
+}
+
+void preempt_get_stats(PreemptStats *out) {
+    *out = stats;
+}
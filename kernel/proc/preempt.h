@@ -0,0 +1,90 @@
+#ifndef ARCHOS_PROC_PREEMPT_H
+#define ARCHOS_PROC_PREEMPT_H
+
+#include <stdint.h>
+#include "proc/thread.h"
+
+/* Kernel preemption.
+ *
+ * Every thread carries a preempt count: spinlocks and preempt_disable()
+ * raise it, and the thread is not preempted while it is non-zero or while
+ * the thread is inside an RCU read-side section.  The scheduler does not
+ * switch from wherever it notices that another thread should run; it sets
+ * need_resched, and the switch happens at the next preemption point:
+ *
+ *   - return from an interrupt that arrived with the count at zero
+ *   - preempt_enable() dropping the count to zero with interrupts on
+ *   - return from a system call
+ *   - cond_resched() in a long-running kernel loop
+ *
+ * System calls run with interrupts off, so inside one only cond_resched()
+ * can preempt: it opens a one-instruction interrupt window to take a
+ * pending timer tick.  Place it only where the caller could also sleep. */
+
+/* Set when a higher-priority thread is ready or the slice has run out */
+extern volatile int preempt_need_resched;
+
+/* Slow path of preempt_enable(): switch if the count is zero, no RCU
+ * reader is active and interrupts are on. */
+void preempt_schedule(void);
+
+/* Disable preemption of the current thread. Nests. */
+static inline void preempt_disable(void) {
+    Thread *t = thread_current();
+    if (t) t->preempt_count++;
+    __asm__ volatile ("" ::: "memory");
+}
+
+/* Re-enable preemption without checking need_resched. */
+static inline void preempt_enable_no_resched(void) {
+    __asm__ volatile ("" ::: "memory");
+    Thread *t = thread_current();
+    if (t) t->preempt_count--;
+}
+
+/* Re-enable preemption; switch now if a reschedule is pending. */
+static inline void preempt_enable(void) {
+    __asm__ volatile ("" ::: "memory");
+    Thread *t = thread_current();
+    if (t && --t->preempt_count == 0 && preempt_need_resched) {
+        preempt_schedule();
+    }
+}
+
+/* Preemption count of the current thread. */
+static inline uint32_t preempt_count(void) {
+    Thread *t = thread_current();
+    return t ? t->preempt_count : 0;
+}
+
+/* Ask for a reschedule at the next preemption point. due_tsc is the TSC
+ * time the switch became due, for the latency tracer; an earlier pending
+ * request keeps its own. */
+void set_need_resched(uint64_t due_tsc);
+
+/* The scheduler is switching: drop the pending request and account the
+ * time it waited. site names the preemption point that honoured it. */
+void clear_need_resched(const char *site);
+
+/* Interrupt exit: preempt the interrupted thread if a reschedule is
+ * pending and it may be preempted. Called with interrupts disabled. */
+void preempt_irq_exit(void);
+
+/* System-call exit: the return to user mode is a preemption point. */
+void preempt_syscall_exit(void);
+
+/* Preemption point for long loops in process context. May switch to
+ * another thread; the caller must hold no spinlock. */
+void cond_resched(void);
+
+/* Latency tracer: how long reschedules waited for a preemption point,
+ * i.e. the longest non-preemptible section seen. */
+typedef struct {
+    uint64_t    count;      /* Reschedules honoured */
+    uint64_t    max_ns;     /* Longest wait for a preemption point */
+    const char *max_site;   /* Preemption point that ended the longest wait */
+} PreemptStats;
+
+void preempt_get_stats(PreemptStats *out);
+
+#endif /* ARCHOS_PROC_PREEMPT_H */
@@ -1,16 +1,26 @@
 #include "proc/process.h"
 #include "proc/sched.h"
 #include "proc/fd.h"
+#include "proc/rcu.h"
+#include "proc/spinlock.h"
+#include "proc/pager.h"
+#include "proc/mmap.h"
+#include "proc/io_ring.h"
+#include "ipc/endpoint.h"
 #include "mm/kmalloc.h"
 #include "mm/vmm.h"
 #include "arch/x86_64/usermode.h"
 #include "arch/x86_64/gdt.h"
 #include "arch/x86_64/syscall.h"
+#include "arch/x86_64/percpu.h"
 #include "arch/x86_64/paging.h"
 #include "lib/kprintf.h"
 #include "lib/string.h"
 
+/* Process list. Readers (proc_get_by_pid) walk it under RCU without locks;
+ * updaters serialize on proc_list_lock and publish with rcu_assign_pointer. */
 static Process *proc_list = NULL;
+static Spinlock proc_list_lock = SPINLOCK_INIT;
 static pid_t next_pid = 0;
 
 /* Simple mapping: each thread's tid maps 1:1 to a process for now.
@@ -27,8 +37,26 @@ static void proc_setup(Process *p) {
     strncpy(p->cwd, "/", PATH_MAX);
     sig_init(&p->sig);
     wq_init(&p->child_exit_wq);
+    wq_init(&p->vfork_wq);
+
+    spinlock_acquire(&proc_list_lock);
     p->next = proc_list;
-    proc_list = p;
+    rcu_assign_pointer(proc_list, p);
+    spinlock_release(&proc_list_lock);
+}
+
+/* Unlink a PCB that never ran and wait out lockless readers before the
+ * caller frees it. */
+static void proc_unpublish(Process *p) {
+    spinlock_acquire(&proc_list_lock);
+    for (Process **pp = &proc_list; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == p) {
+            rcu_assign_pointer(*pp, p->next);
+            break;
+        }
+    }
+    spinlock_release(&proc_list_lock);
+    synchronize_rcu();
 }
 
 void proc_init(void) {
@@ -99,12 +127,17 @@ Process *proc_get_by_tid(uint32_t tid) {
 }
 
 Process *proc_get_by_pid(uint32_t pid) {
-    for (Process *p = proc_list; p != NULL; p = p->next) {
+    Process *found = NULL;
+    rcu_read_lock();
+    for (Process *p = rcu_dereference(proc_list); p != NULL;
+         p = rcu_dereference(p->next)) {
         if (p->pid == pid && p->state != PROC_TERMINATED) {
-            return p;
+            found = p;
+            break;
         }
     }
-    return NULL;
+    rcu_read_unlock();
+    return found;
 }
 
 void proc_set_main_thread(Process *p, Thread *t) {
@@ -114,50 +147,38 @@ void proc_set_main_thread(Process *p, Thread *t) {
     }
 }
 
-/* --- Fork support --- */
-
-/* Data passed to the fork child's kernel thread */
-typedef struct {
-    Process    *child;
-    ForkContext ctx;
-} ForkChildArgs;
+int proc_attach_thread(Process *p, Thread *t) {
+    if (t->tid >= MAX_PROCESSES) return -EAGAIN;
+    proc_table[t->tid] = p;
+    return 0;
+}
 
-static ForkChildArgs g_fork_child_args; /* Single-CPU: only one fork at a time */
+/* --- Fork support --- */
 
-/* Kernel thread entry for the forked child */
+/* Kernel thread entry for the forked child. The user context travels in
+ * the child's own Process, so concurrent forks cannot clobber each other. */
 static void fork_child_entry(void *arg) {
-    ForkChildArgs *args = (ForkChildArgs *)arg;
-    Process *child = args->child;
+    Process *child = (Process *)arg;
 
     /* Set TSS.rsp0 and syscall kernel RSP for this thread */
     Thread *t = thread_current();
     gdt_set_kernel_stack(t->kernel_stack_top);
-    syscall_kernel_rsp = t->kernel_stack_top;
+    this_cpu()->kernel_rsp = t->kernel_stack_top;
 
     /* Switch to child's address space */
     paging_write_cr3(child->page_table);
 
     /* Return to user mode with RAX=0, restoring callee-saved registers */
-    fork_return_to_user(&args->ctx);
+    fork_return_to_user(&child->fork_ctx);
 }
 
-Process *proc_fork(Process *parent, const ForkContext *user_ctx) {
-    if (parent == NULL || parent->page_table == 0) return NULL;
-
-    /* 1. Fork address space */
-    uint64_t child_pml4 = vmm_fork_address_space(parent->page_table);
-    if (child_pml4 == 0) return NULL;
-
-    /* 2. Create child process PCB */
+/* Allocate and publish a child PCB inheriting parent's credentials, cwd and
+ * process group. Returns NULL on allocation failure. */
+static Process *proc_new_child(Process *parent) {
     Process *child = kmalloc(sizeof(Process), GFP_ZERO);
-    if (child == NULL) {
-        vmm_destroy_user_pml4(child_pml4);
-        return NULL;
-    }
+    if (child == NULL) return NULL;
+
     proc_setup(child);
-    child->page_table = child_pml4;
-    child->brk_start = parent->brk_start;
-    child->brk_current = parent->brk_current;
     strncpy(child->cwd, parent->cwd, PATH_MAX);
     child->uid  = parent->uid;
     child->gid  = parent->gid;
@@ -166,28 +187,163 @@ Process *proc_fork(Process *parent, const ForkContext *user_ctx) {
     child->umask = parent->umask;
     child->pgid = parent->pgid;
     child->parent = parent;
+    return child;
+}
 
-    /* 3. Duplicate FD table */
+/* Fork/vfork: the child resumes at user_ctx in the address space pml4.
+ * On failure the caller still owns pml4. */
+static Process *proc_clone(Process *parent, const ForkContext *user_ctx,
+                           uint64_t pml4, int vfork) {
+    /* 1. Create child process PCB */
+    Process *child = proc_new_child(parent);
+    if (child == NULL) return NULL;
+    child->page_table = pml4;
+    child->brk_start = parent->brk_start;
+    child->brk_current = parent->brk_current;
+    if (vfork) {
+        child->vfork_parent = parent;
+    } else {
+        pager_map_copy(&child->image.map, &parent->image.map);
+        pager_map_copy(&child->image.interp, &parent->image.interp);
+    }
+
+    /* 2. Duplicate FD table */
     child->fd_table = fd_table_dup(parent->fd_table);
 
-    /* 4. Create child's kernel thread */
-    g_fork_child_args.child = child;
-    g_fork_child_args.ctx = *user_ctx;
+    /* 3. Create child's kernel thread */
+    child->fork_ctx = *user_ctx;
 
-    Thread *t = thread_create(fork_child_entry, &g_fork_child_args);
+    Thread *t = NULL;
+    if (vfork || mmap_fork(child, parent) == 0) {
+        t = thread_create(fork_child_entry, child);
+    }
     if (t == NULL) {
+        proc_unpublish(child);
+        pager_map_release(&child->image.map);
+        pager_map_release(&child->image.interp);
+        mmap_release(child);
         kfree(child->fd_table);
-        vmm_destroy_user_pml4(child_pml4);
         kfree(child);
         return NULL;
     }
+    sched_fork(t, thread_current());
     proc_set_main_thread(child, t);
     sched_add_thread(t);
+    return child;
+}
+
+Process *proc_fork(Process *parent, const ForkContext *user_ctx) {
+    if (parent == NULL || parent->page_table == 0) return NULL;
+
+    uint64_t child_pml4 = vmm_fork_address_space(parent->page_table);
+    if (child_pml4 == 0) return NULL;
+
+    Process *child = proc_clone(parent, user_ctx, child_pml4, 0);
+    if (child == NULL) {
+        vmm_destroy_user_pml4(child_pml4);
+        return NULL;
+    }
 
     kprintf("[PROC] Forked pid=%u -> pid=%u\n", parent->pid, child->pid);
     return child;
 }
 
+/* --- vfork support --- */
+
+/* Serializes vfork_parent handoff between child and parent */
+static Spinlock vfork_lock = SPINLOCK_INIT;
+
+Process *proc_vfork(Process *parent, const ForkContext *user_ctx) {
+    if (parent == NULL || parent->page_table == 0) return NULL;
+    return proc_clone(parent, user_ctx, parent->page_table, 1);
+}
+
+void proc_vfork_wait(Process *child) {
+    spinlock_acquire(&vfork_lock);
+    while (child->vfork_parent != NULL) {
+        wq_sleep(&child->vfork_parent->vfork_wq, &vfork_lock);
+        spinlock_acquire(&vfork_lock);
+    }
+    spinlock_release(&vfork_lock);
+}
+
+void proc_vfork_release(Process *p) {
+    spinlock_acquire(&vfork_lock);
+    Process *parent = p->vfork_parent;
+    p->vfork_parent = NULL;
+    if (parent != NULL) wq_wake_all(&parent->vfork_wq);
+    spinlock_release(&vfork_lock);
+}
+
+/* --- Exit --- */
+
+void proc_exit(Process *p, int32_t status) {
+    /* Queued ring requests are cancelled; running ones hold their nodes */
+    io_ring_release(p, 0);
+
+    /* Close all open file descriptors */
+    if (p->fd_table != NULL) fd_table_close_all(p->fd_table);
+
+    mmap_release(p);
+    ipc_thread_exit(thread_current());
+    proc_vfork_release(p);
+    pager_map_release(&p->image.map);
+    pager_map_release(&p->image.interp);
+
+    /* Set exit status and mark as zombie for parent to reap */
+    p->exit_status = status;
+    p->state = PROC_ZOMBIE;
+
+    /* Notify parent of child exit */
+    if (p->parent != NULL) {
+        wq_wake(&p->parent->child_exit_wq);
+        sig_send(p->parent->pid, SIGCHLD);
+    }
+
+    thread_current()->state = THREAD_DEAD;
+    sched_yield();
+}
+
+/* --- Spawn support --- */
+
+/* Kernel thread entry for a spawned child: enter the prepared image */
+static void spawn_child_entry(void *arg) {
+    Process *child = (Process *)arg;
+
+    Thread *t = thread_current();
+    gdt_set_kernel_stack(t->kernel_stack_top);
+    this_cpu()->kernel_rsp = t->kernel_stack_top;
+
+    paging_write_cr3(child->page_table);
+    jump_to_usermode(child->image.entry, child->image.user_rsp,
+                     child->image.argc, child->image.argv);
+}
+
+Process *proc_spawn(Process *parent, const UserImage *img, FdTable *fd_table) {
+    if (parent == NULL) return NULL;
+
+    Process *child = proc_new_child(parent);
+    if (child == NULL) return NULL;
+    child->page_table = img->pml4;
+    child->brk_start = img->brk_start;
+    child->brk_current = img->brk_start;
+    child->fd_table = fd_table;
+    child->image = *img;
+
+    Thread *t = thread_create(spawn_child_entry, child);
+    if (t == NULL) {
+        proc_unpublish(child);
+        kfree(child);
+        return NULL;
+    }
+    sched_fork(t, thread_current());
+    proc_set_main_thread(child, t);
+    sched_add_thread(t);
+
+    kprintf("[PROC] Spawned pid=%u -> pid=%u\n", parent->pid, child->pid);
+    return child;
+}
+
 /* --- Zombie/reap helpers --- */
 
 Process *proc_find_zombie_child(Process *parent) {
@@ -4,6 +4,7 @@
 #include "proc/thread.h"
 #include "proc/signal.h"
 #include "proc/waitqueue.h"
+#include "proc/elf.h"
 #include "fs/path.h"
 #include <stdint.h>
 
@@ -31,8 +32,22 @@ typedef struct ForkContext {
     uint64_t user_r15;
 } ForkContext;
 
+/* A freshly loaded user image: what exec or spawn enters */
+typedef struct UserImage {
+    uint64_t pml4;          /* New address space */
+    uint64_t entry;
+    uint64_t user_rsp;
+    uint64_t argc;
+    uint64_t argv;          /* User address of the argv array */
+    uint64_t brk_start;
+    ElfMap   map;           /* Demand-paged segments of the binary */
+    ElfMap   interp;        /* ... and of its interpreter, if dynamically linked */
+} UserImage;
+
 /* Forward declaration */
 typedef struct FdTable FdTable;
+struct IoRing;
+struct MmapRegion;
 
 /* Process Control Block */
 typedef struct Process {
@@ -53,6 +68,12 @@ typedef struct Process {
     uint32_t        umask;          /* File creation permission mask */
     SigState        sig;            /* Per-process signal state */
     WaitQueue       child_exit_wq;  /* Parents sleep here in sys_wait */
+    ForkContext     fork_ctx;       /* Fork child: user context to resume */
+    UserImage       image;          /* Image running (spawn child: to enter) */
+    struct Process *vfork_parent;   /* Suspended parent whose address space we borrow */
+    WaitQueue       vfork_wq;       /* vfork parent sleeps here */
+    struct IoRing  *io_ring;        /* Async I/O ring, or NULL */
+    struct MmapRegion *mmaps;       /* Shared file mappings, by address */
     struct Process *parent;
     struct Process *next;           /* Process list linkage */
 } Process;
@@ -72,16 +93,42 @@ Process *proc_current(void);
 /* Look up process by thread ID. Returns NULL if not found. */
 Process *proc_get_by_tid(uint32_t tid);
 
-/* Look up process by PID. Returns NULL if not found or terminated. */
+/* Look up process by PID. Returns NULL if not found or terminated.
+ * Lockless (RCU); published PCBs are never freed, so the result stays valid. */
 Process *proc_get_by_pid(uint32_t pid);
 
 /* Register a thread as the main thread of a process. */
 void proc_set_main_thread(Process *p, Thread *t);
 
+/* Run an extra kernel thread in p's address space, with proc_current() == p.
+ * Returns 0, or -EAGAIN if the thread's tid cannot be mapped. */
+int proc_attach_thread(Process *p, Thread *t);
+
 /* Fork the current process. Returns child Process* or NULL on failure.
  * The child's thread will return to user_ctx location with RAX=0. */
 Process *proc_fork(Process *parent, const ForkContext *user_ctx);
 
+/* vfork the current process: the child shares the parent's address space
+ * and resumes at user_ctx with RAX=0. Returns NULL on failure. */
+Process *proc_vfork(Process *parent, const ForkContext *user_ctx);
+
+/* Block until a vfork child has exec'd or exited. */
+void proc_vfork_wait(Process *child);
+
+/* Give a borrowed address space back and wake the vfork parent, if any.
+ * Called by the child on exec and exit. */
+void proc_vfork_release(Process *p);
+
+/* Tear down the current process p and leave it a zombie with the given
+ * exit status for its parent to reap; shared by exit and fatal signals.
+ * Switches away for good: the calling thread is dead. */
+void proc_exit(Process *p, int32_t status);
+
+/* Create a child of parent running a prepared image with its own fd table.
+ * Ownership of img->pml4, img->map and fd_table passes to the child on
+ * success; returns NULL (caller still owns them) on failure. */
+Process *proc_spawn(Process *parent, const UserImage *img, FdTable *fd_table);
+
 /* Find a zombie child of the given parent. Returns NULL if none. */
 Process *proc_find_zombie_child(Process *parent);
 
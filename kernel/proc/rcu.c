@@ -0,0 +1,128 @@
+/* arc_os — Read-copy-update grace periods and deferred callbacks
+ *
+ * Grace periods are numbered.  rcu_gp_seq is the newest one started and
+ * rcu_gp_done the newest one completed; a period is in flight while they
+ * differ.  Each CPU records the sequence number current at its last
+ * quiescent state in PerCpu.rcu_qs_seq, and the period completes once every
+ * online, unparked CPU has caught up with it.  Overlapping requests simply
+ * fold into the newest period, since a quiescent state observed after the
+ * newest start also covers every earlier one. */
+
+#include "proc/rcu.h"
+#include "proc/sched.h"
+#include "proc/spinlock.h"
+#include "arch/x86_64/percpu.h"
+
+static Spinlock rcu_lock = SPINLOCK_INIT;
+static volatile uint64_t rcu_gp_seq;    /* Newest grace period started */
+static volatile uint64_t rcu_gp_done;   /* Newest grace period completed */
+
+/* Pending callbacks, FIFO; gp is non-decreasing along the list. */
+static RcuHead *rcu_cb_head;
+static RcuHead **rcu_cb_tail = &rcu_cb_head;
+static uint64_t rcu_cb_last_gp;         /* gp of the newest queued callback */
+
+void rcu_note_qs(void) {
+    PerCpu *cpu = this_cpu();
+    uint64_t seq = __atomic_load_n(&rcu_gp_seq, __ATOMIC_ACQUIRE);
+    if (cpu->rcu_qs_seq != seq || cpu->rcu_parked) {
+        cpu->rcu_parked = 0;
+        __atomic_store_n(&cpu->rcu_qs_seq, seq, __ATOMIC_RELEASE);
+    }
+}
+
+void rcu_cpu_park(void) {
+    PerCpu *cpu = this_cpu();
+    __atomic_store_n(&cpu->rcu_parked, 1, __ATOMIC_RELEASE);
+}
+
+/* Complete the in-flight grace period if every CPU has passed through a
+ * quiescent state, then start another if callbacks are still waiting.
+ * Caller holds rcu_lock. */
+static void rcu_gp_advance(void) {
+    uint64_t seq = rcu_gp_seq;
+    if (rcu_gp_done != seq) {
+        for (uint32_t i = 0; i < cpu_count; i++) {
+            PerCpu *cpu = &percpu_data[i];
+            if (i != 0 && !cpu->online) continue;
+            if (__atomic_load_n(&cpu->rcu_parked, __ATOMIC_ACQUIRE)) continue;
+            if (__atomic_load_n(&cpu->rcu_qs_seq, __ATOMIC_ACQUIRE) < seq) return;
+        }
+        __atomic_store_n(&rcu_gp_done, seq, __ATOMIC_RELEASE);
+    }
+    if (rcu_cb_head && rcu_cb_last_gp > rcu_gp_done) {
+        __atomic_store_n(&rcu_gp_seq, rcu_gp_done + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/* Returns non-zero once grace period `gp` has completed. */
+static int rcu_gp_completed(uint64_t gp) {
+    spinlock_acquire(&rcu_lock);
+    rcu_gp_advance();
+    int done = rcu_gp_done >= gp;
+    spinlock_release(&rcu_lock);
+    return done;
+}
+
+void rcu_check_callbacks(int user_mode) {
+    if (user_mode) rcu_note_qs();
+    spinlock_acquire(&rcu_lock);
+    rcu_gp_advance();
+    spinlock_release(&rcu_lock);
+}
+
+void synchronize_rcu(void) {
+    spinlock_acquire(&rcu_lock);
+    uint64_t gp = rcu_gp_seq + 1;
+    __atomic_store_n(&rcu_gp_seq, gp, __ATOMIC_RELEASE);
+    spinlock_release(&rcu_lock);
+
+    /* We are not in a read-side section, so this CPU is quiescent now;
+     * every yield below is a context switch and reports again. */
+    rcu_note_qs();
+    while (!rcu_gp_completed(gp)) {
+        sched_yield();
+        rcu_note_qs();
+    }
+}
+
+void call_rcu(RcuHead *head, rcu_callback_t func) {
+    head->func = func;
+    head->next = NULL;
+
+    spinlock_acquire(&rcu_lock);
+    /* The callback needs a grace period that starts after this point: start
+     * one now if none is in flight, otherwise the one after the current. */
+    if (rcu_gp_seq == rcu_gp_done) {
+        __atomic_store_n(&rcu_gp_seq, rcu_gp_seq + 1, __ATOMIC_RELEASE);
+        head->gp = rcu_gp_seq;
+    } else {
+        head->gp = rcu_gp_seq + 1;
+    }
+    rcu_cb_last_gp = head->gp;
+    *rcu_cb_tail = head;
+    rcu_cb_tail = &head->next;
+    spinlock_release(&rcu_lock);
+}
+
+void rcu_process_callbacks(void) {
+    spinlock_acquire(&rcu_lock);
+    rcu_gp_advance();
+    RcuHead *ready = NULL;
+    RcuHead **ready_tail = &ready;
+    while (rcu_cb_head && rcu_cb_head->gp <= rcu_gp_done) {
+        RcuHead *h = rcu_cb_head;
+        rcu_cb_head = h->next;
+        *ready_tail = h;
+        ready_tail = &h->next;
+    }
+    *ready_tail = NULL;
+    if (rcu_cb_head == NULL) rcu_cb_tail = &rcu_cb_head;
+    spinlock_release(&rcu_lock);
+
+    while (ready) {
+        RcuHead *h = ready;
+        ready = h->next;
+        h->func(h);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef ARCHOS_PROC_RCU_H
+#define ARCHOS_PROC_RCU_H
+
+#include <stdint.h>
+#include "proc/thread.h"
+
+/* Read-copy-update.
+ *
+ * Readers bracket accesses with rcu_read_lock()/rcu_read_unlock() and load
+ * shared pointers through rcu_dereference().  The read side is a per-thread
+ * nesting counter: no locks, no atomic read-modify-writes, no shared cache
+ * lines.  While the counter is non-zero the timer tick will not preempt the
+ * thread, and a reader must never block.
+ *
+ * Updaters publish new versions with rcu_assign_pointer() and reclaim old
+ * ones only after a grace period — an interval in which every CPU has passed
+ * through a quiescent state (context switch, idle loop, or user mode) and so
+ * cannot still hold a reference obtained before the update.  Use
+ * synchronize_rcu() to wait for one, or call_rcu() to defer a callback. */
+
+/* Deferred-reclaim descriptor — embed in the object being freed. */
+typedef struct RcuHead {
+    struct RcuHead *next;
+    uint64_t        gp;                         /* Grace period to wait for */
+    void          (*func)(struct RcuHead *head);
+} RcuHead;
+
+typedef void (*rcu_callback_t)(RcuHead *head);
+
+/* Enter a read-side critical section. Nests. */
+static inline void rcu_read_lock(void) {
+    Thread *t = thread_current();
+    if (t) t->rcu_read_depth++;
+    __asm__ volatile ("" ::: "memory");
+}
+
+/* Leave a read-side critical section. */
+static inline void rcu_read_unlock(void) {
+    __asm__ volatile ("" ::: "memory");
+    Thread *t = thread_current();
+    if (t) t->rcu_read_depth--;
+}
+
+/* True if the current thread is inside a read-side critical section. */
+static inline int rcu_read_lock_held(void) {
+    Thread *t = thread_current();
+    return t && t->rcu_read_depth > 0;
+}
+
+/* Load an RCU-protected pointer (plain load on x86, ordered for readers). */
+#define rcu_dereference(p)  __atomic_load_n(&(p), __ATOMIC_CONSUME)
+
+/* Publish an RCU-protected pointer: initialization of *v is visible first. */
+#define rcu_assign_pointer(p, v)  __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+/* Report a quiescent state for this CPU. Called on context switch and from
+ * the idle loop; must not be called inside a read-side critical section. */
+void rcu_note_qs(void);
+
+/* Timer-tick hook: records a quiescent state if the tick interrupted user
+ * mode, then advances grace-period bookkeeping. Runs in IRQ context. */
+void rcu_check_callbacks(int user_mode);
+
+/* Mark this CPU as parked: it runs no readers and is ignored by grace
+ * periods until it calls rcu_note_qs() again. */
+void rcu_cpu_park(void);
+
+/* Block until all read-side critical sections in progress have completed.
+ * Process context only; may yield. */
+void synchronize_rcu(void);
+
+/* Queue func(head) to run after a grace period. Safe from IRQ context;
+ * callbacks themselves run later in process context. */
+void call_rcu(RcuHead *head, rcu_callback_t func);
+
+/* Invoke callbacks whose grace period has completed. Process context only
+ * (callbacks typically kfree, and kmalloc is not IRQ-safe). */
+void rcu_process_callbacks(void);
+
+#endif /* ARCHOS_PROC_RCU_H */
@@ -1,20 +1,45 @@
 #include "proc/sched.h"
 #include "proc/process.h"
 #include "proc/spinlock.h"
+#include "proc/rcu.h"
+#include "proc/preempt.h"
 #include "arch/x86_64/gdt.h"
 #include "arch/x86_64/syscall.h"
+#include "arch/x86_64/percpu.h"
 #include "arch/x86_64/paging.h"
+#include "arch/x86_64/tsc.h"
 #include "mm/vmm.h"
 #include "lib/kprintf.h"
 
-/* Run queue: singly-linked FIFO list */
+/* SCHED_NORMAL run queue: singly-linked FIFO list */
 static Thread *queue_head = NULL;
 static Thread *queue_tail = NULL;
 static Thread *idle_thread = NULL;
 static Spinlock sched_lock = SPINLOCK_INIT;
 
+/* Real-time run queues: one FIFO list per priority, and a bitmap of the
+ * non-empty ones so the highest is found in constant time. A thread runs
+ * from the list of its effective priority (prio), so a SCHED_NORMAL thread
+ * boosted through a mutex queues with the real-time threads. */
+static Thread *rt_head[SCHED_PRIO_MAX + 1];
+static Thread *rt_tail[SCHED_PRIO_MAX + 1];
+static uint64_t rt_bitmap[2];
+
+/* Ticks the current SCHED_NORMAL thread has run */
+static uint32_t quantum_ticks;
+
 static void queue_push(Thread *t) {
     t->next = NULL;
+    if (t->prio != 0) {
+        if (rt_tail[t->prio]) {
+            rt_tail[t->prio]->next = t;
+        } else {
+            rt_head[t->prio] = t;
+            rt_bitmap[t->prio / 64] |= 1ULL << (t->prio % 64);
+        }
+        rt_tail[t->prio] = t;
+        return;
+    }
     if (queue_tail) {
         queue_tail->next = t;
     } else {
@@ -23,81 +48,147 @@ static void queue_push(Thread *t) {
     queue_tail = t;
 }
 
-static Thread *queue_pop(void) {
-    if (queue_head == NULL) return NULL;
-    Thread *t = queue_head;
-    queue_head = t->next;
-    if (queue_head == NULL) {
-        queue_tail = NULL;
+/* A preempted real-time thread goes back to the head of its list. */
+static void queue_push_head(Thread *t) {
+    if (t->prio == 0) {
+        queue_push(t);
+        return;
     }
-    t->next = NULL;
-    return t;
+    t->next = rt_head[t->prio];
+    if (t->next == NULL) {
+        rt_tail[t->prio] = t;
+        rt_bitmap[t->prio / 64] |= 1ULL << (t->prio % 64);
+    }
+    rt_head[t->prio] = t;
 }
 
-void sched_init(void) {
-    kprintf("[SCHED] Scheduler initialized (round-robin)\n");
+/* Highest priority with a ready thread: 1..99 for real-time, 0 for
+ * SCHED_NORMAL, -1 if nothing is ready. */
+static int ready_prio(void) {
+    if (rt_bitmap[1] != 0) return 64 + (63 - __builtin_clzll(rt_bitmap[1]));
+    if (rt_bitmap[0] != 0) return 63 - __builtin_clzll(rt_bitmap[0]);
+    return (queue_head != NULL) ? 0 : -1;
 }
 
-void sched_add_thread(Thread *t) {
-    t->state = THREAD_READY;
-    queue_push(t);
+static Thread *queue_pop(void) {
+    int prio = ready_prio();
+    if (prio < 0) return NULL;
+
+    Thread *t;
+    if (prio > 0) {
+        t = rt_head[prio];
+        rt_head[prio] = t->next;
+        if (rt_head[prio] == NULL) {
+            rt_tail[prio] = NULL;
+            rt_bitmap[prio / 64] &= ~(1ULL << (prio % 64));
+        }
+    } else {
+        t = queue_head;
+        queue_head = t->next;
+        if (queue_head == NULL) {
+            queue_tail = NULL;
+        }
+    }
+    t->next = NULL;
+    return t;
 }
 
-void sched_remove_thread(Thread *t) {
-    /* Remove t from the run queue if present */
+/* Unlink t from the list it is queued on. Returns 1 if it was queued. */
+static int queue_remove(Thread *t) {
+    Thread **head = (t->prio != 0) ? &rt_head[t->prio] : &queue_head;
+    Thread **tail = (t->prio != 0) ? &rt_tail[t->prio] : &queue_tail;
+
     Thread *prev = NULL;
-    Thread *cur = queue_head;
+    Thread *cur = *head;
     while (cur) {
         if (cur == t) {
             if (prev) {
                 prev->next = cur->next;
             } else {
-                queue_head = cur->next;
+                *head = cur->next;
+            }
+            if (cur == *tail) {
+                *tail = prev;
             }
-            if (cur == queue_tail) {
-                queue_tail = prev;
+            if (t->prio != 0 && *head == NULL) {
+                rt_bitmap[t->prio / 64] &= ~(1ULL << (t->prio % 64));
             }
             cur->next = NULL;
-            return;
+            return 1;
         }
         prev = cur;
         cur = cur->next;
     }
+    return 0;
 }
 
-static uint64_t proc_get_cr3(Process *proc) {
-    return (proc && proc->page_table) ? proc->page_table : vmm_get_kernel_pml4();
+/* Recompute t's effective priority, moving it between run queues if it
+ * is queued. Caller holds sched_lock. */
+static void sched_update_prio(Thread *t) {
+    uint8_t prio = (t->rt_priority > t->pi_priority) ? t->rt_priority : t->pi_priority;
+    if (prio == t->prio) return;
+
+    int queued = (t->state == THREAD_READY) && queue_remove(t);
+    t->prio = prio;
+    if (queued) queue_push(t);
 }
 
-void sched_schedule(void) {
-    Thread *old = thread_current();
-    Thread *next = queue_pop();
+/* Account one wakeup-to-run latency of a real-time thread. */
+static void sched_record_latency(Thread *t, uint64_t ns) {
+    uint64_t limit = 10000;     /* 10 us */
+    uint32_t bucket = 0;
+    while (bucket < SCHED_LAT_BUCKETS - 1 && ns >= limit) {
+        bucket++;
+        limit *= 10;
+    }
+    t->latency.buckets[bucket]++;
+    t->latency.count++;
+    if (ns > t->latency.max_ns) t->latency.max_ns = ns;
+}
 
-    if (next == NULL) {
-        /* No threads in run queue */
-        if (old->state == THREAD_RUNNING) {
-            return; /* Current thread keeps running */
-        }
-        /* Current can't run — fall back to idle thread */
-        next = idle_thread;
-        if (next == NULL) return; /* Nothing to do */
+void sched_init(void) {
+    kprintf("[SCHED] Scheduler initialized (round-robin, SCHED_FIFO/RR priorities %u-%u)\n",
+            (uint32_t)SCHED_PRIO_MIN, (uint32_t)SCHED_PRIO_MAX);
+}
+
+void sched_add_thread(Thread *t) {
+    uint64_t now = tsc_read();
+    t->state = THREAD_READY;
+    if (t->policy != SCHED_NORMAL) t->wake_tsc = now;
+    queue_push(t);
+
+    /* Preempt the running thread at its next preemption point */
+    Thread *cur = thread_current();
+    if (cur != NULL && (cur == idle_thread || t->prio > cur->prio)) {
+        set_need_resched(now);
     }
+}
 
-    /* Re-enqueue old thread if it's still runnable (not idle — idle only runs
-     * when the queue is empty, so it should never occupy a queue slot). */
-    if (old->state == THREAD_RUNNING && old != idle_thread) {
-        old->state = THREAD_READY;
-        queue_push(old);
+void sched_remove_thread(Thread *t) {
+    /* Remove t from the run queue if present */
+    queue_remove(t);
+}
+
+static uint64_t proc_get_cr3(Process *proc) {
+    return (proc && proc->page_table) ? proc->page_table : vmm_get_kernel_pml4();
+}
+
+/* Make next the running thread and switch to it. Caller holds sched_lock
+ * and has already dealt with old. */
+static void sched_switch(Thread *old, Thread *next) {
+    if (next->wake_tsc != 0) {
+        sched_record_latency(next, tsc_to_ns(tsc_read() - next->wake_tsc));
+        next->wake_tsc = 0;
     }
 
     next->state = THREAD_RUNNING;
     thread_set_current(next);
 
     if (next != old) {
-        /* Update TSS.rsp0 and SYSCALL kernel stack for the new thread */
+        /* Update TSS.rsp0 and this CPU's SYSCALL kernel stack */
         if (next->kernel_stack_top != 0) {
             gdt_set_kernel_stack(next->kernel_stack_top);
-            syscall_kernel_rsp = next->kernel_stack_top;
+            this_cpu()->kernel_rsp = next->kernel_stack_top;
         }
 
         /* Switch CR3 if switching between different address spaces */
@@ -113,13 +204,142 @@ void sched_schedule(void) {
     }
 }
 
+void sched_schedule(void) {
+    /* A context switch is an RCU quiescent state for this CPU */
+    rcu_note_qs();
+    clear_need_resched("schedule");
+
+    Thread *old = thread_current();
+
+    /* A runnable thread keeps the CPU unless something of at least its
+     * priority is ready (equal priority takes turns) */
+    if (old->state == THREAD_RUNNING && (int)old->prio > ready_prio()) {
+        return;
+    }
+
+    Thread *next = queue_pop();
+    if (next == NULL) {
+        /* Current can't run — fall back to idle thread */
+        next = idle_thread;
+        if (next == NULL) return; /* Nothing to do */
+    }
+
+    /* Re-enqueue old thread if it's still runnable (not idle — idle only runs
+     * when the queue is empty, so it should never occupy a queue slot). */
+    if (old->state == THREAD_RUNNING && old != idle_thread) {
+        old->state = THREAD_READY;
+        if (next->prio > old->prio) {
+            queue_push_head(old);
+        } else {
+            queue_push(old);
+        }
+    }
+
+    quantum_ticks = 0;
+    sched_switch(old, next);
+}
+
+void sched_handoff(Thread *next) {
+    spinlock_acquire(&sched_lock);
+    Thread *old = thread_current();
+
+    /* The shortcut must not let next overtake a more urgent thread or skip
+     * a pending reschedule: then next queues like any other wakeup */
+    if (old->state == THREAD_RUNNING || preempt_need_resched ||
+        ready_prio() > (int)next->prio) {
+        next->state = THREAD_READY;
+        queue_push(next);
+        sched_schedule();
+    } else {
+        rcu_note_qs();
+        sched_switch(old, next);
+    }
+    spinlock_release(&sched_lock);
+}
+
 void sched_yield(void) {
     spinlock_acquire(&sched_lock);
     sched_schedule();
     spinlock_release(&sched_lock);
 }
 
+void sched_schedule_tail(void) {
+    /* The switching thread took sched_lock on its own preempt count; take
+     * one here so the release balances on this thread */
+    preempt_disable();
+    spinlock_release(&sched_lock);
+}
+
 void sched_set_idle_thread(Thread *t) {
     idle_thread = t;
     t->state = THREAD_RUNNING;
 }
+
+int sched_tick(void) {
+    Thread *cur = thread_current();
+    int ready = ready_prio();
+
+    if (cur == idle_thread) return ready >= 0;
+    if (ready > (int)cur->prio) return 1;
+
+    if (cur->prio != 0) {
+        /* FIFO (and priority-boosted) threads run until they block */
+        if (cur->policy != SCHED_RR) return 0;
+        if (++cur->rr_ticks < SCHED_RR_TICKS) return 0;
+        cur->rr_ticks = 0;
+        return ready == (int)cur->prio;
+    }
+
+    if (++quantum_ticks < SCHED_QUANTUM) return 0;
+    quantum_ticks = 0;
+    return 1;
+}
+
+/* Switch away if a thread of higher priority than the caller is ready.
+ * Caller holds sched_lock. */
+static void sched_preempt_locked(void) {
+    Thread *cur = thread_current();
+    if (cur->state == THREAD_RUNNING && ready_prio() > (int)cur->prio) {
+        sched_schedule();
+    }
+}
+
+void sched_preempt_check(void) {
+    spinlock_acquire(&sched_lock);
+    sched_preempt_locked();
+    spinlock_release(&sched_lock);
+}
+
+int sched_setscheduler(Thread *t, int policy, int priority) {
+    if (policy == SCHED_NORMAL) {
+        if (priority != 0) return -1;
+    } else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        if (priority < SCHED_PRIO_MIN || priority > SCHED_PRIO_MAX) return -1;
+    } else {
+        return -1;
+    }
+
+    spinlock_acquire(&sched_lock);
+    t->policy = (uint8_t)policy;
+    t->rt_priority = (uint8_t)priority;
+    t->rr_ticks = 0;
+    sched_update_prio(t);
+    /* A caller that just dropped below a ready thread yields to it now */
+    if (t == thread_current()) sched_preempt_locked();
+    spinlock_release(&sched_lock);
+    return 0;
+}
+
+void sched_fork(Thread *child, const Thread *parent) {
+    /* Inherited priority stays with the mutexes' holder */
+    child->policy = parent->policy;
+    child->rt_priority = parent->rt_priority;
+    child->prio = parent->rt_priority;
+}
+
+void sched_set_inherited_prio(Thread *t, uint8_t prio) {
+    spinlock_acquire(&sched_lock);
+    t->pi_priority = prio;
+    sched_update_prio(t);
+    spinlock_release(&sched_lock);
+}
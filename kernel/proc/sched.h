@@ -3,23 +3,73 @@
 
 #include "proc/thread.h"
 
+/* Scheduling policies. SCHED_FIFO and SCHED_RR threads always run before
+ * SCHED_NORMAL ones, the highest priority first. FIFO threads run until
+ * they block or yield; RR threads of equal priority share the CPU in
+ * SCHED_RR_TICKS slices. */
+#define SCHED_NORMAL  0
+#define SCHED_FIFO    1
+#define SCHED_RR      2
+
+/* Real-time priorities; SCHED_NORMAL threads have priority 0 */
+#define SCHED_PRIO_MIN  1
+#define SCHED_PRIO_MAX  99
+
+/* Time slices in timer ticks (10 ms at 100 Hz) */
+#define SCHED_QUANTUM   10
+#define SCHED_RR_TICKS  5
+
 /* Initialize the scheduler. Must be called after thread_init(). */
 void sched_init(void);
 
-/* Add a thread to the run queue. */
+/* Add a thread to the run queue. Requests a reschedule if it should
+ * preempt the running thread. */
 void sched_add_thread(Thread *t);
 
 /* Remove a thread from the run queue. */
 void sched_remove_thread(Thread *t);
 
+/* Switch straight to next, a blocked thread, without passing it through
+ * the run queue; next runs on the rest of the caller's time slice. The
+ * caller must already be blocked. Falls back to a normal wakeup and
+ * reschedule if a thread of higher priority than next is ready or a
+ * reschedule is pending. */
+void sched_handoff(Thread *next);
+
 /* Cooperative yield: disable interrupts, schedule, re-enable. */
 void sched_yield(void);
 
 /* Core scheduling function: pick next thread, context switch.
- * Must be called with interrupts disabled. */
+ * Must be called with interrupts disabled and sched_lock held; use
+ * sched_yield from outside the scheduler. */
 void sched_schedule(void);
 
+/* First step of a new thread: release the sched_lock its creator's switch
+ * left held. A thread resuming in sched_yield releases it there instead. */
+void sched_schedule_tail(void);
+
 /* Set the idle thread (runs when run queue is empty). */
 void sched_set_idle_thread(Thread *t);
 
+/* Timer tick: charge the current thread's time slice. Returns nonzero if
+ * it should be preempted (slice used up, or a higher priority is ready);
+ * the caller then sets need_resched. Called from the timer IRQ with
+ * interrupts disabled. */
+int sched_tick(void);
+
+/* Yield if a thread of higher priority than the caller is ready. */
+void sched_preempt_check(void);
+
+/* Set t's policy and static priority. Returns 0, or -1 if the priority
+ * is out of range for the policy. If t is the caller and a thread of
+ * higher priority is now ready, switches to it before returning. */
+int sched_setscheduler(Thread *t, int policy, int priority);
+
+/* A new thread created on behalf of parent inherits its policy. */
+void sched_fork(Thread *child, const Thread *parent);
+
+/* Set the priority t inherits through priority-inheritance mutexes
+ * (0 for none) and requeue it at its new effective priority. */
+void sched_set_inherited_prio(Thread *t, uint8_t prio);
+
 #endif /* ARCHOS_PROC_SCHED_H */
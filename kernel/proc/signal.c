@@ -7,10 +7,7 @@
 #include "fs/vfs.h"
 #include "lib/mem.h"
 #include "user_access.h"
-
-/* Global: RDI value to pass to signal handler (signo). Set by
- * sig_maybe_deliver, loaded by syscall_entry.asm before SYSRET. */
-uint64_t sig_pending_arg;
+#include "arch/x86_64/percpu.h"
 
 /* Default actions: 0 = terminate, 1 = ignore, 2 = continue, 3 = stop */
 static const uint8_t default_action[NSIG] = {
@@ -91,7 +88,7 @@ static void sig_stop(Process *p, int signo) {
         wq_wake(&p->parent->child_exit_wq);
         sig_send(p->parent->pid, SIGCHLD);
     }
-    sched_schedule();
+    sched_yield();
 }
 
 /* Resume a stopped process */
@@ -104,10 +101,7 @@ static void sig_continue(Process *p) {
 
 /* Terminate a process due to a signal */
 static void sig_terminate(Process *p, int signo) {
-    p->exit_status = 128 + signo;
-    p->state = PROC_ZOMBIE;
-    p->main_thread->state = THREAD_DEAD;
-    sched_schedule();
+    proc_exit(p, 128 + signo);
 }
 
 /* Restore context saved by sigreturn */
@@ -123,7 +117,7 @@ static int64_t sig_restore_context(SigState *ss, SyscallFrame *frame) {
     frame->r13 = sf->r13;
     frame->r14 = sf->r14;
     frame->r15 = sf->r15;
-    sig_pending_arg = 0;
+    this_cpu()->sig_arg = 0;
     return (int64_t)sf->rax;
 }
 
@@ -167,7 +161,7 @@ static int sig_setup_frame(SyscallFrame *frame, sig_handler_t handler,
     frame->r13 = 0;
     frame->r14 = 0;
     frame->r15 = 0;
-    sig_pending_arg = (uint64_t)signo;
+    this_cpu()->sig_arg = (uint64_t)signo;
     return 0;
 }
 
@@ -83,14 +83,13 @@ int sig_send(uint32_t pid, int signo);
 sig_handler_t sig_set_handler(SigState *ss, int signo, sig_handler_t handler);
 
 /* Check and deliver pending signals after syscall_dispatch.
- * May modify the SyscallFrame to redirect to a signal handler.
+ * May modify the SyscallFrame to redirect to a signal handler, and sets
+ * PerCpu.sig_arg to the handler's RDI (signo, or 0), which
+ * syscall_entry.asm loads before SYSRET.
  * Returns the value to place in RAX on return to user space. */
 int64_t sig_maybe_deliver(SyscallFrame *frame, int64_t syscall_ret);
 
 /* Send a signal to all processes in a process group. Returns 0 or -ESRCH. */
 int sig_send_group(uint32_t pgid, int signo);
 
-/* RDI value for signal handler — set by sig_maybe_deliver, loaded by asm. */
-extern uint64_t sig_pending_arg;
-
 #endif /* ARCHOS_PROC_SIGNAL_H */
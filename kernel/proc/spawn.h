@@ -0,0 +1,41 @@
+#ifndef ARCHOS_PROC_SPAWN_H
+#define ARCHOS_PROC_SPAWN_H
+
+#include <stdint.h>
+
+/* SYS_SPAWN request: create a process straight from an ELF path, without
+ * copying the caller's address space.
+ *
+ * File actions run in order against a copy of the caller's fd table, then
+ * the child starts in its own process group if SPAWN_SETPGROUP is set.
+ * Any failure leaves no child behind.
+ *
+ * The layout below is ABI: libc/include/spawn.h mirrors it. */
+
+#define SPAWN_MAX_ACTIONS  8
+
+/* SpawnFileAction.type */
+#define SPAWN_FA_CLOSE  1   /* close(fd) */
+#define SPAWN_FA_DUP2   2   /* dup2(fd, newfd) */
+#define SPAWN_FA_OPEN   3   /* open(path, oflags) installed as fd */
+
+/* SpawnRequest.flags */
+#define SPAWN_SETPGROUP 0x01
+
+typedef struct {
+    uint32_t type;
+    int32_t  fd;
+    int32_t  newfd;
+    uint32_t oflags;
+    uint64_t path;          /* User pointer (SPAWN_FA_OPEN) */
+} SpawnFileAction;
+
+typedef struct {
+    uint32_t        flags;
+    int32_t         pgid;   /* SPAWN_SETPGROUP: 0 = the child's own pid */
+    uint32_t        nactions;
+    uint32_t        reserved;
+    SpawnFileAction actions[SPAWN_MAX_ACTIONS];
+} SpawnRequest;
+
+#endif /* ARCHOS_PROC_SPAWN_H */
@@ -0,0 +1,155 @@
+/* arc_os — Queued spinlock slow path and reader-writer spinlock
+ *
+ * Contended Spinlock acquirers form an MCS queue: each waiter publishes a
+ * node from its own PerCpu and spins on that node only.  The lock word's
+ * tail field names the last waiter; the head of the queue is the only CPU
+ * that polls the lock word itself. */
+
+#include "proc/spinlock.h"
+#include "arch/x86_64/percpu.h"
+
+/* Tail encoding: ((cpu + 1) << 2 | idx) so that 0 means "no tail". */
+static inline uint32_t mcs_encode_tail(uint32_t cpu, uint32_t idx) {
+    return (((cpu + 1) << 2) | idx) << SPINLOCK_TAIL_SHIFT;
+}
+
+static inline McsNode *mcs_decode_tail(uint32_t tail) {
+    uint32_t v = tail >> SPINLOCK_TAIL_SHIFT;
+    return &percpu_data[(v >> 2) - 1].mcs_nodes[v & 3];
+}
+
+/* Nesting exhausted (e.g. NMI inside a contended acquire): spin on the lock
+ * word directly.  Unfair, but only reachable in pathological nesting. */
+static void spinlock_acquire_unqueued(Spinlock *lock) {
+    for (;;) {
+        uint32_t val = __atomic_load_n(&lock->locked, __ATOMIC_RELAXED);
+        if (!(val & SPINLOCK_LOCKED_MASK) &&
+            __atomic_compare_exchange_n(&lock->locked, &val, val | SPINLOCK_LOCKED,
+                                        0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+void spinlock_acquire_slow(Spinlock *lock) {
+    PerCpu *cpu = this_cpu();
+    uint32_t idx = cpu->mcs_depth;
+    if (idx >= MCS_NODES_PER_CPU) {
+        spinlock_acquire_unqueued(lock);
+        return;
+    }
+    cpu->mcs_depth = idx + 1;
+
+    McsNode *node = &cpu->mcs_nodes[idx];
+    node->next = NULL;
+    node->locked = 0;
+    uint32_t tail = mcs_encode_tail(cpu->cpu_id, idx);
+
+    /* 1. Publish ourselves as the queue tail, keeping the locked byte. */
+    uint32_t old = __atomic_load_n(&lock->locked, __ATOMIC_RELAXED);
+    uint32_t val;
+    do {
+        val = (old & ~SPINLOCK_TAIL_MASK) | tail;
+    } while (!__atomic_compare_exchange_n(&lock->locked, &old, val, 0,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    /* 2. Link behind the previous tail and spin on our own node until it
+     *    hands us the queue head. */
+    if (old & SPINLOCK_TAIL_MASK) {
+        McsNode *prev = mcs_decode_tail(old & SPINLOCK_TAIL_MASK);
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        while (!__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+            cpu_relax();
+        }
+    }
+
+    /* 3. Queue head: wait for the owner to drop the locked byte, then take
+     *    it.  The fast path cannot steal the lock meanwhile because the
+     *    tail is non-zero.  If we are still the tail, clear it as well and
+     *    the queue becomes empty. */
+    uint32_t want;
+    for (;;) {
+        val = __atomic_load_n(&lock->locked, __ATOMIC_ACQUIRE);
+        if (val & SPINLOCK_LOCKED_MASK) {
+            cpu_relax();
+            continue;
+        }
+        want = ((val & SPINLOCK_TAIL_MASK) == tail) ? SPINLOCK_LOCKED
+                                                    : (val | SPINLOCK_LOCKED);
+        if (__atomic_compare_exchange_n(&lock->locked, &val, want, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (want == SPINLOCK_LOCKED) {
+        cpu->mcs_depth = idx;
+        return;
+    }
+
+    /* 4. A successor exists (or is about to link in): pass it the head. */
+    McsNode *next;
+    while ((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == NULL) {
+        cpu_relax();
+    }
+    __atomic_store_n(&next->locked, 1, __ATOMIC_RELEASE);
+    cpu->mcs_depth = idx;
+}
+
+/* --- Reader-writer spinlock --- */
+
+uint64_t rwlock_read_acquire(RwSpinlock *rw) {
+    uint64_t flags = spin_irq_save();
+    preempt_disable();
+
+    uint32_t cnts = __atomic_add_fetch(&rw->cnts, RWLOCK_RBIAS, __ATOMIC_ACQUIRE);
+    if (!(cnts & RWLOCK_WMASK)) return flags;
+
+    /* A writer holds or is waiting for the lock: back out and queue. */
+    __atomic_sub_fetch(&rw->cnts, RWLOCK_RBIAS, __ATOMIC_RELAXED);
+    spinlock_acquire(&rw->wait_lock);
+    __atomic_add_fetch(&rw->cnts, RWLOCK_RBIAS, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&rw->cnts, __ATOMIC_ACQUIRE) & RWLOCK_WLOCKED) {
+        cpu_relax();
+    }
+    spinlock_release(&rw->wait_lock);
+    return flags;
+}
+
+void rwlock_read_release(RwSpinlock *rw, uint64_t flags) {
+    __atomic_sub_fetch(&rw->cnts, RWLOCK_RBIAS, __ATOMIC_RELEASE);
+    spin_irq_restore(flags);
+    preempt_enable();
+}
+
+void rwlock_write_acquire(RwSpinlock *rw) {
+    uint64_t flags = spin_irq_save();
+    preempt_disable();
+
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&rw->cnts, &expected, RWLOCK_WLOCKED, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        spinlock_acquire(&rw->wait_lock);
+
+        /* Announce ourselves so new readers queue behind us, then wait
+         * for the active readers to drain. */
+        __atomic_fetch_or(&rw->cnts, RWLOCK_WWAITING, __ATOMIC_RELAXED);
+        for (;;) {
+            expected = RWLOCK_WWAITING;
+            if (__atomic_compare_exchange_n(&rw->cnts, &expected, RWLOCK_WLOCKED, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            cpu_relax();
+        }
+        spinlock_release(&rw->wait_lock);
+    }
+    rw->saved_flags = flags;
+}
+
+void rwlock_write_release(RwSpinlock *rw) {
+    uint64_t flags = rw->saved_flags;
+    __atomic_store_n((volatile uint8_t *)&rw->cnts, 0, __ATOMIC_RELEASE);
+    spin_irq_restore(flags);
+    preempt_enable();
+}
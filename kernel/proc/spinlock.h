@@ -2,7 +2,21 @@
 #define ARCHOS_PROC_SPINLOCK_H
 
 #include <stdint.h>
+#include "proc/preempt.h"
 
+/* Queued spinlock (qspinlock-style MCS lock).
+ *
+ * The 32-bit lock word packs two fields:
+ *   bits  0-7   locked byte — 1 while the lock is held
+ *   bits 16-31  queue tail  — encoded (cpu, nesting index) of the last waiter,
+ *                             0 when nobody is queued
+ *
+ * Uncontended acquire is a single CAS 0 -> 1.  Contended acquirers append a
+ * per-CPU McsNode to the queue and spin on their own node, so waiters do not
+ * bounce the lock's cache line and are granted the lock in FIFO order.
+ *
+ * Holding a spinlock also disables preemption; the release is a
+ * preemption point if it re-enables interrupts. */
 typedef struct {
     volatile uint32_t locked;
     uint64_t saved_flags;
@@ -10,21 +24,102 @@ typedef struct {
 
 #define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
 
+#define SPINLOCK_LOCKED       1u
+#define SPINLOCK_LOCKED_MASK  0x000000FFu
+#define SPINLOCK_TAIL_SHIFT   16
+#define SPINLOCK_TAIL_MASK    0xFFFF0000u
+
+/* Queue nodes per CPU: one per nesting level of contended acquisitions. */
+#define MCS_NODES_PER_CPU 4
+
+/* MCS queue node — lives in PerCpu, never on a lock. */
+typedef struct McsNode {
+    struct McsNode *volatile next;  /* Successor in the queue */
+    volatile uint32_t        locked;  /* Set by predecessor: we are queue head */
+} McsNode;
+
+/* Save RFLAGS and disable interrupts. */
+static inline uint64_t spin_irq_save(void) {
+    uint64_t flags;
+    __asm__ volatile ("pushf; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/* Restore RFLAGS saved by spin_irq_save (re-enables IF if it was set). */
+static inline void spin_irq_restore(uint64_t flags) {
+    __asm__ volatile ("push %0; popf" : : "r"(flags) : "memory", "cc");
+}
+
+/* Briefly enable interrupts so pending ones are delivered: sti takes
+ * effect after the next instruction, then cli closes the window. */
+static inline void irq_window(void) {
+    __asm__ volatile ("sti; nop; cli" ::: "memory");
+}
+
+/* Spin-wait hint for busy loops. */
+static inline void cpu_relax(void) {
+    __asm__ volatile ("pause" ::: "memory");
+}
+
+/* Contended path: queue on this CPU's MCS node. Interrupts must be disabled. */
+void spinlock_acquire_slow(Spinlock *lock);
+
 /* Acquire spinlock: save flags, disable interrupts, spin until acquired. */
 static inline void spinlock_acquire(Spinlock *lock) {
-    uint64_t flags;
-    __asm__ volatile ("pushf; pop %0; cli" : "=r"(flags));
-    while (__sync_lock_test_and_set(&lock->locked, 1)) {
-        __asm__ volatile ("pause");
+    uint64_t flags = spin_irq_save();
+    preempt_disable();
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&lock->locked, &expected, SPINLOCK_LOCKED,
+                                     0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        spinlock_acquire_slow(lock);
     }
     lock->saved_flags = flags;
 }
 
-/* Release spinlock: release lock, restore saved interrupt flags. */
+/* Release spinlock: release lock, restore saved interrupt flags, then
+ * re-enable preemption.
+ * Only the owner writes the locked byte, so a plain byte store suffices
+ * (x86 is little-endian: byte 0 of the word is the locked byte). */
 static inline void spinlock_release(Spinlock *lock) {
     uint64_t flags = lock->saved_flags;
-    __sync_lock_release(&lock->locked);
-    __asm__ volatile ("push %0; popf" : : "r"(flags) : "memory", "cc");
+    __atomic_store_n((volatile uint8_t *)&lock->locked, 0, __ATOMIC_RELEASE);
+    spin_irq_restore(flags);
+    preempt_enable();
 }
 
+/* Reader-writer spinlock (qrwlock-style).
+ *
+ * Readers share the lock; a writer excludes everyone.  Uncontended paths are
+ * a single atomic on `cnts`.  Contended readers and writers serialize on the
+ * queued `wait_lock`, which gives FIFO fairness between them: a waiting
+ * writer blocks new readers, so writers cannot be starved by a reader stream.
+ *
+ * Readers may run concurrently on several CPUs, so their saved interrupt
+ * state is returned to the caller instead of stored in the lock. */
+typedef struct {
+    volatile uint32_t cnts;     /* bits 0-7 writer locked, bit 8 writer waiting,
+                                 * bits 9-31 reader count */
+    Spinlock wait_lock;         /* Queue for contended acquirers */
+    uint64_t saved_flags;       /* Writer's saved interrupt state */
+} RwSpinlock;
+
+#define RWSPINLOCK_INIT { .cnts = 0, .wait_lock = SPINLOCK_INIT, .saved_flags = 0 }
+
+#define RWLOCK_WLOCKED   0x000000FFu
+#define RWLOCK_WWAITING  0x00000100u
+#define RWLOCK_WMASK     (RWLOCK_WLOCKED | RWLOCK_WWAITING)
+#define RWLOCK_RBIAS     0x00000200u
+
+/* Acquire for reading. Returns the saved interrupt flags. */
+uint64_t rwlock_read_acquire(RwSpinlock *rw);
+
+/* Release a read hold, restoring the flags returned by rwlock_read_acquire. */
+void rwlock_read_release(RwSpinlock *rw, uint64_t flags);
+
+/* Acquire for writing (exclusive). */
+void rwlock_write_acquire(RwSpinlock *rw);
+
+/* Release a write hold. */
+void rwlock_write_release(RwSpinlock *rw);
+
 #endif /* ARCHOS_PROC_SPINLOCK_H */
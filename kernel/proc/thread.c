@@ -1,4 +1,5 @@
 #include "proc/thread.h"
+#include "proc/sched.h"
 #include "mm/kmalloc.h"
 #include "lib/kprintf.h"
 #include "lib/mem.h"
@@ -7,9 +8,11 @@ static Thread *current_thread = NULL;
 static tid_t next_tid = 0;
 
 /* Trampoline: first thing a new thread executes after context_switch returns.
- * Enables interrupts, calls the entry function, marks thread DEAD, then yields. */
+ * Releases the scheduler lock, enables interrupts, calls the entry function,
+ * marks thread DEAD, then yields. */
 static void thread_trampoline(void) {
     Thread *t = thread_current();
+    sched_schedule_tail();
     __asm__ volatile ("sti");
     t->entry(t->arg);
     t->state = THREAD_DEAD;
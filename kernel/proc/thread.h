@@ -18,6 +18,19 @@ typedef uint32_t tid_t;
 /* Default kernel stack size: 16 KB */
 #define THREAD_STACK_SIZE  (16 * 1024)
 
+/* Wakeup latency histogram buckets: <10us, <100us, <1ms, <10ms, <100ms, more */
+#define SCHED_LAT_BUCKETS  6
+
+/* Wakeup-to-run latency of a real-time thread */
+typedef struct {
+    uint64_t count;
+    uint64_t max_ns;
+    uint32_t buckets[SCHED_LAT_BUCKETS];
+} SchedLatency;
+
+struct Mutex;
+struct IpcWait;
+
 /* Thread entry function type */
 typedef void (*thread_entry_t)(void *arg);
 
@@ -42,6 +55,18 @@ typedef struct Thread {
     uint64_t        kernel_stack_top; /* Top of kernel stack for TSS.rsp0 / SYSCALL */
     thread_entry_t  entry;
     void           *arg;
+    uint32_t        rcu_read_depth; /* RCU read-side nesting; blocks preemption */
+    uint32_t        preempt_count;  /* Spinlocks and preempt_disable() held */
+    uint8_t         policy;         /* SCHED_NORMAL, SCHED_FIFO or SCHED_RR */
+    uint8_t         rt_priority;    /* Static priority, 0 for SCHED_NORMAL */
+    uint8_t         pi_priority;    /* Priority inherited from mutex waiters */
+    uint8_t         prio;           /* Effective: max(rt_priority, pi_priority) */
+    uint32_t        rr_ticks;       /* Ticks used of the current SCHED_RR slice */
+    uint64_t        wake_tsc;       /* TSC when last woken; 0 once it runs */
+    SchedLatency    latency;
+    struct Mutex   *pi_blocked_on;  /* Mutex this thread sleeps on */
+    struct Mutex   *pi_held;        /* Mutexes held, linked by held_next */
+    struct IpcWait *ipc_caller;     /* IPC call awaiting this thread's reply */
     struct Thread  *next;           /* Intrusive list for scheduler */
 } Thread;
 
@@ -7,19 +7,32 @@ void wq_init(WaitQueue *wq) {
     wq->tail = NULL;
 }
 
+/* Queue t behind every waiter of equal or higher priority, so the
+ * highest-priority waiter wakes first (FIFO among equals). Caller holds
+ * wq->lock. */
+static void wq_insert(WaitQueue *wq, Thread *t) {
+    Thread *prev = NULL;
+    Thread *cur = wq->head;
+    while (cur && cur->prio >= t->prio) {
+        prev = cur;
+        cur = cur->next;
+    }
+    t->next = cur;
+    if (prev) {
+        prev->next = t;
+    } else {
+        wq->head = t;
+    }
+    if (cur == NULL) {
+        wq->tail = t;
+    }
+}
+
 void wq_sleep(WaitQueue *wq, Spinlock *lock) {
     Thread *self = thread_current();
 
     spinlock_acquire(&wq->lock);
-
-    /* Append to wait queue tail */
-    self->next = NULL;
-    if (wq->tail) {
-        wq->tail->next = self;
-    } else {
-        wq->head = self;
-    }
-    wq->tail = self;
+    wq_insert(wq, self);
 
     self->state = THREAD_BLOCKED;
 
@@ -72,3 +85,31 @@ int wq_wake_all(WaitQueue *wq) {
     spinlock_release(&wq->lock);
     return count;
 }
+
+int wq_requeue(WaitQueue *wq, Thread *t) {
+    spinlock_acquire(&wq->lock);
+
+    Thread *prev = NULL;
+    Thread *cur = wq->head;
+    while (cur && cur != t) {
+        prev = cur;
+        cur = cur->next;
+    }
+    if (cur == NULL) {
+        spinlock_release(&wq->lock);
+        return 0;
+    }
+
+    if (prev) {
+        prev->next = t->next;
+    } else {
+        wq->head = t->next;
+    }
+    if (wq->tail == t) {
+        wq->tail = prev;
+    }
+    wq_insert(wq, t);
+
+    spinlock_release(&wq->lock);
+    return 1;
+}
@@ -19,7 +19,8 @@ void wq_init(WaitQueue *wq);
 
 /* Sleep on the wait queue.  Caller must hold `lock`; it is released atomically
  * after the thread is enqueued (prevents lost wakeups).  Callers must
- * re-check their condition in a while loop (spurious wakeup safe). */
+ * re-check their condition in a while loop (spurious wakeup safe).
+ * Waiters queue in priority order, FIFO within a priority. */
 void wq_sleep(WaitQueue *wq, Spinlock *lock);
 
 /* Wake the first thread on the queue.  Returns 1 if a thread was woken, 0 if
@@ -29,4 +30,10 @@ int wq_wake(WaitQueue *wq);
 /* Wake all threads on the queue.  Returns the number of threads woken. */
 int wq_wake_all(WaitQueue *wq);
 
+/* t's priority changed while it sleeps on wq: move it to its place for
+ * the new one.  Returns 1, or 0 if t is not on wq.  Queues are only kept
+ * in order where this is called (mutex priority inheritance); elsewhere a
+ * sleeper's new priority counts from its next sleep. */
+int wq_requeue(WaitQueue *wq, Thread *t);
+
 #endif /* ARCHOS_PROC_WAITQUEUE_H */
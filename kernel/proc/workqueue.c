@@ -0,0 +1,178 @@
+/* arc_os — Kernel workqueues
+ *
+ * Immediate work goes straight onto a per-CPU pool FIFO and wakes one idle
+ * worker.  Delayed work waits on a single list sorted by expiry, which the
+ * PIT tick drains onto the owning pool.  Lock order: delayed_lock, then
+ * pool->lock, then the pool's wait-queue locks. */
+
+#include "proc/workqueue.h"
+#include "proc/sched.h"
+#include "arch/x86_64/percpu.h"
+#include "arch/x86_64/pit.h"
+#include "lib/kprintf.h"
+
+static WorkPool pools[MAX_CPUS];
+static Work *delayed_head;                 /* Sorted by expires, ascending */
+static Spinlock delayed_lock = SPINLOCK_INIT;
+
+void work_init(Work *work, work_func_t func) {
+    *work = (Work)WORK_INIT(func);
+}
+
+/* Append a pending item to a pool and wake one worker. */
+static void pool_enqueue(uint32_t cpu, Work *work) {
+    WorkPool *pool = &pools[cpu];
+
+    spinlock_acquire(&pool->lock);
+    work->cpu = cpu;
+    work->next = NULL;
+    if (pool->tail) {
+        pool->tail->next = work;
+    } else {
+        pool->head = work;
+    }
+    pool->tail = work;
+    spinlock_release(&pool->lock);
+
+    wq_wake(&pool->idle_wq);
+}
+
+/* Pop and run one item.  Called with pool->lock held; returns with it held.
+ * Returns 0 if the pool was empty. */
+static int worker_run_one(Worker *wk) {
+    WorkPool *pool = wk->pool;
+    Work *work = pool->head;
+    if (work == NULL) return 0;
+
+    pool->head = work->next;
+    if (pool->head == NULL) pool->tail = NULL;
+    work->next = NULL;
+
+    /* Clear pending before running so the item can re-queue itself */
+    wk->current = work;
+    work_func_t func = work->func;
+    __atomic_store_n(&work->pending, 0, __ATOMIC_RELEASE);
+    spinlock_release(&pool->lock);
+
+    uint64_t flags = spin_irq_save();
+    func(work);
+    spin_irq_restore(flags);
+
+    spinlock_acquire(&pool->lock);
+    wk->current = NULL;
+    pool->nr_executed++;
+    spinlock_release(&pool->lock);
+
+    wq_wake_all(&pool->done_wq);
+
+    spinlock_acquire(&pool->lock);
+    return 1;
+}
+
+static void worker_main(void *arg) {
+    Worker *wk = (Worker *)arg;
+    WorkPool *pool = wk->pool;
+
+    for (;;) {
+        spinlock_acquire(&pool->lock);
+        while (worker_run_one(wk)) {
+            /* Drain the pool */
+        }
+        wq_sleep(&pool->idle_wq, &pool->lock);
+    }
+}
+
+void workqueue_init(void) {
+    uint32_t started = 0;
+    for (uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+        if (cpu != 0 && !percpu_data[cpu].online) continue;
+        WorkPool *pool = &pools[cpu];
+        for (uint32_t i = 0; i < WQ_MAX_ACTIVE; i++) {
+            Worker *wk = &pool->workers[i];
+            wk->pool = pool;
+            wk->thread = thread_create(worker_main, wk);
+            if (wk->thread == NULL) break;
+            pool->nr_workers++;
+            sched_add_thread(wk->thread);
+            started++;
+        }
+    }
+    kprintf("[WQ] Workqueues initialized (%u workers, %u per CPU)\n",
+            started, (uint32_t)WQ_MAX_ACTIVE);
+}
+
+int queue_work(Work *work) {
+    if (__atomic_exchange_n(&work->pending, 1, __ATOMIC_ACQ_REL)) return 0;
+    pool_enqueue(this_cpu()->cpu_id, work);
+    return 1;
+}
+
+int queue_delayed_work(Work *work, uint64_t delay_ms) {
+    if (delay_ms == 0) return queue_work(work);
+    if (__atomic_exchange_n(&work->pending, 1, __ATOMIC_ACQ_REL)) return 0;
+
+    work->cpu = this_cpu()->cpu_id;
+    work->expires = pit_get_uptime_ms() + delay_ms;
+
+    spinlock_acquire(&delayed_lock);
+    Work **pp = &delayed_head;
+    while (*pp && (*pp)->expires <= work->expires) {
+        pp = &(*pp)->next;
+    }
+    work->next = *pp;
+    *pp = work;
+    work->delayed = 1;
+    spinlock_release(&delayed_lock);
+    return 1;
+}
+
+void workqueue_tick(uint64_t now_ms) {
+    if (__atomic_load_n(&delayed_head, __ATOMIC_RELAXED) == NULL) return;
+
+    spinlock_acquire(&delayed_lock);
+    while (delayed_head && delayed_head->expires <= now_ms) {
+        Work *work = delayed_head;
+        delayed_head = work->next;
+        work->delayed = 0;
+        pool_enqueue(work->cpu, work);
+    }
+    spinlock_release(&delayed_lock);
+}
+
+/* Returns non-zero if a worker of `pool` is running `work`.
+ * Caller holds pool->lock. */
+static int pool_is_running(const WorkPool *pool, const Work *work) {
+    for (uint32_t i = 0; i < WQ_MAX_ACTIVE; i++) {
+        if (pool->workers[i].current == work) return 1;
+    }
+    return 0;
+}
+
+int flush_work(Work *work) {
+    /* Pull a timer-armed item forward so we do not wait out its delay */
+    spinlock_acquire(&delayed_lock);
+    int was_delayed = work->delayed;
+    if (was_delayed) {
+        for (Work **pp = &delayed_head; *pp; pp = &(*pp)->next) {
+            if (*pp == work) {
+                *pp = work->next;
+                break;
+            }
+        }
+        work->delayed = 0;
+        pool_enqueue(work->cpu, work);
+    }
+    spinlock_release(&delayed_lock);
+
+    WorkPool *pool = &pools[work->cpu];
+    int waited = 0;
+    spinlock_acquire(&pool->lock);
+    while (__atomic_load_n(&work->pending, __ATOMIC_ACQUIRE) ||
+           pool_is_running(pool, work)) {
+        waited = 1;
+        wq_sleep(&pool->done_wq, &pool->lock);
+        spinlock_acquire(&pool->lock);
+    }
+    spinlock_release(&pool->lock);
+    return waited;
+}
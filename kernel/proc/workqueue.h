@@ -0,0 +1,82 @@
+#ifndef ARCHOS_PROC_WORKQUEUE_H
+#define ARCHOS_PROC_WORKQUEUE_H
+
+#include <stdint.h>
+#include "proc/spinlock.h"
+#include "proc/waitqueue.h"
+
+/* Kernel workqueues: defer work from IRQ handlers and syscalls to kernel
+ * worker threads.
+ *
+ * Each CPU has a pool with a bounded number of workers (WQ_MAX_ACTIVE), so
+ * a burst of queued work cannot monopolise the scheduler.  Work functions
+ * run with interrupts disabled — the same context as a syscall handler —
+ * and may sleep on a wait queue; workers re-enable interrupts between
+ * items so the timer can preempt them.
+ *
+ * A Work item is embedded in its owner and queued at most once: queueing a
+ * pending item is a no-op, which coalesces repeated requests. */
+
+/* Worker threads per CPU pool */
+#define WQ_MAX_ACTIVE 2
+
+struct Work;
+typedef void (*work_func_t)(struct Work *work);
+
+typedef struct Work {
+    struct Work      *next;       /* Pool or delayed-list linkage */
+    work_func_t       func;
+    uint64_t          expires;    /* Delayed work: uptime (ms) to queue at */
+    uint32_t          cpu;        /* Pool the item is (or was last) queued on */
+    volatile uint8_t  pending;    /* Queued or waiting on a timer */
+    volatile uint8_t  delayed;    /* On the delayed list */
+} Work;
+
+#define WORK_INIT(fn) { .next = NULL, .func = (fn), .expires = 0, .cpu = 0, \
+                        .pending = 0, .delayed = 0 }
+
+struct WorkPool;
+
+/* Worker thread slot. The item being run is tracked here, not in the Work,
+ * so a work function may free its own item. */
+typedef struct {
+    struct WorkPool *pool;
+    Thread          *thread;
+    Work            *current;
+} Worker;
+
+/* Per-CPU worker pool */
+typedef struct WorkPool {
+    Spinlock  lock;
+    Work     *head;
+    Work     *tail;
+    WaitQueue idle_wq;            /* Workers waiting for work */
+    WaitQueue done_wq;            /* flush_work waiters */
+    Worker    workers[WQ_MAX_ACTIVE];
+    uint32_t  nr_workers;
+    uint64_t  nr_executed;        /* Lifetime count of items run */
+} WorkPool;
+
+/* Initialize a work item. */
+void work_init(Work *work, work_func_t func);
+
+/* Start worker threads for every online CPU. Call after sched_init. */
+void workqueue_init(void);
+
+/* Queue work on this CPU's pool. Safe from IRQ context.
+ * Returns 1 if queued, 0 if it was already pending. */
+int queue_work(Work *work);
+
+/* Queue work after `delay_ms` milliseconds. Safe from IRQ context.
+ * Returns 1 if armed, 0 if already pending (the earlier deadline stands). */
+int queue_delayed_work(Work *work, uint64_t delay_ms);
+
+/* Run a pending delayed item now and wait until the item is neither
+ * pending nor running. Process context only.
+ * Returns 1 if it had to wait, 0 if the item was already idle. */
+int flush_work(Work *work);
+
+/* Timer-tick hook: move expired delayed work onto its pool. IRQ context. */
+void workqueue_tick(uint64_t now_ms);
+
+#endif /* ARCHOS_PROC_WORKQUEUE_H */
@@ -15,9 +15,10 @@ struct dirent {
 typedef struct {
     int           fd;      /* Open directory fd (unused — we use path-based readdir) */
     char          path[256];
-    struct dirent entries[64];
+    struct dirent entries[64];  /* Current batch */
     int           count;
     int           pos;
+    uint64_t      cursor;  /* Kernel readdir cursor for the next batch */
 } DIR;
 
 DIR           *opendir(const char *path);
@@ -0,0 +1,113 @@
+#ifndef ARCHOS_LIBC_ELF_H
+#define ARCHOS_LIBC_ELF_H
+
+#include <stdint.h>
+
+/* ELF64 structures and constants used by the dynamic loader (x86_64 only).
+ * The header and program-header layouts match kernel/proc/elf.h. */
+
+#define EI_NIDENT   16
+
+#define ET_EXEC     2
+#define ET_DYN      3
+
+/* Program header types */
+#define PT_LOAD     1
+#define PT_DYNAMIC  2
+#define PT_INTERP   3
+#define PT_PHDR     6
+
+/* Dynamic section tags */
+#define DT_NULL      0
+#define DT_NEEDED    1
+#define DT_PLTRELSZ  2
+#define DT_HASH      4
+#define DT_STRTAB    5
+#define DT_SYMTAB    6
+#define DT_RELA      7
+#define DT_RELASZ    8
+#define DT_RELAENT   9
+#define DT_PLTREL    20
+#define DT_JMPREL    23
+
+/* Symbol binding, type and special section index */
+#define STB_LOCAL   0
+#define STB_GLOBAL  1
+#define STB_WEAK    2
+#define STN_UNDEF   0
+#define SHN_UNDEF   0
+#define ELF64_ST_BIND(info) ((info) >> 4)
+
+/* x86_64 relocation types */
+#define R_X86_64_NONE       0
+#define R_X86_64_64         1
+#define R_X86_64_COPY       5
+#define R_X86_64_GLOB_DAT   6
+#define R_X86_64_JUMP_SLOT  7
+#define R_X86_64_RELATIVE   8
+#define ELF64_R_SYM(info)   ((uint32_t)((info) >> 32))
+#define ELF64_R_TYPE(info)  ((uint32_t)(info))
+
+/* Auxiliary vector entry types (initial user stack, after envp) */
+#define AT_NULL     0
+#define AT_PHDR     3
+#define AT_PHENT    4
+#define AT_PHNUM    5
+#define AT_PAGESZ   6
+#define AT_BASE     7
+#define AT_ENTRY    9
+
+typedef struct {
+    uint8_t  e_ident[EI_NIDENT];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} Elf64_Ehdr;
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} Elf64_Phdr;
+
+typedef struct {
+    int64_t  d_tag;
+    uint64_t d_val;         /* Value or link-time address, by tag */
+} Elf64_Dyn;
+
+typedef struct {
+    uint32_t st_name;
+    uint8_t  st_info;
+    uint8_t  st_other;
+    uint16_t st_shndx;
+    uint64_t st_value;
+    uint64_t st_size;
+} Elf64_Sym;
+
+typedef struct {
+    uint64_t r_offset;
+    uint64_t r_info;
+    int64_t  r_addend;
+} Elf64_Rela;
+
+typedef struct {
+    uint64_t a_type;
+    uint64_t a_val;
+} Elf64_auxv_t;
+
+#endif /* ARCHOS_LIBC_ELF_H */
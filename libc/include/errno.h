@@ -12,7 +12,10 @@
 #define EAGAIN      11
 #define ENOMEM      12
 #define EACCES      13
+#define EFAULT      14
+#define EBUSY       16
 #define EEXIST      17
+#define ENODEV      19
 #define ENOTDIR     20
 #define EISDIR      21
 #define EINVAL      22
@@ -22,6 +25,8 @@
 #define ENAMETOOLONG 36
 #define ENOSYS      38
 #define ENOTEMPTY   39
+#define ETIME       62
+#define ECANCELED  125
 
 extern int errno;
 
@@ -6,6 +6,7 @@
 #define O_WRONLY   0x01
 #define O_RDWR     0x02
 #define O_CREAT    0x40
+#define O_EXCL     0x80
 #define O_TRUNC    0x200
 #define O_APPEND   0x400
 #define O_ACCMODE  0x03
@@ -0,0 +1,77 @@
+#ifndef ARCHOS_LIBC_IO_RING_H
+#define ARCHOS_LIBC_IO_RING_H
+
+#include <stdint.h>
+
+/* Asynchronous I/O rings — layout must match kernel/proc/io_ring.h */
+
+#define IO_RING_MAX_ENTRIES  128
+
+#define IO_OP_NOP      0
+#define IO_OP_READ     1
+#define IO_OP_WRITE    2
+#define IO_OP_FSYNC    3
+#define IO_OP_SEND     4
+#define IO_OP_RECV     5
+#define IO_OP_ACCEPT   6
+#define IO_OP_TIMEOUT  7
+
+#define IO_OFF_CURRENT ((uint64_t)-1)
+
+typedef struct {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t reserved;
+    int32_t  fd;
+    uint64_t off;           /* File offset, or timeout in ms */
+    uint64_t addr;
+    uint32_t len;
+    uint32_t reserved2;
+    uint64_t user_data;
+} IoSqe;
+
+typedef struct {
+    uint64_t user_data;
+    int32_t  res;           /* >= 0, or -errno */
+    uint32_t flags;
+} IoCqe;
+
+typedef struct {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+    uint32_t cq_entries;
+    uint32_t cq_overflow;
+    uint32_t sq_off;
+    uint32_t cq_off;
+    uint32_t reserved;
+} IoRingHeader;
+
+/* User-side handle */
+typedef struct {
+    IoRingHeader *hdr;
+    IoSqe        *sqes;
+    IoCqe        *cqes;
+} IoRing;
+
+/* Map a ring with room for `entries` submissions. Returns 0 or -1 (errno). */
+int io_ring_init(IoRing *ring, unsigned entries);
+
+/* Submit all queued SQEs and wait for at least `wait_nr` completions.
+ * Returns the number of SQEs consumed, or -1 (errno). */
+int io_ring_submit(IoRing *ring, unsigned wait_nr);
+
+/* Next free SQE, zeroed, or NULL if the SQ is full. */
+IoSqe *io_ring_get_sqe(IoRing *ring);
+
+/* Oldest unconsumed CQE, or NULL. Needs no syscall. */
+IoCqe *io_ring_peek_cqe(IoRing *ring);
+
+/* Release the CQE returned by io_ring_peek_cqe. */
+void io_ring_cqe_seen(IoRing *ring);
+
+#endif /* ARCHOS_LIBC_IO_RING_H */
@@ -0,0 +1,39 @@
+#ifndef ARCHOS_LIBC_IPC_H
+#define ARCHOS_LIBC_IPC_H
+
+#include <stdint.h>
+
+/* Synchronous IPC endpoints — layout must match kernel/ipc/endpoint.h.
+ *
+ * A client calls an endpoint and blocks until a server replies; the
+ * server loops in ipc_reply_recv, replying to one call and taking the
+ * next in a single system call. Endpoints are fds, shared through fork. */
+
+#define IPC_MSG_WORDS  6
+#define IPC_BUF_MAX    4096
+
+typedef struct {
+    uint64_t tag;                   /* Call: operation label; reply: result */
+    uint64_t words[IPC_MSG_WORDS];  /* Message registers */
+    void    *buf;                   /* Optional buffer */
+    uint32_t len;                   /* Bytes of buf to send; set to bytes received */
+    uint32_t cap;                   /* Bytes buf can receive; excess is dropped */
+} ipc_msg_t;
+
+/* Create an endpoint. Returns its fd, or -1. */
+int ipc_endpoint(void);
+
+/* Send msg and wait for the reply, which overwrites msg. Fails with
+ * EPIPE if the server exits without replying. */
+int ipc_call(int fd, ipc_msg_t *msg);
+
+/* Wait for a call; the caller then owes it a reply. */
+int ipc_recv(int fd, ipc_msg_t *msg);
+
+/* Reply to the call being served. */
+int ipc_reply(const ipc_msg_t *msg);
+
+/* Reply to the call being served (if any), then wait for the next. */
+int ipc_reply_recv(int fd, ipc_msg_t *msg);
+
+#endif /* ARCHOS_LIBC_IPC_H */
@@ -0,0 +1,23 @@
+#ifndef ARCHOS_LIBC_SCHED_H
+#define ARCHOS_LIBC_SCHED_H
+
+#include <sys/types.h>
+
+/* Scheduling policies (match kernel/proc/sched.h). SCHED_FIFO and
+ * SCHED_RR take priorities 1-99 and always run before SCHED_OTHER. */
+#define SCHED_OTHER  0
+#define SCHED_FIFO   1
+#define SCHED_RR     2
+
+struct sched_param {
+    int sched_priority;
+};
+
+/* Set the policy and priority of process pid (0 = the caller). Real-time
+ * policies need root. */
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param *param);
+
+int sched_get_priority_min(int policy);
+int sched_get_priority_max(int policy);
+
+#endif /* ARCHOS_LIBC_SCHED_H */
@@ -0,0 +1,60 @@
+#ifndef ARCHOS_LIBC_SPAWN_H
+#define ARCHOS_LIBC_SPAWN_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* posix_spawn: create a process straight from an executable, without
+ * copying the caller's address space first.
+ *
+ * The request layout must match kernel/proc/spawn.h. */
+
+#define SPAWN_MAX_ACTIONS  8
+
+#define SPAWN_FA_CLOSE  1
+#define SPAWN_FA_DUP2   2
+#define SPAWN_FA_OPEN   3
+
+#define POSIX_SPAWN_SETPGROUP 0x01
+
+typedef struct {
+    uint32_t type;
+    int32_t  fd;
+    int32_t  newfd;
+    uint32_t oflags;
+    uint64_t path;
+} SpawnFileAction;
+
+/* File actions run in order in the child before it starts */
+typedef struct {
+    uint32_t        count;
+    SpawnFileAction actions[SPAWN_MAX_ACTIONS];
+} posix_spawn_file_actions_t;
+
+typedef struct {
+    uint32_t flags;
+    pid_t    pgroup;
+} posix_spawnattr_t;
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa);
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa);
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa, int fd);
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,
+                                     int fd, int newfd);
+/* `path` must stay valid until posix_spawn returns */
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa, int fd,
+                                     const char *path, int oflags, mode_t mode);
+
+int posix_spawnattr_init(posix_spawnattr_t *attr);
+int posix_spawnattr_destroy(posix_spawnattr_t *attr);
+int posix_spawnattr_setflags(posix_spawnattr_t *attr, short flags);
+int posix_spawnattr_setpgroup(posix_spawnattr_t *attr, pid_t pgroup);
+
+/* Returns 0 and stores the child's pid, or an errno value. `envp` is
+ * accepted for compatibility and ignored. */
+int posix_spawn(pid_t *pid, const char *path,
+                const posix_spawn_file_actions_t *fa,
+                const posix_spawnattr_t *attr,
+                char *const argv[], char *const envp[]);
+
+#endif /* ARCHOS_LIBC_SPAWN_H */
@@ -0,0 +1,32 @@
+#ifndef ARCHOS_LIBC_SYS_MMAN_H
+#define ARCHOS_LIBC_SYS_MMAN_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Memory mappings and POSIX shared memory — constants must match
+ * kernel/proc/mmap.h.
+ *
+ * Only MAP_SHARED mappings of shared memory objects are supported.
+ * shm_open names an object in /dev/shm ("/name" or "name"); size it with
+ * ftruncate, then mmap it in every process that needs the data. */
+
+#define PROT_NONE   0x0
+#define PROT_READ   0x1
+#define PROT_WRITE  0x2
+#define PROT_EXEC   0x4
+
+#define MAP_SHARED   0x01
+#define MAP_PRIVATE  0x02
+#define MAP_FIXED    0x10
+
+#define MAP_FAILED  ((void *)-1)
+
+void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off);
+int   munmap(void *addr, size_t len);
+
+/* Open (O_CREAT: create) a shared memory object; returns an fd or -1 */
+int   shm_open(const char *name, int oflag, mode_t mode);
+int   shm_unlink(const char *name);
+
+#endif /* ARCHOS_LIBC_SYS_MMAN_H */
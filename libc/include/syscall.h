@@ -48,6 +48,22 @@
 #define SYS_RECV      41
 #define SYS_SENDTO    42
 #define SYS_RECVFROM  43
+#define SYS_IO_RING_SETUP 44
+#define SYS_IO_RING_ENTER 45
+#define SYS_SPAWN     46
+#define SYS_VFORK     47
+#define SYS_SCHED_SETSCHEDULER 48
+#define SYS_IPC_ENDPOINT   49
+#define SYS_IPC_CALL       50
+#define SYS_IPC_RECV       51
+#define SYS_IPC_REPLY      52
+#define SYS_IPC_REPLY_RECV 53
+#define SYS_MMAP      54
+#define SYS_MUNMAP    55
+#define SYS_FTRUNCATE 56
+#define SYS_FSYNC     57
+#define SYS_SYNC      58
+#define SYS_READDIR_AT 59
 
 static inline int64_t syscall0(uint64_t num) {
     int64_t ret;
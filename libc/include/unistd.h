@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <sys/types.h>
+#include <syscall.h>
 
 /* Seek whence */
 #define SEEK_SET 0
@@ -19,9 +20,27 @@ int     dup(int fd);
 int     dup2(int oldfd, int newfd);
 int     unlink(const char *path);
 int     pipe(int pipefd[2]);
+int     ftruncate(int fd, off_t length);
+int     fsync(int fd);
+void    sync(void);
 
 /* Process operations */
 pid_t   fork(void);
+
+/* vfork: the child borrows the parent's address space and stack, and the
+ * parent sleeps until the child calls execv or exit. Forced inline so the
+ * child never returns through a stack frame the parent still needs. */
+static inline __attribute__((always_inline)) pid_t vfork(void) {
+    extern int errno;
+    int64_t ret;
+    __asm__ volatile ("syscall"
+        : "=a"(ret)
+        : "a"((uint64_t)SYS_VFORK)
+        : "rcx", "r11", "memory");
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+    return (pid_t)ret;
+}
+
 int     execv(const char *path, char *const argv[]);
 pid_t   getpid(void);
 pid_t   getppid(void);
@@ -1,4 +1,4 @@
-/* arc_os libc — directory operations via SYS_READDIR */
+/* arc_os libc — directory operations via SYS_READDIR_AT */
 
 #include <dirent.h>
 #include <stdlib.h>
@@ -12,20 +12,12 @@ typedef struct {
     uint8_t  type;
 } KernelDirEntry;
 
-DIR *opendir(const char *path) {
-    DIR *dir = malloc(sizeof(DIR));
-    if (!dir) return NULL;
-    memset(dir, 0, sizeof(DIR));
-    strncpy(dir->path, path, sizeof(dir->path) - 1);
-
-    /* Read all entries via SYS_READDIR */
+/* Read the batch after dir->cursor. Returns the entry count, 0 at the end. */
+static int dir_fill(DIR *dir) {
     KernelDirEntry kentries[64];
-    int64_t ret = syscall3(SYS_READDIR, (uint64_t)path,
-                           (uint64_t)kentries, 64);
-    if (ret < 0) {
-        free(dir);
-        return NULL;
-    }
+    int64_t ret = syscall4(SYS_READDIR_AT, (uint64_t)dir->path,
+                           (uint64_t)kentries, 64, (uint64_t)&dir->cursor);
+    if (ret < 0) return (int)ret;
 
     dir->count = (int)ret;
     for (int i = 0; i < dir->count; i++) {
@@ -35,11 +27,26 @@ DIR *opendir(const char *path) {
         dir->entries[i].d_type = kentries[i].type;
     }
     dir->pos = 0;
+    return dir->count;
+}
+
+DIR *opendir(const char *path) {
+    DIR *dir = malloc(sizeof(DIR));
+    if (!dir) return NULL;
+    memset(dir, 0, sizeof(DIR));
+    strncpy(dir->path, path, sizeof(dir->path) - 1);
+
+    if (dir_fill(dir) < 0) {
+        free(dir);
+        return NULL;
+    }
     return dir;
 }
 
+/* Entries come a batch at a time, so directories of any size stream */
 struct dirent *readdir(DIR *dir) {
-    if (!dir || dir->pos >= dir->count) return NULL;
+    if (!dir) return NULL;
+    if (dir->pos >= dir->count && (dir->count == 0 || dir_fill(dir) <= 0)) return NULL;
     return &dir->entries[dir->pos++];
 }
 
@@ -0,0 +1,259 @@
+/* arc_os libc — dynamic loader
+ *
+ * libarc.so is its own program interpreter: dynamically linked programs name
+ * /lib/libarc.so in PT_INTERP, and the kernel maps both and enters
+ * _dl_start with the program's argc/argv. The loader relocates libarc.so,
+ * then the program, binding every symbol immediately (no lazy PLT
+ * resolution), and calls the program's _start.
+ *
+ * Until its own relocations are applied this file may only touch locals,
+ * hidden symbols and string literals: everything here is static or hidden
+ * and takes no address through the GOT. */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <syscall.h>
+
+#define DL_HIDDEN __attribute__((visibility("hidden")))
+
+#define DL_SONAME "libarc.so"
+
+/* Our own dynamic section, found PC-relative before relocation */
+extern Elf64_Dyn _DYNAMIC[] DL_HIDDEN;
+
+/* A loaded object: the program or libarc.so itself */
+typedef struct {
+    uint64_t          base;         /* Load bias added to link-time addresses */
+    const Elf64_Dyn  *dynamic;
+    const Elf64_Sym  *symtab;
+    const char       *strtab;
+    const uint32_t   *hash;         /* DT_HASH: nbucket, nchain, buckets, chains */
+    const Elf64_Rela *rela;
+    uint64_t          relasz;
+    const Elf64_Rela *jmprel;
+    uint64_t          pltrelsz;
+} DlObject;
+
+/* Lookup order: the program first, so it can interpose (and own copy-
+ * relocated data), then the library */
+typedef struct {
+    DlObject prog;
+    DlObject lib;
+} DlScope;
+
+typedef void (*dl_entry_t)(uint64_t argc, char **argv);
+
+static size_t dl_strlen(const char *s) {
+    size_t n = 0;
+    while (s[n] != '\0') n++;
+    return n;
+}
+
+static int dl_streq(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) { a++; b++; }
+    return *a == *b;
+}
+
+__attribute__((noreturn))
+static void dl_fail(const char *what, const char *name) {
+    syscall3(SYS_WRITE, 2, (uint64_t)"libarc.so: ", 11);
+    syscall3(SYS_WRITE, 2, (uint64_t)what, dl_strlen(what));
+    if (name != NULL) {
+        syscall3(SYS_WRITE, 2, (uint64_t)": ", 2);
+        syscall3(SYS_WRITE, 2, (uint64_t)name, dl_strlen(name));
+    }
+    syscall3(SYS_WRITE, 2, (uint64_t)"\n", 1);
+    syscall1(SYS_EXIT, 127);
+    for (;;) __asm__ volatile ("ud2");
+}
+
+/* Record the tables of obj's dynamic section. */
+static void dl_parse_dynamic(DlObject *obj) {
+    obj->symtab = NULL;
+    obj->strtab = NULL;
+    obj->hash = NULL;
+    obj->rela = NULL;
+    obj->relasz = 0;
+    obj->jmprel = NULL;
+    obj->pltrelsz = 0;
+
+    for (const Elf64_Dyn *d = obj->dynamic; d->d_tag != DT_NULL; d++) {
+        switch (d->d_tag) {
+        case DT_SYMTAB:   obj->symtab = (const Elf64_Sym *)(obj->base + d->d_val); break;
+        case DT_STRTAB:   obj->strtab = (const char *)(obj->base + d->d_val); break;
+        case DT_HASH:     obj->hash = (const uint32_t *)(obj->base + d->d_val); break;
+        case DT_RELA:     obj->rela = (const Elf64_Rela *)(obj->base + d->d_val); break;
+        case DT_RELASZ:   obj->relasz = d->d_val; break;
+        case DT_JMPREL:   obj->jmprel = (const Elf64_Rela *)(obj->base + d->d_val); break;
+        case DT_PLTRELSZ: obj->pltrelsz = d->d_val; break;
+        default: break;
+        }
+    }
+}
+
+/* Find the program's dynamic section through its program headers. */
+static void dl_find_program(DlObject *prog, const Elf64_Phdr *phdr,
+                            uint64_t phnum) {
+    prog->base = 0;
+    prog->dynamic = NULL;
+    for (uint64_t i = 0; i < phnum; i++) {
+        if (phdr[i].p_type == PT_PHDR) {
+            prog->base = (uint64_t)phdr - phdr[i].p_vaddr;
+        }
+    }
+    for (uint64_t i = 0; i < phnum; i++) {
+        if (phdr[i].p_type == PT_DYNAMIC) {
+            prog->dynamic = (const Elf64_Dyn *)(prog->base + phdr[i].p_vaddr);
+        }
+    }
+    if (prog->dynamic == NULL) dl_fail("program is not dynamically linked", NULL);
+    dl_parse_dynamic(prog);
+
+    /* libarc.so is the only library there is */
+    for (const Elf64_Dyn *d = prog->dynamic; d->d_tag != DT_NULL; d++) {
+        if (d->d_tag == DT_NEEDED && !dl_streq(prog->strtab + d->d_val, DL_SONAME)) {
+            dl_fail("library not found", prog->strtab + d->d_val);
+        }
+    }
+}
+
+static uint32_t dl_elf_hash(const char *name) {
+    uint32_t h = 0;
+    while (*name != '\0') {
+        h = (h << 4) + (uint8_t)*name++;
+        uint32_t g = h & 0xF0000000U;
+        if (g != 0) h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/* Find a definition of name in obj. A program's undefined function with a
+ * value is its canonical PLT address: it defines the symbol for everything
+ * but PLT slots. */
+static const Elf64_Sym *dl_lookup_in(const DlObject *obj, const char *name,
+                                     uint32_t hash, int plt_slot) {
+    if (obj->hash == NULL) return NULL;
+    uint32_t nbucket = obj->hash[0];
+    const uint32_t *bucket = obj->hash + 2;
+    const uint32_t *chain = bucket + nbucket;
+
+    for (uint32_t i = bucket[hash % nbucket]; i != STN_UNDEF; i = chain[i]) {
+        const Elf64_Sym *sym = &obj->symtab[i];
+        uint32_t bind = ELF64_ST_BIND(sym->st_info);
+        if (bind != STB_GLOBAL && bind != STB_WEAK) continue;
+        if (sym->st_value == 0) continue;
+        if (sym->st_shndx == SHN_UNDEF && plt_slot) continue;
+        if (dl_streq(obj->strtab + sym->st_name, name)) return sym;
+    }
+    return NULL;
+}
+
+/* Resolve symbol symidx of obj for a relocation of the given type. Copy
+ * relocations look past the program for the data being copied. */
+static uint64_t dl_resolve(const DlScope *scope, const DlObject *obj,
+                           uint32_t symidx, uint32_t type,
+                           const Elf64_Sym **def_out) {
+    const Elf64_Sym *ref = &obj->symtab[symidx];
+    const char *name = obj->strtab + ref->st_name;
+    uint32_t hash = dl_elf_hash(name);
+    int plt_slot = (type == R_X86_64_JUMP_SLOT);
+
+    const Elf64_Sym *def;
+    if (type != R_X86_64_COPY) {
+        def = dl_lookup_in(&scope->prog, name, hash, plt_slot);
+        if (def != NULL) {
+            if (def_out != NULL) *def_out = def;
+            return scope->prog.base + def->st_value;
+        }
+    }
+    def = dl_lookup_in(&scope->lib, name, hash, plt_slot);
+    if (def != NULL) {
+        if (def_out != NULL) *def_out = def;
+        return scope->lib.base + def->st_value;
+    }
+
+    if (ELF64_ST_BIND(ref->st_info) == STB_WEAK) return 0;
+    dl_fail("undefined symbol", name);
+}
+
+static void dl_relocate_table(const DlScope *scope, const DlObject *obj,
+                              const Elf64_Rela *rel, uint64_t size) {
+    uint64_t count = size / sizeof(Elf64_Rela);
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t type = ELF64_R_TYPE(rel[i].r_info);
+        uint32_t symidx = ELF64_R_SYM(rel[i].r_info);
+        uint64_t *where = (uint64_t *)(obj->base + rel[i].r_offset);
+
+        switch (type) {
+        case R_X86_64_NONE:
+            break;
+        case R_X86_64_RELATIVE:
+            *where = obj->base + (uint64_t)rel[i].r_addend;
+            break;
+        case R_X86_64_64:
+            *where = dl_resolve(scope, obj, symidx, type, NULL) +
+                     (uint64_t)rel[i].r_addend;
+            break;
+        case R_X86_64_GLOB_DAT:
+        case R_X86_64_JUMP_SLOT:
+            *where = dl_resolve(scope, obj, symidx, type, NULL);
+            break;
+        case R_X86_64_COPY: {
+            const Elf64_Sym *def = NULL;
+            const uint8_t *src = (const uint8_t *)
+                dl_resolve(scope, obj, symidx, type, &def);
+            uint64_t n = obj->symtab[symidx].st_size;
+            if (def == NULL || def->st_size < n) {
+                dl_fail("bad copy relocation", obj->strtab + obj->symtab[symidx].st_name);
+            }
+            for (uint64_t b = 0; b < n; b++) ((uint8_t *)where)[b] = src[b];
+            break;
+        }
+        default:
+            dl_fail("unsupported relocation type", NULL);
+        }
+    }
+}
+
+static void dl_relocate(const DlScope *scope, const DlObject *obj) {
+    if (obj->rela != NULL) dl_relocate_table(scope, obj, obj->rela, obj->relasz);
+    if (obj->jmprel != NULL) dl_relocate_table(scope, obj, obj->jmprel, obj->pltrelsz);
+}
+
+/* Interpreter entry point (ELF e_entry of libarc.so) */
+DL_HIDDEN __attribute__((noreturn))
+void _dl_start(uint64_t argc, char **argv) {
+    /* argv[], NULL, envp[], NULL, then the auxiliary vector */
+    char **p = argv + argc + 1;
+    while (*p != NULL) p++;
+    const Elf64_auxv_t *auxv = (const Elf64_auxv_t *)(p + 1);
+
+    uint64_t at_phdr = 0, at_phnum = 0, at_entry = 0, at_base = 0;
+    for (; auxv->a_type != AT_NULL; auxv++) {
+        switch (auxv->a_type) {
+        case AT_PHDR:  at_phdr = auxv->a_val; break;
+        case AT_PHNUM: at_phnum = auxv->a_val; break;
+        case AT_ENTRY: at_entry = auxv->a_val; break;
+        case AT_BASE:  at_base = auxv->a_val; break;
+        default: break;
+        }
+    }
+    if (at_phdr == 0 || at_entry == 0) dl_fail("run as a program interpreter only", NULL);
+
+    DlScope scope;
+    scope.lib.base = at_base;
+    scope.lib.dynamic = _DYNAMIC;
+    dl_parse_dynamic(&scope.lib);
+    dl_find_program(&scope.prog, (const Elf64_Phdr *)at_phdr, at_phnum);
+
+    /* The library first: copy relocations in the program take initialized
+     * (relocated) library data */
+    dl_relocate(&scope, &scope.lib);
+    dl_relocate(&scope, &scope.prog);
+
+    ((dl_entry_t)at_entry)(argc, argv);
+    syscall1(SYS_EXIT, 127);
+    for (;;) __asm__ volatile ("ud2");
+}
@@ -0,0 +1,52 @@
+/* arc_os libc — asynchronous I/O rings */
+
+#include <io_ring.h>
+#include <syscall.h>
+#include <string.h>
+#include <errno.h>
+
+extern int errno;
+
+int io_ring_init(IoRing *ring, unsigned entries) {
+    int64_t ret = syscall1(SYS_IO_RING_SETUP, (uint64_t)entries);
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+
+    uint8_t *base = (uint8_t *)ret;
+    ring->hdr = (IoRingHeader *)base;
+    ring->sqes = (IoSqe *)(base + ring->hdr->sq_off);
+    ring->cqes = (IoCqe *)(base + ring->hdr->cq_off);
+    return 0;
+}
+
+int io_ring_submit(IoRing *ring, unsigned wait_nr) {
+    uint32_t pending = ring->hdr->sq_tail -
+                       __atomic_load_n(&ring->hdr->sq_head, __ATOMIC_ACQUIRE);
+    int64_t ret = syscall2(SYS_IO_RING_ENTER, (uint64_t)pending, (uint64_t)wait_nr);
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+    return (int)ret;
+}
+
+IoSqe *io_ring_get_sqe(IoRing *ring) {
+    IoRingHeader *h = ring->hdr;
+    uint32_t tail = h->sq_tail;
+    if (tail - __atomic_load_n(&h->sq_head, __ATOMIC_ACQUIRE) >= h->sq_entries) {
+        return NULL;
+    }
+    IoSqe *sqe = &ring->sqes[tail & h->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    /* Publish the slot when the caller has filled it: the kernel reads
+     * nothing until the next io_ring_submit */
+    __atomic_store_n(&h->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+IoCqe *io_ring_peek_cqe(IoRing *ring) {
+    IoRingHeader *h = ring->hdr;
+    uint32_t head = h->cq_head;
+    if (head == __atomic_load_n(&h->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &ring->cqes[head & h->cq_mask];
+}
+
+void io_ring_cqe_seen(IoRing *ring) {
+    __atomic_store_n(&ring->hdr->cq_head, ring->hdr->cq_head + 1, __ATOMIC_RELEASE);
+}
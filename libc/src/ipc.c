@@ -0,0 +1,32 @@
+/* arc_os libc — synchronous IPC endpoints */
+
+#include <ipc.h>
+#include <syscall.h>
+#include <errno.h>
+
+extern int errno;
+
+static int ipc_result(int64_t ret) {
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+    return (int)ret;
+}
+
+int ipc_endpoint(void) {
+    return ipc_result(syscall0(SYS_IPC_ENDPOINT));
+}
+
+int ipc_call(int fd, ipc_msg_t *msg) {
+    return ipc_result(syscall2(SYS_IPC_CALL, (uint64_t)fd, (uint64_t)msg));
+}
+
+int ipc_recv(int fd, ipc_msg_t *msg) {
+    return ipc_result(syscall2(SYS_IPC_RECV, (uint64_t)fd, (uint64_t)msg));
+}
+
+int ipc_reply(const ipc_msg_t *msg) {
+    return ipc_result(syscall1(SYS_IPC_REPLY, (uint64_t)msg));
+}
+
+int ipc_reply_recv(int fd, ipc_msg_t *msg) {
+    return ipc_result(syscall2(SYS_IPC_REPLY_RECV, (uint64_t)fd, (uint64_t)msg));
+}
@@ -0,0 +1,50 @@
+/* arc_os libc — mmap and POSIX shared memory */
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <syscall.h>
+#include <errno.h>
+
+extern int errno;
+
+#define SHM_DIR      "/dev/shm/"
+#define SHM_PATH_MAX 256
+
+void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off) {
+    int64_t ret = syscall6(SYS_MMAP, (uint64_t)addr, len, (uint64_t)prot,
+                           (uint64_t)flags, (uint64_t)fd, (uint64_t)off);
+    if (ret < 0) { errno = (int)(-ret); return MAP_FAILED; }
+    return (void *)ret;
+}
+
+int munmap(void *addr, size_t len) {
+    int64_t ret = syscall2(SYS_MUNMAP, (uint64_t)addr, len);
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+    return 0;
+}
+
+/* "/name" or "name" -> "/dev/shm/name" */
+static int shm_path(const char *name, char *path) {
+    if (name[0] == '/') name++;
+    size_t len = strlen(name);
+    if (len == 0 || strchr(name, '/') != NULL) { errno = EINVAL; return -1; }
+    if (sizeof(SHM_DIR) + len > SHM_PATH_MAX) { errno = ENAMETOOLONG; return -1; }
+    memcpy(path, SHM_DIR, sizeof(SHM_DIR) - 1);
+    memcpy(path + sizeof(SHM_DIR) - 1, name, len + 1);
+    return 0;
+}
+
+int shm_open(const char *name, int oflag, mode_t mode) {
+    (void)mode;
+    char path[SHM_PATH_MAX];
+    if (shm_path(name, path) < 0) return -1;
+    return open(path, oflag);
+}
+
+int shm_unlink(const char *name) {
+    char path[SHM_PATH_MAX];
+    if (shm_path(name, path) < 0) return -1;
+    return unlink(path);
+}
@@ -0,0 +1,30 @@
+/* arc_os libc — scheduling policy */
+
+#include <sched.h>
+#include <syscall.h>
+#include <errno.h>
+#include <stddef.h>
+
+extern int errno;
+
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param *param) {
+    if (param == NULL) { errno = EINVAL; return -1; }
+    int64_t ret = syscall3(SYS_SCHED_SETSCHEDULER, (uint64_t)pid, (uint64_t)policy,
+                           (uint64_t)param->sched_priority);
+    if (ret < 0) { errno = (int)(-ret); return -1; }
+    return 0;
+}
+
+int sched_get_priority_min(int policy) {
+    if (policy == SCHED_FIFO || policy == SCHED_RR) return 1;
+    if (policy == SCHED_OTHER) return 0;
+    errno = EINVAL;
+    return -1;
+}
+
+int sched_get_priority_max(int policy) {
+    if (policy == SCHED_FIFO || policy == SCHED_RR) return 99;
+    if (policy == SCHED_OTHER) return 0;
+    errno = EINVAL;
+    return -1;
+}
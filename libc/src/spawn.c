@@ -0,0 +1,101 @@
+/* arc_os libc — posix_spawn */
+
+#include <spawn.h>
+#include <syscall.h>
+#include <string.h>
+#include <errno.h>
+
+/* Mirrors kernel SpawnRequest */
+typedef struct {
+    uint32_t        flags;
+    int32_t         pgid;
+    uint32_t        nactions;
+    uint32_t        reserved;
+    SpawnFileAction actions[SPAWN_MAX_ACTIONS];
+} SpawnRequest;
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa) {
+    memset(fa, 0, sizeof(*fa));
+    return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa) {
+    fa->count = 0;
+    return 0;
+}
+
+static SpawnFileAction *fa_add(posix_spawn_file_actions_t *fa, uint32_t type, int fd) {
+    if (fd < 0) return NULL;
+    if (fa->count >= SPAWN_MAX_ACTIONS) return NULL;
+    SpawnFileAction *a = &fa->actions[fa->count++];
+    memset(a, 0, sizeof(*a));
+    a->type = type;
+    a->fd = fd;
+    return a;
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa, int fd) {
+    return fa_add(fa, SPAWN_FA_CLOSE, fd) ? 0 : ENOMEM;
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa,
+                                     int fd, int newfd) {
+    if (newfd < 0) return EBADF;
+    SpawnFileAction *a = fa_add(fa, SPAWN_FA_DUP2, fd);
+    if (a == NULL) return ENOMEM;
+    a->newfd = newfd;
+    return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa, int fd,
+                                     const char *path, int oflags, mode_t mode) {
+    (void)mode;
+    SpawnFileAction *a = fa_add(fa, SPAWN_FA_OPEN, fd);
+    if (a == NULL) return ENOMEM;
+    a->oflags = (uint32_t)oflags;
+    a->path = (uint64_t)path;
+    return 0;
+}
+
+int posix_spawnattr_init(posix_spawnattr_t *attr) {
+    memset(attr, 0, sizeof(*attr));
+    return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t *attr) {
+    (void)attr;
+    return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t *attr, short flags) {
+    if (flags & ~POSIX_SPAWN_SETPGROUP) return EINVAL;
+    attr->flags = (uint32_t)flags;
+    return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t *attr, pid_t pgroup) {
+    attr->pgroup = pgroup;
+    return 0;
+}
+
+int posix_spawn(pid_t *pid, const char *path,
+                const posix_spawn_file_actions_t *fa,
+                const posix_spawnattr_t *attr,
+                char *const argv[], char *const envp[]) {
+    (void)envp;
+    SpawnRequest req;
+    memset(&req, 0, sizeof(req));
+    if (attr != NULL) {
+        req.flags = attr->flags;
+        req.pgid = attr->pgroup;
+    }
+    if (fa != NULL) {
+        req.nactions = fa->count;
+        memcpy(req.actions, fa->actions, fa->count * sizeof(SpawnFileAction));
+    }
+
+    int64_t ret = syscall3(SYS_SPAWN, (uint64_t)path, (uint64_t)argv, (uint64_t)&req);
+    if (ret < 0) return (int)(-ret);
+    if (pid != NULL) *pid = (pid_t)ret;
+    return 0;
+}
@@ -55,6 +55,18 @@ int pipe(int pipefd[2]) {
     return set_errno(syscall1(SYS_PIPE, (uint64_t)pipefd));
 }
 
+int ftruncate(int fd, off_t length) {
+    return set_errno(syscall2(SYS_FTRUNCATE, (uint64_t)fd, (uint64_t)length));
+}
+
+int fsync(int fd) {
+    return set_errno(syscall1(SYS_FSYNC, (uint64_t)fd));
+}
+
+void sync(void) {
+    syscall0(SYS_SYNC);
+}
+
 pid_t fork(void) {
     int64_t ret = syscall0(SYS_FORK);
     if (ret < 0) { errno = (int)(-ret); return -1; }
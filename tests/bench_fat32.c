@@ -0,0 +1,250 @@
+/* arc_os — Host-side FAT32 sequential throughput benchmark
+ *
+ * Writes and reads back files of 1..64 MiB on a FAT32 image through
+ * kernel/fs/fat32.c and kernel/fs/bcache.c, comparing the driver's
+ * coalesced path (one device request per contiguous run) with the same
+ * transfer done a cluster at a time through the buffer cache, as the
+ * driver did before.  The image is loaded into memory; each device
+ * request can be charged a fixed latency to model a virtio round trip.
+ * Writes overwrite a file created beforehand, so the numbers measure
+ * the data path, not cluster allocation.
+ *
+ * Usage: bench_fat32 [image] [request_latency_us]
+ * A 34 MiB image (tools/make-fat32-test-disk.sh) covers files up to
+ * 32 MiB; make a bigger one for the rest, e.g.
+ *   tools/make-fat32-test-disk.sh /tmp/bench.img 160 */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Guard kernel headers that we stub */
+#define ARCHOS_LIB_KPRINTF_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_LIB_MEM_H
+#define ARCHOS_LIB_STRING_H
+#define ARCHOS_PROC_WORKQUEUE_H
+#define ARCHOS_ARCH_X86_64_PIT_H
+#define ARCHOS_FS_DCACHE_H
+
+#include "drivers/blkdev.h"
+#include "fs/vfs.h"
+
+static inline void kprintf(const char *fmt, ...) { (void)fmt; }
+
+#define GFP_ZERO 0x01
+static void *kmalloc(size_t size, uint32_t flags) {
+    void *p = malloc(size);
+    if (p && (flags & GFP_ZERO)) memset(p, 0, size);
+    return p;
+}
+static void kfree(void *ptr) { free(ptr); }
+static void *krealloc(void *ptr, size_t new_size) { return realloc(ptr, new_size); }
+
+static void dcache_invalidate_node(VfsNode *node) { (void)node; }
+
+static uint64_t pmm_get_free_pages(void) { return 1 << 20; }
+static uint64_t pit_get_uptime_ms(void) { return 0; }
+
+/* Write-back is driven by the benchmark (fat32_sync_volume), not a timer */
+typedef struct Work {
+    struct Work *next;
+    void       (*func)(struct Work *work);
+} Work;
+typedef void (*work_func_t)(Work *work);
+static void work_init(Work *work, work_func_t func) { work->next = NULL; work->func = func; }
+static int queue_delayed_work(Work *work, uint64_t delay_ms) {
+    (void)work; (void)delay_ms;
+    return 1;
+}
+static int queue_work(Work *work) {
+    work->func(work);
+    return 1;
+}
+
+#include "fs/bcache.c"
+#include "fs/fat32.c"
+
+/* --- RAM disk --- */
+
+static uint8_t *image, *disk;
+static size_t image_size;
+static uint64_t requests;
+static long latency_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void charge_request(void) {
+    requests++;
+    if (latency_ns <= 0) return;
+    uint64_t until = now_ns() + (uint64_t)latency_ns;
+    while (now_ns() < until) { }
+}
+
+static int ram_read(BlockDevice *dev, uint64_t sector, uint32_t count, void *buf) {
+    (void)dev;
+    if ((sector + count) * 512 > image_size) return -1;
+    charge_request();
+    memcpy(buf, disk + sector * 512, (size_t)count * 512);
+    return 0;
+}
+
+static int ram_write(BlockDevice *dev, uint64_t sector, uint32_t count, const void *buf) {
+    (void)dev;
+    if ((sector + count) * 512 > image_size) return -1;
+    charge_request();
+    memcpy(disk + sector * 512, buf, (size_t)count * 512);
+    return 0;
+}
+
+static BlockDevice ram_dev = { .read = ram_read, .write = ram_write };
+
+/* --- Cluster-at-a-time reference path --- */
+
+static int percluster_write(Fat32NodeInfo *info, const uint8_t *buf, uint32_t len) {
+    Fat32Volume *vol = info->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+    for (uint32_t off = 0; off < len; off += bpc) {
+        Buffer *b = fat32_get_cluster(vol, fat32_extent_cluster(info, off / bpc), 0);
+        if (b == NULL) return -1;
+        memcpy(b->data, buf + off, bpc);
+        bcache_mark_dirty(b);
+        bcache_release(b);
+    }
+    return bcache_flush(vol->dev);
+}
+
+static int percluster_read(Fat32NodeInfo *info, uint8_t *buf, uint32_t len) {
+    Fat32Volume *vol = info->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+    for (uint32_t off = 0; off < len; off += bpc) {
+        Buffer *b = fat32_get_cluster(vol, fat32_extent_cluster(info, off / bpc), 1);
+        if (b == NULL) return -1;
+        memcpy(buf + off, b->data, bpc);
+        bcache_release(b);
+    }
+    return 0;
+}
+
+/* --- Benchmark --- */
+
+#define CHUNK (64 * 1024)       /* Bytes per write/read call, like cp */
+
+static void reset_state(void) {
+    bcache_invalidate(&ram_dev);
+    memcpy(disk, image, image_size);
+}
+
+static double mib_per_s(uint32_t bytes, uint64_t ns) {
+    return ns ? (bytes / (1024.0 * 1024.0)) / (ns / 1e9) : 0.0;
+}
+
+static void run(uint32_t mib, uint8_t *data, uint8_t *back) {
+    uint32_t len = mib << 20;
+    reset_state();
+    VfsNode *root = fat32_mount(&ram_dev);
+    if (root == NULL) {
+        printf("  mount failed\n");
+        return;
+    }
+    Fat32Volume *vol = to_fat32(root)->vol;
+    if ((uint64_t)vol->total_clusters * vol->bytes_per_cluster < (uint64_t)len + (1u << 20)) {
+        printf("  %3u MiB  skipped (image too small)\n", mib);
+        return;
+    }
+    VfsNode *f = root->ops->create(root, "bench.bin", VFS_FILE);
+    Fat32NodeInfo *info = to_fat32(f);
+    f->ops->truncate(f, 0);
+    if (f->ops->write(f, back, 0, len) != (int)len) {
+        printf("  %3u MiB  allocation failed\n", mib);
+        return;
+    }
+    fat32_sync_volume(vol);
+
+    /* Coalesced: the driver's own path */
+    bcache_invalidate(&ram_dev);
+    requests = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t off = 0; off < len; off += CHUNK) {
+        if (f->ops->write(f, data + off, off, CHUNK) != CHUNK) {
+            printf("  %3u MiB  write failed\n", mib);
+            return;
+        }
+    }
+    fat32_sync_volume(vol);
+    uint64_t w_ns = now_ns() - t0;
+    uint64_t w_req = requests;
+
+    bcache_invalidate(&ram_dev);
+    requests = 0;
+    t0 = now_ns();
+    for (uint32_t off = 0; off < len; off += CHUNK) {
+        f->ops->read(f, back + off, off, CHUNK);
+    }
+    uint64_t r_ns = now_ns() - t0;
+    uint64_t r_req = requests;
+    if (memcmp(back, data, len) != 0) printf("  %3u MiB  MISMATCH\n", mib);
+
+    /* Cluster at a time over the same clusters */
+    bcache_invalidate(&ram_dev);
+    requests = 0;
+    t0 = now_ns();
+    percluster_write(info, data, len);
+    uint64_t pw_ns = now_ns() - t0;
+    uint64_t pw_req = requests;
+
+    bcache_invalidate(&ram_dev);
+    requests = 0;
+    t0 = now_ns();
+    percluster_read(info, back, len);
+    uint64_t pr_ns = now_ns() - t0;
+    uint64_t pr_req = requests;
+
+    printf("  %3u MiB  write %8.1f MiB/s (%6llu req)  vs %8.1f MiB/s (%6llu req)"
+           "   read %8.1f MiB/s (%6llu req)  vs %8.1f MiB/s (%6llu req)\n",
+           mib, mib_per_s(len, w_ns), (unsigned long long)w_req,
+           mib_per_s(len, pw_ns), (unsigned long long)pw_req,
+           mib_per_s(len, r_ns), (unsigned long long)r_req,
+           mib_per_s(len, pr_ns), (unsigned long long)pr_req);
+}
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "tests/fat32_test.img";
+    latency_ns = (argc > 2) ? atol(argv[2]) * 1000L : 20000L;
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "bench_fat32: cannot open %s\n", path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    image_size = (size_t)ftell(fp);
+    rewind(fp);
+    image = malloc(image_size);
+    disk = malloc(image_size);
+    if (image == NULL || disk == NULL || fread(image, 1, image_size, fp) != image_size) {
+        fprintf(stderr, "bench_fat32: cannot load %s\n", path);
+        return 1;
+    }
+    fclose(fp);
+
+    uint32_t max = 64u << 20;
+    uint8_t *data = malloc(max), *back = malloc(max);
+    for (uint32_t i = 0; i < max; i++) data[i] = (uint8_t)(i * 7 + (i >> 12));
+    memset(back, 0, max);       /* Fault it in before timing */
+
+    printf("=== arc_os FAT32 sequential I/O: coalesced vs per-cluster ===\n");
+    printf("  image %s (%zu MiB), %ld us per request, %u KiB calls\n",
+           path, image_size >> 20, latency_ns / 1000, CHUNK / 1024);
+    for (uint32_t mib = 1; mib <= 64; mib *= 2) run(mib, data, back);
+    return 0;
+}
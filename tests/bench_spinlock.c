@@ -0,0 +1,220 @@
+/* arc_os — Host-side spinlock contention microbenchmark
+ *
+ * Compares the old test-and-set Spinlock with the queued (MCS) Spinlock and
+ * the reader-writer spinlock from kernel/proc/spinlock.c.  Each pthread plays
+ * one CPU and hammers a shared lock for a fixed wall-clock interval; we report
+ * total throughput and fairness (min/max per-thread acquisitions).
+ *
+ * Usage: bench_spinlock [max_threads] [millis_per_run] */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* Host-safe reproduction of proc/spinlock.h (see tests/test_spinlock.c) */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
+
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+#define SPINLOCK_LOCKED       1u
+#define SPINLOCK_LOCKED_MASK  0x000000FFu
+#define SPINLOCK_TAIL_SHIFT   16
+#define SPINLOCK_TAIL_MASK    0xFFFF0000u
+#define MCS_NODES_PER_CPU 4
+
+typedef struct McsNode {
+    struct McsNode *volatile next;
+    volatile uint32_t        locked;
+} McsNode;
+
+static inline uint64_t spin_irq_save(void) { return 0; }
+static inline void spin_irq_restore(uint64_t flags) { (void)flags; }
+
+/* Preemption is a kernel notion: host threads have no preempt count */
+static inline void preempt_disable(void) { }
+static inline void preempt_enable(void) { }
+
+/* With more threads than host CPUs a queued waiter may be descheduled; the
+ * kernel never sees that (it spins with IRQs off), so yield in that case. */
+static int bench_oversubscribed;
+
+static inline void cpu_relax(void) {
+    if (bench_oversubscribed) sched_yield();
+    else __asm__ volatile ("pause" ::: "memory");
+}
+
+void spinlock_acquire_slow(Spinlock *lock);
+
+static inline void spinlock_acquire(Spinlock *lock) {
+    uint64_t flags = spin_irq_save();
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&lock->locked, &expected, SPINLOCK_LOCKED,
+                                     0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        spinlock_acquire_slow(lock);
+    }
+    lock->saved_flags = flags;
+}
+
+static inline void spinlock_release(Spinlock *lock) {
+    uint64_t flags = lock->saved_flags;
+    __atomic_store_n((volatile uint8_t *)&lock->locked, 0, __ATOMIC_RELEASE);
+    spin_irq_restore(flags);
+}
+
+typedef struct {
+    volatile uint32_t cnts;
+    Spinlock wait_lock;
+    uint64_t saved_flags;
+} RwSpinlock;
+
+#define RWSPINLOCK_INIT { .cnts = 0, .wait_lock = SPINLOCK_INIT, .saved_flags = 0 }
+#define RWLOCK_WLOCKED   0x000000FFu
+#define RWLOCK_WWAITING  0x00000100u
+#define RWLOCK_WMASK     (RWLOCK_WLOCKED | RWLOCK_WWAITING)
+#define RWLOCK_RBIAS     0x00000200u
+
+#define MAX_CPUS 16
+typedef struct {
+    uint32_t cpu_id;
+    McsNode  mcs_nodes[MCS_NODES_PER_CPU];
+    uint32_t mcs_depth;
+} PerCpu;
+
+static PerCpu percpu_data[MAX_CPUS];
+static __thread PerCpu *bench_this_cpu;
+
+static PerCpu *this_cpu(void) { return bench_this_cpu; }
+
+#include "../kernel/proc/spinlock.c"
+
+/* The pre-MCS kernel lock: test-and-set on a single word */
+static inline void tas_acquire(Spinlock *lock) {
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        cpu_relax();
+    }
+}
+
+static inline void tas_release(Spinlock *lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+/* --- Harness --- */
+
+enum { MODE_TAS, MODE_MCS, MODE_RW_READ90 };
+
+static const char *mode_names[] = { "tas", "mcs", "rwlock 90% read" };
+
+static Spinlock   bench_lock;
+static RwSpinlock bench_rw;
+static volatile int bench_stop;
+static volatile uint64_t shared_counter;
+
+typedef struct {
+    uint32_t cpu;
+    int      mode;
+    uint64_t ops;
+} Worker;
+
+/* Small critical section touching shared data, like pmm bitmap updates */
+static inline void critical_section(void) {
+    shared_counter++;
+    for (volatile int i = 0; i < 8; i++) { }
+}
+
+static void *bench_worker(void *arg) {
+    Worker *w = (Worker *)arg;
+    percpu_data[w->cpu].cpu_id = w->cpu;
+    bench_this_cpu = &percpu_data[w->cpu];
+
+    uint64_t ops = 0;
+    uint32_t rng = w->cpu * 2654435761u + 1;
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        switch (w->mode) {
+        case MODE_TAS:
+            tas_acquire(&bench_lock);
+            critical_section();
+            tas_release(&bench_lock);
+            break;
+        case MODE_MCS:
+            spinlock_acquire(&bench_lock);
+            critical_section();
+            spinlock_release(&bench_lock);
+            break;
+        case MODE_RW_READ90:
+            rng = rng * 1103515245u + 12345u;
+            if ((rng >> 16) % 10 == 0) {
+                rwlock_write_acquire(&bench_rw);
+                critical_section();
+                rwlock_write_release(&bench_rw);
+            } else {
+                uint64_t f = rwlock_read_acquire(&bench_rw);
+                (void)shared_counter;
+                rwlock_read_release(&bench_rw, f);
+            }
+            break;
+        }
+        ops++;
+    }
+    w->ops = ops;
+    return NULL;
+}
+
+static void run(int mode, int nthreads, int millis) {
+    Worker workers[MAX_CPUS];
+    pthread_t threads[MAX_CPUS];
+
+    bench_lock = (Spinlock)SPINLOCK_INIT;
+    bench_rw = (RwSpinlock)RWSPINLOCK_INIT;
+    bench_stop = 0;
+    shared_counter = 0;
+    bench_oversubscribed = nthreads > sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 0; i < nthreads; i++) {
+        workers[i] = (Worker){ .cpu = (uint32_t)i, .mode = mode, .ops = 0 };
+        pthread_create(&threads[i], NULL, bench_worker, &workers[i]);
+    }
+
+    struct timespec ts = { millis / 1000, (long)(millis % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    __atomic_store_n(&bench_stop, 1, __ATOMIC_RELAXED);
+
+    uint64_t total = 0, min = UINT64_MAX, max = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+        total += workers[i].ops;
+        if (workers[i].ops < min) min = workers[i].ops;
+        if (workers[i].ops > max) max = workers[i].ops;
+    }
+
+    double mops = (double)total / (millis * 1000.0);
+    double fairness = max ? (double)min / (double)max : 1.0;
+    printf("  %-16s threads=%-2d  %8.2f Mops/s  fairness(min/max)=%.2f\n",
+           mode_names[mode], nthreads, mops, fairness);
+}
+
+int main(int argc, char **argv) {
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int millis = (argc > 2) ? atoi(argv[2]) : 500;
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > MAX_CPUS) max_threads = MAX_CPUS;
+
+    printf("=== arc_os spinlock contention benchmark ===\n");
+    for (int n = 1; n <= max_threads; n *= 2) {
+        run(MODE_TAS, n, millis);
+        run(MODE_MCS, n, millis);
+        run(MODE_RW_READ90, n, millis);
+    }
+    return 0;
+}
@@ -11,6 +11,8 @@
 #define ARCHOS_NET_NETIF_H
 #define ARCHOS_LIB_MEM_H
 #define ARCHOS_LIB_KPRINTF_H
+#define ARCHOS_PROC_RCU_H
+#define ARCHOS_PROC_SPINLOCK_H
 
 /* Inline types */
 #define ETH_ALEN        6
@@ -75,10 +77,54 @@ static int eth_send(struct NetIf *nif, const uint8_t dst[ETH_ALEN],
 
 static void kprintf(const char *fmt, ...) { (void)fmt; }
 
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* RCU stubs — call_rcu queues callbacks until the test ends the grace
+ * period with rcu_test_flush() */
+typedef struct RcuHead {
+    struct RcuHead *next;
+    uint64_t        gp;
+    void          (*func)(struct RcuHead *head);
+} RcuHead;
+typedef void (*rcu_callback_t)(RcuHead *head);
+
+#define rcu_dereference(p)        (p)
+#define rcu_assign_pointer(p, v)  ((p) = (v))
+
+static RcuHead *rcu_test_pending;
+static int rcu_test_pending_count;
+
+static void call_rcu(RcuHead *head, rcu_callback_t func) {
+    head->func = func;
+    head->next = rcu_test_pending;
+    rcu_test_pending = head;
+    rcu_test_pending_count++;
+}
+
+static void rcu_test_flush(void) {
+    while (rcu_test_pending) {
+        RcuHead *h = rcu_test_pending;
+        rcu_test_pending = h->next;
+        h->func(h);
+    }
+    rcu_test_pending_count = 0;
+}
+
 /* Include arp.c */
 #include "../kernel/net/arp.c"
 
 static void reset(void) {
+    rcu_test_pending = NULL;
+    rcu_test_pending_count = 0;
     arp_init();
     eth_send_called = 0;
     eth_send_len = 0;
@@ -291,6 +337,57 @@ TEST(rx_bad_hlen_ignored) {
     return 0;
 }
 
+TEST(update_keeps_old_entry_until_grace_period) {
+    reset();
+    uint32_t ip = IP4(10, 0, 2, 2);
+    uint8_t mac1[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    uint8_t mac2[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+    arp_insert(ip, mac1);
+    const uint8_t *reader = arp_lookup(ip);  /* Reader holds the old entry */
+    arp_insert(ip, mac2);
+
+    /* New lookups see the new MAC; the old reader's copy is untouched */
+    ASSERT_MEM_EQ(arp_lookup(ip), mac2, 6);
+    ASSERT_MEM_EQ(reader, mac1, 6);
+    ASSERT_EQ(rcu_test_pending_count, 1);
+
+    rcu_test_flush();
+    ASSERT_MEM_EQ(arp_lookup(ip), mac2, 6);
+    return 0;
+}
+
+TEST(refresh_same_mac_no_retire) {
+    reset();
+    uint32_t ip = IP4(10, 0, 2, 2);
+    uint8_t mac[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    arp_insert(ip, mac);
+    const uint8_t *first = arp_lookup(ip);
+    arp_insert(ip, mac);
+    ASSERT_TRUE(arp_lookup(ip) == first);
+    ASSERT_EQ(rcu_test_pending_count, 0);
+    return 0;
+}
+
+TEST(pool_exhaustion_drops_update) {
+    reset();
+    uint32_t ip = IP4(10, 0, 2, 2);
+    uint8_t mac[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x00};
+    /* Without a grace period, retired entries are never recycled */
+    for (int i = 0; i < ARP_CACHE_SIZE * 2; i++) {
+        mac[5] = (uint8_t)i;
+        arp_insert(ip, mac);
+    }
+    mac[5] = 0xFF;
+    arp_insert(ip, mac);
+    ASSERT_EQ(arp_lookup(ip)[5], ARP_CACHE_SIZE * 2 - 1);
+
+    /* After the grace period the pool refills and updates succeed */
+    rcu_test_flush();
+    arp_insert(ip, mac);
+    ASSERT_EQ(arp_lookup(ip)[5], 0xFF);
+    return 0;
+}
+
 /* --- Suite --- */
 
 TestCase arp_tests[] = {
@@ -307,5 +404,8 @@ TestCase arp_tests[] = {
     TEST_ENTRY(rx_request_wrong_target_no_reply),
     TEST_ENTRY(rx_reply_learns_sender),
     TEST_ENTRY(rx_bad_hlen_ignored),
+    TEST_ENTRY(update_keeps_old_entry_until_grace_period),
+    TEST_ENTRY(refresh_same_mac_no_retire),
+    TEST_ENTRY(pool_exhaustion_drops_update),
 };
 int arp_test_count = sizeof(arp_tests) / sizeof(arp_tests[0]);
@@ -0,0 +1,423 @@
+/* arc_os — Host-side tests for kernel/fs/bcache.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_LIB_MEM_H
+#define ARCHOS_ARCH_X86_64_PIT_H
+
+#define GFP_ZERO 0x01
+
+/* kmalloc via libc */
+static void *kmalloc(size_t size, uint32_t flags) {
+    void *p = malloc(size);
+    if (p && (flags & GFP_ZERO)) memset(p, 0, size);
+    return p;
+}
+static void kfree(void *ptr) { free(ptr); }
+
+/* PMM stub: free memory the cache sees */
+static uint64_t free_pages = 1 << 20;
+static uint64_t pmm_get_free_pages(void) { return free_pages; }
+
+/* PIT stub: uptime the tests advance by hand */
+static uint64_t now_ms;
+static uint64_t pit_get_uptime_ms(void) { return now_ms; }
+
+#include "../kernel/fs/bcache.c"
+
+/* RAM disk counting device I/O */
+#define DISK_SECTORS 512
+
+typedef struct {
+    BlockDevice dev;
+    uint8_t     data[DISK_SECTORS * 512];
+    int         reads;
+    int         writes;
+    int         fail;
+} RamDisk;
+
+static int ram_read(BlockDevice *dev, uint64_t sector, uint32_t count, void *buf) {
+    RamDisk *rd = (RamDisk *)dev;
+    if (rd->fail || sector + count > DISK_SECTORS) return -1;
+    rd->reads++;
+    memcpy(buf, rd->data + sector * 512, (size_t)count * 512);
+    return 0;
+}
+
+static int ram_write(BlockDevice *dev, uint64_t sector, uint32_t count, const void *buf) {
+    RamDisk *rd = (RamDisk *)dev;
+    if (rd->fail || sector + count > DISK_SECTORS) return -1;
+    rd->writes++;
+    memcpy(rd->data + sector * 512, buf, (size_t)count * 512);
+    return 0;
+}
+
+static RamDisk disk_a, disk_b;
+
+static void ram_init(RamDisk *rd, uint8_t seed) {
+    memset(rd, 0, sizeof(*rd));
+    rd->dev.read = ram_read;
+    rd->dev.write = ram_write;
+    for (int s = 0; s < DISK_SECTORS; s++) {
+        memset(rd->data + s * 512, (uint8_t)(seed + s), 512);
+    }
+}
+
+static void reset_bcache(void) {
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        kfree(buffers[i]->data);
+        kfree(buffers[i]);
+    }
+    buffer_count = 0;
+    clock_hand = 0;
+    dirty_count = 0;
+    now_ms = 0;
+    memset(hash_table, 0, sizeof(hash_table));
+    memset(dev_stats, 0, sizeof(dev_stats));
+    free_pages = 1 << 20;
+    ram_init(&disk_a, 0);
+    ram_init(&disk_b, 100);
+}
+
+/* --- Tests --- */
+
+TEST(read_miss_then_hit) {
+    reset_bcache();
+    Buffer *b = bcache_read(&disk_a.dev, 7, 2);
+    ASSERT_TRUE(b != NULL);
+    ASSERT_EQ(b->data[0], 7);
+    ASSERT_EQ(b->data[512], 8);
+    bcache_release(b);
+
+    Buffer *again = bcache_read(&disk_a.dev, 7, 2);
+    ASSERT_TRUE(again == b);
+    bcache_release(again);
+    ASSERT_EQ(disk_a.reads, 1);
+
+    BcacheStats st;
+    bcache_get_stats(&disk_a.dev, &st);
+    ASSERT_EQ(st.hits, 1);
+    ASSERT_EQ(st.misses, 1);
+    return 0;
+}
+
+TEST(dirty_written_back_on_flush) {
+    reset_bcache();
+    Buffer *b = bcache_read(&disk_a.dev, 3, 1);
+    memset(b->data, 0x5A, 512);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    ASSERT_EQ(disk_a.writes, 0);
+    ASSERT_EQ(disk_a.data[3 * 512], 3);
+
+    uint32_t count, dirty;
+    uint64_t bytes;
+    bcache_get_usage(&count, &bytes, &dirty);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(bytes, 512);
+    ASSERT_EQ(dirty, 1);
+
+    ASSERT_EQ(bcache_flush(&disk_a.dev), 0);
+    ASSERT_EQ(disk_a.writes, 1);
+    ASSERT_EQ(disk_a.data[3 * 512], 0x5A);
+    ASSERT_EQ(bcache_flush(NULL), 0);           /* Clean now */
+    ASSERT_EQ(disk_a.writes, 1);
+
+    BcacheStats st;
+    bcache_get_stats(&disk_a.dev, &st);
+    ASSERT_EQ(st.writebacks, 1);
+    return 0;
+}
+
+TEST(get_skips_device_read) {
+    reset_bcache();
+    Buffer *b = bcache_get(&disk_a.dev, 9, 1);
+    ASSERT_TRUE(b != NULL);
+    ASSERT_EQ(disk_a.reads, 0);
+    bcache_release(b);                          /* Never filled */
+
+    b = bcache_read(&disk_a.dev, 9, 1);
+    ASSERT_EQ(disk_a.reads, 1);
+    ASSERT_EQ(b->data[0], 9);
+    bcache_release(b);
+
+    /* A full overwrite through get is cached without reading */
+    b = bcache_get(&disk_a.dev, 10, 1);
+    memset(b->data, 1, 512);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    b = bcache_read(&disk_a.dev, 10, 1);
+    ASSERT_EQ(b->data[0], 1);
+    ASSERT_EQ(disk_a.reads, 1);
+    bcache_release(b);
+    return 0;
+}
+
+TEST(clock_evicts_unreferenced) {
+    reset_bcache();
+    Buffer *held = bcache_read(&disk_a.dev, 0, 1);
+    for (uint64_t s = 1; s < BCACHE_MAX_BUFFERS; s++) {
+        Buffer *b = bcache_read(&disk_a.dev, s, 1);
+        ASSERT_TRUE(b != NULL);
+        if (s == 1) {
+            b->data[0] = 0xEE;
+            bcache_mark_dirty(b);
+        }
+        bcache_release(b);
+    }
+    ASSERT_EQ(buffer_count, BCACHE_MAX_BUFFERS);
+
+    /* Full: the next block recycles a buffer instead of growing */
+    Buffer *b = bcache_read(&disk_a.dev, BCACHE_MAX_BUFFERS, 1);
+    ASSERT_TRUE(b != NULL);
+    bcache_release(b);
+    ASSERT_EQ(buffer_count, BCACHE_MAX_BUFFERS);
+
+    /* The held buffer survived; the dirty victim reached the disk */
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 0) == held);
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 1) == NULL);
+    ASSERT_EQ(disk_a.data[512], 0xEE);
+    bcache_release(held);
+    return 0;
+}
+
+TEST(memory_pressure_recycles) {
+    reset_bcache();
+    free_pages = BCACHE_MIN_FREE_PAGES - 1;
+    bcache_release(bcache_read(&disk_a.dev, 0, 1));
+    bcache_release(bcache_read(&disk_a.dev, 1, 1));
+    bcache_release(bcache_read(&disk_a.dev, 2, 1));
+    ASSERT_EQ(buffer_count, 1);
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 2) != NULL);
+
+    /* All buffers in use: grow anyway rather than fail */
+    Buffer *b2 = bcache_read(&disk_a.dev, 2, 1);
+    Buffer *b3 = bcache_read(&disk_a.dev, 3, 1);
+    ASSERT_TRUE(b3 != NULL && b3 != b2);
+    ASSERT_EQ(buffer_count, 2);
+    bcache_release(b2);
+    bcache_release(b3);
+    return 0;
+}
+
+TEST(size_change_rereads) {
+    reset_bcache();
+    Buffer *b = bcache_read(&disk_a.dev, 20, 1);
+    b->data[0] = 0x77;
+    bcache_mark_dirty(b);
+    bcache_release(b);
+
+    /* Same start sector, bigger block: write back, then read both sectors */
+    b = bcache_read(&disk_a.dev, 20, 2);
+    ASSERT_TRUE(b != NULL);
+    ASSERT_EQ(disk_a.writes, 1);
+    ASSERT_EQ(b->data[0], 0x77);
+    ASSERT_EQ(b->data[512], 21);
+
+    /* Not while someone holds it */
+    ASSERT_TRUE(bcache_read(&disk_a.dev, 20, 1) == NULL);
+    bcache_release(b);
+    return 0;
+}
+
+TEST(invalidate_and_io_errors) {
+    reset_bcache();
+    Buffer *held = bcache_read(&disk_a.dev, 1, 1);
+    Buffer *b = bcache_read(&disk_a.dev, 2, 1);
+    b->data[0] = 0x33;
+    bcache_mark_dirty(b);
+    bcache_release(b);
+
+    /* Dropped without write-back; held buffers stay */
+    bcache_invalidate(&disk_a.dev);
+    ASSERT_EQ(disk_a.writes, 0);
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 2) == NULL);
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 1) == held);
+    bcache_release(held);
+
+    /* A failed read caches nothing */
+    disk_a.fail = 1;
+    ASSERT_TRUE(bcache_read(&disk_a.dev, 2, 1) == NULL);
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 2) == NULL);
+
+    /* A failed write-back leaves the buffer dirty */
+    disk_a.fail = 0;
+    b = bcache_read(&disk_a.dev, 4, 1);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    disk_a.fail = 1;
+    ASSERT_EQ(bcache_flush(&disk_a.dev), -EIO);
+    ASSERT_TRUE(b->dirty);
+    disk_a.fail = 0;
+    return 0;
+}
+
+TEST(flush_aged_writes_old_buffers) {
+    reset_bcache();
+    now_ms = 1000;
+    Buffer *old = bcache_read(&disk_a.dev, 1, 1);
+    bcache_mark_dirty(old);
+    bcache_release(old);
+    now_ms = 4000;
+    Buffer *young = bcache_read(&disk_b.dev, 2, 1);
+    bcache_mark_dirty(young);
+    bcache_release(young);
+
+    /* Re-dirtying keeps the original age */
+    now_ms = 5000;
+    bcache_mark_dirty(old);
+    ASSERT_EQ(old->dirtied_ms, 1000);
+
+    ASSERT_EQ(bcache_flush_aged(5500, 5000), 0);
+    ASSERT_EQ(bcache_flush_aged(6000, 5000), 1);
+    ASSERT_EQ(disk_a.writes, 1);
+    ASSERT_EQ(disk_b.writes, 0);
+    ASSERT_EQ(dirty_count, 1);
+
+    disk_b.fail = 1;
+    ASSERT_EQ(bcache_flush_aged(9000, 5000), -EIO);
+    ASSERT_EQ(dirty_count, 1);
+    disk_b.fail = 0;
+    ASSERT_EQ(bcache_flush_aged(9000, 5000), 1);
+    ASSERT_EQ(dirty_count, 0);
+    return 0;
+}
+
+TEST(read_direct_coalesces_uncached_runs) {
+    reset_bcache();
+    /* Block 1 of 4 is cached and dirty: the disk copy is stale */
+    Buffer *b = bcache_read(&disk_a.dev, 42, 2);
+    memset(b->data, 0xCC, 1024);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+    disk_a.reads = 0;
+
+    uint8_t out[8 * 512];
+    ASSERT_EQ(bcache_read_direct(&disk_a.dev, 40, 8, 2, out), 0);
+    ASSERT_EQ(disk_a.reads, 2);                 /* Blocks 0, then 2-3 */
+    ASSERT_EQ(out[0], 40);
+    ASSERT_EQ(out[2 * 512], 0xCC);
+    ASSERT_EQ(out[4 * 512], 44);
+    ASSERT_EQ(out[7 * 512], 47);
+    ASSERT_EQ(buffer_count, 1);                 /* Nothing new cached */
+
+    /* Long runs are split into bounded requests */
+    uint8_t *big = malloc(300 * 512);
+    disk_a.reads = 0;
+    ASSERT_EQ(bcache_read_direct(&disk_a.dev, 100, 300, 1, big), 0);
+    ASSERT_EQ(disk_a.reads, 2);
+    ASSERT_EQ(big[299 * 512], (uint8_t)(100 + 299));
+    free(big);
+
+    ASSERT_EQ(bcache_read_direct(&disk_a.dev, 0, 3, 2, out), -EINVAL);
+    return 0;
+}
+
+TEST(write_direct_updates_cached_copies) {
+    reset_bcache();
+    Buffer *b = bcache_read(&disk_a.dev, 12, 4);
+    memset(b->data, 0x11, 4 * 512);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+
+    uint8_t in[16 * 512];
+    memset(in, 0x77, sizeof(in));
+    ASSERT_EQ(bcache_write_direct(&disk_a.dev, 8, 16, 4, in), 0);
+    ASSERT_EQ(disk_a.writes, 1);
+    ASSERT_EQ(disk_a.data[12 * 512], 0x77);
+
+    /* The cached block holds the new data and is clean */
+    ASSERT_FALSE(b->dirty);
+    ASSERT_EQ(b->data[0], 0x77);
+    ASSERT_EQ(dirty_count, 0);
+    ASSERT_EQ(bcache_flush(NULL), 0);
+    ASSERT_EQ(disk_a.writes, 1);
+
+    disk_a.fail = 1;
+    ASSERT_EQ(bcache_write_direct(&disk_a.dev, 8, 16, 4, in), -EIO);
+    disk_a.fail = 0;
+    return 0;
+}
+
+TEST(prefetch_fills_uncached_runs) {
+    reset_bcache();
+    Buffer *b = bcache_read(&disk_a.dev, 24, 4);        /* Block 2 of 0..5 */
+    memset(b->data, 0xCC, 4 * 512);
+    bcache_mark_dirty(b);
+    bcache_release(b);
+
+    /* Blocks 0-1 and 3-5 in one request each; the dirty one is kept */
+    disk_a.reads = 0;
+    ASSERT_EQ(bcache_prefetch(&disk_a.dev, 16, 24, 4), 5);
+    ASSERT_EQ(disk_a.reads, 2);
+    ASSERT_EQ(buffer_count, 6);
+    ASSERT_EQ(b->data[0], 0xCC);
+
+    /* Later reads of the range are hits */
+    disk_a.reads = 0;
+    b = bcache_read(&disk_a.dev, 36, 4);
+    ASSERT_TRUE(b != NULL);
+    ASSERT_EQ(b->data[0], 36);
+    ASSERT_EQ(b->refs, 1);
+    bcache_release(b);
+    ASSERT_EQ(disk_a.reads, 0);
+    ASSERT_EQ(bcache_prefetch(&disk_a.dev, 16, 24, 4), 0);
+    ASSERT_EQ(disk_a.reads, 0);
+
+    /* A failed read caches nothing */
+    disk_a.fail = 1;
+    ASSERT_EQ(bcache_prefetch(&disk_a.dev, 100, 8, 4), 0);
+    disk_a.fail = 0;
+    ASSERT_TRUE(bcache_find(&disk_a.dev, 100) == NULL);
+    reset_bcache();
+    return 0;
+}
+
+TEST(devices_are_separate) {
+    reset_bcache();
+    Buffer *a = bcache_read(&disk_a.dev, 5, 1);
+    Buffer *b = bcache_read(&disk_b.dev, 5, 1);
+    ASSERT_TRUE(a != b);
+    ASSERT_EQ(a->data[0], 5);
+    ASSERT_EQ(b->data[0], 105);
+    bcache_mark_dirty(b);
+    bcache_release(a);
+    bcache_release(b);
+
+    bcache_release(bcache_read(&disk_a.dev, 5, 1));
+    ASSERT_EQ(bcache_flush(&disk_a.dev), 0);
+    ASSERT_EQ(disk_b.writes, 0);
+
+    BcacheStats st;
+    bcache_get_stats(&disk_a.dev, &st);
+    ASSERT_EQ(st.hits, 1);
+    ASSERT_EQ(st.misses, 1);
+    bcache_get_stats(&disk_b.dev, &st);
+    ASSERT_EQ(st.hits, 0);
+    ASSERT_EQ(st.misses, 1);
+    reset_bcache();
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase bcache_tests[] = {
+    TEST_ENTRY(read_miss_then_hit),
+    TEST_ENTRY(dirty_written_back_on_flush),
+    TEST_ENTRY(get_skips_device_read),
+    TEST_ENTRY(clock_evicts_unreferenced),
+    TEST_ENTRY(memory_pressure_recycles),
+    TEST_ENTRY(size_change_rereads),
+    TEST_ENTRY(invalidate_and_io_errors),
+    TEST_ENTRY(flush_aged_writes_old_buffers),
+    TEST_ENTRY(read_direct_coalesces_uncached_runs),
+    TEST_ENTRY(write_direct_updates_cached_copies),
+    TEST_ENTRY(prefetch_fills_uncached_runs),
+    TEST_ENTRY(devices_are_separate),
+};
+int bcache_test_count = sizeof(bcache_tests) / sizeof(bcache_tests[0]);
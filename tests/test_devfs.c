@@ -15,6 +15,9 @@
 #define VFS_FILE      0
 #define VFS_DIRECTORY 1
 #define VFS_NAME_MAX  256
+#define VFS_OK        0
+#define ENOMEM       12
+#define EINVAL       22
 
 typedef struct VfsNode VfsNode;
 typedef struct VfsDirEntry VfsDirEntry;
@@ -81,6 +84,7 @@ static void tty_reset(void) {
 
 /* Declare devfs_init before including the .c */
 VfsNode *devfs_init(void);
+int devfs_attach(const char *name, VfsNode *node);
 
 #include "../kernel/fs/devfs.c"
 
@@ -204,6 +208,26 @@ TEST(readdir_lists_three) {
     return 0;
 }
 
+TEST(attach_adds_subdirectory) {
+    VfsNode *root = devfs_init();
+    VfsNode shm = { .inode_num = 3000, .type = VFS_DIRECTORY };
+    ASSERT_EQ(devfs_attach("shm", &shm), 0);
+    ASSERT_TRUE(root->ops->lookup(root, "shm") == &shm);
+
+    VfsDirEntry entries[8];
+    ASSERT_EQ(root->ops->readdir(root, entries, 8), 4);
+    ASSERT_STR_EQ(entries[3].name, "shm");
+    ASSERT_EQ(entries[3].type, VFS_DIRECTORY);
+
+    /* The table is bounded; re-initializing drops attachments */
+    for (int i = 4; i < 8; i++) ASSERT_EQ(devfs_attach("x", &shm), 0);
+    ASSERT_EQ(devfs_attach("x", &shm), -ENOMEM);
+    ASSERT_EQ(devfs_attach("y", NULL), -EINVAL);
+    devfs_init();
+    ASSERT_TRUE(root->ops->lookup(root, "shm") == NULL);
+    return 0;
+}
+
 TEST(no_create_or_unlink) {
     VfsNode *root = devfs_init();
     ASSERT_TRUE(root->ops->create == NULL);
@@ -227,6 +251,7 @@ TestCase devfs_tests[] = {
     TEST_ENTRY(tty_read_calls_through),
     TEST_ENTRY(tty_write_calls_through),
     TEST_ENTRY(readdir_lists_three),
+    TEST_ENTRY(attach_adds_subdirectory),
     TEST_ENTRY(no_create_or_unlink),
 };
 int devfs_test_count = sizeof(devfs_tests) / sizeof(devfs_tests[0]);
@@ -0,0 +1,265 @@
+/* arc_os — Host-side tests for the libarc.so dynamic loader (libc/src/dl.c) */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+
+/* Use the libc's ELF definitions, not the host's */
+#define _ELF_H 1
+#include "../libc/include/elf.h"
+
+/* Syscall stubs: capture loader errors, turn exit into a longjmp */
+#define SYS_EXIT   0
+#define SYS_WRITE  1
+
+static char dl_err[256];
+static int dl_err_len;
+static jmp_buf dl_exit_jmp;
+
+static int64_t syscall3(uint64_t num, uint64_t a0, uint64_t a1, uint64_t a2) {
+    if (num == SYS_WRITE && a0 == 2) {
+        for (uint64_t i = 0; i < a2 && dl_err_len < (int)sizeof(dl_err) - 1; i++) {
+            dl_err[dl_err_len++] = ((const char *)a1)[i];
+        }
+        dl_err[dl_err_len] = '\0';
+    }
+    return (int64_t)a2;
+}
+
+static int64_t syscall1(uint64_t num, uint64_t a0) {
+    if (num == SYS_EXIT) longjmp(dl_exit_jmp, (int)a0 + 1);
+    return 0;
+}
+
+/* The loader's own dynamic section; only _dl_start reads it. The host
+ * executable has a real _DYNAMIC, so the loader's is renamed. */
+#define _DYNAMIC test_dynamic
+Elf64_Dyn test_dynamic[1];
+
+#include "../libc/src/dl.c"
+
+/* --- Synthetic objects --- */
+
+/* Symbols: 0 is STN_UNDEF; one bucket chains every symbol */
+#define MAX_SYMS 8
+
+typedef struct {
+    DlObject  obj;
+    Elf64_Sym syms[MAX_SYMS];
+    char      strtab[256];
+    uint32_t  hash[2 + 1 + MAX_SYMS];
+    uint32_t  nsyms;
+    uint32_t  strtab_used;
+} TestObject;
+
+static void obj_init(TestObject *t, uint64_t base) {
+    memset(t, 0, sizeof(*t));
+    t->obj.base = base;
+    t->obj.symtab = t->syms;
+    t->obj.strtab = t->strtab;
+    t->obj.hash = t->hash;
+    t->nsyms = 1;
+    t->strtab_used = 1;
+    t->hash[0] = 1;                 /* nbucket */
+}
+
+static uint32_t obj_add_sym(TestObject *t, const char *name, uint8_t bind,
+                            uint16_t shndx, uint64_t value, uint64_t size) {
+    uint32_t idx = t->nsyms++;
+    Elf64_Sym *s = &t->syms[idx];
+    s->st_name = t->strtab_used;
+    s->st_info = (uint8_t)(bind << 4);
+    s->st_shndx = shndx;
+    s->st_value = value;
+    s->st_size = size;
+    strcpy(t->strtab + t->strtab_used, name);
+    t->strtab_used += (uint32_t)strlen(name) + 1;
+
+    /* Rebuild the single chain: bucket -> 1 -> 2 -> ... -> 0 */
+    t->hash[1] = t->nsyms;          /* nchain */
+    t->hash[2] = 1;
+    uint32_t *chain = &t->hash[3];
+    for (uint32_t i = 1; i < t->nsyms; i++) {
+        chain[i] = (i + 1 < t->nsyms) ? i + 1 : 0;
+    }
+    return idx;
+}
+
+static Elf64_Rela rela(uint64_t offset, uint32_t sym, uint32_t type, int64_t addend) {
+    Elf64_Rela r = { .r_offset = offset,
+                     .r_info = ((uint64_t)sym << 32) | type,
+                     .r_addend = addend };
+    return r;
+}
+
+static void reset_dl(void) {
+    dl_err[0] = '\0';
+    dl_err_len = 0;
+}
+
+/* --- Tests --- */
+
+TEST(dl_elf_hash_matches_abi) {
+    ASSERT_EQ(dl_elf_hash("printf"), 0x077905a6);
+    ASSERT_EQ(dl_elf_hash("exit"), 0x0006cf04);
+    ASSERT_EQ(dl_elf_hash(""), 0);
+    return 0;
+}
+
+TEST(dl_relative_adds_base) {
+    reset_dl();
+    static uint64_t slots[2];
+    static TestObject lib, prog;
+    obj_init(&lib, (uint64_t)slots);
+    obj_init(&prog, 0);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela r[2] = { rela(0, 0, R_X86_64_RELATIVE, 0x40),
+                        rela(8, 0, R_X86_64_NONE, 0) };
+    slots[1] = 77;
+    dl_relocate_table(&scope, &lib.obj, r, sizeof(r));
+    ASSERT_EQ(slots[0], (uint64_t)slots + 0x40);
+    ASSERT_EQ(slots[1], 77);
+    return 0;
+}
+
+TEST(dl_program_definition_wins) {
+    reset_dl();
+    static uint64_t lib_mem[4], prog_mem[4];
+    static TestObject lib, prog;
+    obj_init(&lib, (uint64_t)lib_mem);
+    obj_init(&prog, 0);
+    /* Both define errno: the program's (copy-relocated) one is used */
+    uint32_t lib_errno = obj_add_sym(&lib, "errno", STB_GLOBAL, 5, 16, 4);
+    obj_add_sym(&prog, "errno", STB_GLOBAL, 7, (uint64_t)&prog_mem[2], 4);
+    uint32_t lib_malloc = obj_add_sym(&lib, "malloc", STB_GLOBAL, 3, 0x100, 0);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela r[2] = { rela(0, lib_errno, R_X86_64_GLOB_DAT, 0),
+                        rela(8, lib_malloc, R_X86_64_64, 8) };
+    dl_relocate_table(&scope, &lib.obj, r, sizeof(r));
+    ASSERT_EQ(lib_mem[0], (uint64_t)&prog_mem[2]);
+    ASSERT_EQ(lib_mem[1], (uint64_t)lib_mem + 0x108);
+    return 0;
+}
+
+TEST(dl_plt_slot_skips_canonical_address) {
+    reset_dl();
+    static uint64_t lib_mem[2], got[2];
+    static TestObject lib, prog;
+    obj_init(&lib, (uint64_t)lib_mem);
+    obj_init(&prog, 0);
+    obj_add_sym(&lib, "puts", STB_GLOBAL, 3, 0x200, 0);
+    /* The program takes puts' address: undefined, valued at its PLT entry */
+    uint32_t ref = obj_add_sym(&prog, "puts", STB_GLOBAL, SHN_UNDEF, 0x401020, 0);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela slot = rela((uint64_t)&got[0], ref, R_X86_64_JUMP_SLOT, 0);
+    dl_relocate_table(&scope, &prog.obj, &slot, sizeof(slot));
+    ASSERT_EQ(got[0], (uint64_t)lib_mem + 0x200);
+
+    /* Data references see the canonical address */
+    Elf64_Rela dat = rela((uint64_t)&got[1], ref, R_X86_64_GLOB_DAT, 0);
+    dl_relocate_table(&scope, &prog.obj, &dat, sizeof(dat));
+    ASSERT_EQ(got[1], 0x401020);
+    return 0;
+}
+
+TEST(dl_copy_takes_library_data) {
+    reset_dl();
+    static uint64_t lib_mem[4], prog_stdout;
+    static TestObject lib, prog;
+    obj_init(&lib, (uint64_t)lib_mem);
+    obj_init(&prog, 0);
+    lib_mem[2] = 0xABCDEF;
+    obj_add_sym(&lib, "stdout", STB_GLOBAL, 5, 16, 8);
+    uint32_t ref = obj_add_sym(&prog, "stdout", STB_GLOBAL, 9,
+                               (uint64_t)&prog_stdout, 8);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela r = rela((uint64_t)&prog_stdout, ref, R_X86_64_COPY, 0);
+    dl_relocate_table(&scope, &prog.obj, &r, sizeof(r));
+    ASSERT_EQ(prog_stdout, 0xABCDEF);
+    return 0;
+}
+
+TEST(dl_weak_undefined_is_zero) {
+    reset_dl();
+    static uint64_t slot = 5;
+    static TestObject lib, prog;
+    obj_init(&lib, 0);
+    obj_init(&prog, 0);
+    uint32_t ref = obj_add_sym(&prog, "__optional", STB_WEAK, SHN_UNDEF, 0, 0);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela r = rela((uint64_t)&slot, ref, R_X86_64_GLOB_DAT, 0);
+    dl_relocate_table(&scope, &prog.obj, &r, sizeof(r));
+    ASSERT_EQ(slot, 0);
+    return 0;
+}
+
+TEST(dl_undefined_symbol_exits) {
+    reset_dl();
+    static uint64_t slot;
+    static TestObject lib, prog;
+    obj_init(&lib, 0);
+    obj_init(&prog, 0);
+    uint32_t ref = obj_add_sym(&prog, "missing_fn", STB_GLOBAL, SHN_UNDEF, 0, 0);
+    DlScope scope = { .prog = prog.obj, .lib = lib.obj };
+
+    Elf64_Rela r = rela((uint64_t)&slot, ref, R_X86_64_JUMP_SLOT, 0);
+    int status = setjmp(dl_exit_jmp);
+    if (status == 0) {
+        dl_relocate_table(&scope, &prog.obj, &r, sizeof(r));
+        ASSERT_TRUE(0);
+    }
+    ASSERT_EQ(status - 1, 127);
+    ASSERT_STR_EQ(dl_err, "libarc.so: undefined symbol: missing_fn\n");
+    return 0;
+}
+
+TEST(dl_find_program_reads_dynamic) {
+    reset_dl();
+    static char strtab[] = "\0libarc.so\0libm.so";
+    static Elf64_Dyn dyn[4];
+    static Elf64_Phdr phdr[2];
+    memset(phdr, 0, sizeof(phdr));
+    phdr[0].p_type = PT_LOAD;
+    phdr[1].p_type = PT_DYNAMIC;
+    phdr[1].p_vaddr = (uint64_t)dyn;
+    dyn[0].d_tag = DT_STRTAB; dyn[0].d_val = (uint64_t)strtab;
+    dyn[1].d_tag = DT_NEEDED; dyn[1].d_val = 1;
+    dyn[2].d_tag = DT_NULL;
+
+    DlObject prog;
+    dl_find_program(&prog, phdr, 2);
+    ASSERT_EQ(prog.base, 0);
+    ASSERT_TRUE(prog.dynamic == dyn);
+    ASSERT_TRUE(prog.strtab == strtab);
+
+    /* Any other library is missing */
+    dyn[2].d_tag = DT_NEEDED; dyn[2].d_val = 11;
+    dyn[3].d_tag = DT_NULL;
+    int status = setjmp(dl_exit_jmp);
+    if (status == 0) {
+        dl_find_program(&prog, phdr, 2);
+        ASSERT_TRUE(0);
+    }
+    ASSERT_STR_EQ(dl_err, "libarc.so: library not found: libm.so\n");
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase dl_tests[] = {
+    TEST_ENTRY(dl_elf_hash_matches_abi),
+    TEST_ENTRY(dl_relative_adds_base),
+    TEST_ENTRY(dl_program_definition_wins),
+    TEST_ENTRY(dl_plt_slot_skips_canonical_address),
+    TEST_ENTRY(dl_copy_takes_library_data),
+    TEST_ENTRY(dl_weak_undefined_is_zero),
+    TEST_ENTRY(dl_undefined_symbol_exits),
+    TEST_ENTRY(dl_find_program_reads_dynamic),
+};
+int dl_test_count = sizeof(dl_tests) / sizeof(dl_tests[0]);
@@ -105,9 +105,27 @@ typedef struct {
     uint64_t p_align;
 } Elf64_Phdr;
 
+#define ELF_MAX_SEGMENTS 8
+
 typedef struct {
-    uint64_t entry_point;
-    uint64_t brk_start;
+    uint64_t vaddr;
+    uint64_t memsz;
+    uint64_t offset;
+    uint64_t filesz;
+    uint32_t flags;
+} ElfSegment;
+
+typedef struct {
+    uint64_t   entry_point;
+    uint64_t   brk_start;
+    uint16_t   type;
+    uint16_t   phnum;
+    uint16_t   phentsize;
+    uint64_t   phdr;
+    uint64_t   interp_offset;
+    uint64_t   interp_size;
+    uint32_t   nsegs;
+    ElfSegment segs[ELF_MAX_SEGMENTS];
 } ElfLoadResult;
 
 /* ELF constants */
@@ -124,15 +142,22 @@ typedef struct {
 #define ELFCLASS64  2
 #define ELFDATA2LSB 1
 #define ET_EXEC     2
+#define ET_DYN      3
 #define EM_X86_64   62
 #define PT_NULL     0
 #define PT_LOAD     1
+#define PT_DYNAMIC  2
+#define PT_INTERP   3
+#define PT_PHDR     6
+#define ELF_INTERP_MAX 128
 #define PF_X        (1 << 0)
 #define PF_W        (1 << 1)
 #define PF_R        (1 << 2)
 
-/* Declare elf_load before including the implementation */
+/* Declare elf_parse/elf_load before including the implementation */
+int elf_parse(const void *data, size_t size, uint64_t file_size, ElfLoadResult *result);
 int elf_load(const void *data, size_t size, uint64_t pml4_phys, ElfLoadResult *result);
+int elf_rebase(ElfLoadResult *result, uint64_t base, uint64_t limit);
 
 /* Include the real elf.c implementation */
 #include "../kernel/proc/elf.c"
@@ -285,6 +310,167 @@ TEST(multi_page_segment) {
     return 0;
 }
 
+TEST(parse_records_segments_without_mapping) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400010, 6, 300, 0x2800);
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), 0);
+    ASSERT_EQ(map_call_count, 0);
+    ASSERT_EQ(allocated_page_count, 0);
+    ASSERT_EQ(result.nsegs, 1);
+    ASSERT_EQ(result.segs[0].vaddr, 0x400000);
+    ASSERT_EQ(result.segs[0].memsz, 0x2800);
+    ASSERT_EQ(result.segs[0].filesz, 300);
+    ASSERT_EQ(result.segs[0].offset, sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr));
+    ASSERT_EQ(result.segs[0].flags, 6);
+    ASSERT_EQ(result.entry_point, 0x400010);
+    ASSERT_EQ(result.brk_start, 0x403000);
+    return 0;
+}
+
+TEST(parse_checks_against_whole_file) {
+    reset_stubs();
+    uint8_t buf[4096];
+    /* Only the header page is in memory; segment data lies beyond it */
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    Elf64_Phdr *phdr = (Elf64_Phdr *)(buf + sizeof(Elf64_Ehdr));
+    phdr->p_offset = 0x3000;
+    phdr->p_filesz = 0x1000;
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), 0x4000, &result), 0);
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), 0x3800, &result), -EINVAL);
+    return 0;
+}
+
+TEST(parse_rejects_phdrs_past_prefix) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(Elf64_Ehdr) + 8, sizeof(buf), &result), -EINVAL);
+    return 0;
+}
+
+TEST(parse_rejects_filesz_over_memsz) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 512, 256);
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), -EINVAL);
+    return 0;
+}
+
+TEST(parse_rejects_too_many_segments) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)buf;
+    Elf64_Phdr *phdrs = (Elf64_Phdr *)(buf + sizeof(Elf64_Ehdr));
+    ehdr->e_phnum = ELF_MAX_SEGMENTS + 1;
+    for (int i = 0; i < ELF_MAX_SEGMENTS + 1; i++) {
+        phdrs[i] = phdrs[0];
+        phdrs[i].p_vaddr = 0x400000 + (uint64_t)i * 0x1000;
+    }
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), -EINVAL);
+    return 0;
+}
+
+/* Turn the minimal ELF into a dynamically linked one: a second program
+ * header names an interpreter stored at offset 0x200. */
+static void add_interp(uint8_t *buf, const char *path) {
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)buf;
+    Elf64_Phdr *phdrs = (Elf64_Phdr *)(buf + sizeof(Elf64_Ehdr));
+    ehdr->e_phnum = 2;
+    memset(&phdrs[1], 0, sizeof(Elf64_Phdr));
+    phdrs[1].p_type = PT_INTERP;
+    phdrs[1].p_offset = 0x200;
+    phdrs[1].p_filesz = strlen(path) + 1;
+    memcpy(buf + 0x200, path, strlen(path) + 1);
+}
+
+TEST(parse_records_interp_and_phdrs) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0x400, 0x1000);
+    Elf64_Phdr *phdr = (Elf64_Phdr *)(buf + sizeof(Elf64_Ehdr));
+    phdr->p_offset = 0;  /* Text loads from the start of the file */
+    add_interp(buf, "/lib/libarc.so");
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), 0);
+    ASSERT_EQ(result.type, ET_EXEC);
+    ASSERT_EQ(result.interp_offset, 0x200);
+    ASSERT_EQ(result.interp_size, 15);
+    ASSERT_EQ(result.phnum, 2);
+    ASSERT_EQ(result.phentsize, sizeof(Elf64_Phdr));
+    ASSERT_EQ(result.phdr, 0x400000 + sizeof(Elf64_Ehdr));
+    ASSERT_EQ(result.nsegs, 1);
+    return 0;
+}
+
+TEST(parse_rejects_bad_interp) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    add_interp(buf, "/lib/libarc.so");
+    Elf64_Phdr *interp = (Elf64_Phdr *)(buf + sizeof(Elf64_Ehdr)) + 1;
+    ElfLoadResult result;
+    interp->p_filesz = ELF_INTERP_MAX + 1;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), -EINVAL);
+    interp->p_filesz = 15;
+    interp->p_offset = sizeof(buf) - 4;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), -EINVAL);
+    return 0;
+}
+
+TEST(rebase_moves_shared_object) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x1000, 0x1040, 5, 0x100, 0x2000);
+    ((Elf64_Ehdr *)buf)->e_type = ET_DYN;
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), 0);
+    ASSERT_EQ(result.type, ET_DYN);
+    ASSERT_EQ(elf_rebase(&result, 0x7E0000000000ULL, 0x7E0040000000ULL), 0);
+    ASSERT_EQ(result.segs[0].vaddr, 0x7E0000001000ULL);
+    ASSERT_EQ(result.segs[0].offset, sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr));
+    ASSERT_EQ(result.entry_point, 0x7E0000001040ULL);
+    ASSERT_EQ(result.brk_start, 0x7E0000003000ULL);
+    return 0;
+}
+
+TEST(rebase_rejects_bad_targets) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x1000, 0x1000, 5, 0, 0x2000);
+    ElfLoadResult result;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), 0);
+    ASSERT_EQ(elf_rebase(&result, 0x100000, 0x200000), -EINVAL);  /* ET_EXEC */
+
+    ((Elf64_Ehdr *)buf)->e_type = ET_DYN;
+    ASSERT_EQ(elf_parse(buf, sizeof(buf), sizeof(buf), &result), 0);
+    ASSERT_EQ(elf_rebase(&result, 0x100800, 0x200000), -EINVAL);  /* Unaligned */
+    ASSERT_EQ(elf_rebase(&result, 0x100000, 0x102000), -EINVAL);  /* Too big */
+    ASSERT_EQ(result.segs[0].vaddr, 0x1000);
+    return 0;
+}
+
+TEST(load_refuses_dynamic_binaries) {
+    reset_stubs();
+    uint8_t buf[4096];
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    add_interp(buf, "/lib/libarc.so");
+    ElfLoadResult result;
+    ASSERT_EQ(elf_load(buf, sizeof(buf), 0x200000, &result), -EINVAL);
+
+    build_minimal_elf(buf, sizeof(buf), 0x400000, 0x400000, 5, 0, 4096);
+    ((Elf64_Ehdr *)buf)->e_type = ET_DYN;
+    ASSERT_EQ(elf_load(buf, sizeof(buf), 0x200000, &result), -EINVAL);
+    ASSERT_EQ(map_call_count, 0);
+    return 0;
+}
+
 /* --- Suite --- */
 
 TestCase elf_tests[] = {
@@ -298,5 +484,15 @@ TestCase elf_tests[] = {
     TEST_ENTRY(segment_maps_correct_flags),
     TEST_ENTRY(kernel_space_rejected),
     TEST_ENTRY(multi_page_segment),
+    TEST_ENTRY(parse_records_segments_without_mapping),
+    TEST_ENTRY(parse_checks_against_whole_file),
+    TEST_ENTRY(parse_rejects_phdrs_past_prefix),
+    TEST_ENTRY(parse_rejects_filesz_over_memsz),
+    TEST_ENTRY(parse_rejects_too_many_segments),
+    TEST_ENTRY(parse_records_interp_and_phdrs),
+    TEST_ENTRY(parse_rejects_bad_interp),
+    TEST_ENTRY(rebase_moves_shared_object),
+    TEST_ENTRY(rebase_rejects_bad_targets),
+    TEST_ENTRY(load_refuses_dynamic_binaries),
 };
 int elf_test_count = sizeof(elf_tests) / sizeof(elf_tests[0]);
@@ -8,6 +8,7 @@
 #define ARCHOS_MM_KMALLOC_H
 #define ARCHOS_LIB_MEM_H
 #define ARCHOS_LIB_STRING_H
+#define ARCHOS_PROC_WORKQUEUE_H
 
 /* Need BlockDevice type before stubs */
 #include "../kernel/drivers/blkdev.h"
@@ -30,10 +31,15 @@ static void *krealloc(void *ptr, size_t new_size) { return realloc(ptr, new_size
 
 /* File-backed block device for tests */
 static FILE *disk_file;
+static int disk_reads;
+static uint32_t disk_largest_write;     /* Sectors in the biggest request */
+static uint64_t watch_lo, watch_hi;     /* Writes to [lo, hi) are counted */
+static int watch_writes;
 
 static int disk_blk_read(BlockDevice *dev, uint64_t sector, uint32_t count, void *buf) {
     (void)dev;
     if (!disk_file) return -1;
+    disk_reads++;
     if (fseek(disk_file, (long)(sector * 512), SEEK_SET) != 0) return -1;
     return (fread(buf, 512, count, disk_file) == count) ? 0 : -1;
 }
@@ -41,6 +47,8 @@ static int disk_blk_read(BlockDevice *dev, uint64_t sector, uint32_t count, void
 static int disk_blk_write(BlockDevice *dev, uint64_t sector, uint32_t count, const void *buf) {
     (void)dev;
     if (!disk_file) return -1;
+    if (count > disk_largest_write) disk_largest_write = count;
+    if (sector < watch_hi && sector + count > watch_lo) watch_writes++;
     if (fseek(disk_file, (long)(sector * 512), SEEK_SET) != 0) return -1;
     if (fwrite(buf, 512, count, disk_file) != count) return -1;
     fflush(disk_file);
@@ -54,6 +62,33 @@ static BlockDevice test_blkdev = {
     .private_data = NULL,
 };
 
+/* Workqueue stub: deferred work runs immediately, so the image on disk is
+ * up to date when a test re-reads it */
+typedef struct Work {
+    struct Work *next;
+    void       (*func)(struct Work *work);
+} Work;
+typedef void (*work_func_t)(Work *work);
+
+static int delayed_work_count;
+
+static void work_init(Work *work, work_func_t func) {
+    work->next = NULL;
+    work->func = func;
+}
+
+static int queue_delayed_work(Work *work, uint64_t delay_ms) {
+    (void)delay_ms;
+    delayed_work_count++;
+    work->func(work);
+    return 1;
+}
+
+static int queue_work(Work *work) {
+    work->func(work);
+    return 1;
+}
+
 /* Include FAT32 implementation only (vfs.c already compiled in test_vfs.c) */
 #include "../kernel/fs/fat32.c"
 
@@ -70,8 +105,6 @@ static VfsNode *mount_test_disk(void) {
     if (!disk_file) return NULL;
 
     /* Reset FAT32-internal state */
-    node_cache_count = 0;
-    next_fat_inode = 0x10000;
 
     return fat32_mount(&test_blkdev);
 }
@@ -103,8 +136,6 @@ static VfsNode *mount_writable_copy(void) {
     rewind(dst);
 
     disk_file = dst;
-    node_cache_count = 0;
-    next_fat_inode = 0x10000;
 
     return fat32_mount(&test_blkdev);
 }
@@ -130,7 +161,6 @@ static int test_bpb_reject_bad_sector_size(void) {
     fflush(disk_file);
     rewind(disk_file);
 
-    node_cache_count = 0;
     VfsNode *root = fat32_mount(&test_blkdev);
     ASSERT_TRUE(root == NULL);
     fclose(disk_file);
@@ -143,12 +173,92 @@ static int test_fat_table_loaded(void) {
     ASSERT_TRUE(root != NULL);
     Fat32NodeInfo *info = to_fat32(root);
     /* FAT entries for cluster 2 (root) should be non-free */
-    uint32_t root_entry = info->vol->fat[info->vol->root_cluster] & FAT32_ENTRY_MASK;
+    uint32_t root_entry = fat32_fat_get(info->vol, info->vol->root_cluster);
     ASSERT_TRUE(root_entry != FAT32_FREE);
     unmount_test_disk();
     return 0;
 }
 
+static int test_fat_paged_on_demand(void) {
+    int reads = disk_reads;
+    VfsNode *root = mount_test_disk();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = to_fat32(root)->vol;
+
+    /* Mount reads the boot and FSInfo sectors and nothing of the FAT */
+    ASSERT_EQ(disk_reads, reads + 2);
+    ASSERT_EQ(vol->num_fats, 2);
+
+    /* First use of a page reads it whole; the rest of it is then cached */
+    reads = disk_reads;
+    ASSERT_TRUE(fat32_fat_get(vol, vol->root_cluster) != FAT32_FREE);
+    ASSERT_EQ(disk_reads, reads + 1);
+    fat32_fat_get(vol, FAT32_FAT_PAGE_ENTRIES - 1);
+    ASSERT_EQ(disk_reads, reads + 1);
+    fat32_fat_get(vol, FAT32_FAT_PAGE_ENTRIES);
+    ASSERT_EQ(disk_reads, reads + 2);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_fat_sync_writes_dirty_sectors(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = to_fat32(root)->vol;
+    VfsNode *f = root->ops->create(root, "one.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+
+    /* A one-cluster file changes one FAT sector: one write per copy */
+    watch_lo = vol->fat_start;
+    watch_hi = vol->data_start;
+    watch_writes = 0;
+    ASSERT_EQ(f->ops->write(f, "x", 0, 1), 1);
+    ASSERT_EQ(watch_writes, vol->num_fats);
+    ASSERT_EQ(vol->fat_dirty, 0);
+
+    /* Both copies on disk agree */
+    uint32_t cluster = to_fat32(f)->first_cluster;
+    uint32_t sector = cluster / (SECTOR_SIZE / 4);
+    uint32_t a[SECTOR_SIZE / 4], b[SECTOR_SIZE / 4];
+    ASSERT_EQ(disk_blk_read(NULL, vol->fat_start + sector, 1, a), 0);
+    ASSERT_EQ(disk_blk_read(NULL, vol->fat_start + vol->fat_sectors + sector, 1, b), 0);
+    ASSERT_MEM_EQ(a, b, SECTOR_SIZE);
+    ASSERT_TRUE((a[cluster % (SECTOR_SIZE / 4)] & FAT32_ENTRY_MASK) >= FAT32_EOC);
+
+    /* Nothing changed, nothing written */
+    watch_writes = 0;
+    ASSERT_EQ(fat32_sync_volume(vol), 0);
+    ASSERT_EQ(watch_writes, 0);
+    watch_lo = watch_hi = 0;
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_fat_page_eviction_keeps_changes(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = to_fat32(root)->vol;
+    uint32_t pages = (vol->total_clusters + 2) / FAT32_FAT_PAGE_ENTRIES;
+    ASSERT_TRUE(pages > FAT32_FAT_PAGES);
+
+    /* Touch one free entry per page: more pages than the cache holds */
+    for (uint32_t pg = 0; pg < pages; pg++) {
+        uint32_t c = pg * FAT32_FAT_PAGE_ENTRIES + 1000;
+        ASSERT_EQ(fat32_fat_get(vol, c), FAT32_FREE);
+        ASSERT_EQ(fat32_fat_set(vol, c, FAT32_EOC), 0);
+    }
+    ASSERT_TRUE(vol->fat_dirty <= FAT32_FAT_PAGES);
+
+    /* Evicted pages were written back and read again */
+    for (uint32_t pg = 0; pg < pages; pg++) {
+        ASSERT_EQ(fat32_fat_get(vol, pg * FAT32_FAT_PAGE_ENTRIES + 1000), FAT32_EOC);
+    }
+    ASSERT_EQ(fat32_sync_volume(vol), 0);
+    ASSERT_EQ(vol->fat_dirty, 0);
+    unmount_test_disk();
+    return 0;
+}
+
 static int test_root_readdir(void) {
     VfsNode *root = mount_test_disk();
     ASSERT_TRUE(root != NULL);
@@ -437,12 +547,595 @@ static int test_truncate_to_zero(void) {
     return 0;
 }
 
+static int test_truncate_defers_sync(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = ((Fat32NodeInfo *)root->private_data)->vol;
+
+    VfsNode *node = root->ops->lookup(root, "hello.txt");
+    ASSERT_TRUE(node != NULL);
+
+    /* Truncate frees clusters (dirtying the FAT) and queues write-back
+     * instead of flushing inline; the stub runs the work immediately. */
+    delayed_work_count = 0;
+    node->ops->truncate(node, 0);
+    ASSERT_EQ(delayed_work_count, 1);
+    ASSERT_EQ(vol->fat_dirty, 0);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_repeated_read_hits_cache(void) {
+    VfsNode *root = mount_test_disk();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *node = root->ops->lookup(root, "hello.txt");
+    ASSERT_TRUE(node != NULL);
+
+    char buf[32];
+    ASSERT_EQ(node->ops->read(node, buf, 0, sizeof(buf)), 13);
+    VfsDirEntry entries[16];
+    root->ops->readdir(root, entries, 16);
+
+    /* Same clusters again: served from the buffer cache */
+    int reads = disk_reads;
+    ASSERT_EQ(node->ops->read(node, buf, 0, sizeof(buf)), 13);
+    ASSERT_TRUE(root->ops->lookup(root, "subdir") != NULL);
+    root->ops->readdir(root, entries, 16);
+    ASSERT_EQ(disk_reads, reads);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_write_survives_remount(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *node = root->ops->create(root, "keep.txt", VFS_FILE);
+    ASSERT_TRUE(node != NULL);
+    ASSERT_EQ(node->ops->write(node, "cached", 0, 6), 6);
+
+    /* Remount the same image: the cache is dropped, so this reads what
+     * the sync work wrote back */
+    root = fat32_mount(&test_blkdev);
+    ASSERT_TRUE(root != NULL);
+    node = root->ops->lookup(root, "keep.txt");
+    ASSERT_TRUE(node != NULL);
+    char buf[8] = {0};
+    ASSERT_EQ(node->ops->read(node, buf, 0, sizeof(buf)), 6);
+    ASSERT_MEM_EQ(buf, "cached", 6);
+    unmount_test_disk();
+    return 0;
+}
+
+/* === Extent map tests === */
+
+static void fill_pattern(uint8_t *buf, uint32_t len, uint32_t pos, uint8_t seed) {
+    for (uint32_t i = 0; i < len; i++) buf[i] = (uint8_t)((pos + i) * 7 + seed);
+}
+
+static int check_pattern(VfsNode *node, uint32_t pos, uint32_t len, uint8_t seed) {
+    uint8_t got[1024], want[1024];
+    if (len > sizeof(got)) return -1;
+    if (node->ops->read(node, got, pos, len) != (int)len) return -1;
+    fill_pattern(want, len, pos, seed);
+    return memcmp(got, want, len) == 0 ? 0 : -1;
+}
+
+static int test_extent_map_fragmented(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *a = root->ops->create(root, "a.bin", VFS_FILE);
+    ASSERT_TRUE(a != NULL);
+    Fat32NodeInfo *ai = to_fat32(a);
+    Fat32Volume *vol = ai->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+
+    /* Eight one-cluster files side by side, every other one deleted */
+    VfsNode *small[8];
+    char name[8];
+    for (int i = 0; i < 8; i++) {
+        snprintf(name, sizeof(name), "f%d", i);
+        small[i] = root->ops->create(root, name, VFS_FILE);
+        ASSERT_TRUE(small[i] != NULL);
+    }
+    for (int i = 0; i < 8; i++) ASSERT_EQ(small[i]->ops->write(small[i], "x", 0, 1), 1);
+    uint32_t hole = to_fat32(small[0])->first_cluster;
+    ASSERT_EQ(to_fat32(small[7])->first_cluster, hole + 7);
+    for (int i = 0; i < 8; i += 2) {
+        snprintf(name, sizeof(name), "f%d", i);
+        ASSERT_EQ(root->ops->unlink(root, name), 0);
+    }
+
+    /* A file written from the first hole on fills them one by one */
+    vol->next_free = hole;
+    uint8_t *chunk = malloc(bpc);
+    for (uint32_t i = 0; i < 4; i++) {
+        fill_pattern(chunk, bpc, i * bpc, 1);
+        ASSERT_EQ(a->ops->write(a, chunk, i * bpc, bpc), (int)bpc);
+    }
+    free(chunk);
+    ASSERT_EQ(ai->first_cluster, hole);
+    ASSERT_EQ(ai->mapped_clusters, 4);
+    ASSERT_EQ(ai->extent_count, 4);
+    ASSERT_EQ(fat32_extent_cluster(ai, 0), ai->first_cluster);
+    ASSERT_EQ(fat32_extent_cluster(ai, 3), ai->extents[3].disk_cluster);
+    ASSERT_EQ(fat32_extent_cluster(ai, 4), 0);
+
+    /* Reads straddling runs, then the same map rebuilt from the FAT */
+    ASSERT_EQ(check_pattern(a, bpc - 10, 20, 1), 0);
+    ASSERT_EQ(check_pattern(a, 3 * bpc - 100, 200, 1), 0);
+    root = fat32_mount(&test_blkdev);
+    a = root->ops->lookup(root, "a.bin");
+    ASSERT_TRUE(a != NULL);
+    ASSERT_EQ(check_pattern(a, 2 * bpc - 1, 2, 1), 0);
+    ASSERT_EQ(to_fat32(a)->extent_count, 4);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_extent_map_truncate_rebuilds(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *f = root->ops->create(root, "big.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    Fat32NodeInfo *info = to_fat32(f);
+    uint32_t bpc = info->vol->bytes_per_cluster;
+
+    /* One write of several clusters lands in one contiguous run */
+    uint32_t len = 6 * bpc;
+    uint8_t *data = malloc(len);
+    fill_pattern(data, len, 0, 3);
+    ASSERT_EQ(f->ops->write(f, data, 0, len), (int)len);
+    ASSERT_EQ(info->extent_count, 1);
+    ASSERT_EQ(info->mapped_clusters, 6);
+
+    f->ops->truncate(f, 2 * bpc + 1);
+    ASSERT_FALSE(info->extents_valid);
+    ASSERT_EQ(check_pattern(f, 2 * bpc - 4, 5, 3), 0);
+    ASSERT_EQ(info->mapped_clusters, 3);
+
+    /* Writing past the end grows chain and map, zero-filling the gap */
+    ASSERT_EQ(f->ops->write(f, data, 5 * bpc, 16), 16);
+    ASSERT_EQ(info->mapped_clusters, 6);
+    uint8_t gap[4] = { 1, 1, 1, 1 };
+    ASSERT_EQ(f->ops->read(f, gap, 4 * bpc, 4), 4);
+    ASSERT_EQ(gap[0] | gap[1] | gap[2] | gap[3], 0);
+    free(data);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_contiguous_io_coalesced(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *f = root->ops->create(root, "seq.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    Fat32Volume *vol = to_fat32(f)->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+
+    /* Eight whole clusters go out as one request, and no data is read:
+     * only the FAT page for their entries (the free map that picks them is
+     * built on the first allocation, so build it here) */
+    ASSERT_EQ(fat32_free_map_build(vol), 0);
+    uint32_t len = 8 * bpc;
+    uint8_t *data = malloc(len);
+    uint8_t *back = malloc(len);
+    fill_pattern(data, len, 0, 5);
+    disk_largest_write = 0;
+    int reads = disk_reads;
+    ASSERT_EQ(f->ops->write(f, data, 0, len), (int)len);
+    ASSERT_EQ(disk_largest_write, 8 * vol->sectors_per_cluster);
+    ASSERT_EQ(disk_reads, reads + 1);
+
+    /* Read back in one request; an unaligned head goes through the cache */
+    reads = disk_reads;
+    ASSERT_EQ(f->ops->read(f, back, 0, len), (int)len);
+    ASSERT_EQ(disk_reads, reads + 1);
+    ASSERT_MEM_EQ(back, data, len);
+    ASSERT_EQ(f->ops->read(f, back, 100, len - 100), (int)(len - 100));
+    ASSERT_MEM_EQ(back, data + 100, len - 100);
+
+    /* A partial overwrite goes through the cache; direct reads see it */
+    ASSERT_EQ(f->ops->write(f, "XY", bpc + 1, 2), 2);
+    ASSERT_EQ(f->ops->read(f, back, 0, len), (int)len);
+    ASSERT_MEM_EQ(back + bpc + 1, "XY", 2);
+    free(data);
+    free(back);
+    unmount_test_disk();
+    return 0;
+}
+
+/* === Allocation tests === */
+
+static uint32_t disk_fsinfo_free(Fat32Volume *vol) {
+    Fat32FsInfo fsi;
+    if (disk_blk_read(NULL, vol->fsinfo_sector, 1, &fsi) != 0) return 0;
+    return fsi.free_count;
+}
+
+static int test_free_map_built_on_first_allocation(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = to_fat32(root)->vol;
+    ASSERT_TRUE(vol->fsinfo_sector != 0);
+    ASSERT_TRUE(vol->free_map == NULL);
+    uint32_t free_before = vol->free_count;
+    ASSERT_EQ(disk_fsinfo_free(vol), free_before);
+
+    /* Three clusters: the map appears, FSInfo follows the FAT on sync */
+    VfsNode *f = root->ops->create(root, "three.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    uint32_t len = 3 * vol->bytes_per_cluster;
+    uint8_t *data = calloc(1, len);
+    ASSERT_EQ(f->ops->write(f, data, 0, len), (int)len);
+    free(data);
+    ASSERT_TRUE(vol->free_map != NULL);
+    ASSERT_EQ(vol->free_count, free_before - 3);
+    ASSERT_EQ(disk_fsinfo_free(vol), free_before - 3);
+    uint32_t first = to_fat32(f)->first_cluster;
+    ASSERT_TRUE(fat32_map_used(vol, first));
+
+    /* Unlinking gives them back, in the map and on disk */
+    ASSERT_EQ(root->ops->unlink(root, "three.bin"), 0);
+    ASSERT_FALSE(fat32_map_used(vol, first));
+    ASSERT_EQ(disk_fsinfo_free(vol), free_before);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_alloc_starts_at_fsinfo_hint(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    Fat32Volume *vol = to_fat32(root)->vol;
+
+    /* Point the on-disk hint well past the used clusters and remount */
+    Fat32FsInfo fsi;
+    ASSERT_EQ(disk_blk_read(NULL, vol->fsinfo_sector, 1, &fsi), 0);
+    fsi.next_free = 5000;
+    ASSERT_EQ(disk_blk_write(NULL, vol->fsinfo_sector, 1, &fsi), 0);
+    root = fat32_mount(&test_blkdev);
+    ASSERT_TRUE(root != NULL);
+    vol = to_fat32(root)->vol;
+    ASSERT_EQ(vol->next_free, 5000);
+
+    VfsNode *f = root->ops->create(root, "hint.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    ASSERT_EQ(f->ops->write(f, "x", 0, 1), 1);
+    ASSERT_EQ(to_fat32(f)->first_cluster, 5000);
+    ASSERT_EQ(vol->next_free, 5001);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_interleaved_appends_stay_contiguous(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *a = root->ops->create(root, "a.log", VFS_FILE);
+    VfsNode *b = root->ops->create(root, "b.log", VFS_FILE);
+    ASSERT_TRUE(a != NULL && b != NULL);
+    Fat32Volume *vol = to_fat32(a)->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+
+    /* Appends to two files in turn: after the first cluster each runs on
+     * into its own reservation instead of interleaving with the other */
+    uint8_t *chunk = malloc(bpc);
+    for (uint32_t i = 0; i < 12; i++) {
+        fill_pattern(chunk, bpc, i * bpc, 1);
+        ASSERT_EQ(a->ops->write(a, chunk, i * bpc, bpc), (int)bpc);
+        fill_pattern(chunk, bpc, i * bpc, 2);
+        ASSERT_EQ(b->ops->write(b, chunk, i * bpc, bpc), (int)bpc);
+    }
+    free(chunk);
+    ASSERT_EQ(to_fat32(a)->extent_count, 2);
+    ASSERT_EQ(to_fat32(b)->extent_count, 2);
+    ASSERT_EQ(check_pattern(a, 5 * bpc - 3, 6, 1), 0);
+    ASSERT_EQ(check_pattern(b, 11 * bpc - 3, 6, 2), 0);
+
+    /* Reserved clusters are free on disk; truncate hands them back */
+    Fat32Prealloc *pa = fat32_prealloc_find(vol, to_fat32(a));
+    ASSERT_TRUE(pa != NULL && pa->count > 0);
+    uint32_t reserved = pa->start;
+    ASSERT_TRUE(fat32_map_used(vol, reserved));
+    ASSERT_EQ(fat32_fat_get(vol, reserved), FAT32_FREE);
+    a->ops->truncate(a, 0);
+    ASSERT_FALSE(fat32_map_used(vol, reserved));
+    ASSERT_TRUE(fat32_prealloc_find(vol, to_fat32(a)) == NULL);
+    unmount_test_disk();
+    return 0;
+}
+
+/* === Directory index tests === */
+
+static int test_dir_index_spans_clusters(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *dir = root->ops->create(root, "many", VFS_DIRECTORY);
+    ASSERT_TRUE(dir != NULL);
+    Fat32NodeInfo *dinfo = to_fat32(dir);
+    uint32_t epc = dinfo->vol->bytes_per_cluster / sizeof(Fat32DirEntry);
+
+    /* Enough names to grow the directory over several clusters */
+    char name[16];
+    uint32_t count = 6 * epc;
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "f%u.txt", i);
+        VfsNode *f = dir->ops->create(dir, name, VFS_FILE);
+        ASSERT_TRUE(f != NULL);
+    }
+    Fat32DirIndex *di = dinfo->dir_index;
+    ASSERT_TRUE(di != NULL);
+    ASSERT_EQ(di->used, count);
+    ASSERT_EQ(di->end, count + 2);          /* After "." and ".." */
+    ASSERT_EQ(di->cluster_count, count / epc + 1);
+    ASSERT_TRUE(dir->ops->create(dir, "f7.txt", VFS_FILE) == NULL);
+
+    /* Misses are answered by the index alone */
+    int reads = disk_reads;
+    ASSERT_TRUE(dir->ops->lookup(dir, "nothere.txt") == NULL);
+    ASSERT_EQ(dir->ops->unlink(dir, "nothere.txt"), -ENOENT);
+    ASSERT_EQ(disk_reads, reads);
+
+    /* A remount rebuilds the same index from disk */
+    bcache_invalidate(&test_blkdev);
+    root = fat32_mount(&test_blkdev);
+    dir = root->ops->lookup(root, "many");
+    ASSERT_TRUE(dir != NULL);
+    snprintf(name, sizeof(name), "f%u.txt", count - 1);
+    VfsNode *last = dir->ops->lookup(dir, name);
+    ASSERT_TRUE(last != NULL);
+    ASSERT_EQ(to_fat32(last)->dir_entry_idx, count + 1);
+    ASSERT_EQ(to_fat32(dir)->dir_index->used, count);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_dir_index_reuses_freed_slot(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *dir = root->ops->create(root, "reuse", VFS_DIRECTORY);
+    ASSERT_TRUE(dir != NULL);
+    VfsNode *a = dir->ops->create(dir, "a.txt", VFS_FILE);
+    VfsNode *b = dir->ops->create(dir, "b.txt", VFS_FILE);
+    ASSERT_TRUE(a != NULL && b != NULL);
+    uint32_t slot = to_fat32(a)->dir_entry_idx;
+    Fat32DirIndex *di = to_fat32(dir)->dir_index;
+    uint32_t end = di->end;
+
+    /* The deleted entry is handed to the next create */
+    ASSERT_EQ(dir->ops->unlink(dir, "a.txt"), 0);
+    ASSERT_TRUE(dir->ops->lookup(dir, "a.txt") == NULL);
+    ASSERT_EQ(di->free_count, 1);
+    VfsNode *c = dir->ops->create(dir, "c.txt", VFS_FILE);
+    ASSERT_TRUE(c != NULL);
+    ASSERT_EQ(to_fat32(c)->dir_entry_idx, slot);
+    ASSERT_EQ(di->end, end);
+
+    /* Size updates land in the reused entry */
+    ASSERT_EQ(c->ops->write(c, "hello", 0, 5), 5);
+    bcache_invalidate(&test_blkdev);
+    root = fat32_mount(&test_blkdev);
+    dir = root->ops->lookup(root, "reuse");
+    ASSERT_TRUE(dir != NULL);
+    c = dir->ops->lookup(dir, "c.txt");
+    ASSERT_TRUE(c != NULL);
+    ASSERT_EQ(c->size, 5);
+    ASSERT_TRUE(dir->ops->lookup(dir, "a.txt") == NULL);
+    ASSERT_TRUE(dir->ops->lookup(dir, "b.txt") != NULL);
+    unmount_test_disk();
+    return 0;
+}
+
+/* === Node cache tests === */
+
+static int test_node_cache_one_node_per_file(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+
+    /* An empty file has no cluster yet, but still only one node */
+    VfsNode *f = root->ops->create(root, "empty.txt", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    ASSERT_EQ(to_fat32(f)->first_cluster, 0);
+    ASSERT_TRUE(root->ops->lookup(root, "empty.txt") == f);
+    ASSERT_EQ(f->ops->write(f, "abc", 0, 3), 3);
+    ASSERT_TRUE(root->ops->lookup(root, "EMPTY.TXT") == f);
+    ASSERT_TRUE(to_fat32(root)->refs > 0);          /* Pinned by the mount */
+    ASSERT_EQ(fat32_sync(), 0);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_node_cache_evicts_unreferenced(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *dir = root->ops->create(root, "lots", VFS_DIRECTORY);
+    ASSERT_TRUE(dir != NULL);
+    Fat32Volume *vol = to_fat32(dir)->vol;
+    VfsNode *held = dir->ops->create(dir, "held.txt", VFS_FILE);
+    VfsNode *first = dir->ops->create(dir, "first.txt", VFS_FILE);
+    ASSERT_TRUE(held != NULL && first != NULL);
+    fat32_node_get(held);
+    uint64_t first_ino = first->inode_num;
+
+    /* More files than the cache holds: the oldest unreferenced go */
+    char name[16];
+    for (uint32_t i = 0; i < FAT32_NODE_CACHE + 40; i++) {
+        snprintf(name, sizeof(name), "n%u.txt", i);
+        ASSERT_TRUE(dir->ops->create(dir, name, VFS_FILE) != NULL);
+    }
+    ASSERT_EQ(vol->node_count, FAT32_NODE_CACHE);
+    ASSERT_TRUE(dir->ops->lookup(dir, "held.txt") == held);
+    VfsNode *again = dir->ops->lookup(dir, "first.txt");
+    ASSERT_TRUE(again != NULL);
+    ASSERT_EQ(again->inode_num, first_ino);         /* Stable across eviction */
+    ASSERT_EQ(vol->node_count, FAT32_NODE_CACHE);
+
+    /* readdir reports the same number without a lookup */
+    VfsDirEntry ents[4];
+    ASSERT_TRUE(dir->ops->readdir(dir, ents, 4) >= 2);
+    ASSERT_STR_EQ(ents[1].name, "first.txt");
+    ASSERT_EQ(ents[1].inode_num, first_ino);
+
+    /* Dropping the last reference leaves the node cached, now evictable */
+    fat32_node_put(held);
+    ASSERT_EQ(to_fat32(held)->refs, 0);
+    ASSERT_TRUE(vol->lru_head == to_fat32(held));
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_node_cache_unlink_open_file(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *f = root->ops->create(root, "open.txt", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    Fat32NodeInfo *info = to_fat32(f);
+    Fat32Volume *vol = info->vol;
+    fat32_node_get(f);
+    uint32_t count = vol->node_count;
+
+    /* Unlinked while open: out of the cache, alive until the last put */
+    ASSERT_EQ(root->ops->unlink(root, "open.txt"), 0);
+    ASSERT_FALSE(info->cached);
+    ASSERT_EQ(vol->node_count, count - 1);
+    ASSERT_TRUE(cache_lookup(vol, info->dir_entry_cluster, info->dir_entry_idx) == NULL);
+
+    /* Its slot goes to the next file, which gets a node of its own */
+    VfsNode *g = root->ops->create(root, "next.txt", VFS_FILE);
+    ASSERT_TRUE(g != NULL && g != f);
+    ASSERT_EQ(to_fat32(g)->dir_entry_idx, info->dir_entry_idx);
+    fat32_node_put(f);
+    ASSERT_TRUE(root->ops->lookup(root, "next.txt") == g);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_unlinked_open_file_keeps_its_clusters(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *a = root->ops->create(root, "gone.bin", VFS_FILE);
+    ASSERT_TRUE(a != NULL);
+    Fat32Volume *vol = to_fat32(a)->vol;
+    uint32_t bpc = vol->bytes_per_cluster;
+    uint8_t *buf = malloc(2 * bpc);
+    uint8_t *back = malloc(2 * bpc);
+    fill_pattern(buf, 2 * bpc, 0, 1);
+    ASSERT_EQ(a->ops->write(a, buf, 0, 2 * bpc), (int)(2 * bpc));
+    uint32_t first = to_fat32(a)->first_cluster;
+    uint32_t free_before = vol->free_count;
+    fat32_node_get(a);
+
+    /* Unlinked while open: its clusters stay allocated */
+    ASSERT_EQ(root->ops->unlink(root, "gone.bin"), 0);
+    ASSERT_TRUE(fat32_map_used(vol, first));
+    ASSERT_EQ(vol->free_count, free_before);
+
+    /* A new file takes other clusters; writing through the old fd
+     * leaves its data alone */
+    VfsNode *b = root->ops->create(root, "kept.bin", VFS_FILE);
+    ASSERT_TRUE(b != NULL);
+    fill_pattern(buf, 2 * bpc, 0, 2);
+    ASSERT_EQ(b->ops->write(b, buf, 0, 2 * bpc), (int)(2 * bpc));
+    ASSERT_TRUE(to_fat32(b)->first_cluster != first);
+    uint8_t *junk = malloc(3 * bpc);
+    memset(junk, 0xEE, 3 * bpc);
+    ASSERT_EQ(a->ops->write(a, junk, 0, 3 * bpc), (int)(3 * bpc));
+    ASSERT_EQ(a->ops->read(a, back, bpc, bpc), (int)bpc);
+    ASSERT_MEM_EQ(back, junk, bpc);
+    ASSERT_EQ(b->ops->read(b, back, 0, 2 * bpc), (int)(2 * bpc));
+    ASSERT_MEM_EQ(back, buf, 2 * bpc);
+
+    /* The last put gives them back */
+    uint32_t free_open = vol->free_count;
+    fat32_node_put(a);
+    ASSERT_FALSE(fat32_map_used(vol, first));
+    ASSERT_EQ(vol->free_count, free_open + 3);
+    ASSERT_EQ(b->ops->read(b, back, 0, 2 * bpc), (int)(2 * bpc));
+    ASSERT_MEM_EQ(back, buf, 2 * bpc);
+    free(junk);
+    free(back);
+    free(buf);
+    unmount_test_disk();
+    return 0;
+}
+
+/* === Readahead tests === */
+
+static int test_sequential_reads_prefetched(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *f = root->ops->create(root, "stream.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    uint32_t bpc = to_fat32(f)->vol->bytes_per_cluster;
+    uint32_t len = 64 * bpc;
+    uint8_t *data = malloc(len);
+    uint8_t *back = malloc(len);
+    fill_pattern(data, len, 0, 7);
+    ASSERT_EQ(f->ops->write(f, data, 0, len), (int)len);
+    ASSERT_EQ(fat32_sync(), 0);
+    bcache_invalidate(&test_blkdev);
+
+    /* Cluster-sized reads: the growing window brings them in a run at
+     * a time instead of one request each */
+    VfsFile file = { .node = f, .flags = O_RDONLY };
+    int reads = disk_reads;
+    for (uint32_t off = 0; off < len; off += bpc) {
+        ASSERT_EQ(vfs_read(&file, back + off, bpc), (int)bpc);
+    }
+    ASSERT_MEM_EQ(back, data, len);
+    ASSERT_TRUE(disk_reads - reads < 8);
+    ASSERT_EQ(file.ra.misses, 1);
+    ASSERT_EQ(file.ra.hits, 63);
+    ASSERT_EQ(file.ra.bytes, len - bpc);
+    free(data);
+    free(back);
+    unmount_test_disk();
+    return 0;
+}
+
+static int test_readahead_fills_bcache(void) {
+    VfsNode *root = mount_writable_copy();
+    ASSERT_TRUE(root != NULL);
+    VfsNode *f = root->ops->create(root, "ahead.bin", VFS_FILE);
+    ASSERT_TRUE(f != NULL);
+    uint32_t bpc = to_fat32(f)->vol->bytes_per_cluster;
+    uint32_t len = 8 * bpc;
+    uint8_t *data = malloc(len);
+    uint8_t *back = malloc(len);
+    fill_pattern(data, len, 0, 11);
+    ASSERT_EQ(f->ops->write(f, data, 0, len), (int)len);
+    ASSERT_EQ(fat32_sync(), 0);
+    bcache_invalidate(&test_blkdev);
+
+    /* The window past the first cluster is read by the prefetch... */
+    ASSERT_EQ(f->ops->read(f, back, 0, bpc), (int)bpc);
+    f->ops->readahead(f, bpc, len - bpc);
+    BcacheStats before, after;
+    bcache_get_stats(&test_blkdev, &before);
+    int reads = disk_reads;
+
+    /* ...so reading it sequentially is all cache hits, no device I/O */
+    for (uint32_t off = bpc; off < len; off += bpc) {
+        ASSERT_EQ(f->ops->read(f, back + off, off, bpc), (int)bpc);
+    }
+    bcache_get_stats(&test_blkdev, &after);
+    ASSERT_MEM_EQ(back, data, len);
+    ASSERT_EQ(disk_reads, reads);
+    ASSERT_EQ(after.misses, before.misses);
+    ASSERT_TRUE(after.hits - before.hits >= 7);
+    free(data);
+    free(back);
+    unmount_test_disk();
+    return 0;
+}
+
 /* --- Test suite export --- */
 
 TestCase fat32_tests[] = {
     { "bpb_parse_valid",         test_bpb_parse_valid },
     { "bpb_reject_bad_sector_size", test_bpb_reject_bad_sector_size },
     { "fat_table_loaded",        test_fat_table_loaded },
+    { "fat_paged_on_demand",     test_fat_paged_on_demand },
+    { "fat_sync_writes_dirty_sectors", test_fat_sync_writes_dirty_sectors },
+    { "fat_page_eviction_keeps_changes", test_fat_page_eviction_keeps_changes },
     { "root_readdir",            test_root_readdir },
     { "lookup_file",             test_lookup_file },
     { "lookup_dir",              test_lookup_dir },
@@ -460,6 +1153,23 @@ TestCase fat32_tests[] = {
     { "create_directory",        test_create_directory },
     { "unlink_file",             test_unlink_fat32_file },
     { "truncate_to_zero",        test_truncate_to_zero },
+    { "truncate_defers_sync",    test_truncate_defers_sync },
+    { "repeated_read_hits_cache", test_repeated_read_hits_cache },
+    { "write_survives_remount",  test_write_survives_remount },
+    { "extent_map_fragmented",   test_extent_map_fragmented },
+    { "extent_map_truncate_rebuilds", test_extent_map_truncate_rebuilds },
+    { "contiguous_io_coalesced", test_contiguous_io_coalesced },
+    { "free_map_built_on_first_allocation", test_free_map_built_on_first_allocation },
+    { "alloc_starts_at_fsinfo_hint", test_alloc_starts_at_fsinfo_hint },
+    { "interleaved_appends_stay_contiguous", test_interleaved_appends_stay_contiguous },
+    { "dir_index_spans_clusters", test_dir_index_spans_clusters },
+    { "dir_index_reuses_freed_slot", test_dir_index_reuses_freed_slot },
+    { "node_cache_one_node_per_file", test_node_cache_one_node_per_file },
+    { "node_cache_evicts_unreferenced", test_node_cache_evicts_unreferenced },
+    { "node_cache_unlink_open_file", test_node_cache_unlink_open_file },
+    { "unlinked_open_file_keeps_clusters", test_unlinked_open_file_keeps_its_clusters },
+    { "sequential_reads_prefetched", test_sequential_reads_prefetched },
+    { "readahead_fills_bcache",  test_readahead_fills_bcache },
 };
 
 int fat32_test_count = sizeof(fat32_tests) / sizeof(fat32_tests[0]);
@@ -0,0 +1,194 @@
+/* arc_os — Host-side tests for kernel/fs/flusher.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_FS_BCACHE_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_WAITQUEUE_H
+#define ARCHOS_PROC_WORKQUEUE_H
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_ARCH_X86_64_PIT_H
+#define ARCHOS_LIB_KPRINTF_H
+
+static inline void kprintf(const char *fmt, ...) { (void)fmt; }
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+static inline uint64_t spin_irq_save(void) { return 0; }
+static inline void spin_irq_restore(uint64_t flags) { (void)flags; }
+
+/* Minimal Thread and scheduler */
+typedef void (*thread_entry_t)(void *arg);
+typedef struct Thread {
+    thread_entry_t entry;
+    void          *arg;
+} Thread;
+
+static Thread test_thread;
+static int thread_fail;
+static int sched_add_count;
+
+static Thread *thread_create(thread_entry_t entry, void *arg) {
+    if (thread_fail) return NULL;
+    test_thread.entry = entry;
+    test_thread.arg = arg;
+    return &test_thread;
+}
+static void sched_add_thread(Thread *t) { (void)t; sched_add_count++; }
+
+/* WaitQueue stub: counts wakeups */
+typedef struct { int unused; } WaitQueue;
+#define WAITQUEUE_INIT { 0 }
+
+static int wq_wake_count;
+static void wq_wake(WaitQueue *wq) { (void)wq; wq_wake_count++; }
+static void wq_sleep(WaitQueue *wq, Spinlock *lock) { (void)wq; spinlock_release(lock); }
+
+/* Workqueue stub: records the last delayed item */
+struct Work;
+typedef void (*work_func_t)(struct Work *work);
+typedef struct Work { work_func_t func; } Work;
+#define WORK_INIT(fn) { .func = (fn) }
+
+static Work *delayed_work;
+static uint64_t delayed_ms;
+static int queue_delayed_work(Work *work, uint64_t delay_ms) {
+    delayed_work = work;
+    delayed_ms = delay_ms;
+    return 1;
+}
+
+static uint64_t pit_get_uptime_ms(void) { return 0; }
+
+/* PMM stub */
+static uint64_t free_pages;
+static uint64_t pmm_get_free_pages(void) { return free_pages; }
+
+/* Buffer cache stub: records which write-back the flusher chose */
+#define BCACHE_MAX_BUFFERS     256
+#define BCACHE_MIN_FREE_PAGES  256
+#define BCACHE_DIRTY_HIGH      (BCACHE_MAX_BUFFERS / 2)
+
+static uint32_t dirty_buffers;
+static int flush_all_calls;
+static int flush_result;
+
+#define EIO 5
+static uint64_t aged_now, aged_age;
+static int aged_calls;
+
+static void bcache_get_usage(uint32_t *count, uint64_t *bytes, uint32_t *dirty) {
+    *count = BCACHE_MAX_BUFFERS;
+    *bytes = 0;
+    *dirty = dirty_buffers;
+}
+static int bcache_flush(void *dev) {
+    (void)dev;
+    flush_all_calls++;
+    return flush_result;
+}
+static int bcache_flush_aged(uint64_t now_ms, uint64_t age_ms) {
+    aged_calls++;
+    aged_now = now_ms;
+    aged_age = age_ms;
+    return flush_result != 0 ? flush_result : 3;
+}
+
+#include "../kernel/fs/flusher.c"
+
+static void reset_flusher(void) {
+    free_pages = 1 << 20;
+    dirty_buffers = 0;
+    flush_all_calls = aged_calls = 0;
+    flush_result = 0;
+    aged_now = aged_age = 0;
+    flusher_wanted = 0;
+    wq_wake_count = 0;
+    sched_add_count = 0;
+    thread_fail = 0;
+    delayed_work = NULL;
+    delayed_ms = 0;
+}
+
+/* --- Tests --- */
+
+TEST(clean_cache_does_nothing) {
+    reset_flusher();
+    ASSERT_EQ(flusher_run(10000), 0);
+    ASSERT_EQ(flush_all_calls, 0);
+    ASSERT_EQ(aged_calls, 0);
+    return 0;
+}
+
+TEST(writes_back_aged_buffers) {
+    reset_flusher();
+    dirty_buffers = 10;
+    ASSERT_EQ(flusher_run(12345), 3);
+    ASSERT_EQ(aged_calls, 1);
+    ASSERT_EQ(aged_now, 12345);
+    ASSERT_EQ(aged_age, FLUSHER_DIRTY_AGE_MS);
+    ASSERT_EQ(flush_all_calls, 0);
+    return 0;
+}
+
+TEST(pressure_flushes_everything) {
+    reset_flusher();
+    dirty_buffers = BCACHE_DIRTY_HIGH + 1;
+    ASSERT_EQ(flusher_run(0), BCACHE_DIRTY_HIGH + 1);
+    ASSERT_EQ(flush_all_calls, 1);
+    ASSERT_EQ(aged_calls, 0);
+
+    dirty_buffers = 4;
+    free_pages = BCACHE_MIN_FREE_PAGES - 1;
+    ASSERT_EQ(flusher_run(0), 4);
+    ASSERT_EQ(flush_all_calls, 2);
+
+    flush_result = -EIO;
+    ASSERT_EQ(flusher_run(0), -EIO);
+    return 0;
+}
+
+TEST(timer_kicks_and_rearms) {
+    reset_flusher();
+    flusher_init();
+    ASSERT_EQ(sched_add_count, 1);
+    ASSERT_TRUE(test_thread.entry == flusher_main);
+    ASSERT_TRUE(delayed_work == &flusher_timer);
+    ASSERT_EQ(delayed_ms, FLUSHER_INTERVAL_MS);
+
+    delayed_work = NULL;
+    flusher_timer.func(&flusher_timer);
+    ASSERT_EQ(flusher_wanted, 1);
+    ASSERT_EQ(wq_wake_count, 1);
+    ASSERT_TRUE(delayed_work == &flusher_timer);
+
+    /* No thread, no timer */
+    reset_flusher();
+    thread_fail = 1;
+    flusher_init();
+    ASSERT_EQ(sched_add_count, 0);
+    ASSERT_TRUE(delayed_work == NULL);
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase flusher_tests[] = {
+    TEST_ENTRY(clean_cache_does_nothing),
+    TEST_ENTRY(writes_back_aged_buffers),
+    TEST_ENTRY(pressure_flushes_everything),
+    TEST_ENTRY(timer_kicks_and_rearms),
+};
+int flusher_test_count = sizeof(flusher_tests) / sizeof(flusher_tests[0]);
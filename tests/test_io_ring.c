@@ -0,0 +1,581 @@
+/* arc_os — Host-side tests for kernel/proc/io_ring.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_WAITQUEUE_H
+#define ARCHOS_PROC_WORKQUEUE_H
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_PROCESS_H
+#define ARCHOS_PROC_FD_H
+#define ARCHOS_ARCH_X86_64_SYSCALL_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_VMM_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_FS_VFS_H
+#define ARCHOS_LIB_MEM_H
+
+#define EIO        5
+#define EBADF      9
+#define EAGAIN    11
+#define ENOMEM    12
+#define EBUSY     16
+#define EEXIST    17
+#define EINVAL    22
+#define ETIME     62
+#define ECANCELED 125
+
+#define PAGE_SIZE 4096
+#define VMM_FLAG_WRITABLE (1 << 0)
+#define VMM_FLAG_USER     (1 << 1)
+#define VMM_FLAG_NOEXEC   (1 << 2)
+#define GFP_ZERO 0x01
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+static inline uint64_t spin_irq_save(void) { return 0; }
+static inline void spin_irq_restore(uint64_t flags) { (void)flags; }
+
+/* WaitQueue stub; wq_sleep is defined after the ring types */
+typedef struct WaitQueue { int dummy; } WaitQueue;
+static int wq_wake_count;
+static void wq_init(WaitQueue *wq) { (void)wq; }
+static int wq_wake(WaitQueue *wq) { (void)wq; wq_wake_count++; return 0; }
+static int wq_wake_all(WaitQueue *wq) { (void)wq; return 0; }
+static void wq_sleep(WaitQueue *wq, Spinlock *lock);
+
+/* Workqueue stub: delayed work is recorded, the test fires it */
+typedef struct Work Work;
+typedef void (*work_func_t)(Work *work);
+struct Work {
+    work_func_t func;
+    uint64_t    delay;
+};
+static Work *armed_work;
+static void work_init(Work *work, work_func_t func) { work->func = func; work->delay = 0; }
+static int queue_delayed_work(Work *work, uint64_t delay_ms) {
+    work->delay = delay_ms;
+    armed_work = work;
+    return 1;
+}
+
+/* Thread stubs */
+typedef void (*thread_entry_t)(void *arg);
+typedef struct Thread {
+    uint32_t       tid;
+    thread_entry_t entry;
+    void          *arg;
+    uint8_t        policy;
+    uint8_t        rt_priority;
+} Thread;
+
+static Thread test_threads[4];
+static int thread_count;
+static int thread_destroy_count;
+static int sched_add_count;
+static int attach_fail;
+
+static Thread *thread_create(thread_entry_t entry, void *arg) {
+    if (thread_count >= 4) return NULL;
+    Thread *t = &test_threads[thread_count];
+    t->tid = (uint32_t)(10 + thread_count++);
+    t->entry = entry;
+    t->arg = arg;
+    return t;
+}
+static void thread_destroy(Thread *t) { (void)t; thread_destroy_count++; }
+static void sched_add_thread(Thread *t) { (void)t; sched_add_count++; }
+static void sched_fork(Thread *child, const Thread *parent) {
+    child->policy = parent->policy;
+    child->rt_priority = parent->rt_priority;
+}
+static int sched_setscheduler(Thread *t, int policy, int priority) {
+    t->policy = (uint8_t)policy;
+    t->rt_priority = (uint8_t)priority;
+    return 0;
+}
+/* The thread a test runs a worker's entry on */
+static Thread *test_current_thread;
+static Thread *thread_current(void) { return test_current_thread; }
+
+/* Minimal VFS and fd table */
+#define VFS_FILE 0
+#define VFS_PIPE 2
+
+typedef struct {
+    uint8_t type;
+} VfsNode;
+
+typedef struct {
+    VfsNode  *node;
+    uint64_t  offset;
+    uint32_t  flags;
+} VfsFile;
+
+typedef struct FdTable {
+    VfsFile files[4];
+    uint8_t in_use[4];
+} FdTable;
+
+static VfsFile *fd_get(FdTable *table, int fd) {
+    if (fd < 0 || fd >= 4 || !table->in_use[fd]) return NULL;
+    return &table->files[fd];
+}
+
+/* Node references: every node counts in node_refs */
+static int node_refs;
+static void fd_file_addref(VfsFile *file) { if (file->node) node_refs++; }
+static void fd_file_release(VfsFile *file) { if (file->node) node_refs--; }
+
+/* vfs_fsync stub: counts calls, returns fsync_result */
+static int fsync_calls;
+static int fsync_result;
+static int vfs_fsync(VfsFile *file) {
+    (void)file;
+    fsync_calls++;
+    return fsync_result;
+}
+
+/* Process stub */
+typedef struct Process {
+    Thread         *main_thread;
+    uint64_t        page_table;
+    FdTable        *fd_table;
+    struct IoRing  *io_ring;
+} Process;
+
+static Process test_proc;
+static Thread test_main_thread;
+static Process *proc_current(void) { return &test_proc; }
+static int proc_attach_thread(Process *p, Thread *t) {
+    (void)p; (void)t;
+    return attach_fail ? -EAGAIN : 0;
+}
+
+/* syscall_dispatch stub: records the call */
+#define SYS_WRITE   1
+#define SYS_READ    4
+#define SYS_ACCEPT 38
+#define SYS_SEND   40
+#define SYS_RECV   41
+
+static const char file_data[] = "0123456789abcdef";
+static FdTable test_fds;
+static uint64_t last_syscall = (uint64_t)-1;
+static int dispatch_node_refs;
+
+/* Reads copy from file_data at the fd's position, as vfs_read would;
+ * everything else returns the byte count */
+static int64_t syscall_dispatch(uint64_t num, uint64_t a0, uint64_t a1, uint64_t a2,
+                                uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    last_syscall = num;
+    dispatch_node_refs = node_refs;
+    VfsFile *f = fd_get(&test_fds, (int)a0);
+    if (num == SYS_READ && f != NULL) {
+        uint64_t avail = sizeof(file_data) - 1 - f->offset;
+        if (a2 > avail) a2 = avail;
+        memcpy((void *)a1, file_data + f->offset, a2);
+        f->offset += a2;
+    }
+    return (int64_t)a2;
+}
+
+/* PMM/VMM/kmalloc stubs: "physical" pages are host memory, HHDM offset 0 */
+static void *ring_pages;
+static int map_count;
+static int kfree_count;
+
+static uint64_t pmm_alloc_contiguous(size_t count) {
+    ring_pages = aligned_alloc(PAGE_SIZE, count * PAGE_SIZE);
+    return (uint64_t)ring_pages;
+}
+static void pmm_free_page(uint64_t phys) { (void)phys; }
+static uint64_t vmm_get_hhdm_offset(void) { return 0; }
+static uint64_t vmm_get_phys_in(uint64_t pml4, uint64_t virt) {
+    (void)pml4; (void)virt;
+    return 0;
+}
+static void vmm_map_page_in(uint64_t pml4, uint64_t virt, uint64_t phys, uint32_t flags) {
+    (void)pml4; (void)virt; (void)phys; (void)flags;
+    map_count++;
+}
+static void *kmalloc(size_t size, uint32_t flags) { (void)flags; return calloc(1, size); }
+static void kfree(void *ptr) { if (ptr) kfree_count++; free(ptr); }
+
+#include "../kernel/proc/io_ring.c"
+
+/* wq_sleep: a sleeping worker means the queue is drained, so stop it; a
+ * sleeping enter fires the armed timeout, standing in for the timer. */
+static void wq_sleep(WaitQueue *wq, Spinlock *lock) {
+    spinlock_release(lock);
+    IoRing *ring = test_proc.io_ring;
+    if (ring != NULL && wq == &ring->async_wq) {
+        ring->dead = 1;
+    } else if (armed_work != NULL) {
+        Work *w = armed_work;
+        armed_work = NULL;
+        w->func(w);
+    }
+}
+
+/* --- Helpers --- */
+
+static VfsNode file_node = { .type = VFS_FILE };
+static VfsNode pipe_node = { .type = VFS_PIPE };
+static char user_buf[32];
+
+static IoRing *reset_ring(uint32_t entries) {
+    if (test_proc.io_ring) {
+        free(test_proc.io_ring->reqs);
+        free(test_proc.io_ring);
+    }
+    free(ring_pages);
+    ring_pages = NULL;
+    memset(&test_proc, 0, sizeof(test_proc));
+    memset(&test_fds, 0, sizeof(test_fds));
+    memset(test_threads, 0, sizeof(test_threads));
+    memset(user_buf, 0, sizeof(user_buf));
+    test_proc.main_thread = &test_main_thread;
+    test_proc.page_table = 0x1000;
+    memset(&test_main_thread, 0, sizeof(test_main_thread));
+    test_current_thread = NULL;
+    test_proc.fd_table = &test_fds;
+    thread_count = 0;
+    thread_destroy_count = 0;
+    sched_add_count = 0;
+    attach_fail = 0;
+    wq_wake_count = 0;
+    armed_work = NULL;
+    last_syscall = (uint64_t)-1;
+    node_refs = 0;
+    dispatch_node_refs = 0;
+    map_count = 0;
+    kfree_count = 0;
+
+    if (entries == 0) return NULL;
+    if (io_ring_setup(entries) != (int64_t)IO_RING_USER_BASE) return NULL;
+    return test_proc.io_ring;
+}
+
+static void open_fd(int fd, VfsNode *node) {
+    test_fds.in_use[fd] = 1;
+    test_fds.files[fd].node = node;
+    test_fds.files[fd].offset = 0;
+}
+
+/* Queue an SQE the way user space would */
+static IoSqe *push_sqe(IoRing *ring, uint8_t op, int32_t fd, uint64_t user_data) {
+    IoRingHeader *h = ring->hdr;
+    IoSqe *sqe = &ring->sqes[h->sq_tail & h->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    h->sq_tail++;
+    return sqe;
+}
+
+/* Pop a CQE the way user space would; NULL if none */
+static IoCqe *pop_cqe(IoRing *ring) {
+    IoRingHeader *h = ring->hdr;
+    if (h->cq_head == h->cq_tail) return NULL;
+    return &ring->cqes[h->cq_head++ & h->cq_mask];
+}
+
+/* --- Tests --- */
+
+static int test_setup_layout(void) {
+    IoRing *ring = reset_ring(5);
+    ASSERT_TRUE(ring != NULL);
+    IoRingHeader *h = ring->hdr;
+    ASSERT_EQ(h->sq_entries, 8);
+    ASSERT_EQ(h->cq_entries, 16);
+    ASSERT_EQ(h->sq_mask, 7);
+    ASSERT_EQ(h->cq_off, h->sq_off + 8 * sizeof(IoSqe));
+    ASSERT_EQ(h->sq_off % 64, 0);
+    ASSERT_EQ(map_count, (int)ring->nr_pages);
+    ASSERT_EQ(ring->refs, 1);
+
+    ASSERT_EQ(io_ring_setup(4), -EEXIST);
+    return 0;
+}
+
+static int test_setup_rejects_bad_sizes(void) {
+    reset_ring(0);
+    ASSERT_EQ(io_ring_setup(0), -EINVAL);
+    ASSERT_EQ(io_ring_setup(IO_RING_MAX_ENTRIES + 1), -EINVAL);
+    ASSERT_TRUE(test_proc.io_ring == NULL);
+    return 0;
+}
+
+static int test_batch_completes_inline(void) {
+    IoRing *ring = reset_ring(4);
+    push_sqe(ring, IO_OP_NOP, -1, 1);
+    push_sqe(ring, IO_OP_NOP, -1, 2);
+    push_sqe(ring, 99, -1, 3);
+    ASSERT_EQ(io_ring_enter(3, 0), 3);
+    ASSERT_EQ(ring->hdr->sq_head, 3);
+
+    IoCqe *c = pop_cqe(ring);
+    ASSERT_EQ(c->user_data, 1);
+    ASSERT_EQ(c->res, 0);
+    ASSERT_EQ(pop_cqe(ring)->user_data, 2);
+    c = pop_cqe(ring);
+    ASSERT_EQ(c->user_data, 3);
+    ASSERT_EQ(c->res, -EINVAL);
+    ASSERT_TRUE(pop_cqe(ring) == NULL);
+    return 0;
+}
+
+static int test_file_read_positional(void) {
+    IoRing *ring = reset_ring(4);
+    open_fd(3, &file_node);
+    test_fds.files[3].offset = 2;
+
+    IoSqe *sqe = push_sqe(ring, IO_OP_READ, 3, 7);
+    sqe->addr = (uint64_t)user_buf;
+    sqe->len = 4;
+    sqe->off = 10;
+    ASSERT_EQ(io_ring_enter(1, 0), 1);
+
+    IoCqe *c = pop_cqe(ring);
+    ASSERT_EQ(c->res, 4);
+    ASSERT_TRUE(memcmp(user_buf, "abcd", 4) == 0);
+    ASSERT_EQ(test_fds.files[3].offset, 2);   /* File position untouched */
+    ASSERT_EQ(thread_count, 0);               /* No worker needed */
+    return 0;
+}
+
+static int test_file_read_current_advances(void) {
+    IoRing *ring = reset_ring(4);
+    open_fd(3, &file_node);
+
+    IoSqe *sqe = push_sqe(ring, IO_OP_READ, 3, 7);
+    sqe->addr = (uint64_t)user_buf;
+    sqe->len = 3;
+    sqe->off = IO_OFF_CURRENT;
+    io_ring_enter(1, 0);
+    ASSERT_EQ(pop_cqe(ring)->res, 3);
+    ASSERT_EQ(test_fds.files[3].offset, 3);
+    return 0;
+}
+
+static int test_fsync_checks_fd(void) {
+    IoRing *ring = reset_ring(4);
+    open_fd(3, &file_node);
+    open_fd(2, &pipe_node);
+    push_sqe(ring, IO_OP_FSYNC, 3, 1);
+    push_sqe(ring, IO_OP_FSYNC, 2, 2);
+    push_sqe(ring, IO_OP_FSYNC, 1, 3);
+    fsync_calls = 0;
+    io_ring_enter(3, 0);
+    ASSERT_EQ(pop_cqe(ring)->res, 0);
+    ASSERT_EQ(pop_cqe(ring)->res, -EINVAL);
+    ASSERT_EQ(pop_cqe(ring)->res, -EBADF);
+    ASSERT_EQ(fsync_calls, 1);              /* Only the regular file */
+
+    /* A write-back failure is the request's result */
+    fsync_result = -EIO;
+    push_sqe(ring, IO_OP_FSYNC, 3, 4);
+    io_ring_enter(1, 0);
+    ASSERT_EQ(pop_cqe(ring)->res, -EIO);
+    fsync_result = 0;
+    return 0;
+}
+
+static int test_socket_op_runs_on_worker(void) {
+    IoRing *ring = reset_ring(4);
+    IoSqe *sqe = push_sqe(ring, IO_OP_RECV, 5, 9);
+    sqe->addr = (uint64_t)user_buf;
+    sqe->len = 12;
+    ASSERT_EQ(io_ring_enter(1, 0), 1);
+
+    /* Queued for a new worker; nothing completed yet */
+    ASSERT_EQ(thread_count, 1);
+    ASSERT_EQ(sched_add_count, 1);
+    ASSERT_EQ(ring->nr_workers, 1);
+    ASSERT_EQ(ring->inflight, 1);
+    ASSERT_EQ(ring->refs, 3);                 /* Owner, worker, request */
+    ASSERT_TRUE(pop_cqe(ring) == NULL);
+    ASSERT_TRUE(ring->workers[0] == &test_threads[0]);
+
+    test_current_thread = &test_threads[0];
+    test_threads[0].entry(test_threads[0].arg);
+    ASSERT_TRUE(ring->workers[0] == NULL);
+    ASSERT_EQ(last_syscall, SYS_RECV);
+    IoCqe *c = pop_cqe(ring);
+    ASSERT_EQ(c->user_data, 9);
+    ASSERT_EQ(c->res, 12);
+    ASSERT_EQ(ring->inflight, 0);
+    ASSERT_EQ(ring->nr_workers, 0);
+    ASSERT_EQ(ring->refs, 1);
+    return 0;
+}
+
+static int test_workers_follow_owner_policy(void) {
+    IoRing *ring = reset_ring(4);
+    test_main_thread.policy = 1;             /* SCHED_FIFO */
+    test_main_thread.rt_priority = 40;
+    push_sqe(ring, IO_OP_RECV, 5, 1)->addr = (uint64_t)user_buf;
+    io_ring_enter(1, 0);
+
+    /* A new worker starts in the owner's class... */
+    Thread *w = ring->workers[0];
+    ASSERT_TRUE(w == &test_threads[0]);
+    ASSERT_EQ(w->policy, 1);
+    ASSERT_EQ(w->rt_priority, 40);
+
+    /* ...and follows it when the process's policy changes */
+    io_ring_setscheduler(&test_proc, 2, 60);
+    ASSERT_EQ(w->policy, 2);
+    ASSERT_EQ(w->rt_priority, 60);
+    return 0;
+}
+
+static int test_exit_keeps_blocked_read_node(void) {
+    IoRing *ring = reset_ring(4);
+    open_fd(3, &pipe_node);
+    node_refs = 1;                            /* The fd's reference */
+    IoSqe *sqe = push_sqe(ring, IO_OP_READ, 3, 8);
+    sqe->addr = (uint64_t)user_buf;
+    sqe->len = 4;
+    ASSERT_EQ(io_ring_enter(1, 0), 1);
+    ASSERT_EQ(node_refs, 2);                  /* Pinned by the request */
+
+    /* The worker picks it up; then the owner exits under it */
+    IoReq *req = ring->async_head;
+    ring->async_head = ring->async_tail = NULL;
+    io_ring_release(&test_proc, 0);
+    test_fds.in_use[3] = 0;
+    fd_file_release(&test_fds.files[3]);
+    ASSERT_EQ(node_refs, 1);                  /* The pipe is still alive */
+
+    /* The read finishes against a live node, then lets it go */
+    io_req_complete(req, io_exec(&req->sqe));
+    ASSERT_EQ(dispatch_node_refs, 1);
+    ASSERT_EQ(node_refs, 0);
+    return 0;
+}
+
+static int test_no_worker_runs_inline(void) {
+    IoRing *ring = reset_ring(4);
+    attach_fail = 1;
+    open_fd(3, &pipe_node);
+    IoSqe *sqe = push_sqe(ring, IO_OP_WRITE, 3, 4);
+    sqe->addr = (uint64_t)user_buf;
+    sqe->len = 6;
+    io_ring_enter(1, 0);
+
+    ASSERT_EQ(thread_destroy_count, 1);
+    ASSERT_EQ(last_syscall, SYS_WRITE);
+    ASSERT_EQ(pop_cqe(ring)->res, 6);
+    ASSERT_EQ(ring->inflight, 0);
+    return 0;
+}
+
+static int test_timeout_waits_for_completion(void) {
+    IoRing *ring = reset_ring(4);
+    IoSqe *sqe = push_sqe(ring, IO_OP_TIMEOUT, -1, 77);
+    sqe->off = 250;
+
+    /* min_complete=1 sleeps until the timer fires */
+    ASSERT_EQ(io_ring_enter(1, 1), 1);
+    ASSERT_TRUE(armed_work == NULL);
+    IoCqe *c = pop_cqe(ring);
+    ASSERT_EQ(c->user_data, 77);
+    ASSERT_EQ(c->res, -ETIME);
+    ASSERT_EQ(ring->refs, 1);
+    return 0;
+}
+
+static int test_requests_exhausted_leaves_sqe(void) {
+    IoRing *ring = reset_ring(1);   /* SQ 1, CQ 2: two request slots */
+    push_sqe(ring, IO_OP_TIMEOUT, -1, 1)->off = 10;
+    ASSERT_EQ(io_ring_enter(1, 0), 1);
+    push_sqe(ring, IO_OP_TIMEOUT, -1, 2)->off = 10;
+    ASSERT_EQ(io_ring_enter(1, 0), 1);
+    push_sqe(ring, IO_OP_TIMEOUT, -1, 3)->off = 10;
+    ASSERT_EQ(io_ring_enter(1, 0), -EBUSY);
+    ASSERT_EQ(ring->hdr->sq_head, 2);
+    ASSERT_EQ(ring->inflight, 2);
+    return 0;
+}
+
+static int test_cq_overflow_counted(void) {
+    IoRing *ring = reset_ring(1);
+    for (int i = 0; i < 3; i++) {
+        push_sqe(ring, IO_OP_NOP, -1, (uint64_t)i);
+        ASSERT_EQ(io_ring_enter(1, 0), 1);
+    }
+    ASSERT_EQ(ring->hdr->cq_tail, 2);
+    ASSERT_EQ(ring->hdr->cq_overflow, 1);
+    return 0;
+}
+
+static int test_enter_clamps_to_queued(void) {
+    IoRing *ring = reset_ring(4);
+    push_sqe(ring, IO_OP_NOP, -1, 1);
+    ASSERT_EQ(io_ring_enter(50, 0), 1);
+
+    /* A bogus tail from user space is clamped to one ring's worth */
+    ring->hdr->sq_tail += 1000;
+    ASSERT_EQ(io_ring_enter(1000, 0), 4);
+    return 0;
+}
+
+static int test_release_busy_and_drop(void) {
+    IoRing *ring = reset_ring(4);
+    push_sqe(ring, IO_OP_TIMEOUT, -1, 5)->off = 100;
+    io_ring_enter(1, 0);
+
+    ASSERT_EQ(io_ring_release(&test_proc, 1), -EBUSY);
+    ASSERT_TRUE(test_proc.io_ring == ring);
+
+    ASSERT_EQ(io_ring_release(&test_proc, 0), 0);
+    ASSERT_TRUE(test_proc.io_ring == NULL);
+    ASSERT_EQ(kfree_count, 0);               /* Request still holds it */
+
+    /* Late completion is dropped and frees the ring */
+    uint32_t tail = ring->hdr->cq_tail;
+    IoRingHeader *h = ring->hdr;
+    armed_work->func(armed_work);
+    ASSERT_EQ(h->cq_tail, tail);
+    ASSERT_EQ(kfree_count, 2);
+    return 0;
+}
+
+/* --- Test suite export --- */
+
+TestCase io_ring_tests[] = {
+    { "setup_layout",               test_setup_layout },
+    { "setup_rejects_bad_sizes",    test_setup_rejects_bad_sizes },
+    { "batch_completes_inline",     test_batch_completes_inline },
+    { "file_read_positional",       test_file_read_positional },
+    { "file_read_current_advances", test_file_read_current_advances },
+    { "fsync_checks_fd",            test_fsync_checks_fd },
+    { "socket_op_runs_on_worker",   test_socket_op_runs_on_worker },
+    { "workers_follow_owner_policy", test_workers_follow_owner_policy },
+    { "exit_keeps_blocked_read_node", test_exit_keeps_blocked_read_node },
+    { "no_worker_runs_inline",      test_no_worker_runs_inline },
+    { "timeout_waits_completion",   test_timeout_waits_for_completion },
+    { "requests_exhausted",         test_requests_exhausted_leaves_sqe },
+    { "cq_overflow_counted",        test_cq_overflow_counted },
+    { "enter_clamps_to_queued",     test_enter_clamps_to_queued },
+    { "release_busy_and_drop",      test_release_busy_and_drop },
+};
+
+int io_ring_test_count = sizeof(io_ring_tests) / sizeof(io_ring_tests[0]);
@@ -0,0 +1,374 @@
+/* arc_os — Host-side tests for kernel/ipc/endpoint.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_LIB_MEM_H
+
+#define THREAD_READY    1
+#define THREAD_RUNNING  2
+#define THREAD_BLOCKED  3
+
+/* Thread stub: only the fields endpoint.c uses */
+struct IpcWait;
+typedef struct Thread {
+    uint32_t        tid;
+    uint8_t         state;
+    struct IpcWait *ipc_caller;
+} Thread;
+
+static Thread *test_current_thread;
+static Thread *thread_current(void) { return test_current_thread; }
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* kmalloc/kfree via libc, counting outstanding allocations */
+#define GFP_ZERO  0x01
+static int live_allocs;
+
+static void *kmalloc(size_t size, uint32_t flags) {
+    void *p = malloc(size);
+    if (p && (flags & GFP_ZERO)) memset(p, 0, size);
+    if (p) live_allocs++;
+    return p;
+}
+
+static void kfree(void *ptr) {
+    if (ptr) live_allocs--;
+    free(ptr);
+}
+
+/* Scheduler stubs: a blocking call runs a hook standing in for the other
+ * threads, which must wake the caller before it returns */
+static void (*block_hook)(void);
+static Thread *handoff_to;
+static int yields;
+static int wakeups;
+static Thread *last_woken;
+
+static void sched_add_thread(Thread *t) {
+    t->state = THREAD_READY;
+    wakeups++;
+    last_woken = t;
+}
+
+static void run_block_hook(void) {
+    Thread *self = thread_current();
+    if (block_hook) block_hook();
+    test_current_thread = self;
+    self->state = THREAD_RUNNING;
+}
+
+static void sched_handoff(Thread *next) {
+    handoff_to = next;
+    next->state = THREAD_RUNNING;
+    run_block_hook();
+}
+
+static void sched_yield(void) {
+    yields++;
+    run_block_hook();
+}
+
+#include "../kernel/ipc/endpoint.c"
+
+/* --- Helpers --- */
+
+static Thread client, server, client2;
+static VfsNode *ep;
+
+static void reset_ipc(void) {
+    memset(&client, 0, sizeof(client));
+    memset(&server, 0, sizeof(server));
+    memset(&client2, 0, sizeof(client2));
+    client.tid = 1;
+    server.tid = 2;
+    client2.tid = 3;
+    client.state = server.state = client2.state = THREAD_RUNNING;
+    block_hook = NULL;
+    handoff_to = NULL;
+    yields = 0;
+    wakeups = 0;
+    last_woken = NULL;
+    live_allocs = 0;
+    ep = ipc_endpoint_create();
+}
+
+static void finish_ipc(void) {
+    ipc_endpoint_close(ep);
+}
+
+static IpcMsg make_msg(uint64_t tag, void *buf, uint32_t len, uint32_t cap) {
+    IpcMsg m;
+    memset(&m, 0, sizeof(m));
+    m.tag = tag;
+    m.buf = (uint64_t)buf;
+    m.len = len;
+    m.cap = cap;
+    return m;
+}
+
+/* What the server saw, for the assertions after the call returns */
+static IpcMsg seen;
+static char seen_buf[64];
+static int server_ret;
+
+/* The server takes the queued call and replies with words[0] + 1 */
+static void hook_server_recv_reply(void) {
+    test_current_thread = &server;
+    memset(seen_buf, 0, sizeof(seen_buf));
+    seen = make_msg(0, seen_buf, 0, sizeof(seen_buf));
+    server_ret = ipc_recv(ep, &seen);
+
+    static char pong[] = "pong";
+    IpcMsg r = make_msg(7, pong, 4, 0);
+    r.words[0] = seen.words[0] + 1;
+    ipc_reply(&r);
+}
+
+/* --- Tests --- */
+
+TEST(ipc_call_queues_until_received) {
+    reset_ipc();
+    block_hook = hook_server_recv_reply;
+    test_current_thread = &client;
+
+    char rbuf[16] = "ping";
+    IpcMsg m = make_msg(3, rbuf, 4, sizeof(rbuf));
+    m.words[0] = 41;
+    ASSERT_EQ(ipc_call(ep, &m), 0);
+    ASSERT_EQ(yields, 1);                   /* No receiver: queued */
+    ASSERT_EQ(server_ret, 0);
+    ASSERT_EQ(seen.tag, 3);
+    ASSERT_EQ(seen.words[0], 41);
+    ASSERT_EQ(seen.len, 4);
+    ASSERT_STR_EQ(seen_buf, "ping");
+
+    ASSERT_EQ(m.tag, 7);
+    ASSERT_EQ(m.words[0], 42);
+    ASSERT_EQ(m.len, 4);
+    ASSERT_STR_EQ(rbuf, "pong");
+    ASSERT_TRUE(last_woken == &client);
+    ASSERT_TRUE(server.ipc_caller == NULL);
+    ASSERT_EQ(live_allocs, 1);              /* Only the endpoint */
+    finish_ipc();
+    return 0;
+}
+
+/* The server is blocked in recv: the call is handed to it directly */
+static IpcWait server_wait;
+
+static void hook_server_takes_handoff(void) {
+    test_current_thread = &server;
+    memset(seen_buf, 0, sizeof(seen_buf));
+    seen = make_msg(0, seen_buf, 0, sizeof(seen_buf));
+    ipc_accept(&server_wait, server_wait.peer, &seen);
+
+    IpcMsg r = make_msg(0, NULL, 0, 0);
+    r.words[0] = 99;
+    ipc_reply(&r);
+}
+
+TEST(ipc_call_hands_off_to_waiting_server) {
+    reset_ipc();
+    IpcMsg sm = make_msg(0, seen_buf, 0, sizeof(seen_buf));
+    test_current_thread = &server;
+    ipc_wait_init(&server_wait, &sm);
+    to_endpoint(ep)->receivers = &server_wait;
+
+    block_hook = hook_server_takes_handoff;
+    test_current_thread = &client;
+    char data[] = "hello";
+    IpcMsg m = make_msg(5, data, 5, sizeof(data));
+    ASSERT_EQ(ipc_call(ep, &m), 0);
+
+    ASSERT_TRUE(handoff_to == &server);
+    ASSERT_EQ(yields, 0);
+    ASSERT_TRUE(to_endpoint(ep)->receivers == NULL);
+    ASSERT_EQ(seen.tag, 5);
+    ASSERT_STR_EQ(seen_buf, "hello");
+    ASSERT_EQ(m.words[0], 99);
+    ASSERT_EQ(m.len, 0);
+    finish_ipc();
+    return 0;
+}
+
+/* reply_recv with nobody queued: the caller runs at once, and the server
+ * sleeps until the next call arrives */
+static IpcWait first_call, next_call;
+
+static void hook_next_call_arrives(void) {
+    /* The replied caller runs, then client2 calls */
+    IpcWait *self = to_endpoint(ep)->receivers;
+    to_endpoint(ep)->receivers = self->next;
+    self->peer = &next_call;
+}
+
+TEST(ipc_reply_recv_hands_off_to_caller) {
+    reset_ipc();
+    memset(&first_call, 0, sizeof(first_call));
+    first_call.thread = &client;
+    client.state = THREAD_BLOCKED;
+    server.ipc_caller = &first_call;
+
+    memset(&next_call, 0, sizeof(next_call));
+    next_call.thread = &client2;
+    next_call.msg.tag = 11;
+    next_call.msg.words[2] = 5;
+
+    block_hook = hook_next_call_arrives;
+    test_current_thread = &server;
+    IpcMsg m = make_msg(1, NULL, 0, 0);
+    m.words[0] = 123;
+    ASSERT_EQ(ipc_reply_recv(ep, &m), 0);
+
+    /* Reply loaded for the first caller, who ran without a queue trip */
+    ASSERT_TRUE(handoff_to == &client);
+    ASSERT_EQ(wakeups, 0);
+    ASSERT_EQ(first_call.msg.words[0], 123);
+    ASSERT_EQ(first_call.status, 0);
+
+    /* And the server now serves client2 */
+    ASSERT_EQ(m.tag, 11);
+    ASSERT_EQ(m.words[2], 5);
+    ASSERT_TRUE(server.ipc_caller == &next_call);
+    finish_ipc();
+    return 0;
+}
+
+TEST(ipc_reply_recv_takes_queued_call) {
+    reset_ipc();
+    memset(&first_call, 0, sizeof(first_call));
+    first_call.thread = &client;
+    server.ipc_caller = &first_call;
+
+    memset(&next_call, 0, sizeof(next_call));
+    next_call.thread = &client2;
+    next_call.msg.tag = 12;
+    ipc_queue_caller(to_endpoint(ep), &next_call);
+
+    test_current_thread = &server;
+    IpcMsg m = make_msg(0, NULL, 0, 0);
+    ASSERT_EQ(ipc_reply_recv(ep, &m), 0);
+
+    /* No switch: the first caller is woken, the server keeps going */
+    ASSERT_TRUE(handoff_to == NULL);
+    ASSERT_EQ(yields, 0);
+    ASSERT_TRUE(last_woken == &client);
+    ASSERT_EQ(m.tag, 12);
+    ASSERT_TRUE(server.ipc_caller == &next_call);
+    finish_ipc();
+    return 0;
+}
+
+TEST(ipc_buffer_truncated_to_cap) {
+    reset_ipc();
+    memset(&first_call, 0, sizeof(first_call));
+    first_call.thread = &client;
+    first_call.msg.len = 10;
+    first_call.data = kmalloc(10, 0);
+    memcpy(first_call.data, "0123456789", 10);
+    ipc_queue_caller(to_endpoint(ep), &first_call);
+
+    test_current_thread = &server;
+    char small[5] = { 0 };
+    IpcMsg m = make_msg(0, small, 0, 4);
+    ASSERT_EQ(ipc_recv(ep, &m), 0);
+    ASSERT_EQ(m.len, 4);
+    ASSERT_STR_EQ(small, "0123");
+    ASSERT_TRUE(first_call.data == NULL);   /* Bounce copy freed */
+    ASSERT_EQ(live_allocs, 1);
+    finish_ipc();
+    return 0;
+}
+
+/* The server takes the call and exits without replying */
+static void hook_server_exits(void) {
+    test_current_thread = &server;
+    IpcMsg m = make_msg(0, NULL, 0, 0);
+    ipc_recv(ep, &m);
+    ipc_thread_exit(&server);
+}
+
+TEST(ipc_server_exit_fails_call) {
+    reset_ipc();
+    block_hook = hook_server_exits;
+    test_current_thread = &client;
+    char x = 'x';
+    IpcMsg m = make_msg(1, &x, 1, 0);
+    ASSERT_EQ(ipc_call(ep, &m), -EPIPE);
+    ASSERT_TRUE(last_woken == &client);
+    ASSERT_TRUE(server.ipc_caller == NULL);
+    ASSERT_EQ(live_allocs, 1);
+    finish_ipc();
+    return 0;
+}
+
+TEST(ipc_rejects_bad_requests) {
+    reset_ipc();
+    test_current_thread = &server;
+
+    /* Nothing to reply to */
+    IpcMsg m = make_msg(0, NULL, 0, 0);
+    ASSERT_EQ(ipc_reply(&m), -EINVAL);
+
+    /* recv while a reply is still owed */
+    memset(&first_call, 0, sizeof(first_call));
+    server.ipc_caller = &first_call;
+    ASSERT_EQ(ipc_recv(ep, &m), -EBUSY);
+    server.ipc_caller = NULL;
+
+    /* Oversized and kernel-space buffers, before anything blocks */
+    test_current_thread = &client;
+    char big[16];
+    m = make_msg(0, big, IPC_BUF_MAX + 1, 0);
+    ASSERT_EQ(ipc_call(ep, &m), -EINVAL);
+    m = make_msg(0, (void *)0xFFFF800000001000ULL, 8, 0);
+    ASSERT_EQ(ipc_call(ep, &m), -EINVAL);
+    m = make_msg(0, (void *)0xFFFF800000001000ULL, 0, 8);
+    ASSERT_EQ(ipc_call(ep, &m), -EINVAL);
+    ASSERT_EQ(yields, 0);
+    ASSERT_TRUE(to_endpoint(ep)->callers == NULL);
+    finish_ipc();
+    return 0;
+}
+
+TEST(ipc_endpoint_refcount) {
+    reset_ipc();
+    ASSERT_EQ(ep->type, VFS_ENDPOINT);
+    ipc_endpoint_addref(ep);
+    ipc_endpoint_close(ep);
+    ASSERT_EQ(live_allocs, 1);
+    ipc_endpoint_close(ep);
+    ASSERT_EQ(live_allocs, 0);
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase ipc_tests[] = {
+    TEST_ENTRY(ipc_call_queues_until_received),
+    TEST_ENTRY(ipc_call_hands_off_to_waiting_server),
+    TEST_ENTRY(ipc_reply_recv_hands_off_to_caller),
+    TEST_ENTRY(ipc_reply_recv_takes_queued_call),
+    TEST_ENTRY(ipc_buffer_truncated_to_cap),
+    TEST_ENTRY(ipc_server_exit_fails_call),
+    TEST_ENTRY(ipc_rejects_bad_requests),
+    TEST_ENTRY(ipc_endpoint_refcount),
+};
+int ipc_test_count = sizeof(ipc_tests) / sizeof(ipc_tests[0]);
@@ -15,6 +15,7 @@
 #define ARCHOS_NET_TCP_H
 #define ARCHOS_LIB_MEM_H
 #define ARCHOS_LIB_KPRINTF_H
+#define ARCHOS_PROC_RCU_H
 
 /* Inline types */
 #define ETH_ALEN        6
@@ -128,6 +129,13 @@ static void tcp_rx(struct NetIf *nif, uint32_t src_ip, uint32_t dst_ip,
 }
 
 /* Include ipv4.c */
+/* RCU stubs — single-threaded tests have no concurrent readers */
+static int rcu_read_depth;
+static inline void rcu_read_lock(void) { rcu_read_depth++; }
+static inline void rcu_read_unlock(void) { rcu_read_depth--; }
+#define rcu_dereference(p)        (p)
+#define rcu_assign_pointer(p, v)  ((p) = (v))
+
 #include "../kernel/net/ipv4.c"
 
 /* Build a valid IPv4 packet with correct checksum */
@@ -33,6 +33,11 @@ static void pic_send_eoi(uint8_t irq) {
 static int test_lapic_eoi_called;
 static void lapic_eoi(void) { test_lapic_eoi_called++; }
 
+/* Stub preemption check on interrupt exit */
+#define ARCHOS_PROC_PREEMPT_H
+static int test_irq_exit_called;
+static void preempt_irq_exit(void) { test_irq_exit_called++; }
+
 /* Include the real ISR implementation */
 #include "../kernel/arch/x86_64/isr.c"
 
@@ -59,6 +64,7 @@ static void reset_test_state(void) {
     test_pic_spurious_result = false;
     test_eoi_called = 0;
     test_eoi_irq = 0;
+    test_irq_exit_called = 0;
     /* Clear all handlers */
     for (int i = 0; i < ISR_COUNT; i++) {
         handlers[i] = NULL;
@@ -89,6 +95,7 @@ static int test_irq_dispatch_eoi(void) {
     ASSERT_EQ(handler_called, 1);
     ASSERT_EQ(test_eoi_called, 1);
     ASSERT_EQ(test_eoi_irq, 0);  /* IRQ 0 */
+    ASSERT_EQ(test_irq_exit_called, 1);  /* Preemption point on exit */
     return 0;
 }
 
@@ -102,6 +109,7 @@ static int test_spurious_irq_no_handler_no_eoi(void) {
 
     ASSERT_EQ(handler_called, 0);  /* Handler not called */
     ASSERT_EQ(test_eoi_called, 0); /* No EOI sent */
+    ASSERT_EQ(test_irq_exit_called, 0);
     return 0;
 }
 
@@ -126,6 +134,7 @@ static int test_exception_no_eoi(void) {
 
     ASSERT_EQ(handler_called, 1);
     ASSERT_EQ(test_eoi_called, 0);  /* Exceptions don't send EOI */
+    ASSERT_EQ(test_irq_exit_called, 0);  /* Nor preempt */
     return 0;
 }
 
@@ -42,6 +42,18 @@ extern TestCase vmm_tests[];
 extern int vmm_test_count;
 extern TestCase spinlock_tests[];
 extern int spinlock_test_count;
+extern TestCase rcu_tests[];
+extern int rcu_test_count;
+extern TestCase workqueue_tests[];
+extern int workqueue_test_count;
+extern TestCase io_ring_tests[];
+extern int io_ring_test_count;
+extern TestCase dl_tests[];
+extern int dl_test_count;
+extern TestCase pager_tests[];
+extern int pager_test_count;
+extern TestCase napi_tests[];
+extern int napi_test_count;
 extern TestCase gdt_tests[];
 extern int gdt_test_count;
 extern TestCase idt_tests[];
@@ -88,6 +100,20 @@ extern TestCase cred_tests[];
 extern int cred_test_count;
 extern TestCase mutex_tests[];
 extern int mutex_test_count;
+extern TestCase mutex_pi_tests[];
+extern int mutex_pi_test_count;
+extern TestCase preempt_tests[];
+extern int preempt_test_count;
+extern TestCase ipc_tests[];
+extern int ipc_test_count;
+extern TestCase shmfs_tests[];
+extern int shmfs_test_count;
+extern TestCase mmap_tests[];
+extern int mmap_test_count;
+extern TestCase bcache_tests[];
+extern int bcache_test_count;
+extern TestCase flusher_tests[];
+extern int flusher_test_count;
 extern TestCase acpi_tests[];
 extern int acpi_test_count;
 extern TestCase fb_console_tests[];
@@ -142,6 +168,12 @@ int main(int argc, char **argv) {
         { "fd",      fd_tests,      &fd_test_count },
         { "vmm",      vmm_tests,      &vmm_test_count },
         { "spinlock",  spinlock_tests,  &spinlock_test_count },
+        { "rcu",       rcu_tests,       &rcu_test_count },
+        { "workqueue", workqueue_tests, &workqueue_test_count },
+        { "io_ring",   io_ring_tests,   &io_ring_test_count },
+        { "pager",     pager_tests,     &pager_test_count },
+        { "dl",        dl_tests,        &dl_test_count },
+        { "napi",      napi_tests,      &napi_test_count },
         { "gdt",       gdt_tests,       &gdt_test_count },
         { "idt",       idt_tests,       &idt_test_count },
         { "bootinfo",  bootinfo_tests,  &bootinfo_test_count },
@@ -165,6 +197,13 @@ int main(int argc, char **argv) {
         { "icmp",         icmp_tests,         &icmp_test_count },
         { "cred",         cred_tests,         &cred_test_count },
         { "mutex",        mutex_tests,        &mutex_test_count },
+        { "mutex_pi",     mutex_pi_tests,     &mutex_pi_test_count },
+        { "preempt",      preempt_tests,      &preempt_test_count },
+        { "ipc",          ipc_tests,          &ipc_test_count },
+        { "shmfs",        shmfs_tests,        &shmfs_test_count },
+        { "mmap",         mmap_tests,         &mmap_test_count },
+        { "bcache",       bcache_tests,       &bcache_test_count },
+        { "flusher",      flusher_tests,      &flusher_test_count },
         { "acpi",         acpi_tests,         &acpi_test_count },
         { "fb_console",   fb_console_tests,   &fb_console_test_count },
         { "passwd",       passwd_tests,       &passwd_test_count },
@@ -0,0 +1,306 @@
+/* arc_os — Host-side tests for kernel/proc/mmap.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_PROCESS_H
+#define ARCHOS_FS_SHMFS_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_VMM_H
+#define ARCHOS_MM_KMALLOC_H
+
+#define PAGE_SIZE 4096
+#define PAGE_ALIGN_UP(x)    (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1ULL))
+
+#define VMM_FLAG_WRITABLE (1 << 0)
+#define VMM_FLAG_USER     (1 << 1)
+#define VMM_FLAG_NOEXEC   (1 << 2)
+#define VMM_FLAG_SHARED   (1 << 3)
+
+#define USER_MMAP_BASE    0x0000600000000000ULL
+#define USER_MMAP_END     0x0000600000100000ULL  /* 256 pages, for the tests */
+
+#define GFP_ZERO 0x01
+
+#include "../kernel/fs/vfs.h"
+
+/* Process stub: only the fields mmap.c uses */
+typedef struct Process {
+    uint64_t           page_table;
+    struct Process    *vfork_parent;
+    struct MmapRegion *mmaps;
+} Process;
+
+/* kmalloc via libc, with failure injection */
+static int kmalloc_fail;
+static void *kmalloc(size_t size, uint32_t flags) {
+    if (kmalloc_fail) return NULL;
+    void *p = malloc(size);
+    if (p && (flags & GFP_ZERO)) memset(p, 0, size);
+    return p;
+}
+static void kfree(void *ptr) { free(ptr); }
+
+/* VMM stub: one fake page table for the window */
+#define WINDOW_PAGES ((USER_MMAP_END - USER_MMAP_BASE) / PAGE_SIZE)
+static uint64_t pte_phys[WINDOW_PAGES];
+static uint32_t pte_flags[WINDOW_PAGES];
+
+static uint64_t slot(uint64_t va) { return (va - USER_MMAP_BASE) / PAGE_SIZE; }
+
+static void vmm_map_page_in(uint64_t pml4, uint64_t virt, uint64_t phys, uint32_t flags) {
+    (void)pml4;
+    pte_phys[slot(virt)] = phys;
+    pte_flags[slot(virt)] = flags;
+}
+
+static void vmm_unmap_page_in(uint64_t pml4, uint64_t virt) {
+    (void)pml4;
+    pte_phys[slot(virt)] = 0;
+    pte_flags[slot(virt)] = 0;
+}
+
+/* shmfs stub: frame i of an object is 0x100000 * inode + i * PAGE_SIZE */
+static int map_refs;
+static int frame_fail_at = -1;
+
+static int shmfs_is_object(const VfsNode *node) { return node->type == VFS_FILE; }
+static void shmfs_map_get(VfsNode *node) { (void)node; map_refs++; }
+static void shmfs_map_put(VfsNode *node) { (void)node; map_refs--; }
+
+static uint64_t shmfs_frame(VfsNode *node, uint64_t index) {
+    if ((int)index == frame_fail_at) return 0;
+    return node->inode_num * 0x100000 + index * PAGE_SIZE;
+}
+
+#include "../kernel/proc/mmap.c"
+
+static Process proc;
+static VfsNode obj;
+static VfsFile file;
+
+static void reset_mmap(void) {
+    while (proc.mmaps) {
+        MmapRegion *next = proc.mmaps->next;
+        free(proc.mmaps);
+        proc.mmaps = next;
+    }
+    memset(&proc, 0, sizeof(proc));
+    proc.page_table = 0x1000;
+    memset(pte_phys, 0, sizeof(pte_phys));
+    memset(pte_flags, 0, sizeof(pte_flags));
+    memset(&obj, 0, sizeof(obj));
+    obj.inode_num = 7;
+    obj.type = VFS_FILE;
+    obj.size = 64 * PAGE_SIZE;
+    file.node = &obj;
+    file.flags = O_RDWR;
+    file.offset = 0;
+    map_refs = 0;
+    kmalloc_fail = 0;
+    frame_fail_at = -1;
+}
+
+static uint64_t frame(uint64_t index) { return 7 * 0x100000 + index * PAGE_SIZE; }
+
+static int region_count(void) {
+    int n = 0;
+    for (MmapRegion *r = proc.mmaps; r != NULL; r = r->next) n++;
+    return n;
+}
+
+/* --- Tests --- */
+
+TEST(map_shares_object_frames) {
+    reset_mmap();
+    int64_t a = mmap_map(&proc, 0, 3 * PAGE_SIZE - 100, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, &file, 2 * PAGE_SIZE);
+    ASSERT_EQ(a, (int64_t)USER_MMAP_BASE);
+    ASSERT_EQ(map_refs, 1);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(pte_phys[i], frame(2 + i));
+        ASSERT_EQ(pte_flags[i], VMM_FLAG_USER | VMM_FLAG_SHARED |
+                                VMM_FLAG_WRITABLE | VMM_FLAG_NOEXEC);
+    }
+    ASSERT_EQ(pte_phys[3], 0);
+
+    /* The next mapping goes after it; read-only maps read-only */
+    int64_t b = mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0);
+    ASSERT_EQ(b, (int64_t)(USER_MMAP_BASE + 3 * PAGE_SIZE));
+    ASSERT_EQ(pte_flags[3], VMM_FLAG_USER | VMM_FLAG_SHARED | VMM_FLAG_NOEXEC);
+    ASSERT_EQ(region_count(), 2);
+    return 0;
+}
+
+TEST(map_rejects_bad_requests) {
+    reset_mmap();
+    ASSERT_EQ(mmap_map(&proc, 0, 0, PROT_READ, MAP_SHARED, &file, 0), -EINVAL);
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 100), -EINVAL);
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_PRIVATE, &file, 0), -EINVAL);
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, 0, &file, 0), -EINVAL);
+
+    /* Past the end of the object */
+    ASSERT_EQ(mmap_map(&proc, 0, 65 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -EINVAL);
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file,
+                       64 * PAGE_SIZE), -EINVAL);
+
+    /* Access beyond the open mode */
+    file.flags = O_RDONLY;
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_WRITE, MAP_SHARED, &file, 0), -EACCES);
+    file.flags = O_WRONLY;
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -EACCES);
+    file.flags = O_RDWR;
+
+    /* Not a shared memory object */
+    obj.type = VFS_PIPE;
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -ENODEV);
+    obj.type = VFS_FILE;
+
+    /* A vfork child does not own its address space */
+    Process parent;
+    proc.vfork_parent = &parent;
+    ASSERT_EQ(mmap_map(&proc, 0, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -EINVAL);
+    proc.vfork_parent = NULL;
+
+    ASSERT_EQ(map_refs, 0);
+    ASSERT_TRUE(proc.mmaps == NULL);
+    return 0;
+}
+
+TEST(hint_and_fixed_placement) {
+    reset_mmap();
+    uint64_t hint = USER_MMAP_BASE + 10 * PAGE_SIZE;
+    ASSERT_EQ(mmap_map(&proc, hint, 2 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0),
+              (int64_t)hint);
+
+    /* An overlapping hint is ignored; the lowest gap is used */
+    ASSERT_EQ(mmap_map(&proc, hint + PAGE_SIZE, PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0),
+              (int64_t)USER_MMAP_BASE);
+
+    /* MAP_FIXED replaces what is there */
+    ASSERT_EQ(mmap_map(&proc, hint + PAGE_SIZE, PAGE_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED,
+                       &file, 5 * PAGE_SIZE), (int64_t)(hint + PAGE_SIZE));
+    ASSERT_EQ(pte_phys[10], frame(0));
+    ASSERT_EQ(pte_phys[11], frame(5));
+    ASSERT_EQ(region_count(), 3);
+    ASSERT_EQ(map_refs, 3);
+
+    ASSERT_EQ(mmap_map(&proc, hint + 1, PAGE_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED,
+                       &file, 0), -EINVAL);
+    ASSERT_EQ(mmap_map(&proc, USER_MMAP_END, PAGE_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED,
+                       &file, 0), -EINVAL);
+
+    /* A full window */
+    ASSERT_EQ(mmap_map(&proc, 0, 250 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -EINVAL);
+    obj.size = 256 * PAGE_SIZE;
+    ASSERT_EQ(mmap_map(&proc, 0, 250 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -ENOMEM);
+    return 0;
+}
+
+TEST(unmap_trims_and_splits) {
+    reset_mmap();
+    ASSERT_EQ(mmap_map(&proc, 0, 8 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0),
+              (int64_t)USER_MMAP_BASE);
+
+    /* Middle: split in two */
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE + 3 * PAGE_SIZE, 2 * PAGE_SIZE), 0);
+    ASSERT_EQ(region_count(), 2);
+    ASSERT_EQ(map_refs, 2);
+    ASSERT_EQ(pte_phys[2], frame(2));
+    ASSERT_EQ(pte_phys[3], 0);
+    ASSERT_EQ(pte_phys[4], 0);
+    MmapRegion *hi = proc.mmaps->next;
+    ASSERT_EQ(hi->start, USER_MMAP_BASE + 5 * PAGE_SIZE);
+    ASSERT_EQ(hi->pages, 3);
+    ASSERT_EQ(hi->pgoff, 5);
+
+    /* Head of the second half, tail of the first */
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE + 5 * PAGE_SIZE, 100), 0);
+    ASSERT_EQ(hi->start, USER_MMAP_BASE + 6 * PAGE_SIZE);
+    ASSERT_EQ(hi->pgoff, 6);
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE + 2 * PAGE_SIZE, PAGE_SIZE), 0);
+    ASSERT_EQ(proc.mmaps->pages, 2);
+
+    /* A range covering both drops them; unmapping nothing is fine */
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE, 16 * PAGE_SIZE), 0);
+    ASSERT_TRUE(proc.mmaps == NULL);
+    ASSERT_EQ(map_refs, 0);
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE, PAGE_SIZE), 0);
+
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE + 1, PAGE_SIZE), -EINVAL);
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE, 0), -EINVAL);
+    ASSERT_EQ(mmap_unmap(&proc, 0x400000, PAGE_SIZE), -EINVAL);
+    return 0;
+}
+
+TEST(split_without_memory_changes_nothing) {
+    reset_mmap();
+    mmap_map(&proc, 0, 4 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0);
+    kmalloc_fail = 1;
+    ASSERT_EQ(mmap_unmap(&proc, USER_MMAP_BASE + PAGE_SIZE, PAGE_SIZE), -ENOMEM);
+    ASSERT_EQ(pte_phys[1], frame(1));
+    ASSERT_EQ(proc.mmaps->pages, 4);
+    ASSERT_EQ(map_refs, 1);
+    return 0;
+}
+
+TEST(map_failure_unwinds) {
+    reset_mmap();
+    frame_fail_at = 2;
+    ASSERT_EQ(mmap_map(&proc, 0, 4 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0), -ENOMEM);
+    for (int i = 0; i < 4; i++) ASSERT_EQ(pte_phys[i], 0);
+    ASSERT_EQ(map_refs, 0);
+    ASSERT_TRUE(proc.mmaps == NULL);
+
+    /* PROT_NONE reserves the range without touching frames */
+    ASSERT_EQ(mmap_map(&proc, 0, 4 * PAGE_SIZE, PROT_NONE, MAP_SHARED, &file, 0),
+              (int64_t)USER_MMAP_BASE);
+    ASSERT_EQ(pte_phys[0], 0);
+    ASSERT_EQ(map_refs, 1);
+    return 0;
+}
+
+TEST(fork_copies_and_release_drops) {
+    reset_mmap();
+    mmap_map(&proc, 0, 2 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0);
+    mmap_map(&proc, 0, 1 * PAGE_SIZE, PROT_READ, MAP_SHARED, &file, 0);
+
+    Process child;
+    memset(&child, 0, sizeof(child));
+    ASSERT_EQ(mmap_fork(&child, &proc), 0);
+    ASSERT_EQ(map_refs, 4);
+    ASSERT_TRUE(child.mmaps != NULL && child.mmaps != proc.mmaps);
+    ASSERT_EQ(child.mmaps->next->start, proc.mmaps->next->start);
+
+    mmap_release(&child);
+    ASSERT_EQ(map_refs, 2);
+    ASSERT_TRUE(child.mmaps == NULL);
+
+    /* Out of memory: the child is left with no mappings */
+    kmalloc_fail = 1;
+    ASSERT_EQ(mmap_fork(&child, &proc), -ENOMEM);
+    ASSERT_TRUE(child.mmaps == NULL);
+    ASSERT_EQ(map_refs, 2);
+    kmalloc_fail = 0;
+
+    mmap_release(&proc);
+    ASSERT_EQ(map_refs, 0);
+    ASSERT_EQ(pte_phys[0], 0);
+    ASSERT_EQ(pte_phys[2], 0);
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase mmap_tests[] = {
+    TEST_ENTRY(map_shares_object_frames),
+    TEST_ENTRY(map_rejects_bad_requests),
+    TEST_ENTRY(hint_and_fixed_placement),
+    TEST_ENTRY(unmap_trims_and_splits),
+    TEST_ENTRY(split_without_memory_changes_nothing),
+    TEST_ENTRY(map_failure_unwinds),
+    TEST_ENTRY(fork_copies_and_release_drops),
+};
+int mmap_test_count = sizeof(mmap_tests) / sizeof(mmap_tests[0]);
@@ -0,0 +1,315 @@
+/* arc_os — Host-side tests for priority inheritance in kernel/proc/mutex.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_WAITQUEUE_H
+
+#define THREAD_READY    1
+#define THREAD_RUNNING  2
+#define THREAD_BLOCKED  3
+
+/* Thread stub: only the fields mutex.c uses */
+typedef struct Thread {
+    uint32_t       tid;
+    uint8_t        state;
+    uint8_t        rt_priority;
+    uint8_t        pi_priority;
+    uint8_t        prio;
+    struct Mutex  *pi_blocked_on;
+    struct Mutex  *pi_held;
+    struct Thread *next;
+} Thread;
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* WaitQueue stub: a FIFO list; sleeping runs a test hook standing in for
+ * the other threads, which must make the mutex available */
+typedef struct WaitQueue {
+    Spinlock lock;
+    Thread  *head;
+    Thread  *tail;
+} WaitQueue;
+
+#define WAITQUEUE_INIT { .lock = SPINLOCK_INIT, .head = NULL, .tail = NULL }
+
+static Thread *test_current_thread;
+static Thread *thread_current(void) { return test_current_thread; }
+
+static void (*sleep_hook)(void);
+
+static void wq_init(WaitQueue *wq) {
+    wq->lock = (Spinlock)SPINLOCK_INIT;
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+static void wq_enqueue(WaitQueue *wq, Thread *t) {
+    t->next = NULL;
+    if (wq->tail) {
+        wq->tail->next = t;
+    } else {
+        wq->head = t;
+    }
+    wq->tail = t;
+}
+
+static void wq_sleep(WaitQueue *wq, Spinlock *lock) {
+    Thread *self = thread_current();
+    wq_enqueue(wq, self);
+    self->state = THREAD_BLOCKED;
+    spinlock_release(lock);
+
+    if (sleep_hook) sleep_hook();
+    test_current_thread = self;
+    self->state = THREAD_RUNNING;
+}
+
+static Thread *last_woken;
+
+static int wq_wake(WaitQueue *wq) {
+    Thread *t = wq->head;
+    if (t == NULL) return 0;
+    wq->head = t->next;
+    if (wq->head == NULL) wq->tail = NULL;
+    t->next = NULL;
+    t->state = THREAD_READY;
+    last_woken = t;
+    return 1;
+}
+
+/* wq_requeue stub: record the last waiter moved */
+static WaitQueue *requeued_wq;
+static Thread *requeued;
+
+static int wq_requeue(WaitQueue *wq, Thread *t) {
+    requeued_wq = wq;
+    requeued = t;
+    return 1;
+}
+
+/* sched stubs */
+static void sched_set_inherited_prio(Thread *t, uint8_t prio) {
+    t->pi_priority = prio;
+    t->prio = (t->rt_priority > prio) ? t->rt_priority : prio;
+}
+
+static int preempt_checks;
+static void sched_preempt_check(void) { preempt_checks++; }
+
+#include "../kernel/proc/mutex.c"
+
+/* --- Helpers --- */
+
+#define POOL_SIZE 4
+static Thread pool[POOL_SIZE];
+
+static Thread *make_thread(int index, uint8_t rt_prio) {
+    memset(&pool[index], 0, sizeof(Thread));
+    pool[index].tid = (uint32_t)index + 1;
+    pool[index].state = THREAD_RUNNING;
+    pool[index].rt_priority = rt_prio;
+    pool[index].prio = rt_prio;
+    return &pool[index];
+}
+
+static void reset_state(void) {
+    memset(pool, 0, sizeof(pool));
+    test_current_thread = NULL;
+    sleep_hook = NULL;
+    last_woken = NULL;
+    preempt_checks = 0;
+    requeued_wq = NULL;
+    requeued = NULL;
+}
+
+/* Hook state: what the sleeping thread's lenders looked like */
+static Thread *hook_owner;
+static Mutex *hook_mutex;
+static uint8_t hook_seen_prio;
+static uint8_t hook_seen_prio2;
+static Thread *hook_second;
+
+/* The owner runs (at the boosted priority) and releases the mutex */
+static void hook_owner_unlocks(void) {
+    hook_seen_prio = hook_owner->prio;
+    test_current_thread = hook_owner;
+    mutex_unlock(hook_mutex);
+}
+
+/* --- Tests --- */
+
+TEST(mutex_pi_tracks_held_mutexes) {
+    reset_state();
+    Mutex a = MUTEX_INIT, b = MUTEX_INIT;
+    Thread *t = make_thread(0, 0);
+    test_current_thread = t;
+
+    mutex_lock(&a);
+    ASSERT_EQ(mutex_trylock(&b), 0);
+    ASSERT_TRUE(t->pi_held == &b);
+    ASSERT_TRUE(b.held_next == &a);
+
+    mutex_unlock(&a);
+    ASSERT_TRUE(t->pi_held == &b);
+    ASSERT_TRUE(b.held_next == NULL);
+    mutex_unlock(&b);
+    ASSERT_TRUE(t->pi_held == NULL);
+    ASSERT_TRUE(b.owner == NULL);
+    ASSERT_EQ(preempt_checks, 2);
+    return 0;
+}
+
+TEST(mutex_pi_waiter_boosts_owner) {
+    reset_state();
+    Mutex m = MUTEX_INIT;
+    Thread *low = make_thread(0, 0);
+    Thread *high = make_thread(1, 80);
+
+    test_current_thread = low;
+    mutex_lock(&m);
+
+    hook_owner = low;
+    hook_mutex = &m;
+    hook_seen_prio = 0;
+    sleep_hook = hook_owner_unlocks;
+    test_current_thread = high;
+    mutex_lock(&m);
+
+    /* low ran at high's priority until it released the mutex */
+    ASSERT_EQ(hook_seen_prio, 80);
+    ASSERT_EQ(low->prio, 0);
+    ASSERT_EQ(low->pi_priority, 0);
+    ASSERT_TRUE(last_woken == high);
+    ASSERT_TRUE(m.owner == high);
+    ASSERT_TRUE(high->pi_blocked_on == NULL);
+    ASSERT_TRUE(high->pi_held == &m);
+    return 0;
+}
+
+TEST(mutex_pi_lower_waiter_does_not_boost) {
+    reset_state();
+    Mutex m = MUTEX_INIT;
+    Thread *owner = make_thread(0, 50);
+    Thread *waiter = make_thread(1, 20);
+
+    test_current_thread = owner;
+    mutex_lock(&m);
+
+    hook_owner = owner;
+    hook_mutex = &m;
+    sleep_hook = hook_owner_unlocks;
+    test_current_thread = waiter;
+    mutex_lock(&m);
+
+    ASSERT_EQ(hook_seen_prio, 50);
+    ASSERT_EQ(owner->pi_priority, 0);
+    ASSERT_TRUE(m.owner == waiter);
+    return 0;
+}
+
+/* mid holds m2 and waits for m1, which low holds */
+static void hook_check_chain(void) {
+    hook_seen_prio = hook_owner->prio;
+    hook_seen_prio2 = hook_second->prio;
+    /* Let the waiter through */
+    wq_wake(&hook_mutex->waiters);
+    hook_mutex->owner = NULL;
+}
+
+TEST(mutex_pi_boost_follows_chain) {
+    reset_state();
+    Mutex m1 = MUTEX_INIT, m2 = MUTEX_INIT;
+    Thread *low = make_thread(0, 0);
+    Thread *mid = make_thread(1, 10);
+    Thread *high = make_thread(2, 90);
+
+    test_current_thread = low;
+    mutex_lock(&m1);
+    test_current_thread = mid;
+    mutex_lock(&m2);
+    mid->pi_blocked_on = &m1;
+    wq_enqueue(&m1.waiters, mid);
+
+    hook_owner = mid;
+    hook_second = low;
+    hook_mutex = &m2;
+    sleep_hook = hook_check_chain;
+    test_current_thread = high;
+    mutex_lock(&m2);
+
+    ASSERT_EQ(hook_seen_prio, 90);
+    ASSERT_EQ(hook_seen_prio2, 90);
+    /* The boosted mid moves up among m1's waiters */
+    ASSERT_TRUE(requeued == mid);
+    ASSERT_TRUE(requeued_wq == &m1.waiters);
+    return 0;
+}
+
+TEST(mutex_pi_unlock_keeps_other_boosts) {
+    reset_state();
+    Mutex m1 = MUTEX_INIT, m2 = MUTEX_INIT;
+    Thread *owner = make_thread(0, 5);
+    Thread *w1 = make_thread(1, 30);
+    Thread *w2 = make_thread(2, 60);
+
+    test_current_thread = owner;
+    mutex_lock(&m1);
+    mutex_lock(&m2);
+    wq_enqueue(&m1.waiters, w1);
+    wq_enqueue(&m2.waiters, w2);
+    sched_set_inherited_prio(owner, 60);
+
+    /* Releasing m2 leaves what m1's waiter lends */
+    mutex_unlock(&m2);
+    ASSERT_TRUE(last_woken == w2);
+    ASSERT_EQ(owner->pi_priority, 30);
+    ASSERT_EQ(owner->prio, 30);
+
+    mutex_unlock(&m1);
+    ASSERT_EQ(owner->pi_priority, 0);
+    ASSERT_EQ(owner->prio, 5);
+    return 0;
+}
+
+TEST(mutex_pi_new_owner_inherits_waiters) {
+    reset_state();
+    Mutex m = MUTEX_INIT;
+    Thread *t = make_thread(0, 0);
+    Thread *waiter = make_thread(1, 70);
+
+    /* A waiter still queued when t takes the mutex */
+    wq_enqueue(&m.waiters, waiter);
+    test_current_thread = t;
+    mutex_lock(&m);
+    ASSERT_EQ(t->prio, 70);
+
+    mutex_unlock(&m);
+    ASSERT_EQ(t->prio, 0);
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase mutex_pi_tests[] = {
+    TEST_ENTRY(mutex_pi_tracks_held_mutexes),
+    TEST_ENTRY(mutex_pi_waiter_boosts_owner),
+    TEST_ENTRY(mutex_pi_lower_waiter_does_not_boost),
+    TEST_ENTRY(mutex_pi_boost_follows_chain),
+    TEST_ENTRY(mutex_pi_unlock_keeps_other_boosts),
+    TEST_ENTRY(mutex_pi_new_owner_inherits_waiters),
+};
+int mutex_pi_test_count = sizeof(mutex_pi_tests) / sizeof(mutex_pi_tests[0]);
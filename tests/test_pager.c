@@ -0,0 +1,590 @@
+/* arc_os — Host-side tests for kernel/proc/pager.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_PROCESS_H
+#define ARCHOS_ARCH_X86_64_ISR_H
+#define ARCHOS_ARCH_X86_64_PAGING_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_VMM_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_FS_VFS_H
+#define ARCHOS_LIB_MEM_H
+#define ARCHOS_LIB_KPRINTF_H
+
+#define EIO        5
+#define ENOMEM    12
+#define EFAULT    14
+#define EINVAL    22
+
+#define PAGE_SIZE 4096
+#define PAGE_ALIGN_UP(x)    (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1ULL))
+#define PAGE_ALIGN_DOWN(x)  ((x) & ~(PAGE_SIZE - 1ULL))
+#define PTE_ADDR_MASK  0x000FFFFFFFFFF000ULL
+
+#define VMM_FLAG_WRITABLE (1 << 0)
+#define VMM_FLAG_USER     (1 << 1)
+#define VMM_FLAG_NOEXEC   (1 << 2)
+#define VMM_FLAG_SHARED   (1 << 3)
+#define VMM_FLAG_COW      (1 << 4)
+#define GFP_ZERO 0x01
+
+static inline void kprintf(const char *fmt, ...) { (void)fmt; }
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* VFS stubs: file bytes are a pattern seeded by the inode number */
+#define O_RDONLY 0x00
+
+typedef struct VfsNode {
+    uint64_t inode_num;
+    uint64_t size;
+    uint32_t data_gen;
+} VfsNode;
+
+typedef struct {
+    VfsNode  *node;
+    uint64_t  offset;
+    uint32_t  flags;
+} VfsFile;
+
+static int vfs_read_calls;
+static int vfs_read_fail;
+
+static uint8_t file_byte(const VfsNode *node, uint64_t off) {
+    return (uint8_t)(off * 7 + node->inode_num + node->data_gen);
+}
+
+static int vfs_read(VfsFile *file, void *buf, uint32_t size) {
+    vfs_read_calls++;
+    if (vfs_read_fail) return -EIO;
+    uint8_t *dst = buf;
+    for (uint32_t i = 0; i < size; i++) {
+        dst[i] = file_byte(file->node, file->offset + i);
+    }
+    file->offset += size;
+    return (int)size;
+}
+
+/* kmalloc stubs */
+static void *kmalloc(size_t size, uint32_t flags) {
+    return (flags & GFP_ZERO) ? calloc(1, size) : malloc(size);
+}
+static void kfree(void *ptr) { free(ptr); }
+
+/* PMM stubs: frames are host pages, HHDM offset 0 */
+static int pages_live;
+static int pmm_fail_after = -1;
+
+static uint64_t pmm_alloc_page(void) {
+    if (pmm_fail_after == 0) return 0;
+    if (pmm_fail_after > 0) pmm_fail_after--;
+    pages_live++;
+    return (uint64_t)aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+}
+static void pmm_free_page(uint64_t phys) {
+    pages_live--;
+    free((void *)phys);
+}
+static uint64_t vmm_get_hhdm_offset(void) { return 0; }
+
+/* VMM stubs: record the last mapping made */
+static uint64_t mapped_pml4, mapped_virt, mapped_phys;
+static uint32_t mapped_flags;
+static int map_calls;
+static int resolve_cow_calls;
+static int resolve_cow_result;
+
+static void vmm_map_page_in(uint64_t pml4, uint64_t virt, uint64_t phys,
+                            uint32_t flags) {
+    mapped_pml4 = pml4;
+    mapped_virt = virt;
+    mapped_phys = phys;
+    mapped_flags = flags;
+    map_calls++;
+}
+static int vmm_resolve_cow(uint64_t pml4, uint64_t virt) {
+    (void)pml4; (void)virt;
+    resolve_cow_calls++;
+    return resolve_cow_result;
+}
+
+/* Arch stubs */
+#define EXCEPTION_PAGE_FAULT 14
+
+typedef struct {
+    uint64_t vector;
+    uint64_t error_code;
+} InterruptFrame;
+
+typedef void (*isr_handler_t)(InterruptFrame *frame);
+static isr_handler_t pf_handler;
+static int unhandled_calls;
+static uint64_t fake_cr2, fake_cr3;
+
+static void isr_register_handler(int vector, isr_handler_t handler) {
+    if (vector == EXCEPTION_PAGE_FAULT) pf_handler = handler;
+}
+static void isr_unhandled_exception(InterruptFrame *frame) {
+    (void)frame;
+    unhandled_calls++;
+}
+static uint64_t paging_read_cr2(void) { return fake_cr2; }
+static uint64_t paging_read_cr3(void) { return fake_cr3; }
+
+/* Process stub: the fault handler only needs the address space and map */
+#include "../kernel/proc/elf.h"
+
+typedef struct UserImage {
+    ElfMap map;
+    ElfMap interp;
+} UserImage;
+
+typedef struct Process {
+    uint64_t        page_table;
+    struct Process *vfork_parent;
+    UserImage       image;
+} Process;
+
+static Process *test_current_proc;
+static Process *proc_current(void) { return test_current_proc; }
+
+/* Include the real pager.c */
+#include "../kernel/proc/pager.c"
+
+/* --- Helpers --- */
+
+static void reset_pager(void) {
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        if (cache[i] != NULL) pager_free(cache[i]);
+        cache[i] = NULL;
+    }
+    use_clock = 0;
+    memset(&stats, 0, sizeof(stats));
+    vfs_read_calls = 0;
+    vfs_read_fail = 0;
+    pmm_fail_after = -1;
+    map_calls = 0;
+    mapped_pml4 = mapped_virt = mapped_phys = 0;
+    mapped_flags = 0;
+    resolve_cow_calls = 0;
+    resolve_cow_result = 0;
+    unhandled_calls = 0;
+    test_current_proc = NULL;
+}
+
+static VfsNode make_node(uint64_t inode, uint64_t size) {
+    VfsNode n = { .inode_num = inode, .size = size, .data_gen = 0 };
+    return n;
+}
+
+static ElfSegment make_seg(uint64_t vaddr, uint64_t offset, uint64_t filesz,
+                           uint64_t memsz, uint32_t flags) {
+    ElfSegment s = { .vaddr = vaddr, .memsz = memsz, .offset = offset,
+                     .filesz = filesz, .flags = flags };
+    return s;
+}
+
+/* --- Cache --- */
+
+static int test_open_reads_file_once(void) {
+    reset_pager();
+    VfsNode node = make_node(3, 2 * PAGE_SIZE + 100);
+
+    PagerFile *a, *b;
+    ASSERT_EQ(pager_open(&node, &a), 0);
+    ASSERT_EQ(a->nr_pages, 3);
+    int reads = vfs_read_calls;
+    ASSERT_EQ(pager_open(&node, &b), 0);
+    ASSERT_TRUE(a == b);
+    ASSERT_EQ(vfs_read_calls, reads);
+    ASSERT_EQ(a->refs, 2);
+
+    const uint8_t *p2 = pager_page_data(a, 2);
+    ASSERT_EQ(p2[99], file_byte(&node, 2 * PAGE_SIZE + 99));
+    ASSERT_EQ(p2[100], 0);  /* Tail of the last page is zeroed */
+    ASSERT_TRUE(pager_page_data(a, 3) == NULL);
+
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.hits, 1);
+    ASSERT_EQ(st.misses, 1);
+    ASSERT_EQ(st.files, 1);
+    ASSERT_EQ(st.cached_pages, 3);
+
+    pager_put(a);
+    pager_put(b);
+    ASSERT_EQ(pages_live, 3);  /* Unused entries stay cached */
+    return 0;
+}
+
+static int test_open_rejects_bad_sizes(void) {
+    reset_pager();
+    PagerFile *f;
+    VfsNode empty = make_node(1, 0);
+    VfsNode huge = make_node(2, PAGER_MAX_FILE_SIZE + 1);
+    ASSERT_EQ(pager_open(&empty, &f), -EINVAL);
+    ASSERT_EQ(pager_open(&huge, &f), -EINVAL);
+    ASSERT_EQ(vfs_read_calls, 0);
+    return 0;
+}
+
+static int test_open_failure_frees_frames(void) {
+    reset_pager();
+    int before = pages_live;
+    VfsNode node = make_node(4, 3 * PAGE_SIZE);
+    PagerFile *f;
+
+    pmm_fail_after = 2;
+    ASSERT_EQ(pager_open(&node, &f), -ENOMEM);
+    ASSERT_EQ(pages_live, before);
+
+    pmm_fail_after = -1;
+    vfs_read_fail = 1;
+    ASSERT_EQ(pager_open(&node, &f), -EIO);
+    ASSERT_EQ(pages_live, before);
+
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.files, 0);
+    return 0;
+}
+
+static int test_written_file_is_reread(void) {
+    reset_pager();
+    int before = pages_live;
+    VfsNode node = make_node(5, PAGE_SIZE);
+
+    PagerFile *old, *fresh;
+    ASSERT_EQ(pager_open(&node, &old), 0);
+    node.data_gen++;
+    ASSERT_EQ(pager_open(&node, &fresh), 0);
+    ASSERT_TRUE(old != fresh);
+    ASSERT_EQ(((const uint8_t *)pager_page_data(fresh, 0))[0],
+              file_byte(&node, 0));
+
+    /* The stale copy lives on for its mapper, then goes with it */
+    ASSERT_EQ(pages_live, before + 2);
+    pager_put(old);
+    ASSERT_EQ(pages_live, before + 1);
+    pager_put(fresh);
+    ASSERT_EQ(pages_live, before + 1);
+    return 0;
+}
+
+static int test_full_cache_evicts_least_recent(void) {
+    reset_pager();
+    static VfsNode nodes[PAGER_MAX_FILES + 1];
+    PagerFile *f;
+    for (int i = 0; i <= PAGER_MAX_FILES; i++) {
+        nodes[i] = make_node((uint64_t)i + 10, PAGE_SIZE);
+    }
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        ASSERT_EQ(pager_open(&nodes[i], &f), 0);
+        pager_put(f);
+    }
+    /* Touch the oldest; the second-oldest becomes the victim */
+    ASSERT_EQ(pager_open(&nodes[0], &f), 0);
+    pager_put(f);
+    ASSERT_EQ(pager_open(&nodes[PAGER_MAX_FILES], &f), 0);
+    pager_put(f);
+
+    int reads = vfs_read_calls;
+    ASSERT_EQ(pager_open(&nodes[0], &f), 0);
+    pager_put(f);
+    ASSERT_EQ(vfs_read_calls, reads);
+    ASSERT_EQ(pager_open(&nodes[1], &f), 0);
+    pager_put(f);
+    ASSERT_EQ(vfs_read_calls, reads + 1);
+    return 0;
+}
+
+static int test_mapped_entries_are_not_evicted(void) {
+    reset_pager();
+    static VfsNode nodes[PAGER_MAX_FILES + 1];
+    static PagerFile *held[PAGER_MAX_FILES];
+    for (int i = 0; i <= PAGER_MAX_FILES; i++) {
+        nodes[i] = make_node((uint64_t)i + 40, PAGE_SIZE);
+    }
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        ASSERT_EQ(pager_open(&nodes[i], &held[i]), 0);
+    }
+
+    /* No slot to take: the new file works but is not cached */
+    PagerFile *extra;
+    ASSERT_EQ(pager_open(&nodes[PAGER_MAX_FILES], &extra), 0);
+    ASSERT_EQ(extra->cached, 0);
+    int before = pages_live;
+    pager_put(extra);
+    ASSERT_EQ(pages_live, before - 1);
+
+    for (int i = 0; i < PAGER_MAX_FILES; i++) {
+        ASSERT_EQ(held[i]->cached, 1);
+        pager_put(held[i]);
+    }
+    return 0;
+}
+
+static int test_map_copy_and_release_refs(void) {
+    reset_pager();
+    VfsNode node = make_node(6, PAGE_SIZE);
+    ElfMap a, b;
+    memset(&a, 0, sizeof(a));
+    ASSERT_EQ(pager_open(&node, &a.file), 0);
+    a.nsegs = 1;
+
+    pager_map_copy(&b, &a);
+    ASSERT_TRUE(b.file == a.file);
+    ASSERT_EQ(a.file->refs, 2);
+    PagerFile *f = a.file;
+    pager_map_release(&a);
+    ASSERT_TRUE(a.file == NULL);
+    ASSERT_EQ(a.nsegs, 0);
+    ASSERT_EQ(f->refs, 1);
+    pager_map_release(&b);
+    ASSERT_EQ(f->refs, 0);
+
+    /* Releasing an empty map is harmless */
+    pager_map_release(&a);
+    return 0;
+}
+
+/* --- Faults --- */
+
+/* File layout: page 0 headers, page 1 text, page 2 data (+ 0x100 into 3) */
+static int open_image(VfsNode *node, ElfMap *map) {
+    *node = make_node(7, 3 * PAGE_SIZE + 0x100);
+    memset(map, 0, sizeof(*map));
+    int err = pager_open(node, &map->file);
+    map->segs[0] = make_seg(0x401000, 0x1000, 0x1000, 0x1000, PF_R | PF_X);
+    map->segs[1] = make_seg(0x402000, 0x2000, 0x1100, 0x3000, PF_R | PF_W);
+    map->nsegs = 2;
+    return err;
+}
+
+static int test_fault_text_maps_cached_frame(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x401234, 0), 0);
+    ASSERT_EQ(mapped_pml4, 0x9000);
+    ASSERT_EQ(mapped_virt, 0x401000);
+    ASSERT_EQ(mapped_phys, map.file->pages[1]);
+    ASSERT_EQ(mapped_flags, VMM_FLAG_USER | VMM_FLAG_SHARED);
+
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.shared_faults, 1);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_fault_data_read_maps_cow(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x402010, 0), 0);
+    ASSERT_EQ(mapped_phys, map.file->pages[2]);
+    ASSERT_EQ(mapped_flags, VMM_FLAG_USER | VMM_FLAG_NOEXEC |
+                            VMM_FLAG_COW | VMM_FLAG_SHARED);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_fault_data_write_copies(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x402010, 1), 0);
+    ASSERT_NEQ(mapped_phys, map.file->pages[2]);
+    ASSERT_EQ(mapped_flags, VMM_FLAG_USER | VMM_FLAG_WRITABLE | VMM_FLAG_NOEXEC);
+    ASSERT_MEM_EQ((const void *)mapped_phys, pager_page_data(map.file, 2),
+                  PAGE_SIZE);
+    pmm_free_page(mapped_phys);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_fault_bss_gets_private_frame(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+
+    /* Page mixing the last 0x100 file bytes with BSS */
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x403000, 0), 0);
+    const uint8_t *page = (const uint8_t *)mapped_phys;
+    ASSERT_EQ(page[0xFF], file_byte(&node, 0x30FF));
+    ASSERT_EQ(page[0x100], 0);
+    pmm_free_page(mapped_phys);
+
+    /* Pure BSS */
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x404800, 1), 0);
+    page = (const uint8_t *)mapped_phys;
+    ASSERT_EQ(page[0], 0);
+    ASSERT_EQ(page[PAGE_SIZE - 1], 0);
+    pmm_free_page(mapped_phys);
+
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.private_faults, 2);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_fault_unaligned_segment_copies(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+    /* File offset not congruent with vaddr: no frame can be shared */
+    map.segs[0] = make_seg(0x401000, 0x1010, 0x800, 0x800, PF_R | PF_X);
+
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x401000, 0), 0);
+    ASSERT_NEQ(mapped_phys, map.file->pages[1]);
+    ASSERT_EQ(((const uint8_t *)mapped_phys)[0], file_byte(&node, 0x1010));
+    ASSERT_EQ(((const uint8_t *)mapped_phys)[0x800], 0);
+    pmm_free_page(mapped_phys);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_fault_rejects_bad_access(void) {
+    reset_pager();
+    VfsNode node;
+    ElfMap map;
+    ASSERT_EQ(open_image(&node, &map), 0);
+
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x401000, 1), -EFAULT);  /* Text */
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x400000, 0), -EFAULT);  /* Gap */
+    ASSERT_EQ(pager_fault(0x9000, &map, 0x405000, 0), -EFAULT);  /* Past end */
+    ASSERT_EQ(map_calls, 0);
+    pager_map_release(&map);
+    return 0;
+}
+
+static int test_page_fault_handler_paths(void) {
+    reset_pager();
+    pager_init();
+    ASSERT_TRUE(pf_handler != NULL);
+
+    Process parent, child;
+    memset(&parent, 0, sizeof(parent));
+    memset(&child, 0, sizeof(child));
+    VfsNode node;
+    ASSERT_EQ(open_image(&node, &parent.image.map), 0);
+    parent.page_table = 0x9000;
+    child.page_table = 0x9000;
+    child.vfork_parent = &parent;
+
+    /* vfork child faults through the parent's map */
+    test_current_proc = &child;
+    fake_cr3 = 0x9000 | 0x18;
+    fake_cr2 = 0x401008;
+    InterruptFrame f = { .vector = EXCEPTION_PAGE_FAULT, .error_code = 0 };
+    pf_handler(&f);
+    ASSERT_EQ(unhandled_calls, 0);
+    ASSERT_EQ(mapped_virt, 0x401000);
+
+    /* Addresses outside the program fall through to its interpreter */
+    ASSERT_EQ(open_image(&node, &parent.image.interp), 0);
+    parent.image.interp.segs[0].vaddr += 0x7E0000000000ULL;
+    fake_cr2 = 0x7E0000401010ULL;
+    pf_handler(&f);
+    ASSERT_EQ(unhandled_calls, 0);
+    ASSERT_EQ(mapped_virt, 0x7E0000401000ULL);
+    ASSERT_EQ(mapped_phys, parent.image.interp.file->pages[1]);
+
+    /* Present + write: copy-on-write */
+    fake_cr2 = 0x402000;
+    f.error_code = PFERR_PRESENT | PFERR_WRITE;
+    pf_handler(&f);
+    ASSERT_EQ(resolve_cow_calls, 1);
+    ASSERT_EQ(unhandled_calls, 0);
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.cow_copies, 1);
+
+    /* Present read (protection fault), kernel address, foreign CR3 */
+    f.error_code = PFERR_PRESENT;
+    pf_handler(&f);
+    ASSERT_EQ(unhandled_calls, 1);
+    f.error_code = 0;
+    fake_cr2 = 0xFFFF800000001000ULL;
+    pf_handler(&f);
+    ASSERT_EQ(unhandled_calls, 2);
+    fake_cr2 = 0x401008;
+    fake_cr3 = 0xA000;
+    pf_handler(&f);
+    ASSERT_EQ(unhandled_calls, 3);
+
+    pager_map_release(&parent.image.map);
+    pager_map_release(&parent.image.interp);
+    return 0;
+}
+
+static int test_stats_count_shared_libraries(void) {
+    reset_pager();
+    VfsNode prog = make_node(8, PAGE_SIZE);
+    VfsNode lib = make_node(9, 5 * PAGE_SIZE);
+    PagerFile *p, *l1, *l2;
+    ASSERT_EQ(pager_open(&prog, &p), 0);
+    ASSERT_EQ(pager_open(&lib, &l1), 0);
+    pager_mark_library(l1);
+    ASSERT_EQ(pager_open(&lib, &l2), 0);
+
+    PagerStats st;
+    pager_get_stats(&st);
+    ASSERT_EQ(st.files, 2);
+    ASSERT_EQ(st.cached_pages, 6);
+    ASSERT_EQ(st.lib_files, 1);
+    ASSERT_EQ(st.lib_pages, 5);
+    ASSERT_EQ(st.lib_maps, 2);
+
+    pager_put(p);
+    pager_put(l1);
+    pager_put(l2);
+    pager_get_stats(&st);
+    ASSERT_EQ(st.lib_maps, 0);
+    return 0;
+}
+
+TestCase pager_tests[] = {
+    { "open_reads_file_once",         test_open_reads_file_once },
+    { "open_rejects_bad_sizes",       test_open_rejects_bad_sizes },
+    { "open_failure_frees_frames",    test_open_failure_frees_frames },
+    { "written_file_is_reread",       test_written_file_is_reread },
+    { "full_cache_evicts_least_recent", test_full_cache_evicts_least_recent },
+    { "mapped_entries_are_not_evicted", test_mapped_entries_are_not_evicted },
+    { "map_copy_and_release_refs",    test_map_copy_and_release_refs },
+    { "fault_text_maps_cached_frame", test_fault_text_maps_cached_frame },
+    { "fault_data_read_maps_cow",     test_fault_data_read_maps_cow },
+    { "fault_data_write_copies",      test_fault_data_write_copies },
+    { "fault_bss_gets_private_frame", test_fault_bss_gets_private_frame },
+    { "fault_unaligned_segment_copies", test_fault_unaligned_segment_copies },
+    { "fault_rejects_bad_access",     test_fault_rejects_bad_access },
+    { "page_fault_handler_paths",     test_page_fault_handler_paths },
+    { "stats_count_shared_libraries", test_stats_count_shared_libraries },
+};
+
+int pager_test_count = sizeof(pager_tests) / sizeof(pager_tests[0]);
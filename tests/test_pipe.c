@@ -56,6 +56,11 @@ typedef struct {
     int      (*unlink)(VfsNode *dir, const char *name);
     int      (*readdir)(VfsNode *dir, void *entries, uint32_t max);
     void     (*truncate)(VfsNode *node, uint64_t size);
+    int      (*sync)(VfsNode *node);
+    void     (*readahead)(VfsNode *node, uint64_t offset, uint32_t size);
+    int      (*readdir_at)(VfsNode *dir, uint64_t *cursor, void *entries, uint32_t max);
+    void     (*ref)(VfsNode *node);
+    void     (*unref)(VfsNode *node);
 } VfsOps;
 
 struct VfsNode {
@@ -245,6 +250,25 @@ TEST(addref_write_end) {
     return 0;
 }
 
+TEST(ops_ref_hooks_count_ends) {
+    VfsNode *r, *w;
+    pipe_create(&r, &w);
+    PipeNode *pipe = to_pipe(r);
+
+    /* The fd layer takes and drops references through the ops */
+    w->ops->ref(w);
+    ASSERT_EQ(pipe->writer_count, 2);
+    w->ops->unref(w);
+    ASSERT_EQ(pipe->writer_count, 1);
+    r->ops->ref(r);
+    ASSERT_EQ(pipe->reader_count, 2);
+    r->ops->unref(r);
+
+    pipe_close(w);
+    pipe_close(r);
+    return 0;
+}
+
 TEST(multiple_small_writes) {
     VfsNode *r, *w;
     pipe_create(&r, &w);
@@ -323,6 +347,7 @@ TestCase pipe_tests[] = {
     TEST_ENTRY(fill_buffer_exact),
     TEST_ENTRY(addref_prevents_early_free),
     TEST_ENTRY(addref_write_end),
+    TEST_ENTRY(ops_ref_hooks_count_ends),
     TEST_ENTRY(multiple_small_writes),
     TEST_ENTRY(partial_read),
     TEST_ENTRY(zero_length_read),
@@ -0,0 +1,224 @@
+/* arc_os — Host-side tests for kernel/proc/preempt.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_ARCH_X86_64_TSC_H
+
+/* Minimal Thread: only the counters that block preemption are used */
+typedef struct Thread {
+    uint32_t tid;
+    uint32_t rcu_read_depth;
+    uint32_t preempt_count;
+} Thread;
+
+static Thread test_thread;
+static Thread *test_current_thread = &test_thread;
+static Thread *thread_current(void) { return test_current_thread; }
+
+/* IRQ helpers: a settable interrupt flag instead of RFLAGS */
+static uint64_t test_rflags;
+static int irq_windows;
+
+static uint64_t spin_irq_save(void) {
+    uint64_t flags = test_rflags;
+    test_rflags = 0;
+    return flags;
+}
+
+static void spin_irq_restore(uint64_t flags) { test_rflags = flags; }
+
+/* A window delivers the pending tick, which may request a reschedule */
+static int window_sets_resched;
+void set_need_resched(uint64_t due_tsc);
+
+static void irq_window(void) {
+    irq_windows++;
+    if (window_sets_resched) set_need_resched(1);
+}
+
+/* TSC stub: a settable clock, 1 cycle = 1 ns */
+static uint64_t test_tsc = 1;
+static uint64_t tsc_read(void) { return test_tsc; }
+static uint64_t tsc_to_ns(uint64_t cycles) { return cycles; }
+
+/* sched_yield stub: record the switch and the flags it ran under */
+static int yield_count;
+static uint64_t yield_rflags;
+
+static void test_sched_yield(void) {
+    yield_count++;
+    yield_rflags = test_rflags;
+}
+#define sched_yield test_sched_yield
+
+#include "../kernel/proc/preempt.c"
+
+#undef sched_yield
+
+static void reset_preempt_state(void) {
+    memset(&test_thread, 0, sizeof(test_thread));
+    test_current_thread = &test_thread;
+    test_rflags = RFLAGS_IF;
+    irq_windows = 0;
+    window_sets_resched = 0;
+    test_tsc = 1000;                        /* Requests due at 1 wait 999 ns */
+    yield_count = 0;
+    yield_rflags = 0;
+    preempt_need_resched = 0;
+    resched_due_tsc = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* --- Tests --- */
+
+TEST(preempt_count_nests) {
+    reset_preempt_state();
+    preempt_disable();
+    preempt_disable();
+    ASSERT_EQ(preempt_count(), 2);
+    preempt_enable();
+    ASSERT_EQ(preempt_count(), 1);
+    preempt_enable();
+    ASSERT_EQ(preempt_count(), 0);
+    ASSERT_EQ(yield_count, 0);
+
+    /* No thread yet (early boot): nothing to count */
+    test_current_thread = NULL;
+    preempt_disable();
+    ASSERT_EQ(preempt_count(), 0);
+    preempt_enable();
+    return 0;
+}
+
+TEST(preempt_enable_honours_pending_resched) {
+    reset_preempt_state();
+    preempt_disable();
+    preempt_disable();
+    set_need_resched(1);
+
+    /* Still nested: the request waits */
+    preempt_enable();
+    ASSERT_EQ(yield_count, 0);
+
+    preempt_enable();
+    ASSERT_EQ(yield_count, 1);
+    ASSERT_EQ(yield_rflags, 0);            /* Switched with interrupts off */
+    ASSERT_EQ(test_rflags, RFLAGS_IF);     /* And restored them */
+    ASSERT_EQ(preempt_need_resched, 0);
+    ASSERT_STR_EQ(stats.max_site, "preempt_enable");
+    return 0;
+}
+
+TEST(preempt_enable_with_irqs_off_defers) {
+    reset_preempt_state();
+    test_rflags = 0;                        /* Inside a system call */
+    preempt_disable();
+    set_need_resched(1);
+    preempt_enable();
+    ASSERT_EQ(yield_count, 0);
+    ASSERT_EQ(preempt_need_resched, 1);
+
+    /* The system-call exit takes it */
+    preempt_syscall_exit();
+    ASSERT_EQ(yield_count, 1);
+    ASSERT_STR_EQ(stats.max_site, "syscall");
+    return 0;
+}
+
+TEST(irq_exit_respects_count_and_rcu) {
+    reset_preempt_state();
+    preempt_irq_exit();
+    ASSERT_EQ(yield_count, 0);              /* Nothing pending */
+
+    set_need_resched(1);
+    test_thread.preempt_count = 1;
+    preempt_irq_exit();
+    ASSERT_EQ(yield_count, 0);
+
+    test_thread.preempt_count = 0;
+    test_thread.rcu_read_depth = 1;
+    preempt_irq_exit();
+    ASSERT_EQ(yield_count, 0);
+
+    test_thread.rcu_read_depth = 0;
+    preempt_irq_exit();
+    ASSERT_EQ(yield_count, 1);
+    ASSERT_EQ(preempt_need_resched, 0);
+    return 0;
+}
+
+TEST(cond_resched_takes_pending_tick) {
+    reset_preempt_state();
+    test_rflags = 0;                        /* System call: interrupts off */
+
+    /* No tick pending: a window, but no switch */
+    cond_resched();
+    ASSERT_EQ(irq_windows, 1);
+    ASSERT_EQ(yield_count, 0);
+
+    window_sets_resched = 1;
+    cond_resched();
+    ASSERT_EQ(irq_windows, 2);
+    ASSERT_EQ(yield_count, 1);
+    ASSERT_EQ(test_rflags, 0);
+    ASSERT_STR_EQ(stats.max_site, "cond_resched");
+
+    /* Interrupts on: ticks arrive anyway, no window needed */
+    test_rflags = RFLAGS_IF;
+    set_need_resched(1);
+    cond_resched();
+    ASSERT_EQ(irq_windows, 2);
+    ASSERT_EQ(yield_count, 2);
+
+    /* Not a preemption point while a spinlock is held */
+    test_thread.preempt_count = 1;
+    set_need_resched(1);
+    cond_resched();
+    ASSERT_EQ(yield_count, 2);
+    return 0;
+}
+
+TEST(tracer_records_longest_wait) {
+    reset_preempt_state();
+    set_need_resched(100);
+    test_tsc = 150;
+    set_need_resched(140);                  /* Earlier request kept */
+    test_tsc = 400;
+    preempt_irq_exit();
+    ASSERT_EQ(stats.count, 1);
+    ASSERT_EQ(stats.max_ns, 300);
+    ASSERT_STR_EQ(stats.max_site, "irq");
+
+    /* A shorter wait does not replace the maximum */
+    set_need_resched(400);
+    test_tsc = 450;
+    preempt_syscall_exit();
+    ASSERT_EQ(stats.count, 2);
+    ASSERT_EQ(stats.max_ns, 300);
+    ASSERT_STR_EQ(stats.max_site, "irq");
+
+    /* Clearing with nothing pending is not a reschedule */
+    clear_need_resched("schedule");
+    PreemptStats st;
+    preempt_get_stats(&st);
+    ASSERT_EQ(st.count, 2);
+    ASSERT_EQ(st.max_ns, 300);
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase preempt_tests[] = {
+    TEST_ENTRY(preempt_count_nests),
+    TEST_ENTRY(preempt_enable_honours_pending_resched),
+    TEST_ENTRY(preempt_enable_with_irqs_off_defers),
+    TEST_ENTRY(irq_exit_respects_count_and_rcu),
+    TEST_ENTRY(cond_resched_takes_pending_tick),
+    TEST_ENTRY(tracer_records_longest_wait),
+};
+int preempt_test_count = sizeof(preempt_tests) / sizeof(preempt_tests[0]);
@@ -17,14 +17,22 @@
 #define ARCHOS_ARCH_X86_64_USERMODE_H
 #define ARCHOS_ARCH_X86_64_GDT_H
 #define ARCHOS_ARCH_X86_64_SYSCALL_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
 #define ARCHOS_ARCH_X86_64_PAGING_H
 #define ARCHOS_FS_PATH_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_RCU_H
+#define ARCHOS_PROC_PAGER_H
+#define ARCHOS_PROC_MMAP_H
+#define ARCHOS_IPC_ENDPOINT_H
+#define ARCHOS_PROC_IO_RING_H
 
 /* Stub kprintf */
 static inline void kprintf(const char *fmt, ...) { (void)fmt; }
 #define KERNEL_PANIC() do { } while(0)
 
 #define EINVAL 22
+#define EAGAIN 11
 #define PATH_MAX 512
 
 /* Reproduce types (headers are guarded out) */
@@ -62,6 +70,8 @@ typedef struct Thread {
 #define PROC_TERMINATED  2
 #define PROC_STOPPED     3
 
+#define SIGCHLD 17
+
 typedef struct FdTable FdTable;
 
 /* Signal types stub */
@@ -96,7 +106,11 @@ static void sig_init(SigState *ss) {
 
 /* WaitQueue stub */
 typedef struct WaitQueue { int dummy; } WaitQueue;
+static int wq_wake_all_count;
 static void wq_init(WaitQueue *wq) { (void)wq; }
+static int wq_wake_all(WaitQueue *wq) { (void)wq; wq_wake_all_count++; return 0; }
+static int wq_wake_count;
+static int wq_wake(WaitQueue *wq) { (void)wq; wq_wake_count++; return 0; }
 
 /* Saved user context for fork */
 typedef struct ForkContext {
@@ -111,6 +125,24 @@ typedef struct ForkContext {
     uint64_t user_r15;
 } ForkContext;
 
+/* Exec page-cache mapping: only the file reference matters here */
+struct PagerFile;
+typedef struct {
+    struct PagerFile *file;
+    uint32_t          nsegs;
+} ElfMap;
+
+typedef struct UserImage {
+    uint64_t pml4;
+    uint64_t entry;
+    uint64_t user_rsp;
+    uint64_t argc;
+    uint64_t argv;
+    uint64_t brk_start;
+    ElfMap   map;
+    ElfMap   interp;
+} UserImage;
+
 typedef struct Process {
     pid_t           pid;
     pid_t           pgid;
@@ -129,6 +161,11 @@ typedef struct Process {
     uint32_t        umask;
     SigState        sig;
     WaitQueue       child_exit_wq;
+    ForkContext     fork_ctx;
+    UserImage       image;
+    struct Process *vfork_parent;
+    WaitQueue       vfork_wq;
+    struct IoRing  *io_ring;
     struct Process *parent;
     struct Process *next;
 } Process;
@@ -138,13 +175,50 @@ static uint64_t vmm_create_user_pml4(void) { return 0x300000; }
 static void vmm_destroy_user_pml4(uint64_t pml4) { (void)pml4; }
 static uint64_t vmm_fork_address_space(uint64_t src) { (void)src; return 0x400000; }
 
+/* Pager stubs: count references held on the mapped file */
+static int pager_refs;
+static void pager_map_copy(ElfMap *dst, const ElfMap *src) {
+    *dst = *src;
+    if (dst->file != NULL) pager_refs++;
+}
+static void pager_map_release(ElfMap *map) {
+    if (map->file != NULL) pager_refs--;
+    memset(map, 0, sizeof(*map));
+}
+
+/* mmap stubs: no shared mappings */
+static int mmap_fork(Process *child, const Process *parent) {
+    (void)child; (void)parent;
+    return 0;
+}
+static void mmap_release(Process *p) { (void)p; }
+
 /* FD stubs */
 static FdTable *fd_table_dup(const FdTable *src) { (void)src; return NULL; }
+static int fd_close_all_count;
+static void fd_table_close_all(FdTable *ft) { (void)ft; fd_close_all_count++; }
+
+/* Exit stubs: record the teardown steps */
+static void ipc_thread_exit(Thread *t) { (void)t; }
+static Process *io_ring_released;
+static int io_ring_release(Process *p, int busy_check) {
+    (void)busy_check;
+    io_ring_released = p;
+    return 0;
+}
+static int sig_send_signo;
+static int sig_send(uint32_t pid, int signo) { (void)pid; sig_send_signo = signo; return 0; }
 
 /* Arch stubs */
 static void gdt_set_kernel_stack(uint64_t rsp0) { (void)rsp0; }
 static void paging_write_cr3(uint64_t cr3) { (void)cr3; }
-static uint64_t syscall_kernel_rsp;
+/* Minimal PerCpu: only the SYSCALL kernel stack is used */
+typedef struct {
+    uint64_t kernel_rsp;
+} PerCpu;
+
+static PerCpu test_cpu;
+static PerCpu *this_cpu(void) { return &test_cpu; }
 __attribute__((noreturn))
 static void fork_return_to_user(const ForkContext *ctx) {
     (void)ctx;
@@ -152,6 +226,12 @@ static void fork_return_to_user(const ForkContext *ctx) {
     for (;;) {}
 }
 
+__attribute__((noreturn))
+static void jump_to_usermode(uint64_t entry, uint64_t rsp, uint64_t argc, uint64_t argv) {
+    (void)entry; (void)rsp; (void)argc; (void)argv;
+    for (;;) {}
+}
+
 /* Allocation flags */
 #define GFP_KERNEL  0x00
 #define GFP_ZERO    0x01
@@ -215,6 +295,10 @@ static Thread *thread_create(thread_entry_t entry, void *arg) {
     return t;
 }
 
+static void sched_fork(Thread *child, const Thread *parent) {
+    (void)child; (void)parent;
+}
+
 /* Tracking sched_add_thread stub (static to avoid linker clash) */
 static int sched_add_call_count;
 static Thread *sched_add_last_thread;
@@ -225,6 +309,9 @@ static void sched_add_thread(Thread *t) {
     t->state = THREAD_READY;
 }
 
+static int sched_yield_count;
+static void sched_yield(void) { sched_yield_count++; }
+
 /* Forward-declare process.c public functions (since we guarded process.h) */
 void proc_init(void);
 Process *proc_create(thread_entry_t entry, void *arg);
@@ -238,6 +325,35 @@ Process *proc_find_zombie_child(Process *parent);
 int proc_reap(Process *child, int32_t *status_out);
 int proc_has_children(Process *parent);
 
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* vfork tests park the parent here; the "child" releases it */
+static struct Process *vfork_sleep_child;
+static void proc_vfork_release(struct Process *p);
+static void wq_sleep(WaitQueue *wq, Spinlock *lock) {
+    (void)wq;
+    spinlock_release(lock);
+    if (vfork_sleep_child) proc_vfork_release(vfork_sleep_child);
+}
+
+/* RCU stubs — single-threaded tests have no concurrent readers */
+static int rcu_read_depth;
+static inline void rcu_read_lock(void) { rcu_read_depth++; }
+static inline void rcu_read_unlock(void) { rcu_read_depth--; }
+#define rcu_dereference(p)        (p)
+#define rcu_assign_pointer(p, v)  ((p) = (v))
+static int synchronize_rcu_count;
+static void synchronize_rcu(void) { synchronize_rcu_count++; }
+
 /* Include the real process.c */
 #include "../kernel/proc/process.c"
 
@@ -269,6 +385,14 @@ static void reset_proc_state(void) {
 
     sched_add_call_count = 0;
     sched_add_last_thread = NULL;
+    synchronize_rcu_count = 0;
+    pager_refs = 0;
+    wq_wake_count = 0;
+    wq_wake_all_count = 0;
+    fd_close_all_count = 0;
+    io_ring_released = NULL;
+    sig_send_signo = 0;
+    sched_yield_count = 0;
 
     setup_boot_thread();
 }
@@ -464,6 +588,174 @@ static int test_current_after_thread_switch(void) {
     return 0;
 }
 
+static int test_get_by_pid_finds_live(void) {
+    reset_proc_state();
+    proc_init();
+    Process *p1 = proc_create((thread_entry_t)0xDEAD, NULL);
+    ASSERT_TRUE(proc_get_by_pid(p1->pid) == p1);
+    ASSERT_TRUE(proc_get_by_pid(0) != NULL);
+    ASSERT_TRUE(proc_get_by_pid(99) == NULL);
+    ASSERT_EQ(rcu_read_depth, 0);
+
+    p1->state = PROC_TERMINATED;
+    ASSERT_TRUE(proc_get_by_pid(p1->pid) == NULL);
+    return 0;
+}
+
+static int test_fork_thread_failure_unpublishes(void) {
+    reset_proc_state();
+    proc_init();
+    Process *parent = proc_current();
+    parent->page_table = 0x1000;
+    parent->image.map.file = (struct PagerFile *)0xF11E;
+    parent->image.interp.file = (struct PagerFile *)0x11B;
+
+    ForkContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    thread_create_force_fail = 1;
+    ASSERT_TRUE(proc_fork(parent, &ctx) == NULL);
+
+    /* The references the child took on the binary and library were dropped */
+    ASSERT_EQ(pager_refs, 0);
+
+    /* Child PCB unlinked and a grace period waited before it was freed */
+    ASSERT_EQ(synchronize_rcu_count, 1);
+    ASSERT_TRUE(proc_get_by_pid(1) == NULL);
+    ASSERT_TRUE(proc_list == parent);
+    return 0;
+}
+
+static int test_attach_thread_shares_process(void) {
+    reset_proc_state();
+    proc_init();
+    Process *p1 = proc_create((thread_entry_t)0xDEAD, NULL);
+
+    Thread helper = { .tid = 5 };
+    ASSERT_EQ(proc_attach_thread(p1, &helper), 0);
+    test_current_thread = &helper;
+    ASSERT_TRUE(proc_current() == p1);
+    ASSERT_TRUE(p1->main_thread != &helper);
+
+    /* Unmappable tid: the caller must not run the thread */
+    Thread far = { .tid = MAX_PROCESSES };
+    ASSERT_EQ(proc_attach_thread(p1, &far), -EAGAIN);
+    return 0;
+}
+
+static int test_vfork_shares_address_space(void) {
+    reset_proc_state();
+    proc_init();
+    Process *parent = proc_current();
+    parent->page_table = 0x1000;
+    parent->brk_start = parent->brk_current = 0x500000;
+    parent->image.map.file = (struct PagerFile *)0xF11E;
+
+    ForkContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.user_rip = 0x401000;
+    Process *child = proc_vfork(parent, &ctx);
+    ASSERT_TRUE(child != NULL);
+    ASSERT_EQ(child->page_table, 0x1000);
+    ASSERT_EQ(child->brk_current, 0x500000);
+    ASSERT_TRUE(child->vfork_parent == parent);
+    ASSERT_TRUE(child->image.map.file == NULL);  /* Faults use the parent's */
+    ASSERT_EQ(pager_refs, 0);
+    ASSERT_EQ(child->fork_ctx.user_rip, 0x401000);
+    ASSERT_EQ(sched_add_call_count, 1);
+
+    /* Parent sleeps until the child lets go */
+    vfork_sleep_child = child;
+    wq_wake_all_count = 0;
+    proc_vfork_wait(child);
+    vfork_sleep_child = NULL;
+    ASSERT_TRUE(child->vfork_parent == NULL);
+    ASSERT_EQ(wq_wake_all_count, 1);
+
+    /* Releasing again (exit after exec) is a no-op */
+    proc_vfork_release(child);
+    ASSERT_EQ(wq_wake_all_count, 1);
+    return 0;
+}
+
+static int test_exit_leaves_zombie(void) {
+    reset_proc_state();
+    proc_init();
+    Process *parent = proc_current();
+    ForkContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    parent->page_table = 0x1000;
+    Process *child = proc_vfork(parent, &ctx);
+    ASSERT_TRUE(child != NULL);
+    child->fd_table = (FdTable *)0xF00D;
+
+    /* A signal death goes through here too: the vfork parent must wake */
+    proc_exit(child, 128 + 9);
+    ASSERT_EQ(child->state, PROC_ZOMBIE);
+    ASSERT_EQ(child->exit_status, 128 + 9);
+    ASSERT_EQ(fd_close_all_count, 1);
+    ASSERT_TRUE(io_ring_released == child);  /* Ring workers stop */
+    ASSERT_TRUE(child->vfork_parent == NULL);
+    ASSERT_EQ(wq_wake_all_count, 1);
+    ASSERT_EQ(wq_wake_count, 1);
+    ASSERT_EQ(sig_send_signo, SIGCHLD);
+    ASSERT_EQ(boot_thread.state, THREAD_DEAD);
+    ASSERT_EQ(sched_yield_count, 1);
+    return 0;
+}
+
+static int test_exit_drops_image_refs(void) {
+    reset_proc_state();
+    proc_init();
+    Process *p = proc_current();
+    p->image.map.file = (struct PagerFile *)0xF11E;
+    p->image.interp.file = (struct PagerFile *)0xF00E;
+    pager_refs = 2;
+
+    proc_exit(p, 128 + 15);
+    ASSERT_EQ(pager_refs, 0);
+    ASSERT_TRUE(p->image.map.file == NULL);
+    ASSERT_TRUE(p->image.interp.file == NULL);
+    return 0;
+}
+
+static int test_spawn_enters_image(void) {
+    reset_proc_state();
+    proc_init();
+    Process *parent = proc_current();
+    parent->uid = parent->euid = 7;
+    parent->pgid = 3;
+
+    UserImage img = { .pml4 = 0x9000, .entry = 0x400080, .user_rsp = 0x7FF0,
+                      .argc = 2, .argv = 0x7FF8, .brk_start = 0x600000 };
+    FdTable *fds = (FdTable *)0xF00D;
+    Process *child = proc_spawn(parent, &img, fds);
+    ASSERT_TRUE(child != NULL);
+    ASSERT_EQ(child->page_table, 0x9000);
+    ASSERT_EQ(child->brk_start, 0x600000);
+    ASSERT_EQ(child->brk_current, 0x600000);
+    ASSERT_TRUE(child->fd_table == fds);
+    ASSERT_EQ(child->image.entry, 0x400080);
+    ASSERT_EQ(child->euid, 7);
+    ASSERT_EQ(child->pgid, 3);
+    ASSERT_TRUE(child->parent == parent);
+    ASSERT_TRUE(child->vfork_parent == NULL);
+    ASSERT_TRUE(sched_add_last_thread == child->main_thread);
+    return 0;
+}
+
+static int test_spawn_thread_failure_unpublishes(void) {
+    reset_proc_state();
+    proc_init();
+    Process *parent = proc_current();
+    UserImage img = { .pml4 = 0x9000 };
+
+    thread_create_force_fail = 1;
+    ASSERT_TRUE(proc_spawn(parent, &img, NULL) == NULL);
+    ASSERT_EQ(synchronize_rcu_count, 1);
+    ASSERT_TRUE(proc_list == parent);
+    return 0;
+}
+
 /* --- Test suite export --- */
 
 TestCase process_tests[] = {
@@ -482,6 +774,14 @@ TestCase process_tests[] = {
     { "max_processes_boundary",     test_max_processes_boundary },
     { "parent_null_by_default",     test_parent_null_by_default },
     { "current_after_thread_switch", test_current_after_thread_switch },
+    { "get_by_pid_finds_live",      test_get_by_pid_finds_live },
+    { "fork_thread_failure_unpublishes", test_fork_thread_failure_unpublishes },
+    { "attach_thread_shares_process", test_attach_thread_shares_process },
+    { "vfork_shares_address_space", test_vfork_shares_address_space },
+    { "exit_leaves_zombie",         test_exit_leaves_zombie },
+    { "exit_drops_image_refs",      test_exit_drops_image_refs },
+    { "spawn_enters_image",         test_spawn_enters_image },
+    { "spawn_thread_failure_unpublishes", test_spawn_thread_failure_unpublishes },
 };
 
 int process_test_count = sizeof(process_tests) / sizeof(process_tests[0]);
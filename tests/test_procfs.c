@@ -12,10 +12,17 @@
 #define ARCHOS_MM_KMALLOC_H
 #define ARCHOS_ARCH_X86_64_PIT_H
 #define ARCHOS_PROC_PROCESS_H
+#define ARCHOS_PROC_FD_H
 #define ARCHOS_PROC_THREAD_H
 #define ARCHOS_PROC_SIGNAL_H
 #define ARCHOS_PROC_WAITQUEUE_H
 #define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_PAGER_H
+#define ARCHOS_FS_SHMFS_H
+#define ARCHOS_FS_BCACHE_H
+#define ARCHOS_DRIVERS_BLKDEV_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_PREEMPT_H
 #define ARCHOS_LIB_MEM_H
 #define ARCHOS_LIB_STRING_H
 
@@ -67,12 +74,67 @@ typedef struct {
     size_t heap_mapped;
 } HeapStats;
 
+/* PagerStats type (only the fields meminfo reports are set) */
+typedef struct {
+    uint32_t files;
+    uint64_t cached_pages;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t shared_faults;
+    uint64_t private_faults;
+    uint64_t cow_copies;
+    uint32_t lib_files;
+    uint64_t lib_pages;
+    uint32_t lib_maps;
+} PagerStats;
+
 /* Process states */
 #define PROC_ALIVE       0
 #define PROC_ZOMBIE      1
 #define PROC_TERMINATED  2
 #define PROC_STOPPED     3
 
+/* Scheduling policies and the Thread fields /proc/[pid]/sched reports */
+#define SCHED_NORMAL  0
+#define SCHED_FIFO    1
+#define SCHED_RR      2
+#define SCHED_LAT_BUCKETS  6
+
+typedef struct {
+    uint64_t count;
+    uint64_t max_ns;
+    uint32_t buckets[SCHED_LAT_BUCKETS];
+} SchedLatency;
+
+typedef struct Thread {
+    uint8_t      policy;
+    uint8_t      rt_priority;
+    uint8_t      prio;
+    SchedLatency latency;
+} Thread;
+
+/* Open files (match vfs.h, fd.h): only the readahead statistics */
+#define MAX_FDS 64
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytes;
+} VfsReadahead;
+
+typedef struct {
+    VfsReadahead ra;
+} VfsFile;
+
+typedef struct {
+    VfsFile file;
+    uint8_t in_use;
+} FdEntry;
+
+typedef struct FdTable {
+    FdEntry entries[MAX_FDS];
+} FdTable;
+
 /* Minimal Process struct — only fields procfs accesses */
 typedef struct Process {
     uint32_t        pid;
@@ -80,6 +142,8 @@ typedef struct Process {
     uint8_t         state;
     uint32_t        uid;
     uint32_t        gid;
+    Thread         *main_thread;
+    FdTable        *fd_table;
     struct Process *parent;
     struct Process *next;
 } Process;
@@ -98,6 +162,14 @@ static HeapStats stub_heap_stats = {
     .heap_mapped = 16384,
 };
 
+static PagerStats stub_pager_stats = {
+    .files = 3,
+    .cached_pages = 40,
+    .lib_files = 1,
+    .lib_pages = 25,
+    .lib_maps = 6,
+};
+
 /* Test processes */
 static Process test_procs[4];
 static int test_proc_count = 0;
@@ -137,6 +209,63 @@ static void kmalloc_get_stats(HeapStats *out) {
     *out = stub_heap_stats;
 }
 
+static void pager_get_stats(PagerStats *out) {
+    *out = stub_pager_stats;
+}
+
+/* ShmfsStats type (match shmfs.h) */
+typedef struct {
+    uint32_t objects;
+    uint64_t pages;
+    uint32_t maps;
+} ShmfsStats;
+
+static void shmfs_get_stats(ShmfsStats *out) {
+    out->objects = 2;
+    out->pages = 512;
+    out->maps = 3;
+}
+
+/* Block devices and BcacheStats (match blkdev.h, bcache.h): slot 1 only */
+#define BLKDEV_MAX 4
+typedef struct BlockDevice { int unused; } BlockDevice;
+static BlockDevice stub_disk;
+
+static BlockDevice *blkdev_get(int index) {
+    return (index == 1) ? &stub_disk : NULL;
+}
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;
+} BcacheStats;
+
+static void bcache_get_stats(const BlockDevice *dev, BcacheStats *out) {
+    out->hits = (dev == &stub_disk) ? 90 : 0;
+    out->misses = (dev == &stub_disk) ? 10 : 0;
+    out->writebacks = (dev == &stub_disk) ? 4 : 0;
+}
+
+static void bcache_get_usage(uint32_t *count, uint64_t *bytes, uint32_t *dirty) {
+    *count = 12;
+    *bytes = 12 * 4096;
+    *dirty = 3;
+}
+
+/* PreemptStats type (match preempt.h) */
+typedef struct {
+    uint64_t    count;
+    uint64_t    max_ns;
+    const char *max_site;
+} PreemptStats;
+
+static PreemptStats stub_preempt_stats;
+
+static void preempt_get_stats(PreemptStats *out) {
+    *out = stub_preempt_stats;
+}
+
 static Process *proc_get_by_pid(uint32_t pid) {
     for (int i = 0; i < test_proc_count; i++) {
         if (test_procs[i].pid == pid && test_procs[i].state != PROC_TERMINATED) {
@@ -226,6 +355,11 @@ TEST(meminfo_content) {
     ASSERT_TRUE(strstr(buf, "MemTotal:") != NULL);
     ASSERT_TRUE(strstr(buf, "MemFree:") != NULL);
     ASSERT_TRUE(strstr(buf, "HeapUsed:") != NULL);
+    ASSERT_TRUE(strstr(buf, "ExecCached: 160 kB\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "SharedLib: 100 kB\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "SharedLibMaps: 6\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Shmem: 2048 kB\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "ShmemObjects: 2\n") != NULL);
     return 0;
 }
 
@@ -258,6 +392,40 @@ TEST(uptime_content) {
     return 0;
 }
 
+TEST(preempt_content) {
+    stub_preempt_stats.count = 42;
+    stub_preempt_stats.max_ns = 1500000;
+    stub_preempt_stats.max_site = "cond_resched";
+    VfsNode *root = procfs_init();
+    VfsNode *n = root->ops->lookup(root, "preempt");
+    ASSERT_TRUE(n != NULL);
+
+    char buf[128] = {0};
+    int rd = n->ops->read(n, buf, 0, sizeof(buf) - 1);
+    ASSERT_TRUE(rd > 0);
+    ASSERT_STR_EQ(buf, "Preemptions: 42\nMaxLatency: 1500 us\nMaxSite: cond_resched\n");
+
+    /* No reschedule seen yet */
+    memset(&stub_preempt_stats, 0, sizeof(stub_preempt_stats));
+    memset(buf, 0, sizeof(buf));
+    n->ops->read(n, buf, 0, sizeof(buf) - 1);
+    ASSERT_STR_EQ(buf, "Preemptions: 0\nMaxLatency: 0 us\nMaxSite: none\n");
+    return 0;
+}
+
+TEST(bcache_content) {
+    VfsNode *root = procfs_init();
+    VfsNode *n = root->ops->lookup(root, "bcache");
+    ASSERT_TRUE(n != NULL);
+
+    char buf[256] = {0};
+    int rd = n->ops->read(n, buf, 0, sizeof(buf) - 1);
+    ASSERT_TRUE(rd > 0);
+    ASSERT_STR_EQ(buf, "Buffers: 12\nCached: 48 kB\nDirty: 3\n"
+                       "blk1: hits 90 misses 10 writebacks 4\n");
+    return 0;
+}
+
 TEST(pid_status_content) {
     setup_test_procs();
     VfsNode *root = procfs_init();
@@ -279,15 +447,76 @@ TEST(pid_status_content) {
     return 0;
 }
 
+TEST(pid_sched_content) {
+    setup_test_procs();
+    static Thread rt = {
+        .policy = SCHED_FIFO, .rt_priority = 40, .prio = 60,
+        .latency = { .count = 5, .max_ns = 2500000,
+                     .buckets = { 3, 1, 0, 1, 0, 0 } },
+    };
+    test_procs[1].main_thread = &rt;
+    VfsNode *root = procfs_init();
+    VfsNode *pid_dir = root->ops->lookup(root, "1");
+    VfsNode *sched = pid_dir->ops->lookup(pid_dir, "sched");
+    ASSERT_TRUE(sched != NULL);
+    ASSERT_TRUE(sched->inode_num == 3012);
+
+    char buf[512] = {0};
+    int rd = sched->ops->read(sched, buf, 0, sizeof(buf) - 1);
+    ASSERT_TRUE(rd > 0);
+    ASSERT_TRUE(strstr(buf, "Policy: fifo\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Priority: 40\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "EffectivePriority: 60\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Wakeups: 5\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "MaxLatency: 2500 us\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Latency<10us: 3\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Latency<10ms: 1\n") != NULL);
+    ASSERT_TRUE(strstr(buf, "Latency>=100ms: 0\n") != NULL);
+
+    /* No thread, no content */
+    VfsNode *dir0 = root->ops->lookup(root, "0");
+    VfsNode *sched0 = dir0->ops->lookup(dir0, "sched");
+    ASSERT_EQ(sched0->ops->read(sched0, buf, 0, sizeof(buf) - 1), 0);
+    return 0;
+}
+
+TEST(pid_readahead_content) {
+    setup_test_procs();
+    static FdTable fds;
+    memset(&fds, 0, sizeof(fds));
+    fds.entries[0].in_use = 1;                  /* Never read: not listed */
+    fds.entries[3].in_use = 1;
+    fds.entries[3].file.ra = (VfsReadahead){ .hits = 62, .misses = 2, .bytes = 262144 };
+    fds.entries[5].file.ra.misses = 7;          /* Closed: not listed */
+    test_procs[1].fd_table = &fds;
+    VfsNode *root = procfs_init();
+    VfsNode *pid_dir = root->ops->lookup(root, "1");
+    VfsNode *ra = pid_dir->ops->lookup(pid_dir, "readahead");
+    ASSERT_TRUE(ra != NULL);
+
+    char buf[256] = {0};
+    int rd = ra->ops->read(ra, buf, 0, sizeof(buf) - 1);
+    ASSERT_TRUE(rd > 0);
+    ASSERT_STR_EQ(buf, "fd 3: hits 62 misses 2 ahead 262144\n");
+
+    /* No fd table, no content */
+    VfsNode *dir0 = root->ops->lookup(root, "0");
+    VfsNode *ra0 = dir0->ops->lookup(dir0, "readahead");
+    ASSERT_EQ(ra0->ops->read(ra0, buf, 0, sizeof(buf) - 1), 0);
+    return 0;
+}
+
 TEST(readdir_root) {
     setup_test_procs();
     VfsNode *root = procfs_init();
     VfsDirEntry entries[16];
     int count = root->ops->readdir(root, entries, 16);
-    /* meminfo + uptime + 3 non-terminated PIDs (0, 1, 2) */
-    ASSERT_EQ(count, 5);
+    /* meminfo + uptime + preempt + bcache + 3 non-terminated PIDs (0, 1, 2) */
+    ASSERT_EQ(count, 7);
     ASSERT_STR_EQ(entries[0].name, "meminfo");
     ASSERT_STR_EQ(entries[1].name, "uptime");
+    ASSERT_STR_EQ(entries[2].name, "preempt");
+    ASSERT_STR_EQ(entries[3].name, "bcache");
     return 0;
 }
 
@@ -299,8 +528,10 @@ TEST(readdir_pid_dir) {
 
     VfsDirEntry entries[4];
     int count = pid_dir->ops->readdir(pid_dir, entries, 4);
-    ASSERT_EQ(count, 1);
+    ASSERT_EQ(count, 3);
     ASSERT_STR_EQ(entries[0].name, "status");
+    ASSERT_STR_EQ(entries[1].name, "sched");
+    ASSERT_STR_EQ(entries[2].name, "readahead");
     return 0;
 }
 
@@ -324,7 +555,11 @@ TestCase procfs_tests[] = {
     TEST_ENTRY(meminfo_content),
     TEST_ENTRY(meminfo_partial_read),
     TEST_ENTRY(uptime_content),
+    TEST_ENTRY(preempt_content),
+    TEST_ENTRY(bcache_content),
     TEST_ENTRY(pid_status_content),
+    TEST_ENTRY(pid_sched_content),
+    TEST_ENTRY(pid_readahead_content),
     TEST_ENTRY(readdir_root),
     TEST_ENTRY(readdir_pid_dir),
     TEST_ENTRY(no_create_ops),
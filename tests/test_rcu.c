@@ -0,0 +1,282 @@
+/* arc_os — Host-side tests for kernel/proc/rcu.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
+
+/* Minimal Thread: only the RCU nesting counter is used */
+typedef struct Thread {
+    uint32_t tid;
+    uint32_t rcu_read_depth;
+} Thread;
+
+static Thread test_thread;
+static Thread *test_current_thread = &test_thread;
+static Thread *thread_current(void) { return test_current_thread; }
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* Minimal PerCpu: the test switches "this CPU" to simulate other CPUs */
+#define MAX_CPUS 16
+typedef struct {
+    uint32_t cpu_id;
+    volatile int online;
+    volatile uint64_t rcu_qs_seq;
+    volatile uint8_t  rcu_parked;
+} PerCpu;
+
+static PerCpu percpu_data[MAX_CPUS];
+static uint32_t cpu_count = 1;
+static PerCpu *test_this_cpu;
+static PerCpu *this_cpu(void) { return test_this_cpu; }
+
+/* sched_yield stub: after `yield_qs_after` yields, CPU `yield_qs_cpu`
+ * passes through a quiescent state, as if it had context-switched. */
+static int yield_count;
+static int yield_qs_after;
+static int yield_qs_cpu = -1;
+
+void rcu_note_qs(void);
+
+static void test_sched_yield(void) {
+    yield_count++;
+    if (yield_qs_cpu >= 0 && yield_count >= yield_qs_after) {
+        PerCpu *saved = test_this_cpu;
+        test_this_cpu = &percpu_data[yield_qs_cpu];
+        rcu_note_qs();
+        test_this_cpu = saved;
+    }
+}
+#define sched_yield test_sched_yield
+
+#include "../kernel/proc/rcu.c"
+
+#undef sched_yield
+
+static void reset_rcu_state(int ncpus) {
+    memset(percpu_data, 0, sizeof(percpu_data));
+    for (int i = 0; i < ncpus; i++) {
+        percpu_data[i].cpu_id = (uint32_t)i;
+        percpu_data[i].online = 1;
+    }
+    cpu_count = (uint32_t)ncpus;
+    test_this_cpu = &percpu_data[0];
+    test_thread.rcu_read_depth = 0;
+    test_current_thread = &test_thread;
+
+    rcu_lock = (Spinlock)SPINLOCK_INIT;
+    rcu_gp_seq = 0;
+    rcu_gp_done = 0;
+    rcu_cb_head = NULL;
+    rcu_cb_tail = &rcu_cb_head;
+    rcu_cb_last_gp = 0;
+
+    yield_count = 0;
+    yield_qs_after = 0;
+    yield_qs_cpu = -1;
+}
+
+/* Run a quiescent state on the given CPU */
+static void qs_on(int cpu) {
+    PerCpu *saved = test_this_cpu;
+    test_this_cpu = &percpu_data[cpu];
+    rcu_note_qs();
+    test_this_cpu = saved;
+}
+
+typedef struct {
+    RcuHead rcu;
+    int     freed;
+} TestObj;
+
+static int cb_calls;
+
+static void test_obj_free(RcuHead *head) {
+    TestObj *o = (TestObj *)head;
+    o->freed = 1;
+    cb_calls++;
+}
+
+/* --- Tests --- */
+
+static int test_read_lock_nests(void) {
+    reset_rcu_state(1);
+    ASSERT_FALSE(rcu_read_lock_held());
+    rcu_read_lock();
+    rcu_read_lock();
+    ASSERT_EQ(test_thread.rcu_read_depth, 2);
+    ASSERT_TRUE(rcu_read_lock_held());
+    rcu_read_unlock();
+    ASSERT_TRUE(rcu_read_lock_held());
+    rcu_read_unlock();
+    ASSERT_FALSE(rcu_read_lock_held());
+    return 0;
+}
+
+static int test_read_lock_before_threads(void) {
+    reset_rcu_state(1);
+    test_current_thread = NULL;  /* Early boot: no current thread yet */
+    rcu_read_lock();
+    ASSERT_FALSE(rcu_read_lock_held());
+    rcu_read_unlock();
+    return 0;
+}
+
+static int test_synchronize_single_cpu(void) {
+    reset_rcu_state(1);
+    synchronize_rcu();
+    /* The caller's own CPU is quiescent, so nothing to wait for */
+    ASSERT_EQ(yield_count, 0);
+    ASSERT_EQ(rcu_gp_done, 1);
+    ASSERT_EQ(percpu_data[0].rcu_qs_seq, 1);
+    return 0;
+}
+
+static int test_synchronize_waits_for_other_cpu(void) {
+    reset_rcu_state(2);
+    yield_qs_cpu = 1;
+    yield_qs_after = 3;
+    synchronize_rcu();
+    ASSERT_EQ(yield_count, 3);
+    ASSERT_EQ(rcu_gp_done, 1);
+    return 0;
+}
+
+static int test_parked_cpu_ignored(void) {
+    reset_rcu_state(2);
+    test_this_cpu = &percpu_data[1];
+    rcu_cpu_park();
+    test_this_cpu = &percpu_data[0];
+    synchronize_rcu();
+    ASSERT_EQ(yield_count, 0);
+
+    /* Unparking happens at the CPU's next quiescent state */
+    qs_on(1);
+    ASSERT_EQ(percpu_data[1].rcu_parked, 0);
+    return 0;
+}
+
+static int test_offline_cpu_ignored(void) {
+    reset_rcu_state(2);
+    percpu_data[1].online = 0;
+    synchronize_rcu();
+    ASSERT_EQ(yield_count, 0);
+    return 0;
+}
+
+static int test_call_rcu_deferred_until_gp(void) {
+    reset_rcu_state(2);
+    TestObj obj = { .freed = 0 };
+    cb_calls = 0;
+
+    call_rcu(&obj.rcu, test_obj_free);
+    ASSERT_EQ(rcu_gp_seq, 1);
+
+    /* Only CPU 0 has been quiescent: callback must not run */
+    qs_on(0);
+    rcu_process_callbacks();
+    ASSERT_EQ(obj.freed, 0);
+
+    qs_on(1);
+    rcu_process_callbacks();
+    ASSERT_EQ(obj.freed, 1);
+    ASSERT_EQ(cb_calls, 1);
+    ASSERT_TRUE(rcu_cb_head == NULL);
+    return 0;
+}
+
+static int test_call_rcu_during_gp_waits_for_next(void) {
+    reset_rcu_state(2);
+    TestObj a = { .freed = 0 }, b = { .freed = 0 };
+    cb_calls = 0;
+
+    call_rcu(&a.rcu, test_obj_free);    /* Starts GP 1 */
+    qs_on(0);                           /* CPU 0 passes GP 1 before b's removal */
+    call_rcu(&b.rcu, test_obj_free);    /* GP 1 in flight: b needs GP 2 */
+    ASSERT_EQ(b.rcu.gp, 2);
+
+    qs_on(1);
+    rcu_process_callbacks();            /* GP 1 completes, GP 2 starts */
+    ASSERT_EQ(a.freed, 1);
+    ASSERT_EQ(b.freed, 0);
+    ASSERT_EQ(rcu_gp_seq, 2);
+
+    qs_on(0);
+    qs_on(1);
+    rcu_process_callbacks();
+    ASSERT_EQ(b.freed, 1);
+    ASSERT_EQ(cb_calls, 2);
+    return 0;
+}
+
+static int test_tick_user_mode_is_qs(void) {
+    reset_rcu_state(2);
+    TestObj obj = { .freed = 0 };
+    call_rcu(&obj.rcu, test_obj_free);
+
+    /* Kernel-mode tick on CPU 1 reports nothing */
+    test_this_cpu = &percpu_data[1];
+    rcu_check_callbacks(0);
+    ASSERT_EQ(percpu_data[1].rcu_qs_seq, 0);
+
+    /* User-mode tick does */
+    rcu_check_callbacks(1);
+    test_this_cpu = &percpu_data[0];
+    ASSERT_EQ(percpu_data[1].rcu_qs_seq, 1);
+
+    qs_on(0);
+    rcu_process_callbacks();
+    ASSERT_EQ(obj.freed, 1);
+    return 0;
+}
+
+static int test_callbacks_fifo(void) {
+    reset_rcu_state(1);
+    TestObj objs[3];
+    memset(objs, 0, sizeof(objs));
+    for (int i = 0; i < 3; i++) {
+        call_rcu(&objs[i].rcu, test_obj_free);
+    }
+    ASSERT_TRUE(rcu_cb_head == &objs[0].rcu);
+    ASSERT_TRUE(objs[0].rcu.next == &objs[1].rcu);
+    ASSERT_TRUE(objs[1].rcu.next == &objs[2].rcu);
+
+    qs_on(0);
+    rcu_process_callbacks();
+    qs_on(0);
+    rcu_process_callbacks();
+    for (int i = 0; i < 3; i++) ASSERT_EQ(objs[i].freed, 1);
+    ASSERT_TRUE(rcu_cb_tail == &rcu_cb_head);
+    return 0;
+}
+
+/* --- Test suite export --- */
+
+TestCase rcu_tests[] = {
+    { "read_lock_nests",              test_read_lock_nests },
+    { "read_lock_before_threads",     test_read_lock_before_threads },
+    { "synchronize_single_cpu",       test_synchronize_single_cpu },
+    { "synchronize_waits_other_cpu",  test_synchronize_waits_for_other_cpu },
+    { "parked_cpu_ignored",           test_parked_cpu_ignored },
+    { "offline_cpu_ignored",          test_offline_cpu_ignored },
+    { "call_rcu_deferred_until_gp",   test_call_rcu_deferred_until_gp },
+    { "call_rcu_during_gp_next",      test_call_rcu_during_gp_waits_for_next },
+    { "tick_user_mode_is_qs",         test_tick_user_mode_is_qs },
+    { "callbacks_fifo",               test_callbacks_fifo },
+};
+
+int rcu_test_count = sizeof(rcu_tests) / sizeof(rcu_tests[0]);
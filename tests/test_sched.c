@@ -12,9 +12,13 @@
 #define ARCHOS_PROC_WAITQUEUE_H
 #define ARCHOS_ARCH_X86_64_GDT_H
 #define ARCHOS_ARCH_X86_64_SYSCALL_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
 #define ARCHOS_ARCH_X86_64_PAGING_H
 #define ARCHOS_MM_VMM_H
 #define ARCHOS_BOOT_BOOTINFO_H
+#define ARCHOS_PROC_RCU_H
+#define ARCHOS_ARCH_X86_64_TSC_H
+#define ARCHOS_PROC_PREEMPT_H
 
 /* Stub kprintf */
 static inline void kprintf(const char *fmt, ...) { (void)fmt; }
@@ -30,6 +34,14 @@ typedef uint32_t tid_t;
 
 #define THREAD_STACK_SIZE  (16 * 1024)
 
+#define SCHED_LAT_BUCKETS  6
+
+typedef struct {
+    uint64_t count;
+    uint64_t max_ns;
+    uint32_t buckets[SCHED_LAT_BUCKETS];
+} SchedLatency;
+
 typedef void (*thread_entry_t)(void *arg);
 
 typedef struct {
@@ -51,9 +63,25 @@ typedef struct Thread {
     uint64_t        kernel_stack_top;
     thread_entry_t  entry;
     void           *arg;
+    uint8_t         policy;
+    uint8_t         rt_priority;
+    uint8_t         pi_priority;
+    uint8_t         prio;
+    uint32_t        rr_ticks;
+    uint64_t        wake_tsc;
+    SchedLatency    latency;
     struct Thread  *next;
 } Thread;
 
+/* Scheduling constants (guarded out sched.h) */
+#define SCHED_NORMAL  0
+#define SCHED_FIFO    1
+#define SCHED_RR      2
+#define SCHED_PRIO_MIN  1
+#define SCHED_PRIO_MAX  99
+#define SCHED_QUANTUM   10
+#define SCHED_RR_TICKS  5
+
 /* Spinlock stub — no-op for host tests */
 typedef struct {
     volatile uint32_t locked;
@@ -70,6 +98,10 @@ static inline void spinlock_release(Spinlock *lock) {
     lock->locked = 0;
 }
 
+/* preempt stub: count disables (the thread's preempt_count) */
+static int preempt_disable_count;
+static inline void preempt_disable(void) { preempt_disable_count++; }
+
 /* thread_current/thread_set_current stubs (static to avoid linker clash) */
 static Thread *test_current_thread = NULL;
 
@@ -103,7 +135,13 @@ static Process *proc_get_by_tid(uint32_t tid) { (void)tid; return NULL; }
 static void gdt_set_kernel_stack(uint64_t rsp0) { (void)rsp0; }
 static uint64_t vmm_get_kernel_pml4(void) { return 0x1000; }
 static void paging_write_cr3(uint64_t cr3) { (void)cr3; }
-static uint64_t syscall_kernel_rsp;
+/* Minimal PerCpu: only the SYSCALL kernel stack is used */
+typedef struct {
+    uint64_t kernel_rsp;
+} PerCpu;
+
+static PerCpu test_cpu;
+static PerCpu *this_cpu(void) { return &test_cpu; }
 
 /* Tracking context_switch stub (static to avoid linker clash) */
 static int ctx_switch_count;
@@ -116,7 +154,34 @@ static void context_switch(ThreadContext *old, ThreadContext *new_ctx) {
     ctx_switch_new = new_ctx;
 }
 
+/* TSC stub: a settable clock, 1 cycle = 1 ns */
+static uint64_t test_tsc = 1;
+static uint64_t tsc_read(void) { return test_tsc; }
+static uint64_t tsc_to_ns(uint64_t cycles) { return cycles; }
+
+/* need_resched stubs: record requests and their due time */
+static int need_resched_flag;
+static uint64_t need_resched_due;
+static const char *need_resched_site;
+
+static void set_need_resched(uint64_t due_tsc) {
+    if (need_resched_flag) return;
+    need_resched_flag = 1;
+    need_resched_due = due_tsc;
+}
+
+static void clear_need_resched(const char *site) {
+    if (!need_resched_flag) return;
+    need_resched_flag = 0;
+    need_resched_site = site;
+}
+#define preempt_need_resched need_resched_flag
+
 /* Include the real sched.c */
+/* RCU stub — count quiescent states reported by the scheduler */
+static int rcu_qs_count;
+static void rcu_note_qs(void) { rcu_qs_count++; }
+
 #include "../kernel/proc/sched.c"
 
 /* Thread pool for tests */
@@ -140,7 +205,24 @@ static void reset_sched_state(void) {
     ctx_switch_count = 0;
     ctx_switch_old = NULL;
     ctx_switch_new = NULL;
+    rcu_qs_count = 0;
+    test_cpu.kernel_rsp = 0;
     memset(thread_pool, 0, sizeof(thread_pool));
+    memset(rt_head, 0, sizeof(rt_head));
+    memset(rt_tail, 0, sizeof(rt_tail));
+    memset(rt_bitmap, 0, sizeof(rt_bitmap));
+    quantum_ticks = 0;
+    test_tsc = 1;
+    need_resched_flag = 0;
+    need_resched_due = 0;
+    need_resched_site = NULL;
+}
+
+static Thread *make_rt_thread(int index, tid_t tid, uint8_t state,
+                              int policy, int prio) {
+    Thread *t = make_thread(index, tid, state);
+    sched_setscheduler(t, policy, prio);
+    return t;
 }
 
 /* --- Tests --- */
@@ -382,6 +464,391 @@ static int test_sched_yield_calls_schedule(void) {
     return 0;
 }
 
+static int test_sched_schedule_tail_releases_lock(void) {
+    reset_sched_state();
+    sched_init();
+    preempt_disable_count = 0;
+
+    /* The switch into a new thread happens under the creator's lock */
+    spinlock_acquire(&sched_lock);
+    sched_schedule_tail();
+
+    ASSERT_EQ(sched_lock.locked, 0);
+    ASSERT_EQ(preempt_disable_count, 1);
+    return 0;
+}
+
+static int test_sched_schedule_reports_rcu_qs(void) {
+    reset_sched_state();
+    sched_init();
+
+    Thread *a = make_thread(0, 1, THREAD_RUNNING);
+    test_current_thread = a;
+
+    /* Even a schedule that keeps the current thread is a quiescent state */
+    sched_schedule();
+    ASSERT_EQ(rcu_qs_count, 1);
+
+    Thread *b = make_thread(1, 2, THREAD_CREATED);
+    sched_add_thread(b);
+    sched_schedule();
+    ASSERT_EQ(rcu_qs_count, 2);
+    ASSERT_TRUE(test_current_thread == b);
+    return 0;
+}
+
+static int test_sched_switch_sets_percpu_kernel_rsp(void) {
+    reset_sched_state();
+    sched_init();
+
+    Thread *a = make_thread(0, 1, THREAD_RUNNING);
+    Thread *b = make_thread(1, 2, THREAD_READY);
+    a->kernel_stack_top = 0xA000;
+    b->kernel_stack_top = 0xB000;
+    test_current_thread = a;
+    sched_add_thread(b);
+
+    sched_schedule();
+    ASSERT_EQ(test_cpu.kernel_rsp, 0xB000);
+    sched_schedule();
+    ASSERT_EQ(test_cpu.kernel_rsp, 0xA000);
+    return 0;
+}
+
+static int test_sched_rt_runs_before_normal(void) {
+    reset_sched_state();
+
+    Thread *a = make_thread(0, 1, THREAD_RUNNING);
+    Thread *n = make_thread(1, 2, THREAD_CREATED);
+    Thread *lo = make_rt_thread(2, 3, THREAD_CREATED, SCHED_RR, 10);
+    Thread *hi = make_rt_thread(3, 4, THREAD_CREATED, SCHED_FIFO, 80);
+    test_current_thread = a;
+    sched_add_thread(n);
+    sched_add_thread(lo);
+    sched_add_thread(hi);
+
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == hi);
+    /* hi blocks: the next priority down runs, then the normal class */
+    hi->state = THREAD_BLOCKED;
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == lo);
+    lo->state = THREAD_BLOCKED;
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == n);
+    return 0;
+}
+
+static int test_sched_rt_keeps_cpu_over_lower(void) {
+    reset_sched_state();
+
+    Thread *rt = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_FIFO, 50);
+    Thread *n = make_thread(1, 2, THREAD_CREATED);
+    Thread *lo = make_rt_thread(2, 3, THREAD_CREATED, SCHED_FIFO, 20);
+    test_current_thread = rt;
+    sched_add_thread(n);
+    sched_add_thread(lo);
+
+    /* Neither a yield nor any number of ticks hands the CPU down */
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == rt);
+    for (int i = 0; i < 3 * SCHED_QUANTUM; i++) {
+        ASSERT_EQ(sched_tick(), 0);
+    }
+    return 0;
+}
+
+static int test_sched_tick_preempts_for_higher(void) {
+    reset_sched_state();
+
+    Thread *n = make_thread(0, 1, THREAD_RUNNING);
+    test_current_thread = n;
+    ASSERT_EQ(sched_tick(), 0);
+
+    Thread *rt = make_rt_thread(1, 2, THREAD_BLOCKED, SCHED_FIFO, 1);
+    sched_add_thread(rt);
+    ASSERT_EQ(sched_tick(), 1);
+
+    /* The preempted normal thread queues behind, RT runs */
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == rt);
+    ASSERT_TRUE(queue_head == n);
+    return 0;
+}
+
+static int test_sched_normal_quantum(void) {
+    reset_sched_state();
+
+    Thread *n = make_thread(0, 1, THREAD_RUNNING);
+    test_current_thread = n;
+    for (int i = 1; i < SCHED_QUANTUM; i++) {
+        ASSERT_EQ(sched_tick(), 0);
+    }
+    ASSERT_EQ(sched_tick(), 1);
+    return 0;
+}
+
+static int test_sched_rr_slices_equal_priority(void) {
+    reset_sched_state();
+
+    Thread *a = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_RR, 30);
+    test_current_thread = a;
+
+    /* Alone at its priority, the slice just renews */
+    for (int i = 0; i < 2 * SCHED_RR_TICKS; i++) {
+        ASSERT_EQ(sched_tick(), 0);
+    }
+
+    Thread *b = make_rt_thread(1, 2, THREAD_CREATED, SCHED_RR, 30);
+    sched_add_thread(b);
+    for (int i = 1; i < SCHED_RR_TICKS; i++) {
+        ASSERT_EQ(sched_tick(), 0);
+    }
+    ASSERT_EQ(sched_tick(), 1);
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == b);
+    ASSERT_TRUE(rt_head[30] == a);
+    return 0;
+}
+
+static int test_sched_fifo_preempted_keeps_head(void) {
+    reset_sched_state();
+
+    Thread *a = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_FIFO, 40);
+    Thread *b = make_rt_thread(1, 2, THREAD_CREATED, SCHED_FIFO, 40);
+    Thread *hi = make_rt_thread(2, 3, THREAD_CREATED, SCHED_FIFO, 90);
+    test_current_thread = a;
+    sched_add_thread(b);
+    sched_add_thread(hi);
+
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == hi);
+    /* a was preempted, not yielding: it resumes before b */
+    ASSERT_TRUE(rt_head[40] == a);
+    ASSERT_TRUE(a->next == b);
+    return 0;
+}
+
+static int test_sched_setscheduler_validates(void) {
+    reset_sched_state();
+
+    Thread *t = make_thread(0, 1, THREAD_CREATED);
+    ASSERT_EQ(sched_setscheduler(t, SCHED_FIFO, 0), -1);
+    ASSERT_EQ(sched_setscheduler(t, SCHED_RR, 100), -1);
+    ASSERT_EQ(sched_setscheduler(t, SCHED_NORMAL, 5), -1);
+    ASSERT_EQ(sched_setscheduler(t, 7, 5), -1);
+    ASSERT_EQ(t->prio, 0);
+
+    ASSERT_EQ(sched_setscheduler(t, SCHED_RR, 99), 0);
+    ASSERT_EQ(t->policy, SCHED_RR);
+    ASSERT_EQ(t->prio, 99);
+    ASSERT_EQ(sched_setscheduler(t, SCHED_NORMAL, 0), 0);
+    ASSERT_EQ(t->prio, 0);
+    return 0;
+}
+
+static int test_sched_setscheduler_requeues(void) {
+    reset_sched_state();
+
+    Thread *a = make_thread(0, 1, THREAD_CREATED);
+    sched_add_thread(a);
+    ASSERT_TRUE(queue_head == a);
+
+    sched_setscheduler(a, SCHED_FIFO, 70);
+    ASSERT_TRUE(queue_head == NULL);
+    ASSERT_TRUE(rt_head[70] == a);
+    ASSERT_EQ(ready_prio(), 70);
+    return 0;
+}
+
+static int test_sched_setscheduler_lowering_self_yields(void) {
+    reset_sched_state();
+    Thread *cur = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_FIFO, 50);
+    Thread *peer = make_rt_thread(1, 2, THREAD_CREATED, SCHED_FIFO, 30);
+    test_current_thread = cur;
+    sched_add_thread(peer);
+
+    /* Dropping below the ready peer hands it the CPU at once */
+    sched_setscheduler(cur, SCHED_FIFO, 20);
+    ASSERT_EQ(ctx_switch_count, 1);
+    ASSERT_TRUE(test_current_thread == peer);
+    ASSERT_TRUE(rt_head[20] == cur);
+    ASSERT_EQ(cur->state, THREAD_READY);
+
+    /* Staying above the ready thread keeps running */
+    sched_setscheduler(peer, SCHED_FIFO, 25);
+    ASSERT_EQ(ctx_switch_count, 1);
+    ASSERT_TRUE(test_current_thread == peer);
+    return 0;
+}
+
+static int test_sched_inherited_prio(void) {
+    reset_sched_state();
+
+    Thread *t = make_rt_thread(0, 1, THREAD_CREATED, SCHED_FIFO, 10);
+    sched_add_thread(t);
+
+    /* A boost moves it up; dropping the boost restores its own priority */
+    sched_set_inherited_prio(t, 60);
+    ASSERT_EQ(t->prio, 60);
+    ASSERT_TRUE(rt_head[60] == t);
+    ASSERT_TRUE(rt_head[10] == NULL);
+    sched_set_inherited_prio(t, 5);
+    ASSERT_EQ(t->prio, 10);
+    ASSERT_TRUE(rt_head[10] == t);
+
+    /* A boosted normal thread is not time-sliced */
+    Thread *n = make_thread(1, 2, THREAD_RUNNING);
+    test_current_thread = n;
+    sched_remove_thread(t);
+    sched_set_inherited_prio(n, 20);
+    for (int i = 0; i < 2 * SCHED_QUANTUM; i++) {
+        ASSERT_EQ(sched_tick(), 0);
+    }
+    return 0;
+}
+
+static int test_sched_fork_inherits_policy(void) {
+    reset_sched_state();
+
+    Thread *parent = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_RR, 45);
+    sched_set_inherited_prio(parent, 90);
+    Thread *child = make_thread(1, 2, THREAD_CREATED);
+    sched_fork(child, parent);
+    ASSERT_EQ(child->policy, SCHED_RR);
+    ASSERT_EQ(child->rt_priority, 45);
+    ASSERT_EQ(child->prio, 45);
+    ASSERT_EQ(child->pi_priority, 0);
+    return 0;
+}
+
+static int test_sched_wakeup_latency_histogram(void) {
+    reset_sched_state();
+
+    Thread *n = make_thread(0, 1, THREAD_RUNNING);
+    Thread *rt = make_rt_thread(1, 2, THREAD_BLOCKED, SCHED_FIFO, 50);
+    test_current_thread = n;
+
+    test_tsc = 1000;
+    sched_add_thread(rt);
+    test_tsc += 50000;              /* 50 us later */
+    sched_schedule();
+    ASSERT_TRUE(test_current_thread == rt);
+    ASSERT_EQ(rt->latency.count, 1);
+    ASSERT_EQ(rt->latency.buckets[1], 1);
+    ASSERT_EQ(rt->latency.max_ns, 50000);
+    ASSERT_EQ(rt->wake_tsc, 0);
+
+    /* Resuming after a plain preemption is not a wakeup */
+    rt->state = THREAD_BLOCKED;
+    sched_schedule();
+    test_tsc += 200000000;          /* 200 ms */
+    sched_add_thread(rt);
+    test_tsc += 200000000;
+    sched_schedule();
+    ASSERT_EQ(rt->latency.count, 2);
+    ASSERT_EQ(rt->latency.buckets[SCHED_LAT_BUCKETS - 1], 1);
+    ASSERT_EQ(rt->latency.max_ns, 200000000);
+
+    /* Normal threads are not tracked */
+    n->state = THREAD_BLOCKED;
+    sched_add_thread(n);
+    ASSERT_EQ(n->wake_tsc, 0);
+    return 0;
+}
+
+static int test_sched_wakeup_requests_resched(void) {
+    reset_sched_state();
+    Thread *cur = make_rt_thread(0, 1, THREAD_RUNNING, SCHED_FIFO, 20);
+    Thread *lo = make_rt_thread(1, 2, THREAD_BLOCKED, SCHED_FIFO, 10);
+    Thread *hi = make_rt_thread(2, 3, THREAD_BLOCKED, SCHED_FIFO, 30);
+    test_current_thread = cur;
+
+    /* A lower-priority wakeup does not disturb the running thread */
+    sched_add_thread(lo);
+    ASSERT_EQ(need_resched_flag, 0);
+
+    test_tsc = 500;
+    sched_add_thread(hi);
+    ASSERT_EQ(need_resched_flag, 1);
+    ASSERT_EQ(need_resched_due, 500);
+
+    /* The switch consumes the request */
+    sched_schedule();
+    ASSERT_EQ(need_resched_flag, 0);
+    ASSERT_STR_EQ(need_resched_site, "schedule");
+    ASSERT_TRUE(test_current_thread == hi);
+    return 0;
+}
+
+static int test_sched_wakeup_preempts_idle(void) {
+    reset_sched_state();
+    Thread *idle = make_thread(0, 0, THREAD_RUNNING);
+    Thread *a = make_thread(1, 1, THREAD_BLOCKED);
+    sched_set_idle_thread(idle);
+    test_current_thread = idle;
+
+    sched_add_thread(a);
+    ASSERT_EQ(need_resched_flag, 1);
+    return 0;
+}
+
+static int test_sched_handoff_bypasses_queue(void) {
+    reset_sched_state();
+    Thread *caller = make_thread(0, 1, THREAD_BLOCKED);
+    Thread *server = make_thread(1, 2, THREAD_BLOCKED);
+    Thread *other = make_thread(2, 3, THREAD_BLOCKED);
+    test_current_thread = caller;
+    sched_add_thread(other);
+    need_resched_flag = 0;
+    quantum_ticks = 4;
+
+    sched_handoff(server);
+    ASSERT_TRUE(test_current_thread == server);
+    ASSERT_EQ(server->state, THREAD_RUNNING);
+    ASSERT_EQ(ctx_switch_count, 1);
+    ASSERT_TRUE(ctx_switch_new == &server->context);
+    ASSERT_EQ(rcu_qs_count, 1);
+    /* The waiting thread keeps its place; the slice carries over */
+    ASSERT_TRUE(queue_head == other);
+    ASSERT_TRUE(other->next == NULL);
+    ASSERT_EQ(quantum_ticks, 4);
+    return 0;
+}
+
+static int test_sched_handoff_yields_to_higher_prio(void) {
+    reset_sched_state();
+    Thread *caller = make_thread(0, 1, THREAD_BLOCKED);
+    Thread *server = make_thread(1, 2, THREAD_BLOCKED);
+    Thread *hi = make_rt_thread(2, 3, THREAD_BLOCKED, SCHED_FIFO, 20);
+    test_current_thread = caller;
+    sched_add_thread(hi);
+
+    /* A real-time thread is ready: the server queues behind it */
+    sched_handoff(server);
+    ASSERT_TRUE(test_current_thread == hi);
+    ASSERT_TRUE(queue_head == server);
+    ASSERT_EQ(server->state, THREAD_READY);
+    return 0;
+}
+
+static int test_sched_handoff_honours_pending_resched(void) {
+    reset_sched_state();
+    Thread *caller = make_thread(0, 1, THREAD_BLOCKED);
+    Thread *server = make_thread(1, 2, THREAD_BLOCKED);
+    Thread *other = make_thread(2, 3, THREAD_BLOCKED);
+    test_current_thread = caller;
+    sched_add_thread(other);
+    need_resched_flag = 1;
+
+    /* The slice ran out: the server waits its turn behind other */
+    sched_handoff(server);
+    ASSERT_TRUE(test_current_thread == other);
+    ASSERT_TRUE(queue_head == server);
+    ASSERT_EQ(need_resched_flag, 0);
+    return 0;
+}
+
 /* --- Test suite export --- */
 
 TestCase sched_tests[] = {
@@ -397,6 +864,26 @@ TestCase sched_tests[] = {
     { "schedule_idle_fallback",   test_sched_schedule_idle_fallback },
     { "idle_not_requeued",        test_sched_idle_not_requeued },
     { "yield_calls_schedule",     test_sched_yield_calls_schedule },
+    { "schedule_tail_releases",   test_sched_schedule_tail_releases_lock },
+    { "schedule_reports_rcu_qs",  test_sched_schedule_reports_rcu_qs },
+    { "switch_sets_percpu_rsp",   test_sched_switch_sets_percpu_kernel_rsp },
+    { "rt_runs_before_normal",    test_sched_rt_runs_before_normal },
+    { "rt_keeps_cpu_over_lower",  test_sched_rt_keeps_cpu_over_lower },
+    { "tick_preempts_for_higher", test_sched_tick_preempts_for_higher },
+    { "normal_quantum",           test_sched_normal_quantum },
+    { "rr_slices_equal_prio",     test_sched_rr_slices_equal_priority },
+    { "fifo_preempted_keeps_head", test_sched_fifo_preempted_keeps_head },
+    { "setscheduler_validates",   test_sched_setscheduler_validates },
+    { "setscheduler_requeues",    test_sched_setscheduler_requeues },
+    { "setscheduler_lowering_self_yields", test_sched_setscheduler_lowering_self_yields },
+    { "inherited_prio",           test_sched_inherited_prio },
+    { "fork_inherits_policy",     test_sched_fork_inherits_policy },
+    { "wakeup_latency_histogram", test_sched_wakeup_latency_histogram },
+    { "wakeup_requests_resched",  test_sched_wakeup_requests_resched },
+    { "wakeup_preempts_idle",     test_sched_wakeup_preempts_idle },
+    { "handoff_bypasses_queue",   test_sched_handoff_bypasses_queue },
+    { "handoff_yields_to_higher", test_sched_handoff_yields_to_higher_prio },
+    { "handoff_pending_resched",  test_sched_handoff_honours_pending_resched },
 };
 
 int sched_test_count = sizeof(sched_tests) / sizeof(sched_tests[0]);
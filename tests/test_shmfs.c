@@ -0,0 +1,243 @@
+/* arc_os — Host-side tests for kernel/fs/shmfs.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_VMM_H
+#define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_LIB_MEM_H
+#define ARCHOS_LIB_STRING_H
+
+#define PAGE_SIZE 4096
+#define PAGE_ALIGN_UP(x)    (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1ULL))
+#define GFP_ZERO 0x01
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* kmalloc via libc */
+static void *kmalloc(size_t size, uint32_t flags) {
+    void *p = malloc(size);
+    if (p && (flags & GFP_ZERO)) memset(p, 0, size);
+    return p;
+}
+static void *krealloc(void *ptr, size_t size) { return realloc(ptr, size); }
+static void kfree(void *ptr) { free(ptr); }
+
+/* PMM stub: frames are host pages, "physical" addresses are their
+ * pointers (HHDM offset 0). Filled with garbage to catch missing zeroing. */
+static int live_frames;
+static int frame_fail;
+
+static uint64_t pmm_alloc_page(void) {
+    if (frame_fail) return 0;
+    void *p = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    memset(p, 0xAA, PAGE_SIZE);
+    live_frames++;
+    return (uint64_t)(uintptr_t)p;
+}
+
+static void pmm_free_page(uint64_t phys) {
+    live_frames--;
+    free((void *)(uintptr_t)phys);
+}
+
+static uint64_t vmm_get_hhdm_offset(void) { return 0; }
+
+#include "../kernel/fs/shmfs.c"
+
+static VfsNode *reset_shmfs(void) {
+    for (int i = 0; i < SHMFS_MAX_OBJECTS; i++) {
+        if (objects[i]) {
+            shmfs_free_pages(objects[i], 0);
+            kfree(objects[i]->pages);
+            kfree(objects[i]);
+        }
+    }
+    live_frames = 0;
+    frame_fail = 0;
+    return shmfs_init();
+}
+
+/* --- Tests --- */
+
+TEST(create_lookup_readdir) {
+    VfsNode *dir = reset_shmfs();
+    ASSERT_EQ(dir->type, VFS_DIRECTORY);
+    ASSERT_EQ(dir->mode, 01777);
+
+    VfsNode *a = dir->ops->create(dir, "ring", VFS_FILE);
+    ASSERT_TRUE(a != NULL);
+    ASSERT_TRUE(shmfs_is_object(a));
+    ASSERT_FALSE(shmfs_is_object(dir));
+    ASSERT_TRUE(dir->ops->lookup(dir, "ring") == a);
+    ASSERT_TRUE(dir->ops->lookup(dir, "other") == NULL);
+
+    /* Names are unique; no subdirectories */
+    ASSERT_TRUE(dir->ops->create(dir, "ring", VFS_FILE) == NULL);
+    ASSERT_TRUE(dir->ops->create(dir, "sub", VFS_DIRECTORY) == NULL);
+
+    ASSERT_TRUE(dir->ops->create(dir, "frames", VFS_FILE) != NULL);
+    VfsDirEntry entries[4];
+    ASSERT_EQ(dir->ops->readdir(dir, entries, 4), 2);
+    ASSERT_STR_EQ(entries[0].name, "ring");
+    ASSERT_STR_EQ(entries[1].name, "frames");
+
+    ShmfsStats st;
+    shmfs_get_stats(&st);
+    ASSERT_EQ(st.objects, 2);
+    ASSERT_EQ(st.pages, 0);
+    return 0;
+}
+
+TEST(write_read_across_pages) {
+    VfsNode *dir = reset_shmfs();
+    VfsNode *n = dir->ops->create(dir, "buf", VFS_FILE);
+
+    uint8_t data[6000];
+    for (int i = 0; i < 6000; i++) data[i] = (uint8_t)(i * 3);
+    ASSERT_EQ(n->ops->write(n, data, 3000, sizeof(data)), 6000);
+    ASSERT_EQ(n->size, 9000);
+    ASSERT_EQ(live_frames, 3);              /* Pages 0-2 */
+
+    uint8_t out[9000];
+    ASSERT_EQ(n->ops->read(n, out, 0, sizeof(out)), 9000);
+    for (int i = 0; i < 3000; i++) ASSERT_EQ(out[i], 0);  /* Zeroed, not garbage */
+    ASSERT_MEM_EQ(out + 3000, data, 6000);
+
+    /* Short read at the end, nothing past it */
+    ASSERT_EQ(n->ops->read(n, out, 8990, 100), 10);
+    ASSERT_EQ(n->ops->read(n, out, 9000, 100), 0);
+    return 0;
+}
+
+TEST(truncate_grows_sparse_and_shrinks) {
+    VfsNode *dir = reset_shmfs();
+    VfsNode *n = dir->ops->create(dir, "buf", VFS_FILE);
+
+    /* Growing allocates nothing; holes read as zeros */
+    n->ops->truncate(n, 4 * 1024 * 1024);
+    ASSERT_EQ(n->size, 4 * 1024 * 1024);
+    ASSERT_EQ(live_frames, 0);
+    uint8_t out[16];
+    memset(out, 0xFF, sizeof(out));
+    ASSERT_EQ(n->ops->read(n, out, 123456, sizeof(out)), 16);
+    for (int i = 0; i < 16; i++) ASSERT_EQ(out[i], 0);
+
+    /* Shrinking an unmapped object frees whole pages past the end and
+     * clears the tail of the last one */
+    uint8_t ones[3 * PAGE_SIZE];
+    memset(ones, 1, sizeof(ones));
+    ASSERT_EQ(n->ops->write(n, ones, 0, sizeof(ones)), (int)sizeof(ones));
+    ASSERT_EQ(live_frames, 3);
+    n->ops->truncate(n, 100);
+    ASSERT_EQ(live_frames, 1);
+
+    n->ops->truncate(n, 200);
+    ASSERT_EQ(n->ops->read(n, out, 96, 8), 8);
+    ASSERT_EQ(out[3], 1);
+    ASSERT_EQ(out[4], 0);
+    return 0;
+}
+
+TEST(shrink_keeps_mapped_frames) {
+    VfsNode *dir = reset_shmfs();
+    VfsNode *n = dir->ops->create(dir, "buf", VFS_FILE);
+    n->ops->truncate(n, 2 * PAGE_SIZE);
+    uint64_t f1 = shmfs_frame(n, 1);
+    ASSERT_TRUE(f1 != 0);
+    ASSERT_EQ(shmfs_frame(n, 1), f1);       /* Same frame every time */
+    memset((void *)(uintptr_t)f1, 7, PAGE_SIZE);
+
+    /* Another process may still see the frame: zero it, keep it */
+    shmfs_map_get(n);
+    n->ops->truncate(n, PAGE_SIZE);
+    ASSERT_EQ(live_frames, 1);
+    ASSERT_EQ(((uint8_t *)(uintptr_t)f1)[10], 0);
+    ASSERT_EQ(shmfs_frame(n, 1), f1);
+
+    ShmfsStats st;
+    shmfs_get_stats(&st);
+    ASSERT_EQ(st.maps, 1);
+    shmfs_map_put(n);
+    shmfs_get_stats(&st);
+    ASSERT_EQ(st.maps, 0);
+    return 0;
+}
+
+TEST(unlink_waits_for_last_reference) {
+    VfsNode *dir = reset_shmfs();
+    VfsNode *n = dir->ops->create(dir, "buf", VFS_FILE);
+    ASSERT_TRUE(shmfs_frame(n, 0) != 0);
+
+    shmfs_get(n);                           /* An open fd */
+    shmfs_map_get(n);                       /* A mapping */
+    ASSERT_EQ(dir->ops->unlink(dir, "buf"), 0);
+    ASSERT_TRUE(dir->ops->lookup(dir, "buf") == NULL);
+    ASSERT_EQ(dir->ops->unlink(dir, "buf"), -ENOENT);
+
+    /* The name is free for a new object while the old one lives on */
+    VfsNode *n2 = dir->ops->create(dir, "buf", VFS_FILE);
+    ASSERT_TRUE(n2 != NULL && n2 != n);
+
+    shmfs_put(n);
+    ASSERT_EQ(live_frames, 1);
+    shmfs_map_put(n);
+    ASSERT_EQ(live_frames, 0);
+
+    ShmfsStats st;
+    shmfs_get_stats(&st);
+    ASSERT_EQ(st.objects, 1);
+    ASSERT_EQ(st.pages, 0);
+    return 0;
+}
+
+TEST(out_of_frames) {
+    VfsNode *dir = reset_shmfs();
+    VfsNode *n = dir->ops->create(dir, "buf", VFS_FILE);
+    frame_fail = 1;
+    ASSERT_EQ(shmfs_frame(n, 0), 0);
+    uint8_t b = 1;
+    ASSERT_EQ(n->ops->write(n, &b, 0, 1), -ENOMEM);
+    ASSERT_EQ(n->size, 0);
+    return 0;
+}
+
+TEST(object_table_is_bounded) {
+    VfsNode *dir = reset_shmfs();
+    char name[8];
+    for (int i = 0; i < SHMFS_MAX_OBJECTS; i++) {
+        snprintf(name, sizeof(name), "o%d", i);
+        ASSERT_TRUE(dir->ops->create(dir, name, VFS_FILE) != NULL);
+    }
+    ASSERT_TRUE(dir->ops->create(dir, "full", VFS_FILE) == NULL);
+    ASSERT_EQ(dir->ops->unlink(dir, "o5"), 0);
+    ASSERT_TRUE(dir->ops->create(dir, "full", VFS_FILE) != NULL);
+    reset_shmfs();
+    return 0;
+}
+
+/* --- Suite --- */
+
+TestCase shmfs_tests[] = {
+    TEST_ENTRY(create_lookup_readdir),
+    TEST_ENTRY(write_read_across_pages),
+    TEST_ENTRY(truncate_grows_sparse_and_shrinks),
+    TEST_ENTRY(shrink_keeps_mapped_frames),
+    TEST_ENTRY(unlink_waits_for_last_reference),
+    TEST_ENTRY(out_of_frames),
+    TEST_ENTRY(object_table_is_bounded),
+};
+int shmfs_test_count = sizeof(shmfs_tests) / sizeof(shmfs_tests[0]);
@@ -15,6 +15,7 @@
 #define ARCHOS_PROC_THREAD_H
 #define ARCHOS_PROC_PROCESS_H
 #define ARCHOS_FS_VFS_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
 
 /* Minimal types needed by signal.c */
 typedef uint32_t tid_t;
@@ -113,7 +114,14 @@ void sig_init(SigState *ss);
 int sig_send(uint32_t pid, int signo);
 sig_handler_t sig_set_handler(SigState *ss, int signo, sig_handler_t handler);
 int64_t sig_maybe_deliver(SyscallFrame *frame, int64_t syscall_ret);
-extern uint64_t sig_pending_arg;
+
+/* Minimal PerCpu: only the signal handler argument is used */
+typedef struct {
+    uint64_t sig_arg;
+} PerCpu;
+
+static PerCpu test_cpu;
+static PerCpu *this_cpu(void) { return &test_cpu; }
 
 /* Spinlock/WaitQueue stubs */
 typedef struct { volatile uint32_t locked; uint64_t saved_flags; } Spinlock;
@@ -145,7 +153,7 @@ typedef struct Process {
 static Process test_procs[MAX_TEST_PROCS];
 static Thread test_threads[MAX_TEST_PROCS];
 static int test_current_idx = 0;
-static int sched_schedule_called = 0;
+static int sched_yield_called = 0;
 
 /* memcpy/memset via libc */
 static void *memcpy_impl(void *dst, const void *src, size_t n) {
@@ -173,8 +181,8 @@ static Thread *thread_current(void) {
     return &test_threads[test_current_idx];
 }
 
-static void sched_schedule(void) {
-    sched_schedule_called = 1;
+static void sched_yield(void) {
+    sched_yield_called = 1;
 }
 
 static int proc_foreach(void (*cb)(Process *p, void *ctx), void *ctx) {
@@ -192,6 +200,12 @@ static int sched_remove_called = 0;
 static void sched_remove_thread(Thread *t) { (void)t; sched_remove_called = 1; }
 static int sched_add_called = 0;
 static void sched_add_thread(Thread *t) { (void)t; t->state = THREAD_READY; sched_add_called = 1; }
+/* Exit stub: the zombie state and status the real teardown leaves */
+static void proc_exit(Process *p, int32_t status) {
+    p->exit_status = status;
+    p->state = PROC_ZOMBIE;
+    sched_yield();
+}
 
 /* Reset test state */
 static void test_reset(void) {
@@ -208,10 +222,10 @@ static void test_reset(void) {
         sig_init(&test_procs[i].sig);
     }
     test_current_idx = 0;
-    sched_schedule_called = 0;
+    sched_yield_called = 0;
     sched_remove_called = 0;
     sched_add_called = 0;
-    sig_pending_arg = 0;
+    test_cpu.sig_arg = 0;
 }
 
 /* Include signal.c directly */
@@ -281,7 +295,7 @@ TEST(default_sigterm_terminates) {
     sig_maybe_deliver(&frame, 0);
     ASSERT_EQ(test_procs[0].state, PROC_ZOMBIE);
     ASSERT_EQ(test_procs[0].exit_status, 128 + SIGTERM);
-    ASSERT_TRUE(sched_schedule_called);
+    ASSERT_TRUE(sched_yield_called);
     return 0;
 }
 
@@ -416,7 +430,7 @@ TEST(user_handler_modifies_frame) {
     /* Frame should be redirected to handler */
     ASSERT_EQ(frame.rcx, (uint64_t)dummy_handler);
     ASSERT_TRUE(frame.rsp < stack_top);  /* stack grew */
-    ASSERT_EQ(sig_pending_arg, SIGINT);
+    ASSERT_EQ(test_cpu.sig_arg, SIGINT);
 
     /* Callee-saved regs zeroed for handler */
     ASSERT_EQ(frame.rbx, 0);
@@ -446,7 +460,7 @@ TEST(sigtstp_default_stops) {
     sig_maybe_deliver(&frame, 0);
     ASSERT_EQ(test_procs[0].state, PROC_STOPPED);
     ASSERT_EQ(test_threads[0].state, THREAD_STOPPED);
-    ASSERT_TRUE(sched_schedule_called);
+    ASSERT_TRUE(sched_yield_called);
     ASSERT_TRUE(sched_remove_called);
     return 0;
 }
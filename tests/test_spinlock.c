@@ -1,11 +1,17 @@
-/* arc_os — Host-side tests for kernel/proc/spinlock.h */
+/* arc_os — Host-side tests for kernel/proc/spinlock.h and spinlock.c */
 
+#define _GNU_SOURCE
 #include "test_framework.h"
 #include <stdint.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 /* We cannot include the real spinlock.h because it uses privileged asm
- * (pushf/popf/cli). Reproduce the struct and provide host-safe versions. */
+ * (pushf/popf/cli). Reproduce the header with host-safe IRQ helpers, then
+ * include the real spinlock.c so the MCS queue and rwlock run under pthreads. */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
 
 typedef struct {
     volatile uint32_t locked;
@@ -14,17 +20,81 @@ typedef struct {
 
 #define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
 
+#define SPINLOCK_LOCKED       1u
+#define SPINLOCK_LOCKED_MASK  0x000000FFu
+#define SPINLOCK_TAIL_SHIFT   16
+#define SPINLOCK_TAIL_MASK    0xFFFF0000u
+#define MCS_NODES_PER_CPU 4
+
+typedef struct McsNode {
+    struct McsNode *volatile next;
+    volatile uint32_t        locked;
+} McsNode;
+
+static inline uint64_t spin_irq_save(void) { return 0; }  /* No real flags on host */
+static inline void spin_irq_restore(uint64_t flags) { (void)flags; }
+
+/* Preemption is a kernel notion: host threads have no preempt count */
+static inline void preempt_disable(void) { }
+static inline void preempt_enable(void) { }
+
+/* Host threads can be preempted while queued (the kernel spins with IRQs
+ * off), so yield instead of burning the holder's timeslice.  Raw syscall:
+ * the test runner links the kernel's own sched_yield() from test_sched.c. */
+static inline void cpu_relax(void) { syscall(SYS_sched_yield); }
+
+void spinlock_acquire_slow(Spinlock *lock);
+
 static inline void spinlock_acquire(Spinlock *lock) {
-    while (__sync_lock_test_and_set(&lock->locked, 1)) {
-        /* spin */
+    uint64_t flags = spin_irq_save();
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&lock->locked, &expected, SPINLOCK_LOCKED,
+                                     0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        spinlock_acquire_slow(lock);
     }
-    lock->saved_flags = 0;  /* No real flags on host */
+    lock->saved_flags = flags;
 }
 
 static inline void spinlock_release(Spinlock *lock) {
-    __sync_lock_release(&lock->locked);
+    uint64_t flags = lock->saved_flags;
+    __atomic_store_n((volatile uint8_t *)&lock->locked, 0, __ATOMIC_RELEASE);
+    spin_irq_restore(flags);
+}
+
+typedef struct {
+    volatile uint32_t cnts;
+    Spinlock wait_lock;
+    uint64_t saved_flags;
+} RwSpinlock;
+
+#define RWSPINLOCK_INIT { .cnts = 0, .wait_lock = SPINLOCK_INIT, .saved_flags = 0 }
+#define RWLOCK_WLOCKED   0x000000FFu
+#define RWLOCK_WWAITING  0x00000100u
+#define RWLOCK_WMASK     (RWLOCK_WLOCKED | RWLOCK_WWAITING)
+#define RWLOCK_RBIAS     0x00000200u
+
+/* Minimal PerCpu: each pthread plays one CPU */
+#define MAX_CPUS 16
+typedef struct {
+    uint32_t cpu_id;
+    McsNode  mcs_nodes[MCS_NODES_PER_CPU];
+    uint32_t mcs_depth;
+} PerCpu;
+
+static PerCpu percpu_data[MAX_CPUS];
+static __thread PerCpu *test_this_cpu;
+
+static PerCpu *this_cpu(void) { return test_this_cpu; }
+
+static void test_bind_cpu(uint32_t id) {
+    percpu_data[id].cpu_id = id;
+    percpu_data[id].mcs_depth = 0;
+    test_this_cpu = &percpu_data[id];
 }
 
+/* Include the real queued-spinlock implementation */
+#include "../kernel/proc/spinlock.c"
+
 /* --- Tests --- */
 
 TEST(init_state) {
@@ -86,13 +156,16 @@ TEST(multiple_locks_independent) {
     return 0;
 }
 
-/* Contention test: 2 pthreads × 100K increments == 200K */
+/* Contention test: 4 pthreads x 100K increments == 400K */
+#define CONTENTION_THREADS 4
+#define CONTENTION_ITERS   100000
+
 static Spinlock contention_lock = SPINLOCK_INIT;
 static volatile int contention_counter = 0;
 
 static void *contention_worker(void *arg) {
-    (void)arg;
-    for (int i = 0; i < 100000; i++) {
+    test_bind_cpu((uint32_t)(uintptr_t)arg);
+    for (int i = 0; i < CONTENTION_ITERS; i++) {
         spinlock_acquire(&contention_lock);
         contention_counter++;
         spinlock_release(&contention_lock);
@@ -104,13 +177,146 @@ TEST(contention) {
     contention_lock = (Spinlock)SPINLOCK_INIT;
     contention_counter = 0;
 
-    pthread_t t1, t2;
-    pthread_create(&t1, NULL, contention_worker, NULL);
-    pthread_create(&t2, NULL, contention_worker, NULL);
-    pthread_join(t1, NULL);
-    pthread_join(t2, NULL);
+    pthread_t t[CONTENTION_THREADS];
+    for (int i = 0; i < CONTENTION_THREADS; i++)
+        pthread_create(&t[i], NULL, contention_worker, (void *)(uintptr_t)(i + 1));
+    for (int i = 0; i < CONTENTION_THREADS; i++)
+        pthread_join(t[i], NULL);
+
+    ASSERT_EQ(contention_counter, CONTENTION_THREADS * CONTENTION_ITERS);
+    /* Queue fully drained: no tail left behind */
+    ASSERT_EQ(contention_lock.locked, 0);
+    return 0;
+}
+
+TEST(tail_encoding_roundtrip) {
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        for (uint32_t idx = 0; idx < MCS_NODES_PER_CPU; idx++) {
+            uint32_t tail = mcs_encode_tail(cpu, idx);
+            ASSERT_TRUE(tail != 0);
+            ASSERT_EQ(tail & SPINLOCK_LOCKED_MASK, 0);
+            ASSERT_TRUE(mcs_decode_tail(tail) == &percpu_data[cpu].mcs_nodes[idx]);
+        }
+    }
+    return 0;
+}
+
+/* Slow path on an uncontended lock: queue, become head, clear our tail. */
+TEST(slow_path_uncontended) {
+    test_bind_cpu(0);
+    Spinlock lock = SPINLOCK_INIT;
+    spinlock_acquire_slow(&lock);
+    ASSERT_EQ(lock.locked, SPINLOCK_LOCKED);
+    ASSERT_EQ(percpu_data[0].mcs_depth, 0);
+    spinlock_release(&lock);
+    ASSERT_EQ(lock.locked, 0);
+    return 0;
+}
+
+/* A queued waiter keeps the lock word's tail set until it takes the lock. */
+static Spinlock handoff_lock = SPINLOCK_INIT;
+static volatile int handoff_acquired = 0;
+
+static void *handoff_waiter(void *arg) {
+    (void)arg;
+    test_bind_cpu(2);
+    spinlock_acquire(&handoff_lock);
+    handoff_acquired = 1;
+    spinlock_release(&handoff_lock);
+    return NULL;
+}
+
+TEST(waiter_publishes_tail) {
+    test_bind_cpu(1);
+    handoff_lock = (Spinlock)SPINLOCK_INIT;
+    handoff_acquired = 0;
+    spinlock_acquire(&handoff_lock);
+
+    pthread_t t;
+    pthread_create(&t, NULL, handoff_waiter, NULL);
+    while ((__atomic_load_n(&handoff_lock.locked, __ATOMIC_ACQUIRE) & SPINLOCK_TAIL_MASK) == 0) {
+        /* wait for waiter to enqueue */
+    }
+    ASSERT_EQ(handoff_lock.locked & SPINLOCK_TAIL_MASK, mcs_encode_tail(2, 0));
+    ASSERT_EQ(handoff_acquired, 0);
+
+    spinlock_release(&handoff_lock);
+    pthread_join(t, NULL);
+    ASSERT_EQ(handoff_acquired, 1);
+    ASSERT_EQ(handoff_lock.locked, 0);
+    return 0;
+}
+
+/* --- Reader-writer spinlock --- */
+
+TEST(rwlock_readers_share) {
+    RwSpinlock rw = RWSPINLOCK_INIT;
+    uint64_t f1 = rwlock_read_acquire(&rw);
+    uint64_t f2 = rwlock_read_acquire(&rw);
+    ASSERT_EQ(rw.cnts, 2 * RWLOCK_RBIAS);
+    rwlock_read_release(&rw, f2);
+    rwlock_read_release(&rw, f1);
+    ASSERT_EQ(rw.cnts, 0);
+    return 0;
+}
+
+TEST(rwlock_writer_exclusive) {
+    RwSpinlock rw = RWSPINLOCK_INIT;
+    rwlock_write_acquire(&rw);
+    ASSERT_EQ(rw.cnts, RWLOCK_WLOCKED);
+    rwlock_write_release(&rw);
+    ASSERT_EQ(rw.cnts, 0);
+    return 0;
+}
+
+/* Mixed readers and writers: writers bump two counters together; readers
+ * must never observe them out of step. */
+#define RW_ITERS 20000
+
+static RwSpinlock mixed_rw = RWSPINLOCK_INIT;
+static volatile int mixed_a, mixed_b;
+static volatile int mixed_torn;
+
+static void *rw_writer(void *arg) {
+    test_bind_cpu((uint32_t)(uintptr_t)arg);
+    for (int i = 0; i < RW_ITERS; i++) {
+        rwlock_write_acquire(&mixed_rw);
+        mixed_a++;
+        mixed_b++;
+        rwlock_write_release(&mixed_rw);
+    }
+    return NULL;
+}
+
+static void *rw_reader(void *arg) {
+    test_bind_cpu((uint32_t)(uintptr_t)arg);
+    for (int i = 0; i < RW_ITERS; i++) {
+        uint64_t f = rwlock_read_acquire(&mixed_rw);
+        if (mixed_a != mixed_b) mixed_torn = 1;
+        rwlock_read_release(&mixed_rw, f);
+    }
+    return NULL;
+}
+
+TEST(rwlock_mixed_contention) {
+    mixed_rw = (RwSpinlock)RWSPINLOCK_INIT;
+    mixed_a = mixed_b = 0;
+    mixed_torn = 0;
+
+    pthread_t w1, w2, r1, r2;
+    pthread_create(&w1, NULL, rw_writer, (void *)(uintptr_t)1);
+    pthread_create(&r1, NULL, rw_reader, (void *)(uintptr_t)2);
+    pthread_create(&w2, NULL, rw_writer, (void *)(uintptr_t)3);
+    pthread_create(&r2, NULL, rw_reader, (void *)(uintptr_t)4);
+    pthread_join(w1, NULL);
+    pthread_join(w2, NULL);
+    pthread_join(r1, NULL);
+    pthread_join(r2, NULL);
 
-    ASSERT_EQ(contention_counter, 200000);
+    ASSERT_EQ(mixed_a, 2 * RW_ITERS);
+    ASSERT_EQ(mixed_b, 2 * RW_ITERS);
+    ASSERT_EQ(mixed_torn, 0);
+    ASSERT_EQ(mixed_rw.cnts, 0);
     return 0;
 }
 
@@ -139,6 +345,12 @@ TestCase spinlock_tests[] = {
     TEST_ENTRY(reacquire_after_release),
     TEST_ENTRY(multiple_locks_independent),
     TEST_ENTRY(contention),
+    TEST_ENTRY(tail_encoding_roundtrip),
+    TEST_ENTRY(slow_path_uncontended),
+    TEST_ENTRY(waiter_publishes_tail),
+    TEST_ENTRY(rwlock_readers_share),
+    TEST_ENTRY(rwlock_writer_exclusive),
+    TEST_ENTRY(rwlock_mixed_contention),
     TEST_ENTRY(struct_size),
     TEST_ENTRY(acquire_release_cycle),
 };
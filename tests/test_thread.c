@@ -8,6 +8,7 @@
 #define ARCHOS_LIB_KPRINTF_H
 #define ARCHOS_MM_KMALLOC_H
 #define ARCHOS_LIB_MEM_H        /* Use libc memset/memcpy */
+#define ARCHOS_PROC_SCHED_H
 
 /* Stub kprintf */
 static inline void kprintf(const char *fmt, ...) { (void)fmt; }
@@ -76,6 +77,9 @@ static void kfree(void *ptr) {
     free(ptr);
 }
 
+/* Scheduler stub: only the trampoline calls it */
+static void sched_schedule_tail(void) { }
+
 /* Stub context_switch — never actually called from thread.c, but declared extern */
 void context_switch(ThreadContext *old, ThreadContext *new_ctx) {
     (void)old; (void)new_ctx;
@@ -6,9 +6,14 @@
 /* Guard kernel headers that we stub */
 #define ARCHOS_LIB_KPRINTF_H
 #define ARCHOS_MM_KMALLOC_H
+#define ARCHOS_MM_PMM_H
+#define ARCHOS_MM_VMM_H
 #define ARCHOS_LIB_MEM_H        /* Use libc memcpy/memset */
 #define ARCHOS_LIB_STRING_H     /* Use libc string functions */
 #define ARCHOS_PROC_PROCESS_H   /* We define our own minimal Process */
+#define ARCHOS_PROC_RCU_H
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_PREEMPT_H
 
 /* Stub kprintf */
 static inline void kprintf(const char *fmt, ...) { (void)fmt; }
@@ -41,6 +46,28 @@ static void *krealloc(void *ptr, size_t new_size) {
     return realloc(ptr, new_size);
 }
 
+/* PMM stub for ramfs pages: frames are host pages, "physical" addresses
+ * are their pointers (HHDM offset 0). Filled with garbage to catch
+ * missing zeroing. */
+#define PAGE_SIZE 4096
+static int live_frames;
+static int frame_fail;
+
+static uint64_t pmm_alloc_page(void) {
+    if (frame_fail) return 0;
+    void *p = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    memset(p, 0xAA, PAGE_SIZE);
+    live_frames++;
+    return (uint64_t)(uintptr_t)p;
+}
+
+static void pmm_free_page(uint64_t phys) {
+    live_frames--;
+    free((void *)(uintptr_t)phys);
+}
+
+static uint64_t vmm_get_hhdm_offset(void) { return 0; }
+
 /* proc_current stub — controllable for permission tests */
 typedef uint32_t uid_t;
 typedef uint32_t gid_t;
@@ -56,8 +83,31 @@ typedef struct Process {
 static Process *vfs_test_proc_ptr = NULL;
 static Process *proc_current(void) { return vfs_test_proc_ptr; }
 
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+
+/* RCU stubs — single-threaded tests have no concurrent readers */
+static int rcu_read_depth;
+static inline void rcu_read_lock(void) { rcu_read_depth++; }
+static inline void rcu_read_unlock(void) { rcu_read_depth--; }
+#define rcu_dereference(p)        (p)
+#define rcu_assign_pointer(p, v)  ((p) = (v))
+
+/* Preemption point stub — counts the points large transfers pass */
+static int cond_resched_calls;
+static void cond_resched(void) { cond_resched_calls++; }
+
 /* Include the implementations directly */
 #include "../kernel/fs/vfs.c"
+#include "../kernel/fs/dcache.c"
 #include "../kernel/fs/ramfs.c"
 
 /* Helper: reset VFS + ramfs state for each test */
@@ -68,7 +118,10 @@ static void reset_vfs(void) {
     next_inode = 1;
     kmalloc_fail_after = 0;
     kmalloc_call_seq = 0;
+    frame_fail = 0;
     vfs_test_proc_ptr = NULL;
+    cond_resched_calls = 0;
+    memset(&stats, 0, sizeof(stats));
 }
 
 static void setup_vfs(void) {
@@ -143,6 +196,19 @@ static int test_open_existing_file(void) {
     return 0;
 }
 
+static int test_open_excl_fails_if_exists(void) {
+    setup_vfs();
+    VfsFile f;
+    ASSERT_EQ(vfs_open("/lock", O_CREAT | O_EXCL | O_RDWR, &f), 0);
+    vfs_close(&f);
+    ASSERT_EQ(vfs_open("/lock", O_CREAT | O_EXCL | O_RDWR, &f), -EEXIST);
+
+    /* O_EXCL means nothing without O_CREAT */
+    ASSERT_EQ(vfs_open("/lock", O_EXCL | O_RDWR, &f), 0);
+    vfs_close(&f);
+    return 0;
+}
+
 static int test_open_nonexistent_fails(void) {
     setup_vfs();
     VfsFile f;
@@ -213,6 +279,37 @@ static int test_write_grows_file(void) {
     return 0;
 }
 
+static int test_large_io_has_preemption_points(void) {
+    setup_vfs();
+    VfsFile f;
+    ASSERT_EQ(vfs_open("/huge.bin", O_CREAT | O_RDWR, &f), 0);
+
+    /* Two and a half chunks: the filesystem sees three calls */
+    uint32_t size = VFS_IO_CHUNK * 2 + VFS_IO_CHUNK / 2;
+    uint8_t *data = malloc(size);
+    for (uint32_t i = 0; i < size; i++) data[i] = (uint8_t)(i * 7);
+    ASSERT_EQ(vfs_write(&f, data, size), (int)size);
+    ASSERT_EQ(f.offset, size);
+    ASSERT_EQ(cond_resched_calls, 2);
+
+    /* Reads stop at end of file without an extra chunk */
+    vfs_seek(&f, 0, SEEK_SET);
+    uint8_t *back = malloc(size + 100);
+    ASSERT_EQ(vfs_read(&f, back, size + 100), (int)size);
+    ASSERT_MEM_EQ(back, data, size);
+    ASSERT_EQ(cond_resched_calls, 4);
+
+    /* Small transfers have none */
+    vfs_seek(&f, 0, SEEK_SET);
+    ASSERT_EQ(vfs_read(&f, back, 100), 100);
+    ASSERT_EQ(cond_resched_calls, 4);
+
+    free(data);
+    free(back);
+    vfs_close(&f);
+    return 0;
+}
+
 static int test_seek_set_cur_end(void) {
     setup_vfs();
     VfsFile f;
@@ -345,30 +442,94 @@ static int test_open_creat_trunc_new_file(void) {
     return 0;
 }
 
-static int test_ramfs_max_children_boundary(void) {
+static int test_ramfs_many_children(void) {
     setup_vfs();
+    ASSERT_EQ(vfs_mkdir("/big", 0755), 0);
+    VfsNode *dir = vfs_resolve("/big");
+    RamfsDir *d = to_ramfs(dir)->dir;
     char name[32];
-    for (int i = 0; i < 128; i++) {
-        sprintf(name, "/file%d.txt", i);
-        VfsFile f;
-        ASSERT_EQ(vfs_open(name, O_CREAT | O_RDWR, &f), 0);
-        vfs_close(&f);
+    for (int i = 0; i < 100000; i++) {
+        sprintf(name, "f%d", i);
+        ASSERT_TRUE(dir->ops->create(dir, name, VFS_FILE) != NULL);
     }
-    /* 129th should fail */
+    ASSERT_EQ(d->count, 100000);
+    ASSERT_TRUE(d->nbuckets >= d->count);
+    ASSERT_TRUE(dir->ops->create(dir, "f99999", VFS_FILE) == NULL);
+    ASSERT_TRUE(dir->ops->lookup(dir, "f31337") != NULL);
+    ASSERT_TRUE(dir->ops->lookup(dir, "f100000") == NULL);
+
+    /* Through the VFS, directories too */
+    ASSERT_EQ(vfs_mkdir("/big/sub", 0755), 0);
     VfsFile f;
-    int ret = vfs_open("/overflow.txt", O_CREAT | O_RDWR, &f);
-    ASSERT_EQ(ret, -ENOMEM);
+    ASSERT_EQ(vfs_open("/big/f4242", O_RDWR, &f), 0);
+
+    /* Emptying the directory gives back its tables */
+    for (int i = 0; i < 100000; i++) {
+        sprintf(name, "f%d", i);
+        ASSERT_EQ(dir->ops->unlink(dir, name), 0);
+    }
+    ASSERT_TRUE(dir->ops->lookup(dir, "f31337") == NULL);
+    ASSERT_EQ(d->count, 1);
+    ASSERT_EQ(d->order_cap, RAMFS_DIR_MIN);
+    ASSERT_EQ(d->nbuckets, RAMFS_DIR_MIN);
+    ASSERT_EQ(vfs_unlink("/big/sub"), 0);
+    ASSERT_EQ(d->order_len, 0);
     return 0;
 }
 
-static int test_ramfs_max_children_mkdir(void) {
+static int test_ramfs_create_out_of_memory(void) {
     setup_vfs();
+    ASSERT_EQ(vfs_mkdir("/d", 0755), 0);
+    VfsNode *dir = vfs_resolve("/d");
+
+    /* The node and hash table are allocated, then the entry is not */
+    kmalloc_call_seq = 0;
+    kmalloc_fail_after = 3;
+    ASSERT_TRUE(dir->ops->create(dir, "x", VFS_FILE) == NULL);
+    kmalloc_fail_after = 0;
+    ASSERT_TRUE(dir->ops->lookup(dir, "x") == NULL);
+    ASSERT_TRUE(dir->ops->create(dir, "x", VFS_FILE) != NULL);
+    ASSERT_TRUE(dir->ops->lookup(dir, "x") != NULL);
+    return 0;
+}
+
+static int test_ramfs_readdir_cursor_stable(void) {
+    setup_vfs();
+    ASSERT_EQ(vfs_mkdir("/d", 0755), 0);
+    VfsNode *dir = vfs_resolve("/d");
     char name[32];
-    for (int i = 0; i < 128; i++) {
-        sprintf(name, "/dir%d", i);
-        ASSERT_EQ(vfs_mkdir(name, 0755), 0);
+    for (char c = 'a'; c <= 'j'; c++) {
+        sprintf(name, "%c", c);
+        ASSERT_TRUE(dir->ops->create(dir, name, VFS_FILE) != NULL);
+    }
+
+    VfsDirEntry e[4];
+    uint64_t cursor = 0;
+    ASSERT_EQ(vfs_readdir_at("/d", &cursor, e, 4), 4);
+    ASSERT_STR_EQ(e[0].name, "a");
+    ASSERT_STR_EQ(e[3].name, "d");
+
+    /* Changes behind the cursor, ahead of it, and enough churn to
+     * squeeze and grow the slot array */
+    ASSERT_EQ(dir->ops->unlink(dir, "b"), 0);
+    ASSERT_EQ(dir->ops->unlink(dir, "e"), 0);
+    for (int i = 0; i < 100; i++) {
+        sprintf(name, "tmp%d", i);
+        ASSERT_TRUE(dir->ops->create(dir, name, VFS_FILE) != NULL);
     }
-    ASSERT_EQ(vfs_mkdir("/overflow_dir", 0755), -ENOMEM);
+    for (int i = 0; i < 100; i++) {
+        sprintf(name, "tmp%d", i);
+        ASSERT_EQ(dir->ops->unlink(dir, name), 0);
+    }
+    ASSERT_TRUE(dir->ops->create(dir, "k", VFS_FILE) != NULL);
+
+    ASSERT_EQ(vfs_readdir_at("/d", &cursor, e, 4), 4);
+    ASSERT_STR_EQ(e[0].name, "f");
+    ASSERT_STR_EQ(e[3].name, "i");
+    ASSERT_EQ(vfs_readdir_at("/d", &cursor, e, 4), 2);
+    ASSERT_STR_EQ(e[0].name, "j");
+    ASSERT_STR_EQ(e[1].name, "k");
+    ASSERT_EQ(vfs_readdir_at("/d", &cursor, e, 4), 0);
     return 0;
 }
 
@@ -550,6 +711,96 @@ static int test_stat_directory_size_zero(void) {
     return 0;
 }
 
+/* --- ramfs page tests --- */
+
+static int test_ramfs_sparse_file_holes(void) {
+    setup_vfs();
+    int frames = live_frames;
+    VfsFile f;
+    ASSERT_EQ(vfs_open("/sparse", O_CREAT | O_RDWR, &f), 0);
+
+    /* A write 10 MiB in holds one page; the rest reads as zeros */
+    ASSERT_EQ(vfs_seek(&f, 10 * 1024 * 1024 - 2, SEEK_SET), VFS_OK);
+    ASSERT_EQ(vfs_write(&f, "abcd", 4), 4);
+    ASSERT_EQ(f.node->size, 10 * 1024 * 1024 + 2);
+    ASSERT_EQ(to_ramfs(f.node)->nr_pages, 2);       /* Straddles a page boundary */
+    ASSERT_EQ(live_frames, frames + 2);
+
+    char buf[8];
+    ASSERT_EQ(vfs_seek(&f, 10 * 1024 * 1024 - 6, SEEK_SET), VFS_OK);
+    ASSERT_EQ(vfs_read(&f, buf, 8), 8);
+    ASSERT_MEM_EQ(buf, "\0\0\0\0abcd", 8);
+    ASSERT_EQ(vfs_seek(&f, 4096, SEEK_SET), VFS_OK);
+    ASSERT_EQ(vfs_read(&f, buf, 8), 8);
+    ASSERT_MEM_EQ(buf, "\0\0\0\0\0\0\0\0", 8);
+
+    /* Unlinking gives every page back */
+    ASSERT_EQ(vfs_unlink("/sparse"), 0);
+    ASSERT_EQ(live_frames, frames);
+    return 0;
+}
+
+static int test_ramfs_truncate_frees_pages(void) {
+    setup_vfs();
+    int frames = live_frames;
+    VfsFile f;
+    ASSERT_EQ(vfs_open("/big", O_CREAT | O_RDWR, &f), 0);
+
+    /* 1 MiB in odd-sized appends, through two levels of the tree */
+    static uint8_t chunk[3000];
+    uint32_t len = 1024 * 1024;
+    for (uint32_t off = 0; off < len; off += sizeof(chunk)) {
+        uint32_t n = (len - off < sizeof(chunk)) ? len - off : sizeof(chunk);
+        for (uint32_t i = 0; i < n; i++) chunk[i] = (uint8_t)((off + i) * 7);
+        ASSERT_EQ(vfs_write(&f, chunk, n), (int)n);
+    }
+    RamfsNode *rn = to_ramfs(f.node);
+    ASSERT_EQ(rn->nr_pages, 256);
+    ASSERT_EQ(rn->height, 2);
+    ASSERT_EQ(vfs_seek(&f, 700001, SEEK_SET), VFS_OK);
+    ASSERT_EQ(vfs_read(&f, chunk, 3), 3);
+    ASSERT_EQ(chunk[0], (uint8_t)(700001 * 7));
+    ASSERT_EQ(chunk[2], (uint8_t)(700003 * 7));
+
+    /* Shrinking frees whole pages and the levels no longer needed */
+    f.node->ops->truncate(f.node, 5000);
+    ASSERT_EQ(rn->nr_pages, 2);
+    ASSERT_EQ(rn->height, 1);
+    ASSERT_EQ(live_frames, frames + 2);
+
+    /* Growing again reads zeros past the old end */
+    f.node->ops->truncate(f.node, 9000);
+    ASSERT_EQ(f.node->size, 9000);
+    ASSERT_EQ(rn->nr_pages, 2);
+    ASSERT_EQ(vfs_seek(&f, 4999, SEEK_SET), VFS_OK);
+    ASSERT_EQ(vfs_read(&f, chunk, 3), 3);
+    ASSERT_EQ(chunk[0], (uint8_t)(4999 * 7));
+    ASSERT_EQ(chunk[1], 0);
+    ASSERT_EQ(chunk[2], 0);
+
+    f.node->ops->truncate(f.node, 0);
+    ASSERT_EQ(rn->nr_pages, 0);
+    ASSERT_TRUE(rn->pages == NULL);
+    ASSERT_EQ(live_frames, frames);
+    return 0;
+}
+
+static int test_ramfs_write_out_of_pages(void) {
+    setup_vfs();
+    VfsFile f;
+    ASSERT_EQ(vfs_open("/full", O_CREAT | O_RDWR, &f), 0);
+    static uint8_t data[8192];
+    ASSERT_EQ(vfs_write(&f, data, 100), 100);
+
+    /* With no free frames, only what fits in held pages is written */
+    frame_fail = 1;
+    ASSERT_EQ(vfs_write(&f, data, sizeof(data)), 4096 - 100);
+    ASSERT_EQ(f.node->size, 4096);
+    ASSERT_EQ(vfs_write(&f, data, sizeof(data)), -ENOMEM);
+    ASSERT_EQ(f.node->size, 4096);
+    return 0;
+}
+
 /* --- Multi-mount tests --- */
 
 static int test_mount_multiple(void) {
@@ -601,6 +852,368 @@ static int test_mount_duplicate_rejected(void) {
     return 0;
 }
 
+static int list_three(VfsNode *dir, VfsDirEntry *entries, uint32_t max) {
+    (void)dir;
+    static const char *const names[] = { "one", "two", "three" };
+    uint32_t n = max < 3 ? max : 3;
+    for (uint32_t i = 0; i < n; i++) {
+        strcpy(entries[i].name, names[i]);
+        entries[i].inode_num = 100 + i;
+        entries[i].type = VFS_FILE;
+    }
+    return (int)n;
+}
+static const VfsOps list_three_ops = { .readdir = list_three };
+
+static int test_readdir_at_batches(void) {
+    setup_vfs();
+    ASSERT_EQ(vfs_mkdir("/x", 0755), 0);
+    ASSERT_EQ(vfs_mkdir("/y", 0755), 0);
+    VfsNode *mnt = kmalloc(sizeof(VfsNode), GFP_ZERO);
+    mnt->type = VFS_DIRECTORY;
+    mnt->ops = &list_three_ops;
+    ASSERT_EQ(vfs_mount("/mnt", mnt), 0);
+
+    /* One at a time: the root's entries, then its mount points */
+    const char *want[] = { "x", "y", "mnt" };
+    VfsDirEntry e[2];
+    uint64_t cursor = 0;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(vfs_readdir_at("/", &cursor, e, 1), 1);
+        ASSERT_STR_EQ(e[0].name, want[i]);
+    }
+    ASSERT_EQ(vfs_readdir_at("/", &cursor, e, 1), 0);
+
+    /* Without readdir_at the VFS pages through readdir */
+    cursor = 0;
+    ASSERT_EQ(vfs_readdir_at("/mnt", &cursor, e, 2), 2);
+    ASSERT_STR_EQ(e[1].name, "two");
+    ASSERT_EQ(vfs_readdir_at("/mnt", &cursor, e, 2), 1);
+    ASSERT_STR_EQ(e[0].name, "three");
+    ASSERT_EQ(vfs_readdir_at("/mnt", &cursor, e, 2), 0);
+    kfree(mnt);
+    return 0;
+}
+
+/* --- Durability tests --- */
+
+static int sync_calls;
+static int sync_result;
+static int counting_sync(VfsNode *node) {
+    (void)node;
+    sync_calls++;
+    return sync_result;
+}
+static const VfsOps syncing_ops = { .sync = counting_sync };
+
+static int test_fsync_uses_sync_op(void) {
+    setup_vfs();
+    VfsFile f;
+
+    /* ramfs caches nothing: fsync succeeds without a hook */
+    ASSERT_EQ(vfs_open("/log", O_CREAT | O_RDWR, &f), 0);
+    ASSERT_EQ(vfs_fsync(&f), 0);
+
+    VfsNode disk_file = { .type = VFS_FILE, .ops = &syncing_ops };
+    f.node = &disk_file;
+    sync_calls = 0;
+    sync_result = 0;
+    ASSERT_EQ(vfs_fsync(&f), 0);
+    ASSERT_EQ(sync_calls, 1);
+    sync_result = -EIO;
+    ASSERT_EQ(vfs_fsync(&f), -EIO);
+    sync_result = 0;
+
+    /* Pipes and the like have nothing to make durable */
+    VfsNode pipe = { .type = VFS_PIPE, .ops = &syncing_ops };
+    f.node = &pipe;
+    ASSERT_EQ(vfs_fsync(&f), -EINVAL);
+    ASSERT_EQ(sync_calls, 2);
+    return 0;
+}
+
+static int test_sync_visits_mounts(void) {
+    setup_vfs();
+    VfsNode disk_a = { .type = VFS_DIRECTORY, .ops = &syncing_ops };
+    VfsNode disk_b = { .type = VFS_DIRECTORY, .ops = &syncing_ops };
+    VfsNode plain = { .type = VFS_DIRECTORY };
+    ASSERT_EQ(vfs_mount("/a", &disk_a), 0);
+    ASSERT_EQ(vfs_mount("/p", &plain), 0);
+    ASSERT_EQ(vfs_mount("/b", &disk_b), 0);
+
+    sync_calls = 0;
+    sync_result = 0;
+    ASSERT_EQ(vfs_sync(), 0);
+    ASSERT_EQ(sync_calls, 2);
+
+    /* Every filesystem is still synced when one fails */
+    sync_result = -EIO;
+    ASSERT_EQ(vfs_sync(), -EIO);
+    ASSERT_EQ(sync_calls, 4);
+    sync_result = 0;
+    return 0;
+}
+
+/* --- Readahead tests --- */
+
+#define RA_LOG_MAX 16
+static struct { uint64_t offset; uint32_t size; } ra_log[RA_LOG_MAX];
+static int ra_calls;
+
+static int zero_read(VfsNode *node, void *buf, uint32_t offset, uint32_t size) {
+    if (offset >= node->size) return 0;
+    if (size > node->size - offset) size = (uint32_t)(node->size - offset);
+    memset(buf, 0, size);
+    return (int)size;
+}
+static void logging_readahead(VfsNode *node, uint64_t offset, uint32_t size) {
+    (void)node;
+    if (ra_calls < RA_LOG_MAX) {
+        ra_log[ra_calls].offset = offset;
+        ra_log[ra_calls].size = size;
+    }
+    ra_calls++;
+}
+static const VfsOps ra_ops = { .read = zero_read, .readahead = logging_readahead };
+
+static int test_readahead_follows_sequential_reads(void) {
+    VfsNode node = { .type = VFS_FILE, .size = 1024 * 1024, .ops = &ra_ops };
+    VfsFile f = { .node = &node, .flags = O_RDONLY };
+    static uint8_t buf[4096];
+    ra_calls = 0;
+
+    /* The first read opens a window just past it */
+    ASSERT_EQ(vfs_read(&f, buf, 4096), 4096);
+    ASSERT_EQ(ra_calls, 1);
+    ASSERT_EQ(ra_log[0].offset, 4096);
+    ASSERT_EQ(ra_log[0].size, VFS_RA_MIN);
+
+    /* Reading into it requests the next, twice as large */
+    ASSERT_EQ(vfs_read(&f, buf, 4096), 4096);
+    ASSERT_EQ(ra_calls, 2);
+    ASSERT_EQ(ra_log[1].offset, 4096 + VFS_RA_MIN);
+    ASSERT_EQ(ra_log[1].size, 2 * VFS_RA_MIN);
+    for (int i = 0; i < 3; i++) ASSERT_EQ(vfs_read(&f, buf, 4096), 4096);
+    ASSERT_EQ(ra_calls, 2);                 /* Still inside the first window */
+    ASSERT_EQ(vfs_read(&f, buf, 4096), 4096);
+    ASSERT_EQ(ra_calls, 3);
+    ASSERT_EQ(ra_log[2].size, 4 * VFS_RA_MIN);
+    ASSERT_EQ(f.ra.misses, 1);
+    ASSERT_EQ(f.ra.hits, 5);
+
+    /* Windows stop growing at VFS_RA_MAX and at the end of the file */
+    while (vfs_read(&f, buf, 4096) > 0) { }
+    for (int i = 3; i < ra_calls; i++) {
+        ASSERT_TRUE(ra_log[i].size <= VFS_RA_MAX);
+        ASSERT_TRUE(ra_log[i].offset + ra_log[i].size <= node.size);
+    }
+    ASSERT_EQ(f.ra.bytes, node.size - 4096);
+    return 0;
+}
+
+static int test_readahead_stops_on_seek(void) {
+    VfsNode node = { .type = VFS_FILE, .size = 1024 * 1024, .ops = &ra_ops };
+    VfsFile f = { .node = &node, .flags = O_RDONLY };
+    static uint8_t buf[512];
+    ra_calls = 0;
+    ASSERT_EQ(vfs_read(&f, buf, 512), 512);
+    ASSERT_EQ(ra_calls, 1);
+
+    /* Random reads request nothing and count as misses */
+    for (int i = 1; i <= 4; i++) {
+        ASSERT_EQ(vfs_seek(&f, i * 100000, SEEK_SET), VFS_OK);
+        ASSERT_EQ(vfs_read(&f, buf, 512), 512);
+    }
+    ASSERT_EQ(ra_calls, 1);
+    ASSERT_EQ(f.ra.size, 0);
+    ASSERT_EQ(f.ra.misses, 5);
+
+    /* A sequential read after one of them starts a new stream */
+    ASSERT_EQ(vfs_read(&f, buf, 512), 512);
+    ASSERT_EQ(ra_calls, 2);
+    ASSERT_EQ(ra_log[1].offset, 400000 + 1024);
+
+    /* Filesystems without the hook keep no state */
+    VfsNode plain = { .type = VFS_FILE, .size = 4096, .ops = &ra_ops };
+    static const VfsOps no_ra_ops = { .read = zero_read };
+    plain.ops = &no_ra_ops;
+    VfsFile g = { .node = &plain, .flags = O_RDONLY };
+    ASSERT_EQ(vfs_read(&g, buf, 512), 512);
+    ASSERT_EQ(g.ra.misses, 0);
+    return 0;
+}
+
+/* --- Dentry cache tests --- */
+
+/* A mounted directory counting the lookups that reach it */
+static int fs_lookups;
+static VfsNode fs_child = { .inode_num = 9101, .type = VFS_FILE };
+static VfsNode *counting_lookup(VfsNode *dir, const char *name) {
+    (void)dir;
+    fs_lookups++;
+    return strcmp(name, "present") == 0 ? &fs_child : NULL;
+}
+static const VfsOps counting_dir_ops = { .lookup = counting_lookup };
+
+static int test_dcache_repeat_lookups_cached(void) {
+    setup_vfs();
+    VfsNode disk = { .type = VFS_DIRECTORY, .flags = VFS_NODE_DCACHE,
+                     .ops = &counting_dir_ops };
+    ASSERT_EQ(vfs_mount("/disk", &disk), 0);
+    fs_lookups = 0;
+
+    VfsStat st;
+    ASSERT_EQ(vfs_stat("/disk/present", &st), 0);
+    ASSERT_EQ(fs_lookups, 1);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(vfs_stat("/disk/present", &st), 0);
+        ASSERT_EQ(st.inode_num, 9101);
+    }
+    ASSERT_EQ(fs_lookups, 1);
+
+    /* Misses are remembered too (PATH searches) */
+    ASSERT_TRUE(vfs_resolve("/disk/missing") == NULL);
+    ASSERT_TRUE(vfs_resolve("/disk/missing") == NULL);
+    ASSERT_EQ(fs_lookups, 2);
+
+    DcacheStats ds;
+    dcache_get_stats(&ds);
+    ASSERT_EQ(ds.negative_hits, 1);
+    ASSERT_TRUE(ds.hits >= 6);
+    return 0;
+}
+
+static int test_dcache_negative_then_create(void) {
+    setup_vfs();
+    VfsFile f;
+    ASSERT_EQ(vfs_mkdir("/bin", 0755), 0);
+    ASSERT_TRUE(vfs_resolve("/bin/ls") == NULL);
+    ASSERT_TRUE(vfs_resolve("/bin/ls") == NULL);
+
+    ASSERT_EQ(vfs_open("/bin/ls", O_CREAT | O_RDWR, &f), 0);
+    ASSERT_TRUE(vfs_resolve("/bin/ls") == f.node);
+
+    ASSERT_TRUE(vfs_resolve("/bin/sub") == NULL);
+    ASSERT_EQ(vfs_mkdir("/bin/sub", 0755), 0);
+    ASSERT_TRUE(vfs_resolve("/bin/sub") != NULL);
+    return 0;
+}
+
+static int test_dcache_unlink_invalidates(void) {
+    setup_vfs();
+    VfsFile f;
+    ASSERT_EQ(vfs_mkdir("/d", 0755), 0);
+    ASSERT_EQ(vfs_open("/d/f", O_CREAT | O_RDWR, &f), 0);
+    ASSERT_TRUE(vfs_resolve("/d/f") == f.node);
+    ASSERT_EQ(vfs_unlink("/d/f"), 0);
+    ASSERT_TRUE(vfs_resolve("/d/f") == NULL);
+
+    /* Entries under a removed directory go with it */
+    VfsNode *d = vfs_resolve("/d");
+    ASSERT_TRUE(vfs_resolve("/d/g") == NULL);
+    ASSERT_EQ(vfs_unlink("/d"), 0);
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        ASSERT_TRUE(entries[i].dir != d);
+    }
+    ASSERT_EQ(vfs_mkdir("/d", 0755), 0);
+    ASSERT_EQ(vfs_open("/d/g", O_CREAT | O_RDWR, &f), 0);
+    ASSERT_TRUE(vfs_resolve("/d/g") == f.node);
+    return 0;
+}
+
+static int test_dcache_mount_invalidates(void) {
+    setup_vfs();
+    VfsNode disk = { .type = VFS_DIRECTORY, .ops = &counting_dir_ops };
+    ASSERT_TRUE(vfs_resolve("/disk") == NULL);
+    ASSERT_EQ(vfs_mount("/disk", &disk), 0);
+    ASSERT_TRUE(vfs_resolve("/disk") == &disk);
+
+    /* A new root starts from an empty cache */
+    VfsNode *old_root = vfs_get_root();
+    ASSERT_TRUE(vfs_resolve("/disk") == &disk);
+    vfs_set_root(ramfs_init());
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        ASSERT_TRUE(entries[i].dir != old_root);
+    }
+    return 0;
+}
+
+static int test_dcache_uncached_dirs_skipped(void) {
+    setup_vfs();
+    VfsNode dev = { .type = VFS_DIRECTORY, .ops = &counting_dir_ops };
+    ASSERT_EQ(vfs_mount("/dev", &dev), 0);
+    fs_lookups = 0;
+    ASSERT_TRUE(vfs_resolve("/dev/present") == &fs_child);
+    ASSERT_TRUE(vfs_resolve("/dev/present") == &fs_child);
+    ASSERT_EQ(fs_lookups, 2);
+
+    /* Names too long to keep inline always reach the filesystem */
+    char name[DCACHE_NAME_MAX + 3];
+    memset(name, 'x', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    VfsNode *root = vfs_get_root();
+    dcache_insert(root, name, NULL, dcache_generation());
+    VfsNode *out;
+    ASSERT_EQ(dcache_lookup(root, name, &out), 0);
+    return 0;
+}
+
+static int test_dcache_lru_eviction(void) {
+    setup_vfs();
+    VfsNode dir, child;
+    char name[16];
+    for (int i = 0; i < DCACHE_SIZE; i++) {
+        snprintf(name, sizeof(name), "n%d", i);
+        dcache_insert(&dir, name, &child, dcache_generation());
+    }
+    VfsNode *out = NULL;
+    ASSERT_EQ(dcache_lookup(&dir, "n0", &out), 1);     /* n0 now most recent */
+    ASSERT_TRUE(out == &child);
+
+    dcache_insert(&dir, "extra", NULL, dcache_generation());
+    ASSERT_EQ(dcache_lookup(&dir, "n1", &out), 0);     /* Oldest went */
+    ASSERT_EQ(dcache_lookup(&dir, "n0", &out), 1);
+    ASSERT_EQ(dcache_lookup(&dir, "extra", &out), 1);
+    ASSERT_TRUE(out == NULL);
+
+    DcacheStats ds;
+    dcache_get_stats(&ds);
+    ASSERT_EQ(ds.evictions, 1);
+    return 0;
+}
+
+static int test_dcache_stale_insert_dropped(void) {
+    setup_vfs();
+    VfsNode dir, other, child;
+    /* The filesystem answered, then the namespace changed before insert */
+    uint32_t gen = dcache_generation();
+    dcache_invalidate_dir(&other);
+    dcache_insert(&dir, "f", &child, gen);
+    VfsNode *out;
+    ASSERT_EQ(dcache_lookup(&dir, "f", &out), 0);
+
+    dcache_insert(&dir, "f", &child, dcache_generation());
+    ASSERT_EQ(dcache_lookup(&dir, "f", &out), 1);
+    return 0;
+}
+
+static int test_dcache_invalidate_node(void) {
+    setup_vfs();
+    VfsNode dir, sub, child, other;
+    dcache_insert(&dir, "sub", &sub, dcache_generation());
+    dcache_insert(&sub, "c", &child, dcache_generation());
+    dcache_insert(&dir, "o", &other, dcache_generation());
+
+    /* Entries naming sub and entries inside it go; others stay */
+    dcache_invalidate_node(&sub);
+    VfsNode *out;
+    ASSERT_EQ(dcache_lookup(&dir, "sub", &out), 0);
+    ASSERT_EQ(dcache_lookup(&sub, "c", &out), 0);
+    ASSERT_EQ(dcache_lookup(&dir, "o", &out), 1);
+    ASSERT_TRUE(out == &other);
+    return 0;
+}
+
 /* --- Permission integration tests --- */
 
 static int test_kernel_context_skips_checks(void) {
@@ -742,10 +1355,12 @@ TestCase vfs_tests[] = {
     { "mkdir_no_parent_fails",  test_mkdir_no_parent_fails },
     { "open_create_file",       test_open_create_file },
     { "open_existing_file",     test_open_existing_file },
+    { "open_excl_fails_if_exists", test_open_excl_fails_if_exists },
     { "open_nonexistent_fails", test_open_nonexistent_fails },
     { "write_then_read",        test_write_then_read },
     { "write_append",           test_write_append },
     { "write_grows_file",       test_write_grows_file },
+    { "large_io_has_preemption_points", test_large_io_has_preemption_points },
     { "seek_set_cur_end",       test_seek_set_cur_end },
     { "readdir_lists_children", test_readdir_lists_children },
     { "unlink_removes_file",    test_unlink_removes_file },
@@ -754,8 +1369,12 @@ TestCase vfs_tests[] = {
     { "open_trunc_clears_data",        test_open_trunc_clears_data },
     { "open_trunc_then_write",         test_open_trunc_then_write },
     { "open_creat_trunc_new_file",     test_open_creat_trunc_new_file },
-    { "ramfs_max_children_boundary",   test_ramfs_max_children_boundary },
-    { "ramfs_max_children_mkdir",      test_ramfs_max_children_mkdir },
+    { "ramfs_many_children",           test_ramfs_many_children },
+    { "ramfs_create_out_of_memory",    test_ramfs_create_out_of_memory },
+    { "ramfs_readdir_cursor_stable",   test_ramfs_readdir_cursor_stable },
+    { "ramfs_sparse_file_holes",       test_ramfs_sparse_file_holes },
+    { "ramfs_truncate_frees_pages",    test_ramfs_truncate_frees_pages },
+    { "ramfs_write_out_of_pages",      test_ramfs_write_out_of_pages },
     { "long_filename_max_length",      test_long_filename_max_length },
     { "deep_nested_path",              test_deep_nested_path },
     { "open_no_creat_nonexistent",     test_open_no_creat_nonexistent },
@@ -772,7 +1391,20 @@ TestCase vfs_tests[] = {
     { "readdir_max_limits_output",     test_readdir_max_limits_output },
     { "stat_directory_size_zero",      test_stat_directory_size_zero },
     { "mount_multiple",                test_mount_multiple },
+    { "readdir_at_batches",            test_readdir_at_batches },
     { "mount_duplicate_rejected",      test_mount_duplicate_rejected },
+    { "fsync_uses_sync_op",            test_fsync_uses_sync_op },
+    { "sync_visits_mounts",            test_sync_visits_mounts },
+    { "readahead_follows_sequential_reads", test_readahead_follows_sequential_reads },
+    { "readahead_stops_on_seek",       test_readahead_stops_on_seek },
+    { "dcache_repeat_lookups_cached",  test_dcache_repeat_lookups_cached },
+    { "dcache_negative_then_create",   test_dcache_negative_then_create },
+    { "dcache_unlink_invalidates",     test_dcache_unlink_invalidates },
+    { "dcache_mount_invalidates",      test_dcache_mount_invalidates },
+    { "dcache_uncached_dirs_skipped",  test_dcache_uncached_dirs_skipped },
+    { "dcache_lru_eviction",           test_dcache_lru_eviction },
+    { "dcache_stale_insert_dropped",   test_dcache_stale_insert_dropped },
+    { "dcache_invalidate_node",        test_dcache_invalidate_node },
     { "kernel_context_skips_checks",   test_kernel_context_skips_checks },
     { "open_readonly_checks_read",     test_open_readonly_checks_read },
     { "open_writable_checks_write",    test_open_writable_checks_write },
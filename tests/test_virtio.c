@@ -247,6 +247,28 @@ static int test_virtq_pop_used_multiple(void) {
     return 0;
 }
 
+static int test_virtq_disable_irq_sets_flag(void) {
+    Virtqueue vq = make_test_vq(4);
+    virtq_disable_irq(&vq);
+    ASSERT_EQ(vq.avail->flags & VRING_AVAIL_F_NO_INTERRUPT,
+              VRING_AVAIL_F_NO_INTERRUPT);
+    ASSERT_FALSE(virtq_enable_irq(&vq));
+    ASSERT_EQ(vq.avail->flags & VRING_AVAIL_F_NO_INTERRUPT, 0);
+    return 0;
+}
+
+static int test_virtq_enable_irq_reports_race(void) {
+    Virtqueue vq = make_test_vq(4);
+    virtq_disable_irq(&vq);
+    /* Device completes a buffer while interrupts are suppressed */
+    vq.used->ring[0].id = 1;
+    vq.used->ring[0].len = 64;
+    vq.used->idx = 1;
+    ASSERT_TRUE(virtq_enable_irq(&vq));
+    ASSERT_EQ(vq.avail->flags & VRING_AVAIL_F_NO_INTERRUPT, 0);
+    return 0;
+}
+
 static int test_virtio_init_queue(void) {
     reset_pmm();
 
@@ -279,6 +301,8 @@ TestCase virtio_tests[] = {
     { "virtq_has_used_empty",     test_virtq_has_used_empty },
     { "virtq_has_used_after_device", test_virtq_has_used_after_device },
     { "virtq_pop_used_multiple",  test_virtq_pop_used_multiple },
+    { "virtq_disable_irq_sets_flag", test_virtq_disable_irq_sets_flag },
+    { "virtq_enable_irq_reports_race", test_virtq_enable_irq_reports_race },
     { "virtio_init_queue",        test_virtio_init_queue },
 };
 
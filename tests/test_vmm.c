@@ -9,16 +9,30 @@
 #define ARCHOS_LIB_KPRINTF_H
 #define ARCHOS_LIB_MEM_H             /* Use libc memset/memcpy */
 #define ARCHOS_MM_VMM_H
+#define ARCHOS_PROC_SPINLOCK_H       /* Has privileged asm (cli/popf) */
+#define ARCHOS_PROC_PREEMPT_H
 
 /* Stub kprintf */
 static inline void kprintf(const char *fmt, ...) { (void)fmt; }
 #define KERNEL_PANIC() do { } while(0)
 
+/* Stub spinlock for host-side tests (cli/sti not available in user space) */
+typedef struct { volatile uint32_t locked; uint64_t saved_flags; } Spinlock;
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+static inline void spinlock_acquire(Spinlock *l) { (void)l; }
+static inline void spinlock_release(Spinlock *l) { (void)l; }
+
+/* Preemption point stub — counts the points fork passes */
+static int cond_resched_calls;
+static void cond_resched(void) { cond_resched_calls++; }
+
 /* PTE constants (from paging.h) */
 #define PTE_PRESENT    (1ULL << 0)
 #define PTE_WRITABLE   (1ULL << 1)
 #define PTE_USER       (1ULL << 2)
 #define PTE_HUGE       (1ULL << 7)
+#define PTE_SHARED     (1ULL << 9)
+#define PTE_COW        (1ULL << 10)
 #define PTE_NX         (1ULL << 63)
 #define PTE_ADDR_MASK  0x000FFFFFFFFFF000ULL
 
@@ -37,6 +51,8 @@ static inline void kprintf(const char *fmt, ...) { (void)fmt; }
 #define VMM_FLAG_WRITABLE  (1 << 0)
 #define VMM_FLAG_USER      (1 << 1)
 #define VMM_FLAG_NOEXEC    (1 << 2)
+#define VMM_FLAG_SHARED    (1 << 3)
+#define VMM_FLAG_COW       (1 << 4)
 
 /* User-space constants (from vmm.h) */
 #define USER_STACK_TOP    0x00007FFFFFFFE000ULL
@@ -101,7 +117,21 @@ static uint64_t pmm_alloc_page(void) {
     return addr;
 }
 
-static void pmm_free_page(uint64_t phys_addr) { (void)phys_addr; }
+/* Record frees so teardown tests can see which frames were released */
+#define MAX_FREED 256
+static uint64_t freed_pages[MAX_FREED];
+static int freed_count;
+
+static void pmm_free_page(uint64_t phys_addr) {
+    if (freed_count < MAX_FREED) freed_pages[freed_count++] = phys_addr;
+}
+
+static int was_freed(uint64_t phys) {
+    for (int i = 0; i < freed_count; i++) {
+        if (freed_pages[i] == phys) return 1;
+    }
+    return 0;
+}
 
 /* Tracking stubs for paging operations */
 static int invlpg_call_count;
@@ -135,6 +165,7 @@ static void reset_vmm_state(void) {
     invlpg_last_addr = 0;
     write_cr3_call_count = 0;
     write_cr3_last_value = 0;
+    freed_count = 0;
 
     /* Allocate a PML4 manually */
     kernel_pml4_phys = pmm_alloc_page();
@@ -418,6 +449,86 @@ TEST(ensure_table_creates_on_first_use) {
     return 0;
 }
 
+/* Returns the PTE for virt in pml4 (test helper) */
+static uint64_t pte_of(uint64_t pml4, uint64_t virt) {
+    uint64_t *pte = walk_to_pt_entry(pml4, virt);
+    return pte ? *pte : 0;
+}
+
+TEST(fork_maps_shared_frames_without_copy) {
+    reset_vmm_state();
+    uint64_t pml4 = vmm_create_user_pml4();
+    uint64_t text = pmm_alloc_page();
+    uint64_t data = pmm_alloc_page();
+    memset((void *)data, 0x5A, PAGE_SIZE);
+    vmm_map_page_in(pml4, 0x400000, text, VMM_FLAG_USER | VMM_FLAG_SHARED);
+    vmm_map_page_in(pml4, 0x600000, data, VMM_FLAG_USER | VMM_FLAG_WRITABLE);
+
+    cond_resched_calls = 0;
+    uint64_t child = vmm_fork_address_space(pml4);
+    ASSERT_TRUE(child != 0);
+    /* One preemption point per page table copied */
+    ASSERT_EQ(cond_resched_calls, 2);
+    ASSERT_EQ(vmm_get_phys_in(child, 0x400000), text);
+    ASSERT_TRUE(pte_of(child, 0x400000) & PTE_SHARED);
+    ASSERT_FALSE(pte_of(child, 0x400000) & PTE_WRITABLE);
+
+    uint64_t copy = vmm_get_phys_in(child, 0x600000);
+    ASSERT_TRUE(copy != 0 && copy != data);
+    ASSERT_EQ(((uint8_t *)copy)[100], 0x5A);
+    return 0;
+}
+
+TEST(free_user_pages_skips_shared_frames) {
+    reset_vmm_state();
+    uint64_t pml4 = vmm_create_user_pml4();
+    uint64_t shared = pmm_alloc_page();
+    uint64_t owned = pmm_alloc_page();
+    vmm_map_page_in(pml4, 0x400000, shared, VMM_FLAG_USER | VMM_FLAG_SHARED);
+    vmm_map_page_in(pml4, 0x401000, owned, VMM_FLAG_USER);
+
+    vmm_free_user_pages(pml4);
+    ASSERT_TRUE(was_freed(owned));
+    ASSERT_FALSE(was_freed(shared));
+    ASSERT_TRUE(was_freed(pml4));
+    return 0;
+}
+
+TEST(resolve_cow_gives_private_copy) {
+    reset_vmm_state();
+    uint64_t pml4 = vmm_create_user_pml4();
+    uint64_t cached = pmm_alloc_page();
+    memset((void *)cached, 0xC3, PAGE_SIZE);
+    vmm_map_page_in(pml4, 0x600000, cached,
+                    VMM_FLAG_USER | VMM_FLAG_SHARED | VMM_FLAG_COW | VMM_FLAG_NOEXEC);
+    ASSERT_FALSE(pte_of(pml4, 0x600000) & PTE_WRITABLE);
+
+    invlpg_call_count = 0;
+    ASSERT_EQ(vmm_resolve_cow(pml4, 0x600123), 0);
+    uint64_t pte = pte_of(pml4, 0x600000);
+    uint64_t copy = pte & PTE_ADDR_MASK;
+    ASSERT_TRUE(copy != cached);
+    ASSERT_EQ(((uint8_t *)copy)[4095], 0xC3);
+    ASSERT_TRUE(pte & PTE_WRITABLE);
+    ASSERT_TRUE(pte & PTE_NX);
+    ASSERT_FALSE(pte & (PTE_SHARED | PTE_COW));
+    ASSERT_EQ(invlpg_call_count, 1);
+    ASSERT_EQ(invlpg_last_addr, 0x600000);
+
+    /* The cached frame is untouched */
+    ASSERT_EQ(((uint8_t *)cached)[0], 0xC3);
+    return 0;
+}
+
+TEST(resolve_cow_rejects_plain_pages) {
+    reset_vmm_state();
+    uint64_t pml4 = vmm_create_user_pml4();
+    vmm_map_page_in(pml4, 0x400000, pmm_alloc_page(), VMM_FLAG_USER);
+    ASSERT_EQ(vmm_resolve_cow(pml4, 0x400000), -EFAULT);
+    ASSERT_EQ(vmm_resolve_cow(pml4, 0x800000), -EFAULT);
+    return 0;
+}
+
 /* --- Test suite export --- */
 
 TestCase vmm_tests[] = {
@@ -443,6 +554,10 @@ TestCase vmm_tests[] = {
     TEST_ENTRY(init_sets_pml4),
     TEST_ENTRY(remap_after_unmap),
     TEST_ENTRY(ensure_table_creates_on_first_use),
+    TEST_ENTRY(fork_maps_shared_frames_without_copy),
+    TEST_ENTRY(free_user_pages_skips_shared_frames),
+    TEST_ENTRY(resolve_cow_gives_private_copy),
+    TEST_ENTRY(resolve_cow_rejects_plain_pages),
 };
 
 int vmm_test_count = sizeof(vmm_tests) / sizeof(vmm_tests[0]);
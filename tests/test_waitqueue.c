@@ -41,6 +41,7 @@ typedef struct Thread {
     uint64_t        kernel_stack_top;
     thread_entry_t  entry;
     void           *arg;
+    uint8_t         prio;
     struct Thread  *next;
 } Thread;
 
@@ -284,6 +285,70 @@ static int test_fifo_ordering(void) {
     return 0;
 }
 
+static int test_priority_ordering(void) {
+    reset_state();
+    WaitQueue wq = (WaitQueue)WAITQUEUE_INIT;
+    Spinlock cond_lock = (Spinlock)SPINLOCK_INIT;
+
+    Thread *lo = make_thread(0, 1, THREAD_RUNNING);
+    Thread *hi = make_thread(1, 2, THREAD_RUNNING);
+    Thread *hi2 = make_thread(2, 3, THREAD_RUNNING);
+    Thread *mid = make_thread(3, 4, THREAD_RUNNING);
+    hi->prio = 50;
+    hi2->prio = 50;
+    mid->prio = 10;
+
+    Thread *order[] = { lo, hi, hi2, mid };
+    for (int i = 0; i < 4; i++) {
+        cond_lock.locked = 1;
+        test_current_thread = order[i];
+        wq_sleep(&wq, &cond_lock);
+    }
+
+    /* Highest priority first, FIFO among equals */
+    wq_wake_all(&wq);
+    ASSERT_EQ(woken_count, 4);
+    ASSERT_TRUE(woken_threads[0] == hi);
+    ASSERT_TRUE(woken_threads[1] == hi2);
+    ASSERT_TRUE(woken_threads[2] == mid);
+    ASSERT_TRUE(woken_threads[3] == lo);
+    ASSERT_TRUE(wq.tail == NULL);
+    return 0;
+}
+
+static int test_requeue_after_boost(void) {
+    reset_state();
+    WaitQueue wq = (WaitQueue)WAITQUEUE_INIT;
+    Spinlock cond_lock = (Spinlock)SPINLOCK_INIT;
+
+    Thread *a = make_thread(0, 1, THREAD_RUNNING);
+    Thread *b = make_thread(1, 2, THREAD_RUNNING);
+    Thread *c = make_thread(2, 3, THREAD_RUNNING);
+    a->prio = 20;
+    b->prio = 10;
+    Thread *order[] = { a, b, c };
+    for (int i = 0; i < 3; i++) {
+        cond_lock.locked = 1;
+        test_current_thread = order[i];
+        wq_sleep(&wq, &cond_lock);
+    }
+
+    /* The last waiter is boosted past the others */
+    c->prio = 30;
+    ASSERT_EQ(wq_requeue(&wq, c), 1);
+    ASSERT_TRUE(wq.head == c);
+    ASSERT_TRUE(wq.tail == b);
+
+    Thread *other = make_thread(3, 4, THREAD_RUNNING);
+    ASSERT_EQ(wq_requeue(&wq, other), 0);
+
+    wq_wake_all(&wq);
+    ASSERT_TRUE(woken_threads[0] == c);
+    ASSERT_TRUE(woken_threads[1] == a);
+    ASSERT_TRUE(woken_threads[2] == b);
+    return 0;
+}
+
 static int test_wake_all_wakes_multiple(void) {
     reset_state();
     WaitQueue wq = (WaitQueue)WAITQUEUE_INIT;
@@ -422,6 +487,8 @@ TestCase waitqueue_tests[] = {
     { "wake_calls_sched_add",     test_wake_calls_sched_add },
     { "wake_returns_one",         test_wake_returns_one },
     { "fifo_ordering",            test_fifo_ordering },
+    { "priority_ordering",        test_priority_ordering },
+    { "requeue_after_boost",      test_requeue_after_boost },
     { "wake_all_wakes_multiple",  test_wake_all_wakes_multiple },
     { "wake_all_returns_count",   test_wake_all_returns_count },
     { "sleep_wake_reuse",         test_sleep_wake_reuse },
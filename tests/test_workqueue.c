@@ -0,0 +1,304 @@
+/* arc_os — Host-side tests for kernel/proc/workqueue.c */
+
+#include "test_framework.h"
+#include <stdint.h>
+
+/* Guard kernel headers that conflict or need stubbing */
+#define ARCHOS_PROC_SPINLOCK_H
+#define ARCHOS_PROC_WAITQUEUE_H
+#define ARCHOS_PROC_THREAD_H
+#define ARCHOS_PROC_SCHED_H
+#define ARCHOS_ARCH_X86_64_PERCPU_H
+#define ARCHOS_ARCH_X86_64_PIT_H
+#define ARCHOS_LIB_KPRINTF_H
+
+static inline void kprintf(const char *fmt, ...) { (void)fmt; }
+
+/* Spinlock stub — no-op for host tests */
+typedef struct {
+    volatile uint32_t locked;
+    uint64_t saved_flags;
+} Spinlock;
+
+#define SPINLOCK_INIT { .locked = 0, .saved_flags = 0 }
+
+static inline void spinlock_acquire(Spinlock *lock) { lock->locked = 1; }
+static inline void spinlock_release(Spinlock *lock) { lock->locked = 0; }
+static inline uint64_t spin_irq_save(void) { return 0; }
+static inline void spin_irq_restore(uint64_t flags) { (void)flags; }
+
+/* Minimal Thread */
+typedef void (*thread_entry_t)(void *arg);
+typedef struct Thread {
+    uint32_t       tid;
+    thread_entry_t entry;
+    void          *arg;
+} Thread;
+
+#define TEST_MAX_THREADS 8
+static Thread test_threads[TEST_MAX_THREADS];
+static int test_thread_count;
+
+static Thread *thread_create(thread_entry_t entry, void *arg) {
+    if (test_thread_count >= TEST_MAX_THREADS) return NULL;
+    Thread *t = &test_threads[test_thread_count];
+    t->tid = (uint32_t)test_thread_count++;
+    t->entry = entry;
+    t->arg = arg;
+    return t;
+}
+
+static int sched_add_count;
+static void sched_add_thread(Thread *t) { (void)t; sched_add_count++; }
+
+/* Minimal PerCpu */
+#define MAX_CPUS 16
+typedef struct {
+    uint32_t cpu_id;
+    volatile int online;
+} PerCpu;
+
+static PerCpu percpu_data[MAX_CPUS];
+static uint32_t cpu_count = 1;
+static PerCpu *test_this_cpu;
+static PerCpu *this_cpu(void) { return test_this_cpu; }
+
+/* Controllable uptime */
+static uint64_t test_now_ms;
+static uint64_t pit_get_uptime_ms(void) { return test_now_ms; }
+
+/* WaitQueue stub: counts wakeups.  A sleeper on done_wq (flush_work)
+ * simulates the worker running, so flush can make progress. */
+typedef struct WaitQueue {
+    Spinlock lock;
+    Thread  *head;
+    Thread  *tail;
+} WaitQueue;
+
+static int wq_wake_count;
+static int wq_sleep_count;
+
+static int wq_wake(WaitQueue *wq) { (void)wq; wq_wake_count++; return 0; }
+static int wq_wake_all(WaitQueue *wq) { (void)wq; return 0; }
+
+#include "../kernel/proc/workqueue.h"
+
+static int worker_run_one(Worker *wk);
+static Worker *test_flush_worker;
+
+static void wq_sleep(WaitQueue *wq, Spinlock *lock) {
+    (void)wq;
+    wq_sleep_count++;
+    spinlock_release(lock);
+    if (test_flush_worker) {
+        spinlock_acquire(&test_flush_worker->pool->lock);
+        worker_run_one(test_flush_worker);
+        spinlock_release(&test_flush_worker->pool->lock);
+    }
+}
+
+#include "../kernel/proc/workqueue.c"
+
+/* --- Helpers --- */
+
+static int run_log[8];
+static int run_count;
+
+typedef struct {
+    Work work;
+    int  id;
+} TestItem;
+
+static void test_item_fn(Work *work) {
+    TestItem *it = (TestItem *)work;
+    if (run_count < 8) run_log[run_count] = it->id;
+    run_count++;
+}
+
+static void reset_wq_state(void) {
+    memset(pools, 0, sizeof(pools));
+    delayed_head = NULL;
+    delayed_lock = (Spinlock)SPINLOCK_INIT;
+    memset(percpu_data, 0, sizeof(percpu_data));
+    percpu_data[0].online = 1;
+    cpu_count = 1;
+    test_this_cpu = &percpu_data[0];
+    test_now_ms = 0;
+    test_thread_count = 0;
+    sched_add_count = 0;
+    wq_wake_count = 0;
+    wq_sleep_count = 0;
+    test_flush_worker = NULL;
+    run_count = 0;
+    memset(run_log, 0, sizeof(run_log));
+}
+
+/* Run everything queued on CPU 0's pool as worker 0 would */
+static int drain_pool0(void) {
+    Worker *wk = &pools[0].workers[0];
+    wk->pool = &pools[0];
+    int n = 0;
+    spinlock_acquire(&pools[0].lock);
+    while (worker_run_one(wk)) n++;
+    spinlock_release(&pools[0].lock);
+    return n;
+}
+
+/* --- Tests --- */
+
+static int test_init_starts_bounded_workers(void) {
+    reset_wq_state();
+    cpu_count = 3;
+    percpu_data[1].online = 1;
+    percpu_data[2].online = 0;  /* Not brought up: no pool threads */
+    workqueue_init();
+    ASSERT_EQ(pools[0].nr_workers, WQ_MAX_ACTIVE);
+    ASSERT_EQ(pools[1].nr_workers, WQ_MAX_ACTIVE);
+    ASSERT_EQ(pools[2].nr_workers, 0);
+    ASSERT_EQ(sched_add_count, 2 * WQ_MAX_ACTIVE);
+    ASSERT_TRUE(pools[1].workers[0].pool == &pools[1]);
+    return 0;
+}
+
+static int test_queue_work_runs_fifo(void) {
+    reset_wq_state();
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    TestItem b = { WORK_INIT(test_item_fn), 2 };
+    ASSERT_EQ(queue_work(&a.work), 1);
+    ASSERT_EQ(queue_work(&b.work), 1);
+    ASSERT_EQ(wq_wake_count, 2);
+    ASSERT_EQ(drain_pool0(), 2);
+    ASSERT_EQ(run_log[0], 1);
+    ASSERT_EQ(run_log[1], 2);
+    ASSERT_EQ(pools[0].nr_executed, 2);
+    ASSERT_EQ(a.work.pending, 0);
+    return 0;
+}
+
+static int test_queue_pending_coalesces(void) {
+    reset_wq_state();
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    ASSERT_EQ(queue_work(&a.work), 1);
+    ASSERT_EQ(queue_work(&a.work), 0);
+    ASSERT_EQ(drain_pool0(), 1);
+    /* Once run, it can be queued again */
+    ASSERT_EQ(queue_work(&a.work), 1);
+    ASSERT_EQ(drain_pool0(), 1);
+    ASSERT_EQ(run_count, 2);
+    return 0;
+}
+
+static int test_queue_on_this_cpu_pool(void) {
+    reset_wq_state();
+    cpu_count = 2;
+    percpu_data[1].cpu_id = 1;
+    test_this_cpu = &percpu_data[1];
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    queue_work(&a.work);
+    ASSERT_TRUE(pools[1].head == &a.work);
+    ASSERT_TRUE(pools[0].head == NULL);
+    ASSERT_EQ(a.work.cpu, 1);
+    return 0;
+}
+
+static int test_delayed_work_expires_in_order(void) {
+    reset_wq_state();
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    TestItem b = { WORK_INIT(test_item_fn), 2 };
+    test_now_ms = 100;
+    ASSERT_EQ(queue_delayed_work(&a.work, 50), 1);  /* due at 150 */
+    ASSERT_EQ(queue_delayed_work(&b.work, 20), 1);  /* due at 120 */
+    ASSERT_EQ(queue_delayed_work(&b.work, 5), 0);   /* pending: no re-arm */
+
+    workqueue_tick(119);
+    ASSERT_EQ(drain_pool0(), 0);
+    workqueue_tick(120);
+    ASSERT_EQ(drain_pool0(), 1);
+    ASSERT_EQ(run_log[0], 2);
+    workqueue_tick(200);
+    ASSERT_EQ(drain_pool0(), 1);
+    ASSERT_EQ(run_log[1], 1);
+    ASSERT_TRUE(delayed_head == NULL);
+    return 0;
+}
+
+static int test_delayed_zero_is_immediate(void) {
+    reset_wq_state();
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    queue_delayed_work(&a.work, 0);
+    ASSERT_TRUE(delayed_head == NULL);
+    ASSERT_EQ(drain_pool0(), 1);
+    return 0;
+}
+
+static int test_flush_idle_returns_immediately(void) {
+    reset_wq_state();
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    ASSERT_EQ(flush_work(&a.work), 0);
+    ASSERT_EQ(wq_sleep_count, 0);
+    return 0;
+}
+
+static int test_flush_waits_for_pending(void) {
+    reset_wq_state();
+    pools[0].workers[0].pool = &pools[0];
+    test_flush_worker = &pools[0].workers[0];
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    queue_work(&a.work);
+    ASSERT_EQ(flush_work(&a.work), 1);
+    ASSERT_EQ(run_count, 1);
+    ASSERT_EQ(a.work.pending, 0);
+    return 0;
+}
+
+static int test_flush_pulls_delayed_forward(void) {
+    reset_wq_state();
+    pools[0].workers[0].pool = &pools[0];
+    test_flush_worker = &pools[0].workers[0];
+    TestItem a = { WORK_INIT(test_item_fn), 1 };
+    queue_delayed_work(&a.work, 10000);
+    ASSERT_EQ(flush_work(&a.work), 1);
+    ASSERT_EQ(run_count, 1);
+    ASSERT_TRUE(delayed_head == NULL);
+    ASSERT_EQ(a.work.delayed, 0);
+    return 0;
+}
+
+static Work self_requeue_work;
+static int self_requeue_runs;
+static int self_requeue_result;
+
+static void self_requeue_fn(Work *work) {
+    /* Pending is already clear, so an item may re-queue itself */
+    if (++self_requeue_runs == 1) {
+        self_requeue_result = queue_work(work);
+    }
+}
+
+static int test_work_can_requeue_itself(void) {
+    reset_wq_state();
+    self_requeue_runs = 0;
+    work_init(&self_requeue_work, self_requeue_fn);
+    queue_work(&self_requeue_work);
+    ASSERT_EQ(drain_pool0(), 2);
+    ASSERT_EQ(self_requeue_result, 1);
+    ASSERT_EQ(self_requeue_runs, 2);
+    return 0;
+}
+
+/* --- Test suite export --- */
+
+TestCase workqueue_tests[] = {
+    { "init_starts_bounded_workers",   test_init_starts_bounded_workers },
+    { "queue_work_runs_fifo",          test_queue_work_runs_fifo },
+    { "queue_pending_coalesces",       test_queue_pending_coalesces },
+    { "queue_on_this_cpu_pool",        test_queue_on_this_cpu_pool },
+    { "delayed_work_expires_in_order", test_delayed_work_expires_in_order },
+    { "delayed_zero_is_immediate",     test_delayed_zero_is_immediate },
+    { "flush_idle_returns",            test_flush_idle_returns_immediately },
+    { "flush_waits_for_pending",       test_flush_waits_for_pending },
+    { "flush_pulls_delayed_forward",   test_flush_pulls_delayed_forward },
+    { "work_can_requeue_itself",       test_work_can_requeue_itself },
+};
+
+int workqueue_test_count = sizeof(workqueue_tests) / sizeof(workqueue_tests[0]);
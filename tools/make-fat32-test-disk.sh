@@ -3,8 +3,9 @@
 set -e
 
 IMG="${1:-tests/fat32_test.img}"
+SIZE_MB="${2:-34}"
 
-dd if=/dev/zero of="$IMG" bs=1M count=34 2>/dev/null
+dd if=/dev/zero of="$IMG" bs=1M count="$SIZE_MB" 2>/dev/null
 mkfs.fat -F 32 -n "TESTDISK" "$IMG" >/dev/null
 mmd -i "$IMG" ::subdir
 echo -n "Hello, FAT32!" | mcopy -i "$IMG" - ::hello.txt
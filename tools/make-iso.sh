@@ -28,7 +28,7 @@ cp "$BUILD_DIR/kernel.elf" "$ISO_ROOT/boot/kernel.elf"
 cp "$PROJECT_DIR/limine.conf" "$ISO_ROOT/boot/limine/limine.conf"
 
 # Copy all userland binaries
-BINARIES="init login shell hello echo cat wc head tail touch mkdir rm ls stat chmod chown cp mv ps kill uname grep free"
+BINARIES="init libarc.so login shell hello echo cat wc head tail touch mkdir rm ls stat chmod chown cp mv ps kill uname grep free ipcbench shmbench sync"
 for bin in $BINARIES; do
     if [ -f "$BUILD_DIR/$bin" ]; then
         cp "$BUILD_DIR/$bin" "$ISO_ROOT/boot/$bin"
@@ -0,0 +1,227 @@
+/* arc_os coreutil — ipcbench: round-trip latency of IPC endpoints, pipes
+ * and loopback TCP
+ *
+ * Usage: ipcbench [iterations]
+ *
+ * A child process echoes every message back to the parent, which times
+ * the round trips with the TSC and prints the mean in cycles for an
+ * 8-byte and a 4 KB payload over each transport. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ipc.h>
+#include <sys/wait.h>
+
+#define DEFAULT_ITERS  10000
+#define SMALL_MSG      8
+#define LARGE_MSG      IPC_BUF_MAX
+
+#define TAG_ECHO  1
+#define TAG_QUIT  2
+
+/* Socket ABI (kernel/net/socket.h); libc has no socket wrappers yet */
+#define AF_INET      2
+#define SOCK_STREAM  1
+#define BENCH_PORT   7070
+
+typedef struct {
+    uint16_t sin_family;
+    uint16_t sin_port;      /* Network byte order */
+    uint32_t sin_addr;      /* Network byte order */
+} SockAddrIn;
+
+static uint8_t payload[LARGE_MSG];
+static uint8_t reply[LARGE_MSG];
+
+static uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint16_t htons(uint16_t v) {
+    return (uint16_t)((v << 8) | (v >> 8));
+}
+
+/* Read or write exactly len bytes over a pipe or socket */
+static int xfer_all(int fd, void *buf, uint32_t len, int do_write, int sock) {
+    uint8_t *p = (uint8_t *)buf;
+    uint32_t done = 0;
+    while (done < len) {
+        int64_t n;
+        if (sock) {
+            n = syscall4(do_write ? SYS_SEND : SYS_RECV, (uint64_t)fd,
+                         (uint64_t)(p + done), len - done, 0);
+        } else if (do_write) {
+            n = write(fd, p + done, len - done);
+        } else {
+            n = read(fd, p + done, len - done);
+        }
+        if (n <= 0) return -1;
+        done += (uint32_t)n;
+    }
+    return 0;
+}
+
+static void report(const char *name, uint32_t size, uint64_t cycles, int iters) {
+    printf("%s %u bytes: %lu cycles/round trip\n", name, size,
+           cycles / (uint64_t)iters);
+}
+
+/* --- IPC endpoint --- */
+
+static void ipc_server(int ep) {
+    ipc_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.buf = reply;
+    msg.cap = sizeof(reply);
+    if (ipc_recv(ep, &msg) < 0) exit(1);
+    while (msg.tag == TAG_ECHO) {
+        /* Echo the buffer back; msg.len is already the received size */
+        msg.words[0]++;
+        msg.cap = sizeof(reply);
+        if (ipc_reply_recv(ep, &msg) < 0) exit(1);
+    }
+    msg.len = 0;
+    ipc_reply(&msg);
+    exit(0);
+}
+
+static int bench_ipc(uint32_t size, int iters) {
+    int ep = ipc_endpoint();
+    if (ep < 0) return -1;
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) ipc_server(ep);
+
+    ipc_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    uint64_t start = rdtsc();
+    for (int i = 0; i < iters; i++) {
+        msg.tag = TAG_ECHO;
+        msg.words[0] = (uint64_t)i;
+        msg.buf = payload;
+        msg.len = size;
+        msg.cap = sizeof(payload);
+        if (ipc_call(ep, &msg) < 0 || msg.words[0] != (uint64_t)i + 1) {
+            fprintf(stderr, "ipcbench: bad IPC reply\n");
+            return -1;
+        }
+    }
+    uint64_t cycles = rdtsc() - start;
+
+    msg.tag = TAG_QUIT;
+    msg.len = 0;
+    ipc_call(ep, &msg);
+    waitpid(pid, NULL, 0);
+    close(ep);
+    report("ipc ", size, cycles, iters);
+    return 0;
+}
+
+/* --- Pipes --- */
+
+static int bench_pipe(uint32_t size, int iters) {
+    int to_child[2], to_parent[2];
+    if (pipe(to_child) < 0 || pipe(to_parent) < 0) return -1;
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(to_child[1]);
+        close(to_parent[0]);
+        while (xfer_all(to_child[0], reply, size, 0, 0) == 0) {
+            if (xfer_all(to_parent[1], reply, size, 1, 0) < 0) break;
+        }
+        exit(0);
+    }
+    close(to_child[0]);
+    close(to_parent[1]);
+
+    uint64_t start = rdtsc();
+    for (int i = 0; i < iters; i++) {
+        if (xfer_all(to_child[1], payload, size, 1, 0) < 0 ||
+            xfer_all(to_parent[0], payload, size, 0, 0) < 0) {
+            fprintf(stderr, "ipcbench: pipe transfer failed\n");
+            return -1;
+        }
+    }
+    uint64_t cycles = rdtsc() - start;
+
+    close(to_child[1]);             /* EOF ends the child */
+    waitpid(pid, NULL, 0);
+    close(to_parent[0]);
+    report("pipe", size, cycles, iters);
+    return 0;
+}
+
+/* --- Loopback TCP --- */
+
+static int bench_tcp(uint32_t size, int iters, uint16_t port) {
+    SockAddrIn addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr = 0x0100007F;     /* 127.0.0.1 */
+
+    int lfd = (int)syscall3(SYS_SOCKET, AF_INET, SOCK_STREAM, 0);
+    if (lfd < 0) return -1;
+    if (syscall3(SYS_BIND, (uint64_t)lfd, (uint64_t)&addr, sizeof(addr)) < 0 ||
+        syscall2(SYS_LISTEN, (uint64_t)lfd, 1) < 0) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int cfd = (int)syscall3(SYS_SOCKET, AF_INET, SOCK_STREAM, 0);
+        if (cfd < 0 ||
+            syscall3(SYS_CONNECT, (uint64_t)cfd, (uint64_t)&addr, sizeof(addr)) < 0) {
+            exit(1);
+        }
+        for (int i = 0; i < iters; i++) {
+            if (xfer_all(cfd, reply, size, 0, 1) < 0 ||
+                xfer_all(cfd, reply, size, 1, 1) < 0) {
+                exit(1);
+            }
+        }
+        exit(0);
+    }
+
+    int fd = (int)syscall3(SYS_ACCEPT, (uint64_t)lfd, 0, 0);
+    if (fd < 0) return -1;
+    uint64_t start = rdtsc();
+    for (int i = 0; i < iters; i++) {
+        if (xfer_all(fd, payload, size, 1, 1) < 0 ||
+            xfer_all(fd, payload, size, 0, 1) < 0) {
+            fprintf(stderr, "ipcbench: TCP transfer failed\n");
+            return -1;
+        }
+    }
+    uint64_t cycles = rdtsc() - start;
+
+    waitpid(pid, NULL, 0);
+    close(fd);
+    close(lfd);
+    report("tcp ", size, cycles, iters);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int iters = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERS;
+    if (iters <= 0) {
+        fprintf(stderr, "usage: ipcbench [iterations]\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)i;
+
+    static const uint32_t sizes[2] = { SMALL_MSG, LARGE_MSG };
+    for (int s = 0; s < 2; s++) {
+        if (bench_ipc(sizes[s], iters) < 0) fprintf(stderr, "ipcbench: ipc failed\n");
+        if (bench_pipe(sizes[s], iters) < 0) fprintf(stderr, "ipcbench: pipe failed\n");
+        if (bench_tcp(sizes[s], iters, (uint16_t)(BENCH_PORT + s)) < 0) {
+            fprintf(stderr, "ipcbench: tcp failed\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* arc_os coreutil — shmbench: hand a large buffer to another process
+ * through POSIX shared memory and through a pipe
+ *
+ * Usage: shmbench [megabytes]
+ *
+ * The parent produces the buffer and a child consumes it (sums every
+ * byte), once through a mapped /dev/shm object and once copied through a
+ * pipe, and prints both times in TSC cycles. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define DEFAULT_MB  4
+#define CHUNK       4096
+#define SHM_NAME    "/shmbench"
+
+static uint8_t chunk[CHUNK];
+
+static uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static void fill(uint8_t *buf, size_t len, size_t base) {
+    for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)(base + i);
+}
+
+static uint64_t sum(const uint8_t *buf, size_t len) {
+    uint64_t s = 0;
+    for (size_t i = 0; i < len; i++) s += buf[i];
+    return s;
+}
+
+/* --- Shared memory: produce in place, consume in place --- */
+
+static int bench_shm(size_t size, uint64_t *sum_out) {
+    int fd = shm_open(SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return -1;
+    shm_unlink(SHM_NAME);           /* The fd and the mappings keep it */
+    if (ftruncate(fd, (off_t)size) < 0) { close(fd); return -1; }
+
+    uint8_t *buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (buf == MAP_FAILED) return -1;
+
+    int ready[2], done[2];
+    if (pipe(ready) < 0 || pipe(done) < 0) return -1;
+
+    uint64_t start = rdtsc();
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        char c;
+        if (read(ready[0], &c, 1) != 1) exit(1);
+        uint64_t s = sum(buf, size);
+        write(done[1], &s, sizeof(s));
+        exit(0);
+    }
+
+    fill(buf, size, 0);
+    write(ready[1], "x", 1);
+    if (read(done[0], sum_out, sizeof(*sum_out)) != sizeof(*sum_out)) return -1;
+    uint64_t cycles = rdtsc() - start;
+
+    waitpid(pid, NULL, 0);
+    munmap(buf, size);
+    close(ready[0]); close(ready[1]);
+    close(done[0]); close(done[1]);
+    printf("shm : %lu cycles\n", cycles);
+    return 0;
+}
+
+/* --- Pipe: produce chunk by chunk, copy through the kernel --- */
+
+static int bench_pipe(size_t size, uint64_t *sum_out) {
+    int data[2], done[2];
+    if (pipe(data) < 0 || pipe(done) < 0) return -1;
+
+    uint64_t start = rdtsc();
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(data[1]);
+        uint64_t s = 0;
+        ssize_t n;
+        while ((n = read(data[0], chunk, CHUNK)) > 0) s += sum(chunk, (size_t)n);
+        write(done[1], &s, sizeof(s));
+        exit(0);
+    }
+
+    close(data[0]);
+    for (size_t off = 0; off < size; off += CHUNK) {
+        fill(chunk, CHUNK, off);
+        for (size_t w = 0; w < CHUNK; ) {
+            ssize_t n = write(data[1], chunk + w, CHUNK - w);
+            if (n <= 0) return -1;
+            w += (size_t)n;
+        }
+    }
+    close(data[1]);                 /* EOF ends the child's loop */
+    if (read(done[0], sum_out, sizeof(*sum_out)) != sizeof(*sum_out)) return -1;
+    uint64_t cycles = rdtsc() - start;
+
+    waitpid(pid, NULL, 0);
+    close(done[0]); close(done[1]);
+    printf("pipe: %lu cycles\n", cycles);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int mb = (argc > 1) ? atoi(argv[1]) : DEFAULT_MB;
+    if (mb <= 0) {
+        fprintf(stderr, "usage: shmbench [megabytes]\n");
+        return 1;
+    }
+    size_t size = (size_t)mb * 1024 * 1024;
+    printf("shmbench: %d MB\n", mb);
+
+    uint64_t shm_sum = 0, pipe_sum = 0;
+    if (bench_shm(size, &shm_sum) < 0) fprintf(stderr, "shmbench: shm failed\n");
+    if (bench_pipe(size, &pipe_sum) < 0) fprintf(stderr, "shmbench: pipe failed\n");
+    if (shm_sum != pipe_sum) {
+        fprintf(stderr, "shmbench: checksum mismatch\n");
+        return 1;
+    }
+    return 0;
+}
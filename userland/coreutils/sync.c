@@ -0,0 +1,31 @@
+/* arc_os coreutil — sync: write cached data to disk
+ *
+ * Usage: sync [file]...
+ *
+ * With no arguments, flushes every filesystem; otherwise fsyncs each file. */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        sync();
+        return 0;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        int fd = open(argv[i], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "sync: cannot open '%s'\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        if (fsync(fd) < 0) {
+            fprintf(stderr, "sync: error syncing '%s'\n", argv[i]);
+            status = 1;
+        }
+        close(fd);
+    }
+    return status;
+}
@@ -1,18 +1,36 @@
 /* arc_os — Init process (PID 1)
- * Execs the login program for user authentication.
- * Falls back to shell if login is not available. */
+ * Spawns the login program for user authentication, falling back to the
+ * shell if login is not available, and respawns it when it exits. Also
+ * reaps orphans re-parented to init. */
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <spawn.h>
+#include <sys/wait.h>
 
-int main(int argc, char **argv) {
-    (void)argc; (void)argv;
-    /* Try login first */
+/* Start login (or the shell). Returns the child's pid, or -1. */
+static pid_t spawn_session(void) {
     char *login_argv[] = { "/boot/login", NULL };
-    execv("/boot/login", login_argv);
-    /* Fall back to shell if login not found */
+    pid_t pid;
+    if (posix_spawn(&pid, "/boot/login", NULL, NULL, login_argv, NULL) == 0)
+        return pid;
     char *sh_argv[] = { "/boot/shell", NULL };
-    execv("/boot/shell", sh_argv);
-    exit(1);
+    if (posix_spawn(&pid, "/boot/shell", NULL, NULL, sh_argv, NULL) == 0)
+        return pid;
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    (void)argc; (void)argv;
+    pid_t session = spawn_session();
+    if (session < 0) exit(1);
+
+    for (;;) {
+        pid_t pid = wait(NULL);
+        if (pid == session || pid < 0) {
+            session = spawn_session();
+            if (session < 0) exit(1);
+        }
+    }
     return 1;
 }
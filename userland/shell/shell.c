@@ -12,6 +12,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <spawn.h>
 #include <syscall.h>
 #include <errno.h>
 
@@ -383,8 +384,9 @@ static int parse_line(char *line, char *argv[MAX_ARGV]) {
     return argc;
 }
 
-/* Forward declaration for dispatch (needed by execute_with_redirect) */
+/* Forward declarations (needed by execute_with_redirect) */
 static void dispatch(int argc, char *argv[]);
+static int runs_in_shell(int argc, char *argv[]);
 
 /* --- I/O Redirection --- */
 
@@ -513,16 +515,61 @@ static int resolve_command(const char *cmd, char *resolved, uint64_t buf_size) {
     return 0;
 }
 
-/* Try resolve_command, then exec. Falls back to raw argv[0] if not found. */
-static int exec_resolved(char *argv[]) {
+/* Spawn an external command. in_fd/out_fd (-1 = inherit) become its stdin
+ * and stdout, close_fd (-1 = none) is closed in the child, and redirects
+ * are applied on top. Returns the child's pid, or -1 with errno set. */
+static pid_t spawn_command(char *argv[], const Redirect *r, int in_fd, int out_fd,
+                           int close_fd, int setpgroup) {
     char resolved[256];
+    const char *path = argv[0];
     if (resolve_command(argv[0], resolved, 256))
-        return execv(resolved, argv);
-    return execv(argv[0], argv);
+        path = resolved;
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    if (in_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&fa, in_fd, 0);
+        posix_spawn_file_actions_addclose(&fa, in_fd);
+    }
+    if (out_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&fa, out_fd, 1);
+        posix_spawn_file_actions_addclose(&fa, out_fd);
+    }
+    if (close_fd >= 0)
+        posix_spawn_file_actions_addclose(&fa, close_fd);
+    if (r && r->in_file)
+        posix_spawn_file_actions_addopen(&fa, 0, r->in_file, O_RDONLY, 0);
+    if (r && r->out_file) {
+        int flags = O_WRONLY | O_CREAT;
+        flags |= r->append ? O_APPEND : O_TRUNC;
+        posix_spawn_file_actions_addopen(&fa, 1, r->out_file, flags, 0);
+    }
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    if (setpgroup) {
+        /* The child is in its own group before it runs: no setpgid race */
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+    }
+
+    pid_t pid;
+    int err = posix_spawn(&pid, path, &fa, &attr, argv, NULL);
+    if (err != 0) { errno = err; return -1; }
+    return pid;
 }
 
-/* Fork, apply redirects in child, dispatch or exec, parent waits. */
+/* Run with redirects, parent waits. External commands are spawned;
+ * builtins fork so they cannot disturb the shell's own fds. */
 static void execute_with_redirect(int argc, char *argv[], const Redirect *r) {
+    if (argc > 0 && !runs_in_shell(argc, argv)) {
+        if (spawn_command(argv, r, -1, -1, -1, 0) < 0) {
+            print_error(argv[0], errno);
+            return;
+        }
+        wait(NULL);
+        return;
+    }
     pid_t pid = fork();
     if (pid < 0) {
         print_error("fork", errno);
@@ -533,12 +580,7 @@ static void execute_with_redirect(int argc, char *argv[], const Redirect *r) {
         if (apply_redirects(r) < 0) {
             exit(1);
         }
-        if (argc > 0) {
-            /* Try exec first (pass argv for argument passing) */
-            exec_resolved(argv);
-            /* Exec failed — try as builtin */
-            dispatch(argc, argv);
-        }
+        dispatch(argc, argv);
         exit(0);
     }
     /* Parent: wait for child */
@@ -599,7 +641,7 @@ static const Builtin builtins[] = {
     { "uname",  cmd_uname,  "Print OS name" },
     { "clear",  cmd_clear,  "Clear screen" },
     { "exit",   cmd_exit,   "Exit shell [code]" },
-    { "run",    cmd_run,    "Execute binary (fork/exec)" },
+    { "run",    cmd_run,    "Execute binary (spawn)" },
     { "pid",    cmd_pid,    "Print current PID" },
     { "cd",     cmd_cd,     "Change directory [path]" },
     { "pwd",    cmd_pwd,    "Print working directory" },
@@ -625,6 +667,15 @@ static int try_assignment(const char *arg) {
     return arg[i] == '=';
 }
 
+/* Returns 1 if argv is a builtin or assignment rather than a program */
+static int runs_in_shell(int argc, char *argv[]) {
+    if (argc == 1 && try_assignment(argv[0])) return 1;
+    for (int i = 0; i < (int)NUM_BUILTINS; i++) {
+        if (strcmp(argv[0], builtins[i].name) == 0) return 1;
+    }
+    return 0;
+}
+
 static void dispatch(int argc, char *argv[]) {
     if (argc == 0) return;
 
@@ -646,18 +697,13 @@ static void dispatch(int argc, char *argv[]) {
             return;
         }
     }
-    /* Not a builtin — try fork + exec */
-    pid_t pid = fork();
-    if (pid < 0) { print_error("fork", errno); return; }
-    if (pid == 0) {
-        /* Child: create own process group */
-        syscall2(SYS_SETPGID, 0, 0);
-        exec_resolved(argv);
+    /* Not a builtin — spawn it in its own process group */
+    pid_t pid = spawn_command(argv, NULL, -1, -1, -1, 1);
+    if (pid < 0) {
         printf("%s: command not found\n", argv[0]);
-        exit(127);
+        return;
     }
-    /* Parent: set child pgid, give foreground, wait */
-    syscall2(SYS_SETPGID, (uint64_t)pid, (uint64_t)pid);
+    /* Give foreground, wait */
     syscall1(SYS_TCSETPGRP, (uint64_t)pid);
     int status = 0;
     waitpid(-1, &status, 0);
@@ -832,24 +878,12 @@ static void cmd_exit(int argc, char *argv[]) {
 
 static void cmd_run(int argc, char *argv[]) {
     if (argc < 2) { puts("usage: run <path>"); return; }
-    /* Resolve before fork so child doesn't need stat */
-    char resolved[256];
-    const char *exec_path = argv[1];
-    if (resolve_command(argv[1], resolved, 256))
-        exec_path = resolved;
-    pid_t pid = fork();
-    if (pid < 0) {
-        print_error("fork", errno);
-        return;
-    }
-    if (pid == 0) {
-        /* Child: exec the binary (argv+1 so binary gets argv[0]=path) */
-        execv(exec_path, argv + 1);
-        /* If exec fails, exit */
+    /* argv+1 so the binary gets argv[0]=path */
+    if (spawn_command(argv + 1, NULL, -1, -1, -1, 0) < 0) {
         puts("exec failed");
-        exit(1);
+        return;
     }
-    /* Parent: wait for child */
+    /* Wait for child */
     int status = -1;
     waitpid(-1, &status, 0);
     printf("exited with status ");
@@ -1029,19 +1063,25 @@ static void execute_background(char *line) {
     Redirect redir = {0, 0, 0};
     if (parse_redirects(&argc, argv, &redir) < 0) return;
 
-    pid_t pid = fork();
-    if (pid < 0) { print_error("fork", errno); return; }
-    if (pid == 0) {
-        /* Child: create own process group */
-        syscall2(SYS_SETPGID, 0, 0);
-        if (redir.in_file || redir.out_file)
-            apply_redirects(&redir);
-        exec_resolved(argv);
-        dispatch(argc, argv);
-        exit(0);
+    pid_t pid;
+    if (!runs_in_shell(argc, argv)) {
+        pid = spawn_command(argv, &redir, -1, -1, -1, 1);
+        if (pid < 0) { print_error(argv[0], errno); return; }
+    } else {
+        pid = fork();
+        if (pid < 0) { print_error("fork", errno); return; }
+        if (pid == 0) {
+            /* Child: create own process group */
+            syscall2(SYS_SETPGID, 0, 0);
+            if (redir.in_file || redir.out_file)
+                apply_redirects(&redir);
+            dispatch(argc, argv);
+            exit(0);
+        }
+        /* Parent: set child's pgid too (whichever runs first wins) */
+        syscall2(SYS_SETPGID, (uint64_t)pid, (uint64_t)pid);
     }
-    /* Parent: set child's pgid, add to job table, do NOT wait */
-    syscall2(SYS_SETPGID, (uint64_t)pid, (uint64_t)pid);
+    /* Add to job table, do NOT wait */
     Job *j = job_alloc((int32_t)pid, (int32_t)pid, argv[0]);
     if (j) {
         printf("[%d] %d\n", j->job_id, (int)pid);
@@ -1069,6 +1109,43 @@ static char *skip_spaces(char *s) {
     return s;
 }
 
+/* Start one side of a pipeline with pipe_fd as its stdin (target 0) or
+ * stdout (target 1); other_fd is the pipe end it must not hold open.
+ * Returns the child's pid, or -1. */
+static pid_t start_pipe_side(char *cmd, int pipe_fd, int target, int other_fd) {
+    char *argv[MAX_ARGV];
+    int argc = parse_line(cmd, argv);
+    Redirect redir = {0, 0, 0};
+    if (argc > 0 && parse_redirects(&argc, argv, &redir) < 0)
+        argc = 0;
+
+    if (argc > 0 && !runs_in_shell(argc, argv)) {
+        pid_t pid = spawn_command(argv, &redir,
+                                  target == 0 ? pipe_fd : -1,
+                                  target == 1 ? pipe_fd : -1, other_fd, 0);
+        if (pid < 0) print_error(argv[0], errno);
+        return pid;
+    }
+
+    /* Builtin (or empty): run it in a forked child */
+    pid_t pid = fork();
+    if (pid < 0) {
+        print_error("fork", errno);
+        return -1;
+    }
+    if (pid == 0) {
+        close(other_fd);
+        dup2(pipe_fd, target);
+        close(pipe_fd);
+        if (argc > 0) {
+            apply_redirects(&redir);
+            dispatch(argc, argv);
+        }
+        exit(0);
+    }
+    return pid;
+}
+
 /* Execute a pipeline: left | right */
 static void execute_pipe(char *left, char *right) {
     left = skip_spaces(left);
@@ -1082,69 +1159,16 @@ static void execute_pipe(char *left, char *right) {
         return;
     }
 
-    /* Fork child 1 (writer — runs left command, stdout -> pipe write end) */
-    pid_t pid1 = fork();
-    if (pid1 < 0) {
-        print_error("fork", errno);
-        close(pipefd[0]);
-        close(pipefd[1]);
-        return;
-    }
-    if (pid1 == 0) {
-        /* Child 1: close read end, dup write end to stdout, close original */
-        close(pipefd[0]);
-        dup2(pipefd[1], 1);
-        close(pipefd[1]);
-
-        /* Parse and run left command (with optional redirects) */
-        char *argv[MAX_ARGV];
-        int argc = parse_line(left, argv);
-        if (argc > 0) {
-            Redirect redir = {0, 0, 0};
-            if (parse_redirects(&argc, argv, &redir) == 0)
-                apply_redirects(&redir);
-            /* Try exec first (pass argv) */
-            exec_resolved(argv);
-            /* Exec failed — try as builtin */
-            dispatch(argc, argv);
-        }
-        exit(0);
-    }
-
-    /* Fork child 2 (reader — runs right command, stdin -> pipe read end) */
-    pid_t pid2 = fork();
-    if (pid2 < 0) {
-        print_error("fork", errno);
-        close(pipefd[0]);
-        close(pipefd[1]);
-        /* Wait for child1 */
-        wait(NULL);
-        return;
-    }
-    if (pid2 == 0) {
-        /* Child 2: close write end, dup read end to stdin, close original */
-        close(pipefd[1]);
-        dup2(pipefd[0], 0);
-        close(pipefd[0]);
-
-        /* Parse and run right command (with optional redirects) */
-        char *argv[MAX_ARGV];
-        int argc = parse_line(right, argv);
-        if (argc > 0) {
-            Redirect redir = {0, 0, 0};
-            if (parse_redirects(&argc, argv, &redir) == 0)
-                apply_redirects(&redir);
-            exec_resolved(argv);
-            dispatch(argc, argv);
-        }
-        exit(0);
-    }
+    /* Writer: left command, stdout -> pipe write end */
+    pid_t pid1 = start_pipe_side(left, pipefd[1], 1, pipefd[0]);
+    /* Reader: right command, stdin -> pipe read end */
+    pid_t pid2 = start_pipe_side(right, pipefd[0], 0, pipefd[1]);
 
-    /* Parent: close both pipe ends, wait for both children */
+    /* Parent: close both pipe ends, wait for the children that started */
     close(pipefd[0]);
     close(pipefd[1]);
-    wait(NULL);
-    wait(NULL);
+    if (pid1 > 0) wait(NULL);
+    if (pid2 > 0) wait(NULL);
 }
 
 /* --- Entry point --- */